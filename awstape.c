@@ -46,6 +46,14 @@ void close_awstape (DEVBLK *dev)
 {
     if(dev->fd>=0)
     {
+        /* Keep the block index for the next time the tape is used */
+        if (dev->tdparms.idxfile
+         && tapeidx_save (&dev->tapeidx, dev->fd, dev->filename) < 0)
+            logmsg (_("HHCTA121W %4.4X: Unable to write block index "
+                    "of file %s\n"), dev->devnum, dev->filename);
+        tapera_term (&dev->tapera);
+        tapeidx_term (&dev->tapeidx);
+
         logmsg (_("HHCTA101I %4.4X: AWS Tape %s closed\n"),
                 dev->devnum, dev->filename);
         close(dev->fd);
@@ -152,6 +160,13 @@ char            pathname[MAX_PATH];     /* file path in host format  */
 
     /* Store the file descriptor in the device block */
     dev->fd = rc;
+
+    /* Set up the block index and read-ahead */
+    tapeidx_init (&dev->tapeidx);
+    if (dev->tdparms.idxfile)
+        tapeidx_load (&dev->tapeidx, dev->fd, dev->filename);
+    tapera_init (&dev->tapera, dev->fd);
+
     rc=rewind_awstape(dev,unitstat,code);
     return rc;
 
@@ -167,24 +182,9 @@ int readhdr_awstape (DEVBLK *dev, off_t blkpos,
                         AWSTAPE_BLKHDR *buf, BYTE *unitstat,BYTE code)
 {
 int             rc;                     /* Return code               */
-off_t           rcoff;                  /* Return code from lseek()  */
-
-    /* Reposition file to the requested block header */
-    rcoff = lseek (dev->fd, blkpos, SEEK_SET);
-    if (rcoff < 0)
-    {
-        /* Handle seek error condition */
-        logmsg (_("HHCTA103E %4.4X: Error seeking to offset "I64_FMTX" "
-                "in file %s: %s\n"),
-                dev->devnum, blkpos, dev->filename, strerror(errno));
-
-        /* Set unit check with equipment check */
-        build_senseX(TAPE_BSENSE_LOCATEERR,dev,unitstat,code);
-        return -1;
-    }
 
-    /* Read the 6-byte block header */
-    rc = read (dev->fd, buf, sizeof(AWSTAPE_BLKHDR));
+    /* Read the 6-byte block header at the requested offset */
+    rc = tapera_read (&dev->tapera, buf, sizeof(AWSTAPE_BLKHDR), blkpos);
 
     /* Handle read error condition */
     if (rc < 0)
@@ -294,7 +294,7 @@ U16             seglen;                 /* Data length of segment    */
             break;
 
         /* Read data block segment from tape file */
-        rc = read (dev->fd, buf+blklen, seglen);
+        rc = tapera_read (&dev->tapera, buf+blklen, seglen, blkpos-seglen);
 
         /* Handle read error condition */
         if (rc < 0)
@@ -325,6 +325,10 @@ U16             seglen;                 /* Data length of segment    */
 
     } while ((awshdr.flags1 & AWSTAPE_FLAG1_ENDREC) == 0);
 
+    /* Remember where the block was */
+    tapeidx_add (&dev->tapeidx, dev->blockid, dev->nxtblkpos, blkpos,
+                 (awshdr.flags1 & AWSTAPE_FLAG1_TAPEMARK) != 0);
+
     /* Calculate the offsets of the next and previous blocks */
     dev->prvblkpos = dev->nxtblkpos;
     dev->nxtblkpos = blkpos;
@@ -378,6 +382,10 @@ U16             prvblkl;                /* Length of previous block  */
         blkpos = dev->prvblkpos + sizeof(awshdr) + prvblkl;
     }
 
+    /* Forget what was read from here on, as it is being replaced */
+    tapera_reset (&dev->tapera);
+    tapeidx_truncate (&dev->tapeidx, dev->blockid);
+
     /* Reposition file to the new block header */
     rcoff = lseek (dev->fd, blkpos, SEEK_SET);
     if (rcoff < 0)
@@ -462,6 +470,7 @@ U16             prvblkl;                /* Length of previous block  */
         return -1;
     }
 
+    tapeidx_add (&dev->tapeidx, dev->blockid, blkpos, dev->nxtblkpos, 0);
     dev->blockid++;
 
     /* Set new physical EOF */
@@ -518,6 +527,10 @@ U16             prvblkl;                /* Length of previous block  */
         blkpos = dev->prvblkpos + sizeof(awshdr) + prvblkl;
     }
 
+    /* Forget what was read from here on, as it is being replaced */
+    tapera_reset (&dev->tapera);
+    tapeidx_truncate (&dev->tapeidx, dev->blockid);
+
     /* Reposition file to the new block header */
     rcoff = lseek (dev->fd, blkpos, SEEK_SET);
     if (rcoff < 0)
@@ -562,12 +575,13 @@ U16             prvblkl;                /* Length of previous block  */
         return -1;
     }
 
-    dev->blockid++;
-
     /* Calculate the offsets of the next and previous blocks */
     dev->nxtblkpos = blkpos + sizeof(awshdr);
     dev->prvblkpos = blkpos;
 
+    tapeidx_add (&dev->tapeidx, dev->blockid, blkpos, dev->nxtblkpos, 1);
+    dev->blockid++;
+
     /* Set new physical EOF */
     do rc = ftruncate( dev->fd, dev->nxtblkpos );
     while (EINTR == rc);
@@ -662,6 +676,10 @@ U16             seglen;                 /* Data length of segment    */
 
     } while ((awshdr.flags1 & AWSTAPE_FLAG1_ENDREC) == 0);
 
+    /* Remember where the block was */
+    tapeidx_add (&dev->tapeidx, dev->blockid, dev->nxtblkpos, blkpos,
+                 (awshdr.flags1 & AWSTAPE_FLAG1_TAPEMARK) != 0);
+
     /* Calculate the offsets of the next and previous blocks */
     dev->prvblkpos = dev->nxtblkpos;
     dev->nxtblkpos = blkpos;
@@ -732,15 +750,31 @@ off_t           blkpos;                 /* Offset of block header    */
 /* Forward space to next logical file of AWSTAPE format file         */
 /*                                                                   */
 /* For AWSTAPE files, the forward space file operation is achieved   */
-/* by forward spacing blocks until positioned just after a tapemark. */
+/* by positioning just after the next tapemark known to the block    */
+/* index, or else by forward spacing blocks until positioned just    */
+/* after a tapemark.                                                 */
 /*                                                                   */
 /* If successful, return value is zero, and the current file number  */
-/* in the device block is incremented by fsb_awstape.                */
+/* in the device block is incremented.                               */
 /* If error, return value is -1 and unitstat is set to CE+DE+UC      */
 /*-------------------------------------------------------------------*/
 int fsf_awstape (DEVBLK *dev, BYTE *unitstat,BYTE code)
 {
 int             rc;                     /* Return code               */
+U32             tm;                     /* Block number of tapemark  */
+off_t           tmpos, nxtpos;          /* Offsets of tapemark and
+                                           the block after it        */
+
+    if (tapeidx_nexttm (&dev->tapeidx, dev->fd, dev->blockid, &tm) == 0
+     && tapeidx_locate (&dev->tapeidx, dev->fd, tm, &tmpos) == 0
+     && tapeidx_locate (&dev->tapeidx, dev->fd, tm + 1, &nxtpos) == 0)
+    {
+        dev->prvblkpos = tmpos;
+        dev->nxtblkpos = nxtpos;
+        dev->blockid = tm + 1;
+        dev->curfilen++;
+        return 0;
+    }
 
     while (1)
     {
@@ -762,16 +796,44 @@ int             rc;                     /* Return code               */
 /* Backspace to previous logical file of AWSTAPE format file         */
 /*                                                                   */
 /* For AWSTAPE files, the backspace file operation is achieved       */
-/* by backspacing blocks until positioned just before a tapemark     */
-/* or until positioned at start of tape.                             */
+/* by positioning just before the previous tapemark known to the     */
+/* block index, or else by backspacing blocks until positioned just  */
+/* before a tapemark or until positioned at start of tape.           */
 /*                                                                   */
 /* If successful, return value is zero, and the current file number  */
-/* in the device block is decremented by bsb_awstape.                */
+/* in the device block is decremented.                               */
 /* If error, return value is -1 and unitstat is set to CE+DE+UC      */
 /*-------------------------------------------------------------------*/
 int bsf_awstape (DEVBLK *dev, BYTE *unitstat,BYTE code)
 {
 int             rc;                     /* Return code               */
+U32             tm;                     /* Block number of tapemark  */
+off_t           tmpos, prvpos = -1;     /* Offsets of tapemark and
+                                           the block before it       */
+
+    if (dev->blockid > 0
+     && tapeidx_prevtm (&dev->tapeidx, dev->fd, dev->blockid, &tm) == 0
+     && tapeidx_locate (&dev->tapeidx, dev->fd, tm, &tmpos) == 0
+     && (tm == 0
+      || tapeidx_locate (&dev->tapeidx, dev->fd, tm - 1, &prvpos) == 0))
+    {
+        dev->prvblkpos = prvpos;
+        dev->nxtblkpos = tmpos;
+        dev->blockid = tm;
+        dev->curfilen--;
+        return 0;
+    }
+
+    /* If there is no tapemark before the block, go to the load point */
+    if (dev->blockid > 0 && dev->tapeidx.nblks >= dev->blockid
+     && tapeidx_files (&dev->tapeidx, dev->blockid) == 0)
+    {
+        dev->prvblkpos = -1;
+        dev->nxtblkpos = 0;
+        dev->blockid = 0;
+        build_senseX(TAPE_BSENSE_LOADPTERR,dev,unitstat,code);
+        return -1;
+    }
 
     while (1)
     {
@@ -799,3 +861,31 @@ int             rc;                     /* Return code               */
 /*********************************************************************/
 /*  END OF ORIGINAL RB AWS FUNCTIONS                                 */
 /*********************************************************************/
+
+/*-------------------------------------------------------------------*/
+/* Locate a block of an AWSTAPE format file                          */
+/*                                                                   */
+/* If the block index can find the block, the position is set        */
+/* directly.  Otherwise the tape is spaced from the load point.      */
+/*                                                                   */
+/* If successful, return value is zero.                              */
+/* If error, return value is -1 and unitstat is set to CE+DE+UC      */
+/*-------------------------------------------------------------------*/
+int locateblk_awstape (DEVBLK *dev, U32 blockid, BYTE *unitstat, BYTE code)
+{
+off_t           blkpos, prvpos = -1;    /* Offsets of block and the
+                                           block before it           */
+
+    if (tapeidx_locate (&dev->tapeidx, dev->fd, blockid, &blkpos) < 0
+     || (blockid > 0
+      && tapeidx_locate (&dev->tapeidx, dev->fd, blockid - 1, &prvpos) < 0))
+        return locateblk_virtual (dev, blockid, unitstat, code);
+
+    dev->nxtblkpos = blkpos;
+    dev->prvblkpos = prvpos;
+    dev->blockid = blockid;
+    dev->curfilen = 1 + tapeidx_files (&dev->tapeidx, blockid);
+    dev->fenced = 0;
+    return 0;
+
+} /* end function locateblk_awstape */
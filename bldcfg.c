@@ -164,6 +164,93 @@ void delayed_exit (int exit_code)
 }
 
 
+#if defined(OPTION_HUGE_STORAGE)
+/*-------------------------------------------------------------------*/
+/* Obtain storage backed by huge pages and/or placed on NUMA nodes   */
+/*      The storage is zero and is not touched, so that the NUMA     */
+/*      policy applies when the guest first references each page.   */
+/*      Returns NULL if the storage cannot be obtained this way.     */
+/*-------------------------------------------------------------------*/
+static BYTE *config_mmap(U64 size, char *what)
+{
+BYTE   *p = MAP_FAILED;                 /* -> Storage                */
+U64     align = 4096;                   /* Page size                 */
+U64     extra = 0;                      /* Extra for THP alignment   */
+U64     off;                            /* Alignment offset          */
+int     flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+    if (sysblk.hugepages > 0)
+    {
+#if defined(MAP_HUGETLB)
+        off = sysblk.hugepages * 1024ULL;
+        p = mmap(NULL, (size_t)((size + off - 1) & ~(off - 1)),
+                 PROT_READ | PROT_WRITE, flags | MAP_HUGETLB
+#if defined(MAP_HUGE_SHIFT)
+                 | ((off == 1024*1024*1024ULL ? 30 : 21) << MAP_HUGE_SHIFT)
+#endif
+                 , -1, 0);
+        if (p != MAP_FAILED)
+            size = (size + off - 1) & ~(off - 1);
+#else
+        errno = ENOTSUP;
+#endif
+        if (p == MAP_FAILED)
+        {
+            logmsg(_("HHCCF122W Cannot obtain %s storage in %s pages: %s\n"),
+                    what, sysblk.hugepages >= 1024*1024 ? "1G" : "2M",
+                    strerror(errno));
+            /* Host pages may still be placed on the NUMA nodes */
+            if (sysblk.numa == NUMA_NONE)
+                return NULL;
+        }
+    }
+    else if (sysblk.hugepages == HUGEPAGES_THP)
+    {
+        /* Transparent huge pages must be 2M aligned */
+        align = 2*1024*1024ULL;
+        extra = align;
+    }
+
+    if (p == MAP_FAILED)
+    {
+        size = (size + align - 1) & ~(align - 1);
+        p = mmap(NULL, (size_t)(size + extra), PROT_READ | PROT_WRITE,
+                 flags, -1, 0);
+        if (p == MAP_FAILED)
+        {
+            logmsg(_("HHCCF122W Cannot obtain %s storage in %s pages: %s\n"),
+                    what, extra ? "transparent huge" : "host",
+                    strerror(errno));
+            return NULL;
+        }
+    }
+
+    if (extra)
+    {
+        /* Trim the mapping back to an aligned range */
+        off = (uintptr_t)p & (align - 1);
+        off = off ? align - off : 0;
+        if (off)
+            munmap(p, (size_t)off);
+        if (extra - off)
+            munmap(p + off + size, (size_t)(extra - off));
+        p += off;
+#if defined(MADV_HUGEPAGE)
+        madvise(p, (size_t)size, MADV_HUGEPAGE);
+#endif
+    }
+
+    if (sysblk.numa != NUMA_NONE
+     && bind_host_memory(p, (size_t)size, sysblk.numa == NUMA_INTERLEAVE,
+                         sysblk.numanodes) != 0)
+        logmsg(_("HHCCF123W NUMA policy not applied to %s storage: %s\n"),
+                what, strerror(errno));
+
+    return p;
+}
+#endif /*defined(OPTION_HUGE_STORAGE)*/
+
+
 /* storage configuration routine. To be moved *JJ */
 static void config_storage(unsigned mainsize, unsigned xpndsize)
 {
@@ -172,23 +259,35 @@ int off;
     /* Obtain main storage */
     sysblk.mainsize = mainsize * 1024 * 1024ULL;
 
-    sysblk.mainstor = calloc((size_t)(sysblk.mainsize + 8192), 1);
-
-    if (sysblk.mainstor != NULL)
-        sysblk.main_clear = 1;
-    else
-        sysblk.mainstor = malloc((size_t)(sysblk.mainsize + 8192));
-
-    if (sysblk.mainstor == NULL)
+#if defined(OPTION_HUGE_STORAGE)
+    sysblk.mainmmap = 0;
+    if (sysblk.hugepages || sysblk.numa != NUMA_NONE)
     {
-        logmsg(_("HHCCF031S Cannot obtain %dMB main storage: %s\n"),
-                mainsize, strerror(errno));
-        delayed_exit(1);
+        sysblk.mainstor = config_mmap(sysblk.mainsize, "main");
+        if (sysblk.mainstor != NULL)
+            sysblk.mainmmap = sysblk.main_clear = 1;
     }
+    if (sysblk.mainstor == NULL)
+#endif
+    {
+        sysblk.mainstor = calloc((size_t)(sysblk.mainsize + 8192), 1);
+
+        if (sysblk.mainstor != NULL)
+            sysblk.main_clear = 1;
+        else
+            sysblk.mainstor = malloc((size_t)(sysblk.mainsize + 8192));
 
-    /* Trying to get mainstor aligned to the next 4K boundary - Greg */
-    off = (uintptr_t)sysblk.mainstor & 0xFFF;
-    sysblk.mainstor += off ? 4096 - off : 0;
+        if (sysblk.mainstor == NULL)
+        {
+            logmsg(_("HHCCF031S Cannot obtain %dMB main storage: %s\n"),
+                    mainsize, strerror(errno));
+            delayed_exit(1);
+        }
+
+        /* Trying to get mainstor aligned to the next 4K boundary - Greg */
+        off = (uintptr_t)sysblk.mainstor & 0xFFF;
+        sysblk.mainstor += off ? 4096 - off : 0;
+    }
 
     /* Obtain main storage key array */
     sysblk.storkeys = calloc((size_t)(sysblk.mainsize / STORAGE_KEY_UNITSIZE), 1);
@@ -222,6 +321,14 @@ int off;
 
         /* Obtain expanded storage */
         sysblk.xpndsize = xpndsize * (1024*1024 / XSTORE_PAGESIZE);
+#if defined(OPTION_HUGE_STORAGE)
+        if (sysblk.hugepages || sysblk.numa != NUMA_NONE)
+            sysblk.xpndstor = config_mmap(
+                    (U64)sysblk.xpndsize * XSTORE_PAGESIZE, "expanded");
+        if (sysblk.xpndstor != NULL)
+            sysblk.xpnd_clear = 1;
+        else
+#endif
         sysblk.xpndstor = calloc(sysblk.xpndsize, XSTORE_PAGESIZE);
         if (sysblk.xpndstor)
             sysblk.xpnd_clear = 1;
@@ -811,14 +918,22 @@ char    pathname[MAX_PATH];             /* file path in host format  */
     sysblk.panrate = PANEL_REFRESH_RATE_SLOW;
 #endif
 
+    /* Default is no second level TLB */
+    sysblk.tlbsets = 0;
+    sysblk.tlbways = 1;
+
     /* Initialize locks, conditions, and attributes */
     initialize_lock (&sysblk.todlock);
     initialize_lock (&sysblk.mainlock);
     sysblk.mainowner = LOCK_OWNER_NONE;
     initialize_lock (&sysblk.intlock);
-    initialize_lock (&sysblk.iointqlk);
+    for (i = 0; i < IOINTQ_MAX; i++)
+        initialize_lock (&sysblk.iointq[i].lock);
     sysblk.intowner = LOCK_OWNER_NONE;
     initialize_lock (&sysblk.sigplock);
+#if defined(OPTION_BLOCK_CACHE)
+    initialize_lock (&sysblk.bbclock);
+#endif
 //  initialize_detach_attr (&sysblk.detattr);   // (moved to impl.c)
 //  initialize_join_attr   (&sysblk.joinattr);  // (moved to impl.c)
     initialize_condition (&sysblk.cpucond);
@@ -829,6 +944,13 @@ char    pathname[MAX_PATH];             /* file path in host format  */
 #if defined(OPTION_INSTRUCTION_COUNTING)
     initialize_lock (&sysblk.icount_lock);
 #endif
+#if defined(OPTION_INSTRUCTION_PROFILE)
+    profile_init ();
+#endif
+#if defined(OPTION_TRACEBIN)
+    tracebin_init ();
+#endif
+    simd_init ();
 
 #ifdef OPTION_PTTRACE
     ptt_trace_init (0, 1);
@@ -849,11 +971,11 @@ char    pathname[MAX_PATH];             /* file path in host format  */
     );
 #else // !defined(OPTION_FISHIO)
     initialize_lock (&sysblk.ioqlock);
-    initialize_condition (&sysblk.ioqcond);
+    ioq_init ();
     /* Set max number device threads */
     sysblk.devtmax = devtmax;
-    sysblk.devtwait = sysblk.devtnbr =
-    sysblk.devthwm  = sysblk.devtunavail = 0;
+    sysblk.devtnbr =
+    sysblk.devthwm = sysblk.devtunavail = 0;
 #endif // defined(OPTION_FISHIO)
 
     /* Default the licence setting */
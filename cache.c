@@ -15,96 +15,121 @@ static CACHEBLK cacheblk[CACHE_MAX_INDEX];
 /*-------------------------------------------------------------------*/
 /* Public functions                                                  */
 /*-------------------------------------------------------------------*/
-int cache_nbr (int ix)
+DLL_EXPORT int cache_nbr (int ix)
 {
     if (cache_check_ix(ix)) return -1;
     return cacheblk[ix].nbr;
 }
 
-int cache_busy (int ix)
+DLL_EXPORT int cache_busy (int ix)
 {
+    int s, n = 0;
     if (cache_check_ix(ix)) return -1;
-    return cacheblk[ix].busy;
+    for (s = 0; s < cacheblk[ix].stripes; s++)
+        n += cacheblk[ix].stripe[s].busy;
+    return n;
 }
 
-int cache_empty (int ix)
+DLL_EXPORT int cache_empty (int ix)
 {
+    int s, n = 0;
     if (cache_check_ix(ix)) return -1;
-    return cacheblk[ix].empty;
+    for (s = 0; s < cacheblk[ix].stripes; s++)
+        n += cacheblk[ix].stripe[s].empty;
+    return n;
 }
 
 int cache_waiters (int ix)
 {
+    int s, n = 0;
     if (cache_check_ix(ix)) return -1;
-    return cacheblk[ix].waiters;
+    for (s = 0; s < cacheblk[ix].stripes; s++)
+        n += cacheblk[ix].stripe[s].waiters;
+    return n;
 }
 
-long long cache_size (int ix)
+DLL_EXPORT long long cache_size (int ix)
 {
+    int s;
+    long long n = 0;
     if (cache_check_ix(ix)) return -1;
-    return cacheblk[ix].size;
+    for (s = 0; s < cacheblk[ix].stripes; s++)
+        n += cacheblk[ix].stripe[s].size;
+    return n;
 }
 
-long long cache_hits (int ix)
+DLL_EXPORT long long cache_hits (int ix)
 {
+    int s;
+    long long n = 0;
     if (cache_check_ix(ix)) return -1;
-    return cacheblk[ix].hits;
+    for (s = 0; s < cacheblk[ix].stripes; s++)
+        n += cacheblk[ix].stripe[s].hits;
+    return n;
 }
 
-long long cache_misses (int ix)
+DLL_EXPORT long long cache_misses (int ix)
 {
+    int s;
+    long long n = 0;
     if (cache_check_ix(ix)) return -1;
-    return cacheblk[ix].misses;
+    for (s = 0; s < cacheblk[ix].stripes; s++)
+        n += cacheblk[ix].stripe[s].misses;
+    return n;
 }
 
 int cache_busy_percent (int ix)
 {
-    if (cache_check_ix(ix)) return -1;
-    return (cacheblk[ix].busy * 100) / cacheblk[ix].nbr;
+    if (cache_check_ix(ix) || cacheblk[ix].nbr == 0) return -1;
+    return (cache_busy(ix) * 100) / cacheblk[ix].nbr;
 }
 
 int cache_empty_percent (int ix)
 {
-    if (cache_check_ix(ix)) return -1;
-    return (cacheblk[ix].empty * 100) / cacheblk[ix].nbr;
+    if (cache_check_ix(ix) || cacheblk[ix].nbr == 0) return -1;
+    return (cache_empty(ix) * 100) / cacheblk[ix].nbr;
 }
 
 int cache_hit_percent (int ix)
 {
-    long long total;
+    long long hits, total;
     if (cache_check_ix(ix)) return -1;
-    total = cacheblk[ix].hits + cacheblk[ix].misses;
+    hits = cache_hits(ix);
+    total = hits + cache_misses(ix);
     if (total == 0) return -1;
-    return (int)((cacheblk[ix].hits * 100) / total);
+    return (int)((hits * 100) / total);
 }
 
 int cache_lookup (int ix, U64 key, int *o)
 {
-    int i,p;
+    CACHESTRIPE *cs;
+    int i,p,n;
     if (o) *o = -1;
-    if (cache_check_ix(ix)) return -1;
+    if (cache_check_ix(ix) || cacheblk[ix].magic != CACHE_MAGIC) return -1;
+    cs = cache_keystripe(ix, key);
+    n = cs->first + cacheblk[ix].stripenbr;
     /* `p' is the preferred index */
-    p = (int)(key % cacheblk[ix].nbr);
+    p = cs->first + (int)(key % cacheblk[ix].stripenbr);
     if (cacheblk[ix].cache[p].key == key) {
         i = p;
-        cacheblk[ix].fasthits++;
+        cs->fasthits++;
     }
     else {
-        if (cache_isbusy(ix, p) || cacheblk[ix].age - cacheblk[ix].cache[p].age < 20)
+        if (cache_isbusy(ix, p) || cs->age - cacheblk[ix].cache[p].age < 20)
             p = -2;
-        for (i = 0; i < cacheblk[ix].nbr; i++) {
+        for (i = cs->first; i < n; i++) {
             if (cacheblk[ix].cache[i].key == key) break;
             if (o && !cache_isbusy(ix, i)
              && (*o < 0 || i == p || cacheblk[ix].cache[i].age < cacheblk[ix].cache[*o].age))
                 if (*o != p) *o = i;
         }
     }
-    if (i >= cacheblk[ix].nbr) {
+    if (i >= n) {
         i = -1;
-        cacheblk[ix].misses++;
+        cs->misses++;
     }
     else
-        cacheblk[ix].hits++;
+        cs->hits++;
 
     if (i < 0 && o && *o < 0) cache_adjust(ix,1);
     else cache_adjust(ix, 0);
@@ -127,27 +152,62 @@ int      answer = -1;                   /* Answer from routine       */
 
 int cache_lock(int ix)
 {
+    int s;
     if (cache_check_cache(ix)) return -1;
-    obtain_lock(&cacheblk[ix].lock);
+    for (s = 0; s < cacheblk[ix].stripes; s++)
+        obtain_lock(&cacheblk[ix].stripe[s].lock);
     return 0;
 }
 
 int cache_unlock(int ix)
 {
+    int s, empty;
     if (cache_check_ix(ix)) return -1;
-    release_lock(&cacheblk[ix].lock);
-    if (cacheblk[ix].empty == cacheblk[ix].nbr)
+    empty = cache_empty(ix);
+    for (s = cacheblk[ix].stripes - 1; s >= 0; s--)
+        release_lock(&cacheblk[ix].stripe[s].lock);
+    if (empty == cacheblk[ix].nbr)
         cache_destroy(ix);
     return 0;
 }
 
-int cache_wait(int ix)
+int cache_lock_key(int ix, U64 key)
+{
+    if (cache_check_cache(ix)) return -1;
+    obtain_lock(&cache_keystripe(ix, key)->lock);
+    return 0;
+}
+
+int cache_unlock_key(int ix, U64 key)
+{
+    if (cache_check_ix(ix)) return -1;
+    release_lock(&cache_keystripe(ix, key)->lock);
+    return 0;
+}
+
+int cache_lock_entry(int ix, int i)
+{
+    if (cache_check(ix,i)) return -1;
+    obtain_lock(&cache_entrystripe(ix, i)->lock);
+    return 0;
+}
+
+int cache_unlock_entry(int ix, int i)
+{
+    if (cache_check(ix,i)) return -1;
+    release_lock(&cache_entrystripe(ix, i)->lock);
+    return 0;
+}
+
+int cache_wait(int ix, U64 key)
 {
+    CACHESTRIPE    *cs;
     struct timeval  now;
     struct timespec tm;
 
     if (cache_check_ix(ix)) return -1;
-    if (cacheblk[ix].busy < cacheblk[ix].nbr)
+    cs = cache_keystripe(ix, key);
+    if (cs->busy < cacheblk[ix].stripenbr)
         return 0;
     if (cache_adjust(ix, 1))
         return 0;
@@ -156,13 +216,13 @@ int cache_wait(int ix)
     tm.tv_nsec = (now.tv_usec + CACHE_WAITTIME) * 1000;
     tm.tv_sec += tm.tv_nsec / 1000000000;
     tm.tv_nsec = tm.tv_nsec % 1000000000;
-    cacheblk[ix].waiters++; cacheblk[ix].waits++;
+    cs->waiters++; cs->waits++;
 #if 0
-    timed_wait_condition(&cacheblk[ix].waitcond, &cacheblk[ix].lock, &tm);
+    timed_wait_condition(&cs->waitcond, &cs->lock, &tm);
 #else
-    wait_condition(&cacheblk[ix].waitcond, &cacheblk[ix].lock);
+    wait_condition(&cs->waitcond, &cs->lock);
 #endif
-    cacheblk[ix].waiters--;
+    cs->waiters--;
     return 0;
 }
 
@@ -174,17 +234,19 @@ U64 cache_getkey(int ix, int i)
 
 U64 cache_setkey(int ix, int i, U64 key)
 {
+    CACHESTRIPE *cs;
     U64 oldkey;
     int empty;
 
     if (cache_check(ix,i)) return (U64)-1;
+    cs = cache_entrystripe(ix, i);
     empty = cache_isempty(ix, i);
     oldkey = cacheblk[ix].cache[i].key;
     cacheblk[ix].cache[i].key = key;
     if (empty && !cache_isempty(ix, i))
-        cacheblk[ix].empty--;
+        cs->empty--;
     else if (!empty && cache_isempty(ix, i))
-        cacheblk[ix].empty++;
+        cs->empty++;
     return oldkey;
 }
 
@@ -196,11 +258,13 @@ U32 cache_getflag(int ix, int i)
 
 U32 cache_setflag(int ix, int i, U32 andbits, U32 orbits)
 {
+    CACHESTRIPE *cs;
     U32 oldflags;
     int empty;
     int busy;
 
     if (cache_check(ix,i)) return (U32)-1;
+    cs = cache_entrystripe(ix, i);
 
     empty = cache_isempty(ix, i);
     busy = cache_isbusy(ix, i);
@@ -209,16 +273,16 @@ U32 cache_setflag(int ix, int i, U32 andbits, U32 orbits)
     cacheblk[ix].cache[i].flag &= andbits;
     cacheblk[ix].cache[i].flag |= orbits;
 
-    if (!cache_isbusy(ix, i) && cacheblk[ix].waiters > 0)
-        signal_condition(&cacheblk[ix].waitcond);
+    if (!cache_isbusy(ix, i) && cs->waiters > 0)
+        signal_condition(&cs->waitcond);
     if (busy && !cache_isbusy(ix, i))
-        cacheblk[ix].busy--;
+        cs->busy--;
     else if (!busy && cache_isbusy(ix, i))
-        cacheblk[ix].busy++;
+        cs->busy++;
     if (empty && !cache_isempty(ix, i))
-        cacheblk[ix].empty--;
+        cs->empty--;
     else if (!empty && cache_isempty(ix, i))
-        cacheblk[ix].empty++;
+        cs->empty++;
     return oldflags;
 }
 
@@ -230,14 +294,16 @@ U64 cache_getage(int ix, int i)
 
 U64 cache_setage(int ix, int i)
 {
+    CACHESTRIPE *cs;
     U64 oldage;
     int empty;
 
     if (cache_check(ix,i)) return (U64)-1;
+    cs = cache_entrystripe(ix, i);
     empty = cache_isempty(ix, i);
     oldage = cacheblk[ix].cache[i].age;
-    cacheblk[ix].cache[i].age = ++cacheblk[ix].age;
-    if (empty) cacheblk[ix].empty--;
+    cacheblk[ix].cache[i].age = ++cs->age;
+    if (empty) cs->empty--;
     return oldage;
 }
 
@@ -247,7 +313,7 @@ void *cache_getbuf(int ix, int i, int len)
     if (len > 0
      && cacheblk[ix].cache[i].buf != NULL
      && cacheblk[ix].cache[i].len < len) {
-        cacheblk[ix].size -= cacheblk[ix].cache[i].len;
+        cache_entrystripe(ix, i)->size -= cacheblk[ix].cache[i].len;
         free (cacheblk[ix].cache[i].buf);
         cacheblk[ix].cache[i].buf = NULL;
         cacheblk[ix].cache[i].len = 0;
@@ -259,13 +325,15 @@ void *cache_getbuf(int ix, int i, int len)
 
 void *cache_setbuf(int ix, int i, void *buf, int len)
 {
+    CACHESTRIPE *cs;
     void *oldbuf;
     if (cache_check(ix,i)) return NULL;
+    cs = cache_entrystripe(ix, i);
     oldbuf = cacheblk[ix].cache[i].buf;
-    cacheblk[ix].size -= cacheblk[ix].cache[i].len;
+    cs->size -= cacheblk[ix].cache[i].len;
     cacheblk[ix].cache[i].buf = buf;
     cacheblk[ix].cache[i].len = len;
-    cacheblk[ix].size += len;
+    cs->size += len;
     return oldbuf;
 }
 
@@ -292,12 +360,14 @@ int cache_setval(int ix, int i, int val)
 
 int cache_release(int ix, int i, int flag)
 {
+    CACHESTRIPE *cs;
     void *buf;
     int   len;
     int   empty;
     int   busy;
 
     if (cache_check(ix,i)) return -1;
+    cs = cache_entrystripe(ix, i);
 
     empty = cache_isempty(ix, i);
     busy = cache_isbusy(ix, i);
@@ -309,7 +379,7 @@ int cache_release(int ix, int i, int flag)
 
     if ((flag & CACHE_FREEBUF) && buf != NULL) {
         free (buf);
-        cacheblk[ix].size -= len;
+        cs->size -= len;
         buf = NULL;
         len = 0;
     }
@@ -317,18 +387,20 @@ int cache_release(int ix, int i, int flag)
     cacheblk[ix].cache[i].buf = buf;
     cacheblk[ix].cache[i].len = len;
 
-    if (cacheblk[ix].waiters > 0)
-        signal_condition(&cacheblk[ix].waitcond);
+    if (cs->waiters > 0)
+        signal_condition(&cs->waitcond);
 
-    if (!empty) cacheblk[ix].empty++;
-    if (busy) cacheblk[ix].busy--;
+    if (!empty) cs->empty++;
+    if (busy) cs->busy--;
 
     return 0;
 }
 
 DLL_EXPORT int cache_cmd(int argc, char *argv[], char *cmdline)
 {
-    int ix, i;
+    int ix, i, s, waits;
+    long long fasthits;
+    U64 age;
 
     UNREFERENCED(cmdline);
     UNREFERENCED(argc);
@@ -339,9 +411,15 @@ DLL_EXPORT int cache_cmd(int argc, char *argv[], char *cmdline)
             logmsg ("cache[%d] ....... not created\n", ix);
             continue;
         }
+        for (waits = 0, fasthits = 0, age = 0, s = 0; s < cacheblk[ix].stripes; s++) {
+            waits += cacheblk[ix].stripe[s].waits;
+            fasthits += cacheblk[ix].stripe[s].fasthits;
+            age += cacheblk[ix].stripe[s].age;
+        }
         logmsg ("\n"
                 "cache............ %10d\n"
                 "nbr ............. %10d\n"
+                "stripes ......... %10d\n"
                 "busy ............ %10d\n"
                 "busy%% ........... %10d\n"
                 "empty ........... %10d\n"
@@ -356,10 +434,11 @@ DLL_EXPORT int cache_cmd(int argc, char *argv[], char *cmdline)
                 "last adjusted ... %s"
                 "last wait ....... %s"
                 "adjustments ..... %10d\n",
-          ix, cacheblk[ix].nbr, cacheblk[ix].busy, cache_busy_percent(ix),
-          cacheblk[ix].empty, cacheblk[ix].waiters, cacheblk[ix].waits,
-          cacheblk[ix].size, cacheblk[ix].hits, cacheblk[ix].fasthits,
-          cacheblk[ix].misses, cache_hit_percent(ix), cacheblk[ix].age,
+          ix, cacheblk[ix].nbr, cacheblk[ix].stripes,
+          cache_busy(ix), cache_busy_percent(ix),
+          cache_empty(ix), cache_waiters(ix), waits,
+          cache_size(ix), cache_hits(ix), fasthits,
+          cache_misses(ix), cache_hit_percent(ix), age,
           ctime(&cacheblk[ix].atime), ctime(&cacheblk[ix].wtime),
           cacheblk[ix].adjusts);
         if (argc > 1)
@@ -377,33 +456,52 @@ DLL_EXPORT int cache_cmd(int argc, char *argv[], char *cmdline)
 /*-------------------------------------------------------------------*/
 static int cache_create (int ix)
 {
+    int s;
+
     cache_destroy (ix);
-    cacheblk[ix].magic = CACHE_MAGIC;
+    /* The device buffer cache is shared by all dasd devices and is
+       striped so i/o to different tracks can proceed in parallel */
+    if (ix == CACHE_DEVBUF) {
+        cacheblk[ix].stripes = CACHE_DEVBUF_STRIPES;
+        cacheblk[ix].stripenbr = CACHE_DEVBUF_STRIPE_NBR;
+    } else {
+        cacheblk[ix].stripes = 1;
 //FIXME See the note in cache.h about CACHE_DEFAULT_L2_NBR
-    cacheblk[ix].nbr = ix != CACHE_L2 ? CACHE_DEFAULT_NBR : CACHE_DEFAULT_L2_NBR;
-    cacheblk[ix].empty = cacheblk[ix].nbr;
-    initialize_lock (&cacheblk[ix].lock);
-    initialize_condition (&cacheblk[ix].waitcond);
+        cacheblk[ix].stripenbr = ix != CACHE_L2 ? CACHE_DEFAULT_NBR : CACHE_DEFAULT_L2_NBR;
+    }
+    cacheblk[ix].nbr = cacheblk[ix].stripes * cacheblk[ix].stripenbr;
+    cacheblk[ix].stripe = calloc (cacheblk[ix].stripes, sizeof(CACHESTRIPE));
     cacheblk[ix].cache = calloc (cacheblk[ix].nbr, sizeof(CACHE));
-    if (cacheblk[ix].cache == NULL) {
+    if (cacheblk[ix].stripe == NULL || cacheblk[ix].cache == NULL) {
         logmsg (_("HHCCH001E calloc failed cache[%d] size %d: %s\n"),
                 ix, cacheblk[ix].nbr * sizeof(CACHE), strerror(errno));
+        free (cacheblk[ix].stripe);
+        free (cacheblk[ix].cache);
+        memset(&cacheblk[ix], 0, sizeof(CACHEBLK));
         return -1;
     }
+    for (s = 0; s < cacheblk[ix].stripes; s++) {
+        cacheblk[ix].stripe[s].first = s * cacheblk[ix].stripenbr;
+        cacheblk[ix].stripe[s].empty = cacheblk[ix].stripenbr;
+        initialize_lock (&cacheblk[ix].stripe[s].lock);
+        initialize_condition (&cacheblk[ix].stripe[s].waitcond);
+    }
+    cacheblk[ix].magic = CACHE_MAGIC;
     return 0;
 }
 
 static int cache_destroy (int ix)
 {
-    int i;
+    int i, s;
     if (cacheblk[ix].magic == CACHE_MAGIC) {
-        destroy_lock (&cacheblk[ix].lock);
-        destroy_condition (&cacheblk[ix].waitcond);
-        if (cacheblk[ix].cache) {
-            for (i = 0; i < cacheblk[ix].nbr; i++)
-                cache_release(ix, i, CACHE_FREEBUF);
-            free (cacheblk[ix].cache);
+        for (i = 0; i < cacheblk[ix].nbr; i++)
+            cache_release(ix, i, CACHE_FREEBUF);
+        for (s = 0; s < cacheblk[ix].stripes; s++) {
+            destroy_lock (&cacheblk[ix].stripe[s].lock);
+            destroy_condition (&cacheblk[ix].stripe[s].waitcond);
         }
+        free (cacheblk[ix].cache);
+        free (cacheblk[ix].stripe);
     }
     memset(&cacheblk[ix], 0, sizeof(CACHEBLK));
     return 0;
@@ -430,6 +528,20 @@ static int cache_check(int ix, int i)
     return 0;
 }
 
+static CACHESTRIPE *cache_keystripe(int ix, U64 key)
+{
+    U32 h;
+    /* Fold the device number into the track/block number so the
+       same track on different devices maps to different stripes */
+    h = (U32)key ^ ((U32)(key >> 32) * 0x9E3779B1);
+    return &cacheblk[ix].stripe[h % cacheblk[ix].stripes];
+}
+
+static CACHESTRIPE *cache_entrystripe(int ix, int i)
+{
+    return &cacheblk[ix].stripe[i / cacheblk[ix].stripenbr];
+}
+
 static int cache_isbusy(int ix, int i)
 {
     return ((cacheblk[ix].cache[i].flag & CACHE_BUSY) != 0);
@@ -442,6 +554,9 @@ static int cache_isempty(int ix, int i)
          && cacheblk[ix].cache[i].age  == 0);
 }
 
+/* Called with only the stripe lock held.  The code below is not
+   compiled; it reads and updates fields shared by all stripes, so it
+   would need cache_lock() before being enabled again */
 static int cache_adjust(int ix, int n)
 {
 #if 0
@@ -453,7 +568,7 @@ static int cache_adjust(int ix, int n)
     hitpct = cache_hit_percent(ix);
     nbr = cacheblk[ix].nbr;
     empty = cache_empty(ix);
-    sz = cacheblk[ix].size;
+    sz = cache_size(ix);
 
     if (n == 0) {
         /* Normal adjustments */
@@ -478,7 +593,7 @@ static int cache_adjust(int ix, int n)
 
         /* Decrease cache if hit percentage is ok and not many busy */
         if (hitpct >= CACHE_ADJUST_HIT3 && busypct <= CACHE_ADJUST_BUSY3
-         && cacheblk[ix].size >= CACHE_ADJUST_SIZE)
+         && cache_size(ix) >= CACHE_ADJUST_SIZE)
             return cache_resize(ix, -CACHE_ADJUST_RESIZE);
     } else {
         /* All cache entries are busy */
@@ -543,13 +658,18 @@ static int cache_resize (int ix, int n)
 
 static void cache_allocbuf(int ix, int i, int len)
 {
+    CACHESTRIPE *cs;
+    int j;
+
+    cs = cache_entrystripe(ix, i);
     cacheblk[ix].cache[i].buf = calloc (len, 1);
     if (cacheblk[ix].cache[i].buf == NULL) {
         logmsg (_("HHCCH004W buf calloc failed cache[%d] size %d: %s\n"),
                 ix, len, strerror(errno));
         logmsg (_("HHCCH005W releasing inactive buffer space\n"));
-        for (i = 0; i < cacheblk[ix].nbr; i++)
-            if (!cache_isbusy(ix, i)) cache_release(ix, i, CACHE_FREEBUF);
+        /* Only the entries in our own stripe are locked */
+        for (j = cs->first; j < cs->first + cacheblk[ix].stripenbr; j++)
+            if (j != i && !cache_isbusy(ix, j)) cache_release(ix, j, CACHE_FREEBUF);
         cacheblk[ix].cache[i].buf = calloc (len, 1);
         if (cacheblk[ix].cache[i].buf == NULL) {
             logmsg (_("HHCCH006E Unable to calloc buf cache[%d] size %d: %s\n"),
@@ -558,5 +678,5 @@ static void cache_allocbuf(int ix, int i, int len)
         }
     }
     cacheblk[ix].cache[i].len = len;
-    cacheblk[ix].size += len;
+    cs->size += len;
 }
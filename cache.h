@@ -9,6 +9,17 @@
     an identifying `key', `flags' which indicate whether an entry is
     busy or not, and a `buf' which is a pointer to the cached object.
 
+  Stripes:
+    The entries of a cache are divided into one or more `stripes',
+    each with its own lock.  The stripe that holds a key is chosen
+    by hashing the key, so a lookup, and the stealing of an entry to
+    hold the key, only need the lock for that one stripe.  Threads
+    accessing different keys in the same cache then rarely contend.
+    The entry counts, lookup statistics and the age counter are kept
+    per stripe and are only updated under that stripe's lock; the
+    counts are summed when queried.  Entry ages are therefore only
+    comparable within one stripe.
+
   Cache entry:
     The structure of a cache entry is:
       U64       key;
@@ -106,23 +117,43 @@
 
     Locking functions:
       int         cache_lock(int ix);
-                  Obtain the lock for cache `ix'.  If the cache does
-                  not exist then it will be created.  Generally, the
-                  lock should be obtained when referencing cache
-                  entries and must be held when a cache entry status
-                  may change from `busy' to `not busy' or vice versa.
-                  Likewise, the lock must be held when a cache entry
-                  changes from `empty' to `not empty' or vice versa.
+                  Obtain the locks for all stripes of cache `ix'.  If
+                  the cache does not exist then it will be created.
+                  Generally, the lock should be obtained when
+                  referencing cache entries and must be held when a
+                  cache entry status may change from `busy' to `not
+                  busy' or vice versa.  Likewise, the lock must be
+                  held when a cache entry changes from `empty' to
+                  `not empty' or vice versa.  Required by cache_scan.
 
       int         cache_unlock(int ix);
-                  Release the cache lock
+                  Release the locks for all stripes
+
+      int         cache_lock_key(int ix, U64 key);
+                  Obtain only the lock for the stripe of cache `ix'
+                  that holds `key'.  This is sufficient for
+                  cache_lookup and cache_wait for the key and for
+                  updating the entries of that stripe, including the
+                  entry returned for stealing.  If the cache does not
+                  exist then it will be created.
+
+      int         cache_unlock_key(int ix, U64 key);
+                  Release the lock obtained by cache_lock_key
+
+      int         cache_lock_entry(int ix, int i);
+                  Obtain only the lock for the stripe containing
+                  entry `i'; sufficient for updating that entry.
+
+      int         cache_unlock_entry(int ix, int i);
+                  Release the lock obtained by cache_lock_entry
 
     Search functions:
       int         cache_lookup(int ix, U64 key, int *o);
                   Search cache `ix' for entry matching `key'.
                   If a non-NULL pointer `o' is provided, then the
                   oldest or preferred cache entry index is returned
-                  that is available to be stolen.
+                  that is available to be stolen.  Only the stripe
+                  that holds `key' is searched.
 
       int         cache_scan (int ix, int (rtn)(), void *data);
                   Scan a cache routine entry by entry calling routine
@@ -136,10 +167,12 @@
                   value then the scan is terminated.
 
     Other functions:
-      int         cache_wait(int ix);
-                  Wait for a non-busy cache entry to become available.
-                  Typically called after `cache_lookup' was
-                  unsuccessful and `*o' is -1.
+      int         cache_wait(int ix, U64 key);
+                  Wait for a non-busy cache entry to become available
+                  in the stripe that holds `key'.  Must be called
+                  with only the cache_lock_key lock held.  Typically
+                  called after `cache_lookup' was unsuccessful and
+                  `*o' is -1.
 
       int         cache_release(int ix, int i, int flag);
                   Release the cache entry.  If flag is CACHE_FREEBUF
@@ -195,11 +228,12 @@ typedef struct _CACHE {                 /* Cache entry               */
     } CACHE;
 
 /*-------------------------------------------------------------------*/
-/* Cache header                                                      */
+/* Cache stripe                                                      */
 /*-------------------------------------------------------------------*/
-typedef struct _CACHEBLK {              /* Cache header              */
-      int       magic;                  /* Magic number              */
-      int       nbr;                    /* Number entries            */
+typedef struct _CACHESTRIPE {           /* Cache stripe              */
+      LOCK      lock;                   /* Lock                      */
+      COND      waitcond;               /* Wait for available entry  */
+      int       first;                  /* First entry index         */
       int       busy;                   /* Number busy entries       */
       int       empty;                  /* Number empty entries      */
       int       waiters;                /* Number waiters            */
@@ -209,8 +243,17 @@ typedef struct _CACHEBLK {              /* Cache header              */
       long long fasthits;               /* Number fast lookup hits   */
       long long misses;                 /* Number lookup misses      */
       U64       age;                    /* Age counter               */
-      LOCK      lock;                   /* Lock                      */
-      COND      waitcond;               /* Wait for available entry  */
+    } CACHESTRIPE;
+
+/*-------------------------------------------------------------------*/
+/* Cache header                                                      */
+/*-------------------------------------------------------------------*/
+typedef struct _CACHEBLK {              /* Cache header              */
+      int       magic;                  /* Magic number              */
+      int       nbr;                    /* Number entries            */
+      int       stripes;                /* Number stripes            */
+      int       stripenbr;              /* Number entries per stripe */
+      CACHESTRIPE *stripe;              /* Stripe table address      */
       CACHE    *cache;                  /* Cache table address       */
       time_t    atime;                  /* Time last adjustment      */
       time_t    wtime;                  /* Time last wait            */
@@ -236,6 +279,9 @@ typedef struct _CACHEBLK {              /* Cache header              */
 //      This is a workaround to increase the max number of devices
 #define CACHE_DEFAULT_L2_NBR       1031 /* Initial entries for L2    */
 
+#define CACHE_DEVBUF_STRIPES         16 /* Stripes for device buffers*/
+#define CACHE_DEVBUF_STRIPE_NBR      32 /* Entries per stripe        */
+
 #define CACHE_WAITTIME             1000 /* Wait time for entry(usec) */
 
 #define CACHE_ADJUST_INTERVAL        15 /* Adjustment interval (sec) */
@@ -255,13 +301,13 @@ typedef struct _CACHEBLK {              /* Cache header              */
 /*-------------------------------------------------------------------*/
 /* Functions                                                         */
 /*-------------------------------------------------------------------*/
-int         cache_nbr(int ix);
-int         cache_busy(int ix);
-int         cache_empty(int ix);
+CCH_DLL_IMPORT int         cache_nbr(int ix);
+CCH_DLL_IMPORT int         cache_busy(int ix);
+CCH_DLL_IMPORT int         cache_empty(int ix);
 int         cache_waiters(int ix);
-long long   cache_size(int ix);
-long long   cache_hits(int ix);
-long long   cache_misses(int ix);
+CCH_DLL_IMPORT long long   cache_size(int ix);
+CCH_DLL_IMPORT long long   cache_hits(int ix);
+CCH_DLL_IMPORT long long   cache_misses(int ix);
 int         cache_busy_percent(int ix);
 int         cache_empty_percent(int ix);
 int         cache_hit_percent(int ix);
@@ -270,7 +316,11 @@ typedef int CACHE_SCAN_RTN (int *answer, int ix, int i, void *data);
 int         cache_scan (int ix, CACHE_SCAN_RTN rtn, void *data);
 int         cache_lock(int ix);
 int         cache_unlock(int ix);
-int         cache_wait(int ix);
+int         cache_lock_key(int ix, U64 key);
+int         cache_unlock_key(int ix, U64 key);
+int         cache_lock_entry(int ix, int i);
+int         cache_unlock_entry(int ix, int i);
+int         cache_wait(int ix, U64 key);
 U64         cache_getkey(int ix, int i);
 U64         cache_setkey(int ix, int i, U64 key);
 U32         cache_getflag(int ix, int i);
@@ -293,6 +343,8 @@ static int  cache_check_cache(int ix);
 static int  cache_check(int ix, int i);
 static int  cache_isbusy(int ix, int i);
 static int  cache_isempty(int ix, int i);
+static CACHESTRIPE *cache_keystripe(int ix, U64 key);
+static CACHESTRIPE *cache_entrystripe(int ix, int i);
 static int  cache_adjust(int ix, int n);
 #if 0
 static int  cache_resize (int ix, int n);
@@ -319,6 +371,7 @@ static void cache_allocbuf(int ix, int i, int len);
 #define   CKD_CACHE_ACTIVE   0x80000000 /* Active entry              */
 #define   FBA_CACHE_ACTIVE   0x80000000 /* Active entry              */
 #define   SHRD_CACHE_ACTIVE  0x80000000 /* Active entry              */
+#define   SHRD_CACHE_READING 0x40000000 /* Read ahead in progress    */
 
 #define   DEVBUF_TYPE_SHARED 0x00000080 /* Shared entry type         */
 #define   DEVBUF_TYPE_COMP   0x00000040 /* CCKD/CFBA entry type      */
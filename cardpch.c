@@ -25,15 +25,14 @@ write_buffer (DEVBLK *dev, BYTE *buf, int len, BYTE *unitstat)
 {
 int             rc;                     /* Return code               */
 
-    /* Write data to the output file */
-    rc = write (dev->fd, buf, len);
+    /* Queue data for the output file */
+    rc = spool_write (&dev->spool, buf, len);
 
     /* Equipment check if error writing to output file */
-    if (rc < len)
+    if (rc < 0)
     {
         logmsg (_("HHCPU004E Error writing to %s: %s\n"),
-                dev->filename,
-                (errno == 0 ? "incomplete": strerror(errno)));
+                dev->filename, strerror(errno));
         dev->sense[0] = SENSE_EC;
         *unitstat = CSW_CE | CSW_DE | CSW_UC;
         return;
@@ -47,6 +46,12 @@ int             rc;                     /* Return code               */
 static int cardpch_init_handler (DEVBLK *dev, int argc, char *argv[])
 {
 int     i;                              /* Array subscript           */
+char   *nxt;                            /* -> End of number          */
+
+    /* Finish any output written before a devinit */
+    if (spool_close (&dev->spool) < 0)
+        logmsg (_("HHCPU004E Error writing to %s: %s\n"),
+                dev->filename, strerror(errno));
 
     /* The first argument is the file name */
     if (argc == 0 || strlen(argv[0]) > sizeof(dev->filename)-1)
@@ -65,6 +70,9 @@ int     i;                              /* Array subscript           */
     dev->cardpos = 0;
     dev->cardrem = CARD_LENGTH;
     dev->notrunc = 0;
+    dev->spool.fd = -1;
+    dev->spool.size = SPOOL_BUFSIZE;
+    dev->spool.compress = 0;
 
     if(!sscanf(dev->typname,"%hx",&(dev->devtype)))
         dev->devtype = 0x3525;
@@ -96,6 +104,23 @@ int     i;                              /* Array subscript           */
             continue;
         }
 
+        if (strncasecmp(argv[i], "bufsize=", 8) == 0)
+        {
+            errno = 0;
+            dev->spool.size = (int) strtoul(argv[i]+8, &nxt, 10);
+            if (errno == 0 && nxt != argv[i]+8 && *nxt == 0
+             && dev->spool.size >= 0 && dev->spool.size <= SPOOL_MAXSIZE)
+                continue;
+        }
+
+#if defined(HAVE_LIBZ)
+        if (strcasecmp(argv[i], "compress") == 0)
+        {
+            dev->spool.compress = 1;
+            continue;
+        }
+#endif /*defined(HAVE_LIBZ)*/
+
         logmsg (_("HHCPU002E Invalid argument: %s\n"),
                 argv[i]);
         return -1;
@@ -129,14 +154,21 @@ int     i;                              /* Array subscript           */
 static void cardpch_query_device (DEVBLK *dev, char **class,
                 int buflen, char *buffer)
 {
+char bufsize[20];                       /* bufsize= option           */
 
     BEGIN_DEVICE_CLASS_QUERY( "PCH", dev, class, buflen, buffer );
 
-    snprintf (buffer, buflen, "%s%s%s%s",
+    bufsize[0] = 0;
+    if (dev->spool.size != SPOOL_BUFSIZE)
+        snprintf (bufsize, sizeof(bufsize), " bufsize=%d", dev->spool.size);
+
+    snprintf (buffer, buflen, "%s%s%s%s%s%s",
                 dev->filename,
                 (dev->ascii ? " ascii" : " ebcdic"),
                 ((dev->ascii && dev->crlf) ? " crlf" : ""),
-                (dev->notrunc ? " notrunc" : ""));
+                (dev->notrunc ? " notrunc" : ""),
+                (dev->spool.compress ? " compress" : ""),
+                bufsize);
 
 } /* end function cardpch_query_device */
 
@@ -145,6 +177,11 @@ static void cardpch_query_device (DEVBLK *dev, char **class,
 /*-------------------------------------------------------------------*/
 static int cardpch_close_device ( DEVBLK *dev )
 {
+    /* Write the buffered output and stop the flusher thread */
+    if (spool_close (&dev->spool) < 0)
+        logmsg (_("HHCPU004E Error writing to %s: %s\n"),
+                dev->filename, strerror(errno));
+
     /* Close the device file */
     if (dev->fd >= 0)
         close (dev->fd);
@@ -193,6 +230,18 @@ char            pathname[MAX_PATH];     /* file path in host format  */
             return;
         }
         dev->fd = rc;
+
+        /* Start buffering output for the new file */
+        if (spool_open (&dev->spool, dev->fd, 0) < 0)
+        {
+            logmsg (_("HHCPU003E Error opening file %s: %s\n"),
+                    dev->filename, strerror(errno));
+            close (dev->fd);
+            dev->fd = -1;
+            dev->sense[0] = SENSE_IR;
+            *unitstat = CSW_CE | CSW_DE | CSW_UC;
+            return;
+        }
     }
 
     /* Process depending on CCW opcode */
@@ -43,7 +43,6 @@ int     cfba_write_block(DEVBLK *dev, int blkgrp, int off,
 int     cfba_used(DEVBLK *dev);
 int     cckd_read_trk(DEVBLK *dev, int trk, int ra, BYTE *unitstat);
 void    cckd_readahead(DEVBLK *dev, int trk);
-int     cckd_readahead_scan(int *answer, int ix, int i, void *data);
 void    cckd_ra();
 void    cckd_flush_cache(DEVBLK *dev);
 int     cckd_flush_cache_scan(int *answer, int ix, int i, void *data);
@@ -97,10 +96,14 @@ DEVBLK *cckd_find_device_by_devnum (U16 devnum);
 BYTE   *cckd_uncompress(DEVBLK *dev, BYTE *from, int len, int maxlen, int trk);
 int     cckd_uncompress_zlib(DEVBLK *dev, BYTE *to, BYTE *from, int len, int maxlen);
 int     cckd_uncompress_bzip2(DEVBLK *dev, BYTE *to, BYTE *from, int len, int maxlen);
+int     cckd_uncompress_lz4(DEVBLK *dev, BYTE *to, BYTE *from, int len, int maxlen);
+int     cckd_uncompress_zstd(DEVBLK *dev, BYTE *to, BYTE *from, int len, int maxlen);
 int     cckd_compress(DEVBLK *dev, BYTE **to, BYTE *from, int len, int comp, int parm);
 int     cckd_compress_none(DEVBLK *dev, BYTE **to, BYTE *from, int len, int parm);
 int     cckd_compress_zlib(DEVBLK *dev, BYTE **to, BYTE *from, int len, int parm);
 int     cckd_compress_bzip2(DEVBLK *dev, BYTE **to, BYTE *from, int len, int parm);
+int     cckd_compress_lz4(DEVBLK *dev, BYTE **to, BYTE *from, int len, int parm);
+int     cckd_compress_zstd(DEVBLK *dev, BYTE **to, BYTE *from, int len, int parm);
 void    cckd_command_help();
 void    cckd_command_opts();
 void    cckd_command_stats();
@@ -182,6 +185,10 @@ int             i, j;                   /* Loop indexes              */
     cckdblk.ranbr      = CCKD_DEFAULT_RA_SIZE;
     cckdblk.ramax      = CCKD_DEFAULT_RA;
     cckdblk.wrmax      = CCKD_DEFAULT_WRITER;
+    /* Allow a writer (compressor) per host processor */
+    if (hostinfo.num_procs > cckdblk.wrmax)
+        cckdblk.wrmax  = hostinfo.num_procs < CCKD_MAX_WRITER
+                       ? hostinfo.num_procs : CCKD_MAX_WRITER;
     cckdblk.gcmax      = CCKD_DEFAULT_GCOL;
     cckdblk.gcwait     = CCKD_DEFAULT_GCOLWAIT;
     cckdblk.gcparm     = CCKD_DEFAULT_GCOLPARM;
@@ -192,6 +199,12 @@ int             i, j;                   /* Loop indexes              */
 #endif
 #ifdef CCKD_BZIP2
     cckdblk.comps     |= CCKD_COMPRESS_BZIP2;
+#endif
+#ifdef CCKD_LZ4
+    cckdblk.comps     |= CCKD_COMPRESS_LZ4;
+#endif
+#ifdef CCKD_ZSTD
+    cckdblk.comps     |= CCKD_COMPRESS_ZSTD;
 #endif
     cckdblk.comp       = 0xff;
     cckdblk.compparm   = -1;
@@ -465,10 +478,11 @@ int             trk = 0;                /* Last active track         */
     }
     cckd->ioactive = 1;
 
-    cache_lock(CACHE_DEVBUF);
-
     if (dev->cache >= 0)
+    {
+        cache_lock_entry (CACHE_DEVBUF, dev->cache);
         CCKD_CACHE_GETKEY(dev->cache, devnum, trk);
+    }
 
     /* Check if previous active entry is still valid and not busy */
     if (dev->cache >= 0 && dev->devnum == devnum && dev->bufcur == trk
@@ -485,11 +499,14 @@ int             trk = 0;                /* Last active track         */
             if (cckd->iowaiters && !cckd->wrpending)
                 broadcast_condition (&cckd->iocond);
         }
+        cache_unlock_entry (CACHE_DEVBUF, dev->cache);
     }
     else
+    {
+        if (dev->cache >= 0)
+            cache_unlock_entry (CACHE_DEVBUF, dev->cache);
         dev->bufcur = dev->cache = -1;
-
-    cache_unlock (CACHE_DEVBUF);
+    }
 
     release_lock (&cckd->iolock);
 
@@ -525,9 +542,9 @@ CCKDDASD_EXT   *cckd;                   /* -> cckd extension         */
     /* Make the current entry inactive */
     if (dev->cache >= 0)
     {
-        cache_lock (CACHE_DEVBUF);
+        cache_lock_entry (CACHE_DEVBUF, dev->cache);
         cache_setflag (CACHE_DEVBUF, dev->cache, ~CCKD_CACHE_ACTIVE, 0);
-        cache_unlock (CACHE_DEVBUF);
+        cache_unlock_entry (CACHE_DEVBUF, dev->cache);
     }
 
     /* Cause writers to start after first update */
@@ -632,7 +649,7 @@ int             rc;                     /* Return code               */
                 sfx, cckd->fd[sfx], (long long)off, (long)len);
 
     /* Seek to specified offset */
-    if (lseek (cckd->fd[sfx], off, SEEK_SET) < 0)
+    if (!dev->iouring && lseek (cckd->fd[sfx], off, SEEK_SET) < 0)
     {
         logmsg (_("HHCCD130E %4.4X file[%d] lseek error, offset 0x%" I64_FMT "x: %s\n"),
                 dev->devnum, sfx, (long long)off, strerror(errno));
@@ -641,7 +658,10 @@ int             rc;                     /* Return code               */
     }
 
     /* Read the data */
-    rc = read (cckd->fd[sfx], buf, len);
+    if (dev->iouring)
+        rc = dasdio_pread (cckd->fd[sfx], buf, len, off);
+    else
+        rc = read (cckd->fd[sfx], buf, len);
     if (rc < (int)len)
     {
         if (rc < 0)
@@ -673,7 +693,7 @@ int             rc = 0;                 /* Return code               */
                 sfx, cckd->fd[sfx], (long long)off, (long)len);
 
     /* Seek to specified offset */
-    if (lseek (cckd->fd[sfx], off, SEEK_SET) < 0)
+    if (!dev->iouring && lseek (cckd->fd[sfx], off, SEEK_SET) < 0)
     {
         logmsg (_("HHCCD130E %4.4X file[%d] lseek error, offset 0x%" I64_FMT "x: %s\n"),
                 dev->devnum, sfx, (long long)off, strerror(errno));
@@ -681,7 +701,10 @@ int             rc = 0;                 /* Return code               */
     }
 
     /* Write the data */
-    rc = write (cckd->fd[sfx], buf, len);
+    if (dev->iouring)
+        rc = dasdio_pwrite (cckd->fd[sfx], buf, len, off);
+    else
+        rc = write (cckd->fd[sfx], buf, len);
     if (rc < (int)len)
     {
         if (rc < 0)
@@ -1175,6 +1198,7 @@ int             curtrk = -1;            /* Current track (at entry)  */
 U16             devnum;                 /* Device number             */
 U32             oldtrk;                 /* Stolen track number       */
 U32             flag;                   /* Cache flag                */
+U64             key;                    /* Cache key                 */
 BYTE           *buf;                    /* Read buffer               */
 
     cckd = dev->cckd_ext;
@@ -1184,29 +1208,36 @@ BYTE           *buf;                    /* Read buffer               */
     maxlen = cckd->ckddasd ? dev->ckdtrksz
                            : CFBA_BLOCK_SIZE + CKDDASD_TRKHDR_SIZE;
 
-    if (!ra) obtain_lock (&cckd->iolock);
+    key = CCKD_CACHE_SETKEY(dev->devnum, trk);
 
-    cache_lock (CACHE_DEVBUF);
+    if (!ra) obtain_lock (&cckd->iolock);
 
     /* Inactivate the old entry */
     if (!ra)
     {
         curtrk = dev->bufcur;
         if (dev->cache >= 0)
+        {
+            cache_lock_entry (CACHE_DEVBUF, dev->cache);
             cache_setflag(CACHE_DEVBUF, dev->cache, ~CCKD_CACHE_ACTIVE, 0);
+            cache_unlock_entry (CACHE_DEVBUF, dev->cache);
+        }
         dev->bufcur = dev->cache = -1;
     }
 
+    /* Only the cache stripe containing the track is locked */
+    cache_lock_key (CACHE_DEVBUF, key);
+
 cckd_read_trk_retry:
 
     /* scan the cache array for the track */
-    fnd = cache_lookup (CACHE_DEVBUF, CCKD_CACHE_SETKEY(dev->devnum, trk), &lru);
+    fnd = cache_lookup (CACHE_DEVBUF, key, &lru);
 
     /* check for cache hit */
     if (fnd >= 0)
     {
         if (ra) /* readahead doesn't care about a cache hit */
-        {   cache_unlock (CACHE_DEVBUF);
+        {   cache_unlock_key (CACHE_DEVBUF, key);
             return fnd;
         }
 
@@ -1221,7 +1252,7 @@ cckd_read_trk_retry:
                             "reading" : "writing");
                 cckdblk.stats_synciomisses++;
                 dev->syncio_retry = 1;
-                cache_unlock (CACHE_DEVBUF);
+                cache_unlock_key (CACHE_DEVBUF, key);
                 release_lock (&cckd->iolock);
                 return -1;
             }
@@ -1242,7 +1273,7 @@ cckd_read_trk_retry:
         }
         buf = cache_getbuf(CACHE_DEVBUF, fnd, 0);
 
-        cache_unlock (CACHE_DEVBUF);
+        cache_unlock_key (CACHE_DEVBUF, key);
 
         cckd_trace (dev, "%d rdtrk[%d] %d cache hit buf %p:%2.2x%2.2x%2.2x%2.2x%2.2x\n",
                     ra, fnd, trk, buf, buf[0], buf[1], buf[2], buf[3], buf[4]);
@@ -1279,7 +1310,7 @@ cckd_read_trk_retry:
     /* If not readahead and synchronous I/O then retry */
     if (!ra && dev->syncio_active)
     {
-        cache_unlock(CACHE_DEVBUF);
+        cache_unlock_key (CACHE_DEVBUF, key);
         release_lock (&cckd->iolock);
         cckd_trace (dev, "%d rdtrk[%d] %d syncio cache miss\n", ra, lru, trk);
         cckdblk.stats_synciomisses++;
@@ -1291,23 +1322,23 @@ cckd_read_trk_retry:
 
     /* If no cache entry was stolen, then flush all outstanding writes.
        This requires us to release our locks.  cache_wait should be
-       called with only the cache_lock held.  Fortunately, cache waits
-       occur very rarely. */
+       called with only the cache_lock_key lock held.  Fortunately,
+       cache waits occur very rarely. */
     if (lru < 0) /* No available entry to be stolen */
     {
         cckd_trace (dev, "%d rdtrk[%d] %d no available cache entry\n",
                     ra, lru, trk);
-        cache_unlock (CACHE_DEVBUF);
+        cache_unlock_key (CACHE_DEVBUF, key);
         if (!ra) release_lock (&cckd->iolock);
         cckd_flush_cache_all();
-        cache_lock (CACHE_DEVBUF);
+        cache_lock_key (CACHE_DEVBUF, key);
         cckdblk.stats_cachewaits++;
-        cache_wait (CACHE_DEVBUF);
+        cache_wait (CACHE_DEVBUF, key);
         if (!ra)
         {
-            cache_unlock (CACHE_DEVBUF);
+            cache_unlock_key (CACHE_DEVBUF, key);
             obtain_lock (&cckd->iolock);
-            cache_lock (CACHE_DEVBUF);
+            cache_lock_key (CACHE_DEVBUF, key);
         }
         goto cckd_read_trk_retry;
     }
@@ -1324,7 +1355,7 @@ cckd_read_trk_retry:
     }
 
     /* Initialize the entry */
-    cache_setkey(CACHE_DEVBUF, lru, CCKD_CACHE_SETKEY(dev->devnum, trk));
+    cache_setkey(CACHE_DEVBUF, lru, key);
     cache_setflag(CACHE_DEVBUF, lru, 0, CCKD_CACHE_READING);
     cache_setage(CACHE_DEVBUF, lru);
     cache_setval(CACHE_DEVBUF, lru, 0);
@@ -1341,7 +1372,7 @@ cckd_read_trk_retry:
     cckd_trace (dev, "%d rdtrk[%d] %d buf %p len %d\n",
                 ra, lru, trk, buf, cache_getlen(CACHE_DEVBUF, lru));
 
-    cache_unlock (CACHE_DEVBUF);
+    cache_unlock_key (CACHE_DEVBUF, key);
 
     if (!ra) release_lock (&cckd->iolock);
 
@@ -1361,9 +1392,9 @@ cckd_read_trk_retry:
     obtain_lock (&cckd->iolock);
 
     /* Turn off the READING bit */
-    cache_lock (CACHE_DEVBUF);
+    cache_lock_entry (CACHE_DEVBUF, lru);
     flag = cache_setflag(CACHE_DEVBUF, lru, ~CCKD_CACHE_READING, 0);
-    cache_unlock (CACHE_DEVBUF);
+    cache_unlock_entry (CACHE_DEVBUF, lru);
 
     /* Wakeup other thread waiting for this read */
     if (cckd->iowaiters && (flag & CCKD_CACHE_IOWAIT))
@@ -1395,6 +1426,7 @@ void cckd_readahead (DEVBLK *dev, int trk)
 {
 CCKDDASD_EXT   *cckd;                   /* -> cckd extension         */
 int             i, r;                   /* Indexes                   */
+U64             key;                    /* Cache key                 */
 TID             tid;                    /* Readahead thread id       */
 
     cckd = dev->cckd_ext;
@@ -1404,12 +1436,16 @@ TID             tid;                    /* Readahead thread id       */
 
     obtain_lock (&cckdblk.ralock);
 
-    /* Scan the cache to see if the tracks are already there */
+    /* Look up each track to see if it is already in the cache */
     memset(cckd->ralkup, 0, sizeof(cckd->ralkup));
-    cckd->ratrk = trk;
-    cache_lock(CACHE_DEVBUF);
-    cache_scan(CACHE_DEVBUF, cckd_readahead_scan, dev);
-    cache_unlock(CACHE_DEVBUF);
+    for (i = 1; i <= cckdblk.readaheads; i++)
+    {
+        key = CCKD_CACHE_SETKEY(dev->devnum, trk + i);
+        cache_lock_key (CACHE_DEVBUF, key);
+        if (cache_lookup (CACHE_DEVBUF, key, NULL) >= 0)
+            cckd->ralkup[i-1] = 1;
+        cache_unlock_key (CACHE_DEVBUF, key);
+    }
 
     /* Scan the queue to see if the tracks are already there */
     for (r = cckdblk.ra1st; r >= 0; r = cckdblk.ra[r].next)
@@ -1456,27 +1492,6 @@ TID             tid;                    /* Readahead thread id       */
 
 } /* end function cckd_readahead */
 
-int cckd_readahead_scan (int *answer, int ix, int i, void *data)
-{
-CCKDDASD_EXT   *cckd;                   /* -> cckd extension         */
-U16             devnum;                 /* Cached device number      */
-U32             trk;                    /* Cached track              */
-DEVBLK         *dev = data;             /* -> device block           */
-int             k;                      /* Index                     */
-
-    UNREFERENCED(answer);
-    UNREFERENCED(ix);
-    cckd = dev->cckd_ext;
-    CCKD_CACHE_GETKEY(i, devnum, trk);
-    if (devnum == dev->devnum)
-    {
-        k = (int)trk - cckd->ratrk;
-        if (k > 0 && k <= cckdblk.readaheads)
-            cckd->ralkup[k-1] = 1;
-    }
-    return 0;
-}
-
 /*-------------------------------------------------------------------*/
 /* Asynchronous readahead thread                                     */
 /*-------------------------------------------------------------------*/
@@ -1677,7 +1692,7 @@ int             comp;                   /* Compression algorithm     */
 int             parm;                   /* Compression parameter     */
 TID             tid;                    /* Writer thead id           */
 U32             flag;                   /* Cache flag                */
-static char    *compress[] = {"none", "zlib", "bzip2"};
+static char    *compress[] = CCKD_COMPRESS_NAMES;
 BYTE            buf2[65536];            /* Compress buffer           */
 
     UNREFERENCED(arg);
@@ -1807,9 +1822,9 @@ BYTE            buf2[65536];            /* Compress buffer           */
             create_thread (&tid, JOINABLE, cckd_gcol, NULL, "cckd_gcol");
 
         obtain_lock (&cckd->iolock);
-        cache_lock (CACHE_DEVBUF);
+        cache_lock_entry (CACHE_DEVBUF, o);
         flag = cache_setflag (CACHE_DEVBUF, o, ~CCKD_CACHE_WRITING, 0);
-        cache_unlock (CACHE_DEVBUF);
+        cache_unlock_entry (CACHE_DEVBUF, o);
         cckd->wrpending--;
         if (cckd->iowaiters && ((flag & CCKD_CACHE_IOWAIT) || !cckd->wrpending))
         {   cckd_trace (dev, "writer[%d] cache[%2.2d] %d signalling write complete\n",
@@ -1832,6 +1847,8 @@ BYTE            buf2[65536];            /* Compress buffer           */
     release_lock(&cckdblk.wrlock);
 } /* end thread cckd_writer */
 
+/* Ages are counted per cache stripe, so across stripes this only
+   approximates oldest first; later scans still find every write */
 int cckd_writer_scan (int *o, int ix, int i, void *data)
 {
     UNREFERENCED(data);
@@ -3349,7 +3366,7 @@ U16             cyl;                    /* Cylinder                  */
 U16             head;                   /* Head                      */
 int             t;                      /* Calculated track          */
 BYTE            badcomp=0;              /* 1=Unsupported compression */
-static char    *comp[] = {"none", "zlib", "bzip2"};
+static char    *comp[] = CCKD_COMPRESS_NAMES;
 
     cckd = dev->cckd_ext;
 
@@ -5011,7 +5028,7 @@ CCKDDASD_EXT   *cckd;
 BYTE           *to = NULL;                /* Uncompressed buffer     */
 int             newlen;                   /* Uncompressed length     */
 BYTE            comp;                     /* Compression type        */
-static char    *compress[] = {"none", "zlib", "bzip2"};
+static char    *compress[] = CCKD_COMPRESS_NAMES;
 
     cckd = dev->cckd_ext;
 
@@ -5044,6 +5061,14 @@ static char    *compress[] = {"none", "zlib", "bzip2"};
         to = cckd->newbuf;
         newlen = cckd_uncompress_bzip2 (dev, to, from, len, maxlen);
         break;
+    case CCKD_COMPRESS_LZ4:
+        to = cckd->newbuf;
+        newlen = cckd_uncompress_lz4 (dev, to, from, len, maxlen);
+        break;
+    case CCKD_COMPRESS_ZSTD:
+        to = cckd->newbuf;
+        newlen = cckd_uncompress_zstd (dev, to, from, len, maxlen);
+        break;
     default:
         newlen = -1;
         break;
@@ -5101,6 +5126,28 @@ static char    *compress[] = {"none", "zlib", "bzip2"};
         return to;
     }
 
+    /* lz4 compression */
+    to = cckd->newbuf;
+    newlen = cckd_uncompress_lz4 (dev, to, from, len, maxlen);
+    newlen = cckd_validate (dev, to, trk, newlen);
+    if (newlen > 0)
+    {
+        cckd->newbuf = from;
+        cckd->bufused = 1;
+        return to;
+    }
+
+    /* zstd compression */
+    to = cckd->newbuf;
+    newlen = cckd_uncompress_zstd (dev, to, from, len, maxlen);
+    newlen = cckd_validate (dev, to, trk, newlen);
+    if (newlen > 0)
+    {
+        cckd->newbuf = from;
+        cckd->bufused = 1;
+        return to;
+    }
+
     /* Unable to uncompress */
     logmsg (_("HHCCD193E %4.4X file[%d] uncompress error trk %d: %2.2x%2.2x%2.2x%2.2x%2.2x\n"),
             dev->devnum, cckd->sfn, trk, from[0], from[1], from[2], from[3], from[4]);
@@ -5174,6 +5221,69 @@ int rc;
     return -1;
 #endif
 }
+int cckd_uncompress_lz4 (DEVBLK *dev, BYTE *to, BYTE *from, int len, int maxlen)
+{
+#if defined(CCKD_LZ4)
+int newlen;
+
+    UNREFERENCED(dev);
+    memcpy (to, from, CKDDASD_TRKHDR_SIZE);
+    newlen = LZ4_decompress_safe (
+                (const char *)&from[CKDDASD_TRKHDR_SIZE],
+                (char *)&to[CKDDASD_TRKHDR_SIZE],
+                len - CKDDASD_TRKHDR_SIZE, maxlen - CKDDASD_TRKHDR_SIZE);
+    if (newlen >= 0)
+    {
+        newlen += CKDDASD_TRKHDR_SIZE;
+        to[0] = 0;
+    }
+    else
+        newlen = -1;
+
+    cckd_trace (dev, "uncompress lz4 newlen %d\n",newlen);
+
+    return newlen;
+#else
+    UNREFERENCED(dev);
+    UNREFERENCED(to);
+    UNREFERENCED(from);
+    UNREFERENCED(len);
+    UNREFERENCED(maxlen);
+    return -1;
+#endif
+}
+int cckd_uncompress_zstd (DEVBLK *dev, BYTE *to, BYTE *from, int len, int maxlen)
+{
+#if defined(CCKD_ZSTD)
+size_t newlen;
+
+    UNREFERENCED(dev);
+    memcpy (to, from, CKDDASD_TRKHDR_SIZE);
+    newlen = ZSTD_decompress (&to[CKDDASD_TRKHDR_SIZE],
+                              maxlen - CKDDASD_TRKHDR_SIZE,
+                              &from[CKDDASD_TRKHDR_SIZE],
+                              len - CKDDASD_TRKHDR_SIZE);
+    if (ZSTD_isError (newlen))
+    {
+        cckd_trace (dev, "uncompress zstd error %s\n",
+                    ZSTD_getErrorName (newlen));
+        return -1;
+    }
+    newlen += CKDDASD_TRKHDR_SIZE;
+    to[0] = 0;
+
+    cckd_trace (dev, "uncompress zstd newlen %d\n",(int)newlen);
+
+    return (int)newlen;
+#else
+    UNREFERENCED(dev);
+    UNREFERENCED(to);
+    UNREFERENCED(from);
+    UNREFERENCED(len);
+    UNREFERENCED(maxlen);
+    return -1;
+#endif
+}
 
 /*-------------------------------------------------------------------*/
 /* Compress a track image                                            */
@@ -5193,6 +5303,12 @@ int newlen;
     case CCKD_COMPRESS_BZIP2:
         newlen = cckd_compress_bzip2 (dev, to, from, len, parm);
         break;
+    case CCKD_COMPRESS_LZ4:
+        newlen = cckd_compress_lz4 (dev, to, from, len, parm);
+        break;
+    case CCKD_COMPRESS_ZSTD:
+        newlen = cckd_compress_zstd (dev, to, from, len, parm);
+        break;
     default:
         newlen = cckd_compress_bzip2 (dev, to, from, len, parm);
         break;
@@ -5268,6 +5384,60 @@ BYTE *buf;
     return cckd_compress_zlib (dev, to, from, len, parm);
 #endif
 }
+int cckd_compress_lz4 (DEVBLK *dev, BYTE **to, BYTE *from, int len, int parm)
+{
+#if defined(CCKD_LZ4)
+int newlen;
+BYTE *buf;
+
+    UNREFERENCED(dev);
+    buf = *to;
+    from[0] = CCKD_COMPRESS_NONE;
+    memcpy (buf, from, CKDDASD_TRKHDR_SIZE);
+    buf[0] = CCKD_COMPRESS_LZ4;
+    /* lz4 has no compression levels; higher `parm' values trade
+       ratio for speed through the acceleration factor */
+    newlen = LZ4_compress_fast (
+                    (const char *)&from[CKDDASD_TRKHDR_SIZE],
+                    (char *)&buf[CKDDASD_TRKHDR_SIZE],
+                    len - CKDDASD_TRKHDR_SIZE, 65535 - CKDDASD_TRKHDR_SIZE,
+                    parm >= 1 && parm <= 9 ? 10 - parm : 1);
+    newlen += CKDDASD_TRKHDR_SIZE;
+    if (newlen == CKDDASD_TRKHDR_SIZE || newlen >= len)
+    {
+        *to = from;
+        newlen = len;
+    }
+    return newlen;
+#else
+    return cckd_compress_zlib (dev, to, from, len, parm);
+#endif
+}
+int cckd_compress_zstd (DEVBLK *dev, BYTE **to, BYTE *from, int len, int parm)
+{
+#if defined(CCKD_ZSTD)
+size_t newlen;
+BYTE *buf;
+
+    UNREFERENCED(dev);
+    buf = *to;
+    from[0] = CCKD_COMPRESS_NONE;
+    memcpy (buf, from, CKDDASD_TRKHDR_SIZE);
+    buf[0] = CCKD_COMPRESS_ZSTD;
+    newlen = ZSTD_compress (&buf[CKDDASD_TRKHDR_SIZE], 65535 - CKDDASD_TRKHDR_SIZE,
+                    &from[CKDDASD_TRKHDR_SIZE], len - CKDDASD_TRKHDR_SIZE,
+                    parm >= 1 && parm <= 9 ? parm : 3);
+    if (ZSTD_isError (newlen)
+     || (int)(newlen += CKDDASD_TRKHDR_SIZE) >= len)
+    {
+        *to = from;
+        newlen = len;
+    }
+    return (int)newlen;
+#else
+    return cckd_compress_zlib (dev, to, from, len, parm);
+#endif
+}
 
 /*-------------------------------------------------------------------*/
 /* cckd command help                                                 */
@@ -5278,12 +5448,12 @@ void cckd_command_help()
              "help\t\tDisplay help message\n"
              "stats\t\tDisplay cckd statistics\n"
              "opts\t\tDisplay cckd options\n"
-             "comp=<n>\t\tOverride compression\t\t(-1 .. 2)\n"
+             "comp=<n>\t\tOverride compression\t\t(-1,0,1,2,4,8)\n"
              "compparm=<n>\tOverride compression parm\t\t(-1 .. 9)\n"
              "ra=<n>\t\tSet number readahead threads\t\t(1 .. 9)\n"
              "raq=<n>\t\tSet readahead queue size\t\t(0 .. 16)\n"
              "rat=<n>\t\tSet number tracks to read ahead\t\t(0 .. 16)\n"
-             "wr=<n>\t\tSet number writer threads\t\t(1 .. 9)\n"
+             "wr=<n>\t\tSet number writer threads\t\t(1 .. 32)\n"
              "gcint=<n>\tSet garbage collector interval (sec)\t(1 .. 60)\n"
              "gcparm=<n>\tSet garbage collector parameter\t\t(-8 .. 8)\n"
              "\t\t    (least agressive ... most aggressive)\n"
@@ -5401,7 +5571,8 @@ int   val, opts = 0;
         }
         else if (strcasecmp (kw, "comp") == 0)
         {
-            if (val < -1 || (val & ~cckdblk.comps) || c != '\0')
+            if (val < -1 || (val & ~cckdblk.comps) || (val & (val - 1))
+             || c != '\0')
             {
                 logmsg ("Invalid value for comp=\n");
                 return -1;
@@ -162,7 +162,8 @@ int decomptrk(
 /* This code based on decompression logic in cdsk_valid_trk.         */
 /* Returns length of decompressed data or -1 on error.               */
 {
-#if defined( HAVE_LIBZ ) || defined( CCKD_BZIP2 )
+#if defined( HAVE_LIBZ ) || defined( CCKD_BZIP2 ) \
+ || defined( CCKD_LZ4 ) || defined( CCKD_ZSTD )
 int             rc;                     /* Return code               */
 BYTE           *bufp;                   /* Buffer pointer            */
 #endif
@@ -171,7 +172,8 @@ size_t          bufl;                   /* Buffer length             */
 unsigned int    ubufl;                  /* when size_t != unsigned int */
 #endif
 
-#if !defined( HAVE_LIBZ ) && !defined( CCKD_BZIP2 )
+#if !defined( HAVE_LIBZ ) && !defined( CCKD_BZIP2 ) \
+ && !defined( CCKD_LZ4 ) && !defined( CCKD_ZSTD )
     UNREFERENCED(heads);
     UNREFERENCED(trk);
     UNREFERENCED(msg);
@@ -231,6 +233,50 @@ unsigned int    ubufl;                  /* when size_t != unsigned int */
         break;
 #endif
 
+#ifdef CCKD_LZ4
+    case CCKD_COMPRESS_LZ4:
+        bufp = obuf;
+        memcpy(obuf, ibuf, CKDDASD_TRKHDR_SIZE);
+        rc = LZ4_decompress_safe (
+                 (char *)&ibuf[CKDDASD_TRKHDR_SIZE],
+                 (char *)&obuf[CKDDASD_TRKHDR_SIZE],
+                 ibuflen - CKDDASD_TRKHDR_SIZE,
+                 obuflen - CKDDASD_TRKHDR_SIZE);
+        if (rc < 0) {
+            if (msg)
+                snprintf(msg, 80, "%s %d decompress error, rc=%d;"
+                         "%2.2x%2.2x%2.2x%2.2x%2.2x",
+                         heads >= 0 ? "trk" : "blk", trk, rc,
+                         ibuf[0], ibuf[1], ibuf[2], ibuf[3], ibuf[4]);
+            return -1;
+        }
+        bufl = rc + CKDDASD_TRKHDR_SIZE;
+        break;
+#endif
+
+#ifdef CCKD_ZSTD
+    case CCKD_COMPRESS_ZSTD:
+        bufp = obuf;
+        memcpy(obuf, ibuf, CKDDASD_TRKHDR_SIZE);
+        bufl = ZSTD_decompress (
+                 &obuf[CKDDASD_TRKHDR_SIZE],
+                 obuflen - CKDDASD_TRKHDR_SIZE,
+                 &ibuf[CKDDASD_TRKHDR_SIZE],
+                 ibuflen - CKDDASD_TRKHDR_SIZE);
+        rc = ZSTD_isError (bufl);
+        if (rc) {
+            if (msg)
+                snprintf(msg, 80, "%s %d decompress error, %s;"
+                         "%2.2x%2.2x%2.2x%2.2x%2.2x",
+                         heads >= 0 ? "trk" : "blk", trk,
+                         ZSTD_getErrorName (bufl),
+                         ibuf[0], ibuf[1], ibuf[2], ibuf[3], ibuf[4]);
+            return -1;
+        }
+        bufl += CKDDASD_TRKHDR_SIZE;
+        break;
+#endif
+
     default:
         return -1;
 
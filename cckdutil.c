@@ -48,7 +48,7 @@ static int  cdsk_valid_trk (int trk, BYTE *buf, int heads, int len);
 static BYTE  eighthexFF[] = {0xff,0xff,0xff,0xff,0xff,0xff,0xff,0xff};
 static char *spaces[] = { "none", "devhdr", "cdevhdr", "l1",  "l2",
                           "trk",  "blkgrp", "free",    "eof" }; 
-static char *comps[]  = { "none", "zlib",   "bzip2" };
+static char *comps[]  = { "none", "zlib",   "bzip2", "lz4", "zstd" };
 
 /*-------------------------------------------------------------------*/
 /* Change the endianess of a compressed file                         */
@@ -955,6 +955,16 @@ BYTE            buf[4*65536];           /* buffer                    */
 #else
     compmask[CCKD_COMPRESS_BZIP2] = 2;
 #endif
+#if defined(CCKD_LZ4)
+    compmask[CCKD_COMPRESS_LZ4] = 0;
+#else
+    compmask[CCKD_COMPRESS_LZ4] = 3;
+#endif
+#if defined(CCKD_ZSTD)
+    compmask[CCKD_COMPRESS_ZSTD] = 0;
+#else
+    compmask[CCKD_COMPRESS_ZSTD] = 4;
+#endif
 
     /*---------------------------------------------------------------
      * Header checks
@@ -1716,6 +1726,11 @@ cdsk_recovery:
                     else if (comp == CCKD_COMPRESS_BZIP2
                      && (buf[i+5] != 'B' || buf[i+6] != 'Z'))
                         continue;
+
+                    /* Quick validation for zstd */
+                    else if (comp == CCKD_COMPRESS_ZSTD
+                     && fetch_fw(buf + i + 5) != 0x28B52FFD)
+                        continue;
                     /*
                      * If we are in `borrowed space' then start over
                      * with the current position at the beginning
@@ -1771,6 +1786,10 @@ cdsk_recovery:
                         else if (buf[j] == CCKD_COMPRESS_BZIP2
                          && (buf[j+5] != 'B' || buf[j+6] != 'Z'))
                                 continue;
+                        /* check zstd compressed header */
+                        else if (buf[j] == CCKD_COMPRESS_ZSTD
+                         && fetch_fw(buf + j + 5) != 0x28B52FFD)
+                                continue;
 
                         /* check to possible trkhdr */
                         l = j - i;
@@ -1934,6 +1953,11 @@ cdsk_ckd_recover:
                     else if (comp == CCKD_COMPRESS_BZIP2
                      && (buf[i+5] != 'B' || buf[i+6] != 'Z'))
                         continue;
+
+                    /* Quick validation for zstd */
+                    else if (comp == CCKD_COMPRESS_ZSTD
+                     && fetch_fw(buf + i + 5) != 0x28B52FFD)
+                        continue;
                     /*
                      * If we are in `borrowed space' then start over
                      * with the current position at the beginning
@@ -1994,6 +2018,10 @@ cdsk_ckd_recover:
                         else if (buf[j] == CCKD_COMPRESS_BZIP2
                          && (buf[j+5] != 'B' || buf[j+6] != 'Z'))
                                 continue;
+                        /* check zstd compressed header */
+                        else if (buf[j] == CCKD_COMPRESS_ZSTD
+                         && fetch_fw(buf + j + 5) != 0x28B52FFD)
+                                continue;
 
                         /* check to possible trkhdr */
                         l = j - i;
@@ -2589,7 +2617,11 @@ uLongf          zlen;
 #ifdef CCKD_BZIP2
 unsigned int    bz2len;
 #endif
-#if defined(HAVE_LIBZ) || defined(CCKD_BZIP2)
+#ifdef CCKD_ZSTD
+size_t          zstdlen;
+#endif
+#if defined(HAVE_LIBZ) || defined(CCKD_BZIP2) || defined(CCKD_LZ4) \
+ || defined(CCKD_ZSTD)
 int             rc;                     /* Return code               */
 BYTE            buf2[65536];            /* Uncompressed buffer       */
 #endif
@@ -2636,6 +2668,34 @@ BYTE            buf2[65536];            /* Uncompressed buffer       */
         break;
 #endif
 
+#ifdef CCKD_LZ4
+    case CCKD_COMPRESS_LZ4:
+        if (len < 0) return 0;
+        bufp = (BYTE *)buf2;
+        memcpy (buf2, buf, CKDDASD_TRKHDR_SIZE);
+        rc = LZ4_decompress_safe ((char *)&buf[CKDDASD_TRKHDR_SIZE],
+                         (char *)&buf2[CKDDASD_TRKHDR_SIZE], len - CKDDASD_TRKHDR_SIZE,
+                         sizeof(buf2) - CKDDASD_TRKHDR_SIZE);
+        if (rc < 0)
+            return 0;
+        bufl = rc + CKDDASD_TRKHDR_SIZE;
+        break;
+#endif
+
+#ifdef CCKD_ZSTD
+    case CCKD_COMPRESS_ZSTD:
+        if (len < 0) return 0;
+        bufp = (BYTE *)buf2;
+        memcpy (buf2, buf, CKDDASD_TRKHDR_SIZE);
+        zstdlen = ZSTD_decompress (&buf2[CKDDASD_TRKHDR_SIZE], sizeof(buf2) - CKDDASD_TRKHDR_SIZE,
+                         &buf[CKDDASD_TRKHDR_SIZE], len - CKDDASD_TRKHDR_SIZE);
+        rc = ZSTD_isError (zstdlen);
+        if (rc)
+            return 0;
+        bufl = (int)zstdlen + CKDDASD_TRKHDR_SIZE;
+        break;
+#endif
+
     default:
         return 0;
 
@@ -1023,6 +1023,103 @@ int zone;
 }
 
 
+#if defined(OPTION_INSTRUCTION_PROFILE)
+void cgibin_debug_profile(WEBBLK *webblk)
+{
+PROFSTAT *stat;
+int i, n, max = 50;
+int active, interval;
+U64 total, lost;
+char *value;
+
+    if((value = cgi_variable(webblk,"max")))
+        sscanf(value,"%d",&max);
+
+    html_header(webblk);
+
+    total = profile_samples(&active, &interval, &lost);
+
+    hprintf(webblk->sock,"<h2>Instruction Profile</h2>\n");
+
+    hprintf(webblk->sock,"<p>Profiling %s, interval %d usecs, "
+                          "%" I64_FMT "u samples, "
+                          "%" I64_FMT "u without address</p>\n",
+                          active ? "active" : "stopped", interval,
+                          total, lost);
+
+    if(!total)
+    {
+        html_footer(webblk);
+        return;
+    }
+
+    n = profile_opcodes(&stat);
+
+    hprintf(webblk->sock,"<table border>\n"
+                          "<caption align=left>"
+                          "<h3>Opcodes</h3>"
+                          "</caption>\n");
+
+    hprintf(webblk->sock,"<tr><th>Opcode</th>"
+                          "<th>Instruction</th>"
+                          "<th>Samples</th>"
+                          "<th>%%</th>"
+                          "<th>Avg ns</th>"
+                          "<th>50%% ns</th>"
+                          "<th>99%% ns</th></tr>\n");
+
+    for(i = 0; i < n && i < max; i++)
+        hprintf(webblk->sock,"<tr><td>%2.2X%2.2X</td>"
+                              "<td>%s</td>"
+                              "<td>%" I64_FMT "u</td>"
+                              "<td>%.2f</td>"
+                              "<td>%" I64_FMT "u</td>"
+                              "<td>%" I64_FMT "u</td>"
+                              "<td>%" I64_FMT "u</td></tr>\n",
+                              stat[i].inst[0], stat[i].inst[1],
+                              stat[i].mnemonic, stat[i].samples,
+                              (stat[i].samples * 100.0) / total,
+                              stat[i].timed ? stat[i].nsecs / stat[i].timed : 0,
+                              stat[i].timed ? profile_pct(&stat[i], 50) : 0,
+                              stat[i].timed ? profile_pct(&stat[i], 99) : 0);
+
+    hprintf(webblk->sock,"</table>\n");
+
+    free(stat);
+
+    n = profile_addrs(&stat);
+
+    hprintf(webblk->sock,"<table border>\n"
+                          "<caption align=left>"
+                          "<h3>Addresses</h3>"
+                          "</caption>\n");
+
+    hprintf(webblk->sock,"<tr><th>CPU</th>"
+                          "<th>Address</th>"
+                          "<th>Instruction</th>"
+                          "<th>Samples</th>"
+                          "<th>%%</th></tr>\n");
+
+    for(i = 0; i < n && i < max; i++)
+        hprintf(webblk->sock,"<tr><td>%4.4X</td>"
+                              "<td>%16.16" I64_FMT "X</td>"
+                              "<td>%s</td>"
+                              "<td>%" I64_FMT "u</td>"
+                              "<td>%.2f</td></tr>\n",
+                              stat[i].cpuad, stat[i].addr,
+                              stat[i].mnemonic, stat[i].samples,
+                              (stat[i].samples * 100.0) / total);
+
+    hprintf(webblk->sock,"</table>\n");
+
+    free(stat);
+
+    html_footer(webblk);
+
+}
+#endif /*defined(OPTION_INSTRUCTION_PROFILE)*/
+
+
 void cgibin_configure_cpu(WEBBLK *webblk)
 {
 int i,j;
@@ -1109,6 +1206,36 @@ void cgibin_xml_rates_info(WEBBLK *webblk)
 #endif /*defined(OPTION_MIPS_COUNTING)*/
 
 
+void cgibin_metrics(WEBBLK *webblk, int json)
+{
+char *buf;
+
+    hprintf(webblk->sock,"Expires: 0\n");
+    if(json)
+        hprintf(webblk->sock,"Content-type: application/json\n\n");
+    else
+        hprintf(webblk->sock,"Content-type: text/plain; version=0.0.4\n\n");
+
+    if((buf = metrics_format(json)))
+    {
+        hwrite(webblk->sock, buf, strlen(buf));
+        free(buf);
+    }
+}
+
+
+void cgibin_metrics_prometheus(WEBBLK *webblk)
+{
+    cgibin_metrics(webblk, 0);
+}
+
+
+void cgibin_metrics_json(WEBBLK *webblk)
+{
+    cgibin_metrics(webblk, 1);
+}
+
+
 //  cgibin_hwrite: helper function to output HTML
 
 void cgibin_hwrite(WEBBLK *webblk, char *msg, int msg_len)
@@ -1243,6 +1370,9 @@ CGITAB cgidir[] = {
     { "debug/storage", &cgibin_debug_storage },
     { "debug/misc", &cgibin_debug_misc },
     { "debug/version_info", &cgibin_debug_version_info },
+#if defined(OPTION_INSTRUCTION_PROFILE)
+    { "debug/profile", &cgibin_debug_profile },
+#endif /*defined(OPTION_INSTRUCTION_PROFILE)*/
     { "debug/device/list", &cgibin_debug_device_list },
     { "debug/device/detail", &cgibin_debug_device_detail },
     { "registers/general", &cgibin_reg_general },
@@ -1251,6 +1381,8 @@ CGITAB cgidir[] = {
 #if defined(OPTION_MIPS_COUNTING)
     { "xml/rates", &cgibin_xml_rates_info },
 #endif /*defined(OPTION_MIPS_COUNTING)*/
+    { "metrics/prometheus", &cgibin_metrics_prometheus },
+    { "metrics/json", &cgibin_metrics_json },
     { NULL, NULL } };
 
 #endif /*defined(OPTION_HTTP_SERVER)*/
@@ -98,6 +98,20 @@ static void display_ccw (DEVBLK *dev, BYTE ccw[], U32 addr)
 {
 BYTE    area[64];                       /* Data display area         */
 
+#if defined(OPTION_TRACEBIN)
+    if (sysblk.tracebin && !dev->ccwstep)
+    {
+        TBREC rec;
+        memset (&rec, 0, sizeof(rec));
+        rec.type = TBREC_CCW;
+        rec.flags = TBREC_DATA;
+        memcpy (rec.u.io.word, ccw, 8);
+        rec.u.io.addr = addr;
+        tracebin_io (dev, &rec);
+        return;
+    }
+#endif /*defined(OPTION_TRACEBIN)*/
+
     format_iobuf_data (addr, area, dev);
     logmsg (_("HHCCP048I %4.4X:CCW=%2.2X%2.2X%2.2X%2.2X "
               "%2.2X%2.2X%2.2X%2.2X%s\n"),
@@ -112,6 +126,18 @@ BYTE    area[64];                       /* Data display area         */
 /*-------------------------------------------------------------------*/
 static void display_csw (DEVBLK *dev, BYTE csw[])
 {
+#if defined(OPTION_TRACEBIN)
+    if (sysblk.tracebin && !dev->ccwstep)
+    {
+        TBREC rec;
+        memset (&rec, 0, sizeof(rec));
+        rec.type = TBREC_CSW;
+        memcpy (rec.u.io.word, csw, 8);
+        tracebin_io (dev, &rec);
+        return;
+    }
+#endif /*defined(OPTION_TRACEBIN)*/
+
     logmsg (_("HHCCP049I %4.4X:Stat=%2.2X%2.2X Count=%2.2X%2.2X  "
             "CCW=%2.2X%2.2X%2.2X\n"),
             dev->devnum,
@@ -125,6 +151,18 @@ static void display_csw (DEVBLK *dev, BYTE csw[])
 /*-------------------------------------------------------------------*/
 static void display_scsw (DEVBLK *dev, SCSW scsw)
 {
+#if defined(OPTION_TRACEBIN)
+    if (sysblk.tracebin && !dev->ccwstep)
+    {
+        TBREC rec;
+        memset (&rec, 0, sizeof(rec));
+        rec.type = TBREC_SCSW;
+        memcpy (rec.u.io.word, &scsw, sizeof(SCSW));
+        tracebin_io (dev, &rec);
+        return;
+    }
+#endif /*defined(OPTION_TRACEBIN)*/
+
     logmsg (_("HHCCP050I %4.4X:SCSW=%2.2X%2.2X%2.2X%2.2X "
             "Stat=%2.2X%2.2X Count=%2.2X%2.2X  "
             "CCW=%2.2X%2.2X%2.2X%2.2X\n"),
@@ -137,6 +175,186 @@ static void display_scsw (DEVBLK *dev, SCSW scsw)
 
 } /* end function display_scsw */
 
+#if !defined(OPTION_FISHIO)
+/*-------------------------------------------------------------------*/
+/* Return the host time in microseconds                              */
+/*-------------------------------------------------------------------*/
+static U64 ioq_now ()
+{
+struct timeval  tv;
+
+    gettimeofday (&tv, NULL);
+    return (U64)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/*-------------------------------------------------------------------*/
+/* Initialize the device I/O queues                                  */
+/*-------------------------------------------------------------------*/
+/* One queue is used per host processor, up to DEVIOQ_MAX.  On a     */
+/* NUMA host the device threads of each queue are bound to the       */
+/* processors of one node, the nodes being assigned round robin.     */
+/*-------------------------------------------------------------------*/
+void ioq_init (void)
+{
+int     i;                              /* Queue index               */
+DEVIOQ *q;                              /* -> Device I/O queue       */
+
+    sysblk.numioq = hostinfo.num_procs;
+    if (sysblk.numioq < 1)
+        sysblk.numioq = 1;
+    if (sysblk.numioq > DEVIOQ_MAX)
+        sysblk.numioq = DEVIOQ_MAX;
+
+    for (i = 0; i < sysblk.numioq; i++)
+    {
+        q = &sysblk.devioq[i];
+        initialize_lock (&q->lock);
+        initialize_condition (&q->cond);
+        q->ioq = NULL;
+        q->waiting = q->searching = q->recheck = 0;
+        q->node = hostinfo.num_nodes > 1 ? i % hostinfo.num_nodes : -1;
+        q->queued = q->stolen = 0;
+    }
+}
+
+/*-------------------------------------------------------------------*/
+/* Wake all idle device threads (to check whether they should end)   */
+/*-------------------------------------------------------------------*/
+void ioq_wakeup (void)
+{
+int     i;                              /* Queue index               */
+DEVIOQ *q;                              /* -> Device I/O queue       */
+
+    for (i = 0; i < sysblk.numioq; i++)
+    {
+        q = &sysblk.devioq[i];
+        obtain_lock (&q->lock);
+        q->waiting = 0;
+        broadcast_condition (&q->cond);
+        release_lock (&q->lock);
+    }
+}
+
+/*-------------------------------------------------------------------*/
+/* Return 1 if any device is waiting on an I/O queue                 */
+/*-------------------------------------------------------------------*/
+int ioq_pending (void)
+{
+int     i;                              /* Queue index               */
+int     pending = 0;                    /* 1=I/O queued              */
+DEVIOQ *q;                              /* -> Device I/O queue       */
+
+    for (i = 0; i < sysblk.numioq && !pending; i++)
+    {
+        q = &sysblk.devioq[i];
+        obtain_lock (&q->lock);
+        pending = q->ioq != NULL;
+        release_lock (&q->lock);
+    }
+    return pending;
+}
+
+/*-------------------------------------------------------------------*/
+/* Remove a device from an I/O queue (queue lock held)               */
+/*-------------------------------------------------------------------*/
+static int ioq_remove (DEVIOQ *q, DEVBLK *dev)
+{
+DEVBLK *tmp;                            /* -> Queued device          */
+
+    /* special case for head of queue */
+    if (q->ioq == dev)
+    {
+        q->ioq = dev->nextioq;
+        return 1;
+    }
+
+    /* Search for device on i/o queue */
+    for (tmp = q->ioq; tmp != NULL && tmp->nextioq != dev; tmp = tmp->nextioq);
+    if (tmp == NULL)
+        return 0;
+    tmp->nextioq = dev->nextioq;
+    return 1;
+}
+
+/*-------------------------------------------------------------------*/
+/* Take the first device off an I/O queue (queue lock held)          */
+/*-------------------------------------------------------------------*/
+static DEVBLK *ioq_dequeue (DEVIOQ *q)
+{
+DEVBLK *dev;                            /* -> Device                 */
+U64     wait;                           /* Time on queue (usecs)     */
+
+    if ((dev = q->ioq) == NULL)
+        return NULL;
+    q->ioq = dev->nextioq;
+
+    /* Accumulate the queue wait time for the device */
+    wait = ioq_now() - dev->ioqtime;
+    dev->ioqwait += wait;
+    if (wait > dev->ioqwaitmax)
+        dev->ioqwaitmax = wait;
+    dev->ioqcount++;
+
+    return dev;
+}
+
+/*-------------------------------------------------------------------*/
+/* Take a device off one of the other I/O queues                     */
+/*-------------------------------------------------------------------*/
+static DEVBLK *ioq_steal (DEVIOQ *q)
+{
+int     i;                              /* Queue index               */
+DEVIOQ *r;                              /* -> Other I/O queue        */
+DEVBLK *dev = NULL;                     /* -> Device                 */
+
+    /* Start with the next queue so that taking is spread around */
+    for (i = 1; i < sysblk.numioq && dev == NULL; i++)
+    {
+        r = &sysblk.devioq[((q - sysblk.devioq) + i) % sysblk.numioq];
+        if (r->ioq == NULL)
+            continue;
+        obtain_lock (&r->lock);
+        if ((dev = ioq_dequeue (r)) != NULL)
+            r->stolen++;
+        release_lock (&r->lock);
+    }
+    return dev;
+}
+
+/*-------------------------------------------------------------------*/
+/* Have a device thread of another queue pick up queued work         */
+/*-------------------------------------------------------------------*/
+/* A thread that is looking at the other queues is told to look      */
+/* again before it waits; otherwise an idle thread is signalled.     */
+/* Returns 1 if a thread was found, otherwise 0.                     */
+/*-------------------------------------------------------------------*/
+static int ioq_notify (DEVIOQ *q)
+{
+int     i;                              /* Queue index               */
+int     found = 0;                      /* 1=Thread notified         */
+DEVIOQ *r;                              /* -> Other I/O queue        */
+
+    for (i = 1; i < sysblk.numioq && !found; i++)
+    {
+        r = &sysblk.devioq[((q - sysblk.devioq) + i) % sysblk.numioq];
+        obtain_lock (&r->lock);
+        if (r->waiting)
+        {
+            r->waiting--;
+            signal_condition (&r->cond);
+            found = 1;
+        }
+        else if (r->searching)
+        {
+            r->recheck = 1;
+            found = 1;
+        }
+        release_lock (&r->lock);
+    }
+    return found;
+}
+#endif /*!defined(OPTION_FISHIO)*/
+
 /*-------------------------------------------------------------------*/
 /* STORE CHANNEL ID                                                  */
 /*-------------------------------------------------------------------*/
@@ -186,6 +404,7 @@ PSA_3XX *psa;                           /* -> Prefixed storage area  */
     /* Store the channel id word at PSA+X'A8' */
     psa = (PSA_3XX*)(regs->mainstor + regs->PX);
     STORE_FW(psa->chanid, chanid);
+    BBC_INVALIDATE(psa->chanid, 4);
 
     /* Exit with condition code 0 indicating channel id stored */
     return 0;
@@ -267,6 +486,7 @@ IOINT *ioint=NULL;
             if (dev->pcipending)
             {
                 memcpy (psa->csw, dev->pcicsw, 8);
+                BBC_INVALIDATE(psa->csw, 8);
                 ioint=&dev->pciioint;
             }
             else
@@ -274,11 +494,13 @@ IOINT *ioint=NULL;
                 if(dev->pending)
                 {
                     memcpy (psa->csw, dev->csw, 8);
+                    BBC_INVALIDATE(psa->csw, 8);
                     ioint=&dev->ioint;
                 }
                 else
                 {
                     memcpy (psa->csw, dev->attncsw, 8);
+                    BBC_INVALIDATE(psa->csw, 8);
                     ioint=&dev->attnioint;
                 }
             }
@@ -302,6 +524,7 @@ IOINT *ioint=NULL;
                 dev->csw[5] = 0;
                 psa = (PSA_3XX*)(regs->mainstor + regs->PX);
                 memcpy (psa->csw, dev->csw, 8);
+                BBC_INVALIDATE(psa->csw, 8);
                 if (dev->ccwtrace)
                 {
                     logmsg(_("HHCCP052I TIO modification executed CC=1\n"));
@@ -365,6 +588,7 @@ int      pending = 0;                   /* New interrupt pending     */
             psa = (PSA_3XX*)( regs->mainstor + regs->PX );
             psa->csw[4] = 0;    /*  Store partial CSW       */
             psa->csw[5] = 0;
+            BBC_INVALIDATE(psa->csw, 8);
             cc = 1;             /*  Set CC for CSW stored   */
         }                                       /* @ISW */
         else
@@ -387,6 +611,7 @@ int      pending = 0;                   /* New interrupt pending     */
         /* Store the channel status word at PSA+X'40' */
         psa = (PSA_3XX*)(regs->mainstor + regs->PX);
         memcpy (psa->csw, dev->csw, 8);
+        BBC_INVALIDATE(psa->csw, 8);
 
         /* Set pending interrupt */
         dev->pending = pending = 1;
@@ -404,6 +629,7 @@ int      pending = 0;                   /* New interrupt pending     */
             dev->csw[5] = 0;
             psa = (PSA_3XX*)(regs->mainstor + regs->PX);
             memcpy (psa->csw, dev->csw, 8);
+            BBC_INVALIDATE(psa->csw, 8);
             if (dev->ccwtrace)
             {
                 logmsg(_("HHCCP054I HIO modification executed CC=1\n"));
@@ -486,29 +712,12 @@ int     cc;                             /* Condition code            */
     {
         cc = 2;
 #if !defined(OPTION_FISHIO)
-        obtain_lock(&sysblk.ioqlock);
-        if(sysblk.ioq != NULL)
+        if (dev->devioq != NULL)
         {
-         DEVBLK *tmp;
-
-            /* special case for head of queue */
-            if(sysblk.ioq == dev)
-            {
-                /* Remove device from the i/o queue */
-                sysblk.ioq = dev->nextioq;
+            /* Remove device from the i/o queue */
+            obtain_lock(&dev->devioq->lock);
+            if (ioq_remove(dev->devioq, dev))
                 cc = 0;
-            }
-            else
-            {
-                /* Search for device on i/o queue */
-                for(tmp = sysblk.ioq; tmp->nextioq != NULL && tmp->nextioq != dev; tmp = tmp->nextioq);
-                /* Remove from queue if found */
-                if(tmp->nextioq == dev)
-                {
-                    tmp->nextioq = tmp->nextioq->nextioq;
-                    cc = 0;
-                }
-            }
 
             /* Reset the device */
             if(!cc)
@@ -528,8 +737,8 @@ int     cc;                             /* Condition code            */
                 dev->busy = dev->startpending = 0;
 
             }
+            release_lock(&dev->devioq->lock);
         }
-        release_lock(&sysblk.ioqlock);
 #endif /*!defined(OPTION_FISHIO)*/
     }
 
@@ -956,21 +1165,16 @@ int pending = 0;
 
 #if !defined(OPTION_FISHIO)
         /* Remove the device from the ioq if startpending */
-        obtain_lock(&sysblk.ioqlock);
-        if(dev->startpending)
+        if (dev->devioq != NULL)
         {
-            if(sysblk.ioq == dev)
-                sysblk.ioq = dev->nextioq;
-            else if ( sysblk.ioq != NULL )      /* add check for empty IOQ */
-            {
-             DEVBLK *tmp;
-                for(tmp = sysblk.ioq; tmp->nextioq != NULL && tmp->nextioq != dev; tmp = tmp->nextioq);
-                if(tmp->nextioq == dev)
-                    tmp->nextioq = tmp->nextioq->nextioq;
-            }
+            obtain_lock(&dev->devioq->lock);
+            if(dev->startpending)
+                ioq_remove(dev->devioq, dev);
+            dev->startpending = 0;
+            release_lock(&dev->devioq->lock);
         }
-        dev->startpending = 0;
-        release_lock(&sysblk.ioqlock);
+        else
+            dev->startpending = 0;
 #endif /*!defined(OPTION_FISHIO)*/
 
         /* Invoke the provided halt_device routine @ISW */
@@ -1122,11 +1326,11 @@ void device_reset (DEVBLK *dev)
 {
     obtain_lock (&dev->lock);
 
-    obtain_lock(&sysblk.iointqlk);
+    OBTAIN_IOINTQLOCK(dev);
     DEQUEUE_IO_INTERRUPT_QLOCKED(&dev->ioint);
     DEQUEUE_IO_INTERRUPT_QLOCKED(&dev->pciioint);
     DEQUEUE_IO_INTERRUPT_QLOCKED(&dev->attnioint);
-    release_lock(&sysblk.iointqlk);
+    RELEASE_IOINTQLOCK(dev);
 
     dev->busy = dev->reserved = dev->pending = dev->pcipending =
     dev->attnpending = dev->startpending = 0;
@@ -1319,33 +1523,53 @@ void adjust_thread_priority(int *newprio)
 /*-------------------------------------------------------------------*/
 /* Execute a queued I/O                                              */
 /*-------------------------------------------------------------------*/
+/* The argument is the index of the I/O queue the thread serves.     */
+/*-------------------------------------------------------------------*/
 void *device_thread (void *arg)
 {
 char    thread_name[32];
 DEVBLK *dev;
+DEVIOQ *q;                              /* -> Device I/O queue       */
 int     current_priority;               /* Current thread priority   */
 
-    UNREFERENCED(arg);
+    q = &sysblk.devioq[(uintptr_t)arg % sysblk.numioq];
 
     adjust_thread_priority(&sysblk.devprio);
     current_priority = getpriority(PRIO_PROCESS, 0);
 
-    obtain_lock(&sysblk.ioqlock);
+    /* Run on the processors of the queue's NUMA node */
+    if (q->node >= 0)
+        bind_host_node (q->node);
 
+    obtain_lock(&sysblk.ioqlock);
     sysblk.devtnbr++;
     if (sysblk.devtnbr > sysblk.devthwm)
         sysblk.devthwm = sysblk.devtnbr;
+    release_lock (&sysblk.ioqlock);
+
+    obtain_lock(&q->lock);
 
     while (1)
     {
-        while ((dev=sysblk.ioq) != NULL)
+        dev = ioq_dequeue (q);
+
+        /* Take work from another queue if ours is empty */
+        if (dev == NULL && sysblk.numioq > 1)
+        {
+            q->searching++;
+            release_lock (&q->lock);
+            dev = ioq_steal (q);
+            obtain_lock (&q->lock);
+            q->searching--;
+        }
+
+        if (dev != NULL)
         {
             snprintf ( thread_name, sizeof(thread_name),
                 "device %4.4X thread", dev->devnum );
             thread_name[sizeof(thread_name)-1]=0;
             SET_THREAD_NAME(thread_name);
 
-            sysblk.ioq = dev->nextioq;
             dev->tid = thread_id();
 
             /* Set priority to requested device priority */
@@ -1353,27 +1577,38 @@ int     current_priority;               /* Current thread priority   */
                 adjust_thread_priority(&dev->devprio);
             current_priority = dev->devprio;
 
-            release_lock (&sysblk.ioqlock);
+            release_lock (&q->lock);
 
             call_execute_ccw_chain(sysblk.arch_mode, dev);
 
-            obtain_lock(&sysblk.ioqlock);
+            obtain_lock(&q->lock);
             dev->tid = 0;
+            continue;
+        }
+
+        /* Look again if work was queued while we were searching */
+        if (q->recheck)
+        {
+            q->recheck = 0;
+            continue;
         }
 
         SET_THREAD_NAME("idle device thread");
 
         if (sysblk.devtmax < 0
-         || (sysblk.devtmax == 0 && sysblk.devtwait > 3)
+         || (sysblk.devtmax == 0 && q->waiting > 3)
          || (sysblk.devtmax >  0 && sysblk.devtnbr > sysblk.devtmax)
          || (sysblk.shutdown))
             break;
 
         /* Wait for work to arrive */
-        sysblk.devtwait++;
-        wait_condition (&sysblk.ioqcond, &sysblk.ioqlock);
+        q->waiting++;
+        wait_condition (&q->cond, &q->lock);
     }
 
+    release_lock (&q->lock);
+
+    obtain_lock(&sysblk.ioqlock);
     sysblk.devtnbr--;
     release_lock (&sysblk.ioqlock);
     return NULL;
@@ -1840,9 +2075,10 @@ BYTE    midawflg;                       /* MIDAW flags            @MW*/
                     return;
                 }
 
-                /* Set the main storage reference and change bits */
-                STORAGE_KEY(midawdat, dev) |= (readcmd ? 
-                        (STORKEY_REF|STORKEY_CHANGE) : STORKEY_REF);
+                /* Set the main storage reference bit, and the change
+                   bit once the data is in storage so that a change bit
+                   reset meanwhile can not hide the store */
+                STORAGE_KEY(midawdat, dev) |= STORKEY_REF;
 
                 /* Copy data between main storage and channel buffer */
                 if (IS_CCW_RDBACK(code))
@@ -1851,6 +2087,9 @@ BYTE    midawflg;                       /* MIDAW flags            @MW*/
                     memcpy (dev->mainstor + midawdat,
                             iobuf + dev->curblkrem + midawrem - midawlen,
                             midawlen);
+                    BBC_INVALIDATE(dev->mainstor + midawdat, midawlen);
+                    STORAGE_KEY(midawdat + midawlen - 1, dev)
+                                                    |= STORKEY_CHANGE;
 
                     /* Decrement buffer pointer */
                     iobuf -= midawlen;
@@ -1858,7 +2097,11 @@ BYTE    midawflg;                       /* MIDAW flags            @MW*/
                 else
                 {
                     if (readcmd)
+                    {
                         memcpy (dev->mainstor + midawdat, iobuf, midawlen);
+                        BBC_INVALIDATE(dev->mainstor + midawdat, midawlen);
+                        STORAGE_KEY(midawdat, dev) |= STORKEY_CHANGE;
+                    }
                     else
                         memcpy (iobuf, dev->mainstor + midawdat, midawlen);
 
@@ -1928,9 +2171,10 @@ BYTE    midawflg;                       /* MIDAW flags            @MW*/
             /* Reduce length if less than one page remaining */
             if (idalen > idacount) idalen = idacount;
 
-            /* Set the main storage reference and change bits */
-            STORAGE_KEY(idadata, dev) |=
-                (readcmd ? (STORKEY_REF|STORKEY_CHANGE) : STORKEY_REF);
+            /* Set the main storage reference bit, and the change
+               bit once the data is in storage so that a change bit
+               reset meanwhile can not hide the store */
+            STORAGE_KEY(idadata, dev) |= STORKEY_REF;
 
             /* Copy data between main storage and channel buffer */
             if (IS_CCW_RDBACK(code))
@@ -1938,11 +2182,17 @@ BYTE    midawflg;                       /* MIDAW flags            @MW*/
                 idadata =  (idadata - idalen) + 1;
                 memcpy (dev->mainstor + idadata,
                         iobuf + dev->curblkrem + idacount - idalen, idalen);
+                BBC_INVALIDATE(dev->mainstor + idadata, idalen);
+                STORAGE_KEY(idadata + idalen - 1, dev) |= STORKEY_CHANGE;
             }
             else
             {
                 if (readcmd)
+                {
                     memcpy (dev->mainstor + idadata, iobuf, idalen);
+                    BBC_INVALIDATE(dev->mainstor + idadata, idalen);
+                    STORAGE_KEY(idadata, dev) |= STORKEY_CHANGE;
+                }
                 else
                     memcpy (iobuf, dev->mainstor + idadata, idalen);
 
@@ -2025,13 +2275,12 @@ BYTE    midawflg;                       /* MIDAW flags            @MW*/
             }
         } /* end for(page) */
 
-        /* Set the main storage reference and change bits */
+        /* Set the main storage reference bits */
         for (page = startpage & STORAGE_KEY_PAGEMASK;
              page <= (endpage | STORAGE_KEY_BYTEMASK);
              page += STORAGE_KEY_PAGESIZE)
         {
-            STORAGE_KEY(page, dev) |=
-                (readcmd ? (STORKEY_REF|STORKEY_CHANGE) : STORKEY_REF);
+            STORAGE_KEY(page, dev) |= STORKEY_REF;
         } /* end for(page) */
 
         /* Copy data between main storage and channel buffer */
@@ -2046,6 +2295,16 @@ BYTE    midawflg;                       /* MIDAW flags            @MW*/
             {
                 memcpy (dev->mainstor + addr, iobuf, count);
             }
+            BBC_INVALIDATE(dev->mainstor + addr, count);
+
+            /* Set the change bits once the data is in storage, so
+               that a change bit reset meanwhile can not hide it */
+            for (page = startpage & STORAGE_KEY_PAGEMASK;
+                 page <= (endpage | STORAGE_KEY_BYTEMASK);
+                 page += STORAGE_KEY_PAGESIZE)
+            {
+                STORAGE_KEY(page, dev) |= STORKEY_CHANGE;
+            } /* end for(page) */
         }
         else
         {
@@ -2167,6 +2426,7 @@ int     syncio;                         /* 1=Do synchronous I/O      */
 #if !defined(OPTION_FISHIO)
 int     rc;                             /* Return code               */
 DEVBLK *previoq, *ioq;                  /* Device I/O queue pointers */
+DEVIOQ *q;                              /* -> Device I/O queue       */
 #endif // !defined(OPTION_FISHIO)
 
     obtain_lock (&dev->lock);
@@ -2307,43 +2567,62 @@ DEVBLK *previoq, *ioq;                  /* Device I/O queue pointers */
 #else // !defined(OPTION_FISHIO)
     if (sysblk.devtmax >= 0)
     {
-        /* Queue the I/O request */
-        obtain_lock (&sysblk.ioqlock);
+        /* Queue the I/O request on the queue for its channel path */
+        q = &sysblk.devioq[dev->pmcw.chpid[0] % sysblk.numioq];
+        obtain_lock (&q->lock);
 
         /* Insert the device into the I/O queue */
-        for (previoq = NULL, ioq = sysblk.ioq; ioq; ioq = ioq->nextioq)
+        for (previoq = NULL, ioq = q->ioq; ioq; ioq = ioq->nextioq)
         {
             if (dev->priority < ioq->priority) break;
             previoq = ioq;
         }
         dev->nextioq = ioq;
         if (previoq) previoq->nextioq = dev;
-        else sysblk.ioq = dev;
-
-        /* Signal a device thread if one is waiting, otherwise create
-           a device thread if the maximum number hasn't been created */
-        if (sysblk.devtwait)
+        else q->ioq = dev;
+        dev->devioq = q;
+        dev->ioqtime = ioq_now();
+        q->queued++;
+
+        /* Signal a device thread of this queue if one is waiting,
+           otherwise one of another queue, otherwise create a device
+           thread if the maximum number hasn't been created */
+        if (q->waiting)
+        {
+            q->waiting--;
+            signal_condition(&q->cond);
+            release_lock (&q->lock);
+        }
+        else if (q->searching)
         {
-            sysblk.devtwait--;
-            signal_condition(&sysblk.ioqcond);
+            q->recheck = 1;
+            release_lock (&q->lock);
         }
-        else if (sysblk.devtmax == 0 || sysblk.devtnbr < sysblk.devtmax)
+        else
         {
-            rc = create_thread (&dev->tid, DETACHED,
-                        device_thread, NULL, "idle device thread");
-            if (rc != 0 && sysblk.devtnbr == 0)
+            release_lock (&q->lock);
+            if (!ioq_notify (q))
             {
-                logmsg (_("HHCCP067E %4.4X create_thread error: %s"),
-                        dev->devnum, strerror(errno));
+                obtain_lock (&sysblk.ioqlock);
+                if (sysblk.devtmax == 0 || sysblk.devtnbr < sysblk.devtmax)
+                {
+                    rc = create_thread (&dev->tid, DETACHED, device_thread,
+                            (void *)(uintptr_t)(q - sysblk.devioq),
+                            "idle device thread");
+                    if (rc != 0 && sysblk.devtnbr == 0)
+                    {
+                        logmsg (_("HHCCP067E %4.4X create_thread error: %s"),
+                                dev->devnum, strerror(errno));
+                        release_lock (&sysblk.ioqlock);
+                        release_lock (&dev->lock);
+                        return 2;
+                    }
+                }
+                else
+                    sysblk.devtunavail++;
                 release_lock (&sysblk.ioqlock);
-                release_lock (&dev->lock);
-                return 2;
             }
         }
-        else
-            sysblk.devtunavail++;
-
-        release_lock (&sysblk.ioqlock);
     }
     else
     {
@@ -2478,6 +2757,7 @@ int     cmdretry = 255;                 /* Limit command retry       */
     {
         dev->chained = dev->prev_chained =
         dev->code    = dev->prevcode     = dev->ccwseq = 0;
+        dev->excps++;
     }
 
     /* Check for synchronous I/O */
@@ -2507,11 +2787,11 @@ int     cmdretry = 255;                 /* Limit command retry       */
             && (((STORAGE_KEY(mbaddr, dev) & STORKEY_KEY) == _IOA_MBK)
                 || (_IOA_MBK == 0)))
         {
-            STORAGE_KEY(mbaddr, dev) |= (STORKEY_REF | STORKEY_CHANGE);
             mbk = (MBK*)&dev->mainstor[mbaddr];
             FETCH_HW(mbcount,mbk->srcount);
             mbcount++;
             STORE_HW(mbk->srcount,mbcount);
+            STORAGE_KEY(mbaddr, dev) |= (STORKEY_REF | STORKEY_CHANGE);
         } else {
             /* Generate subchannel logout indicating program
                check or protection check, and set the subchannel
@@ -2650,10 +2930,10 @@ int     cmdretry = 255;                 /* Limit command retry       */
             }
 
             /* Queue the pending interrupt */
-            obtain_lock(&sysblk.iointqlk);
+            OBTAIN_IOINTQLOCK(dev);
             DEQUEUE_IO_INTERRUPT_QLOCKED(&dev->pciioint);
             QUEUE_IO_INTERRUPT_QLOCKED(&dev->ioint);
-            release_lock(&sysblk.iointqlk);
+            RELEASE_IOINTQLOCK(dev);
 
             release_lock (&dev->lock);
 
@@ -2710,10 +2990,10 @@ int     cmdretry = 255;                 /* Limit command retry       */
             }
 
             /* Queue the pending interrupt */
-            obtain_lock(&sysblk.iointqlk);
+            OBTAIN_IOINTQLOCK(dev);
             DEQUEUE_IO_INTERRUPT_QLOCKED(&dev->pciioint);
             QUEUE_IO_INTERRUPT_QLOCKED(&dev->ioint);
-            release_lock(&sysblk.iointqlk);
+            RELEASE_IOINTQLOCK(dev);
 
             release_lock (&dev->lock);
 
@@ -3117,6 +3397,12 @@ resume_suspend:
          */
         dev->syncio_retry = 0;
 
+        /* Update the device I/O statistics */
+        dev->ccws++;
+        dev->iobytes += count - residual;
+        if (unitstat & CSW_UC)
+            dev->unitchecks++;
+
         /* Check for Command Retry (suggested by Jim Pierson) */
         if ( --cmdretry && unitstat == ( CSW_CE | CSW_DE | CSW_UC | CSW_SM ) )
         {
@@ -3177,6 +3463,29 @@ resume_suspend:
             tracethis = 1;
         }
 
+#if defined(OPTION_TRACEBIN)
+        /* Record the results of CCW execution in the binary trace */
+        if (sysblk.tracebin && !dev->ccwstep
+         && (dev->ccwtrace || tracethis))
+        {
+            TBREC rec;
+            memset (&rec, 0, sizeof(rec));
+            rec.type = TBREC_CCWEND;
+            rec.u.io.addr = addr;
+            rec.u.io.count = residual;
+            rec.u.io.unitstat = unitstat;
+            rec.u.io.chanstat = chanstat;
+            if (IS_CCW_READ(dev->code) || IS_CCW_SENSE(dev->code) || IS_CCW_RDBACK(dev->code))
+                rec.flags |= TBREC_DATA;
+            if (unitstat & CSW_UC)
+            {
+                rec.flags |= TBREC_SENSE;
+                memcpy (rec.u.io.word, dev->sense, sizeof(rec.u.io.word));
+            }
+            tracebin_io (dev, &rec);
+        }
+        else
+#endif /*defined(OPTION_TRACEBIN)*/
         /* Trace the results of CCW execution */
         if (dev->ccwtrace || dev->ccwstep || tracethis)
         {
@@ -3453,7 +3762,8 @@ int     i;                              /* Interruption subclass     */
 /* The CSW pointer is NULL in the case of TPI.                       */
 /* The return value is the condition code for the TPI instruction:   */
 /* 0 if no allowable pending interrupt exists, otherwise 1.          */
-/* Note: The caller MUST hold the interrupt lock (sysblk.intlock).   */
+/* Note: The caller must NOT hold the interrupt lock (sysblk.intlock)*/
+/* which is only obtained here to update the IC_IOPENDING state.     */
 /*-------------------------------------------------------------------*/
 /* I/O Assist:                                                       */
 /* This routine must return:                                         */
@@ -3469,8 +3779,11 @@ int ARCH_DEP(present_io_interrupt) (REGS *regs, U32 *ioid,
                                   U32 *ioparm, U32 *iointid, BYTE *csw)
 {
 IOINT  *io, *io2;                       /* -> I/O interrupt entry    */
+IOINTQ *q;                              /* -> I/O interrupt queue    */
 DEVBLK *dev;                            /* -> Device control block   */
+int     isc;                            /* Interruption subclass     */
 int     icode = 0;                      /* Intercept code            */
+int     locked;                         /* 1=Device and queue locked */
 #if defined(FEATURE_S370_CHANNEL)
 BYTE    *pendcsw;                       /* Pending CSW               */
 #endif
@@ -3485,28 +3798,55 @@ BYTE    *pendcsw;                       /* Pending CSW               */
 
     /* Find a device with pending interrupt */
 
-    /* (N.B. devlock cannot be acquired while iointqlk held;
-       iointqlk must be acquired after devlock) */
+    /* (N.B. devlock cannot be waited for while a queue lock is held;
+       the queue lock must be acquired after devlock) */
 retry:
     dev = NULL;
-    obtain_lock(&sysblk.iointqlk);
-    for (io = sysblk.iointq; io != NULL; io = io->next)
+    io = NULL;
+    locked = 0;
+    for (isc = 0; isc < IOINTQ_MAX; isc++)
     {
-        /* Exit loop if enabled for interrupts from this device */
-        if ((icode = ARCH_DEP(interrupt_enabled)(regs, io->dev))
+        q = &sysblk.iointq[isc];
+
+        /* Pass over an empty queue without locking it */
+        if (q->head == NULL)
+            continue;
+
+#if defined(FEATURE_CHANNEL_SUBSYSTEM)
+        /* Pass over a subclass which is disabled in CR6 */
+        if (!SIE_MODE(regs) && !(regs->CR_L(6) & (0x80000000 >> isc)))
+            continue;
+#endif /*defined(FEATURE_CHANNEL_SUBSYSTEM)*/
+
+        obtain_lock(&q->lock);
+        for (io = q->head; io != NULL; io = io->next)
+        {
+            /* Exit loop if enabled for interrupts from this device */
+            if ((icode = ARCH_DEP(interrupt_enabled)(regs, io->dev))
 #if defined(_FEATURE_IO_ASSIST)
-          && icode != SIE_INTERCEPT_IOINTP
+              && icode != SIE_INTERCEPT_IOINTP
 #endif
-                                          )
+                                              )
+            {
+                dev = io->dev;
+                break;
+            }
+
+        } /* end for(io) */
+
+        /* Keep the queue locked if the device lock is free, so that
+           the interrupt need not be looked up again once it is held */
+        if (io != NULL && try_obtain_lock(&dev->lock) == 0)
         {
-            dev = io->dev;
+            locked = 1;
             break;
         }
+        release_lock(&q->lock);
 
-        /* See if another CPU can take this interrupt */
-        WAKEUP_CPU_MASK (sysblk.waiting_mask);
+        if (io != NULL)
+            break;
 
-    } /* end for(io) */
+    } /* end for(isc) */
 
 #if defined(_FEATURE_IO_ASSIST)
     /* In the case of I/O assist, do a rescan, to see if there are
@@ -3517,41 +3857,59 @@ retry:
         /* Find a device with a pending interrupt, regardless
            of the interrupt subclass mask */
         ASSERT(dev == NULL);
-        for (io = sysblk.iointq; io != NULL; io = io->next)
+        for (isc = 0; isc < IOINTQ_MAX; isc++)
         {
-            /* Exit loop if pending interrupts from this device */
-            if ((icode = ARCH_DEP(interrupt_enabled)(regs, io->dev)))
+            q = &sysblk.iointq[isc];
+            if (q->head == NULL)
+                continue;
+
+            obtain_lock(&q->lock);
+            for (io = q->head; io != NULL; io = io->next)
             {
-                dev = io->dev;
+                /* Exit loop if pending interrupts from this device */
+                if ((icode = ARCH_DEP(interrupt_enabled)(regs, io->dev)))
+                {
+                    dev = io->dev;
+                    break;
+                }
+            } /* end for(io) */
+            release_lock(&q->lock);
+
+            if (io != NULL)
                 break;
-            }
-        } /* end for(io) */
+
+        } /* end for(isc) */
     }
 #endif
-    release_lock(&sysblk.iointqlk);
 
-    /* If no interrupt pending, exit with condition code 0 */
+    /* If no interrupt pending, exit with condition code 0; another
+       CPU may be enabled for the interrupts we passed over */
     if (io == NULL)
     {
         ASSERT(dev == NULL);
+        OBTAIN_INTLOCK(regs);
         UPDATE_IC_IOPENDING();
+        RELEASE_INTLOCK(regs);
         return 0;
     }
 
-    /* Obtain device lock for device with interrupt */
     ASSERT(dev != NULL);
-    obtain_lock (&dev->lock);
+    if (!locked)
+    {
+        /* Obtain device lock for device with interrupt */
+        obtain_lock (&dev->lock);
 
-    /* Verify interrupt for this device still exists */
-    obtain_lock(&sysblk.iointqlk);
-    for (io2 = sysblk.iointq; io2 != NULL && io2 != io; io2 = io2->next);
+        /* Verify interrupt for this device still exists */
+        obtain_lock(&q->lock);
+        for (io2 = q->head; io2 != NULL && io2 != io; io2 = io2->next);
 
-    if (io2 == NULL)
-    {
-        /* Our interrupt was dequeued; retry */
-        release_lock(&sysblk.iointqlk);
-        release_lock (&dev->lock);
-        goto retry;
+        if (io2 == NULL)
+        {
+            /* Our interrupt was dequeued; retry */
+            release_lock(&q->lock);
+            release_lock (&dev->lock);
+            goto retry;
+        }
     }
 
 #ifdef FEATURE_S370_CHANNEL
@@ -3613,15 +3971,29 @@ retry:
 
         /* Dequeue the interrupt */
         DEQUEUE_IO_INTERRUPT_QLOCKED(io);
-        UPDATE_IC_IOPENDING_QLOCKED();
+        q->presented++;
 
         /* Signal console thread to redrive select */
         if (dev->console)
             SIGNAL_CONSOLE_THREAD();
     }
-    release_lock(&sysblk.iointqlk);
+    release_lock(&q->lock);
     release_lock (&dev->lock);
 
+    /* The interrupt lock is only needed to reset IC_IOPENDING when
+       the queues are now empty, or to have a waiting CPU take the
+       next interrupt.  A device thread queueing an interrupt meanwhile
+       sets IC_IOPENDING again under the interrupt lock. */
+    for (isc = 0; isc < IOINTQ_MAX; isc++)
+        if (sysblk.iointq[isc].head != NULL)
+            break;
+    if (isc >= IOINTQ_MAX || sysblk.waiting_mask)
+    {
+        OBTAIN_INTLOCK(regs);
+        UPDATE_IC_IOPENDING();
+        RELEASE_INTLOCK(regs);
+    }
+
     /* Exit with condition code indicating interrupt cleared */
     return icode;
 
@@ -3633,6 +4005,7 @@ int ARCH_DEP(present_zone_io_interrupt) (U32 *ioid, U32 *ioparm,
                                                U32 *iointid, BYTE zone)
 {
 IOINT  *io;                             /* -> I/O interrupt entry    */
+IOINTQ *q;                              /* -> I/O interrupt queue    */
 DEVBLK *dev;                            /* -> Device control block   */
 typedef struct _DEVLIST {               /* list of device block ptrs */
     struct _DEVLIST *next;              /* next list entry or NULL   */
@@ -3688,11 +4061,13 @@ DEVLIST *pZoneDevs = NULL;              /* devices in requested zone */
 
     /* Remove from our list those devices
        without a pending interrupt queued */
-    obtain_lock(&sysblk.iointqlk);
     for (pDEVLIST = pZoneDevs, pPrevDEVLIST = NULL; pDEVLIST;)
     {
         /* Search interrupt queue for this device */
-        for (io = sysblk.iointq; io != NULL && io->dev != pDEVLIST->dev; io = io->next);
+        q = IOINTQ(pDEVLIST->dev);
+        obtain_lock(&q->lock);
+        for (io = q->head; io != NULL && io->dev != pDEVLIST->dev; io = io->next);
+        release_lock(&q->lock);
 
         /* Is interrupt queued for this device? */
         if (io == NULL)
@@ -3719,7 +4094,6 @@ DEVLIST *pZoneDevs = NULL;              /* devices in requested zone */
             pDEVLIST = pDEVLIST->next;
         }
     }
-    release_lock(&sysblk.iointqlk);
 
     /* If no devices remain, exit with condition code 0 */
     if (!pZoneDevs)
@@ -252,6 +252,8 @@ char            pathname[MAX_PATH];     /* file path in host format  */
 
     /* Default to synchronous I/O */
     dev->syncio = 1;
+    dev->iouring = 0;
+    dev->dasdmmap = 0;
 
     /* No active track or cache entry */
     dev->bufcur = dev->cache = -1;
@@ -343,6 +345,26 @@ char            pathname[MAX_PATH];     /* file path in host format  */
             dev->syncio = 1;
             continue;
         }
+        if (strcasecmp ("iouring", argv[i]) == 0)
+        {
+            dev->iouring = dasdio_init () == 0;
+            continue;
+        }
+        if (strcasecmp ("noiouring", argv[i]) == 0)
+        {
+            dev->iouring = 0;
+            continue;
+        }
+        if (strcasecmp ("mmap", argv[i]) == 0)
+        {
+            dev->dasdmmap = 1;
+            continue;
+        }
+        if (strcasecmp ("nommap", argv[i]) == 0)
+        {
+            dev->dasdmmap = 0;
+            continue;
+        }
 
         logmsg (_("HHCDA003E parameter %d is invalid: %s\n"),
                 i + 1, argv[i]);
@@ -583,6 +605,33 @@ char            pathname[MAX_PATH];     /* file path in host format  */
     /* Restore the last character of the file name */
     *sfxptr = sfxchar;
 
+    /* Map the image files if requested and not compressed */
+    if (dev->dasdmmap)
+    {
+        dev->dasdmmap = 0;
+        if (!cckd && !dev->batch && !dev->dasdcopy)
+        {
+            for (i = 0; i < dev->ckdnumfd; i++)
+            {
+                dev->dasdmapsz[i] = CKDDASD_DEVHDR_SIZE + (off_t)dev->ckdtrksz
+                     * (dev->ckdhitrk[i] - (i ? dev->ckdhitrk[i-1] : 0));
+                dev->dasdmap[i] = dasdio_map (dev->ckdfd[i],
+                                     dev->dasdmapsz[i], dev->ckdrdonly);
+                if (dev->dasdmap[i] == NULL)
+                {
+                    logmsg (_("HHCDA088W %4.4X mmap error: %s; "
+                            "using normal file i/o\n"),
+                            dev->devnum, strerror(errno));
+                    while (--i >= 0)
+                        dasdio_unmap (dev->dasdmap[i], dev->dasdmapsz[i]);
+                    break;
+                }
+            }
+            if (i == dev->ckdnumfd)
+                dev->dasdmmap = 1;
+        }
+    }
+
     /* Log the device geometry */
     logmsg (_("HHCDA020I %s cyls=%d heads=%d tracks=%d trklen=%d\n"),
             dev->filename, dev->ckdcyls,
@@ -690,6 +739,17 @@ BYTE    unitstat;                       /* Unit Status               */
                 dev->devnum, dev->cachehits, dev->cachemisses,
                 dev->cachewaits);
 
+    /* Unmap the CKD image files */
+    if (dev->dasdmmap)
+    {
+        for (i = 0; i < dev->ckdnumfd; i++)
+        {
+            dasdio_unmap (dev->dasdmap[i], dev->dasdmapsz[i]);
+            dev->dasdmap[i] = NULL;
+        }
+        dev->dasdmmap = 0;
+    }
+
     /* Close all of the CKD image files */
     for (i = 0; i < dev->ckdnumfd; i++)
         if (dev->ckdfd[i] > 2)
@@ -755,6 +815,119 @@ int             sz;                     /* Size so far               */
     return sz;
 }
 
+/*-------------------------------------------------------------------*/
+/* Reference a track image in the mapped image files                 */
+/*-------------------------------------------------------------------*/
+static
+int ckd_read_mapped_track (DEVBLK *dev, int trk, BYTE *unitstat)
+{
+int             cyl;                    /* Cylinder                  */
+int             head;                   /* Head                      */
+int             f;                      /* File index                */
+off_t           offset;                 /* Track offset in file      */
+CKDDASD_TRKHDR *trkhdr;                 /* -> New track header       */
+
+    /* Retry if synchronous I/O and the track image is not in host
+       storage, as referencing it would wait for a host disk read */
+    if (trk > 0 && dev->syncio_active && !dev->ckdtrkof)
+    {
+        for (f = 0; f < dev->ckdnumfd; f++)
+            if (trk < dev->ckdhitrk[f]) break;
+        offset = CKDDASD_DEVHDR_SIZE +
+             (off_t)(trk - (f ? dev->ckdhitrk[f-1] : 0)) * dev->ckdtrksz;
+        if (!dasdio_resident (dev->dasdmap[f], offset, dev->ckdtrksz))
+        {
+            dev->syncio_retry = 1;
+            return -1;
+        }
+    }
+
+    /* Schedule write back of the previous track image if modified */
+    if (dev->bufupd)
+    {
+        logdevtr (dev, _("HHCDA025I read track: updating track %d\n"),
+                  dev->bufcur);
+
+        dev->bufupd = 0;
+
+        for (f = 0; f < dev->ckdnumfd; f++)
+            if (dev->bufcur < dev->ckdhitrk[f]) break;
+        if (dasdio_sync (dev->dasdmap[f], dev->ckdtrkoff + dev->bufupdlo,
+                         dev->bufupdhi - dev->bufupdlo, 0) < 0)
+        {
+            logmsg (_("HHCDA089E error writing trk %d: msync error: %s\n"),
+                    dev->bufcur, strerror(errno));
+            ckd_build_sense (dev, SENSE_EC, 0, 0,
+                            FORMAT_1, MESSAGE_0);
+            *unitstat = CSW_CE | CSW_DE | CSW_UC;
+            dev->bufupdlo = dev->bufupdhi = 0;
+            dev->bufcur = -1;
+            return -1;
+        }
+
+        dev->bufupdlo = dev->bufupdhi = 0;
+    }
+    dev->bufcur = -1;
+
+    /* Return on special case when called by the close handler */
+    if (trk < 0)
+        return 0;
+
+    /* Calculate cylinder and head */
+    cyl = trk / dev->ckdheads;
+    head = trk % dev->ckdheads;
+
+    /* Set the file descriptor */
+    for (f = 0; f < dev->ckdnumfd; f++)
+        if (trk < dev->ckdhitrk[f]) break;
+    dev->fd = dev->ckdfd[f];
+
+    /* Calculate the track offset */
+    dev->ckdtrkoff = CKDDASD_DEVHDR_SIZE +
+         (off_t)(trk - (f ? dev->ckdhitrk[f-1] : 0)) * dev->ckdtrksz;
+
+    logdevtr (dev, _("HHCDA031I read trk %d reading file %d offset %" I64_FMT "d len %d\n"),
+              trk, f+1, (long long)dev->ckdtrkoff, dev->ckdtrksz);
+
+    /* Read the track image now if it is not in host storage, so a
+       host read error is reported here instead of raising SIGBUS */
+    if (dasdio_load (dev->fd, dev->dasdmap[f], dev->ckdtrkoff,
+                     dev->ckdtrksz) < 0)
+    {
+        logmsg (_("HHCDA092E error reading trk %d: read error: %s\n"),
+                trk, strerror(errno));
+        ckd_build_sense (dev, SENSE_EC, 0, 0, FORMAT_1, MESSAGE_0);
+        *unitstat = CSW_CE | CSW_DE | CSW_UC;
+        return -1;
+    }
+
+    dev->buf = dev->dasdmap[f] + dev->ckdtrkoff;
+
+    /* Validate the track header */
+    trkhdr = (CKDDASD_TRKHDR *)dev->buf;
+    if (trkhdr->bin != 0
+      || trkhdr->cyl[0] != (cyl >> 8)
+      || trkhdr->cyl[1] != (cyl & 0xFF)
+      || trkhdr->head[0] != (head >> 8)
+      || trkhdr->head[1] != (head & 0xFF))
+    {
+        logmsg (_("HHCDA035E %4.4X invalid track header for cyl %d head %d "
+                " %2.2x%2.2x%2.2x%2.2x%2.2x\n"), dev->devnum, cyl, head,
+                trkhdr->bin,trkhdr->cyl[0],trkhdr->cyl[1],trkhdr->head[0],trkhdr->head[1]);
+        ckd_build_sense (dev, 0, SENSE1_ITF, 0, 0, 0);
+        *unitstat = CSW_CE | CSW_DE | CSW_UC;
+        return -1;
+    }
+
+    dev->bufcur = trk;
+    dev->bufoff = 0;
+    dev->bufoffhi = dev->ckdtrksz;
+    dev->buflen = ckd_trklen (dev, dev->buf);
+    dev->bufsize = dev->ckdtrksz;
+
+    return 0;
+} /* end function ckd_read_mapped_track */
+
 /*-------------------------------------------------------------------*/
 /* Read a track image                                                */
 /*-------------------------------------------------------------------*/
@@ -767,6 +940,7 @@ int             head;                   /* Head                      */
 off_t           offset;                 /* File offsets              */
 int             i,o,f;                  /* Indexes                   */
 int             active;                 /* 1=Synchronous I/O active  */
+U64             key;                    /* Cache key                 */
 CKDDASD_TRKHDR *trkhdr;                 /* -> New track header       */
 
     logdevtr (dev, _("HHCDA024I read trk %d cur trk %d\n"), trk, dev->bufcur);
@@ -783,6 +957,10 @@ CKDDASD_TRKHDR *trkhdr;                 /* -> New track header       */
     if (trk >= 0 && trk == dev->bufcur)
         return 0;
 
+    /* Reference the track image directly if the files are mapped */
+    if (dev->dasdmmap)
+        return ckd_read_mapped_track (dev, trk, unitstat);
+
     /* Turn off the synchronous I/O bit if trk overflow or trk 0 */
     active = dev->syncio_active;
     if (dev->ckdtrkof || trk <= 0)
@@ -805,7 +983,8 @@ CKDDASD_TRKHDR *trkhdr;                 /* -> New track header       */
 
         /* Seek to the old track image offset */
         offset = (off_t)(dev->ckdtrkoff + dev->bufupdlo);
-        offset = lseek (dev->fd, offset, SEEK_SET);
+        if (!dev->iouring)
+            offset = lseek (dev->fd, offset, SEEK_SET);
         if (offset < 0)
         {
             /* Handle seek error condition */
@@ -814,17 +993,21 @@ CKDDASD_TRKHDR *trkhdr;                 /* -> New track header       */
             ckd_build_sense (dev, SENSE_EC, 0, 0,
                             FORMAT_1, MESSAGE_0);
             *unitstat = CSW_CE | CSW_DE | CSW_UC;
-            cache_lock(CACHE_DEVBUF);
+            cache_lock_entry(CACHE_DEVBUF, dev->cache);
             cache_setflag(CACHE_DEVBUF, dev->cache, ~CKD_CACHE_ACTIVE, 0);
-            cache_unlock(CACHE_DEVBUF);
+            cache_unlock_entry(CACHE_DEVBUF, dev->cache);
             dev->bufupdlo = dev->bufupdhi = 0;
             dev->bufcur = dev->cache = -1;
             return -1;
         }
 
         /* Write the portion of the track image that was modified */
-        rc = write (dev->fd, &dev->buf[dev->bufupdlo],
-                    dev->bufupdhi - dev->bufupdlo);
+        if (dev->iouring)
+            rc = dasdio_pwrite (dev->fd, &dev->buf[dev->bufupdlo],
+                                dev->bufupdhi - dev->bufupdlo, offset);
+        else
+            rc = write (dev->fd, &dev->buf[dev->bufupdlo],
+                        dev->bufupdhi - dev->bufupdlo);
         if (rc < dev->bufupdhi - dev->bufupdlo)
         {
             /* Handle seek error condition */
@@ -833,9 +1016,9 @@ CKDDASD_TRKHDR *trkhdr;                 /* -> New track header       */
             ckd_build_sense (dev, SENSE_EC, 0, 0,
                             FORMAT_1, MESSAGE_0);
             *unitstat = CSW_CE | CSW_DE | CSW_UC;
-            cache_lock(CACHE_DEVBUF);
+            cache_lock_entry(CACHE_DEVBUF, dev->cache);
             cache_setflag(CACHE_DEVBUF, dev->cache, ~CKD_CACHE_ACTIVE, 0);
-            cache_unlock(CACHE_DEVBUF);
+            cache_unlock_entry(CACHE_DEVBUF, dev->cache);
             dev->bufupdlo = dev->bufupdhi = 0;
             dev->bufcur = dev->cache = -1;
             return -1;
@@ -844,31 +1027,33 @@ CKDDASD_TRKHDR *trkhdr;                 /* -> New track header       */
         dev->bufupdlo = dev->bufupdhi = 0;
     }
 
-    cache_lock (CACHE_DEVBUF);
-
     /* Make the previous cache entry inactive */
     if (dev->cache >= 0)
+    {
+        cache_lock_entry (CACHE_DEVBUF, dev->cache);
         cache_setflag(CACHE_DEVBUF, dev->cache, ~CKD_CACHE_ACTIVE, 0);
+        cache_unlock_entry (CACHE_DEVBUF, dev->cache);
+    }
     dev->bufcur = dev->cache = -1;
 
     /* Return on special case when called by the close handler */
     if (trk < 0)
-    {
-        cache_unlock (CACHE_DEVBUF);
         return 0;
-    }
+
+    key = CKD_CACHE_SETKEY(dev->devnum, trk);
+    cache_lock_key (CACHE_DEVBUF, key);
 
 ckd_read_track_retry:
 
     /* Search the cache */
-    i = cache_lookup (CACHE_DEVBUF, CKD_CACHE_SETKEY(dev->devnum, trk), &o);
+    i = cache_lookup (CACHE_DEVBUF, key, &o);
 
     /* Cache hit */
     if (i >= 0)
     {
         cache_setflag(CACHE_DEVBUF, i, ~0, CKD_CACHE_ACTIVE);
         cache_setage(CACHE_DEVBUF, i);
-        cache_unlock(CACHE_DEVBUF);
+        cache_unlock_key (CACHE_DEVBUF, key);
 
         logdevtr (dev, _("HHCDA028I read trk %d cache hit, using cache[%d]\n"),
                   trk, i);
@@ -899,7 +1084,7 @@ ckd_read_track_retry:
     /* Retry if synchronous I/O */
     if (dev->syncio_active)
     {
-        cache_unlock(CACHE_DEVBUF);
+        cache_unlock_key (CACHE_DEVBUF, key);
         dev->syncio_retry = 1;
         return -1;
     }
@@ -910,7 +1095,7 @@ ckd_read_track_retry:
         logdevtr (dev, _("HHCDA029I read trk %d no available cache entry, waiting\n"),
                   trk);
         dev->cachewaits++;
-        cache_wait(CACHE_DEVBUF);
+        cache_wait(CACHE_DEVBUF, key);
         goto ckd_read_track_retry;
     }
 
@@ -921,11 +1106,11 @@ ckd_read_track_retry:
     dev->cachemisses++;
 
     /* Make this cache entry active */
-    cache_setkey (CACHE_DEVBUF, o, CKD_CACHE_SETKEY(dev->devnum, trk));
+    cache_setkey (CACHE_DEVBUF, o, key);
     cache_setflag(CACHE_DEVBUF, o, 0, CKD_CACHE_ACTIVE|DEVBUF_TYPE_CKD);
     cache_setage (CACHE_DEVBUF, o);
     dev->buf = cache_getbuf(CACHE_DEVBUF, o, dev->ckdtrksz);
-    cache_unlock (CACHE_DEVBUF);
+    cache_unlock_key (CACHE_DEVBUF, key);
 
     /* Set the file descriptor */
     for (f = 0; f < dev->ckdnumfd; f++)
@@ -943,7 +1128,8 @@ ckd_read_track_retry:
 
     /* Seek to the track image offset */
     offset = (off_t)dev->ckdtrkoff;
-    offset = lseek (dev->fd, offset, SEEK_SET);
+    if (!dev->iouring)
+        offset = lseek (dev->fd, offset, SEEK_SET);
     if (offset < 0)
     {
         /* Handle seek error condition */
@@ -952,16 +1138,19 @@ ckd_read_track_retry:
         ckd_build_sense (dev, SENSE_EC, 0, 0, FORMAT_1, MESSAGE_0);
         *unitstat = CSW_CE | CSW_DE | CSW_UC;
         dev->bufcur = dev->cache = -1;
-        cache_lock(CACHE_DEVBUF);
+        cache_lock_entry(CACHE_DEVBUF, o);
         cache_release(CACHE_DEVBUF, o, 0);
-        cache_unlock(CACHE_DEVBUF);
+        cache_unlock_entry(CACHE_DEVBUF, o);
         return -1;
     }
 
     /* Read the track image */
     if (dev->dasdcopy == 0)
     {
-        rc = read (dev->fd, dev->buf, dev->ckdtrksz);
+        if (dev->iouring)
+            rc = dasdio_pread (dev->fd, dev->buf, dev->ckdtrksz, offset);
+        else
+            rc = read (dev->fd, dev->buf, dev->ckdtrksz);
         if (rc < dev->ckdtrksz)
         {
             /* Handle read error condition */
@@ -970,9 +1159,9 @@ ckd_read_track_retry:
             ckd_build_sense (dev, SENSE_EC, 0, 0, FORMAT_1, MESSAGE_0);
             *unitstat = CSW_CE | CSW_DE | CSW_UC;
             dev->bufcur = dev->cache = -1;
-            cache_lock(CACHE_DEVBUF);
+            cache_lock_entry(CACHE_DEVBUF, o);
             cache_release(CACHE_DEVBUF, o, 0);
-            cache_unlock(CACHE_DEVBUF);
+            cache_unlock_entry(CACHE_DEVBUF, o);
             return -1;
         }
     }
@@ -1003,9 +1192,9 @@ ckd_read_track_retry:
         ckd_build_sense (dev, 0, SENSE1_ITF, 0, 0, 0);
         *unitstat = CSW_CE | CSW_DE | CSW_UC;
         dev->bufcur = dev->cache = -1;
-        cache_lock(CACHE_DEVBUF);
+        cache_lock_entry(CACHE_DEVBUF, o);
         cache_release(CACHE_DEVBUF, o, 0);
-        cache_unlock(CACHE_DEVBUF);
+        cache_unlock_entry(CACHE_DEVBUF, o);
         return -1;
     }
 
@@ -40,12 +40,13 @@ COMMAND ( "hst",       PANEL,        History,
 #if defined(OPTION_HAO)
 COMMAND ( "hao",       PANEL,        hao_cmd,
   "Hercules Automatic Operator",
-    "Format: \"hao  tgt <tgt> | cmd <cmd> | list <n> | del <n> | clear \".\n"
+    "Format: \"hao  tgt <tgt> | cmd <cmd> | list <n> | del <n> | clear | stats \".\n"
     "  hao tgt <tgt> : define target rule (regex pattern) to react on\n"
     "  hao cmd <cmd> : define command for previously defined rule\n"
     "  hao list <n>  : list all rules/commands or only at index <n>\n"
     "  hao del <n>   : delete the rule at index <n>\n"
-    "  hao clear     : delete all rules (stops automatic operator)\n" )
+    "  hao clear     : delete all rules (stops automatic operator)\n"
+    "  hao stats     : display the match counts of all rules\n" )
 #endif /* defined(OPTION_HAO) */
 
 COMMAND ( "log",       PANEL,        log_cmd,      "direct log output", NULL )
@@ -197,6 +198,14 @@ COMMAND ( "shcmdopt",  CONFIG,        shcmdopt_cmd,"Set diag8 sh option\n", NULL
 
 COMMAND ( "legacysenseid",CONFIG,     lsid_cmd,    "set legacysenseid setting\n", NULL )
 
+COMMAND ( "tlbsize",   CONFIG,        tlbsize_cmd, "set second level TLB size and associativity\n", NULL )
+
+#if defined(OPTION_HUGE_STORAGE)
+COMMAND ( "hugepages", CONFIG,        hugepages_cmd,"set page size backing storage\n", NULL )
+
+COMMAND ( "numa",      CONFIG,        numa_cmd,    "set NUMA placement of storage and CPUs\n", NULL )
+#endif /*defined(OPTION_HUGE_STORAGE)*/
+
 COMMAND ( "ipl",       PANEL,         ipl_cmd,
   "IPL Normal from device xxxx",
     "Format: \"ipl nnnn [parm xxxxxxxxxxxxxx]\"\n"
@@ -310,6 +319,18 @@ COMMAND ( "u",         PANEL,        u_cmd,         "disassemble storage", NULL
 
 COMMAND ( "devtmax",   PANEL+CONFIG, devtmax_cmd,   "display or set max device threads", NULL )
 
+#if !defined(OPTION_FISHIO)
+COMMAND ( "ioq",       PANEL,        ioq_cmd,
+  "display device I/O queue statistics",
+    "Format: \"ioq [reset]\".  Displays each device I/O queue with the number\n"
+    "of I/Os queued on it, how many of those were run by a device thread of\n"
+    "another queue, its idle device threads and the host NUMA node its threads\n"
+    "are bound to (-1 if none).  Then for each device that has queued I/O the\n"
+    "number of I/Os and the average and maximum time spent on the queue before\n"
+    "a device thread started the channel program are displayed.  \"ioq reset\"\n"
+    "clears the device counts.\n" )
+#endif /* !defined(OPTION_FISHIO) */
+
 COMMAND ( "k",         PANEL,        k_cmd,         "display cckd internal trace\n", NULL )
 
 COMMAND ( "attach",    PANEL,        attach_cmd,
@@ -576,6 +597,56 @@ COMMAND ( "syncio",    PANEL,        syncio_cmd,    "display syncio devices stat
 COMMAND ( "icount",    PANEL,        icount_cmd,    "display individual instruction counts", NULL )
 #endif
 
+#if defined(OPTION_INSTRUCTION_PROFILE)
+COMMAND ( "profile",   PANEL+CONFIG, profile_cmd,
+  "start, stop or display the instruction profiler",
+    "Format: \"profile [start [usecs] | stop | reset | show [n] |\n"
+    "                   dump filename [folded | pprof]]\"\n"
+    "\"profile start\" samples the next instruction executed by each running\n"
+    "CPU every 'usecs' microseconds (default 1000), recording its opcode, its\n"
+    "address and the host time taken to execute it.  \"profile stop\" stops\n"
+    "sampling and \"profile reset\" discards the samples.  \"profile show\"\n"
+    "(or \"profile\") displays the 'n' (default 10) most sampled opcodes, with\n"
+    "their average, median and 99th percentile host nanoseconds, and the 'n'\n"
+    "most sampled instruction addresses.  \"profile dump\" writes the address\n"
+    "samples as folded stacks, one 'CPnnnn;mnemonic;address count' line each,\n"
+    "for flamegraph.pl and similar tools, or as a legacy pprof cpu profile.\n"
+    "The samples are also shown by the http server page debug/profile.\n" )
+#endif /*defined(OPTION_INSTRUCTION_PROFILE)*/
+
+#if defined(OPTION_TRACEBIN)
+COMMAND ( "tracebin",  PANEL+CONFIG, tracebin_cmd,
+  "start, stop or display the binary trace",
+    "Format: \"tracebin [on [dir [mb]] | off]\"\n"
+    "\"tracebin on\" creates a memory mapped ring file of 'mb' megabytes\n"
+    "(default 64) for each CPU, trace-cpunnnn.htb, and one for channel\n"
+    "programs, trace-io.htb, in directory 'dir' (default the current\n"
+    "directory).  While the binary trace is on, instructions traced by \"t+\"\n"
+    "and CCWs, CSWs and SCSWs traced by \"t+devn\" are recorded in the ring\n"
+    "files instead of being displayed, and the oldest records are replaced\n"
+    "when a ring is full.  \"tracebin off\" stops the trace and closes the\n"
+    "files, and \"tracebin\" displays the number of records written.  The\n"
+    "files are decoded with the tracedump utility.\n" )
+#endif /*defined(OPTION_TRACEBIN)*/
+
+COMMAND ( "metrics",  PANEL,        metrics_cmd,
+  "display performance metrics",
+    "Format: \"metrics [prometheus | json]\"\n"
+    "Displays the CPU, device, cache and compressed dasd counters in\n"
+    "Prometheus text format (the default) or as a JSON document.  The same\n"
+    "output is available from the http server as cgi-bin/metrics/prometheus\n"
+    "and cgi-bin/metrics/json.\n" )
+
+COMMAND ( "simd",     PANEL+CONFIG, simd_cmd,
+  "display or set the storage instruction kernels",
+    "Format: \"simd [none | sse2 | ssse3 | avx2]\"\n"
+    "Selects the host vector instructions used by XC, NC, OC, TR, TRT and\n"
+    "TRE.  The best level supported by the host processor is selected at\n"
+    "startup; a lower level may be chosen to compare their performance.\n"
+    "sse2 vectorizes XC, NC and OC, ssse3 adds TRT, and avx2 uses 32 byte\n"
+    "vectors for all of them and also TR and TRE.  With no operand the\n"
+    "current level is displayed.\n" )
+
 #ifdef OPTION_MIPS_COUNTING
 COMMAND ( "maxrates",  PANEL,        maxrates_cmd,
   "display maximum observed MIPS/SIOS rate for the\n"
@@ -628,7 +699,24 @@ COMMAND ( "ecpsvm",    PANEL,        evm_cmd,
 
 COMMAND ( "aea",       PANEL,        aea_cmd,       "Display AEA tables", NULL )
 COMMAND ( "aia",       PANEL,        aia_cmd,       "Display AIA fields", NULL )
-COMMAND ( "tlb",       PANEL,        tlb_cmd,       "Display TLB tables\n", NULL )
+COMMAND ( "tlb",       PANEL,        tlb_cmd,       "Display TLB tables",
+  "Format: \"tlb [stats]\".  Displays the TLB entries of the target cpu,\n"
+  "or with the 'stats' option only the number of translations which\n"
+  "were not found in the TLB, and the number found in the second level\n"
+  "TLB if one is configured.\n" )
+
+#if defined(OPTION_BLOCK_CACHE)
+COMMAND ( "blkcache",  PANEL+CONFIG, blkcache_cmd,
+  "enable/disable/display basic block cache",
+    "Format: \"blkcache [on | off]\".  When enabled, each CPU keeps a cache\n"
+    "of the instruction sequences it has recently executed, with the\n"
+    "instruction functions resolved and the operand fields decoded, so\n"
+    "that hot loops are not decoded again on every pass.  Blocks are\n"
+    "discarded when the storage they were built from is stored into or\n"
+    "when the TLB is purged.  Entering the command with no arguments\n"
+    "displays the current setting and, for each online CPU, the number\n"
+    "of blocks found in the cache, built, and not cached.\n" )
+#endif /*defined(OPTION_BLOCK_CACHE)*/
 
 #if defined(SIE_DEBUG_PERFMON)
 COMMAND ( "spm",       PANEL,        spm_cmd,       "SIE performance monitor\n", NULL )
@@ -638,10 +726,35 @@ COMMAND ( "count",     PANEL,        count_cmd,     "Display/clear overall instr
 #endif
 COMMAND ( "sizeof",    PANEL,        sizeof_cmd,    "Display size of structures\n", NULL )
 
-COMMAND ( "suspend",   PANEL,        suspend_cmd,   "Suspend hercules", NULL )
+COMMAND ( "suspend",   PANEL,        suspend_cmd,   "Suspend hercules",
+    "Format: \"suspend [filename] [incremental] [continue] [raw]\".  Stops\n"
+    "all CPUs and writes the state of the system to 'filename', then\n"
+    "terminates hercules.  Main storage is compressed in 1M chunks by one\n"
+    "thread per host processor, and all-zero pages are not written.\n"
+    "'raw' writes the pages uncompressed; resume then maps the file and\n"
+    "reads each page when it is first used.\n"
+    "'continue' restarts the CPUs instead of terminating hercules, and\n"
+    "starts tracking changed pages.  'incremental' then writes only the\n"
+    "pages changed since the previous suspend, which must have been done\n"
+    "with 'continue'.  Resuming an incremental file also reads the files\n"
+    "it was taken after, which must not be moved or changed.\n" )
 
 COMMAND ( "resume",    PANEL,        resume_cmd,    "Resume hercules\n", NULL )
 
+#if defined(OPTION_SR_MIGRATE)
+COMMAND ( "migrate",   PANEL,        migrate_cmd,   "Move the running system to another hercules",
+    "Format: \"migrate host:port [raw]\" or \"migrate listen port\".\n"
+    "'migrate listen' waits for one connection on 'port' and resumes the\n"
+    "system it receives; its configuration must match the sender's and\n"
+    "all its CPUs must be stopped.  'migrate host:port' sends main storage\n"
+    "to that hercules while the CPUs keep running, then sends the pages\n"
+    "changed meanwhile, again and again until few pages change.  Only then\n"
+    "are the CPUs stopped, for the last changed pages and the CPU and\n"
+    "device state.  When the receiver has resumed the system, this hercules\n"
+    "terminates; otherwise the CPUs are restarted.  'raw' sends the pages\n"
+    "uncompressed.\n" )
+#endif /*defined(OPTION_SR_MIGRATE)*/
+
 COMMAND ( "herclogo",  PANEL,        herclogo_cmd,
   "Read a new hercules logo file\n",
     "Format: \"herclogo [<filename>]\". Load a new logo file for 3270 terminal sessions\n"
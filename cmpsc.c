@@ -17,6 +17,7 @@
 /*   Expand symbol translation caching.                                       */
 /*   Compression dead end determination and elimination.                      */
 /*   Proactive dead end determination and elimination.                        */
+/*   Dictionary caching across instructions, validated against storage.       */
 /*                                                                            */
 /*                              (c) Copyright Bernard van der Helm, 2000-2015 */
 /*                              Noordwijkerhout, The Netherlands.             */
@@ -176,22 +177,45 @@
 /* Constants                                                                  */
 /*----------------------------------------------------------------------------*/
 #define MINPROC_SIZE         32768     /* Minumum processing size             */
+#define CMPSC_ECSIZE         0x40000   /* Expanded index symbol cache size    */
 
 /*----------------------------------------------------------------------------*/
 /* Typedefs and prototypes                                                    */
 /*----------------------------------------------------------------------------*/
 #ifndef NO_2ND_COMPILE
+struct dc                              /* Cached dictionary                   */
+{
+  U64 copied;                          /* Blocks with a copy                  */
+  BYTE copy[64][0x800];                /* Copies of the dictionary blocks     */
+  U64 dep[8192];                       /* Blocks an is cache entry relies on  */
+  U64 dictor;                          /* Dictionary origin                   */
+  U32 gr0;                             /* GR0 cdss, f1 and e bits             */
+  U64 used;                            /* Last use, for replacement           */
+  union
+  {
+    BYTE deadadm[8192][0x100 / 8];     /* Dead end administration             */
+    struct
+    {
+      BYTE ec[CMPSC_ECSIZE + 8];       /* Expanded index symbol cache         */
+      int eci[8192];                   /* Index within cache for is           */
+      int ecl[8192];                   /* Size of expanded is                 */
+      int ecwm;                        /* Water mark                          */
+    } x;
+  } u;
+};
+
 struct cc                              /* Compress context                    */
 {
   BYTE *cce;                           /* Character entry under investigation */
   int cr;                              /* Characters read to check #261       */
+  struct dc *dc;                       /* Cached dictionary or NULL           */
   unsigned dctsz;                      /* Dictionary size                     */
-  BYTE deadadm[8192][0x100 / 8];       /* Dead end administration             */
   BYTE deadend;                        /* Dead end indicator                  */
+  U64 dep;                             /* Blocks used by the current search   */
   BYTE *dest;                          /* Destination MADDR address           */
-  BYTE *dict[32];                      /* Dictionary MADDR addresses          */
+  BYTE *dict[64];                      /* Dictionary MADDR addresses, 32-63   */
+                                       /* for the expansion dictionary        */
   GREG dictor;                         /* Dictionary origin                   */
-  BYTE *edict[32];                     /* Expansion dictionary MADDR addrs    */
   int f1;                              /* Indication format-1 sibling descr   */
   REGS *iregs;                         /* Intermediate registers              */
   U16 is[8];                           /* Cache for 8 index symbols           */
@@ -204,17 +228,17 @@ struct cc                              /* Compress context                    */
   BYTE *src;                           /* Source MADDR page address           */
   unsigned srclen;                     /* Source length left in page          */
   BYTE st;                             /* Symbol translation                  */
+  U64 valid;                           /* Blocks validated by this call       */
 };
 
 struct ec                              /* Expand context                      */
 {
+  struct dc *dc;                       /* Cached dictionary or NULL           */
+  unsigned dctsz;                      /* Dictionary size                     */
+  U64 dep;                             /* Blocks used by the current is       */
   BYTE *dest;                          /* Destination MADDR page address      */
   BYTE *dict[32];                      /* Dictionary MADDR addresses          */
   GREG dictor;                         /* Dictionary origin                   */
-  BYTE ec[8192 * 7];                   /* Expanded index symbol cache         */
-  int eci[8192];                       /* Index within cache for is           */
-  int ecl[8192];                       /* Size of expanded is                 */
-  int ecwm;                            /* Water mark                          */
   REGS *iregs;                         /* Intermediate registers              */
   BYTE oc[8 * 260];                    /* Output cache                        */
   unsigned ocl;                        /* Output cache length                 */
@@ -223,6 +247,7 @@ struct ec                              /* Expand context                      */
   REGS *regs;                          /* Registers                           */
   unsigned smbsz;                      /* Symbol size                         */
   BYTE *src;                           /* Source MADDR page address           */
+  U64 valid;                           /* Blocks validated by this call       */
 
 #ifdef OPTION_CMPSC_DEBUG
   unsigned dbgac;                      /* Alphabet characters                 */
@@ -237,9 +262,12 @@ struct ec                              /* Expand context                      */
 
 static void  ARCH_DEP(cmpsc_compress)(int r1, int r2, REGS *regs, REGS *iregs);
 static int   ARCH_DEP(cmpsc_compress_single_is)(struct cc *cc);
+static void  cmpsc_dc_flush(struct dc *dc);
+static struct dc *cmpsc_dc_get(REGS *regs, U64 dictor, U32 gr0);
 static void  ARCH_DEP(cmpsc_expand)(int r1, int r2, REGS *regs, REGS *iregs);
 static void  ARCH_DEP(cmpsc_expand_is)(struct ec *ec, U16 is);
 static int   ARCH_DEP(cmpsc_expand_single_is)(struct ec *ec);
+static BYTE *ARCH_DEP(cmpsc_fetch_block)(struct dc *dc, BYTE **dict, U64 *valid, unsigned b, VADR addr, int r2, REGS *regs);
 static BYTE *ARCH_DEP(cmpsc_fetch_cce)(struct cc *cc, unsigned index);
 static int   ARCH_DEP(cmpsc_fetch_ch)(struct cc *cc);
 static int   ARCH_DEP(cmpsc_fetch_is)(struct ec *ec, U16 *is);
@@ -254,6 +282,7 @@ static int   ARCH_DEP(cmpsc_search_sd)(struct cc *cc, U16 *is);
 static int   ARCH_DEP(cmpsc_store_is)(struct cc *cc, U16 is);
 static void  ARCH_DEP(cmpsc_store_iss)(struct cc *cc);
 static int   ARCH_DEP(cmpsc_test_ec)(struct cc *cc, BYTE *cce);
+static void  ARCH_DEP(cmpsc_validate)(struct dc *dc, BYTE **dict, U64 *valid, U64 dep, GREG dictor, unsigned dctsz, int r2, REGS *regs);
 static int   ARCH_DEP(cmpsc_vstore)(struct ec *ec, BYTE *buf, unsigned len);
 
 /*----------------------------------------------------------------------------*/
@@ -325,6 +354,145 @@ DEF_INST(compression_call)
     ARCH_DEP(cmpsc_compress)(r1, r2, regs, &iregs);
 }
 
+/*============================================================================*/
+/* Dictionary cache                                                           */
+/*============================================================================*/
+
+#ifndef NO_2ND_COMPILE
+/*----------------------------------------------------------------------------*/
+/* cmpsc_dc_flush (dictionary cache)                                          */
+/*----------------------------------------------------------------------------*/
+static void cmpsc_dc_flush(struct dc *dc)
+{
+  int i;                               /* Index                               */
+
+  /* Forget all dead ends or expanded index symbols, keep the block copies */
+  if(dc->gr0 & 0x00000100)
+  {
+    /* Prefill expanded index symbol cache with alphabet entries */
+    memset(dc->u.x.ecl, 0, sizeof(dc->u.x.ecl));
+    for(i = 0; i < 256; i++)
+    {
+      dc->u.x.ec[i] = i;
+      dc->u.x.eci[i] = i;
+      dc->u.x.ecl[i] = 1;
+      dc->dep[i] = 0;
+    }
+    dc->u.x.ecwm = 256;                /* Set watermark after alphabet part   */
+  }
+  else
+    memset(dc->u.deadadm, 0, sizeof(dc->u.deadadm));
+}
+
+/*----------------------------------------------------------------------------*/
+/* cmpsc_dc_get (dictionary cache)                                            */
+/*----------------------------------------------------------------------------*/
+static struct dc *cmpsc_dc_get(REGS *regs, U64 dictor, U32 gr0)
+{
+  CMPSCCACHE *cache;                   /* Dictionary cache of this CPU        */
+  struct dc *dc;                       /* Cached dictionary                   */
+  int i;                               /* Index                               */
+  int lru;                             /* Least recently used or free slot    */
+
+  /* Allocate the cache on first use, without it we just don't cache */
+  cache = regs->cmpsc;
+  if(unlikely(!cache))
+  {
+    cache = calloc(1, sizeof(CMPSCCACHE));
+    if(unlikely(!cache))
+      return(NULL);
+    regs->cmpsc = cache;
+  }
+  cache->uses++;
+
+  /* Look for the dictionary, slots are used in order and never freed */
+  lru = 0;
+  for(i = 0; i < CMPSC_DICTS; i++)
+  {
+    dc = cache->dict[i];
+    if(!dc)
+    {
+      lru = i;
+      break;
+    }
+    if(likely(dc->dictor == dictor && dc->gr0 == gr0))
+    {
+      dc->used = cache->uses;
+      return(dc);
+    }
+    if(dc->used < ((struct dc *) cache->dict[lru])->used)
+      lru = i;
+  }
+
+  /* Not found, (re)use the slot */
+  dc = cache->dict[lru];
+  if(!dc)
+  {
+    dc = malloc(sizeof(struct dc));
+    if(unlikely(!dc))
+      return(NULL);
+    cache->dict[lru] = dc;
+  }
+  dc->copied = 0;
+  dc->dictor = dictor;
+  dc->gr0 = gr0;
+  dc->used = cache->uses;
+  cmpsc_dc_flush(dc);
+  return(dc);
+}
+#endif /* #ifndef NO_2ND_COMPILE */
+
+/*----------------------------------------------------------------------------*/
+/* cmpsc_fetch_block (dictionary block)                                       */
+/*----------------------------------------------------------------------------*/
+/* Every 2K dictionary block is compared once per instruction with the copy   */
+/* taken when it was first used. A changed block invalidates all dead ends    */
+/* or expanded index symbols derived from the dictionary.                     */
+/*----------------------------------------------------------------------------*/
+static BYTE *ARCH_DEP(cmpsc_fetch_block)(struct dc *dc, BYTE **dict, U64 *valid, unsigned b, VADR addr, int r2, REGS *regs)
+{
+  dict[b] = MADDR(addr & ADDRESS_MAXWRAP(regs), r2, regs, ACCTYPE_READ, regs->psw.pkey);
+  *valid |= (U64) 1 << b;
+  if(dc)
+  {
+    if(likely(dc->copied & ((U64) 1 << b)))
+    {
+      if(likely(!memcmp(dc->copy[b], dict[b], 0x800)))
+        return(dict[b]);
+
+#ifdef OPTION_CMPSC_DEBUG
+      logmsg("dict     : block %d changed, cache flushed\n", b);
+#endif /* #ifdef OPTION_CMPSC_DEBUG */
+
+      cmpsc_dc_flush(dc);
+    }
+    memcpy(dc->copy[b], dict[b], 0x800);
+    dc->copied |= (U64) 1 << b;
+  }
+  return(dict[b]);
+}
+
+/*----------------------------------------------------------------------------*/
+/* cmpsc_validate (dictionary blocks)                                         */
+/*----------------------------------------------------------------------------*/
+static void ARCH_DEP(cmpsc_validate)(struct dc *dc, BYTE **dict, U64 *valid, U64 dep, GREG dictor, unsigned dctsz, int r2, REGS *regs)
+{
+  unsigned b;                          /* Block number                        */
+
+  /* Fetch the blocks not yet compared during this instruction */
+  dep &= ~*valid;
+  for(b = 0; dep; b++, dep >>= 1)
+  {
+    if(dep & 1)
+    {
+      if(b < 32)
+        ARCH_DEP(cmpsc_fetch_block)(dc, dict, valid, b, dictor + b * 0x800, r2, regs);
+      else
+        ARCH_DEP(cmpsc_fetch_block)(dc, dict, valid, b, dictor + dctsz + (b - 32) * 0x800, r2, regs);
+    }
+  }
+}
+
 /*============================================================================*/
 /* Compress                                                                   */
 /*============================================================================*/
@@ -440,6 +608,26 @@ DEF_INST(compression_call)
 #define BIT_get(array, is, ch) ((array)[(is)][(ch) / 8] & (0x80 >> ((ch) % 8)))
 #define BIT_set(array, is, ch) ((array)[(is)][(ch) / 8] |= (0x80 >> ((ch) % 8)))
 
+/*----------------------------------------------------------------------------*/
+/* Cached dead end, only trusted when the blocks it relies on are unchanged   */
+/*----------------------------------------------------------------------------*/
+#define DEADEND(cc, is, ch) \
+  ((cc)->dc && BIT_get((cc)->dc->u.deadadm, (is), (ch)) && \
+   (likely(!((cc)->dc->dep[(is)] & ~(cc)->valid)) || \
+    (ARCH_DEP(cmpsc_validate)((cc)->dc, (cc)->dict, &(cc)->valid, (cc)->dc->dep[(is)], (cc)->dictor, (cc)->dctsz, (cc)->r2, (cc)->regs), \
+     BIT_get((cc)->dc->u.deadadm, (is), (ch)))))
+
+/*----------------------------------------------------------------------------*/
+/* Registrate dead ends of the current search                                 */
+/*----------------------------------------------------------------------------*/
+#define DEADEND_set(cc, is) \
+{ \
+  int _j; \
+  for(_j = 0; _j < 0x100 / 8; _j++) \
+    (cc)->dc->u.deadadm[(is)][_j] = ~(cc)->searchadm[0][_j]; \
+  (cc)->dc->dep[(is)] = (cc)->dep; \
+}
+
 /*============================================================================*/
 
 /*----------------------------------------------------------------------------*/
@@ -455,11 +643,10 @@ static void ARCH_DEP(cmpsc_compress)(int r1, int r2, REGS *regs, REGS *iregs)
 
   /* Initialize compression context */
   cc.dctsz = GR0_dctsz(regs);
-  memset(cc.deadadm, 0, sizeof(cc.deadadm));
   cc.dest = NULL;
   memset(cc.dict, 0, sizeof(cc.dict));
-  memset(cc.edict, 0, sizeof(cc.edict));
   cc.dictor = GR1_dictor(iregs);
+  cc.dc = cmpsc_dc_get(regs, cc.dictor, regs->GR_L(0) & 0x0000F300);
   cc.f1 = GR0_f1(regs);
   cc.iregs = iregs;
   cc.r1 = r1;
@@ -469,6 +656,7 @@ static void ARCH_DEP(cmpsc_compress)(int r1, int r2, REGS *regs, REGS *iregs)
   cc.src = NULL;
   cc.srclen = 0;
   cc.st = GR0_st(regs) ? 1 : 0;
+  cc.valid = 0;
 
   /* Initialize values */
   srclen = GR_A(cc.r2 + 1, cc.iregs);
@@ -507,14 +695,14 @@ static void ARCH_DEP(cmpsc_compress)(int r1, int r2, REGS *regs, REGS *iregs)
       cc.cr = 1;
 
       /* Check for alphabet entry ch dead end combination */
-      if(unlikely(!(cc.src && BIT_get(cc.deadadm, is, *cc.src))))
+      if(unlikely(!(cc.src && DEADEND(&cc, is, *cc.src))))
       {
         /* Get the alphabet entry and try to find a child */
         cc.cce = ARCH_DEP(cmpsc_fetch_cce)(&cc, is);
         while(ARCH_DEP(cmpsc_search_cce)(&cc, &is))
         {
           /* Check for other dead end combination */
-          if(unlikely(cc.src && BIT_get(cc.deadadm, is, *cc.src)))
+          if(unlikely(cc.src && DEADEND(&cc, is, *cc.src)))
           {
 
 #ifdef OPTION_CMPSC_DEBUG
@@ -526,7 +714,7 @@ static void ARCH_DEP(cmpsc_compress)(int r1, int r2, REGS *regs, REGS *iregs)
         }
 
         /* Registrate possible found dead ends */
-        if(unlikely(cc.deadend && cc.src))
+        if(unlikely(cc.deadend && cc.src && cc.dc))
         {
 
 #ifdef OPTION_CMPSC_DEBUG
@@ -544,8 +732,7 @@ static void ARCH_DEP(cmpsc_compress)(int r1, int r2, REGS *regs, REGS *iregs)
 #endif /* #ifdef OPTION_CMPSC_DEBUG */
 
           /* Registrate all discovered dead ends */ 
-          for(j = 0; j < 0x100 / 8; j++)
-            cc.deadadm[is][j] = ~cc.searchadm[0][j];
+          DEADEND_set(&cc, is);
         }
       }
 
@@ -590,7 +777,11 @@ static void ARCH_DEP(cmpsc_compress)(int r1, int r2, REGS *regs, REGS *iregs)
 /*----------------------------------------------------------------------------*/
 static int ARCH_DEP(cmpsc_compress_single_is)(struct cc *cc)
 {
+
+#ifdef OPTION_CMPSC_DEBUG
   int i;                               /* Index                               */
+#endif /* #ifdef OPTION_CMPSC_DEBUG */
+
   U16 is;                              /* index symbol                        */
 
   /* Get the next character, return -1 on end of source */
@@ -607,14 +798,14 @@ static int ARCH_DEP(cmpsc_compress_single_is)(struct cc *cc)
   cc->cr = 1;
 
   /* Search for child when no src and no dead end combination */
-  if(unlikely(!(cc->src && BIT_get(cc->deadadm, is, *cc->src))))
+  if(unlikely(!(cc->src && DEADEND(cc, is, *cc->src))))
   {
     /* Get the alphabet entry and try to find a child */
     cc->cce = ARCH_DEP(cmpsc_fetch_cce)(cc, is);
     while(ARCH_DEP(cmpsc_search_cce)(cc, &is))
     {
       /* Check for (found cce entry + ch) dead end combination */
-      if(unlikely(cc->src && BIT_get(cc->deadadm, is, *cc->src)))
+      if(unlikely(cc->src && DEADEND(cc, is, *cc->src)))
       {
 
 #ifdef OPTION_CMPSC_DEBUG
@@ -626,7 +817,7 @@ static int ARCH_DEP(cmpsc_compress_single_is)(struct cc *cc)
     }
 
     /* Registrate possible found dead ends */
-    if(unlikely(cc->deadend && cc->src))
+    if(unlikely(cc->deadend && cc->src && cc->dc))
     {
 
 #ifdef OPTION_CMPSC_DEBUG
@@ -644,8 +835,7 @@ static int ARCH_DEP(cmpsc_compress_single_is)(struct cc *cc)
 #endif /* #ifdef OPTION_CMPSC_DEBUG */
 
       /* Registrate all discovered dead ends */ 
-      for(i = 0; i < 0x100 / 8; i++)
-        cc->deadadm[is][i] = ~cc->searchadm[0][i];
+      DEADEND_set(cc, is);
     }
   }
 
@@ -673,7 +863,7 @@ static BYTE *ARCH_DEP(cmpsc_fetch_cce)(struct cc *cc, unsigned index)
 
   index *= 8;
   if(unlikely(!cc->dict[index / 0x800]))
-    cc->dict[index / 0x800] = MADDR((cc->dictor + (index / 0x800) * 0x800) & ADDRESS_MAXWRAP(cc->regs), cc->r2, cc->regs, ACCTYPE_READ, cc->regs->psw.pkey);
+    ARCH_DEP(cmpsc_fetch_block)(cc->dc, cc->dict, &cc->valid, index / 0x800, cc->dictor + (index / 0x800) * 0x800, cc->r2, cc->regs);
   cce = &cc->dict[index / 0x800][index % 0x800];
   ITIMER_SYNC((cc->dictor + index) & ADDRESS_MAXWRAP(cc->regs), 8 - 1, cc->regs);
 
@@ -888,8 +1078,9 @@ static int ARCH_DEP(cmpsc_search_cce)(struct cc *cc, U16 *is)
   int i;                               /* Child character index               */
   int ind_search_siblings;             /* Indicator for searching siblings    */
 
-  /* Initialize values */
+  /* Initialize values, a dead end relies on the block of the parent */
   ccs = CCE_ccs(cc->cce);
+  cc->dep = (U64) 1 << (*is >> 8);
 
   /* Get the next character when there are children */
   if(likely(ccs))
@@ -975,7 +1166,11 @@ static int ARCH_DEP(cmpsc_search_cce)(struct cc *cc, U16 *is)
       logmsg("dead end : %04X permanent dead end discovered\n", *is);
 #endif /* #ifdef OPTION_CMPSC_DEBUG */
 
-      memset(&cc->deadadm[*is], 0xff, 0x100 / 8);
+      if(cc->dc)
+      {
+        memset(cc->dc->u.deadadm[*is], 0xff, 0x100 / 8);
+        cc->dc->dep[*is] = cc->dep;
+      }
     }
     cc->deadend = 0;
   }
@@ -1009,16 +1204,18 @@ static int ARCH_DEP(cmpsc_search_sd)(struct cc *cc, U16 *is)
     /* Get the sibling descriptor */
     index = (CCE_cptr(cc->cce) + sd_ptr) * 8;
     if(unlikely(!cc->dict[index / 0x800]))
-      cc->dict[index / 0x800] = MADDR((cc->dictor + (index / 0x800) * 0x800) & ADDRESS_MAXWRAP(cc->regs), cc->r2, cc->regs, ACCTYPE_READ, cc->regs->psw.pkey);
+      ARCH_DEP(cmpsc_fetch_block)(cc->dc, cc->dict, &cc->valid, index / 0x800, cc->dictor + (index / 0x800) * 0x800, cc->r2, cc->regs);
     sd1 = &cc->dict[index / 0x800][index % 0x800];
+    cc->dep |= (U64) 1 << (index / 0x800);
     ITIMER_SYNC((cc->dictor + index) & ADDRESS_MAXWRAP(cc->regs), 8 - 1, cc->regs);
 
     /* If format-1, get second half from the expansion dictionary */
     if(cc->f1)
     {
-      if(unlikely(!cc->edict[index / 0x800]))
-        cc->edict[index / 0x800] = MADDR((cc->dictor + cc->dctsz + (index / 0x800) * 0x800) & ADDRESS_MAXWRAP(cc->regs), cc->r2, cc->regs, ACCTYPE_READ, cc->regs->psw.pkey);
-      sd2 = &cc->edict[index / 0x800][index % 0x800];
+      if(unlikely(!cc->dict[32 + index / 0x800]))
+        ARCH_DEP(cmpsc_fetch_block)(cc->dc, cc->dict, &cc->valid, 32 + index / 0x800, cc->dictor + cc->dctsz + (index / 0x800) * 0x800, cc->r2, cc->regs);
+      sd2 = &cc->dict[32 + index / 0x800][index % 0x800];
+      cc->dep |= (U64) 1 << (32 + index / 0x800);
       ITIMER_SYNC((cc->dictor + cc->dctsz + index) & ADDRESS_MAXWRAP(cc->regs), 8 - 1, cc->regs);
 
 #ifdef OPTION_CMPSC_DEBUG
@@ -1409,6 +1606,15 @@ static int ARCH_DEP(cmpsc_test_ec)(struct cc *cc, BYTE *cce)
 #define ECE_pptr(ece)        ((((ece)[0] & 0x1f) << 8) | (ece)[1])
 #define ECE_psl(ece)         ((ece)[0] >> 5)
 
+/*----------------------------------------------------------------------------*/
+/* Cached expanded index symbol, only trusted when its blocks are unchanged   */
+/*----------------------------------------------------------------------------*/
+#define EXPANDED(ec, is) \
+  ((ec)->dc && (ec)->dc->u.x.ecl[(is)] && \
+   (likely(!((ec)->dc->dep[(is)] & ~(ec)->valid)) || \
+    (ARCH_DEP(cmpsc_validate)((ec)->dc, (ec)->dict, &(ec)->valid, (ec)->dc->dep[(is)], (ec)->dictor, (ec)->dctsz, (ec)->r2, (ec)->regs), \
+     (ec)->dc->u.x.ecl[(is)])))
+
 /*----------------------------------------------------------------------------*/
 /* cmpsc_expand                                                               */
 /*----------------------------------------------------------------------------*/
@@ -1418,24 +1624,19 @@ static void ARCH_DEP(cmpsc_expand)(int r1, int r2, REGS *regs, REGS *iregs)
   struct ec ec;                        /* Expand cache                        */
   int i;                               /* Index                               */
   U16 iss[8] = {0};                    /* Index symbols                       */
+  int len;                             /* Length of cached expanded is        */
 
   /* Initialize values */
   destlen = GR_A(r1 + 1, iregs);
 
   /* Initialize expansion context */
+  ec.dctsz = GR0_dctsz(regs);
   ec.dest = NULL;
   ec.dictor = GR1_dictor(iregs);
   memset(ec.dict, 0, sizeof(ec.dict));
 
-  /* Initialize expanded index symbol cache and prefill with alphabet entries */
-  memset(ec.ecl, 0, sizeof(ec.ecl));
-  for(i = 0; i < 256; i++)             /* Alphabet entries                    */
-  {
-    ec.ec[i] = i;
-    ec.eci[i] = i;
-    ec.ecl[i] = 1;
-  }
-  ec.ecwm = 256;                       /* Set watermark after alphabet part   */
+  /* Get the expanded index symbol cache, prefilled with alphabet entries */
+  ec.dc = cmpsc_dc_get(regs, ec.dictor, regs->GR_L(0) & 0x0000F300);
 
   ec.iregs = iregs;
   ec.r1 = r1;
@@ -1443,6 +1644,7 @@ static void ARCH_DEP(cmpsc_expand)(int r1, int r2, REGS *regs, REGS *iregs)
   ec.regs = regs;
   ec.smbsz = GR0_smbsz(regs);
   ec.src = NULL;
+  ec.valid = 0;
 
 #ifdef OPTION_CMPSC_DEBUG
   ec.dbgac = 0;
@@ -1474,12 +1676,17 @@ static void ARCH_DEP(cmpsc_expand)(int r1, int r2, REGS *regs, REGS *iregs)
       ec.dbgiss++;
 #endif /* #ifdef OPTION_CMPSC_DEBUG */
 
-      if(unlikely(!ec.ecl[iss[i]]))
+      if(unlikely(!EXPANDED(&ec, iss[i])))
         ARCH_DEP(cmpsc_expand_is)(&ec, iss[i]);
       else
       {
-        memcpy(&ec.oc[ec.ocl], &ec.ec[ec.eci[iss[i]]], ec.ecl[iss[i]]);
-        ec.ocl += ec.ecl[iss[i]];
+        /* Most expanded index symbols are short, copy them in one go */
+        len = ec.dc->u.x.ecl[iss[i]];
+        if(likely(len <= 8))
+          memcpy(&ec.oc[ec.ocl], &ec.dc->u.x.ec[ec.dc->u.x.eci[iss[i]]], 8);
+        else
+          memcpy(&ec.oc[ec.ocl], &ec.dc->u.x.ec[ec.dc->u.x.eci[iss[i]]], len);
+        ec.ocl += len;
 
 #ifdef OPTION_CMPSC_DEBUG
         if(iss[i] < 0x100)
@@ -1533,14 +1740,22 @@ static void ARCH_DEP(cmpsc_expand_is)(struct ec *ec, U16 is)
   U16 index;                           /* Index within dictionary             */
   int psl;                             /* Partial symbol length               */
 
+  /* Alphabet entries are conform POP never referenced, without cache too */
+  if(unlikely(is < 0x100))
+  {
+    ec->oc[ec->ocl++] = (BYTE) is;
+    return;
+  }
+
   /* Initialize values */
   cw = 0;
 
   /* Get expansion character entry */
   index = is * 8;
   if(unlikely(!ec->dict[index / 0x800]))
-    ec->dict[index / 0x800] = MADDR((ec->dictor + (index / 0x800) * 0x800) & ADDRESS_MAXWRAP(ec->regs), ec->r2, ec->regs, ACCTYPE_READ, ec->regs->psw.pkey);
+    ARCH_DEP(cmpsc_fetch_block)(ec->dc, ec->dict, &ec->valid, index / 0x800, ec->dictor + (index / 0x800) * 0x800, ec->r2, ec->regs);
   ece = &ec->dict[index / 0x800][index % 0x800];
+  ec->dep = (U64) 1 << (index / 0x800);
   ITIMER_SYNC((ec->dictor + index) & ADDRESS_MAXWRAP(ec->regs), 8 - 1, ec->regs);
 
 #ifdef OPTION_CMPSC_DEBUG
@@ -1572,8 +1787,9 @@ static void ARCH_DEP(cmpsc_expand_is)(struct ec *ec, U16 is)
     /* Get preceding entry */
     index = ECE_pptr(ece) * 8;
     if(unlikely(!ec->dict[index / 0x800]))
-      ec->dict[index / 0x800] = MADDR((ec->dictor + (index / 0x800) * 0x800) & ADDRESS_MAXWRAP(ec->regs), ec->r2, ec->regs, ACCTYPE_READ, ec->regs->psw.pkey);
+      ARCH_DEP(cmpsc_fetch_block)(ec->dc, ec->dict, &ec->valid, index / 0x800, ec->dictor + (index / 0x800) * 0x800, ec->r2, ec->regs);
     ece = &ec->dict[index / 0x800][index % 0x800];
+    ec->dep |= (U64) 1 << (index / 0x800);
     ITIMER_SYNC((ec->dictor + index) & ADDRESS_MAXWRAP(ec->regs), 8 - 1, ec->regs);
 
 #ifdef OPTION_CMPSC_DEBUG
@@ -1603,11 +1819,15 @@ static void ARCH_DEP(cmpsc_expand_is)(struct ec *ec, U16 is)
   /* Process extension characters in unpreceded entry */
   memcpy(&ec->oc[ec->ocl], &ece[1], csl);
 
-  /* Place within cache */
-  memcpy(&ec->ec[ec->ecwm], &ec->oc[ec->ocl], cw);
-  ec->eci[is] = ec->ecwm;
-  ec->ecl[is] = cw;
-  ec->ecwm += cw;
+  /* Place within cache, as long as there is room */
+  if(likely(ec->dc && ec->dc->u.x.ecwm + cw <= CMPSC_ECSIZE))
+  {
+    memcpy(&ec->dc->u.x.ec[ec->dc->u.x.ecwm], &ec->oc[ec->ocl], cw);
+    ec->dc->u.x.eci[is] = ec->dc->u.x.ecwm;
+    ec->dc->u.x.ecl[is] = cw;
+    ec->dc->u.x.ecwm += cw;
+    ec->dc->dep[is] = ec->dep;
+  }
 
   /* Commit in output buffer */
   ec->ocl += cw;
@@ -1622,7 +1842,7 @@ static int ARCH_DEP(cmpsc_expand_single_is)(struct ec *ec)
 
   if(unlikely(ARCH_DEP(cmpsc_fetch_is)(ec, &is)))
     return(-1);
-  if(!ec->ecl[is])
+  if(!EXPANDED(ec, is))
   {
     ec->ocl = 0;                       /* Initialize output cache             */
     ARCH_DEP(cmpsc_expand_is)(ec, is);
@@ -1631,7 +1851,7 @@ static int ARCH_DEP(cmpsc_expand_single_is)(struct ec *ec)
   }
   else
   {
-    if(unlikely(ARCH_DEP(cmpsc_vstore)(ec, &ec->ec[ec->eci[is]], ec->ecl[is])))
+    if(unlikely(ARCH_DEP(cmpsc_vstore)(ec, &ec->dc->u.x.ec[ec->dc->u.x.eci[is]], ec->dc->u.x.ecl[is])))
       return(-1);
   }
 
@@ -60,10 +60,7 @@ int     cpu;
 
 #if !defined(OPTION_FISHIO)
     /* Terminate device threads */
-    obtain_lock (&sysblk.ioqlock);
-    sysblk.devtwait=0;
-    broadcast_condition (&sysblk.ioqcond);
-    release_lock (&sysblk.ioqlock);
+    ioq_wakeup ();
 #endif
 
 } /* end function release_config */
@@ -860,7 +857,7 @@ DEVBLK *find_device_by_subchan (U32 ioid)
 /*-------------------------------------------------------------------*/
 /* Returns a CPU register context for the device, or else NULL       */
 /*-------------------------------------------------------------------*/
-REGS *devregs(DEVBLK *dev)
+DLL_EXPORT REGS *devregs(DEVBLK *dev)
 {
     /* If a register context already exists then use it */
     if (dev->regs)
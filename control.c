@@ -1143,9 +1143,10 @@ BYTE    storkey;
                 SIE_TRANSLATE(&n, ACCTYPE_SIE, regs);
 
 #if !defined(_FEATURE_2K_STORAGE_KEYS)
-                regs->GR_LHLCL(r1) = STORAGE_KEY(n, regs) & 0xFE;
+                regs->GR_LHLCL(r1) = (STORAGE_KEY(n, regs) | STORKEY_SAVEDC(n, regs)) & 0xFE;
 #else
-                regs->GR_LHLCL(r1) = (STORAGE_KEY1(n, regs) | STORAGE_KEY2(n, regs)) & 0xFE;
+                regs->GR_LHLCL(r1) = (STORAGE_KEY1(n, regs) | STORAGE_KEY2(n, regs)
+                                      | STORKEY_SAVEDC4K(n, regs)) & 0xFE;
 #endif
             }
             else
@@ -1215,28 +1216,31 @@ BYTE    storkey;
 
 #if !defined(_FEATURE_2K_STORAGE_KEYS)
                     regs->GR_LHLCL(r1) = storkey
-                                       | (STORAGE_KEY(n, regs) & 0xFE);
+                                       | ((STORAGE_KEY(n, regs) | STORKEY_SAVEDC(n, regs)) & 0xFE);
 #else
                     regs->GR_LHLCL(r1) = storkey
-                                       | ((STORAGE_KEY1(n, regs) | STORAGE_KEY2(n, regs)) & 0xFE);
+                                       | ((STORAGE_KEY1(n, regs) | STORAGE_KEY2(n, regs)
+                                           | STORKEY_SAVEDC4K(n, regs)) & 0xFE);
 #endif
                 }
             }
         }
         else /* !sie_pref */
 #if !defined(_FEATURE_2K_STORAGE_KEYS)
-            regs->GR_LHLCL(r1) = STORAGE_KEY(n, regs) & 0xFE;
+            regs->GR_LHLCL(r1) = (STORAGE_KEY(n, regs) | STORKEY_SAVEDC(n, regs)) & 0xFE;
 #else
-            regs->GR_LHLCL(r1) = (STORAGE_KEY1(n, regs) | STORAGE_KEY2(n, regs)) & 0xFE;
+            regs->GR_LHLCL(r1) = (STORAGE_KEY1(n, regs) | STORAGE_KEY2(n, regs)
+                                  | STORKEY_SAVEDC4K(n, regs)) & 0xFE;
 #endif
     }
     else /* !SIE_MODE */
 #endif /*defined(_FEATURE_SIE)*/
         /* Insert the storage key into R1 register bits 24-31 */
 #if defined(_FEATURE_2K_STORAGE_KEYS)
-        regs->GR_LHLCL(r1) = STORAGE_KEY(n, regs) & 0xFE;
+        regs->GR_LHLCL(r1) = (STORAGE_KEY(n, regs) | STORKEY_SAVEDC(n, regs)) & 0xFE;
 #else
-        regs->GR_LHLCL(r1) = (STORAGE_KEY1(n, regs) | STORAGE_KEY2(n, regs)) & 0xFE;
+        regs->GR_LHLCL(r1) = (STORAGE_KEY1(n, regs) | STORAGE_KEY2(n, regs)
+                              | STORKEY_SAVEDC4K(n, regs)) & 0xFE;
 #endif
 
     /* In BC mode, clear bits 29-31 of R1 register */
@@ -1295,9 +1299,10 @@ BYTE    storkey;
 
                 /* Insert the storage key into R1 register bits 24-31 */
 #if !defined(_FEATURE_2K_STORAGE_KEYS)
-                regs->GR_LHLCL(r1) = STORAGE_KEY(n, regs) & 0xFE;
+                regs->GR_LHLCL(r1) = (STORAGE_KEY(n, regs) | STORKEY_SAVEDC(n, regs)) & 0xFE;
 #else
-                regs->GR_LHLCL(r1) = (STORAGE_KEY1(n, regs) | STORAGE_KEY2(n, regs)) & 0xFE;
+                regs->GR_LHLCL(r1) = (STORAGE_KEY1(n, regs) | STORAGE_KEY2(n, regs)
+                                      | STORKEY_SAVEDC4K(n, regs)) & 0xFE;
 #endif
         }
         else
@@ -1375,9 +1380,10 @@ BYTE    storkey;
 
                     /* Insert the storage key into R1 register bits 24-31 */
 #if !defined(_FEATURE_2K_STORAGE_KEYS)
-                    regs->GR_LHLCL(r1) = storkey | (STORAGE_KEY(n, regs) & 0xFE);
+                    regs->GR_LHLCL(r1) = storkey | ((STORAGE_KEY(n, regs) | STORKEY_SAVEDC(n, regs)) & 0xFE);
 #else
-                    regs->GR_LHLCL(r1) = storkey | ((STORAGE_KEY1(n, regs) | STORAGE_KEY2(n, regs)) & 0xFE);
+                    regs->GR_LHLCL(r1) = storkey | ((STORAGE_KEY1(n, regs) | STORAGE_KEY2(n, regs)
+                                                     | STORKEY_SAVEDC4K(n, regs)) & 0xFE);
 #endif
                 }
             }
@@ -1385,18 +1391,20 @@ BYTE    storkey;
         else /* sie_pref */
             /* Insert the storage key into R1 register bits 24-31 */
 #if !defined(_FEATURE_2K_STORAGE_KEYS)
-            regs->GR_LHLCL(r1) = STORAGE_KEY(n, regs) & 0xFE;
+            regs->GR_LHLCL(r1) = (STORAGE_KEY(n, regs) | STORKEY_SAVEDC(n, regs)) & 0xFE;
 #else
-            regs->GR_LHLCL(r1) = (STORAGE_KEY1(n, regs) | STORAGE_KEY2(n, regs)) & 0xFE;
+            regs->GR_LHLCL(r1) = (STORAGE_KEY1(n, regs) | STORAGE_KEY2(n, regs)
+                                  | STORKEY_SAVEDC4K(n, regs)) & 0xFE;
 #endif
     }
     else /* !SIE_MODE */
 #endif /*defined(_FEATURE_SIE)*/
         /* Insert the storage key into R1 register bits 24-31 */
 #if !defined(_FEATURE_2K_STORAGE_KEYS)
-        regs->GR_LHLCL(r1) = STORAGE_KEY(n, regs) & 0xFE;
+        regs->GR_LHLCL(r1) = (STORAGE_KEY(n, regs) | STORKEY_SAVEDC(n, regs)) & 0xFE;
 #else
-        regs->GR_LHLCL(r1) = (STORAGE_KEY1(n, regs) | STORAGE_KEY2(n, regs)) & 0xFE;
+        regs->GR_LHLCL(r1) = (STORAGE_KEY1(n, regs) | STORAGE_KEY2(n, regs)
+                              | STORKEY_SAVEDC4K(n, regs)) & 0xFE;
 #endif
 
 } /* end DEF_INST(insert_storage_key_extended) */
@@ -3368,7 +3376,7 @@ int     rc;                             /* return code from load_psw */
     memcpy( &newregs, regs, sysblk.regs_copy_len );
 
     /* Now INVALIDATE ALL TLB ENTRIES in our working copy.. */
-    memset( &newregs.tlb.vaddr, 0, TLBN * sizeof(DW) );
+    tlb_init( &newregs, 0, 1 );
     newregs.tlbID = 1;
 
     /* Set the breaking event address register in the copy */
@@ -4032,9 +4040,10 @@ BYTE    storkey;                        /* Storage key               */
             {
                 SIE_TRANSLATE(&n, ACCTYPE_SIE, regs);
 #if !defined(_FEATURE_2K_STORAGE_KEYS)
-                storkey = STORAGE_KEY(n, regs);
+                storkey = STORAGE_KEY(n, regs) | STORKEY_SAVEDC(n, regs);
 #else
-                storkey = STORAGE_KEY1(n, regs) | STORAGE_KEY2(n, regs);
+                storkey = STORAGE_KEY1(n, regs) | STORAGE_KEY2(n, regs)
+                          | STORKEY_SAVEDC4K(n, regs);
 #endif
 
                 /* Reset the reference bit in the storage key */
@@ -4092,13 +4101,15 @@ BYTE    storkey;                        /* Storage key               */
                 {
                     ra = APPLY_PREFIXING(regs->hostregs->dat.raddr, regs->hostregs->PX);
 #if !defined(_FEATURE_2K_STORAGE_KEYS)
-                    realkey = STORAGE_KEY(ra, regs)
+                    realkey = (STORAGE_KEY(ra, regs) | STORKEY_SAVEDC(ra, regs))
 #else
-                    realkey = (STORAGE_KEY1(ra, regs) | STORAGE_KEY2(ra, regs))
+                    realkey = (STORAGE_KEY1(ra, regs) | STORAGE_KEY2(ra, regs)
+                               | STORKEY_SAVEDC4K(ra, regs))
 #endif
                             & (STORKEY_REF | STORKEY_CHANGE);
 
                     /* Reset reference and change bits in storage key */
+                    STORKEY_CHGSAVE(ra, regs);
 #if !defined(_FEATURE_2K_STORAGE_KEYS)
                     STORAGE_KEY(ra, regs) &= ~(STORKEY_REF | STORKEY_CHANGE);
 #else
@@ -4125,9 +4136,10 @@ BYTE    storkey;                        /* Storage key               */
         else /* regs->sie_perf */
         {
 #if defined(_FEATURE_2K_STORAGE_KEYS)
-            storkey = STORAGE_KEY(n, regs);
+            storkey = STORAGE_KEY(n, regs) | STORKEY_SAVEDC(n, regs);
 #else
-            storkey = STORAGE_KEY1(n, regs) | STORAGE_KEY2(n, regs);
+            storkey = STORAGE_KEY1(n, regs) | STORAGE_KEY2(n, regs)
+                      | STORKEY_SAVEDC4K(n, regs);
 #endif
             /* Reset the reference bit in the storage key */
 #if defined(_FEATURE_2K_STORAGE_KEYS)
@@ -4144,7 +4156,8 @@ BYTE    storkey;                        /* Storage key               */
 #if !defined(_FEATURE_2K_STORAGE_KEYS)
         storkey =  STORAGE_KEY(n, regs);
 #else
-        storkey =  STORAGE_KEY1(n, regs) | STORAGE_KEY2(n, regs);
+        storkey =  STORAGE_KEY1(n, regs) | STORAGE_KEY2(n, regs)
+                   | STORKEY_SAVEDC4K(n, regs);
 #endif
             /* Reset the reference bit in the storage key */
 #if !defined(_FEATURE_2K_STORAGE_KEYS)
@@ -4213,10 +4226,11 @@ BYTE    storkey;                        /* Storage key               */
             {
                 SIE_TRANSLATE(&n, ACCTYPE_SIE, regs);
 #if !defined(_FEATURE_2K_STORAGE_KEYS)
-                storkey = STORAGE_KEY(n, regs);
+                storkey = STORAGE_KEY(n, regs) | STORKEY_SAVEDC(n, regs);
 #else
             storkey = STORAGE_KEY1(n, regs)
                    | (STORAGE_KEY2(n, regs) & (STORKEY_REF|STORKEY_CHANGE))
+                   | STORKEY_SAVEDC4K(n, regs)
 #endif
                                         ;
             /* Reset the reference bit in the storage key */
@@ -4282,13 +4296,16 @@ BYTE    storkey;                        /* Storage key               */
                 {
                     ra = APPLY_PREFIXING(regs->hostregs->dat.raddr, regs->hostregs->PX);
 #if !defined(_FEATURE_2K_STORAGE_KEYS)
-                    realkey = STORAGE_KEY(ra, regs) & (STORKEY_REF | STORKEY_CHANGE);
+                    realkey = (STORAGE_KEY(ra, regs) | STORKEY_SAVEDC(ra, regs))
+                              & (STORKEY_REF | STORKEY_CHANGE);
 #else
-                    realkey = (STORAGE_KEY1(ra, regs) | STORAGE_KEY2(ra, regs))
+                    realkey = (STORAGE_KEY1(ra, regs) | STORAGE_KEY2(ra, regs)
+                               | STORKEY_SAVEDC4K(ra, regs))
                               & (STORKEY_REF | STORKEY_CHANGE);
 #endif
                     /* Reset the reference and change bits in
                        the real machine storage key */
+                    STORKEY_CHGSAVE(ra, regs);
 #if !defined(_FEATURE_2K_STORAGE_KEYS)
                     STORAGE_KEY(ra, regs) &= ~(STORKEY_REF | STORKEY_CHANGE);
 #else
@@ -4315,10 +4332,11 @@ BYTE    storkey;                        /* Storage key               */
         else
         {
 #if !defined(_FEATURE_2K_STORAGE_KEYS)
-            storkey = STORAGE_KEY(n, regs);
+            storkey = STORAGE_KEY(n, regs) | STORKEY_SAVEDC(n, regs);
 #else
             storkey = STORAGE_KEY1(n, regs)
                       | (STORAGE_KEY2(n, regs) & (STORKEY_REF|STORKEY_CHANGE))
+                      | STORKEY_SAVEDC4K(n, regs)
 #endif
                                     ;
             /* Reset the reference bit in the storage key */
@@ -4334,10 +4352,11 @@ BYTE    storkey;                        /* Storage key               */
 #endif /*defined(_FEATURE_SIE)*/
     {
 #if !defined(_FEATURE_2K_STORAGE_KEYS)
-        storkey = STORAGE_KEY(n, regs);
+        storkey = STORAGE_KEY(n, regs) | STORKEY_SAVEDC(n, regs);
 #else
         storkey = STORAGE_KEY1(n, regs)
                   | (STORAGE_KEY2(n, regs) & (STORKEY_REF|STORKEY_CHANGE))
+                  | STORKEY_SAVEDC4K(n, regs)
 #endif
                                 ;
         /* Reset the reference bit in the storage key */
@@ -4999,9 +5018,10 @@ RADR    n;                              /* Absolute storage addr     */
 
                     realkey =
 #if !defined(_FEATURE_2K_STORAGE_KEYS)
-                              STORAGE_KEY(n, regs)
+                              (STORAGE_KEY(n, regs) | STORKEY_SAVEDC(n, regs))
 #else
-                              (STORAGE_KEY1(n, regs) | STORAGE_KEY2(n, regs))
+                              (STORAGE_KEY1(n, regs) | STORAGE_KEY2(n, regs)
+                               | STORKEY_SAVEDC4K(n, regs))
 #endif
                               & (STORKEY_REF | STORKEY_CHANGE);
                 }
@@ -5024,6 +5044,7 @@ RADR    n;                              /* Absolute storage addr     */
                 if(!sr)
 #endif /*defined(_FEATURE_STORAGE_KEY_ASSIST)*/
                 {
+                    STORKEY_CHGSAVE(n, regs);
 #if !defined(_FEATURE_2K_STORAGE_KEYS)
                     STORAGE_KEY(n, regs) &= STORKEY_BADFRM;
                     STORAGE_KEY(n, regs) |= regs->GR_LHLCL(r1)
@@ -5042,6 +5063,7 @@ RADR    n;                              /* Absolute storage addr     */
         else
         {
             /* Update the storage key from R1 register bits 24-30 */
+            STORKEY_CHGSAVE(n, regs);
 #if !defined(_FEATURE_2K_STORAGE_KEYS)
             STORAGE_KEY(n, regs) &= STORKEY_BADFRM;
             STORAGE_KEY(n, regs) |= regs->GR_LHLCL(r1) & ~(STORKEY_BADFRM);
@@ -5057,6 +5079,7 @@ RADR    n;                              /* Absolute storage addr     */
 #endif /*defined(_FEATURE_SIE)*/
     {
         /* Update the storage key from R1 register bits 24-30 */
+        STORKEY_CHGSAVE(n, regs);
 #if defined(_FEATURE_2K_STORAGE_KEYS)
         STORAGE_KEY(n, regs) &= STORKEY_BADFRM;
         STORAGE_KEY(n, regs) |= regs->GR_LHLCL(r1) & ~(STORKEY_BADFRM);
@@ -5310,9 +5333,10 @@ BYTE    r1key;                          /* New key (R1 bits 56-63)   */
 
                         protkey =
 #if !defined(_FEATURE_2K_STORAGE_KEYS)
-                                  STORAGE_KEY(n, regs)
+                                  (STORAGE_KEY(n, regs) | STORKEY_SAVEDC(n, regs))
 #else
-                                  (STORAGE_KEY1(n, regs) | STORAGE_KEY2(n, regs))
+                                  (STORAGE_KEY1(n, regs) | STORAGE_KEY2(n, regs)
+                                   | STORKEY_SAVEDC4K(n, regs))
 #endif
                                                                                   ;
                         realkey = protkey & (STORKEY_REF | STORKEY_CHANGE);
@@ -5342,6 +5366,7 @@ BYTE    r1key;                          /* New key (R1 bits 56-63)   */
                     if(!sr)
 #endif /*defined(_FEATURE_STORAGE_KEY_ASSIST)*/
                     {
+                        STORKEY_CHGSAVE(n, regs);
 #if !defined(_FEATURE_2K_STORAGE_KEYS)
                         STORAGE_KEY(n, regs) &= STORKEY_BADFRM;
                         STORAGE_KEY(n, regs) |= r1key
@@ -5363,14 +5388,16 @@ BYTE    r1key;                          /* New key (R1 bits 56-63)   */
                 /* Perform conditional SSKE procedure */
                 if (ARCH_DEP(conditional_sske_procedure)(regs, r1, m3,
 #if defined(FEATURE_4K_STORAGE_KEYS) && !defined(_FEATURE_2K_STORAGE_KEYS)
-                        STORAGE_KEY(n, regs),
+                        (STORAGE_KEY(n, regs) | STORKEY_SAVEDC(n, regs)),
 #else
-                        (STORAGE_KEY1(n, regs) | STORAGE_KEY2(n, regs)),
+                        (STORAGE_KEY1(n, regs) | STORAGE_KEY2(n, regs)
+                         | STORKEY_SAVEDC4K(n, regs)),
 #endif
                     r1key))
                     return;
 #endif /*defined(FEATURE_CONDITIONAL_SSKE)*/
                 /* Update the storage key from R1 register bits 24-30 */
+                STORKEY_CHGSAVE(n, regs);
 #if !defined(_FEATURE_2K_STORAGE_KEYS)
                 STORAGE_KEY(n, regs) &= STORKEY_BADFRM;
                 STORAGE_KEY(n, regs) |= r1key & ~(STORKEY_BADFRM);
@@ -5389,15 +5416,17 @@ BYTE    r1key;                          /* New key (R1 bits 56-63)   */
             /* Perform conditional SSKE procedure */
             if (ARCH_DEP(conditional_sske_procedure)(regs, r1, m3,
 #if defined(FEATURE_4K_STORAGE_KEYS) && !defined(_FEATURE_2K_STORAGE_KEYS)
-                    STORAGE_KEY(n, regs),
+                    (STORAGE_KEY(n, regs) | STORKEY_SAVEDC(n, regs)),
 #else
-                    (STORAGE_KEY1(n, regs) | STORAGE_KEY2(n, regs)),
+                    (STORAGE_KEY1(n, regs) | STORAGE_KEY2(n, regs)
+                     | STORKEY_SAVEDC4K(n, regs)),
 #endif
                 r1key))
                 return;
 #endif /*defined(FEATURE_CONDITIONAL_SSKE)*/
 
             /* Update the storage key from R1 register bits 24-30 */
+            STORKEY_CHGSAVE(n, regs);
 #if defined(FEATURE_4K_STORAGE_KEYS) && !defined(_FEATURE_2K_STORAGE_KEYS)
             STORAGE_KEY(n, regs) &= STORKEY_BADFRM;
             STORAGE_KEY(n, regs) |= r1key & ~(STORKEY_BADFRM);
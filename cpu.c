@@ -915,6 +915,9 @@ static char *pgmintname[] = {
         /* Store current PSW at PSA+X'28' or PSA+X'150' for ESAME */
         ARCH_DEP(store_psw) (realregs, psa->pgmold);
 
+        /* Discard cached blocks built from the PSA */
+        BBC_INVALIDATE(psa, sizeof(*psa));
+
         /* Load new PSW from PSA+X'68' or PSA+X'1D0' for ESAME */
         if ( (code = ARCH_DEP(load_psw) (realregs, psa->pgmnew)) )
         {
@@ -971,6 +974,9 @@ PSA    *psa;                            /* -> Prefixed storage area  */
     /* Store current PSW at PSA+X'8' or PSA+X'120' for ESAME  */
     ARCH_DEP(store_psw) (regs, psa->RSTOLD);
 
+    /* Discard cached blocks built from the PSA */
+    BBC_INVALIDATE(psa, sizeof(*psa));
+
     /* Load new PSW from PSA+X'0' or PSA+X'1A0' for ESAME */
     rc = ARCH_DEP(load_psw) (regs, psa->RSTNEW);
 
@@ -991,7 +997,7 @@ PSA    *psa;                            /* -> Prefixed storage area  */
 
 /*-------------------------------------------------------------------*/
 /* Perform I/O interrupt if pending                                  */
-/* Note: The caller MUST hold the interrupt lock (sysblk.intlock)    */
+/* Note: The caller must NOT hold the interrupt lock (sysblk.intlock)*/
 /*-------------------------------------------------------------------*/
 void ARCH_DEP(perform_io_interrupt) (REGS *regs)
 {
@@ -1082,18 +1088,16 @@ DBLWRD  csw;                            /* CSW for S/370 channels    */
         /* Store current PSW at PSA+X'38' or PSA+X'170' for ESAME */
         ARCH_DEP(store_psw) ( regs, psa->iopold );
 
+        /* Discard cached blocks built from the PSA */
+        BBC_INVALIDATE(psa, sizeof(*psa));
+
         /* Load new PSW from PSA+X'78' or PSA+X'1F0' for ESAME */
         rc = ARCH_DEP(load_psw) ( regs, psa->iopnew );
 
         if ( rc )
-        {
-            RELEASE_INTLOCK(regs);
             regs->program_interrupt (regs, rc);
-        }
     }
 
-    RELEASE_INTLOCK(regs);
-
     longjmp(regs->progjmp, icode);
 
 } /* end function perform_io_interrupt */
@@ -1153,6 +1157,9 @@ RADR    fsta;                           /* Failing storage address   */
     /* Store current PSW at PSA+X'30' */
     ARCH_DEP(store_psw) ( regs, psa->mckold );
 
+    /* Discard cached blocks built from the PSA */
+    BBC_INVALIDATE(psa, sizeof(*psa));
+
     /* Load new PSW from PSA+X'70' */
     rc = ARCH_DEP(load_psw) ( regs, psa->mcknew );
 
@@ -1227,6 +1234,23 @@ int   cpu  = *ptr;
     /* Back to user mode */
     SETMODE(USER);
 
+#if defined(OPTION_HUGE_STORAGE)
+    /* Run on the processors of one of the storage NUMA nodes */
+    if (sysblk.numa != NUMA_NONE && sysblk.numanodes)
+    {
+        int node, n;
+        for (node = n = 0; node < 64; node++)
+            if (sysblk.numanodes & (1ULL << node))
+                n++;
+        for (node = 0, n = cpu % n; ; node++)
+            if ((sysblk.numanodes & (1ULL << node)) && n-- == 0)
+                break;
+        if (bind_host_node (node))
+            logmsg (_("HHCCP005W CPU%4.4X thread cannot be bound to NUMA "
+                    "node %d\n"), cpu, node);
+    }
+#endif /*defined(OPTION_HUGE_STORAGE)*/
+
     /* Display thread started message on control panel */
     logmsg (_("HHCCP002I CPU%4.4X thread started: tid="TIDPAT", pid=%d, "
             "priority=%d\n"),
@@ -1300,6 +1324,7 @@ int i;
     regs->vf = &sysblk.vf[cpu];
     regs->vf->online = (cpu < sysblk.numvec);
 #endif /*defined(_FEATURE_VECTOR_FACILITY)*/
+    tlb_init (regs, sysblk.tlbsets, sysblk.tlbways);
     initial_cpu_reset(regs);
 
     if (hostregs == NULL)
@@ -1366,6 +1391,8 @@ int i;
 /*-------------------------------------------------------------------*/
 void *cpu_uninit (int cpu, REGS *regs)
 {
+int     i;                              /* Index                     */
+
     if (regs->host)
     {
         obtain_lock (&sysblk.cpulock[cpu]);
@@ -1378,6 +1405,24 @@ void *cpu_uninit (int cpu, REGS *regs)
 
     destroy_condition(&regs->intcond);
 
+    if (regs->cmpsc)
+    {
+        for (i = 0; i < CMPSC_DICTS; i++)
+            free (regs->cmpsc->dict[i]);
+        free (regs->cmpsc);
+        regs->cmpsc = NULL;
+    }
+
+    tlb_uninit (regs);
+
+#if defined(OPTION_BLOCK_CACHE)
+    if (regs->bbc)
+    {
+        free (regs->bbc);
+        regs->bbc = NULL;
+    }
+#endif /*defined(OPTION_BLOCK_CACHE)*/
+
     if (regs->host)
     {
 #ifdef FEATURE_VECTOR_FACILITY
@@ -1402,6 +1447,240 @@ void *cpu_uninit (int cpu, REGS *regs)
 }
 
 
+/*-------------------------------------------------------------------*/
+/* Initialize the translation lookaside buffer                       */
+/*                                                                   */
+/* All TLB entries are invalidated and the statistics are reset.     */
+/* If sets is nonzero then a second level TLB of sets * ways entries */
+/* is obtained; a second level TLB previously obtained must first be */
+/* released by tlb_uninit.  Returns -1 if it could not be obtained.  */
+/*-------------------------------------------------------------------*/
+int tlb_init (REGS *regs, U32 sets, int ways)
+{
+TLB2   *l2 = &regs->tlb.l2;             /* -> Second level TLB       */
+BYTE   *area = NULL;                    /* -> Obtained entries       */
+int     entries = sets * ways;          /* Number of entries         */
+int     rc = 0;                         /* Return code               */
+
+    memset (&regs->tlb.vaddr, 0, TLBN * sizeof(DW));
+    regs->tlb.l2hits = regs->tlb.misses = 0;
+
+    if (entries)
+    {
+        area = calloc (entries, 3 * sizeof(DW) + 2);
+        if (area == NULL)
+        {
+            logmsg (_("HHCCP092E CPU%4.4X calloc failed for %d TLB "
+                      "entries: %s\n"),
+                    regs->cpuad, entries, strerror(errno));
+            rc = -1;
+        }
+    }
+
+    memset (l2, 0, sizeof(TLB2));
+    if (area)
+    {
+        l2->asd     = (DW*)area;
+        l2->vaddr   = l2->asd + entries;
+        l2->pte     = l2->vaddr + entries;
+        l2->common  = (BYTE*)(l2->pte + entries);
+        l2->protect = l2->common + entries;
+        l2->sets    = sets;
+        l2->mask    = sets - 1;
+        l2->ways    = ways;
+        l2->entries = entries;
+    }
+
+    return rc;
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Release the second level translation lookaside buffer             */
+/*-------------------------------------------------------------------*/
+void tlb_uninit (REGS *regs)
+{
+    if (regs->tlb.l2.entries)
+    {
+        free (regs->tlb.l2.asd);
+        tlb_init (regs, 0, 1);
+    }
+}
+
+
+#if defined(OPTION_BLOCK_CACHE)
+/*-------------------------------------------------------------------*/
+/* Allocate the basic block cache for a CPU                          */
+/*                                                                   */
+/* Called by the CPU thread itself the first time it runs with the   */
+/* block cache enabled.  The frame table is obtained by the first    */
+/* CPU and is kept for the life of the configuration, since the      */
+/* store paths test it without holding a lock.  The cache remains    */
+/* allocated until the CPU is deconfigured so that the panel may     */
+/* display its statistics while holding the cpu lock.                */
+/*-------------------------------------------------------------------*/
+int bbc_init (REGS *regs)
+{
+BBCACHE *bbc;                           /* -> Basic block cache      */
+RADR     frames;                        /* Number of frames          */
+
+    bbc = calloc (1, sizeof(BBCACHE));
+    if (bbc == NULL)
+    {
+        logmsg (_("HHCCP091E CPU%4.4X calloc failed for block cache: %s\n"),
+                regs->cpuad, strerror(errno));
+        sysblk.blkcache = 0;
+        return -1;
+    }
+
+    obtain_lock (&sysblk.bbclock);
+    if (sysblk.bbcframe == NULL)
+    {
+        frames = (sysblk.mainsize + (1 << BBC_FRAMESHIFT) - 1)
+                                                    >> BBC_FRAMESHIFT;
+        sysblk.bbcframe = calloc ((size_t)frames, sizeof(BBFRAME));
+        if (sysblk.bbcframe == NULL)
+            logmsg (_("HHCCP093E calloc failed for block cache "
+                      "frame table: %s\n"), strerror(errno));
+    }
+    release_lock (&sysblk.bbclock);
+
+    if (sysblk.bbcframe == NULL)
+    {
+        free (bbc);
+        sysblk.blkcache = 0;
+        return -1;
+    }
+
+    obtain_lock (regs->cpulock);
+    regs->bbc = bbc;
+    release_lock (regs->cpulock);
+
+    return 0;
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Check a CPU store into main storage against the block cache       */
+/*                                                                   */
+/* Called by logical_to_main_l for every access which may store,     */
+/* before the store is made.  `addr' is the absolute address and     */
+/* `len' the number of bytes; a length of 1 or less is taken to mean */
+/* the rest of the frame, as many callers pass 1 for longer stores.  */
+/* `slow' is nonzero if the TLB would not have given write access    */
+/* anyway.  A store into a line of the frame holding cached code     */
+/* discards the blocks built from the frame; other stores into the   */
+/* frame are counted, and the frame is no longer cached when they    */
+/* become too many, so that its stores may use the TLB again.        */
+/*                                                                   */
+/* Returns 0 if the TLB may give write access to the frame, 1 if it  */
+/* may not, or 2 if cached blocks were discarded, in which case the  */
+/* caller ends the block it may be executing.                        */
+/*-------------------------------------------------------------------*/
+int bbc_store (RADR addr, size_t len, int acctype, int slow)
+{
+BBFRAME *frame;                         /* -> Frame stored into      */
+U64      lines;                         /* Lines stored into         */
+int      off;                           /* Offset of addr in frame   */
+int      rc;                            /* Return code               */
+
+    if (addr >= sysblk.mainsize)
+        return 0;
+
+    /* Lines are only added to a frame while this CPU is stopped
+       at an instruction boundary, so the frame cannot become
+       cached while the store is being made */
+    frame = sysblk.bbcframe + (addr >> BBC_FRAMESHIFT);
+    if (frame->code == 0)
+        return 0;
+
+    /* An access which does not store (TPROT) keeps the frame out
+       of the TLB, as it would give the TLB entry write access */
+    if (!(acctype & (ACC_WRITE|ACC_CHECK)))
+        return 1;
+
+    off = addr & ((1 << BBC_FRAMESHIFT) - 1);
+    lines = BBC_LINES(off, len > 1 && off + len <= (1 << BBC_FRAMESHIFT)
+                           ? off + (int)len - 1
+                           : (1 << BBC_FRAMESHIFT) - 1);
+
+    /* Store into data held in a frame with cached code */
+    if (likely(!(frame->code & lines))
+     && (slow || ++frame->hits < BBC_MAXHITS))
+        return 1;
+
+    obtain_lock (&sysblk.bbclock);
+    if (frame->code & lines)
+    {
+        /* Discard the blocks built from the frame.  The lines are
+           removed so that a block being built from them by another
+           CPU may only be added with this CPU stopped */
+        frame->gen++;
+        frame->code = 0;
+        if (frame->hits < BBC_MAXHITS)
+            frame->hits++;
+        rc = 2;
+    }
+    else if (frame->code && frame->hits >= BBC_MAXHITS)
+    {
+        /* Frame holds too much data to be cached */
+        frame->gen++;
+        frame->code = 0;
+        rc = 0;
+    }
+    else
+        rc = frame->code ? 1 : 0;
+    release_lock (&sysblk.bbclock);
+
+    return rc;
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Discard the blocks built from main storage which has been stored  */
+/* into without using the TLB (channel data transfer, interruption   */
+/* codes, panel commands).  Called after the store has been made.    */
+/* Every frame in the range gets a new generation, even if no block  */
+/* was built from the lines stored into, since a block may be being  */
+/* built from them by a CPU which read them before the store.        */
+/*-------------------------------------------------------------------*/
+void bbc_invalidate (RADR addr, RADR len)
+{
+BBFRAME *frame;                         /* -> Frame stored into      */
+RADR     end;                           /* Last byte stored into     */
+RADR     n;                             /* Frame number              */
+int      off;                           /* First offset in frame     */
+int      last;                          /* Last offset in frame      */
+
+    if (len == 0 || addr >= sysblk.mainsize)
+        return;
+
+    end = addr + len - 1;
+    if (end >= sysblk.mainsize || end < addr)
+        end = sysblk.mainsize - 1;
+
+    obtain_lock (&sysblk.bbclock);
+    for (n = addr >> BBC_FRAMESHIFT; n <= end >> BBC_FRAMESHIFT; n++)
+    {
+        frame = sysblk.bbcframe + n;
+        off = (n == addr >> BBC_FRAMESHIFT)
+            ? (int)(addr & ((1 << BBC_FRAMESHIFT) - 1)) : 0;
+        last = (n == end >> BBC_FRAMESHIFT)
+             ? (int)(end & ((1 << BBC_FRAMESHIFT) - 1))
+             : (1 << BBC_FRAMESHIFT) - 1;
+        frame->gen++;
+        if (frame->code & BBC_LINES(off, last))
+            frame->code = 0;
+
+        /* A frame whose contents are replaced may be cached again */
+        if (off == 0 && last == (1 << BBC_FRAMESHIFT) - 1)
+            frame->hits = 0;
+    }
+    release_lock (&sysblk.bbclock);
+}
+#endif /*defined(OPTION_BLOCK_CACHE)*/
+
+
 #endif /*!defined(_GEN_ARCH)*/
 
 
@@ -1410,6 +1689,9 @@ void *cpu_uninit (int cpu, REGS *regs)
 /*-------------------------------------------------------------------*/
 void (ATTR_REGPARM(1) ARCH_DEP(process_interrupt))(REGS *regs)
 {
+U32     ioqueued;                       /* I/O interrupts queued     */
+U32     ioqueued2;                      /* ... after presentation    */
+
     /* Process PER program interrupts */
     if( OPEN_IC_PER(regs) )
         regs->program_interrupt (regs, PGM_PER_EVENT);
@@ -1452,7 +1734,16 @@ void (ATTR_REGPARM(1) ARCH_DEP(process_interrupt))(REGS *regs)
             {
                 PERFORM_SERIALIZATION (regs);
                 PERFORM_CHKPT_SYNC (regs);
-                ARCH_DEP (perform_io_interrupt) (regs);
+                /* Presented without the interrupt lock; returns only
+                   if no interrupt was taken.  Try again if one was
+                   queued meanwhile, or we could wait with it pending */
+                do {
+                    IOINT_QUEUED(ioqueued);
+                    RELEASE_INTLOCK(regs);
+                    ARCH_DEP (perform_io_interrupt) (regs);
+                    OBTAIN_INTLOCK(regs);
+                    IOINT_QUEUED(ioqueued2);
+                } while (ioqueued2 != ioqueued && OPEN_IC_IOPENDING(regs));
             }
             else
                 WAKEUP_CPU_MASK(sysblk.waiting_mask);
@@ -1601,6 +1892,600 @@ void (ATTR_REGPARM(1) ARCH_DEP(process_interrupt))(REGS *regs)
 
 } /* process_interrupt */
 
+#if defined(OPTION_INSTRUCTION_PROFILE)
+/*-------------------------------------------------------------------*/
+/* Execute one instruction, recording a profile sample               */
+/*-------------------------------------------------------------------*/
+/* The timer thread sets `profsample' and the interrupt state bit;   */
+/* the sample is the instruction executed after process_interrupt.   */
+/* The sample is recorded before execution, as the instruction may   */
+/* not return; the host time is recorded if it does.                 */
+/*-------------------------------------------------------------------*/
+static void ARCH_DEP(profile_instruction) (REGS *regs, BYTE *ip)
+{
+BYTE    inst[6];                        /* Sampled instruction       */
+U64     start;                          /* Host time (nanoseconds)   */
+
+    regs->profsample = 0;
+    memset (inst, 0, sizeof(inst));
+    memcpy (inst, ip, ILC(ip[0]));
+    profile_sample (regs->cpuad, (U64)PSW_IA(regs, 0), inst);
+
+    start = profile_clock ();
+    EXECUTE_INSTRUCTION(ip, regs);
+    profile_time (inst, profile_clock () - start);
+}
+#endif /*defined(OPTION_INSTRUCTION_PROFILE)*/
+
+#if defined(OPTION_BLOCK_CACHE)
+/*-------------------------------------------------------------------*/
+/* Basic block cache instruction functions                           */
+/*                                                                   */
+/* These replace the instruction functions of the most frequently    */
+/* executed instructions when they are cached.  They are passed the  */
+/* BBINST holding the operand fields decoded when the block was      */
+/* built, and otherwise do exactly what the functions they replace   */
+/* do, in the same order.                                            */
+/*-------------------------------------------------------------------*/
+#define BBC_INST(_name) \
+static void (ATTR_REGPARM(2) ARCH_DEP(bbc_ ## _name)) (BYTE inst[], REGS *regs)
+
+/* Effective address from the decoded X2, B2 and displacement fields */
+#define BBC_ADDR(_bbi, _regs) \
+    ( (VADR)(_bbi)->i2 \
+    + ((_bbi)->r2 ? (VADR)(_regs)->GR((_bbi)->r2) : (VADR)0) \
+    + ((_bbi)->b2 ? (VADR)(_regs)->GR((_bbi)->b2) : (VADR)0) )
+
+BBC_INST(load_register)
+{
+BBINST *bbi = (BBINST *)inst;           /* -> Cached instruction     */
+
+    INST_UPDATE_PSW(regs, 2, 0);
+    regs->GR_L(bbi->r1) = regs->GR_L(bbi->r2);
+}
+
+BBC_INST(load_and_test_register)
+{
+BBINST *bbi = (BBINST *)inst;           /* -> Cached instruction     */
+
+    INST_UPDATE_PSW(regs, 2, 0);
+    regs->GR_L(bbi->r1) = regs->GR_L(bbi->r2);
+    regs->psw.cc = (S32)regs->GR_L(bbi->r1) < 0 ? 1 :
+                   (S32)regs->GR_L(bbi->r1) > 0 ? 2 : 0;
+}
+
+BBC_INST(add_register)
+{
+BBINST *bbi = (BBINST *)inst;           /* -> Cached instruction     */
+
+    INST_UPDATE_PSW(regs, 2, 2);
+    regs->psw.cc = add_signed (&(regs->GR_L(bbi->r1)),
+                               regs->GR_L(bbi->r1),
+                               regs->GR_L(bbi->r2));
+    if ( regs->psw.cc == 3 && FOMASK(&regs->psw) )
+        regs->program_interrupt (regs, PGM_FIXED_POINT_OVERFLOW_EXCEPTION);
+}
+
+BBC_INST(subtract_register)
+{
+BBINST *bbi = (BBINST *)inst;           /* -> Cached instruction     */
+
+    INST_UPDATE_PSW(regs, 2, 2);
+    regs->psw.cc = sub_signed (&(regs->GR_L(bbi->r1)),
+                               regs->GR_L(bbi->r1),
+                               regs->GR_L(bbi->r2));
+    if ( regs->psw.cc == 3 && FOMASK(&regs->psw) )
+        regs->program_interrupt (regs, PGM_FIXED_POINT_OVERFLOW_EXCEPTION);
+}
+
+BBC_INST(load_address)
+{
+BBINST *bbi = (BBINST *)inst;           /* -> Cached instruction     */
+VADR    effective_addr2;                /* Effective address         */
+
+    effective_addr2 = BBC_ADDR(bbi, regs) & ADDRESS_MAXWRAP(regs);
+    INST_UPDATE_PSW(regs, 4, 0);
+    SET_GR_A(bbi->r1, regs, effective_addr2);
+}
+
+BBC_INST(load)
+{
+BBINST *bbi = (BBINST *)inst;           /* -> Cached instruction     */
+VADR    effective_addr2;                /* Effective address         */
+
+    effective_addr2 = BBC_ADDR(bbi, regs) & ADDRESS_MAXWRAP(regs);
+    INST_UPDATE_PSW(regs, 4, 4);
+    regs->GR_L(bbi->r1) = ARCH_DEP(vfetch4) (effective_addr2, bbi->b2, regs);
+}
+
+BBC_INST(store)
+{
+BBINST *bbi = (BBINST *)inst;           /* -> Cached instruction     */
+VADR    effective_addr2;                /* Effective address         */
+
+    effective_addr2 = BBC_ADDR(bbi, regs) & ADDRESS_MAXWRAP(regs);
+    INST_UPDATE_PSW(regs, 4, 4);
+    ARCH_DEP(vstore4) (regs->GR_L(bbi->r1), effective_addr2, bbi->b2, regs);
+}
+
+BBC_INST(add)
+{
+BBINST *bbi = (BBINST *)inst;           /* -> Cached instruction     */
+VADR    effective_addr2;                /* Effective address         */
+U32     n;                              /* 32-bit operand value      */
+
+    effective_addr2 = BBC_ADDR(bbi, regs) & ADDRESS_MAXWRAP(regs);
+    INST_UPDATE_PSW(regs, 4, 4);
+    n = ARCH_DEP(vfetch4) (effective_addr2, bbi->b2, regs);
+    regs->psw.cc = add_signed (&(regs->GR_L(bbi->r1)),
+                               regs->GR_L(bbi->r1), n);
+    if ( regs->psw.cc == 3 && FOMASK(&regs->psw) )
+        regs->program_interrupt (regs, PGM_FIXED_POINT_OVERFLOW_EXCEPTION);
+}
+
+BBC_INST(branch_on_condition)
+{
+BBINST *bbi = (BBINST *)inst;           /* -> Cached instruction     */
+
+    if ((0x08 >> regs->psw.cc) & bbi->r1)
+        SUCCESSFUL_BRANCH(regs, BBC_ADDR(bbi, regs), 4);
+    else
+        INST_UPDATE_PSW(regs, 4, 0);
+}
+
+/* Only cached if R2 is not zero, so never serializes */
+BBC_INST(branch_on_condition_register)
+{
+BBINST *bbi = (BBINST *)inst;           /* -> Cached instruction     */
+
+    if ((0x08 >> regs->psw.cc) & bbi->r1)
+        SUCCESSFUL_BRANCH(regs, regs->GR(bbi->r2), 2);
+    else
+        INST_UPDATE_PSW(regs, 2, 0);
+}
+
+BBC_INST(branch_on_count)
+{
+BBINST *bbi = (BBINST *)inst;           /* -> Cached instruction     */
+VADR    effective_addr2;                /* Effective address         */
+
+    effective_addr2 = BBC_ADDR(bbi, regs);
+    if ( --(regs->GR_L(bbi->r1)) )
+        SUCCESSFUL_BRANCH(regs, effective_addr2, 4);
+    else
+        INST_UPDATE_PSW(regs, 4, 0);
+}
+
+/* Only cached if R2 is not zero */
+BBC_INST(branch_on_count_register)
+{
+BBINST *bbi = (BBINST *)inst;           /* -> Cached instruction     */
+VADR    newia;                          /* New instruction address   */
+
+    newia = regs->GR(bbi->r2);
+    if ( --(regs->GR_L(bbi->r1)) )
+        SUCCESSFUL_BRANCH(regs, newia, 2);
+    else
+        INST_UPDATE_PSW(regs, 2, 0);
+}
+
+#if defined(FEATURE_IMMEDIATE_AND_RELATIVE)
+BBC_INST(add_halfword_immediate)
+{
+BBINST *bbi = (BBINST *)inst;           /* -> Cached instruction     */
+
+    INST_UPDATE_PSW(regs, 4, 4);
+    regs->psw.cc = add_signed (&(regs->GR_L(bbi->r1)),
+                               regs->GR_L(bbi->r1), (U32)bbi->i2);
+    if ( regs->psw.cc == 3 && FOMASK(&regs->psw) )
+        regs->program_interrupt (regs, PGM_FIXED_POINT_OVERFLOW_EXCEPTION);
+}
+
+BBC_INST(load_halfword_immediate)
+{
+BBINST *bbi = (BBINST *)inst;           /* -> Cached instruction     */
+
+    INST_UPDATE_PSW(regs, 4, 0);
+    regs->GR_L(bbi->r1) = (U32)bbi->i2;
+}
+
+BBC_INST(branch_relative_on_condition)
+{
+BBINST *bbi = (BBINST *)inst;           /* -> Cached instruction     */
+
+    if ((0x08 >> regs->psw.cc) & bbi->r1)
+        SUCCESSFUL_RELATIVE_BRANCH(regs, 2*bbi->i2, 4);
+    else
+        INST_UPDATE_PSW(regs, 4, 0);
+}
+
+BBC_INST(branch_relative_on_count)
+{
+BBINST *bbi = (BBINST *)inst;           /* -> Cached instruction     */
+
+    if ( --(regs->GR_L(bbi->r1)) )
+        SUCCESSFUL_RELATIVE_BRANCH(regs, 2*bbi->i2, 4);
+    else
+        INST_UPDATE_PSW(regs, 4, 0);
+}
+#endif /*defined(FEATURE_IMMEDIATE_AND_RELATIVE)*/
+
+#if defined(FEATURE_ESAME)
+BBC_INST(load_long_register)
+{
+BBINST *bbi = (BBINST *)inst;           /* -> Cached instruction     */
+
+    INST_UPDATE_PSW(regs, 4, 0);
+    regs->GR_G(bbi->r1) = regs->GR_G(bbi->r2);
+}
+
+BBC_INST(add_long_register)
+{
+BBINST *bbi = (BBINST *)inst;           /* -> Cached instruction     */
+
+    INST_UPDATE_PSW(regs, 4, 4);
+    regs->psw.cc = add_signed_long (&(regs->GR_G(bbi->r1)),
+                                    regs->GR_G(bbi->r1),
+                                    regs->GR_G(bbi->r2));
+    if ( regs->psw.cc == 3 && FOMASK(&regs->psw) )
+        regs->program_interrupt (regs, PGM_FIXED_POINT_OVERFLOW_EXCEPTION);
+}
+
+#if defined(FEATURE_LONG_DISPLACEMENT)
+BBC_INST(load_long)
+{
+BBINST *bbi = (BBINST *)inst;           /* -> Cached instruction     */
+VADR    effective_addr2;                /* Effective address         */
+
+    effective_addr2 = BBC_ADDR(bbi, regs) & ADDRESS_MAXWRAP(regs);
+    INST_UPDATE_PSW(regs, 6, 6);
+    regs->GR_G(bbi->r1) = ARCH_DEP(vfetch8) (effective_addr2, bbi->b2, regs);
+}
+
+BBC_INST(store_long)
+{
+BBINST *bbi = (BBINST *)inst;           /* -> Cached instruction     */
+VADR    effective_addr2;                /* Effective address         */
+
+    effective_addr2 = BBC_ADDR(bbi, regs) & ADDRESS_MAXWRAP(regs);
+    INST_UPDATE_PSW(regs, 6, 6);
+    ARCH_DEP(vstore8) (regs->GR_G(bbi->r1), effective_addr2, bbi->b2, regs);
+}
+#endif /*defined(FEATURE_LONG_DISPLACEMENT)*/
+#endif /*defined(FEATURE_ESAME)*/
+
+#undef BBC_INST
+
+
+/*-------------------------------------------------------------------*/
+/* Decode an instruction into a basic block cache entry              */
+/*                                                                   */
+/* The operand fields of the instructions which have a function      */
+/* above are decoded, and the function replaces the one resolved     */
+/* from the opcode tables.  Returns nonzero if the instruction never */
+/* continues with the next sequential instruction, which ends the    */
+/* block.                                                            */
+/*-------------------------------------------------------------------*/
+static int ARCH_DEP(bbc_decode) (BYTE *ip, BBINST *bbi, zz_func func)
+{
+zz_func fast = NULL;                    /* Cached instruction func   */
+int     r1, r2;                         /* First operand, R2 fields  */
+
+    r1 = ip[1] >> 4;
+    r2 = ip[1] & 0x0F;
+
+#define BBC_RR(_name)                                                \
+    if (func == ARCH_DEP(_name))                                     \
+    {                                                                \
+        bbi->r1 = r1;                                                \
+        bbi->r2 = r2;                                                \
+        fast = ARCH_DEP(bbc_ ## _name);                              \
+    }
+
+#define BBC_RX(_name)                                                \
+    if (func == ARCH_DEP(_name))                                     \
+    {                                                                \
+        bbi->r1 = r1;                                                \
+        bbi->r2 = r2;                                                \
+        bbi->b2 = ip[2] >> 4;                                        \
+        bbi->i2 = fetch_hw(ip + 2) & 0xFFF;                          \
+        fast = ARCH_DEP(bbc_ ## _name);                              \
+    }
+
+#define BBC_RI(_name)                                                \
+    if (func == ARCH_DEP(_name))                                     \
+    {                                                                \
+        bbi->r1 = r1;                                                \
+        bbi->i2 = (S16)fetch_hw(ip + 2);                             \
+        fast = ARCH_DEP(bbc_ ## _name);                              \
+    }
+
+#define BBC_RRE(_name)                                               \
+    if (func == ARCH_DEP(_name))                                     \
+    {                                                                \
+        bbi->r1 = ip[3] >> 4;                                        \
+        bbi->r2 = ip[3] & 0x0F;                                      \
+        fast = ARCH_DEP(bbc_ ## _name);                              \
+    }
+
+#define BBC_RXY(_name)                                               \
+    if (func == ARCH_DEP(_name))                                     \
+    {                                                                \
+        bbi->r1 = r1;                                                \
+        bbi->r2 = r2;                                                \
+        bbi->b2 = ip[2] >> 4;                                        \
+        bbi->i2 = (ip[4] << 12) | (fetch_hw(ip + 2) & 0xFFF);        \
+        if (bbi->i2 & 0x80000)                                       \
+            bbi->i2 |= 0xFFF00000;                                   \
+        fast = ARCH_DEP(bbc_ ## _name);                              \
+    }
+
+    BBC_RR(load_register)
+    else BBC_RR(load_and_test_register)
+    else BBC_RR(add_register)
+    else BBC_RR(subtract_register)
+    else BBC_RX(load_address)
+    else BBC_RX(load)
+    else BBC_RX(store)
+    else BBC_RX(add)
+    else BBC_RX(branch_on_condition)
+    else BBC_RX(branch_on_count)
+    else if (r2 != 0)
+    {
+        BBC_RR(branch_on_condition_register)
+        else BBC_RR(branch_on_count_register)
+    }
+#if defined(FEATURE_IMMEDIATE_AND_RELATIVE)
+    if (fast == NULL)
+    {
+        BBC_RI(add_halfword_immediate)
+        else BBC_RI(load_halfword_immediate)
+        else BBC_RI(branch_relative_on_condition)
+        else BBC_RI(branch_relative_on_count)
+    }
+#endif /*defined(FEATURE_IMMEDIATE_AND_RELATIVE)*/
+#if defined(FEATURE_ESAME)
+    if (fast == NULL)
+    {
+        BBC_RRE(load_long_register)
+        else BBC_RRE(add_long_register)
+#if defined(FEATURE_LONG_DISPLACEMENT)
+        else BBC_RXY(load_long)
+        else BBC_RXY(store_long)
+#endif /*defined(FEATURE_LONG_DISPLACEMENT)*/
+    }
+#endif /*defined(FEATURE_ESAME)*/
+
+#undef BBC_RR
+#undef BBC_RX
+#undef BBC_RI
+#undef BBC_RRE
+#undef BBC_RXY
+
+    if (fast)
+    {
+        bbi->func = fast;
+        bbi->inst = (BYTE *)bbi;
+    }
+    else
+    {
+        bbi->func = func;
+        bbi->inst = ip;
+    }
+
+    /* Instructions which always branch or load a new PSW */
+    switch (ip[0]) {
+    case 0x05:                          /* BALR                      */
+    case 0x0B:                          /* BSM                       */
+    case 0x0C:                          /* BASSM                     */
+    case 0x0D:                          /* BASR                      */
+        return r2 != 0;
+    case 0x07:                          /* BCR                       */
+        return ip[1] >= 0xF1;
+    case 0x47:                          /* BC                        */
+        return ip[1] >= 0xF0;
+    case 0x0A:                          /* SVC                       */
+    case 0x45:                          /* BAL                       */
+    case 0x4D:                          /* BAS                       */
+    case 0x82:                          /* LPSW                      */
+        return 1;
+    case 0xA7:                          /* BRC, BRAS                 */
+        return (ip[1] & 0x0F) == 0x05
+            || ((ip[1] & 0x0F) == 0x04 && ip[1] >= 0xF0);
+    case 0xB2:                          /* LPSWE                     */
+        return ip[1] == 0xB2;
+    case 0xC0:                          /* BRCL, BRASL               */
+        return (ip[1] & 0x0F) == 0x05
+            || ((ip[1] & 0x0F) == 0x04 && ip[1] >= 0xF0);
+    }
+    return 0;
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Mark the lines of a frame as holding cached code                  */
+/*                                                                   */
+/* The other CPUs are stopped at an instruction boundary, so that no */
+/* store into the lines can be in progress, and if the frame held no */
+/* code then every TLB entry giving write access to it is removed.   */
+/*-------------------------------------------------------------------*/
+static void ARCH_DEP(bbc_protect) (REGS *regs, BBFRAME *frame, U64 lines)
+{
+BYTE   *main;                           /* -> Frame in mainstor      */
+int     i;                              /* CPU index                 */
+
+    OBTAIN_INTLOCK(regs);
+    SYNCHRONIZE_CPUS(regs);
+
+    obtain_lock (&sysblk.bbclock);
+    if (frame->hits < BBC_MAXHITS)
+    {
+        if (frame->code == 0)
+        {
+            main = sysblk.mainstor
+                 + ((RADR)(frame - sysblk.bbcframe) << BBC_FRAMESHIFT);
+            for (i = 0; i < HI_CPU; i++)
+                if (IS_CPU_ONLINE(i))
+                {
+                    ARCH_DEP(invalidate_tlbe) (sysblk.regs[i], main);
+#if !defined(FEATURE_S390_DAT) && !defined(FEATURE_ESAME)
+                    /* 2K pages are separate TLB entries */
+                    ARCH_DEP(invalidate_tlbe) (sysblk.regs[i], main + 2048);
+#endif
+                }
+        }
+        frame->code |= lines;
+    }
+    release_lock (&sysblk.bbclock);
+
+    RELEASE_INTLOCK(regs);
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Build a basic block cache entry                                   */
+/*                                                                   */
+/* The block starts at the current instruction and extends for at    */
+/* most BBC_MAXINST instructions, up to the end of the AIA page or   */
+/* an instruction which never continues sequentially.  The block is  */
+/* only added if the lines it was built from were already marked as  */
+/* holding code and nothing was stored into the frame meanwhile.     */
+/* Otherwise the lines are marked and the instructions are executed  */
+/* without the cache this time.  Returns 1 if the block was added.   */
+/*-------------------------------------------------------------------*/
+static int ARCH_DEP(build_block) (REGS *regs, BBLOCK *blk)
+{
+BBCACHE *bbc = regs->bbc;               /* -> Basic block cache      */
+BBFRAME *frame;                         /* -> Frame holding block    */
+BBINST  *bbi;                           /* -> Cached instruction     */
+BYTE    *ip;                            /* Instruction pointer       */
+RADR     aaddr;                         /* Absolute address of block */
+U64      lines;                         /* Lines holding the block   */
+U32      gen;                           /* Frame generation          */
+zz_func  func;                          /* Instruction function      */
+int      end = 0;                       /* 1=Block ends              */
+int      n;                             /* Number of instructions    */
+int      xoff;                          /* Extended opcode offset    */
+
+    aaddr = regs->ip - sysblk.mainstor;
+    frame = sysblk.bbcframe + (aaddr >> BBC_FRAMESHIFT);
+    if (frame->hits >= BBC_MAXHITS)
+        return 0;
+
+    blk->ip = NULL;
+
+    obtain_lock (&sysblk.bbclock);
+    gen = frame->gen;
+    release_lock (&sysblk.bbclock);
+
+    for (ip = regs->ip, bbi = blk->inst, n = 0;
+         !end && n < BBC_MAXINST && ip < regs->aie; n++, bbi++)
+    {
+        func = ARCH_DEP(resolve_opcode) (ip, regs, &xoff);
+        if (func == ARCH_DEP(operation_exception))
+            break;
+        end = ARCH_DEP(bbc_decode) (ip, bbi, func);
+        ip += ILC(ip[0]);
+        bbi->next = ip;
+    }
+
+    if (n == 0)
+        return 0;
+
+    lines = BBC_LINES(aaddr & ((1 << BBC_FRAMESHIFT) - 1),
+                      (ip - 1 - sysblk.mainstor) & ((1 << BBC_FRAMESHIFT) - 1));
+
+    obtain_lock (&sysblk.bbclock);
+    if (frame->gen == gen && (lines & ~frame->code) == 0)
+    {
+        blk->frame = frame;
+        blk->gen = gen;
+        blk->cgen = bbc->gen;
+        blk->count = n;
+        blk->ip = regs->ip;
+    }
+    release_lock (&sysblk.bbclock);
+
+    if (blk->ip == NULL)
+    {
+        ARCH_DEP(bbc_protect) (regs, frame, lines);
+        return 0;
+    }
+
+    return 1;
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Execute instructions from the basic block cache                   */
+/*                                                                   */
+/* The block at the current instruction is looked up, or built, and  */
+/* its instructions are executed until one does not continue with    */
+/* the next cached instruction.  Invalidating the AIA also ends the  */
+/* block: this is done by the store which discards the blocks built  */
+/* from the frame, and by anything which changes the translation of  */
+/* the instruction address.                                          */
+/*-------------------------------------------------------------------*/
+static void ARCH_DEP(execute_block) (REGS *regs)
+{
+BBCACHE *bbc = regs->bbc;               /* -> Basic block cache      */
+BBLOCK  *blk;                           /* -> Cached block           */
+BBINST  *bbi;                           /* -> Cached instruction     */
+BBINST  *end;                           /* -> End of block           */
+BYTE    *ip;                            /* Instruction pointer       */
+int      n;                             /* Instructions executed     */
+int      total = 0;                     /* Instructions in all blocks*/
+
+    /* Blocks are chained until as many instructions have been
+       executed as a block may hold, so that short loops do not
+       check for interrupts after every block */
+    do {
+        if (unlikely(regs->ip >= regs->aie))
+        {
+            regs->instcount += total + 1;
+            ip = INSTRUCTION_FETCH(regs, 0);
+            EXECUTE_INSTRUCTION(ip, regs);
+            return;
+        }
+
+        blk = bbc->blk + BBC_HASH(regs->ip);
+        if (likely(blk->ip == regs->ip
+                && blk->cgen == bbc->gen
+                && blk->gen == blk->frame->gen))
+            bbc->hits++;
+        else if (ARCH_DEP(build_block) (regs, blk))
+            bbc->misses++;
+        else
+        {
+            /* Execute without the cache, as long as the AIA remains
+               valid, since marking the frame may have invalidated it */
+            bbc->interp++;
+            for (n = 0; n < BBC_MAXINST && regs->ip < regs->aie; n++)
+                EXECUTE_INSTRUCTION(regs->ip, regs);
+            regs->instcount += total + n;
+            return;
+        }
+
+        end = blk->inst + blk->count;
+        do {
+            /* A block which loops to itself is executed again
+               without being looked up, while it remains valid */
+            bbi = blk->inst;
+            do {
+                FOOTPRINT(regs->ip, regs);
+                COUNT_INST(regs->ip, regs);
+                bbi->func (bbi->inst, regs);
+            } while (++bbi < end && regs->ip == bbi[-1].next && regs->aie);
+
+            total += bbi - blk->inst;
+        } while (regs->ip == blk->ip && total < BBC_MAXINST
+              && regs->aie && blk->gen == blk->frame->gen);
+    } while (total < BBC_MAXINST);
+
+    regs->instcount += total;
+}
+#endif /*defined(OPTION_BLOCK_CACHE)*/
+
 /*-------------------------------------------------------------------*/
 /* Run CPU                                                           */
 /*-------------------------------------------------------------------*/
@@ -1673,6 +2558,12 @@ REGS    regs;
         return oldregs;
     }
 
+#if defined(OPTION_BLOCK_CACHE)
+    /* Discard blocks resolved for another architecture */
+    if (regs.bbc)
+        regs.bbc->gen++;
+#endif /*defined(OPTION_BLOCK_CACHE)*/
+
     RELEASE_INTLOCK(&regs);
 
     /* Establish longjmp destination for program check */
@@ -1687,8 +2578,23 @@ REGS    regs;
 
         ip = INSTRUCTION_FETCH(&regs, 0);
         regs.instcount++;
+#if defined(OPTION_INSTRUCTION_PROFILE)
+        if (unlikely(regs.profsample))
+            ARCH_DEP(profile_instruction) (&regs, ip);
+        else
+#endif /*defined(OPTION_INSTRUCTION_PROFILE)*/
         EXECUTE_INSTRUCTION(ip, &regs);
 
+#if defined(OPTION_BLOCK_CACHE)
+        if (sysblk.blkcache && (regs.bbc || bbc_init(&regs) == 0))
+        {
+            do
+                ARCH_DEP(execute_block) (&regs);
+            while (!INTERRUPT_PENDING(&regs));
+            continue;
+        }
+#endif /*defined(OPTION_BLOCK_CACHE)*/
+
         do {
             UNROLLED_EXECUTE(&regs);
             UNROLLED_EXECUTE(&regs);
@@ -1733,6 +2639,12 @@ int     shouldstep = 0;                 /* 1=Wait for start command  */
     if (shouldtrace || shouldstep)
     {
         BYTE *ip = regs->ip < regs->aip ? regs->inst : regs->ip;
+#if defined(OPTION_TRACEBIN)
+        /* Record it instead if the binary trace is active */
+        if (sysblk.tracebin && !shouldstep)
+            ARCH_DEP(tracebin_inst) (regs, ip);
+        else
+#endif /*defined(OPTION_TRACEBIN)*/
         ARCH_DEP(display_inst) (regs, ip);
     }
 
@@ -41,6 +41,7 @@
 #include "opcode.h" /* For fetch_fw */
 
 #include "aes.h"
+#include "hwcrypt.h"
 
 #define FULL_UNROLL
 
@@ -1230,6 +1231,27 @@ rijndaelDecrypt(const u32 rk[/*4*(Nr + 1)*/], int Nr, const u8 ct[16],
  PUTU32(pt + 12, s3);
 }
 
+/* derive the round keys for the host AES instructions */
+static void
+rijndael_set_hwkeys(rijndael_ctx *ctx)
+{
+ int i;
+
+ ctx->hw = 0;
+#ifdef HWCRYPT_X86
+ if (!hwcrypt_aes)
+  return;
+ for (i = 0; i < 4 * (ctx->Nr + 1); i++) {
+  PUTU32(ctx->hwek + 4 * i, ctx->ek[i]);
+  if (!ctx->enc_only)
+   PUTU32(ctx->hwdk + 4 * i, ctx->dk[i]);
+ }
+ ctx->hw = 1;
+#else
+ UNREFERENCED(i);
+#endif
+}
+
 /* setup key context for encryption only */
 int
 rijndael_set_key_enc_only(rijndael_ctx *ctx, u_char *key, int bits)
@@ -1242,6 +1264,7 @@ rijndael_set_key_enc_only(rijndael_ctx *ctx, u_char *key, int bits)
 
  ctx->Nr = rounds;
  ctx->enc_only = 1;
+ rijndael_set_hwkeys(ctx);
 
  return 0;
 }
@@ -1260,6 +1283,7 @@ rijndael_set_key(rijndael_ctx *ctx, u_char *key, int bits)
 
  ctx->Nr = rounds;
  ctx->enc_only = 0;
+ rijndael_set_hwkeys(ctx);
 
  return 0;
 }
@@ -1267,12 +1291,116 @@ rijndael_set_key(rijndael_ctx *ctx, u_char *key, int bits)
 void
 rijndael_decrypt(rijndael_ctx *ctx, u_char *src, u_char *dst)
 {
+#ifdef HWCRYPT_X86
+ if (ctx->hw) {
+  if (src != dst)
+   memcpy(dst, src, 16);
+  hwaes_ecb_decrypt(ctx->hwdk, ctx->Nr, dst, 1);
+  return;
+ }
+#endif
  rijndaelDecrypt(ctx->dk, ctx->Nr, src, dst);
 }
 
 void
 rijndael_encrypt(rijndael_ctx *ctx, u_char *src, u_char *dst)
 {
+#ifdef HWCRYPT_X86
+ if (ctx->hw) {
+  if (src != dst)
+   memcpy(dst, src, 16);
+  hwaes_ecb_encrypt(ctx->hwek, ctx->Nr, dst, 1);
+  return;
+ }
+#endif
  rijndaelEncrypt(ctx->ek, ctx->Nr, src, dst);
 }
 
+/* Additional functions for dyncrypt, blocks are processed in place */
+
+void
+aes_encrypt_ecb(aes_context *ctx, u8 *buf, int blocks)
+{
+#ifdef HWCRYPT_X86
+ if (ctx->hw) {
+  hwaes_ecb_encrypt(ctx->hwek, ctx->Nr, buf, blocks);
+  return;
+ }
+#endif
+ for (; blocks > 0; blocks--, buf += 16)
+  rijndaelEncrypt(ctx->ek, ctx->Nr, buf, buf);
+}
+
+void
+aes_decrypt_ecb(aes_context *ctx, u8 *buf, int blocks)
+{
+#ifdef HWCRYPT_X86
+ if (ctx->hw) {
+  hwaes_ecb_decrypt(ctx->hwdk, ctx->Nr, buf, blocks);
+  return;
+ }
+#endif
+ for (; blocks > 0; blocks--, buf += 16)
+  rijndaelDecrypt(ctx->dk, ctx->Nr, buf, buf);
+}
+
+/* iv is replaced by the output chaining value */
+void
+aes_encrypt_cbc(aes_context *ctx, u8 *iv, u8 *buf, int blocks)
+{
+ int i;
+
+#ifdef HWCRYPT_X86
+ if (ctx->hw) {
+  hwaes_cbc_encrypt(ctx->hwek, ctx->Nr, iv, buf, blocks);
+  return;
+ }
+#endif
+ for (; blocks > 0; blocks--, buf += 16) {
+  for (i = 0; i < 16; i++)
+   buf[i] ^= iv[i];
+  rijndaelEncrypt(ctx->ek, ctx->Nr, buf, buf);
+  memcpy(iv, buf, 16);
+ }
+}
+
+void
+aes_decrypt_cbc(aes_context *ctx, u8 *iv, u8 *buf, int blocks)
+{
+ int i;
+ u8 cv[16];
+
+#ifdef HWCRYPT_X86
+ if (ctx->hw) {
+  hwaes_cbc_decrypt(ctx->hwdk, ctx->Nr, iv, buf, blocks);
+  return;
+ }
+#endif
+ for (; blocks > 0; blocks--, buf += 16) {
+  memcpy(cv, buf, 16);
+  rijndaelDecrypt(ctx->dk, ctx->Nr, buf, buf);
+  for (i = 0; i < 16; i++)
+   buf[i] ^= iv[i];
+  memcpy(iv, cv, 16);
+ }
+}
+
+/* ctr holds one counter block for each block, it may be overwritten */
+void
+aes_encrypt_ctr(aes_context *ctx, u8 *ctr, u8 *buf, int blocks)
+{
+ int i;
+
+#ifdef HWCRYPT_X86
+ if (ctx->hw) {
+  hwaes_ctr(ctx->hwek, ctx->Nr, ctr, buf, blocks);
+  return;
+ }
+#endif
+ for (; blocks > 0; blocks--, buf += 16, ctr += 16) {
+  rijndaelEncrypt(ctx->ek, ctx->Nr, ctr, ctr);
+  for (i = 0; i < 16; i++)
+   buf[i] ^= ctr[i];
+ }
+}
+
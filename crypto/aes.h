@@ -48,6 +48,9 @@ typedef struct {
         int     Nr;                     /* key-length-dependent number of rounds */
         u32     ek[4*(MAXNR + 1)];      /* encrypt key schedule */
         u32     dk[4*(MAXNR + 1)];      /* decrypt key schedule */
+        int     hw;                     /* host AES instructions usable */
+        u8      hwek[16*(MAXNR + 1)];   /* encrypt round keys, byte order */
+        u8      hwdk[16*(MAXNR + 1)];   /* decrypt round keys, byte order */
 } rijndael_ctx;
 
 int      rijndael_set_key(rijndael_ctx *, u_char *, int);
@@ -66,4 +69,11 @@ typedef rijndael_ctx    aes_context;
 #define aes_encrypt     rijndael_encrypt
 #define aes_decrypt     rijndael_decrypt
 
+/* Multiple 16 byte blocks in place */
+void     aes_encrypt_ecb(aes_context *, u8 *, int);
+void     aes_decrypt_ecb(aes_context *, u8 *, int);
+void     aes_encrypt_cbc(aes_context *, u8 *, u8 *, int);
+void     aes_decrypt_cbc(aes_context *, u8 *, u8 *, int);
+void     aes_encrypt_ctr(aes_context *, u8 *, u8 *, int);
+
 #endif /* __RIJNDAEL_H */
@@ -29,6 +29,7 @@
 #include "des.h"
 #include "sha1.h"
 #include "sha256.h"
+#include "hwcrypt.h"
 
 /*----------------------------------------------------------------------------*/
 /* Sanity compile check                                                       */
@@ -221,6 +222,14 @@
 /*----------------------------------------------------------------------------*/
 #define PROCESS_MAX        16384
 
+/*----------------------------------------------------------------------------*/
+/* Amount of data fetched and stored in one go by the AES and GHASH functions */
+/* Access exceptions may be recognized up to 4K beyond the current block, so  */
+/* the host kernels can work on several blocks between register updates.     */
+/*----------------------------------------------------------------------------*/
+#define PROCESS_CHUNK      256
+#define CHUNK_LEN(len)     ((int) ((len) < PROCESS_CHUNK ? (len) : PROCESS_CHUNK))
+
 /*----------------------------------------------------------------------------*/
 /* Used for printing debugging info                                           */
 /*----------------------------------------------------------------------------*/
@@ -1141,7 +1150,9 @@ static void ARCH_DEP(kimd_ghash)(int r1, int r2, REGS *regs)
 {
   int crypted;
   int i;
-  BYTE message_block[16];
+  int j;
+  BYTE message_block[PROCESS_CHUNK];
+  int n;
   BYTE parameter_block[32];
 
   UNREFERENCED(r1);
@@ -1169,19 +1180,28 @@ static void ARCH_DEP(kimd_ghash)(int r1, int r2, REGS *regs)
 #endif /* #ifdef OPTION_KIMD_DEBUG */
 
   /* Try to process the CPU-determined amount of data */
-  for(crypted = 0; crypted < PROCESS_MAX; crypted += 16)
+  for(crypted = 0; crypted < PROCESS_MAX; crypted += n)
   {
-    /* Fetch and process a block of data */
-    ARCH_DEP(vfetchc)(message_block, 15, GR_A(r2, regs) & ADDRESS_MAXWRAP(regs), r2, regs);
+    /* Fetch and process up to 16 blocks of data */
+    n = CHUNK_LEN(GR_A(r2 + 1, regs));
+    ARCH_DEP(vfetchc)(message_block, n - 1, GR_A(r2, regs) & ADDRESS_MAXWRAP(regs), r2, regs);
 
 #ifdef OPTION_KIMD_DEBUG
-    LOGBYTE("input :", message_block, 16);
+    LOGBYTE2("input :", message_block, 16, n / 16);
 #endif /* #ifdef OPTION_KIMD_DEBUG */
 
     /* XOR and multiply */
-    for(i = 0; i < 16; i++)
-      parameter_block[i] ^= message_block[i];
-    gcm_gf_mult(parameter_block, &parameter_block[16], parameter_block);
+#ifdef HWCRYPT_X86
+    if(hwcrypt_clmul)
+      hwghash(parameter_block, &parameter_block[16], message_block, n / 16);
+    else
+#endif /* #ifdef HWCRYPT_X86 */
+    for(j = 0; j < n; j += 16)
+    {
+      for(i = 0; i < 16; i++)
+        parameter_block[i] ^= message_block[j + i];
+      gcm_gf_mult(parameter_block, &parameter_block[16], parameter_block);
+    }
 
     /* Store the output chaining value */
     ARCH_DEP(vstorec)(parameter_block, 15, GR_A(1, regs) & ADDRESS_MAXWRAP(regs), 1, regs);
@@ -1191,8 +1211,8 @@ static void ARCH_DEP(kimd_ghash)(int r1, int r2, REGS *regs)
 #endif /* #ifdef OPTION_KIMD_DEBUG */
 
     /* Update the registers */
-    SET_GR_A(r2, regs, GR_A(r2, regs) + 16);
-    SET_GR_A(r2 + 1, regs, GR_A(r2 + 1, regs) - 16);
+    SET_GR_A(r2, regs, GR_A(r2, regs) + n);
+    SET_GR_A(r2 + 1, regs, GR_A(r2 + 1, regs) - n);
 
 #ifdef OPTION_KIMD_DEBUG
     logmsg("  GR%02d  : " F_GREG "\n", r2, (regs)->GR(r2));
@@ -1613,8 +1633,9 @@ static void ARCH_DEP(km_aes)(int r1, int r2, REGS *regs)
   aes_context context;
   int crypted;
   int keylen;
-  BYTE message_block[16];
+  BYTE message_block[PROCESS_CHUNK];
   int modifier_bit;
+  int n;
   BYTE parameter_block[64];
   int parameter_blocklen;
   int r1_is_not_r2;
@@ -1669,33 +1690,34 @@ static void ARCH_DEP(km_aes)(int r1, int r2, REGS *regs)
   /* Try to process the CPU-determined amount of data */
   modifier_bit = GR0_m(regs);
   r1_is_not_r2 = r1 != r2;
-  for(crypted = 0; crypted < PROCESS_MAX; crypted += 16)
+  for(crypted = 0; crypted < PROCESS_MAX; crypted += n)
   {
-    /* Fetch a block of data */
-    ARCH_DEP(vfetchc)(message_block, 15, GR_A(r2, regs) & ADDRESS_MAXWRAP(regs), r2, regs);
+    /* Fetch up to 16 blocks of data */
+    n = CHUNK_LEN(GR_A(r2 + 1, regs));
+    ARCH_DEP(vfetchc)(message_block, n - 1, GR_A(r2, regs) & ADDRESS_MAXWRAP(regs), r2, regs);
 
 #ifdef OPTION_KM_DEBUG
-    LOGBYTE("input :", message_block, 16);
+    LOGBYTE2("input :", message_block, 16, n / 16);
 #endif /* #ifdef OPTION_KM_DEBUG */
 
     /* Do the job */
     if(modifier_bit)
-      aes_decrypt(&context, message_block, message_block);
+      aes_decrypt_ecb(&context, message_block, n / 16);
     else
-      aes_encrypt(&context, message_block, message_block);
+      aes_encrypt_ecb(&context, message_block, n / 16);
 
     /* Store the output */
-    ARCH_DEP(vstorec)(message_block, 15, GR_A(r1, regs) & ADDRESS_MAXWRAP(regs), r1, regs);
+    ARCH_DEP(vstorec)(message_block, n - 1, GR_A(r1, regs) & ADDRESS_MAXWRAP(regs), r1, regs);
 
 #ifdef OPTION_KM_DEBUG
-    LOGBYTE("output:", message_block, 16);
+    LOGBYTE2("output:", message_block, 16, n / 16);
 #endif /* #ifdef OPTION_KM_DEBUG */
 
     /* Update the registers */
-    SET_GR_A(r1, regs, GR_A(r1, regs) + 16);
+    SET_GR_A(r1, regs, GR_A(r1, regs) + n);
     if(likely(r1_is_not_r2))
-      SET_GR_A(r2, regs, GR_A(r2, regs) + 16);
-    SET_GR_A(r2 + 1, regs, GR_A(r2 + 1, regs) - 16);
+      SET_GR_A(r2, regs, GR_A(r2, regs) + n);
+    SET_GR_A(r2 + 1, regs, GR_A(r2 + 1, regs) - n);
 
 #ifdef OPTION_KM_DEBUG
     logmsg("  GR%02d  : " F_GREG "\n", r1, (regs)->GR(r1));
@@ -2370,11 +2392,10 @@ static void ARCH_DEP(kmc_aes)(int r1, int r2, REGS *regs)
 {
   aes_context context;
   int crypted;
-  int i;
   int keylen;
-  BYTE message_block[16];
+  BYTE message_block[PROCESS_CHUNK];
   int modifier_bit;
-  BYTE ocv[16];
+  int n;
   BYTE parameter_block[80];
   int parameter_blocklen;
   int r1_is_not_r2;
@@ -2433,53 +2454,41 @@ static void ARCH_DEP(kmc_aes)(int r1, int r2, REGS *regs)
   /* Try to process the CPU-determined amount of data */
   modifier_bit = GR0_m(regs);
   r1_is_not_r2 = r1 != r2;
-  for(crypted = 0; crypted < PROCESS_MAX; crypted += 16)
+  for(crypted = 0; crypted < PROCESS_MAX; crypted += n)
   {
-    /* Fetch a block of data */
-    ARCH_DEP(vfetchc)(message_block, 15, GR_A(r2, regs) & ADDRESS_MAXWRAP(regs), r2, regs);
+    /* Fetch up to 16 blocks of data */
+    n = CHUNK_LEN(GR_A(r2 + 1, regs));
+    ARCH_DEP(vfetchc)(message_block, n - 1, GR_A(r2, regs) & ADDRESS_MAXWRAP(regs), r2, regs);
 
 #ifdef OPTION_KMC_DEBUG
-    LOGBYTE("input :", message_block, 16);
+    LOGBYTE2("input :", message_block, 16, n / 16);
 #endif /* #ifdef OPTION_KMC_DEBUG */
 
-    /* Do the job */
+    /* Do the job, the chaining value is replaced by the ocv */
     if(modifier_bit)
-    {
-
-      /* Save, decrypt and XOR */
-      memcpy(ocv, message_block, 16);
-      aes_decrypt(&context, message_block, message_block);
-      for(i = 0; i < 16; i++)
-        message_block[i] ^= parameter_block[i];
-    }
+      aes_decrypt_cbc(&context, parameter_block, message_block, n / 16);
     else
-    {
-      /* XOR, encrypt and save */
-      for(i = 0; i < 16; i++)
-        message_block[i] ^= parameter_block[i];
-      aes_encrypt(&context, message_block, message_block);
-      memcpy(ocv, message_block, 16);
-    }
+      aes_encrypt_cbc(&context, parameter_block, message_block, n / 16);
 
     /* Store the output */
-    ARCH_DEP(vstorec)(message_block, 15, GR_A(r1, regs) & ADDRESS_MAXWRAP(regs), r1, regs);
+    ARCH_DEP(vstorec)(message_block, n - 1, GR_A(r1, regs) & ADDRESS_MAXWRAP(regs), r1, regs);
 
 #ifdef OPTION_KMC_DEBUG
-    LOGBYTE("output:", message_block, 16);
+    LOGBYTE2("output:", message_block, 16, n / 16);
 #endif /* #ifdef OPTION_KMC_DEBUG */
 
     /* Store the output chaining value */
-    ARCH_DEP(vstorec)(ocv, 15, GR_A(1, regs) & ADDRESS_MAXWRAP(regs), 1, regs);
+    ARCH_DEP(vstorec)(parameter_block, 15, GR_A(1, regs) & ADDRESS_MAXWRAP(regs), 1, regs);
 
 #ifdef OPTION_KMC_DEBUG
-    LOGBYTE("ocv   :", ocv, 16);
+    LOGBYTE("ocv   :", parameter_block, 16);
 #endif /* #ifdef OPTION_KMC_DEBUG */
 
     /* Update the registers */
-    SET_GR_A(r1, regs, GR_A(r1, regs) + 16);
+    SET_GR_A(r1, regs, GR_A(r1, regs) + n);
     if(likely(r1_is_not_r2))
-      SET_GR_A(r2, regs, GR_A(r2, regs) + 16);
-    SET_GR_A(r2 + 1, regs, GR_A(r2 + 1, regs) - 16);
+      SET_GR_A(r2, regs, GR_A(r2, regs) + n);
+    SET_GR_A(r2 + 1, regs, GR_A(r2 + 1, regs) - n);
 
 #ifdef OPTION_KMC_DEBUG
     logmsg("  GR%02d  : " F_GREG "\n", r1, (regs)->GR(r1));
@@ -2493,9 +2502,6 @@ static void ARCH_DEP(kmc_aes)(int r1, int r2, REGS *regs)
       regs->psw.cc = 0;
       return;
     }
-
-    /* Set cv for next 16 bytes */
-    memcpy(parameter_block, ocv, 16);
   }
 
   /* CPU-determined amount of data processed */
@@ -2818,11 +2824,11 @@ static void ARCH_DEP(kmctr_dea)(int r1, int r2, int r3, REGS *regs)
 static void ARCH_DEP(kmctr_aes)(int r1, int r2, int r3, REGS *regs)
 {
   aes_context context;
-  BYTE countervalue_block[16];  
+  BYTE countervalue_block[PROCESS_CHUNK];
   int crypted;
-  int i;
   int keylen;
-  BYTE message_block[16];
+  BYTE message_block[PROCESS_CHUNK];
+  int n;
   BYTE parameter_block[64];
   int parameter_blocklen;
   int r1_is_not_r2;
@@ -2877,37 +2883,36 @@ static void ARCH_DEP(kmctr_aes)(int r1, int r2, int r3, REGS *regs)
   r1_is_not_r2 = r1 != r2;
   r1_is_not_r3 = r1 != r3;
   r2_is_not_r3 = r1 != r2;
-  for(crypted = 0; crypted < PROCESS_MAX; crypted += 16)
+  for(crypted = 0; crypted < PROCESS_MAX; crypted += n)
   {
-    /* Fetch a block of data and counter-value */
-    ARCH_DEP(vfetchc)(message_block, 15, GR_A(r2, regs) & ADDRESS_MAXWRAP(regs), r2, regs);
-    ARCH_DEP(vfetchc)(countervalue_block, 15, GR_A(r3, regs) & ADDRESS_MAXWRAP(regs), r3, regs);
+    /* Fetch up to 16 blocks of data and counter-values */
+    n = CHUNK_LEN(GR_A(r2 + 1, regs));
+    ARCH_DEP(vfetchc)(message_block, n - 1, GR_A(r2, regs) & ADDRESS_MAXWRAP(regs), r2, regs);
+    ARCH_DEP(vfetchc)(countervalue_block, n - 1, GR_A(r3, regs) & ADDRESS_MAXWRAP(regs), r3, regs);
 
 #ifdef OPTION_KMCTR_DEBUG
-    LOGBYTE("input :", message_block, 16);
-    LOGBYTE("cv    :", countervalue_block, 16);
+    LOGBYTE2("input :", message_block, 16, n / 16);
+    LOGBYTE2("cv    :", countervalue_block, 16, n / 16);
 #endif /* #ifdef OPTION_KMCTR_DEBUG */
 
     /* Do the job */
     /* Encrypt and XOR */
-    aes_encrypt(&context, countervalue_block, countervalue_block);
-    for(i = 0; i < 16; i++)
-      countervalue_block[i] ^= message_block[i];
+    aes_encrypt_ctr(&context, countervalue_block, message_block, n / 16);
 
     /* Store the output */
-    ARCH_DEP(vstorec)(countervalue_block, 15, GR_A(r1, regs) & ADDRESS_MAXWRAP(regs), r1, regs);
+    ARCH_DEP(vstorec)(message_block, n - 1, GR_A(r1, regs) & ADDRESS_MAXWRAP(regs), r1, regs);
 
 #ifdef OPTION_KMCTR_DEBUG
-    LOGBYTE("output:", countervalue_block, 16);
+    LOGBYTE2("output:", message_block, 16, n / 16);
 #endif /* #ifdef OPTION_KMCTR_DEBUG */
 
     /* Update the registers */
-    SET_GR_A(r1, regs, GR_A(r1, regs) + 16);
+    SET_GR_A(r1, regs, GR_A(r1, regs) + n);
     if(likely(r1_is_not_r2))
-      SET_GR_A(r2, regs, GR_A(r2, regs) + 16);
-    SET_GR_A(r2 + 1, regs, GR_A(r2 + 1, regs) - 16);
+      SET_GR_A(r2, regs, GR_A(r2, regs) + n);
+    SET_GR_A(r2 + 1, regs, GR_A(r2 + 1, regs) - n);
     if(likely(r1_is_not_r3 && r2_is_not_r3))
-      SET_GR_A(r3, regs, GR_A(r3, regs) + 16);
+      SET_GR_A(r3, regs, GR_A(r3, regs) + n);
 
 #ifdef OPTION_KMCTR_DEBUG
     logmsg("  GR%02d  : " F_GREG "\n", r1, (regs)->GR(r1));
@@ -4958,6 +4963,8 @@ HDL_REGISTER_SECTION;
   HDL_REGISTER(z900_perform_cryptographic_key_management_operation, z900_perform_cryptographic_key_management_operation_d);
 #endif /*defined(_900_FEATURE_MESSAGE_SECURITY_ASSIST)*/
 
+  hwcrypt_init();
+
   logmsg("Crypto module loaded (c) Copyright Bernard van der Helm, 2003-2010\n");
   logmsg("  Active: Message Security Assist\n");
 #ifdef FEATURE_MESSAGE_SECURITY_ASSIST_EXTENSION_1
@@ -4972,6 +4979,9 @@ HDL_REGISTER_SECTION;
 #ifdef FEATURE_MESSAGE_SECURITY_ASSIST_EXTENSION_4
   logmsg("          Message Security Assist Extension 4\n");
 #endif
+  if(hwcrypt_aes || hwcrypt_clmul || hwcrypt_sha)
+    logmsg("  Host:   %s%s%s\n", hwcrypt_aes ? "AES-NI " : "",
+      hwcrypt_clmul ? "PCLMULQDQ " : "", hwcrypt_sha ? "SHA" : "");
 }
 END_REGISTER_SECTION;
 
@@ -0,0 +1,419 @@
+/* HWCRYPT.C    (c) Copyright The Hercules Project, 2026             */
+/*              Host processor crypto instructions for dyncrypt      */
+
+/*   Released under the Q Public License                             */
+/*      (http://www.hercules-390.org/herclic.html)                   */
+/*   as modifications to Hercules.                                   */
+
+// $Id$
+
+/*-------------------------------------------------------------------*/
+/* This module contains the AES, GHASH, SHA-1 and SHA-256 kernels    */
+/* used by dyncrypt on x86 hosts that have the AES-NI, PCLMULQDQ and */
+/* SHA extensions.  hwcrypt_init tests the host processor when the   */
+/* crypto module is loaded; the portable routines in aes.c, sha1.c,  */
+/* sha256.c and dyncrypt.c are used for anything the host lacks.     */
+/*                                                                   */
+/* The AES kernels work on round keys in byte order, which aes.c     */
+/* derives from its own key schedules.  The decryption schedule of   */
+/* aes.c is already the equivalent inverse cipher schedule that the  */
+/* AESDEC instruction expects.  ECB, CBC decryption and CTR process  */
+/* four blocks at a time to hide the latency of the AES rounds;      */
+/* CBC encryption is inherently serial.                              */
+/*-------------------------------------------------------------------*/
+
+#include "hstdinc.h"
+#include "hwcrypt.h"
+
+int hwcrypt_aes;
+int hwcrypt_clmul;
+int hwcrypt_sha;
+
+#if defined(HWCRYPT_X86)
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+#define TARGET_AES    __attribute__ ((target ("aes,sse2")))
+#define TARGET_CLMUL  __attribute__ ((target ("pclmul,ssse3")))
+#define TARGET_SHA    __attribute__ ((target ("sha,sse4.1")))
+
+/*-------------------------------------------------------------------*/
+/* Test the host processor                                           */
+/*-------------------------------------------------------------------*/
+void hwcrypt_init(void)
+{
+unsigned int eax, ebx, ecx, edx;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return;
+    hwcrypt_aes   = (ecx & (1 << 25)) != 0;
+    hwcrypt_clmul = (ecx & (1 << 1)) != 0 && (ecx & (1 << 9)) != 0;
+    if ((ecx & (1 << 19)) != 0 && __get_cpuid_max(0, NULL) >= 7)
+    {
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        hwcrypt_sha = (ebx & (1 << 29)) != 0;
+    }
+}
+
+/*-------------------------------------------------------------------*/
+/* AES                                                               */
+/*-------------------------------------------------------------------*/
+#define LOAD_KEYS(_k, _rk, _nr) \
+do { \
+    int _i; \
+    for (_i = 0; _i <= (_nr); _i++) \
+        (_k)[_i] = _mm_loadu_si128((const __m128i *)((_rk) + 16 * _i)); \
+} while (0)
+
+#define ENC4(_k, _nr, _b0, _b1, _b2, _b3) \
+do { \
+    int _r; \
+    _b0 = _mm_xor_si128(_b0, (_k)[0]); \
+    _b1 = _mm_xor_si128(_b1, (_k)[0]); \
+    _b2 = _mm_xor_si128(_b2, (_k)[0]); \
+    _b3 = _mm_xor_si128(_b3, (_k)[0]); \
+    for (_r = 1; _r < (_nr); _r++) \
+    { \
+        _b0 = _mm_aesenc_si128(_b0, (_k)[_r]); \
+        _b1 = _mm_aesenc_si128(_b1, (_k)[_r]); \
+        _b2 = _mm_aesenc_si128(_b2, (_k)[_r]); \
+        _b3 = _mm_aesenc_si128(_b3, (_k)[_r]); \
+    } \
+    _b0 = _mm_aesenclast_si128(_b0, (_k)[_nr]); \
+    _b1 = _mm_aesenclast_si128(_b1, (_k)[_nr]); \
+    _b2 = _mm_aesenclast_si128(_b2, (_k)[_nr]); \
+    _b3 = _mm_aesenclast_si128(_b3, (_k)[_nr]); \
+} while (0)
+
+#define DEC4(_k, _nr, _b0, _b1, _b2, _b3) \
+do { \
+    int _r; \
+    _b0 = _mm_xor_si128(_b0, (_k)[0]); \
+    _b1 = _mm_xor_si128(_b1, (_k)[0]); \
+    _b2 = _mm_xor_si128(_b2, (_k)[0]); \
+    _b3 = _mm_xor_si128(_b3, (_k)[0]); \
+    for (_r = 1; _r < (_nr); _r++) \
+    { \
+        _b0 = _mm_aesdec_si128(_b0, (_k)[_r]); \
+        _b1 = _mm_aesdec_si128(_b1, (_k)[_r]); \
+        _b2 = _mm_aesdec_si128(_b2, (_k)[_r]); \
+        _b3 = _mm_aesdec_si128(_b3, (_k)[_r]); \
+    } \
+    _b0 = _mm_aesdeclast_si128(_b0, (_k)[_nr]); \
+    _b1 = _mm_aesdeclast_si128(_b1, (_k)[_nr]); \
+    _b2 = _mm_aesdeclast_si128(_b2, (_k)[_nr]); \
+    _b3 = _mm_aesdeclast_si128(_b3, (_k)[_nr]); \
+} while (0)
+
+static inline __m128i TARGET_AES enc1(const __m128i *k, int nr, __m128i b)
+{
+int r;
+
+    b = _mm_xor_si128(b, k[0]);
+    for (r = 1; r < nr; r++)
+        b = _mm_aesenc_si128(b, k[r]);
+    return _mm_aesenclast_si128(b, k[nr]);
+}
+
+static inline __m128i TARGET_AES dec1(const __m128i *k, int nr, __m128i b)
+{
+int r;
+
+    b = _mm_xor_si128(b, k[0]);
+    for (r = 1; r < nr; r++)
+        b = _mm_aesdec_si128(b, k[r]);
+    return _mm_aesdeclast_si128(b, k[nr]);
+}
+
+#define LOADU(_p)       _mm_loadu_si128((const __m128i *)(_p))
+#define STOREU(_p, _v)  _mm_storeu_si128((__m128i *)(_p), (_v))
+
+void TARGET_AES hwaes_ecb_encrypt(const unsigned char *rk, int Nr,
+                                  unsigned char *buf, int blocks)
+{
+__m128i k[15], b0, b1, b2, b3;
+
+    LOAD_KEYS(k, rk, Nr);
+    for (; blocks >= 4; blocks -= 4, buf += 64)
+    {
+        b0 = LOADU(buf);      b1 = LOADU(buf + 16);
+        b2 = LOADU(buf + 32); b3 = LOADU(buf + 48);
+        ENC4(k, Nr, b0, b1, b2, b3);
+        STOREU(buf, b0);      STOREU(buf + 16, b1);
+        STOREU(buf + 32, b2); STOREU(buf + 48, b3);
+    }
+    for (; blocks > 0; blocks--, buf += 16)
+        STOREU(buf, enc1(k, Nr, LOADU(buf)));
+}
+
+void TARGET_AES hwaes_ecb_decrypt(const unsigned char *rk, int Nr,
+                                  unsigned char *buf, int blocks)
+{
+__m128i k[15], b0, b1, b2, b3;
+
+    LOAD_KEYS(k, rk, Nr);
+    for (; blocks >= 4; blocks -= 4, buf += 64)
+    {
+        b0 = LOADU(buf);      b1 = LOADU(buf + 16);
+        b2 = LOADU(buf + 32); b3 = LOADU(buf + 48);
+        DEC4(k, Nr, b0, b1, b2, b3);
+        STOREU(buf, b0);      STOREU(buf + 16, b1);
+        STOREU(buf + 32, b2); STOREU(buf + 48, b3);
+    }
+    for (; blocks > 0; blocks--, buf += 16)
+        STOREU(buf, dec1(k, Nr, LOADU(buf)));
+}
+
+void TARGET_AES hwaes_cbc_encrypt(const unsigned char *rk, int Nr,
+                                  unsigned char iv[16],
+                                  unsigned char *buf, int blocks)
+{
+__m128i k[15], v;
+
+    LOAD_KEYS(k, rk, Nr);
+    v = LOADU(iv);
+    for (; blocks > 0; blocks--, buf += 16)
+    {
+        v = enc1(k, Nr, _mm_xor_si128(v, LOADU(buf)));
+        STOREU(buf, v);
+    }
+    STOREU(iv, v);
+}
+
+void TARGET_AES hwaes_cbc_decrypt(const unsigned char *rk, int Nr,
+                                  unsigned char iv[16],
+                                  unsigned char *buf, int blocks)
+{
+__m128i k[15], v, c0, c1, c2, c3, b0, b1, b2, b3;
+
+    LOAD_KEYS(k, rk, Nr);
+    v = LOADU(iv);
+    for (; blocks >= 4; blocks -= 4, buf += 64)
+    {
+        b0 = c0 = LOADU(buf);      b1 = c1 = LOADU(buf + 16);
+        b2 = c2 = LOADU(buf + 32); b3 = c3 = LOADU(buf + 48);
+        DEC4(k, Nr, b0, b1, b2, b3);
+        STOREU(buf,      _mm_xor_si128(b0, v));
+        STOREU(buf + 16, _mm_xor_si128(b1, c0));
+        STOREU(buf + 32, _mm_xor_si128(b2, c1));
+        STOREU(buf + 48, _mm_xor_si128(b3, c2));
+        v = c3;
+    }
+    for (; blocks > 0; blocks--, buf += 16)
+    {
+        c0 = LOADU(buf);
+        STOREU(buf, _mm_xor_si128(dec1(k, Nr, c0), v));
+        v = c0;
+    }
+    STOREU(iv, v);
+}
+
+void TARGET_AES hwaes_ctr(const unsigned char *rk, int Nr,
+                          const unsigned char *ctr,
+                          unsigned char *buf, int blocks)
+{
+__m128i k[15], b0, b1, b2, b3;
+
+    LOAD_KEYS(k, rk, Nr);
+    for (; blocks >= 4; blocks -= 4, buf += 64, ctr += 64)
+    {
+        b0 = LOADU(ctr);      b1 = LOADU(ctr + 16);
+        b2 = LOADU(ctr + 32); b3 = LOADU(ctr + 48);
+        ENC4(k, Nr, b0, b1, b2, b3);
+        STOREU(buf,      _mm_xor_si128(b0, LOADU(buf)));
+        STOREU(buf + 16, _mm_xor_si128(b1, LOADU(buf + 16)));
+        STOREU(buf + 32, _mm_xor_si128(b2, LOADU(buf + 32)));
+        STOREU(buf + 48, _mm_xor_si128(b3, LOADU(buf + 48)));
+    }
+    for (; blocks > 0; blocks--, buf += 16, ctr += 16)
+        STOREU(buf, _mm_xor_si128(enc1(k, Nr, LOADU(ctr)), LOADU(buf)));
+}
+
+/*-------------------------------------------------------------------*/
+/* GHASH                                                             */
+/*                                                                   */
+/* The operands are byte reversed so that the carry-less multiply    */
+/* sees the bit reflected GCM polynomial as in the Intel white paper */
+/* "Carry-Less Multiplication and Its Usage for Computing the GCM    */
+/* Mode"; the 256 bit product is shifted left one bit and reduced.   */
+/*-------------------------------------------------------------------*/
+static inline __m128i TARGET_CLMUL gfmul(__m128i a, __m128i b)
+{
+__m128i lo, mid, hi, t, u, v;
+
+    lo  = _mm_clmulepi64_si128(a, b, 0x00);
+    mid = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x10),
+                        _mm_clmulepi64_si128(a, b, 0x01));
+    hi  = _mm_clmulepi64_si128(a, b, 0x11);
+    lo  = _mm_xor_si128(lo, _mm_slli_si128(mid, 8));
+    hi  = _mm_xor_si128(hi, _mm_srli_si128(mid, 8));
+
+    /* Shift the product <hi:lo> left one bit */
+    t  = _mm_srli_epi32(lo, 31);
+    u  = _mm_srli_epi32(hi, 31);
+    lo = _mm_slli_epi32(lo, 1);
+    hi = _mm_slli_epi32(hi, 1);
+    v  = _mm_srli_si128(t, 12);
+    u  = _mm_slli_si128(u, 4);
+    t  = _mm_slli_si128(t, 4);
+    lo = _mm_or_si128(lo, t);
+    hi = _mm_or_si128(hi, u);
+    hi = _mm_or_si128(hi, v);
+
+    /* Reduce modulo x^128 + x^7 + x^2 + x + 1 */
+    t  = _mm_xor_si128(_mm_xor_si128(_mm_slli_epi32(lo, 31),
+                                     _mm_slli_epi32(lo, 30)),
+                       _mm_slli_epi32(lo, 25));
+    u  = _mm_srli_si128(t, 4);
+    t  = _mm_slli_si128(t, 12);
+    lo = _mm_xor_si128(lo, t);
+    v  = _mm_xor_si128(_mm_xor_si128(_mm_srli_epi32(lo, 1),
+                                     _mm_srli_epi32(lo, 2)),
+                       _mm_srli_epi32(lo, 7));
+    v  = _mm_xor_si128(v, u);
+    lo = _mm_xor_si128(lo, v);
+    return _mm_xor_si128(hi, lo);
+}
+
+void TARGET_CLMUL hwghash(unsigned char x[16], const unsigned char h[16],
+                          const unsigned char *buf, int blocks)
+{
+const __m128i rev = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7,
+                                 8, 9, 10, 11, 12, 13, 14, 15);
+__m128i y, hh;
+
+    y  = _mm_shuffle_epi8(LOADU(x), rev);
+    hh = _mm_shuffle_epi8(LOADU(h), rev);
+    for (; blocks > 0; blocks--, buf += 16)
+        y = gfmul(_mm_xor_si128(y, _mm_shuffle_epi8(LOADU(buf), rev)), hh);
+    STOREU(x, _mm_shuffle_epi8(y, rev));
+}
+
+/*-------------------------------------------------------------------*/
+/* SHA-1                                                             */
+/*                                                                   */
+/* Message word group g (four words) is w[g % 4]; groups 4 to 19     */
+/* are expanded in place just before they are used.                  */
+/*-------------------------------------------------------------------*/
+void TARGET_SHA hwsha1(unsigned int state[5], const unsigned char *data,
+                       int blocks)
+{
+const __m128i rev = _mm_set_epi64x(0x0001020304050607ULL,
+                                   0x08090a0b0c0d0e0fULL);
+__m128i abcd, abcd_save, e0, e0_save, e, prev, w[4];
+int g;
+
+    abcd = _mm_shuffle_epi32(LOADU(state), 0x1B);
+    e0 = _mm_set_epi32((int)state[4], 0, 0, 0);
+
+    for (; blocks > 0; blocks--, data += 64)
+    {
+        abcd_save = abcd;
+        e0_save = e0;
+        for (g = 0; g < 4; g++)
+            w[g] = _mm_shuffle_epi8(LOADU(data + 16 * g), rev);
+
+        prev = abcd;
+        for (g = 0; g < 20; g++)
+        {
+            if (g >= 4)
+                w[g % 4] = _mm_sha1msg2_epu32(
+                             _mm_xor_si128(
+                               _mm_sha1msg1_epu32(w[g % 4], w[(g + 1) % 4]),
+                               w[(g + 2) % 4]),
+                             w[(g + 3) % 4]);
+            if (g == 0)
+                e = _mm_add_epi32(e0, w[0]);
+            else
+                e = _mm_sha1nexte_epu32(prev, w[g % 4]);
+            prev = abcd;
+            switch (g / 5) {
+            case 0:  abcd = _mm_sha1rnds4_epu32(abcd, e, 0); break;
+            case 1:  abcd = _mm_sha1rnds4_epu32(abcd, e, 1); break;
+            case 2:  abcd = _mm_sha1rnds4_epu32(abcd, e, 2); break;
+            default: abcd = _mm_sha1rnds4_epu32(abcd, e, 3); break;
+            }
+        }
+
+        e0 = _mm_sha1nexte_epu32(prev, e0_save);
+        abcd = _mm_add_epi32(abcd, abcd_save);
+    }
+
+    STOREU(state, _mm_shuffle_epi32(abcd, 0x1B));
+    state[4] = (unsigned int)_mm_extract_epi32(e0, 3);
+}
+
+/*-------------------------------------------------------------------*/
+/* SHA-256                                                           */
+/*-------------------------------------------------------------------*/
+static const unsigned int sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+void TARGET_SHA hwsha256(unsigned int state[8], const unsigned char *data,
+                         int blocks)
+{
+const __m128i rev = _mm_set_epi64x(0x0c0d0e0f08090a0bULL,
+                                   0x0405060700010203ULL);
+__m128i abef, cdgh, abef_save, cdgh_save, t, m, w[4];
+int g;
+
+    /* Rearrange the state words a..h into ABEF and CDGH */
+    t    = _mm_shuffle_epi32(LOADU(state), 0xB1);
+    cdgh = _mm_shuffle_epi32(LOADU(state + 4), 0x1B);
+    abef = _mm_alignr_epi8(t, cdgh, 8);
+    cdgh = _mm_blend_epi16(cdgh, t, 0xF0);
+
+    for (; blocks > 0; blocks--, data += 64)
+    {
+        abef_save = abef;
+        cdgh_save = cdgh;
+        for (g = 0; g < 4; g++)
+            w[g] = _mm_shuffle_epi8(LOADU(data + 16 * g), rev);
+
+        for (g = 0; g < 16; g++)
+        {
+            if (g >= 4)
+                w[g % 4] = _mm_sha256msg2_epu32(
+                             _mm_add_epi32(
+                               _mm_sha256msg1_epu32(w[g % 4], w[(g + 1) % 4]),
+                               _mm_alignr_epi8(w[(g + 3) % 4], w[(g + 2) % 4], 4)),
+                             w[(g + 3) % 4]);
+            m = _mm_add_epi32(w[g % 4], LOADU(&sha256_k[4 * g]));
+            cdgh = _mm_sha256rnds2_epu32(cdgh, abef, m);
+            abef = _mm_sha256rnds2_epu32(abef, cdgh, _mm_shuffle_epi32(m, 0x0E));
+        }
+
+        abef = _mm_add_epi32(abef, abef_save);
+        cdgh = _mm_add_epi32(cdgh, cdgh_save);
+    }
+
+    t    = _mm_shuffle_epi32(abef, 0x1B);
+    cdgh = _mm_shuffle_epi32(cdgh, 0xB1);
+    STOREU(state, _mm_blend_epi16(t, cdgh, 0xF0));
+    STOREU(state + 4, _mm_alignr_epi8(cdgh, t, 8));
+}
+
+#else /* !defined(HWCRYPT_X86) */
+
+void hwcrypt_init(void)
+{
+}
+
+#endif /* !defined(HWCRYPT_X86) */
@@ -0,0 +1,39 @@
+/* HWCRYPT.H    (c) Copyright The Hercules Project, 2026             */
+/*              Host processor crypto instructions for dyncrypt      */
+
+/*   Released under the Q Public License                             */
+/*      (http://www.hercules-390.org/herclic.html)                   */
+/*   as modifications to Hercules.                                   */
+
+// $Id$
+
+#ifndef __HWCRYPT_H
+#define __HWCRYPT_H
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) \
+ && (__GNUC__ >= 5 || defined(__clang__))
+ #define HWCRYPT_X86
+#endif
+
+/* Host facilities, set by hwcrypt_init */
+extern int hwcrypt_aes;                 /* AES-NI                    */
+extern int hwcrypt_clmul;               /* PCLMULQDQ                 */
+extern int hwcrypt_sha;                 /* SHA-1 and SHA-256         */
+
+void hwcrypt_init(void);
+
+/* AES on round keys in byte order, 16 byte blocks in place */
+void hwaes_ecb_encrypt(const unsigned char *rk, int Nr, unsigned char *buf, int blocks);
+void hwaes_ecb_decrypt(const unsigned char *rk, int Nr, unsigned char *buf, int blocks);
+void hwaes_cbc_encrypt(const unsigned char *rk, int Nr, unsigned char iv[16], unsigned char *buf, int blocks);
+void hwaes_cbc_decrypt(const unsigned char *rk, int Nr, unsigned char iv[16], unsigned char *buf, int blocks);
+void hwaes_ctr(const unsigned char *rk, int Nr, const unsigned char *ctr, unsigned char *buf, int blocks);
+
+/* GHASH of 16 byte blocks into the chaining value x with hash subkey h */
+void hwghash(unsigned char x[16], const unsigned char h[16], const unsigned char *buf, int blocks);
+
+/* SHA-1 and SHA-256 of 64 byte blocks into the host order state */
+void hwsha1(unsigned int state[5], const unsigned char *data, int blocks);
+void hwsha256(unsigned int state[8], const unsigned char *data, int blocks);
+
+#endif /* __HWCRYPT_H */
@@ -19,6 +19,7 @@
 
 #include "hstdinc.h"
 #include "sha1.h"
+#include "hwcrypt.h"
 
 #ifndef bcopy
 #define bcopy(_src,_dest,_len) memcpy(_dest,_src,_len)
@@ -187,6 +188,13 @@ SHA1Final(unsigned char digest[SHA1_DIGEST_LENGTH], SHA1_CTX *context)
 void 
 sha1_process(sha1_context *ctx, unsigned char data[64])
 {
+#ifdef HWCRYPT_X86
+    if (hwcrypt_sha)
+    {
+        hwsha1(ctx->state, data, 1);
+        return;
+    }
+#endif
     SHA1Transform(ctx->state, data);
 }
 
@@ -46,6 +46,7 @@
 #include "opcode.h" /* For CSWAP macros */
 
 #include "sha256.h"
+#include "hwcrypt.h"
 
 #ifndef bcopy
 #define bcopy(_src,_dest,_len) memcpy(_dest,_src,_len)
@@ -519,6 +520,12 @@ SHA256_Final(u_int8_t digest[], SHA256_CTX *context)
 void
 sha256_process(sha256_context *ctx, u_int8_t data[64])
 {
+#ifdef HWCRYPT_X86
+ if (hwcrypt_sha) {
+  hwsha256(ctx->state, data, 1);
+  return;
+ }
+#endif
  SHA256_Transform(ctx, data);
 }
 
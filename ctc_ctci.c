@@ -56,10 +56,10 @@ static BYTE CTCI_Immed_Commands[256]=
 // Declarations
 // ====================================================================
 
-static void*    CTCI_ReadThread( PCTCBLK pCTCBLK );
+static void*    CTCI_ReadThread( PCTCIQUE pQueue );
 
-static int      CTCI_EnqueueIPFrame( DEVBLK* pDEVBLK,
-                                     BYTE*   pData, size_t iSize );
+static int      CTCI_EnqueueIPFrames( DEVBLK* pDEVBLK, BYTE** ppData,
+                                      int*    piSize,  int    iCount );
 
 static int      ParseArgs( DEVBLK* pDEVBLK, PCTCBLK pCTCBLK,
                            int argc, char** argv );
@@ -109,6 +109,7 @@ int  CTCI_Init( DEVBLK* pDEVBLK, int argc, char *argv[] )
     int             nIFType;            // Interface type
     int             nIFFlags;           // Interface flags
     char            thread_name[32];    // CTCI_ReadThread
+    int             i;                  // Queue number
 
     nIFType =               // Interface type
         0
@@ -207,8 +208,17 @@ int  CTCI_Init( DEVBLK* pDEVBLK, int argc, char *argv[] )
              pDevCTCBLK->szTUNCharName,
      sizeof( pDevCTCBLK->pDEVBLK[1]->filename ) );
 
+#ifdef OPTION_TUNTAP_MULTIQUEUE
+    if( pDevCTCBLK->iQueues > 1 )
+        nIFType |= IFF_MULTI_QUEUE;
+#endif
+#ifdef OPTION_TUNTAP_VNETHDR
+    if( pDevCTCBLK->fVnetHdr )
+        nIFType |= IFF_VNET_HDR;
+#endif
+
     rc = TUNTAP_CreateInterface( pDevCTCBLK->szTUNCharName,
-                                 IFF_TUN | IFF_NO_PI,
+                                 nIFType,
                                  &pDevCTCBLK->fd,
                                  pDevCTCBLK->szTUNDevName );
 
@@ -225,6 +235,30 @@ int  CTCI_Init( DEVBLK* pDEVBLK, int argc, char *argv[] )
                   pDevCTCBLK->szTUNDevName);
     }
 
+    pDevCTCBLK->Queue[0].fd = pDevCTCBLK->fd;
+
+#ifdef OPTION_TUNTAP_MULTIQUEUE
+    // Attach the additional queues; carry on with those we got
+    for( i = 1; i < pDevCTCBLK->iQueues; i++ )
+    {
+        if( TUNTAP_AddQueue( pDevCTCBLK->szTUNCharName, nIFType,
+                             &pDevCTCBLK->Queue[i].fd,
+                             pDevCTCBLK->szTUNDevName ) != 0 )
+        {
+            logmsg( _("HHCCT089W %4.4X: Using %d of %d queues on %s\n"),
+                    pDevCTCBLK->pDEVBLK[0]->devnum, i,
+                    pDevCTCBLK->iQueues, pDevCTCBLK->szTUNDevName );
+            pDevCTCBLK->iQueues = i;
+            break;
+        }
+    }
+#endif
+
+#ifdef OPTION_TUNTAP_VNETHDR
+    if( pDevCTCBLK->fVnetHdr )
+        TUNTAP_SetOffload( pDevCTCBLK->fd, pDevCTCBLK->szTUNDevName );
+#endif
+
 #if defined(OPTION_W32_CTCI)
 
     // Set the specified driver/dll i/o buffer sizes..
@@ -310,9 +344,19 @@ int  CTCI_Init( DEVBLK* pDEVBLK, int argc, char *argv[] )
     pDevCTCBLK->pDEVBLK[0]->fd =
     pDevCTCBLK->pDEVBLK[1]->fd = pDevCTCBLK->fd;
 
-    snprintf(thread_name,sizeof(thread_name),"CTCI %4.4X ReadThread",pDEVBLK->devnum);
-    thread_name[sizeof(thread_name)-1]=0;
-    create_thread( &pDevCTCBLK->tid, JOINABLE, CTCI_ReadThread, pDevCTCBLK, thread_name );
+    for( i = 0; i < pDevCTCBLK->iQueues; i++ )
+    {
+        pDevCTCBLK->Queue[i].pCTCBLK = pDevCTCBLK;
+
+        if( i == 0 )
+            snprintf(thread_name,sizeof(thread_name),"CTCI %4.4X ReadThread",pDEVBLK->devnum);
+        else
+            snprintf(thread_name,sizeof(thread_name),"CTCI %4.4X ReadThread %d",pDEVBLK->devnum,i);
+        thread_name[sizeof(thread_name)-1]=0;
+        create_thread( &pDevCTCBLK->Queue[i].tid, JOINABLE, CTCI_ReadThread, &pDevCTCBLK->Queue[i], thread_name );
+    }
+
+    pDevCTCBLK->tid = pDevCTCBLK->Queue[0].tid;
 
     pDevCTCBLK->pDEVBLK[0]->tid = pDevCTCBLK->tid;
     pDevCTCBLK->pDEVBLK[1]->tid = pDevCTCBLK->tid;
@@ -549,21 +593,21 @@ int  CTCI_Close( DEVBLK* pDEVBLK )
 {
     /* DEVBLK* pDEVBLK2; */
     PCTCBLK pCTCBLK  = (PCTCBLK)pDEVBLK->dev_data;
+    int     i;
 
     // Close the device file (if not already closed)
     if( pCTCBLK->fd >= 0 )
     {
         // PROGRAMMING NOTE: there's currently no way to interrupt
-        // the "CTCI_ReadThread"s TUNTAP_Read of the adapter. Thus
-        // we must simply wait for CTCI_ReadThread to eventually
-        // notice that we're doing a close (via our setting of the
-        // fCloseInProgress flag). Its TUNTAP_Read will eventually
-        // timeout after a few seconds (currently 5, which is dif-
-        // ferent than the CTC_READ_TIMEOUT_SECS timeout value the
-        // CTCI_Read function uses) and will then do the close of
-        // the adapter for us (TUNTAP_Close) so we don't have to.
-        // All we need to do is ask it to exit (via our setting of
-        // the fCloseInProgress flag) and then wait for it to exit
+        // the "CTCI_ReadThread"s TUNTAP_ReadBatch of the adapter.
+        // Thus we must simply wait for each CTCI_ReadThread to
+        // eventually notice that we're doing a close (via our
+        // setting of the fCloseInProgress flag). Its wait for a
+        // frame times out after CTC_READ_TIMEOUT_SECS seconds and
+        // it will then do the close of its queue of the adapter
+        // for us (TUNTAP_Close) so we don't have to. All we need
+        // to do is ask them to exit (via our setting of the
+        // fCloseInProgress flag) and then wait for them to exit
         // (which, as stated, could take up to a max of 5 seconds).
 
         // All of this is simply because it's poor form to close a
@@ -573,14 +617,17 @@ int  CTCI_Close( DEVBLK* pDEVBLK )
         // read request could have been freed (by the close call)
         // by the time the read request eventually gets serviced.
 
-        TID tid = pCTCBLK->tid;
-        pCTCBLK->fCloseInProgress = 1;  // (ask read thread to exit)
-        signal_thread( tid, SIGUSR2 );   // (for non-Win32 platforms)
+        pCTCBLK->fCloseInProgress = 1;  // (ask read threads to exit)
+        for( i = 0; i < pCTCBLK->iQueues; i++ )
+        {
+            TID tid = pCTCBLK->Queue[i].tid;
+            signal_thread( tid, SIGUSR2 );   // (for non-Win32 platforms)
 //FIXME signal_thread not working for non-MSVC platforms
 #if defined(_MSVC_)
-        join_thread( tid, NULL );       // (wait for thread to end)
+            join_thread( tid, NULL );       // (wait for thread to end)
 #endif
-        detach_thread( tid );           // (wait for thread to end)
+            detach_thread( tid );           // (wait for thread to end)
+        }
     }
 
     pDEVBLK->fd = -1;           // indicate we're now closed
@@ -608,10 +655,11 @@ void  CTCI_Query( DEVBLK* pDEVBLK, char** ppszClass,
         return;
     }
 
-    snprintf( pBuffer, iBufLen, "CTCI %s/%s (%s)%s",
+    snprintf( pBuffer, iBufLen, "CTCI %s/%s (%s)%s%s",
               pCTCBLK->szGuestIPAddr,
               pCTCBLK->szDriveIPAddr,
               pCTCBLK->szTUNDevName,
+              pCTCBLK->fVnetHdr ? " vnet" : "",
               pCTCBLK->fDebug ? " -d" : "" );
 }
 
@@ -888,7 +936,8 @@ void  CTCI_Write( DEVBLK* pDEVBLK,   U16   sCount,
         }
 
         // Write the IP packet to the TUN/TAP interface
-        rc = TUNTAP_Write( pCTCBLK->fd, pSegment->bData, sDataLen );
+        rc = TUNTAP_WriteFrame( pCTCBLK->fd, pCTCBLK->fVnetHdr,
+                                pSegment->bData, sDataLen );
 
         if( rc < 0 )
         {
@@ -941,15 +990,18 @@ void  CTCI_Write( DEVBLK* pDEVBLK,   U16   sCount,
 // a 2 byte frame type field (always 0x0800 = IPv4), and a 2 byte
 // reserved area (always 0000), followed by the actual frame data.
 //
-// The CTCI_ReadThread reads the IP frame, then CTCI_EnqueueIPFrame
-// function is called to add it to the frame buffer (which precedes
-// each one with a CTCISEG and adjusts the block header (CTCIHDR)
-// offset value as appropriate.
+// The CTCI_ReadThread reads the IP frames that are waiting on its
+// queue of the TUN interface in one batch, then the function
+// CTCI_EnqueueIPFrames is called to add them to the frame buffer
+// (which precedes each one with a CTCISEG and adjusts the block
+// header (CTCIHDR) offset value as appropriate). When the interface
+// has more than one queue, each queue has its own CTCI_ReadThread
+// and all of them add to the same frame buffer.
 //
 // Oddly, it is the CTCI_Read function (called by CCW processing in
 // response to a guest SIO request) that adds the CTCIHDR with the
 // 000 offset value marking the end of the buffer's chain of blocks,
-// and not the CTCI_EnqueueIPFrame nor the CTCI_ReadThread as would
+// and not the CTCI_EnqueueIPFrames nor the CTCI_ReadThread as would
 // be expected.
 //
 // Also note that the iFrameOffset field in the CTCI device's CTCBLK
@@ -958,24 +1010,34 @@ void  CTCI_Write( DEVBLK* pDEVBLK,   U16   sCount,
 // all of the queued CTCISEG's hwLength fields added together.
 // 
 
-static void*  CTCI_ReadThread( PCTCBLK pCTCBLK )
+static void*  CTCI_ReadThread( PCTCIQUE pQueue )
 {
+    PCTCBLK  pCTCBLK = pQueue->pCTCBLK;
     DEVBLK*  pDEVBLK = pCTCBLK->pDEVBLK[0];
-    int      iLength;
-    BYTE     szBuff[2048];
+    TTBATCH  batch;
+    int      iFrames;
+    int      i, n;
 
     // ZZ FIXME: Try to avoid race condition at startup with hercifc
     SLEEP(10);
 
     pCTCBLK->pid = getpid();
 
-    while( pCTCBLK->fd != -1 && !pCTCBLK->fCloseInProgress )
+    if( TUNTAP_InitBatch( &batch, pQueue->fd, pCTCBLK->fVnetHdr, 0,
+                          MAX( pCTCBLK->sMTU, TUNTAP_FRAME_SIZE ) ) != 0 )
+    {
+        logmsg( _("HHCCT090E %4.4X: Unable to allocate read buffer\n"),
+                pDEVBLK->devnum );
+        pCTCBLK->fCloseInProgress = 1;
+    }
+
+    while( pQueue->fd != -1 && !pCTCBLK->fCloseInProgress )
     {
-        // Read frame from the TUN/TAP interface
-        iLength = TUNTAP_Read( pCTCBLK->fd, szBuff, sizeof(szBuff) );
+        // Read the frames waiting on the TUN/TAP interface
+        iFrames = TUNTAP_ReadBatch( &batch, CTC_READ_TIMEOUT_SECS * 1000 );
 
         // Check for error condition
-        if( iLength < 0 )
+        if( iFrames < 0 )
         {
             logmsg( _("HHCCT048E %4.4X: Error reading from %s: %s\n"),
                 pDEVBLK->devnum, pCTCBLK->szTUNDevName,
@@ -983,125 +1045,140 @@ static void*  CTCI_ReadThread( PCTCBLK pCTCBLK )
             break;
         }
 
-        if( iLength == 0 )      // (probably EINTR; ignore)
+        if( iFrames == 0 )      // (timeout or EINTR; ignore)
             continue;
 
         if( pCTCBLK->fDebug )
         {
-            logmsg( _("HHCCT049I %4.4X: Received packet from %s (%d bytes):\n"),
-                    pDEVBLK->devnum, pCTCBLK->szTUNDevName, iLength );
-            packet_trace( szBuff, iLength );
+            for( i = 0; i < iFrames; i++ )
+            {
+                logmsg( _("HHCCT049I %4.4X: Received packet from %s (%d bytes):\n"),
+                        pDEVBLK->devnum, pCTCBLK->szTUNDevName,
+                        batch.iLength[i] );
+                packet_trace( batch.pFrame[i], batch.iLength[i] );
+            }
         }
 
-        // Enqueue frame on buffer, if buffer is full, keep trying
-        while( CTCI_EnqueueIPFrame( pDEVBLK, szBuff, iLength ) < 0
-            && pCTCBLK->fd != -1 && !pCTCBLK->fCloseInProgress )
+        // Enqueue frames on buffer, if buffer is full, keep trying
+        for( i = 0; i < iFrames
+            && pQueue->fd != -1 && !pCTCBLK->fCloseInProgress; i += n )
         {
-            if( EMSGSIZE == errno )     // (if too large for buffer)
+            n = CTCI_EnqueueIPFrames( pDEVBLK, batch.pFrame  + i,
+                                               batch.iLength + i,
+                                               iFrames - i );
+            if( n == 0 )
             {
-                if( pCTCBLK->fDebug )
-                    logmsg( _("HHCCT072W %4.4X: Packet too big; dropped.\n"),
-                            pDEVBLK->devnum );
-                break;                  // (discard it...)
+                // Don't use sched_yield() here; use an actual non-dispatchable
+                // delay instead so as to allow another [possibly lower priority]
+                // thread to 'read' (remove) some packet(s) from our frame buffer.
+                usleep( CTC_DELAY_USECS );  // (wait a bit before retrying...)
             }
-
-            ASSERT( ENOBUFS == errno );
-
-            // Don't use sched_yield() here; use an actual non-dispatchable
-            // delay instead so as to allow another [possibly lower priority]
-            // thread to 'read' (remove) some packet(s) from our frame buffer.
-            usleep( CTC_DELAY_USECS );  // (wait a bit before retrying...)
         }
     }
 
+    TUNTAP_FreeBatch( &batch );
+
     // We must do the close since we were the one doing the i/o...
 
-    VERIFY( pCTCBLK->fd == -1 || TUNTAP_Close( pCTCBLK->fd ) == 0 );
-    pCTCBLK->fd = -1;
+    VERIFY( pQueue->fd == -1 || TUNTAP_Close( pQueue->fd ) == 0 );
+    if( pQueue == &pCTCBLK->Queue[0] )
+        pCTCBLK->fd = -1;
+    pQueue->fd = -1;
 
     return NULL;
 }
 
 // --------------------------------------------------------------------
-// CTCI_EnqueueIPFrame
+// CTCI_EnqueueIPFrames
 // --------------------------------------------------------------------
 //
-// Places the provided IP frame in the next available frame slot in
-// the adapter buffer. For details regarding the actual buffer layout
-// please refer to the comments preceding the CTCI_ReadThread function.
+// Places the provided IP frames in the next available frame slots in
+// the adapter buffer, holding the buffer lock once for all of them.
+// For details regarding the actual buffer layout please refer to the
+// comments preceding the CTCI_ReadThread function.
 //
-// Returns:
+// Returns the number of frames consumed. This is less than iCount
+// when the buffer filled up, in which case the caller should retry
+// the remaining frames once the guest has read some. Frames which
+// would never fit into the buffer are discarded and count as consumed.
 //
-//  0 == Success
-// -1 == Failure; errno = ENOBUFS:  No buffer space available
-//                        EMSGSIZE: Message too long
-//
-static int  CTCI_EnqueueIPFrame( DEVBLK* pDEVBLK,
-                                 BYTE*   pData, size_t iSize )
+static int  CTCI_EnqueueIPFrames( DEVBLK* pDEVBLK, BYTE** ppData,
+                                  int*    piSize,  int    iCount )
 {
     PCTCIHDR pFrame;
     PCTCISEG pSegment;
     PCTCBLK  pCTCBLK = (PCTCBLK)pDEVBLK->dev_data;
-
-    // Will frame NEVER fit into buffer??
-    if( iSize > MAX_CTCI_FRAME_SIZE( pCTCBLK ) )
-    {
-        errno = EMSGSIZE;   // Message too long
-        return -1;          // (-1==failure)
-    }
+    size_t   iSize;
+    int      iTooBig = 0;
+    int      i;
 
     obtain_lock( &pCTCBLK->Lock );
 
-    // Ensure we dont overflow the buffer
-    if( ( pCTCBLK->iFrameOffset +         // Current buffer Offset
-          sizeof( CTCIHDR ) +             // Size of Block Header
-          sizeof( CTCISEG ) +             // Size of Segment Header
-          iSize +                         // Size of Ethernet packet
-          sizeof(pFrame->hwOffset) )      // Size of Block terminator
-        > pCTCBLK->iMaxFrameBufferSize )  // Size of Frame buffer
+    for( i = 0; i < iCount; i++ )
     {
-        release_lock( &pCTCBLK->Lock );
-        errno = ENOBUFS;    // No buffer space available
-        return -1;          // (-1==failure)
-    }
+        iSize = piSize[i];
 
-    // Fix-up Frame pointer
-    pFrame = (PCTCIHDR)pCTCBLK->bFrameBuffer;
+        // Will frame NEVER fit into buffer??
+        if( iSize > MAX_CTCI_FRAME_SIZE( pCTCBLK ) )
+        {
+            iTooBig++;      // (discard it...)
+            continue;
+        }
 
-    // Fix-up Segment pointer
-    pSegment = (PCTCISEG)( pCTCBLK->bFrameBuffer +
-                           sizeof( CTCIHDR ) +
-                           pCTCBLK->iFrameOffset );
+        // Ensure we dont overflow the buffer
+        if( ( pCTCBLK->iFrameOffset +         // Current buffer Offset
+              sizeof( CTCIHDR ) +             // Size of Block Header
+              sizeof( CTCISEG ) +             // Size of Segment Header
+              iSize +                         // Size of Ethernet packet
+              sizeof(pFrame->hwOffset) )      // Size of Block terminator
+            > pCTCBLK->iMaxFrameBufferSize )  // Size of Frame buffer
+            break;
+
+        // Fix-up Frame pointer
+        pFrame = (PCTCIHDR)pCTCBLK->bFrameBuffer;
 
-    // Initialize segment
-    memset( pSegment, 0, iSize + sizeof( CTCISEG ) );
+        // Fix-up Segment pointer
+        pSegment = (PCTCISEG)( pCTCBLK->bFrameBuffer +
+                               sizeof( CTCIHDR ) +
+                               pCTCBLK->iFrameOffset );
 
-    // Increment offset
-    pCTCBLK->iFrameOffset += sizeof( CTCISEG ) + iSize;
+        // Initialize segment
+        memset( pSegment, 0, iSize + sizeof( CTCISEG ) );
 
-    // Update next frame offset
-    STORE_HW( pFrame->hwOffset,
-              pCTCBLK->iFrameOffset + sizeof( CTCIHDR ) );
+        // Increment offset
+        pCTCBLK->iFrameOffset += sizeof( CTCISEG ) + iSize;
 
-    // Store segment length
-    STORE_HW( pSegment->hwLength, sizeof( CTCISEG ) + iSize );
+        // Update next frame offset
+        STORE_HW( pFrame->hwOffset,
+                  pCTCBLK->iFrameOffset + sizeof( CTCIHDR ) );
 
-    // Store Frame type
-    STORE_HW( pSegment->hwType, ETH_TYPE_IP );
+        // Store segment length
+        STORE_HW( pSegment->hwLength, sizeof( CTCISEG ) + iSize );
 
-    // Copy data
-    memcpy( pSegment->bData, pData, iSize );
+        // Store Frame type
+        STORE_HW( pSegment->hwType, ETH_TYPE_IP );
 
-    // Mark data pending
-    pCTCBLK->fDataPending = 1;
+        // Copy data
+        memcpy( pSegment->bData, ppData[i], iSize );
+
+        // Mark data pending
+        pCTCBLK->fDataPending = 1;
+    }
 
     release_lock( &pCTCBLK->Lock );
 
-    obtain_lock( &pCTCBLK->EventLock );
-    signal_condition( &pCTCBLK->Event );
-    release_lock( &pCTCBLK->EventLock );
+    if( iTooBig && pCTCBLK->fDebug )
+        logmsg( _("HHCCT072W %4.4X: Packet too big; dropped.\n"),
+                pDEVBLK->devnum );
+
+    if( i > iTooBig )
+    {
+        obtain_lock( &pCTCBLK->EventLock );
+        signal_condition( &pCTCBLK->Event );
+        release_lock( &pCTCBLK->EventLock );
+    }
 
-    return 0;       // (0==success)
+    return i;
 }
 
 //
@@ -1115,6 +1192,9 @@ static int  ParseArgs( DEVBLK* pDEVBLK, PCTCBLK pCTCBLK,
     int             iMTU;
     int             i;
     MAC             mac;                // Work area for MAC address
+#if defined(OPTION_TUNTAP_MULTIQUEUE)
+    int             iQueues;
+#endif
 #if defined(OPTION_W32_CTCI)
     int             iKernBuff;
     int             iIOBuff;
@@ -1127,6 +1207,7 @@ static int  ParseArgs( DEVBLK* pDEVBLK, PCTCBLK pCTCBLK,
     // Set some initial defaults
     strcpy( pCTCBLK->szMTU,     "1500" );
     strcpy( pCTCBLK->szNetMask, "255.255.255.255" );
+    pCTCBLK->iQueues = 1;
 #if defined( OPTION_W32_CTCI )
     strcpy( pCTCBLK->szTUNCharName,  tt32_get_default_iface() );
 #else
@@ -1199,6 +1280,12 @@ static int  ParseArgs( DEVBLK* pDEVBLK, PCTCBLK pCTCBLK,
             { "netmask", 1, NULL, 's' },
             { "mac",     1, NULL, 'm' },
             { "debug",   0, NULL, 'd' },
+#if defined( OPTION_TUNTAP_MULTIQUEUE )
+            { "queues",  1, NULL, 'q' },
+#endif
+#if defined( OPTION_TUNTAP_VNETHDR )
+            { "vnet",    0, NULL, 'v' },
+#endif
             { NULL,      0, NULL,  0  }
         };
 
@@ -1207,14 +1294,27 @@ static int  ParseArgs( DEVBLK* pDEVBLK, PCTCBLK pCTCBLK,
 #if defined( OPTION_W32_CTCI )
                  ":k:i"
 #endif
-                 ":t:s:m:d",
-                 options, &iOpt );
+                 ":t:s:m:d"
+#if defined( OPTION_TUNTAP_MULTIQUEUE )
+                 "q:"
+#endif
+#if defined( OPTION_TUNTAP_VNETHDR )
+                 "v"
+#endif
+                 , options, &iOpt );
 #else /* defined(HAVE_GETOPT_LONG) */
         c = getopt( argc, argv, "n"
 #if defined( OPTION_W32_CTCI )
             ":k:i"
 #endif
-            ":t:s:m:d");
+            ":t:s:m:d"
+#if defined( OPTION_TUNTAP_MULTIQUEUE )
+            "q:"
+#endif
+#if defined( OPTION_TUNTAP_VNETHDR )
+            "v"
+#endif
+            );
 #endif /* defined(HAVE_GETOPT_LONG) */
 
         if( c == -1 ) // No more options found
@@ -1317,6 +1417,27 @@ static int  ParseArgs( DEVBLK* pDEVBLK, PCTCBLK pCTCBLK,
             pCTCBLK->fDebug = TRUE;
             break;
 
+#if defined( OPTION_TUNTAP_MULTIQUEUE )
+        case 'q':     // Number of TUN queues
+            iQueues = atoi( optarg );
+
+            if( iQueues < 1 || iQueues > CTCI_MAX_QUEUES )
+            {
+                logmsg( _("HHCCT084E %4.4X: Invalid number of queues %s\n"),
+                    pDEVBLK->devnum, optarg );
+                return -1;
+            }
+
+            pCTCBLK->iQueues = iQueues;
+            break;
+#endif
+
+#if defined( OPTION_TUNTAP_VNETHDR )
+        case 'v':     // virtio-net headers and offloads
+            pCTCBLK->fVnetHdr = TRUE;
+            break;
+#endif
+
         default:
             break;
         }
@@ -322,7 +322,11 @@ int  LCS_Init( DEVBLK* pDEVBLK, int argc, char *argv[] )
             int   rc;
 
             rc = TUNTAP_CreateInterface( pLCSBLK->pszTUNDevice,
-                                         IFF_TAP | IFF_NO_PI,
+                                         IFF_TAP | IFF_NO_PI
+#ifdef OPTION_TUNTAP_VNETHDR
+                                         | ( pLCSBLK->fVnetHdr ? IFF_VNET_HDR : 0 )
+#endif
+                                         ,
                                          &pLCSBLK->Port[pLCSDev->bPort].fd,
                                          pLCSBLK->Port[pLCSDev->bPort].szNetDevName );
 
@@ -330,6 +334,12 @@ int  LCS_Init( DEVBLK* pDEVBLK, int argc, char *argv[] )
                       pLCSDev->pDEVBLK[0]->devnum,
                       pLCSBLK->Port[pLCSDev->bPort].szNetDevName);
 
+#ifdef OPTION_TUNTAP_VNETHDR
+            if( rc == 0 && pLCSBLK->fVnetHdr )
+                TUNTAP_SetOffload( pLCSBLK->Port[pLCSDev->bPort].fd,
+                                   pLCSBLK->Port[pLCSDev->bPort].szNetDevName );
+#endif
+
 #if defined(OPTION_W32_CTCI)
 
             // Set the specified driver/dll i/o buffer sizes..
@@ -651,14 +661,13 @@ int  LCS_Close( DEVBLK* pDEVBLK )
     if( !pLCSPORT->icDevices )
     {
         // PROGRAMMING NOTE: there's currently no way to interrupt
-        // the "LCS_PortThread"s TUNTAP_Read of the adapter. Thus
-        // we must simply wait for LCS_PortThread to eventually
+        // the "LCS_PortThread"s TUNTAP_ReadBatch of the adapter.
+        // Thus we must simply wait for LCS_PortThread to eventually
         // notice that we're doing a close (via our setting of the
-        // fCloseInProgress flag). Its TUNTAP_Read will eventually
-        // timeout after a few seconds (currently 5, which is dif-
-        // ferent than the CTC_READ_TIMEOUT_SECS timeout value the
-        // CTCI_Read function uses) and will then do the close of
-        // the adapter for us (TUNTAP_Close) so we don't have to.
+        // fCloseInProgress flag). Its wait for a frame times out
+        // after CTC_READ_TIMEOUT_SECS seconds and it will then do
+        // the close of the adapter for us (TUNTAP_Close) so we
+        // don't have to.
         // All we need to do is ask it to exit (via our setting of
         // the fCloseInProgress flag) and then wait for it to exit
         // (which, as stated, could take up to a max of 5 seconds).
@@ -1070,8 +1079,8 @@ void  LCS_Write( DEVBLK* pDEVBLK,   U16   sCount,
             }
 
             // Write the Ethernet frame to the TAP device
-            if( TUNTAP_Write( pDEVBLK->fd,
-                              (BYTE*)pEthFrame, iEthLen ) != iEthLen )
+            if( TUNTAP_WriteFrame( pDEVBLK->fd, pLCSDEV->pLCSBLK->fVnetHdr,
+                                   (BYTE*)pEthFrame, iEthLen ) != iEthLen )
             {
                 logmsg( _("HHCLC005E %4.4X: Error writing to %s: %s\n"),
                         pDEVBLK->devnum, pDEVBLK->filename,
@@ -1610,11 +1619,22 @@ static void*  LCS_PortThread( PLCSPORT pLCSPORT )
     U16         hwEthernetType;
     U32         lIPAddress;             // (network byte order)
     BYTE*       pMAC;
-    BYTE        szBuff[2048];
+    TTBATCH     batch;
+    int         iFrames;
+    int         iFrame;
+    BYTE*       pFrame;
     char        bReported = 0;
 
     pLCSPORT->pid = getpid();
 
+    if( TUNTAP_InitBatch( &batch, pLCSPORT->fd, pLCSPORT->pLCSBLK->fVnetHdr,
+                          sizeof( ETHFRM ), TUNTAP_FRAME_SIZE ) != 0 )
+    {
+        logmsg( _("HHCLC057E Port %2.2X: Unable to allocate read buffer\n"),
+                pLCSPORT->bPort );
+        pLCSPORT->fCloseInProgress = 1;
+    }
+
     for (;;)
     {
         obtain_lock( &pLCSPORT->EventLock );
@@ -1643,14 +1663,14 @@ static void*  LCS_PortThread( PLCSPORT pLCSPORT )
         if ( pLCSPORT->fd < 0 || pLCSPORT->fCloseInProgress )
             break;
 
-        // Read an IP packet from the TAP device
-        iLength = TUNTAP_Read( pLCSPORT->fd, szBuff, sizeof( szBuff ) );
+        // Read the frames waiting on the TAP device
+        iFrames = TUNTAP_ReadBatch( &batch, CTC_READ_TIMEOUT_SECS * 1000 );
 
-        if( iLength == 0 )      // (probably EINTR; ignore)
+        if( iFrames == 0 )      // (timeout or EINTR; ignore)
             continue;
 
         // Check for other error condition
-        if( iLength < 0 )
+        if( iFrames < 0 )
         {
             if( pLCSPORT->fd < 0 || pLCSPORT->fCloseInProgress )
                 break;
@@ -1659,209 +1679,217 @@ static void*  LCS_PortThread( PLCSPORT pLCSPORT )
             break;
         }
 
-        if( pLCSPORT->pLCSBLK->fDebug )
+        for( iFrame = 0; iFrame < iFrames; iFrame++ )
         {
-            // Trace the frame
-            logmsg( _("HHCLC009I Port %2.2X: Read Buffer:\n"),
-                    pLCSPORT->bPort );
-            packet_trace( szBuff, iLength );
+            pFrame  = batch.pFrame [ iFrame ];
+            iLength = batch.iLength[ iFrame ];
 
-            bReported = 0;
-        }
+            if( pLCSPORT->pLCSBLK->fDebug )
+            {
+                // Trace the frame
+                logmsg( _("HHCLC009I Port %2.2X: Read Buffer:\n"),
+                        pLCSPORT->bPort );
+                packet_trace( pFrame, iLength );
 
-        pEthFrame = (PETHFRM)szBuff;
+                bReported = 0;
+            }
 
-        FETCH_HW( hwEthernetType, pEthFrame->hwEthernetType );
+            pEthFrame = (PETHFRM)pFrame;
 
-        // Housekeeping
-        pPrimaryLCSDEV   = NULL;
-        pSecondaryLCSDEV = NULL;
-        pMatchingLCSDEV  = NULL;
+            FETCH_HW( hwEthernetType, pEthFrame->hwEthernetType );
 
-        // Attempt to find the device that this frame belongs to
-        for( pLCSDev = pLCSPORT->pLCSBLK->pDevices; pLCSDev; pLCSDev = pLCSDev->pNext )
-        {
-            // Only process devices that are on this port
-            if( pLCSDev->bPort == pLCSPORT->bPort )
+            // Housekeeping
+            pPrimaryLCSDEV   = NULL;
+            pSecondaryLCSDEV = NULL;
+            pMatchingLCSDEV  = NULL;
+
+            // Attempt to find the device that this frame belongs to
+            for( pLCSDev = pLCSPORT->pLCSBLK->pDevices; pLCSDev; pLCSDev = pLCSDev->pNext )
             {
-                if( hwEthernetType == ETH_TYPE_IP )
+                // Only process devices that are on this port
+                if( pLCSDev->bPort == pLCSPORT->bPort )
                 {
-                    pIPFrame   = (PIP4FRM)pEthFrame->bData;
-                    lIPAddress = pIPFrame->lDstIP;  // (network byte order)
-
-                    if( pLCSPORT->pLCSBLK->fDebug && !bReported )
+                    if( hwEthernetType == ETH_TYPE_IP )
                     {
-                        logmsg( _("HHCLC010I Port %2.2X: "
-                                  "IPV4 frame for %8.8X\n"),
-                                pLCSPORT->bPort, ntohl(lIPAddress) );
+                        pIPFrame   = (PIP4FRM)pEthFrame->bData;
+                        lIPAddress = pIPFrame->lDstIP;  // (network byte order)
 
-                        bReported = 1;
-                    }
+                        if( pLCSPORT->pLCSBLK->fDebug && !bReported )
+                        {
+                            logmsg( _("HHCLC010I Port %2.2X: "
+                                      "IPV4 frame for %8.8X\n"),
+                                    pLCSPORT->bPort, ntohl(lIPAddress) );
 
-                    // If this is an exact match use it
-                    // otherwise look for primary and secondary
-                    // default devices
-                    if( pLCSDev->lIPAddress == lIPAddress )
-                    {
-                        pMatchingLCSDEV = pLCSDev;
-                        break;
-                    }
-                    else if( pLCSDev->bType == LCSDEV_TYPE_PRIMARY )
-                        pPrimaryLCSDEV = pLCSDev;
-                    else if( pLCSDev->bType == LCSDEV_TYPE_SECONDARY )
-                        pSecondaryLCSDEV = pLCSDev;
-                }
-                else if( hwEthernetType == ETH_TYPE_ARP )
-                {
-                    pARPFrame  = (PARPFRM)pEthFrame->bData;
-                    lIPAddress = pARPFrame->lTargIPAddr; // (network byte order)
+                            bReported = 1;
+                        }
 
-                    if( pLCSPORT->pLCSBLK->fDebug && !bReported )
+                        // If this is an exact match use it
+                        // otherwise look for primary and secondary
+                        // default devices
+                        if( pLCSDev->lIPAddress == lIPAddress )
+                        {
+                            pMatchingLCSDEV = pLCSDev;
+                            break;
+                        }
+                        else if( pLCSDev->bType == LCSDEV_TYPE_PRIMARY )
+                            pPrimaryLCSDEV = pLCSDev;
+                        else if( pLCSDev->bType == LCSDEV_TYPE_SECONDARY )
+                            pSecondaryLCSDEV = pLCSDev;
+                    }
+                    else if( hwEthernetType == ETH_TYPE_ARP )
                     {
-                        logmsg( _("HHCLC011I Port %2.2X: "
-                                  "ARP frame for %8.8X\n"),
-                                pLCSPORT->bPort, ntohl(lIPAddress) );
+                        pARPFrame  = (PARPFRM)pEthFrame->bData;
+                        lIPAddress = pARPFrame->lTargIPAddr; // (network byte order)
 
-                        bReported = 1;
-                    }
+                        if( pLCSPORT->pLCSBLK->fDebug && !bReported )
+                        {
+                            logmsg( _("HHCLC011I Port %2.2X: "
+                                      "ARP frame for %8.8X\n"),
+                                    pLCSPORT->bPort, ntohl(lIPAddress) );
 
-                    // If this is an exact match use it
-                    // otherwise look for primary and secondary
-                    // default devices
-                    if( pLCSDev->lIPAddress == lIPAddress )
-                    {
-                        pMatchingLCSDEV = pLCSDev;
-                        break;
-                    }
-                    else if( pLCSDev->bType == LCSDEV_TYPE_PRIMARY )
-                        pPrimaryLCSDEV = pLCSDev;
-                    else if( pLCSDev->bType == LCSDEV_TYPE_SECONDARY )
-                        pSecondaryLCSDEV = pLCSDev;
-                }
-                else if( hwEthernetType == ETH_TYPE_RARP )
-                {
-                    pARPFrame  = (PARPFRM)pEthFrame->bData;
-                    pMAC = pARPFrame->bTargEthAddr;
+                            bReported = 1;
+                        }
 
-                    if( pLCSPORT->pLCSBLK->fDebug && !bReported )
-                    {
-                        logmsg
-                        (
-                            _("HHCLC011I Port %2.2X: RARP frame for "
-                              "%2.2X:%2.2X:%2.2X:%2.2X:%2.2X:%2.2X\n")
-
-                            ,pLCSPORT->bPort
-                            ,*(pMAC+0)
-                            ,*(pMAC+1)
-                            ,*(pMAC+2)
-                            ,*(pMAC+3)
-                            ,*(pMAC+4)
-                            ,*(pMAC+5)
-                        );
-
-                        bReported = 1;
+                        // If this is an exact match use it
+                        // otherwise look for primary and secondary
+                        // default devices
+                        if( pLCSDev->lIPAddress == lIPAddress )
+                        {
+                            pMatchingLCSDEV = pLCSDev;
+                            break;
+                        }
+                        else if( pLCSDev->bType == LCSDEV_TYPE_PRIMARY )
+                            pPrimaryLCSDEV = pLCSDev;
+                        else if( pLCSDev->bType == LCSDEV_TYPE_SECONDARY )
+                            pSecondaryLCSDEV = pLCSDev;
                     }
-
-                    // If this is an exact match use it
-                    // otherwise look for primary and secondary
-                    // default devices
-                    if( memcmp( pMAC, pLCSPORT->MAC_Address, IFHWADDRLEN ) == 0 )
+                    else if( hwEthernetType == ETH_TYPE_RARP )
                     {
-                        pMatchingLCSDEV = pLCSDev;
-                        break;
+                        pARPFrame  = (PARPFRM)pEthFrame->bData;
+                        pMAC = pARPFrame->bTargEthAddr;
+
+                        if( pLCSPORT->pLCSBLK->fDebug && !bReported )
+                        {
+                            logmsg
+                            (
+                                _("HHCLC011I Port %2.2X: RARP frame for "
+                                  "%2.2X:%2.2X:%2.2X:%2.2X:%2.2X:%2.2X\n")
+
+                                ,pLCSPORT->bPort
+                                ,*(pMAC+0)
+                                ,*(pMAC+1)
+                                ,*(pMAC+2)
+                                ,*(pMAC+3)
+                                ,*(pMAC+4)
+                                ,*(pMAC+5)
+                            );
+
+                            bReported = 1;
+                        }
+
+                        // If this is an exact match use it
+                        // otherwise look for primary and secondary
+                        // default devices
+                        if( memcmp( pMAC, pLCSPORT->MAC_Address, IFHWADDRLEN ) == 0 )
+                        {
+                            pMatchingLCSDEV = pLCSDev;
+                            break;
+                        }
+                        else if( pLCSDev->bType == LCSDEV_TYPE_PRIMARY )
+                            pPrimaryLCSDEV = pLCSDev;
+                        else if( pLCSDev->bType == LCSDEV_TYPE_SECONDARY )
+                            pSecondaryLCSDEV = pLCSDev;
                     }
-                    else if( pLCSDev->bType == LCSDEV_TYPE_PRIMARY )
-                        pPrimaryLCSDEV = pLCSDev;
-                    else if( pLCSDev->bType == LCSDEV_TYPE_SECONDARY )
-                        pSecondaryLCSDEV = pLCSDev;
-                }
-                else if( hwEthernetType == ETH_TYPE_SNA )
-                {
-                    if( pLCSPORT->pLCSBLK->fDebug && !bReported )
+                    else if( hwEthernetType == ETH_TYPE_SNA )
                     {
-                        logmsg( _("HHCLC012I Port %2.2X: SNA frame\n"),
-                                pLCSPORT->bPort );
+                        if( pLCSPORT->pLCSBLK->fDebug && !bReported )
+                        {
+                            logmsg( _("HHCLC012I Port %2.2X: SNA frame\n"),
+                                    pLCSPORT->bPort );
 
-                        bReported = 1;
-                    }
+                            bReported = 1;
+                        }
 
-                    if( pLCSDev->bMode == LCSDEV_MODE_SNA )
-                    {
-                        pMatchingLCSDEV = pLCSDev;
-                        break;
+                        if( pLCSDev->bMode == LCSDEV_MODE_SNA )
+                        {
+                            pMatchingLCSDEV = pLCSDev;
+                            break;
+                        }
                     }
                 }
             }
-        }
 
-        // If the matching device is not started
-        // nullify the pointer and pass frame to one
-        // of the defaults if present
-        if( pMatchingLCSDEV && !pMatchingLCSDEV->fStarted )
-            pMatchingLCSDEV = NULL;
+            // If the matching device is not started
+            // nullify the pointer and pass frame to one
+            // of the defaults if present
+            if( pMatchingLCSDEV && !pMatchingLCSDEV->fStarted )
+                pMatchingLCSDEV = NULL;
 
-        // Match not found, check for default devices
-        // If one is defined and started, use it
-        if( !pMatchingLCSDEV )
-        {
-            if( pPrimaryLCSDEV && pPrimaryLCSDEV->fStarted )
+            // Match not found, check for default devices
+            // If one is defined and started, use it
+            if( !pMatchingLCSDEV )
             {
-                pMatchingLCSDEV = pPrimaryLCSDEV;
+                if( pPrimaryLCSDEV && pPrimaryLCSDEV->fStarted )
+                {
+                    pMatchingLCSDEV = pPrimaryLCSDEV;
 
-                if( pLCSPORT->pLCSBLK->fDebug )
-                    logmsg( _("HHCLC013I Port %2.2X: "
-                              "No match found - "
-                              "selecting primary %4.4X\n"),
-                            pLCSPORT->bPort, pMatchingLCSDEV->sAddr );
+                    if( pLCSPORT->pLCSBLK->fDebug )
+                        logmsg( _("HHCLC013I Port %2.2X: "
+                                  "No match found - "
+                                  "selecting primary %4.4X\n"),
+                                pLCSPORT->bPort, pMatchingLCSDEV->sAddr );
+                }
+                else if( pSecondaryLCSDEV && pSecondaryLCSDEV->fStarted )
+                {
+                    pMatchingLCSDEV = pSecondaryLCSDEV;
+
+                    if( pLCSPORT->pLCSBLK->fDebug )
+                        logmsg( _("HHCLC014I Port %2.2X: "
+                                  "No match found - "
+                                  "selecting secondary %4.4X\n"),
+                                pLCSPORT->bPort, pMatchingLCSDEV->sAddr );
+                }
             }
-            else if( pSecondaryLCSDEV && pSecondaryLCSDEV->fStarted )
-            {
-                pMatchingLCSDEV = pSecondaryLCSDEV;
 
+            // No match found, discard frame
+            if( !pMatchingLCSDEV )
+            {
                 if( pLCSPORT->pLCSBLK->fDebug )
-                    logmsg( _("HHCLC014I Port %2.2X: "
-                              "No match found - "
-                              "selecting secondary %4.4X\n"),
-                            pLCSPORT->bPort, pMatchingLCSDEV->sAddr );
+                    logmsg( _("HHCLC015I Port %2.2X: "
+                              "No match found - Discarding frame\n"),
+                            pLCSPORT->bPort );
+
+                continue;
             }
-        }
 
-        // No match found, discard frame
-        if( !pMatchingLCSDEV )
-        {
             if( pLCSPORT->pLCSBLK->fDebug )
-                logmsg( _("HHCLC015I Port %2.2X: "
-                          "No match found - Discarding frame\n"),
-                        pLCSPORT->bPort );
-
-            continue;
-        }
-
-        if( pLCSPORT->pLCSBLK->fDebug )
-            logmsg( _("HHCLC016I Port %2.2X: "
-                      "Enqueing frame to device %4.4X (%8.8X)\n"),
-                    pLCSPORT->bPort, pMatchingLCSDEV->sAddr,
-                    ntohl(pMatchingLCSDEV->lIPAddress) );
+                logmsg( _("HHCLC016I Port %2.2X: "
+                          "Enqueing frame to device %4.4X (%8.8X)\n"),
+                        pLCSPORT->bPort, pMatchingLCSDEV->sAddr,
+                        ntohl(pMatchingLCSDEV->lIPAddress) );
 
-        // Match was found.
-        // Enqueue frame on buffer, if buffer is full, keep trying
+            // Match was found.
+            // Enqueue frame on buffer, if buffer is full, keep trying
 
-        while( LCS_EnqueueEthFrame( pMatchingLCSDEV, pLCSPORT->bPort, szBuff, iLength ) < 0
-            && pLCSPORT->fd != -1 && !pLCSPORT->fCloseInProgress )
-        {
-            if (EMSGSIZE == errno)
+            while( LCS_EnqueueEthFrame( pMatchingLCSDEV, pLCSPORT->bPort, pFrame, iLength ) < 0
+                && pLCSPORT->fd != -1 && !pLCSPORT->fCloseInProgress )
             {
-                if( pLCSPORT->pLCSBLK->fDebug )
-                    logmsg( _("HHCLC041W Port %2.2X: "
-                        "Frame too big; discarded.\n"),
-                        pLCSPORT->bPort );
-                break;
+                if (EMSGSIZE == errno)
+                {
+                    if( pLCSPORT->pLCSBLK->fDebug )
+                        logmsg( _("HHCLC041W Port %2.2X: "
+                            "Frame too big; discarded.\n"),
+                            pLCSPORT->bPort );
+                    break;
+                }
+                ASSERT( ENOBUFS == errno );
+                usleep( CTC_DELAY_USECS );
             }
-            ASSERT( ENOBUFS == errno );
-            usleep( CTC_DELAY_USECS );
         }
     } // end for(;;)
 
+    TUNTAP_FreeBatch( &batch );
+
     // We must do the close since we were the one doing the i/o...
 
     VERIFY( pLCSPORT->fd == -1 || TUNTAP_Close( pLCSPORT->fd ) == 0 );
@@ -2092,6 +2120,9 @@ int  ParseArgs( DEVBLK* pDEVBLK, PLCSBLK pLCSBLK,
             { "oat",   1, NULL, 'o' },
             { "mac",   1, NULL, 'm' },
             { "debug", 0, NULL, 'd' },
+#if defined( OPTION_TUNTAP_VNETHDR )
+            { "vnet",  0, NULL, 'v' },
+#endif
             { NULL,    0, NULL, 0   }
         };
 
@@ -2100,13 +2131,21 @@ int  ParseArgs( DEVBLK* pDEVBLK, PLCSBLK pLCSBLK,
 #if defined( OPTION_W32_CTCI )
                          ":k:i"
 #endif
-                         ":o:m:d", options, &iOpt );
+                         ":o:m:d"
+#if defined( OPTION_TUNTAP_VNETHDR )
+                         "v"
+#endif
+                         , options, &iOpt );
 #else /* defined(HAVE_GETOPT_LONG) */
         c = getopt( argc, argv, "n"
 #if defined( OPTION_W32_CTCI )
             ":k:i"
 #endif
-            ":o:m:d" );
+            ":o:m:d"
+#if defined( OPTION_TUNTAP_VNETHDR )
+            "v"
+#endif
+            );
 #endif /* defined(HAVE_GETOPT_LONG) */
 
         if( c == -1 )
@@ -2177,6 +2216,12 @@ int  ParseArgs( DEVBLK* pDEVBLK, PLCSBLK pLCSBLK,
             pLCSBLK->fDebug = TRUE;
             break;
 
+#if defined( OPTION_TUNTAP_VNETHDR )
+        case 'v':
+            pLCSBLK->fVnetHdr = TRUE;
+            break;
+#endif
+
         default:
             break;
         }
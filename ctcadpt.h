@@ -226,15 +226,31 @@ typedef struct _ARPFRM ARPFRM, *PARPFRM;
                                             // mostly by enqueue frame buffer
                                             // full delay loop...
 
+#define CTCI_MAX_QUEUES        (8)          // Max TUN queues per CTCI
+
 struct  _CTCBLK;
+struct  _CTCIQUE;
 struct  _CTCIHDR;
 struct  _CTCISEG;
 
 typedef struct _CTCBLK  CTCBLK, *PCTCBLK;
+typedef struct _CTCIQUE CTCIQUE,*PCTCIQUE;
 typedef struct _CTCIHDR CTCIHDR,*PCTCIHDR;
 typedef struct _CTCISEG CTCISEG,*PCTCISEG;
 
 
+// --------------------------------------------------------------------
+// CTCIQUE - TUN queue and its read thread     (host byte order)
+// --------------------------------------------------------------------
+
+struct  _CTCIQUE
+{
+    PCTCBLK     pCTCBLK;                  // -> CTCBLK
+    int         fd;                       // TUN/TAP fd of this queue
+    TID         tid;                      // Read Thread ID
+};
+
+
 // --------------------------------------------------------------------
 // CTCBLK -                                (host byte order)
 // --------------------------------------------------------------------
@@ -264,6 +280,10 @@ struct  _CTCBLK
     u_int       fDataPending:1;           // Data is pending for
                                           //   read device
     u_int       fCloseInProgress:1;       // Close in progress
+    u_int       fVnetHdr:1;               // Frames have virtio-net hdr
+
+    int         iQueues;                  // Number of TUN queues
+    CTCIQUE     Queue[CTCI_MAX_QUEUES];   // Queue 0 fd/tid = fd/tid
 
     int         iKernBuff;                // Kernel buffer in K bytes.
     int         iIOBuff;                  // I/O buffer in K bytes.
@@ -463,6 +483,7 @@ struct  _LCSBLK
     MAC         MAC_Address;              // MAC Address (binary)
 
     u_int       fDebug:1;
+    u_int       fVnetHdr:1;               // Use virtio-net headers
 
     int         icDevices;                // Number of devices
     int         iKernBuff;                // Kernel buffer in K bytes.
@@ -130,6 +130,14 @@ char            pgmpath[MAX_PATH];      /* prog path in host format  */
 #ifdef CCKD_COMPRESS_BZIP2
         else if (strcmp(argv[0], "-bz2") == 0)
             comp = CCKD_COMPRESS_BZIP2;
+#endif
+#ifdef CCKD_LZ4
+        else if (strcmp(argv[0], "-lz4") == 0)
+            comp = CCKD_COMPRESS_LZ4;
+#endif
+#ifdef CCKD_ZSTD
+        else if (strcmp(argv[0], "-zstd") == 0)
+            comp = CCKD_COMPRESS_ZSTD;
 #endif
         else if (strcmp(argv[0], "-0") == 0)
             comp = CCKD_COMPRESS_NONE;
@@ -524,6 +532,8 @@ int syntax (char *pgm)
             "     -r                replace the output file if it exists\n"
             "%s"
             "%s"
+            "%s"
+            "%s"
             "     -0                don't compress track images\n"
             "     -cyls  n          size of output file\n"
             "     -a                output file will have alt cyls\n"
@@ -538,6 +548,20 @@ int syntax (char *pgm)
 #ifdef CCKD_COMPRESS_BZIP2
             _(
             "     -bz2              compress using bzip2\n"
+            ),
+#else
+            "",
+#endif
+#ifdef CCKD_LZ4
+            _(
+            "     -lz4              compress using lz4\n"
+            ),
+#else
+            "",
+#endif
+#ifdef CCKD_ZSTD
+            _(
+            "     -zstd             compress using zstd\n"
             )
 #else
             ""
@@ -581,6 +605,8 @@ int syntax (char *pgm)
             "     -r                replace the output file if it exists\n"
             "%s"
             "%s"
+            "%s"
+            "%s"
             "     -0                don't compress track images\n"
             "     -blks  n          size of output file\n"
             ),
@@ -594,6 +620,20 @@ int syntax (char *pgm)
 #ifdef CCKD_COMPRESS_BZIP2
             _(
             "     -bz2              compress using bzip2\n"
+            ),
+#else
+            "",
+#endif
+#ifdef CCKD_LZ4
+            _(
+            "     -lz4              compress using lz4\n"
+            ),
+#else
+            "",
+#endif
+#ifdef CCKD_ZSTD
+            _(
+            "     -zstd             compress using zstd\n"
             )
 #else
             ""
@@ -637,6 +677,8 @@ int syntax (char *pgm)
             "     -r                replace the output file if it exists\n"
             "%s"
             "%s"
+            "%s"
+            "%s"
             "     -0                don't compress output\n"
             "     -blks  n          size of output fba file\n"
             "     -cyls  n          size of output ckd file\n"
@@ -656,6 +698,20 @@ int syntax (char *pgm)
 #ifdef CCKD_COMPRESS_BZIP2
             _(
             "     -bz2              compress output using bzip2\n"
+            ),
+#else
+            "",
+#endif
+#ifdef CCKD_LZ4
+            _(
+            "     -lz4              compress output using lz4\n"
+            ),
+#else
+            "",
+#endif
+#ifdef CCKD_ZSTD
+            _(
+            "     -zstd             compress output using zstd\n"
             )
 #else
             ""
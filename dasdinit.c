@@ -14,6 +14,8 @@
 /*                      (ignored if size specified manually)         */
 /*                -z    build compressed device using zlib           */
 /*                -bz2  build compressed device using bzip2          */
+/*                -lz4  build compressed device using lz4            */
+/*                -zstd build compressed device using zstd           */
 /*                -0    build compressed device with no compression  */
 /*                -r    "raw" init (bypass VOL1 & IPL track fmt)     */
 /*                                                                   */
@@ -96,6 +98,12 @@ argexit ( int code, char *m )
 #ifdef CCKD_BZIP2
 "  -bz2       build compressed dasd image file using bzip2\n"
 #endif
+#ifdef CCKD_LZ4
+"  -lz4       build compressed dasd image file using lz4\n"
+#endif
+#ifdef CCKD_ZSTD
+"  -zstd      build compressed dasd image file using zstd\n"
+#endif
 "  -0         build compressed dasd image file with no compression\n"
 );
         if (sizeof(off_t) > 4) fprintf(stderr,
@@ -170,6 +178,14 @@ int     rc;                             /* Return code               */
 #ifdef CCKD_BZIP2
         else if (strcmp("bz2", &argv[1][1]) == 0)
             comp = CCKD_COMPRESS_BZIP2;
+#endif
+#ifdef CCKD_LZ4
+        else if (strcmp("lz4", &argv[1][1]) == 0)
+            comp = CCKD_COMPRESS_LZ4;
+#endif
+#ifdef CCKD_ZSTD
+        else if (strcmp("zstd", &argv[1][1]) == 0)
+            comp = CCKD_COMPRESS_ZSTD;
 #endif
         else if (strcmp("a", &argv[1][1]) == 0)
             altcylflag = 1;
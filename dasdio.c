@@ -0,0 +1,583 @@
+/* DASDIO.C   (c)Copyright The Hercules Project, 2026                */
+/*            DASD image file i/o using io_uring or mmap             */
+
+/*-------------------------------------------------------------------*/
+/* This module queues dasd image file reads and writes on a shared   */
+/* io_uring submission ring, and maps image files for the `mmap'     */
+/* device option.  See dasdio.h for a description.                   */
+/*-------------------------------------------------------------------*/
+
+#include "hstdinc.h"
+
+#define _DASDIO_C_
+#define _HDASD_DLL_
+
+#if defined(HAVE_LINUX_IO_URING_H)
+ #include <sys/syscall.h>
+ #include <linux/io_uring.h>
+#endif
+
+#include "hercules.h"
+
+#if defined(OPTION_IO_URING)
+
+static DASDIO_RING  dasdioring;
+static int          dasdioinit;         /* 1=Ring created, -1=failed */
+
+/*-------------------------------------------------------------------*/
+/* io_uring system calls                                             */
+/*-------------------------------------------------------------------*/
+static inline int dasdio_setup (unsigned entries, struct io_uring_params *p)
+{
+    return (int)syscall (__NR_io_uring_setup, entries, p);
+}
+
+static inline int dasdio_enter (int fd, unsigned to_submit,
+                                unsigned min_complete, unsigned flags)
+{
+    return (int)syscall (__NR_io_uring_enter, fd, to_submit,
+                         min_complete, flags, NULL, 0);
+}
+
+/*-------------------------------------------------------------------*/
+/* Stop using the ring after an unexpected io_uring_enter error      */
+/*-------------------------------------------------------------------*/
+/* Called with the ring lock held.  Requests that the kernel has not */
+/* yet taken from the submission ring are completed with ECANCELED,  */
+/* which makes their callers use normal file i/o instead, as do all  */
+/* later requests.  Requests already in the kernel are still reaped. */
+/*-------------------------------------------------------------------*/
+static void dasdio_fail (DASDIO_RING *ring, int err, int submit)
+{
+DASDIO_REQ     *req;                    /* -> Cancelled request      */
+unsigned        head;                   /* Submission ring head      */
+
+    if (!ring->failed)
+        logmsg (submit
+                ? _("HHCDA086E io_uring submit error, using synchronous "
+                    "file i/o: %s\n")
+                : _("HHCDA085E io_uring wait error, using synchronous "
+                    "file i/o: %s\n"), strerror(err));
+    ring->failed = 1;
+
+    head = __atomic_load_n (ring->sqhead, __ATOMIC_ACQUIRE);
+    while (head != *ring->sqtail)
+    {
+        req = (DASDIO_REQ *)(uintptr_t)
+              ring->sqes[ring->sqarray[head & ring->sqmask]].user_data;
+        req->res = -ECANCELED;
+        req->done = 1;
+        signal_condition (&req->cond);
+        head++;
+    }
+    ring->queued = 0;
+    broadcast_condition (&ring->cond);
+
+} /* end function dasdio_fail */
+
+/*-------------------------------------------------------------------*/
+/* Pass the queued entries to the kernel                             */
+/*-------------------------------------------------------------------*/
+/* Called with the ring lock held, which is released meanwhile.  If  */
+/* `wait' the call also waits for at least one completion.           */
+/*-------------------------------------------------------------------*/
+static void dasdio_submit (DASDIO_RING *ring, int wait)
+{
+unsigned        n = 0;                  /* Number to submit          */
+int             rc;                     /* Return code               */
+int             err;                    /* Error number              */
+
+    /* Only one thread submits at a time */
+    if (!ring->submitting && !ring->failed)
+        n = ring->queued;
+    if (n == 0 && !wait)
+        return;
+    if (n)
+    {
+        ring->submitting = 1;
+        ring->queued = 0;
+        ring->inflight += n;
+    }
+
+    release_lock (&ring->lock);
+    rc = dasdio_enter (ring->fd, n, wait ? 1 : 0,
+                       wait ? IORING_ENTER_GETEVENTS : 0);
+    err = errno;
+    obtain_lock (&ring->lock);
+
+    /* The kernel returns the number of entries it took, even if the
+       wait for a completion was then interrupted */
+    if (n)
+    {
+        ring->submitting = 0;
+        if (rc < (int)n)
+        {
+            ring->inflight -= n - (rc < 0 ? 0 : rc);
+            ring->queued += n - (rc < 0 ? 0 : rc);
+        }
+    }
+    if (rc < 0 && err != EINTR && err != EAGAIN && err != EBUSY)
+        dasdio_fail (ring, err, n != 0);
+    else if (rc < (int)n)
+    {
+        /* Let completions drain before trying again */
+        release_lock (&ring->lock);
+        sched_yield ();
+        obtain_lock (&ring->lock);
+    }
+
+} /* end function dasdio_submit */
+
+/*-------------------------------------------------------------------*/
+/* Complete the requests on the completion ring                      */
+/*-------------------------------------------------------------------*/
+/* Called with the ring lock held.                                   */
+/*-------------------------------------------------------------------*/
+static void dasdio_complete (DASDIO_RING *ring)
+{
+DASDIO_REQ     *req;                    /* -> Completed request      */
+struct io_uring_cqe *cqe;               /* -> Completion entry       */
+unsigned        head;                   /* Completion ring head      */
+unsigned        n = 0;                  /* Number reaped             */
+
+    head = *ring->cqhead;
+    while (head != __atomic_load_n (ring->cqtail, __ATOMIC_ACQUIRE))
+    {
+        cqe = &ring->cqes[head & ring->cqmask];
+        req = (DASDIO_REQ *)(uintptr_t)cqe->user_data;
+        req->res = cqe->res;
+        req->done = 1;
+        signal_condition (&req->cond);
+        head++;
+        n++;
+    }
+    __atomic_store_n (ring->cqhead, head, __ATOMIC_RELEASE);
+
+    if (n)
+    {
+        ring->inflight -= n;
+        if (ring->spacewaiters)
+            broadcast_condition (&ring->cond);
+    }
+
+} /* end function dasdio_complete */
+
+/*-------------------------------------------------------------------*/
+/* Queue a request and wait for it to complete                       */
+/*-------------------------------------------------------------------*/
+/* There is no completion thread.  One of the waiting threads reaps  */
+/* the completion ring at a time, submitting the queued entries and  */
+/* waiting for a completion in the same io_uring_enter call, and     */
+/* wakes only the threads whose requests completed.  A thread with   */
+/* nobody else waiting so makes a single system call and no context  */
+/* switch, as with pread.  Returns -1 with errno ECANCELED if normal */
+/* file i/o must be used instead.                                    */
+/*-------------------------------------------------------------------*/
+static int dasdio_rw (BYTE op, int fd, void *buf, int len, off_t off)
+{
+DASDIO_RING    *ring = &dasdioring;     /* -> Ring                   */
+DASDIO_REQ      req;                    /* Request                   */
+DASDIO_REQ    **pp;                     /* -> Waiting request chain  */
+struct io_uring_sqe *sqe;               /* -> Submission entry       */
+unsigned        tail;                   /* Submission ring tail      */
+
+    obtain_lock (&ring->lock);
+
+    /* Wait for ring space; this also keeps the completion ring,
+       which is twice the size, from ever overflowing */
+    while (ring->queued + ring->inflight >= ring->entries && !ring->failed)
+    {
+        ring->spacewaiters++;
+        wait_condition (&ring->cond, &ring->lock);
+        ring->spacewaiters--;
+    }
+
+    if (ring->failed)
+    {
+        release_lock (&ring->lock);
+        errno = ECANCELED;
+        return -1;
+    }
+
+    initialize_condition (&req.cond);
+    req.done = 0;
+    req.res = 0;
+    req.next = ring->waiters;
+    ring->waiters = &req;
+
+    /* Fill in the next submission entry */
+    tail = *ring->sqtail;
+    sqe = &ring->sqes[tail & ring->sqmask];
+    memset (sqe, 0, sizeof(*sqe));
+    sqe->opcode = op;
+    sqe->fd = fd;
+    sqe->addr = (U64)(uintptr_t)buf;
+    sqe->len = len;
+    sqe->off = (U64)off;
+    sqe->user_data = (U64)(uintptr_t)&req;
+    ring->sqarray[tail & ring->sqmask] = tail & ring->sqmask;
+    __atomic_store_n (ring->sqtail, tail + 1, __ATOMIC_RELEASE);
+    ring->queued++;
+
+    while (!req.done)
+    {
+        if (!ring->reaping)
+        {
+            /* Become the reaper until our own request completes */
+            ring->reaping = 1;
+            if (ring->failed)
+            {
+                /* Only requests already in the kernel are left */
+                release_lock (&ring->lock);
+                usleep (1000);
+                obtain_lock (&ring->lock);
+            }
+            else
+                dasdio_submit (ring, 1);
+            dasdio_complete (ring);
+            ring->reaping = 0;
+        }
+        else if (ring->queued && !ring->submitting && !ring->failed)
+            /* The reaper is in the kernel; do not wait for it */
+            dasdio_submit (ring, 0);
+        else
+            wait_condition (&req.cond, &ring->lock);
+    }
+
+    /* Leave the chain and hand the reaping on to a waiting thread */
+    for (pp = &ring->waiters; *pp != &req; pp = &(*pp)->next);
+    *pp = req.next;
+    if (!ring->reaping)
+    {
+        for (pp = &ring->waiters; *pp && (*pp)->done; pp = &(*pp)->next);
+        if (*pp)
+            signal_condition (&(*pp)->cond);
+    }
+
+    release_lock (&ring->lock);
+
+    destroy_condition (&req.cond);
+
+    if (req.res < 0)
+    {
+        errno = -req.res;
+        return -1;
+    }
+    return req.res;
+
+} /* end function dasdio_rw */
+
+/*-------------------------------------------------------------------*/
+/* Create the ring                                                   */
+/*-------------------------------------------------------------------*/
+DLL_EXPORT int dasdio_init ()
+{
+DASDIO_RING    *ring = &dasdioring;     /* -> Ring                   */
+struct io_uring_params p;               /* Setup parameters          */
+BYTE           *sq, *cq;                /* -> Mapped rings           */
+
+    /* Called by the device init handlers, which are serialized */
+    if (dasdioinit)
+        return dasdioinit > 0 ? 0 : -1;
+    dasdioinit = -1;
+
+    memset (&p, 0, sizeof(p));
+    ring->fd = dasdio_setup (DASDIO_RING_ENTRIES, &p);
+    if (ring->fd < 0)
+    {
+        logmsg (_("HHCDA083W io_uring not available, using synchronous "
+                  "file i/o: %s\n"), strerror(errno));
+        return -1;
+    }
+
+    /* IORING_OP_READ and IORING_OP_WRITE arrived with this feature */
+    if (!(p.features & IORING_FEAT_RW_CUR_POS))
+    {
+        errno = ENOSYS;
+        goto dasdio_init_error;
+    }
+
+    /* Map the rings; a single mapping is used when supported */
+    ring->sqringsz = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    ring->cqringsz = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if ((p.features & IORING_FEAT_SINGLE_MMAP)
+     && ring->cqringsz > ring->sqringsz)
+        ring->sqringsz = ring->cqringsz;
+    sq = mmap (NULL, ring->sqringsz, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+    if (sq == MAP_FAILED)
+        goto dasdio_init_error;
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+        cq = sq;
+    else
+    {
+        cq = mmap (NULL, ring->cqringsz, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+        if (cq == MAP_FAILED)
+        {
+            munmap (sq, ring->sqringsz);
+            goto dasdio_init_error;
+        }
+    }
+    ring->sqessz = p.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap (NULL, ring->sqessz, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED)
+    {
+        if (cq != sq) munmap (cq, ring->cqringsz);
+        munmap (sq, ring->sqringsz);
+        goto dasdio_init_error;
+    }
+
+    ring->sqring  = sq;
+    ring->sqhead  = (unsigned *)(sq + p.sq_off.head);
+    ring->sqtail  = (unsigned *)(sq + p.sq_off.tail);
+    ring->sqmask  = *(unsigned *)(sq + p.sq_off.ring_mask);
+    ring->sqarray = (unsigned *)(sq + p.sq_off.array);
+    ring->cqring  = cq;
+    ring->cqhead  = (unsigned *)(cq + p.cq_off.head);
+    ring->cqtail  = (unsigned *)(cq + p.cq_off.tail);
+    ring->cqmask  = *(unsigned *)(cq + p.cq_off.ring_mask);
+    ring->cqes    = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+    ring->entries = p.sq_entries;
+
+    initialize_lock (&ring->lock);
+    initialize_condition (&ring->cond);
+
+    logmsg (_("HHCDA087I io_uring file i/o started, %d entries\n"),
+            ring->entries);
+
+    dasdioinit = 1;
+    return 0;
+
+dasdio_init_error:
+    logmsg (_("HHCDA083W io_uring not available, using synchronous "
+              "file i/o: %s\n"), strerror(errno));
+    close (ring->fd);
+    return -1;
+
+} /* end function dasdio_init */
+
+DLL_EXPORT int dasdio_active ()
+{
+    return dasdioinit > 0 && !dasdioring.failed;
+}
+
+#else /* !defined(OPTION_IO_URING) */
+
+DLL_EXPORT int dasdio_init ()
+{
+    return -1;
+}
+
+DLL_EXPORT int dasdio_active ()
+{
+    return 0;
+}
+
+#endif /* defined(OPTION_IO_URING) */
+
+/*-------------------------------------------------------------------*/
+/* Read from a dasd image file                                       */
+/*-------------------------------------------------------------------*/
+DLL_EXPORT int dasdio_pread (int fd, void *buf, int len, off_t off)
+{
+int             rc;                     /* Return code               */
+int             n = 0;                  /* Bytes read                */
+
+    while (n < len)
+    {
+#if defined(OPTION_IO_URING)
+        rc = -1;
+        errno = ECANCELED;
+        if (dasdioinit > 0)
+            rc = dasdio_rw (IORING_OP_READ, fd, (BYTE *)buf + n, len - n, off + n);
+        if (rc < 0 && errno == ECANCELED)
+#endif
+        {
+            if (lseek (fd, off + n, SEEK_SET) < 0)
+                return -1;
+            rc = read (fd, (BYTE *)buf + n, len - n);
+        }
+        if (rc < 0)
+            return -1;
+        if (rc == 0)
+            break;
+        n += rc;
+    }
+    return n;
+
+} /* end function dasdio_pread */
+
+/*-------------------------------------------------------------------*/
+/* Write to a dasd image file                                        */
+/*-------------------------------------------------------------------*/
+DLL_EXPORT int dasdio_pwrite (int fd, void *buf, int len, off_t off)
+{
+int             rc;                     /* Return code               */
+int             n = 0;                  /* Bytes written             */
+
+    while (n < len)
+    {
+#if defined(OPTION_IO_URING)
+        rc = -1;
+        errno = ECANCELED;
+        if (dasdioinit > 0)
+            rc = dasdio_rw (IORING_OP_WRITE, fd, (BYTE *)buf + n, len - n, off + n);
+        if (rc < 0 && errno == ECANCELED)
+#endif
+        {
+            if (lseek (fd, off + n, SEEK_SET) < 0)
+                return -1;
+            rc = write (fd, (BYTE *)buf + n, len - n);
+        }
+        if (rc < 0)
+            return -1;
+        if (rc == 0)
+            break;
+        n += rc;
+    }
+    return n;
+
+} /* end function dasdio_pwrite */
+
+/*-------------------------------------------------------------------*/
+/* Map a dasd image file                                             */
+/*-------------------------------------------------------------------*/
+DLL_EXPORT BYTE *dasdio_map (int fd, off_t len, int rdonly)
+{
+#if defined(OPTION_DASD_MMAP)
+void           *p;                      /* -> Mapping                */
+
+    if (len <= 0 || (off_t)(size_t)len != len)
+    {
+        errno = EFBIG;
+        return NULL;
+    }
+    p = mmap (NULL, (size_t)len, rdonly ? PROT_READ : PROT_READ|PROT_WRITE,
+              MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED)
+        return NULL;
+#if defined(MADV_RANDOM)
+    /* Tracks are referenced in channel program order, not sequentially */
+    madvise (p, (size_t)len, MADV_RANDOM);
+#endif
+    return (BYTE *)p;
+#else /* !defined(OPTION_DASD_MMAP) */
+    UNREFERENCED(fd);
+    UNREFERENCED(len);
+    UNREFERENCED(rdonly);
+    errno = ENOSYS;
+    return NULL;
+#endif /* defined(OPTION_DASD_MMAP) */
+} /* end function dasdio_map */
+
+/*-------------------------------------------------------------------*/
+/* Check whether a range of a mapped dasd image file is in storage   */
+/*-------------------------------------------------------------------*/
+DLL_EXPORT int dasdio_resident (BYTE *map, off_t off, int len)
+{
+#if defined(OPTION_DASD_MMAP)
+off_t           pgsz;                   /* Host page size            */
+off_t           lo;                     /* Page aligned start offset */
+size_t          n;                      /* Pages to check            */
+size_t          i;                      /* Index                     */
+unsigned char   vec[64];                /* Page residency flags      */
+
+    pgsz = (off_t)sysconf(_SC_PAGESIZE);
+    for (lo = off & ~(pgsz - 1); lo < off + len; lo += n * pgsz)
+    {
+        n = (size_t)((off + len - lo + pgsz - 1) / pgsz);
+        if (n > sizeof(vec))
+            n = sizeof(vec);
+        /* Assume the worst if the host can not tell */
+        if (mincore (map + lo, n * (size_t)pgsz, (void *)vec) < 0)
+            return 0;
+        for (i = 0; i < n; i++)
+            if (!(vec[i] & 1))
+                return 0;
+    }
+    return 1;
+#else /* !defined(OPTION_DASD_MMAP) */
+    UNREFERENCED(map);
+    UNREFERENCED(off);
+    UNREFERENCED(len);
+    return 1;
+#endif /* defined(OPTION_DASD_MMAP) */
+} /* end function dasdio_resident */
+
+/*-------------------------------------------------------------------*/
+/* Bring a range of a mapped dasd image file into storage            */
+/*-------------------------------------------------------------------*/
+/* The range is read with normal file i/o, which fills the host page */
+/* cache shared with the mapping, so a host read error is returned   */
+/* here rather than raising SIGBUS when the mapping is referenced.   */
+/*-------------------------------------------------------------------*/
+DLL_EXPORT int dasdio_load (int fd, BYTE *map, off_t off, int len)
+{
+#if defined(OPTION_DASD_MMAP)
+BYTE            buf[4096];              /* Discarded data            */
+int             n;                      /* Bytes to read             */
+int             rc;                     /* Return code               */
+
+    if (dasdio_resident (map, off, len))
+        return 0;
+    while (len > 0)
+    {
+        n = len < (int)sizeof(buf) ? len : (int)sizeof(buf);
+        rc = pread (fd, buf, n, off);
+        if (rc <= 0)
+        {
+            if (rc == 0)
+                errno = EIO;
+            return -1;
+        }
+        off += rc;
+        len -= rc;
+    }
+    return 0;
+#else /* !defined(OPTION_DASD_MMAP) */
+    UNREFERENCED(fd);
+    UNREFERENCED(map);
+    UNREFERENCED(off);
+    UNREFERENCED(len);
+    return 0;
+#endif /* defined(OPTION_DASD_MMAP) */
+} /* end function dasdio_load */
+
+/*-------------------------------------------------------------------*/
+/* Write back an updated range of a mapped dasd image file           */
+/*-------------------------------------------------------------------*/
+DLL_EXPORT int dasdio_sync (BYTE *map, off_t off, int len, int wait)
+{
+#if defined(OPTION_DASD_MMAP)
+off_t           pgsz;                   /* Host page size            */
+off_t           lo;                     /* Page aligned start offset */
+
+    pgsz = (off_t)sysconf(_SC_PAGESIZE);
+    lo = off & ~(pgsz - 1);
+    return msync (map + lo, (size_t)(off + len - lo),
+                  wait ? MS_SYNC : MS_ASYNC);
+#else /* !defined(OPTION_DASD_MMAP) */
+    UNREFERENCED(map);
+    UNREFERENCED(off);
+    UNREFERENCED(len);
+    UNREFERENCED(wait);
+    errno = ENOSYS;
+    return -1;
+#endif /* defined(OPTION_DASD_MMAP) */
+} /* end function dasdio_sync */
+
+/*-------------------------------------------------------------------*/
+/* Unmap a dasd image file                                           */
+/*-------------------------------------------------------------------*/
+DLL_EXPORT void dasdio_unmap (BYTE *map, off_t len)
+{
+#if defined(OPTION_DASD_MMAP)
+    msync (map, (size_t)len, MS_SYNC);
+    munmap (map, (size_t)len);
+#else /* !defined(OPTION_DASD_MMAP) */
+    UNREFERENCED(map);
+    UNREFERENCED(len);
+#endif /* defined(OPTION_DASD_MMAP) */
+} /* end function dasdio_unmap */
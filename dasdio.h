@@ -0,0 +1,148 @@
+/* DASDIO.H   (c)Copyright The Hercules Project, 2026                */
+/*            DASD image file i/o using io_uring or mmap             */
+
+/*-------------------------------------------------------------------
+  Description:
+    Positional reads and writes for the dasd image files.  When the
+    host supports io_uring and a device is defined with the `iouring'
+    option, requests from all device, readahead and writer threads
+    are queued on a single submission ring.  Requests queued while
+    another thread is in the kernel submitting are picked up by that
+    thread, so under load many requests go to the kernel in a single
+    io_uring_enter call.
+
+    The calling thread waits for its request to complete, as channel
+    program execution requires the data before continuing.  There is
+    no completion thread: one waiting thread at a time submits and
+    waits for completions in the same io_uring_enter call, then wakes
+    only the threads whose requests completed.  An uncontended request
+    so costs one system call, like pread.  If io_uring_enter fails
+    with an unexpected error the ring is abandoned: requests not yet
+    taken by the kernel, and all later ones, use normal file i/o.
+
+  APIs:
+
+      int         dasdio_init (void);
+                  Create the ring and the completion thread if not
+                  already done.  Returns 0 if io_uring i/o can be
+                  used, otherwise -1 (message issued once).
+
+      int         dasdio_pread (int fd, void *buf, int len, off_t off);
+      int         dasdio_pwrite (int fd, void *buf, int len, off_t off);
+                  Read or write `len' bytes at offset `off'.  Return
+                  the number of bytes transferred, which is less than
+                  `len' only at end of file, or -1 with errno set.
+
+      int         dasdio_active (void);
+                  Returns 1 if the ring has been created and is in use.
+
+    An image file may instead be mapped into storage when the device
+    is defined with the `mmap' option.  Track and block group reads
+    then reference the mapping directly, so the host page cache is the
+    only cache and no copy is made into a device buffer.
+
+      BYTE       *dasdio_map (int fd, off_t len, int rdonly);
+                  Map `len' bytes of the file from offset 0, shared,
+                  read-only if `rdonly'.  Returns NULL with errno set
+                  if the file can not be mapped.
+
+      int         dasdio_resident (BYTE *map, off_t off, int len);
+                  Returns 1 if the range is in host storage, so that
+                  referencing it will not wait for a host disk read.
+
+      int         dasdio_load (int fd, BYTE *map, off_t off, int len);
+                  Read the range with normal file i/o unless it is
+                  already in host storage.  Returns 0, or -1 with errno
+                  set if the host read failed.
+
+      int         dasdio_sync (BYTE *map, off_t off, int len, int wait);
+                  Schedule write back of the updated range, or wait for
+                  it to complete if `wait'.  Returns 0 or -1.
+
+      void        dasdio_unmap (BYTE *map, off_t len);
+                  Write back and remove the mapping.
+
+ -------------------------------------------------------------------*/
+
+#ifndef _HERCULES_DASDIO_H
+#define _HERCULES_DASDIO_H 1
+
+#include "hercules.h"
+
+#ifndef _DASDIO_C_
+#ifndef _HDASD_DLL_
+#define DIO_DLL_IMPORT DLL_IMPORT
+#else   /* _HDASD_DLL_ */
+#define DIO_DLL_IMPORT extern
+#endif  /* _HDASD_DLL_ */
+#else
+#define DIO_DLL_IMPORT DLL_EXPORT
+#endif
+
+/*-------------------------------------------------------------------*/
+/* Public definitions                                                */
+/*-------------------------------------------------------------------*/
+DIO_DLL_IMPORT int dasdio_init (void);
+DIO_DLL_IMPORT int dasdio_pread (int fd, void *buf, int len, off_t off);
+DIO_DLL_IMPORT int dasdio_pwrite (int fd, void *buf, int len, off_t off);
+DIO_DLL_IMPORT int dasdio_active (void);
+DIO_DLL_IMPORT BYTE *dasdio_map (int fd, off_t len, int rdonly);
+DIO_DLL_IMPORT int dasdio_resident (BYTE *map, off_t off, int len);
+DIO_DLL_IMPORT int dasdio_load (int fd, BYTE *map, off_t off, int len);
+DIO_DLL_IMPORT int dasdio_sync (BYTE *map, off_t off, int len, int wait);
+DIO_DLL_IMPORT void dasdio_unmap (BYTE *map, off_t len);
+
+/*-------------------------------------------------------------------*/
+/* Private definitions                                               */
+/*-------------------------------------------------------------------*/
+#ifdef _DASDIO_C_
+
+#define DASDIO_RING_ENTRIES   256       /* Submission ring entries   */
+
+#if defined(OPTION_IO_URING)
+
+/* A request waiting for completion; lives on the caller's stack     */
+typedef struct _DASDIO_REQ {
+        struct _DASDIO_REQ *next;       /* -> Next waiting request   */
+        COND            cond;           /* Completion condition      */
+        int             done;           /* 1=Request completed       */
+        int             res;            /* Bytes or -errno           */
+} DASDIO_REQ;
+
+typedef struct _DASDIO_RING {
+        LOCK            lock;           /* Submission lock           */
+        COND            cond;           /* Ring space condition      */
+        int             fd;             /* io_uring file descriptor  */
+        unsigned        entries;        /* Submission ring entries   */
+        unsigned        queued;         /* Queued, not yet submitted */
+        unsigned        inflight;       /* Submitted, not completed  */
+        int             submitting;     /* 1=Thread is submitting    */
+        int             reaping;        /* 1=Thread is reaping       */
+        int             failed;         /* 1=Ring no longer used     */
+        int             spacewaiters;   /* Number waiting for space  */
+        DASDIO_REQ     *waiters;        /* -> Waiting requests       */
+
+        /* Submission ring */
+        void           *sqring;         /* -> Mapped submission ring */
+        size_t          sqringsz;       /* Submission ring size      */
+        unsigned       *sqhead;         /* -> Kernel consumer index  */
+        unsigned       *sqtail;         /* -> Our producer index     */
+        unsigned        sqmask;         /* Submission ring mask      */
+        unsigned       *sqarray;        /* -> Submission index array */
+        struct io_uring_sqe *sqes;      /* -> Submission entries     */
+        size_t          sqessz;         /* Submission entries size   */
+
+        /* Completion ring */
+        void           *cqring;         /* -> Mapped completion ring */
+        size_t          cqringsz;       /* Completion ring size      */
+        unsigned       *cqhead;         /* -> Our consumer index     */
+        unsigned       *cqtail;         /* -> Kernel producer index  */
+        unsigned        cqmask;         /* Completion ring mask      */
+        struct io_uring_cqe *cqes;      /* -> Completion entries     */
+} DASDIO_RING;
+
+#endif /* defined(OPTION_IO_URING) */
+
+#endif /* _DASDIO_C_ */
+
+#endif /* _HERCULES_DASDIO_H */
@@ -144,6 +144,12 @@ argexit ( int code )
 #endif
 #ifdef CCKD_COMPRESS_BZIP2
             "\t-bz2: compress using bzip2\n"
+#endif
+#ifdef CCKD_LZ4
+            "\t-lz4: compress using lz4\n"
+#endif
+#ifdef CCKD_ZSTD
+            "\t-zstd: compress using zstd\n"
 #endif
             );
     if (sizeof(off_t) > 4)
@@ -5002,6 +5008,14 @@ char            pathname[MAX_PATH];     /* cfname in host path format*/
 #ifdef CCKD_COMPRESS_BZIP2
         else if (strcmp("bz2", &argv[1][1]) == 0)
             comp = CCKD_COMPRESS_BZIP2;
+#endif
+#ifdef CCKD_LZ4
+        else if (strcmp("lz4", &argv[1][1]) == 0)
+            comp = CCKD_COMPRESS_LZ4;
+#endif
+#ifdef CCKD_ZSTD
+        else if (strcmp("zstd", &argv[1][1]) == 0)
+            comp = CCKD_COMPRESS_ZSTD;
 #endif
         else if (strcmp("a", &argv[1][1]) == 0)
             altcylflag = 1;
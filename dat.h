@@ -724,6 +724,146 @@ U16     eax;                            /* Authorization index       */
 } /* end function load_address_space_designator */
 
 
+/*-------------------------------------------------------------------*/
+/* Move a second level TLB entry to way 0 of its set                 */
+/*                                                                   */
+/* Input:                                                            */
+/*      l2      Pointer to the second level TLB                      */
+/*      ix      Second level TLB set index                           */
+/*      way     Way of the entry to be moved                         */
+/*                                                                   */
+/*      Ways 0 through way-1 of the set are moved down one position. */
+/*      When way is the last way of the set, the least recently      */
+/*      used entry is thereby rotated into way 0 to be replaced.     */
+/*-------------------------------------------------------------------*/
+static inline void ARCH_DEP(rotate_tlb2e) (TLB2 *l2, int ix, int way)
+{
+int     i, j;                           /* TLB entry indexes         */
+DW      asd, vaddr, pte;                /* Saved entry fields        */
+BYTE    common, protect;                /* Saved entry fields        */
+
+    j = ix + way * l2->sets;
+    asd     = l2->asd[j];
+    vaddr   = l2->vaddr[j];
+    pte     = l2->pte[j];
+    common  = l2->common[j];
+    protect = l2->protect[j];
+
+    for ( ; j != ix; j = i)
+    {
+        i = j - l2->sets;
+        l2->asd[j]     = l2->asd[i];
+        l2->vaddr[j]   = l2->vaddr[i];
+        l2->pte[j]     = l2->pte[i];
+        l2->common[j]  = l2->common[i];
+        l2->protect[j] = l2->protect[i];
+    }
+
+    l2->asd[ix]     = asd;
+    l2->vaddr[ix]   = vaddr;
+    l2->pte[ix]     = pte;
+    l2->common[ix]  = common;
+    l2->protect[ix] = protect;
+
+} /* end function rotate_tlb2e */
+
+
+/*-------------------------------------------------------------------*/
+/* Search the second level TLB for a virtual address                 */
+/*                                                                   */
+/* Input:                                                            */
+/*      vaddr   Virtual address to be looked up                      */
+/*      regs    Pointer to the CPU register context; regs->dat.asd   */
+/*              and regs->dat.private must already have been set     */
+/*      tlbix   TLB entry index                                      */
+/*                                                                   */
+/*      Called by translate_addr before it examines the TLB entry.   */
+/*      If that entry does not match but the second level TLB holds  */
+/*      the translation then it is copied to the TLB entry, so that  */
+/*      no table lookup is needed.  Otherwise the miss is counted.   */
+/*-------------------------------------------------------------------*/
+static inline void ARCH_DEP(search_tlb) (VADR vaddr, REGS *regs, int tlbix)
+{
+TLB2   *l2 = &regs->tlb.l2;             /* -> Second level TLB       */
+int     ix;                             /* Second level set index    */
+int     i;                              /* Second level entry index  */
+int     way;                            /* Way within set            */
+
+    if (   ((vaddr & TLBID_PAGEMASK) | regs->tlbID) == regs->tlb.TLB_VADDR(tlbix)
+        && (regs->tlb.common[tlbix] || regs->dat.asd == regs->tlb.TLB_ASD(tlbix))
+        && !(regs->tlb.common[tlbix] && regs->dat.private) )
+        return;
+
+    ix = ((VADR_L)vaddr >> TLB_PAGESHIFT) & l2->mask;
+    for (way = 0, i = ix; way < l2->ways; way++, i += l2->sets)
+    {
+        if (   ((vaddr & TLBID_PAGEMASK) | regs->tlbID) == l2->TLB_VADDR(i)
+            && (l2->common[i] || regs->dat.asd == l2->TLB_ASD(i))
+            && !(l2->common[i] && regs->dat.private) )
+        {
+            regs->tlb.l2hits++;
+            if (way)
+                ARCH_DEP(rotate_tlb2e) (l2, ix, way);
+            regs->tlb.TLB_ASD(tlbix)   = l2->TLB_ASD(ix);
+            regs->tlb.TLB_VADDR(tlbix) = l2->TLB_VADDR(ix);
+            regs->tlb.TLB_PTE(tlbix)   = l2->TLB_PTE(ix);
+            regs->tlb.common[tlbix]    = l2->common[ix];
+            regs->tlb.protect[tlbix]   = l2->protect[ix];
+            regs->tlb.acc[tlbix]       = 0;
+            regs->tlb.main[tlbix]      = NULL;
+            return;
+        }
+    }
+
+    regs->tlb.misses++;
+
+} /* end function search_tlb */
+
+
+/*-------------------------------------------------------------------*/
+/* Copy a new TLB entry to the second level TLB                      */
+/*                                                                   */
+/* Input:                                                            */
+/*      vaddr   Virtual address of the translation                   */
+/*      regs    Pointer to the CPU register context                  */
+/*      tlbix   TLB entry index                                      */
+/*                                                                   */
+/*      The entry replaces the least recently used way of its set.   */
+/*-------------------------------------------------------------------*/
+static inline void ARCH_DEP(fill_tlb2) (VADR vaddr, REGS *regs, int tlbix)
+{
+TLB2   *l2 = &regs->tlb.l2;             /* -> Second level TLB       */
+int     ix;                             /* Second level set index    */
+
+    if (l2->entries == 0)
+        return;
+
+    ix = ((VADR_L)vaddr >> TLB_PAGESHIFT) & l2->mask;
+    if (l2->ways > 1)
+        ARCH_DEP(rotate_tlb2e) (l2, ix, l2->ways - 1);
+    l2->TLB_ASD(ix)   = regs->tlb.TLB_ASD(tlbix);
+    l2->TLB_VADDR(ix) = regs->tlb.TLB_VADDR(tlbix);
+    l2->TLB_PTE(ix)   = regs->tlb.TLB_PTE(tlbix);
+    l2->common[ix]    = regs->tlb.common[tlbix];
+    l2->protect[ix]   = regs->tlb.protect[tlbix];
+
+} /* end function fill_tlb2 */
+
+
+/*-------------------------------------------------------------------*/
+/* Purge second level TLB entries for a page frame                   */
+/*-------------------------------------------------------------------*/
+static inline void ARCH_DEP(purge_tlb2e) (TLB2 *l2, RADR pte, RADR ptemask)
+{
+int     i;                              /* Second level entry index  */
+
+    for (i = 0; i < l2->entries; i++)
+        if ((l2->TLB_PTE(i) & ptemask) == pte)
+            l2->TLB_VADDR(i) &= TLBID_PAGEMASK;
+
+} /* end function purge_tlb2e */
+
+
 /*-------------------------------------------------------------------*/
 /* Translate a virtual address to a real address                     */
 /*                                                                   */
@@ -844,6 +984,9 @@ U32     ptl;                            /* Page table length         */
        goto tran_spec_excp;
 
     /* Look up the address in the TLB */
+    if (!(acctype & ACC_NOTLB))
+        ARCH_DEP(search_tlb) (vaddr, regs, tlbix);
+
     if (   ((vaddr & TLBID_PAGEMASK) | regs->tlbID) == regs->tlb.TLB_VADDR(tlbix)
         && (regs->tlb.common[tlbix] || regs->dat.asd == regs->tlb.TLB_ASD(tlbix))
         && !(regs->tlb.common[tlbix] && regs->dat.private) 
@@ -949,6 +1092,7 @@ U32     ptl;                            /* Page table length         */
             regs->tlb.protect[tlbix]   = regs->dat.protect;
             regs->tlb.acc[tlbix]       = 0;
             regs->tlb.main[tlbix]       = NULL;
+            ARCH_DEP(fill_tlb2) (vaddr, regs, tlbix);
 
         /* Set adjacent TLB entry if 4K page sizes */
             if ((regs->CR(0) & CR0_PAGE_SIZE) == CR0_PAGE_SZ_4K)
@@ -960,6 +1104,7 @@ U32     ptl;                            /* Page table length         */
                 regs->tlb.protect[tlbix^1]   = regs->tlb.protect[tlbix];
                 regs->tlb.acc[tlbix^1]       = 0;
                 regs->tlb.main[tlbix^1]      = NULL;
+                ARCH_DEP(fill_tlb2) (vaddr ^ 0x800, regs, tlbix^1);
             }
         }
     } /* end if(!TLB) */
@@ -999,6 +1144,9 @@ U32     ptl;                            /* Page table length         */
     regs->dat.private = ((regs->dat.asd & STD_PRIVATE) != 0);
 
     /* [3.11.4] Look up the address in the TLB */
+    if (!(acctype & ACC_NOTLB))
+        ARCH_DEP(search_tlb) (vaddr, regs, tlbix);
+
     if (   ((vaddr & TLBID_PAGEMASK) | regs->tlbID) == regs->tlb.TLB_VADDR(tlbix)
         && (regs->tlb.common[tlbix] || regs->dat.asd == regs->tlb.TLB_ASD(tlbix))
         && !(regs->tlb.common[tlbix] && regs->dat.private) 
@@ -1087,6 +1235,7 @@ U32     ptl;                            /* Page table length         */
             regs->tlb.acc[tlbix]       = 0;
             regs->tlb.protect[tlbix]   = regs->dat.protect;
             regs->tlb.main[tlbix]       = NULL;
+            ARCH_DEP(fill_tlb2) (vaddr, regs, tlbix);
         }
     } /* end if(!TLB) */
 
@@ -1132,6 +1281,9 @@ U16     sx, px;                         /* Segment and page index,
 //  logmsg("asce=%16.16" I64_FMT "X\n",regs->dat.asd);
 
     /* [3.11.4] Look up the address in the TLB */
+    if (!(acctype & ACC_NOTLB))
+        ARCH_DEP(search_tlb) (vaddr, regs, tlbix);
+
     if (   ((vaddr & TLBID_PAGEMASK) | regs->tlbID) == regs->tlb.TLB_VADDR(tlbix)
         && (regs->tlb.common[tlbix] || regs->dat.asd == regs->tlb.TLB_ASD(tlbix))
         && !(regs->tlb.common[tlbix] && regs->dat.private) 
@@ -1386,6 +1538,7 @@ U16     sx, px;                         /* Segment and page index,
                         regs->tlb.protect[tlbix] = regs->dat.protect;
                         regs->tlb.acc[tlbix] = 0;
                         regs->tlb.main[tlbix] = NULL;
+                        ARCH_DEP(fill_tlb2) (vaddr, regs, tlbix);
                     }
 
                     /* Clear exception code and return with zero return code */
@@ -1482,6 +1635,7 @@ U16     sx, px;                         /* Segment and page index,
                     regs->tlb.protect[tlbix]   = regs->dat.protect;
                     regs->tlb.acc[tlbix]       = 0;
                     regs->tlb.main[tlbix]      = NULL;
+                    ARCH_DEP(fill_tlb2) (vaddr, regs, tlbix);
                 }
 
                 /* Clear exception code and return with zero return code */
@@ -1548,6 +1702,7 @@ U16     sx, px;                         /* Segment and page index,
             regs->tlb.protect[tlbix]   = regs->dat.protect;
             regs->tlb.acc[tlbix]       = 0;
             regs->tlb.main[tlbix]      = NULL;
+            ARCH_DEP(fill_tlb2) (vaddr, regs, tlbix);
         }
     }
 
@@ -1781,9 +1936,17 @@ tran_excp_addr:
 _DAT_C_STATIC void ARCH_DEP(purge_tlb) (REGS *regs)
 {
     INVALIDATE_AIA(regs);
+#if defined(OPTION_BLOCK_CACHE)
+    /* Discard the cached blocks of this CPU */
+    if (regs->bbc)
+        regs->bbc->gen++;
+#endif /*defined(OPTION_BLOCK_CACHE)*/
     if (((++regs->tlbID) & TLBID_BYTEMASK) == 0)
     {
         memset (&regs->tlb.vaddr, 0, TLBN * sizeof(DW));
+        if (regs->tlb.l2.entries)
+            memset (regs->tlb.l2.vaddr, 0,
+                    regs->tlb.l2.entries * sizeof(DW));
         regs->tlbID = 1;
     }
 #if defined(_FEATURE_SIE)
@@ -1794,6 +1957,9 @@ _DAT_C_STATIC void ARCH_DEP(purge_tlb) (REGS *regs)
         if (((++regs->guestregs->tlbID) & TLBID_BYTEMASK) == 0)
         {
             memset (&regs->guestregs->tlb.vaddr, 0, TLBN * sizeof(DW));
+            if (regs->guestregs->tlb.l2.entries)
+                memset (regs->guestregs->tlb.l2.vaddr, 0,
+                        regs->guestregs->tlb.l2.entries * sizeof(DW));
             regs->guestregs->tlbID = 1;
         }
     }
@@ -1845,6 +2011,12 @@ RADR ptemask;
     for (i = 0; i < TLBN; i++)
         if ((regs->tlb.TLB_PTE(i) & ptemask) == pte)
             regs->tlb.TLB_VADDR(i) &= TLBID_PAGEMASK;
+    ARCH_DEP(purge_tlb2e) (&regs->tlb.l2, pte, ptemask);
+
+    /* Discard the blocks built from the page frame, which is about
+       to be given new contents */
+    BBC_INVALIDATE(sysblk.mainstor + APPLY_PREFIXING (pfra, regs->PX),
+                   PAGEFRAME_PAGESIZE);
 
 #if defined(_FEATURE_SIE)
     /* Also clear the guest registers in the SIE copy */
@@ -1869,6 +2041,10 @@ RADR ptemask;
             if ((regs->guestregs->tlb.TLB_PTE(i) & ptemask) == pte ||    /* @PJJ */
                  (regs->hostregs->tlb.TLB_PTE(i) & ptemask) == pte)      /* @PJJ */
                 regs->guestregs->tlb.TLB_VADDR(i) &= TLBID_PAGEMASK;
+
+        /* The second level TLB only holds guest DAT translations,
+           whose host translation is redone when they are used */
+        ARCH_DEP(purge_tlb2e) (&regs->guestregs->tlb.l2, pte, ptemask);
     }
     else
     /* For guests, clear any host entries */
@@ -1878,6 +2054,7 @@ RADR ptemask;
         for (i = 0; i < TLBN; i++)
             if ((regs->hostregs->tlb.TLB_PTE(i) & ptemask) == pte)
                 regs->hostregs->tlb.TLB_VADDR(i) &= TLBID_PAGEMASK;
+        ARCH_DEP(purge_tlb2e) (&regs->hostregs->tlb.l2, pte, ptemask);
     }
 #endif /*defined(_FEATURE_SIE)*/
 
@@ -2229,6 +2406,9 @@ _LOGICAL_C_STATIC BYTE *ARCH_DEP(logical_to_main_l) (VADR addr, int arn,
 RADR    aaddr;                          /* Absolute address          */
 RADR    apfra;                          /* Abs page frame address    */
 int     ix = TLBIX(addr);               /* TLB index                 */
+#if defined(OPTION_BLOCK_CACHE)
+int     bbc = 0;                        /* Block cache store result  */
+#endif /*defined(OPTION_BLOCK_CACHE)*/
 
     /* Convert logical address to real address */
     if ( (REAL_MODE(&regs->psw) || arn == USE_REAL_ADDR)
@@ -2344,6 +2524,17 @@ int     ix = TLBIX(addr);               /* TLB index                 */
     /* Check protection and set reference and change bits */
     regs->dat.storkey = &(STORAGE_KEY(aaddr, regs));
 
+#if defined(OPTION_BLOCK_CACHE)
+    /* Check stores against the frames holding cached blocks */
+    if (!(acctype & ACC_READ) && sysblk.bbcframe)
+    {
+        bbc = bbc_store (aaddr, len, acctype,
+                         addr < PSA_SIZE && !regs->dat.private);
+        if (bbc == 2)
+            INVALIDATE_AIA(regs);
+    }
+#endif /*defined(OPTION_BLOCK_CACHE)*/
+
 #if defined(_FEATURE_SIE)
     /* Do not apply host key access when SIE fetches/stores data */
     if (unlikely(SIE_ACTIVE(regs)))
@@ -2392,6 +2583,13 @@ int     ix = TLBIX(addr);               /* TLB index                 */
                               :  ACC_READ;
         regs->tlb.main[ix]    = NEW_MAINADDR (regs, addr, apfra);
 
+#if defined(OPTION_BLOCK_CACHE)
+        /* Keep stores into frames holding cached blocks out of the
+           TLB, so that they are all checked by bbc_store */
+        if (bbc == 1)
+            regs->tlb.acc[ix] = ACC_READ;
+#endif /*defined(OPTION_BLOCK_CACHE)*/
+
 #if defined(FEATURE_PER)
         if (EN_IC_PER_SA(regs))
         {
@@ -1241,12 +1241,12 @@ static int ecpsvm_tranbrng(REGS *regs,VADR cortabad,VADR pgadd,RADR *raddr)
     pg1=(*raddr & 0xfff000);
     pg2=pg1+0x800;
     DEBUG_CPASSISTX(TRBRG,logmsg(_("HHCEV300D : Checking 2K Storage keys @"F_RADR" & "F_RADR"\n"),pg1,pg2));
-    if((STORAGE_KEY(pg1,regs) & STORKEY_CHANGE) ||
-            (STORAGE_KEY(pg2,regs) & STORKEY_CHANGE))
+    if(((STORAGE_KEY(pg1,regs) | STORKEY_SAVEDC(pg1,regs)) & STORKEY_CHANGE) ||
+            ((STORAGE_KEY(pg2,regs) | STORKEY_SAVEDC(pg2,regs)) & STORKEY_CHANGE))
     {
 #else
     DEBUG_CPASSISTX(TRBRG,logmsg(_("HHCEV300D : Checking 4K Storage keys @"F_RADR"\n"),*raddr));
-    if(STORAGE_KEY(*raddr,regs) & STORKEY_CHANGE)
+    if((STORAGE_KEY(*raddr,regs) | STORKEY_SAVEDC(*raddr,regs)) & STORKEY_CHANGE)
     {
 #endif
         DEBUG_CPASSISTX(TRBRG,logmsg(_("HHCEV300D : Page shared and changed\n")));
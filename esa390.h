@@ -158,9 +158,23 @@ typedef struct  _PSW {
 /* Structure definition for translation-lookaside buffer entry */
 #define TLBN            1024            /* Number TLB entries        */
 #define TLB_MASK        0x3FF           /* Mask for 1024 entries     */
+#define TLB_MAXSETS     65536           /* Max second level TLB sets */
+#define TLB_MAXWAYS     4               /* Max second level TLB ways */
 #define TLB_REAL_ASD_L  0xFFFFFFFF      /* ASD values for real mode  */
 #define TLB_REAL_ASD_G  0xFFFFFFFFFFFFFFFFULL
 #define TLB_HOST_ASD    0x800           /* Host entry for XC guest   */
+typedef struct _TLB2 {
+        DW             *asd;            /* Address space designator  */
+        DW             *vaddr;          /* Virtual page address      */
+        DW             *pte;            /* Copy of page table entry  */
+        BYTE           *common;         /* 1=Page in common segment  */
+        BYTE           *protect;        /* 1=Page in protected segmnt*/
+        U32             mask;           /* Set index mask (sets-1)   */
+        U32             sets;           /* Number of sets            */
+        int             ways;           /* Number of entries per set */
+        int             entries;        /* Number of entries, or 0
+                                           if no second level TLB    */
+    } TLB2;
 typedef struct _TLB  {
         DW              asd[TLBN];      /* Address space designator  */
 #define TLB_ASD_G(_n)   asd[(_n)].D
@@ -177,6 +191,11 @@ typedef struct _TLB  {
         BYTE            common[TLBN];   /* 1=Page in common segment  */
         BYTE            protect[TLBN];  /* 1=Page in protected segmnt*/
         BYTE            acc[TLBN];      /* Access type flags         */
+        TLB2            l2;             /* Second level TLB          */
+        U64             l2hits;         /* Translations found in the
+                                           second level TLB          */
+        U64             misses;         /* Translations which walked
+                                           the DAT tables            */
     } TLB;
 
 /* TLB Notes -
@@ -184,6 +203,11 @@ typedef struct _TLB  {
  * protect.
  * Fields set by logical_to_main() are main, storkey, skey, read and
  * write and are used for accelerated address lookup (formerly AEA).
+ * The optional second level TLB configured by the TLBSIZE statement
+ * holds a copy of the translate_addr() fields of each translation.
+ * It is searched only by translate_addr() when the first level entry
+ * does not match, so the accelerated lookup is not affected.  Way n
+ * of second level set i is entry i + n * sets.
  */
 
 /* Structure for Dynamic Address Translation */
@@ -5499,9 +5499,10 @@ int     page_offset;                    /* Low order bits of R2      */
 
                             protkey =
 #if !defined(_FEATURE_2K_STORAGE_KEYS)
-                                      STORAGE_KEY(n, regs)
+                                      (STORAGE_KEY(n, regs) | STORKEY_SAVEDC(n, regs))
 #else
-                                      (STORAGE_KEY1(n, regs) | STORAGE_KEY2(n, regs))
+                                      (STORAGE_KEY1(n, regs) | STORAGE_KEY2(n, regs)
+                                       | STORKEY_SAVEDC4K(n, regs))
 #endif
                                                                                       ;
                             realkey = protkey & (STORKEY_REF | STORKEY_CHANGE);
@@ -5529,6 +5530,7 @@ int     page_offset;                    /* Low order bits of R2      */
                         if(!sr)
 #endif /*defined(_FEATURE_STORAGE_KEY_ASSIST)*/
                         {
+                            STORKEY_CHGSAVE(aaddr, regs);
 #if !defined(_FEATURE_2K_STORAGE_KEYS)
                             STORAGE_KEY(aaddr, regs) &= STORKEY_BADFRM;
                             STORAGE_KEY(aaddr, regs) |= sk
@@ -5549,13 +5551,15 @@ int     page_offset;                    /* Low order bits of R2      */
                     /* Perform conditional SSKE procedure */
                     if (ARCH_DEP(conditional_key_procedure)(mask,
 #if defined(FEATURE_4K_STORAGE_KEYS) && !defined(_FEATURE_2K_STORAGE_KEYS)
-                            STORAGE_KEY(aaddr, regs),
+                            (STORAGE_KEY(aaddr, regs) | STORKEY_SAVEDC(aaddr, regs)),
 #else
-                            (STORAGE_KEY1(aaddr, regs) | STORAGE_KEY2(aaddr, regs)),
+                            (STORAGE_KEY1(aaddr, regs) | STORAGE_KEY2(aaddr, regs)
+                             | STORKEY_SAVEDC4K(aaddr, regs)),
 #endif
                         sk))
                         return;
                     /* Update the storage key from R1 register bits 24-30 */
+                    STORKEY_CHGSAVE(aaddr, regs);
 #if !defined(_FEATURE_2K_STORAGE_KEYS)
                     STORAGE_KEY(aaddr, regs) &= STORKEY_BADFRM;
                     STORAGE_KEY(aaddr, regs) |= sk & ~(STORKEY_BADFRM);
@@ -5573,14 +5577,16 @@ int     page_offset;                    /* Low order bits of R2      */
                 /* Perform conditional SSKE procedure */
                 if (ARCH_DEP(conditional_key_procedure)(mask,
 #if defined(FEATURE_4K_STORAGE_KEYS) && !defined(_FEATURE_2K_STORAGE_KEYS)
-                        STORAGE_KEY(aaddr, regs),
+                        (STORAGE_KEY(aaddr, regs) | STORKEY_SAVEDC(aaddr, regs)),
 #else
-                        (STORAGE_KEY1(aaddr, regs) | STORAGE_KEY2(n, regs)),
+                        (STORAGE_KEY1(aaddr, regs) | STORAGE_KEY2(n, regs)
+                         | STORKEY_SAVEDC4K(aaddr, regs)),
 #endif
                     sk))
                     return;
 
                 /* Update the storage key from R1 register bits 24-30 */
+                STORKEY_CHGSAVE(aaddr, regs);
 #if defined(FEATURE_4K_STORAGE_KEYS) && !defined(_FEATURE_2K_STORAGE_KEYS)
                 STORAGE_KEY(aaddr, regs) &= STORKEY_BADFRM;
                 STORAGE_KEY(aaddr, regs) |= sk & ~(STORKEY_BADFRM);
@@ -5608,7 +5614,10 @@ int     page_offset;                    /* Low order bits of R2      */
 
         /* Clear Frame Control */
         if(regs->GR_L(r1) & PFMF_FMFI_CF)
+        {
             memset(regs->mainstor + aaddr, 0, PAGEFRAME_PAGESIZE);
+            STORKEY_CHGSET(aaddr, regs);
+        }
 
         /* Update r2 - point to the next frame */
         switch (PFMF_FSC & regs->GR_L(r1)) {
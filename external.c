@@ -104,6 +104,9 @@ int     rc;
         /* Store current PSW at PSA+X'18' */
         ARCH_DEP(store_psw) (regs, psa->extold);
 
+        /* Discard cached blocks built from the PSA */
+        BBC_INVALIDATE(psa, sizeof(*psa));
+
         /* Load new PSW from PSA+X'58' */
         rc = ARCH_DEP(load_psw) (regs, psa->extnew);
 
@@ -84,6 +84,10 @@ char    pathname[MAX_PATH];             /* file path in host format  */
     /* Device is shareable */
     dev->shared = 1;
 
+    /* Default to synchronous file i/o */
+    dev->iouring = 0;
+    dev->dasdmmap = 0;
+
     /* Check for possible remote device */
     hostpath(pathname, dev->filename, sizeof(pathname));
     if (stat(pathname, &statbuf) < 0)
@@ -203,6 +207,19 @@ char    pathname[MAX_PATH];             /* file path in host format  */
                 dev->syncio = 1;
                 continue;
             }
+            if (strcasecmp ("iouring", argv[i]) == 0)
+            {
+                dev->iouring = dasdio_init () == 0;
+                continue;
+            }
+            if (strcasecmp ("noiouring", argv[i]) == 0)
+            {
+                dev->iouring = 0;
+                continue;
+            }
+            if (strcasecmp ("mmap",   argv[i]) == 0
+             || strcasecmp ("nommap", argv[i]) == 0)
+                continue;
 
             logmsg (_("HHCDA063E parameter %d is invalid: %s\n"),
                     i + 1, argv[i]);
@@ -213,6 +230,18 @@ char    pathname[MAX_PATH];             /* file path in host format  */
     /* Processing for regular fba dasd */
     else
     {
+        /* Keyword options follow the origin and block count */
+        for ( ; argc > 1; argc--)
+        {
+            if (strcasecmp ("iouring", argv[argc-1]) == 0)
+                dev->iouring = dasdio_init () == 0;
+            else if (strcasecmp ("mmap", argv[argc-1]) == 0)
+                dev->dasdmmap = 1;
+            else if (strcasecmp ("noiouring", argv[argc-1]) != 0
+                  && strcasecmp ("nommap",    argv[argc-1]) != 0)
+                break;
+        }
+
         /* Determine the device size */
         rc = fstat (dev->fd, &statbuf);
         if (rc < 0)
@@ -282,6 +311,23 @@ char    pathname[MAX_PATH];             /* file path in host format  */
     }
     dev->fbaend = (dev->fbaorigin + dev->fbanumblk) * dev->fbablksiz;
 
+    /* Map the device file if requested */
+    if (dev->dasdmmap && !cfba)
+    {
+        dev->dasdmapsz[0] = dev->fbaend;
+        dev->dasdmap[0] = NULL;
+        if (!dev->batch)
+            dev->dasdmap[0] = dasdio_map (dev->fd, dev->dasdmapsz[0], 0);
+        if (dev->dasdmap[0] == NULL)
+        {
+            if (!dev->batch)
+                logmsg (_("HHCDA090W %4.4X mmap error: %s; "
+                        "using normal file i/o\n"),
+                        dev->devnum, strerror(errno));
+            dev->dasdmmap = 0;
+        }
+    }
+
     logmsg (_("HHCDA067I %s origin=%lld blks=%d\n"),
             dev->filename, (long long)dev->fbaorigin, dev->fbanumblk);
 
@@ -485,6 +531,78 @@ int     copylen;                        /* Length left to copy       */
     return len;
 } /* end function fba_write */
 
+/*-------------------------------------------------------------------*/
+/* Reference a block group in the mapped device file                 */
+/*-------------------------------------------------------------------*/
+static
+int fba_read_mapped_blkgrp (DEVBLK *dev, int blkgrp, BYTE *unitstat)
+{
+off_t           offset;                 /* File offset               */
+
+    /* Retry if synchronous I/O and the block group is not in host
+       storage, as referencing it would wait for a host disk read */
+    if (blkgrp >= 0 && dev->syncio_active
+     && !dasdio_resident (dev->dasdmap[0], (off_t)blkgrp * FBA_BLKGRP_SIZE,
+                          fba_blkgrp_len (dev, blkgrp)))
+    {
+        dev->syncio_retry = 1;
+        return -1;
+    }
+
+    /* Schedule write back of the previous block group if modified */
+    if (dev->bufupd)
+    {
+        dev->bufupd = 0;
+
+        offset = (off_t)(((S64)dev->bufcur * FBA_BLKGRP_SIZE) + dev->bufupdlo);
+        if (dasdio_sync (dev->dasdmap[0], offset,
+                         dev->bufupdhi - dev->bufupdlo, 0) < 0)
+        {
+            logmsg (_("HHCDA091E error writing blkgrp %d: msync error: %s\n"),
+                    dev->bufcur, strerror(errno));
+            dev->sense[0] = SENSE_EC;
+            *unitstat = CSW_CE | CSW_DE | CSW_UC;
+            dev->bufupdlo = dev->bufupdhi = 0;
+            dev->bufcur = -1;
+            return -1;
+        }
+
+        dev->bufupdlo = dev->bufupdhi = 0;
+    }
+    dev->bufcur = -1;
+
+    /* Return on special case when called by the close handler */
+    if (blkgrp < 0)
+        return 0;
+
+    offset = (off_t)((S64)blkgrp * FBA_BLKGRP_SIZE);
+
+    logdevtr (dev, _("HHCDA074I read blkgrp %d offset %" I64_FMT "d len %d\n"),
+              blkgrp, (long long)offset, fba_blkgrp_len(dev, blkgrp));
+
+    /* Read the block group now if it is not in host storage, so a
+       host read error is reported here instead of raising SIGBUS */
+    if (dasdio_load (dev->fd, dev->dasdmap[0], offset,
+                     fba_blkgrp_len (dev, blkgrp)) < 0)
+    {
+        logmsg (_("HHCDA093E error reading blkgrp %d: read error: %s\n"),
+                blkgrp, strerror(errno));
+        dev->sense[0] = SENSE_EC;
+        *unitstat = CSW_CE | CSW_DE | CSW_UC;
+        return -1;
+    }
+
+    dev->buf = dev->dasdmap[0] + offset;
+    dev->bufcur = blkgrp;
+    dev->bufoff = 0;
+    dev->bufoffhi = fba_blkgrp_len (dev, blkgrp);
+    dev->buflen = fba_blkgrp_len (dev, blkgrp);
+    dev->bufsize = dev->buflen;
+
+    return 0;
+
+} /* end function fba_read_mapped_blkgrp */
+
 /*-------------------------------------------------------------------*/
 /* FBA read block group exit                                         */
 /*-------------------------------------------------------------------*/
@@ -495,11 +613,16 @@ int             rc;                     /* Return code               */
 int             i, o;                   /* Cache indexes             */
 int             len;                    /* Length to read            */
 off_t           offset;                 /* File offsets              */
+U64             key;                    /* Cache key                 */
 
     /* Return if reading the same block group */
     if (blkgrp >= 0 && blkgrp == dev->bufcur)
         return 0;
 
+    /* Reference the block group directly if the file is mapped */
+    if (dev->dasdmmap)
+        return fba_read_mapped_blkgrp (dev, blkgrp, unitstat);
+
     /* Write the previous block group if modified */
     if (dev->bufupd)
     {
@@ -514,7 +637,8 @@ off_t           offset;                 /* File offsets              */
 
         /* Seek to the old block group offset */
         offset = (off_t)(((S64)dev->bufcur * FBA_BLKGRP_SIZE) + dev->bufupdlo);
-        offset = lseek (dev->fd, offset, SEEK_SET);
+        if (!dev->iouring)
+            offset = lseek (dev->fd, offset, SEEK_SET);
         if (offset < 0)
         {
             /* Handle seek error condition */
@@ -522,17 +646,21 @@ off_t           offset;                 /* File offsets              */
                     dev->bufcur, strerror(errno));
             dev->sense[0] = SENSE_EC;
             *unitstat = CSW_CE | CSW_DE | CSW_UC;
-            cache_lock(CACHE_DEVBUF);
+            cache_lock_entry(CACHE_DEVBUF, dev->cache);
             cache_setflag(CACHE_DEVBUF, dev->cache, ~FBA_CACHE_ACTIVE, 0);
-            cache_unlock(CACHE_DEVBUF);
+            cache_unlock_entry(CACHE_DEVBUF, dev->cache);
             dev->bufupdlo = dev->bufupdhi = 0;
             dev->bufcur = dev->cache = -1;
             return -1;
         }
 
         /* Write the portion of the block group that was modified */
-        rc = write (dev->fd, dev->buf + dev->bufupdlo,
-                    dev->bufupdhi - dev->bufupdlo);
+        if (dev->iouring)
+            rc = dasdio_pwrite (dev->fd, dev->buf + dev->bufupdlo,
+                                dev->bufupdhi - dev->bufupdlo, offset);
+        else
+            rc = write (dev->fd, dev->buf + dev->bufupdlo,
+                        dev->bufupdhi - dev->bufupdlo);
         if (rc < dev->bufupdhi - dev->bufupdlo)
         {
             /* Handle write error condition */
@@ -540,9 +668,9 @@ off_t           offset;                 /* File offsets              */
                     dev->bufcur, strerror(errno));
             dev->sense[0] = SENSE_EC;
             *unitstat = CSW_CE | CSW_DE | CSW_UC;
-            cache_lock(CACHE_DEVBUF);
+            cache_lock_entry(CACHE_DEVBUF, dev->cache);
             cache_setflag(CACHE_DEVBUF, dev->cache, ~FBA_CACHE_ACTIVE, 0);
-            cache_unlock(CACHE_DEVBUF);
+            cache_unlock_entry(CACHE_DEVBUF, dev->cache);
             dev->bufupdlo = dev->bufupdhi = 0;
             dev->bufcur = dev->cache = -1;
             return -1;
@@ -551,31 +679,33 @@ off_t           offset;                 /* File offsets              */
         dev->bufupdlo = dev->bufupdhi = 0;
     }
 
-    cache_lock (CACHE_DEVBUF);
-
     /* Make the previous cache entry inactive */
     if (dev->cache >= 0)
+    {
+        cache_lock_entry (CACHE_DEVBUF, dev->cache);
         cache_setflag(CACHE_DEVBUF, dev->cache, ~FBA_CACHE_ACTIVE, 0);
+        cache_unlock_entry (CACHE_DEVBUF, dev->cache);
+    }
     dev->bufcur = dev->cache = -1;
 
     /* Return on special case when called by the close handler */
     if (blkgrp < 0)
-    {
-        cache_unlock (CACHE_DEVBUF);
         return 0;
-    }
+
+    key = FBA_CACHE_SETKEY(dev->devnum, blkgrp);
+    cache_lock_key (CACHE_DEVBUF, key);
 
 fba_read_blkgrp_retry:
 
     /* Search the cache */
-    i = cache_lookup (CACHE_DEVBUF, FBA_CACHE_SETKEY(dev->devnum, blkgrp), &o);
+    i = cache_lookup (CACHE_DEVBUF, key, &o);
 
     /* Cache hit */
     if (i >= 0)
     {
         cache_setflag(CACHE_DEVBUF, i, ~0, FBA_CACHE_ACTIVE);
         cache_setage(CACHE_DEVBUF, i);
-        cache_unlock(CACHE_DEVBUF);
+        cache_unlock_key (CACHE_DEVBUF, key);
 
         logdevtr (dev, _("HHCDA071I read blkgrp %d cache hit, using cache[%d]\n"),
                   blkgrp, i);
@@ -594,7 +724,7 @@ fba_read_blkgrp_retry:
     /* Retry if synchronous I/O */
     if (dev->syncio_active)
     {
-        cache_unlock(CACHE_DEVBUF);
+        cache_unlock_key (CACHE_DEVBUF, key);
         dev->syncio_retry = 1;
         return -1;
     }
@@ -605,7 +735,7 @@ fba_read_blkgrp_retry:
         logdevtr (dev, _("HHCDA072I read blkgrp %d no available cache entry, waiting\n"),
                   blkgrp);
         dev->cachewaits++;
-        cache_wait(CACHE_DEVBUF);
+        cache_wait(CACHE_DEVBUF, key);
         goto fba_read_blkgrp_retry;
     }
 
@@ -616,11 +746,11 @@ fba_read_blkgrp_retry:
     dev->cachemisses++;
 
     /* Make this cache entry active */
-    cache_setkey (CACHE_DEVBUF, o, FBA_CACHE_SETKEY(dev->devnum, blkgrp));
+    cache_setkey (CACHE_DEVBUF, o, key);
     cache_setflag(CACHE_DEVBUF, o, 0, FBA_CACHE_ACTIVE|DEVBUF_TYPE_FBA);
     cache_setage (CACHE_DEVBUF, o);
     dev->buf = cache_getbuf(CACHE_DEVBUF, o, FBA_BLKGRP_SIZE);
-    cache_unlock (CACHE_DEVBUF);
+    cache_unlock_key (CACHE_DEVBUF, key);
 
     /* Get offset and length */
     offset = (off_t)((S64)blkgrp * FBA_BLKGRP_SIZE);
@@ -630,7 +760,8 @@ fba_read_blkgrp_retry:
               blkgrp, (long long)offset, fba_blkgrp_len(dev, blkgrp));
 
     /* Seek to the block group offset */
-    offset = lseek (dev->fd, offset, SEEK_SET);
+    if (!dev->iouring)
+        offset = lseek (dev->fd, offset, SEEK_SET);
     if (offset < 0)
     {
         /* Handle seek error condition */
@@ -638,14 +769,17 @@ fba_read_blkgrp_retry:
                 blkgrp, strerror(errno));
         dev->sense[0] = SENSE_EC;
         *unitstat = CSW_CE | CSW_DE | CSW_UC;
-        cache_lock(CACHE_DEVBUF);
+        cache_lock_entry(CACHE_DEVBUF, o);
         cache_release(CACHE_DEVBUF, o, 0);
-        cache_unlock(CACHE_DEVBUF);
+        cache_unlock_entry(CACHE_DEVBUF, o);
         return -1;
     }
 
     /* Read the block group */
-    rc = read (dev->fd, dev->buf, len);
+    if (dev->iouring)
+        rc = dasdio_pread (dev->fd, dev->buf, len, offset);
+    else
+        rc = read (dev->fd, dev->buf, len);
     if (rc < len)
     {
         /* Handle read error condition */
@@ -653,9 +787,9 @@ fba_read_blkgrp_retry:
            blkgrp, rc < 0 ? strerror(errno) : "end of file");
         dev->sense[0] = SENSE_EC;
         *unitstat = CSW_CE | CSW_DE | CSW_UC;
-        cache_lock(CACHE_DEVBUF);
+        cache_lock_entry(CACHE_DEVBUF, o);
         cache_release(CACHE_DEVBUF, o, 0);
-        cache_unlock(CACHE_DEVBUF);
+        cache_unlock_entry(CACHE_DEVBUF, o);
         return -1;
     }
 
@@ -753,6 +887,15 @@ BYTE            unitstat;
     cache_scan(CACHE_DEVBUF, fbadasd_purge_cache, dev);
     cache_unlock(CACHE_DEVBUF);
 
+    /* Unmap the device file */
+    if (dev->dasdmmap)
+    {
+        dasdio_unmap (dev->dasdmap[0], dev->dasdmapsz[0]);
+        dev->dasdmap[0] = NULL;
+        dev->dasdmmap = 0;
+        dev->buf = NULL;
+    }
+
     /* Close the device file */
     close (dev->fd);
     dev->fd = -1;
@@ -24,11 +24,19 @@
 #undef  OPTION_NO_INLINE_VSTORE         /* Performance option        */
 #undef  OPTION_NO_INLINE_IFETCH         /* Performance option        */
 #define OPTION_MULTI_BYTE_ASSIST        /* Performance option        */
+#define OPTION_BLOCK_CACHE              /* Performance option        */
 #define OPTION_SINGLE_CPU_DW            /* Performance option (ia32) */
 #define OPTION_FAST_DEVLOOKUP           /* Fast devnum/subchan lookup*/
+#define OPTION_DASD_MMAP                /* mmap CKD/FBA image files  */
+#define OPTION_SR_MMAP                  /* mmap resume file pages    */
+#define OPTION_SR_MIGRATE               /* Live migration over TCP   */
+#define OPTION_HUGE_STORAGE             /* Huge page/NUMA storage    */
 #define OPTION_IODELAY_KLUDGE           /* IODELAY kludge for linux  */
 #undef  OPTION_FOOTPRINT_BUFFER /* 2048 ** Size must be a power of 2 */
 #undef  OPTION_INSTRUCTION_COUNTING     /* First use trace and count */
+#define OPTION_INSTRUCTION_PROFILE      /* Sampling profiler         */
+#define OPTION_TRACEBIN                 /* Binary trace ring files   */
+#define OPTION_SIMD_STORAGE_OPS         /* SSE2/AVX2 TR,TRT,XC etc.  */
 #define OPTION_CKD_KEY_TRACING          /* Trace CKD search keys     */
 #undef  OPTION_CMPSC_DEBUGLVL      /* 3 ** 1=Exp 2=Comp 3=Both debug */
 #undef  MODEL_DEPENDENT_STCM            /* STCM, STCMH always store  */
@@ -43,6 +51,7 @@
                                            interrupt selects instead
                                            of inter-thread signaling */
 #define OPTION_TIMESTAMP_LOGFILE        /* Hardcopy logfile HH:MM:SS */
+#define OPTION_LOGGER_RING              /* Lock free logmsg queue    */
 #define OPTION_IPLPARM                  /* IPL PARM a la VM          */
 #define OPTION_PTTRACE                  /* Pthreads tracing          */
 //#define OPTION_DEBUG_MESSAGES         /* Prefix msgs with filename
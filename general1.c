@@ -256,7 +256,6 @@ VADR    addr1, addr2;                   /* Virtual addresses         */
 BYTE   *dest1, *dest2;                  /* Destination addresses     */
 BYTE   *source1, *source2;              /* Source addresses          */
 BYTE   *sk1, *sk2;                      /* Storage key addresses     */
-int     i;                              /* Loop counter              */
 int     cc = 0;                         /* Condition code            */
 
     SS_L(inst, regs, len, b1, addr1, b2, addr2);
@@ -295,8 +294,7 @@ int     cc = 0;                         /* Condition code            */
         if ( NOCROSS2K(addr2,len) )
         {
             /* (1) - No boundaries are crossed */
-            for (i = 0; i <= len; i++)
-                if (*dest1++ &= *source1++) cc = 1;
+            cc |= simdops.nc (dest1, source1, len + 1);
 
         }
         else
@@ -305,11 +303,10 @@ int     cc = 0;                         /* Condition code            */
              len2 = 0x800 - (addr2 & 0x7FF);
              source2 = MADDR ((addr2 + len2) & ADDRESS_MAXWRAP(regs),
                               b2, regs, ACCTYPE_READ, regs->psw.pkey);
-             for ( i = 0; i < len2; i++)
-                 if (*dest1++ &= *source1++) cc = 1;
+             cc |= simdops.nc (dest1, source1, len2);
+             dest1 += len2; source1 += len2;
              len2 = len - len2;
-             for ( i = 0; i <= len2; i++)
-                 if (*dest1++ &= *source2++) cc = 1;
+             cc |= simdops.nc (dest1, source2, len2 + 1);
         }
         *sk1 |= (STORKEY_REF | STORKEY_CHANGE);
     }
@@ -324,11 +321,10 @@ int     cc = 0;                         /* Condition code            */
         if ( NOCROSS2K(addr2,len ))
         {
              /* (3) - First operand crosses a boundary */
-             for ( i = 0; i < len2; i++)
-                 if (*dest1++ &= *source1++) cc = 1;
+             cc |= simdops.nc (dest1, source1, len2);
+             dest1 += len2; source1 += len2;
              len2 = len - len2;
-             for ( i = 0; i <= len2; i++)
-                 if (*dest2++ &= *source1++) cc = 1;
+             cc |= simdops.nc (dest2, source1, len2 + 1);
         }
         else
         {
@@ -339,35 +335,32 @@ int     cc = 0;                         /* Condition code            */
             if (len2 == len3)
             {
                 /* (4a) - Both operands cross at the same time */
-                for ( i = 0; i < len2; i++)
-                    if (*dest1++ &= *source1++) cc = 1;
+                cc |= simdops.nc (dest1, source1, len2);
+                dest1 += len2; source1 += len2;
                 len2 = len - len2;
-                for ( i = 0; i <= len2; i++)
-                    if (*dest2++ &= *source2++) cc = 1;
+                cc |= simdops.nc (dest2, source2, len2 + 1);
             }
             else if (len2 < len3)
             {
                 /* (4b) - First operand crosses first */
-                for ( i = 0; i < len2; i++)
-                    if (*dest1++ &= *source1++) cc = 1;
+                cc |= simdops.nc (dest1, source1, len2);
+                dest1 += len2; source1 += len2;
                 len2 = len3 - len2;
-                for ( i = 0; i < len2; i++)
-                    if (*dest2++ &= *source1++) cc = 1;
+                cc |= simdops.nc (dest2, source1, len2);
+                dest2 += len2; source1 += len2;
                 len2 = len - len3;
-                for ( i = 0; i <= len2; i++)
-                    if (*dest2++ &= *source2++) cc = 1;
+                cc |= simdops.nc (dest2, source2, len2 + 1);
             }
             else
             {
                 /* (4c) - Second operand crosses first */
-                for ( i = 0; i < len3; i++)
-                    if (*dest1++ &= *source1++) cc = 1;
+                cc |= simdops.nc (dest1, source1, len3);
+                dest1 += len3; source1 += len3;
                 len3 = len2 - len3;
-                for ( i = 0; i < len3; i++)
-                    if (*dest1++ &= *source2++) cc = 1;
+                cc |= simdops.nc (dest1, source2, len3);
+                dest1 += len3; source2 += len3;
                 len3 = len - len2;
-                for ( i = 0; i <= len3; i++)
-                    if (*dest2++ &= *source2++) cc = 1;
+                cc |= simdops.nc (dest2, source2, len3 + 1);
             }
         }
         *sk1 |= (STORKEY_REF | STORKEY_CHANGE);
@@ -2989,7 +2982,6 @@ VADR    addr1, addr2;                   /* Virtual addresses         */
 BYTE   *dest1, *dest2;                  /* Destination addresses     */
 BYTE   *source1, *source2;              /* Source addresses          */
 BYTE   *sk1, *sk2;                      /* Storage key addresses     */
-int     i;                              /* Loop counter              */
 int     cc = 0;                         /* Condition code            */
 
     SS_L(inst, regs, len, b1, addr1, b2, addr2);
@@ -3037,8 +3029,7 @@ int     cc = 0;                         /* Condition code            */
             else
             {
                /* (1b) - Dest and source are not the sam */
-                for (i = 0; i <= len; i++)
-                    if (*dest1++ ^= *source1++) cc = 1;
+                cc |= simdops.xc (dest1, source1, len + 1);
             }
         }
         else
@@ -3047,11 +3038,10 @@ int     cc = 0;                         /* Condition code            */
              len2 = 0x800 - (addr2 & 0x7FF);
              source2 = MADDR ((addr2 + len2) & ADDRESS_MAXWRAP(regs),
                               b2, regs, ACCTYPE_READ, regs->psw.pkey);
-             for ( i = 0; i < len2; i++)
-                 if (*dest1++ ^= *source1++) cc = 1;
+             cc |= simdops.xc (dest1, source1, len2);
+             dest1 += len2; source1 += len2;
              len2 = len - len2;
-             for ( i = 0; i <= len2; i++)
-                 if (*dest1++ ^= *source2++) cc = 1;
+             cc |= simdops.xc (dest1, source2, len2 + 1);
         }
         *sk1 |= (STORKEY_REF | STORKEY_CHANGE);
     }
@@ -3066,11 +3056,10 @@ int     cc = 0;                         /* Condition code            */
         if ( NOCROSS2K(addr2,len))
         {
              /* (3) - First operand crosses a boundary */
-             for ( i = 0; i < len2; i++)
-                 if (*dest1++ ^= *source1++) cc = 1;
+             cc |= simdops.xc (dest1, source1, len2);
+             dest1 += len2; source1 += len2;
              len2 = len - len2;
-             for ( i = 0; i <= len2; i++)
-                 if (*dest2++ ^= *source1++) cc = 1;
+             cc |= simdops.xc (dest2, source1, len2 + 1);
         }
         else
         {
@@ -3081,35 +3070,32 @@ int     cc = 0;                         /* Condition code            */
             if (len2 == len3)
             {
                 /* (4a) - Both operands cross at the same time */
-                for ( i = 0; i < len2; i++)
-                    if (*dest1++ ^= *source1++) cc = 1;
+                cc |= simdops.xc (dest1, source1, len2);
+                dest1 += len2; source1 += len2;
                 len2 = len - len2;
-                for ( i = 0; i <= len2; i++)
-                    if (*dest2++ ^= *source2++) cc = 1;
+                cc |= simdops.xc (dest2, source2, len2 + 1);
             }
             else if (len2 < len3)
             {
                 /* (4b) - First operand crosses first */
-                for ( i = 0; i < len2; i++)
-                    if (*dest1++ ^= *source1++) cc = 1;
+                cc |= simdops.xc (dest1, source1, len2);
+                dest1 += len2; source1 += len2;
                 len2 = len3 - len2;
-                for ( i = 0; i < len2; i++)
-                    if (*dest2++ ^= *source1++) cc = 1;
+                cc |= simdops.xc (dest2, source1, len2);
+                dest2 += len2; source1 += len2;
                 len2 = len - len3;
-                for ( i = 0; i <= len2; i++)
-                    if (*dest2++ ^= *source2++) cc = 1;
+                cc |= simdops.xc (dest2, source2, len2 + 1);
             }
             else
             {
                 /* (4c) - Second operand crosses first */
-                for ( i = 0; i < len3; i++)
-                    if (*dest1++ ^= *source1++) cc = 1;
+                cc |= simdops.xc (dest1, source1, len3);
+                dest1 += len3; source1 += len3;
                 len3 = len2 - len3;
-                for ( i = 0; i < len3; i++)
-                    if (*dest1++ ^= *source2++) cc = 1;
+                cc |= simdops.xc (dest1, source2, len3);
+                dest1 += len3; source2 += len3;
                 len3 = len - len2;
-                for ( i = 0; i <= len3; i++)
-                    if (*dest2++ ^= *source2++) cc = 1;
+                cc |= simdops.xc (dest2, source2, len3 + 1);
             }
         }
         *sk1 |= (STORKEY_REF | STORKEY_CHANGE);
@@ -112,7 +112,6 @@ VADR    addr1, addr2;                   /* Virtual addresses         */
 BYTE   *dest1, *dest2;                  /* Destination addresses     */
 BYTE   *source1, *source2;              /* Source addresses          */
 BYTE   *sk1, *sk2;                      /* Storage key addresses     */
-int     i;                              /* Loop counter              */
 int     cc = 0;                         /* Condition code            */
 
     SS_L(inst, regs, len, b1, addr1, b2, addr2);
@@ -151,8 +150,7 @@ int     cc = 0;                         /* Condition code            */
         if ( NOCROSS2K(addr2,len) )
         {
             /* (1) - No boundaries are crossed */
-            for (i = 0; i <= len; i++)
-                if ((*dest1++ |= *source1++)) cc = 1;
+            cc |= simdops.oc (dest1, source1, len + 1);
 
         }
         else
@@ -161,11 +159,10 @@ int     cc = 0;                         /* Condition code            */
              len2 = 0x800 - (addr2 & 0x7FF);
              source2 = MADDR ((addr2 + len2) & ADDRESS_MAXWRAP(regs),
                               b2, regs, ACCTYPE_READ, regs->psw.pkey);
-             for ( i = 0; i < len2; i++)
-                 if ((*dest1++ |= *source1++)) cc = 1;
+             cc |= simdops.oc (dest1, source1, len2);
+             dest1 += len2; source1 += len2;
              len2 = len - len2;
-             for ( i = 0; i <= len2; i++)
-                 if ((*dest1++ |= *source2++)) cc = 1;
+             cc |= simdops.oc (dest1, source2, len2 + 1);
         }
         *sk1 |= (STORKEY_REF | STORKEY_CHANGE);
     }
@@ -180,11 +177,10 @@ int     cc = 0;                         /* Condition code            */
         if ( NOCROSS2K(addr2,len) )
         {
              /* (3) - First operand crosses a boundary */
-             for ( i = 0; i < len2; i++)
-                 if ((*dest1++ |= *source1++)) cc = 1;
+             cc |= simdops.oc (dest1, source1, len2);
+             dest1 += len2; source1 += len2;
              len2 = len - len2;
-             for ( i = 0; i <= len2; i++)
-                 if ((*dest2++ |= *source1++)) cc = 1;
+             cc |= simdops.oc (dest2, source1, len2 + 1);
         }
         else
         {
@@ -195,35 +191,32 @@ int     cc = 0;                         /* Condition code            */
             if (len2 == len3)
             {
                 /* (4a) - Both operands cross at the same time */
-                for ( i = 0; i < len2; i++)
-                    if ((*dest1++ |= *source1++)) cc = 1;
+                cc |= simdops.oc (dest1, source1, len2);
+                dest1 += len2; source1 += len2;
                 len2 = len - len2;
-                for ( i = 0; i <= len2; i++)
-                    if ((*dest2++ |= *source2++)) cc = 1;
+                cc |= simdops.oc (dest2, source2, len2 + 1);
             }
             else if (len2 < len3)
             {
                 /* (4b) - First operand crosses first */
-                for ( i = 0; i < len2; i++)
-                    if ((*dest1++ |= *source1++)) cc = 1;
+                cc |= simdops.oc (dest1, source1, len2);
+                dest1 += len2; source1 += len2;
                 len2 = len3 - len2;
-                for ( i = 0; i < len2; i++)
-                    if ((*dest2++ |= *source1++)) cc = 1;
+                cc |= simdops.oc (dest2, source1, len2);
+                dest2 += len2; source1 += len2;
                 len2 = len - len3;
-                for ( i = 0; i <= len2; i++)
-                    if ((*dest2++ |= *source2++)) cc = 1;
+                cc |= simdops.oc (dest2, source2, len2 + 1);
             }
             else
             {
                 /* (4c) - Second operand crosses first */
-                for ( i = 0; i < len3; i++)
-                    if ((*dest1++ |= *source1++)) cc = 1;
+                cc |= simdops.oc (dest1, source1, len3);
+                dest1 += len3; source1 += len3;
                 len3 = len2 - len3;
-                for ( i = 0; i < len3; i++)
-                    if ((*dest1++ |= *source2++)) cc = 1;
+                cc |= simdops.oc (dest1, source2, len3);
+                dest1 += len3; source2 += len3;
                 len3 = len - len2;
-                for ( i = 0; i <= len3; i++)
-                    if ((*dest2++ |= *source2++)) cc = 1;
+                cc |= simdops.oc (dest2, source2, len3 + 1);
             }
         }
         *sk1 |= (STORKEY_REF | STORKEY_CHANGE);
@@ -1372,6 +1365,9 @@ int     rc;                             /* Return code               */
     /* Store current PSW at PSA+X'20' */
     ARCH_DEP(store_psw) ( regs, psa->svcold );
 
+    /* Discard cached blocks built from the PSA */
+    BBC_INVALIDATE(psa, sizeof(*psa));
+
     /* Load new PSW from PSA+X'60' */
     if ( (rc = ARCH_DEP(load_psw) ( regs, psa->svcnew ) ) )
         regs->program_interrupt (regs, rc);
@@ -1575,10 +1571,9 @@ BYTE   *dest, *dest2 = NULL, *tab, *tab2; /* Mainstor pointers       */
     {
         tab = MADDR (addr2, b2, regs, ACCTYPE_READ, regs->psw.pkey);
         /* Perform translate function */
-        for (i = 0; i <= len; i++)
-            dest[i] = tab[dest[i]];
-        for (i = 0; i <= len2; i++)
-            dest2[i] = tab[dest2[i]];
+        simdops.tr (dest, len + 1, tab);
+        if (dest2)
+            simdops.tr (dest2, len2 + 1, tab);
     }
     else
     {
@@ -1630,54 +1625,90 @@ int     b1, b2;                         /* Values of base field      */
 VADR    effective_addr1,
         effective_addr2;                /* Effective addresses       */
 int     cc = 0;                         /* Condition code            */
-BYTE    sbyte;                          /* Byte work areas           */
+BYTE    sbyte = 0;                      /* Byte work areas           */
 BYTE    dbyte;                          /* Byte work areas           */
 int     i;                              /* Integer work areas        */
+int     n, k;                           /* Bytes in this 2K block    */
+BYTE   *m1, *tab;                       /* Mainstor addresses        */
 
     SS_L(inst, regs, l, b1, effective_addr1,
                                   b2, effective_addr2);
 
-    /* Process first operand from left to right */
-    for ( i = 0; i <= l; i++ )
+    /* Fast path if table does not cross a boundary */
+    if (NOCROSS2K (effective_addr2, 255))
     {
-        /* Fetch argument byte from first operand */
-        dbyte = ARCH_DEP(vfetchb) ( effective_addr1, b1, regs );
+        ITIMER_SYNC(effective_addr1,l,regs);
+        ITIMER_SYNC(effective_addr2,255,regs);
 
-        /* Fetch function byte from second operand */
-        sbyte = ARCH_DEP(vfetchb) ( (effective_addr2 + dbyte)
-                                   & ADDRESS_MAXWRAP(regs), b2, regs );
+        tab = MADDR (effective_addr2, b2, regs, ACCTYPE_READ, regs->psw.pkey);
 
-        /* Test for non-zero function byte */
-        if (sbyte != 0) {
+        /* Test the first operand one 2K block at a time */
+        for (i = 0; i <= l; i += n)
+        {
+            /* Bytes of the operand in this 2K block */
+            n = 0x800 - (effective_addr1 & 0x7FF);
+            if (n > l + 1 - i)
+                n = l + 1 - i;
+            m1 = MADDR (effective_addr1, b1, regs, ACCTYPE_READ, regs->psw.pkey);
+            k = simdops.trt (m1, n, tab);
+            if (k < n)
+            {
+                /* Non-zero function byte found */
+                effective_addr1 += k;
+                effective_addr1 &= ADDRESS_MAXWRAP(regs);
+                sbyte = tab[m1[k]];
+                i += k;
+                break;
+            }
+            effective_addr1 += n;
+            effective_addr1 &= ADDRESS_MAXWRAP(regs);
+        }
+    }
+    else
+    {
+        /* Process first operand from left to right */
+        for ( i = 0; i <= l; i++ )
+        {
+            /* Fetch argument byte from first operand */
+            dbyte = ARCH_DEP(vfetchb) ( effective_addr1, b1, regs );
 
-            /* Store address of argument byte in register 1 */
-#if defined(FEATURE_ESAME)
-            if(regs->psw.amode64)
-                regs->GR_G(1) = effective_addr1;
-            else
-#endif
-            if ( regs->psw.amode )
-                regs->GR_L(1) = effective_addr1;
-            else
-                regs->GR_LA24(1) = effective_addr1;
+            /* Fetch function byte from second operand */
+            sbyte = ARCH_DEP(vfetchb) ( (effective_addr2 + dbyte)
+                                       & ADDRESS_MAXWRAP(regs), b2, regs );
 
-            /* Store function byte in low-order byte of reg.2 */
-            regs->GR_LHLCL(2) = sbyte;
+            /* Test for non-zero function byte */
+            if (sbyte != 0)
+                break;
 
-            /* Set condition code 2 if argument byte was last byte
-               of first operand, otherwise set condition code 1 */
-            cc = (i == l) ? 2 : 1;
+            /* Increment first operand address */
+            effective_addr1++;
+            effective_addr1 &= ADDRESS_MAXWRAP(regs);
 
-            /* Terminate the operation at this point */
-            break;
+        } /* end for(i) */
+    }
 
-        } /* end if(sbyte) */
+    /* Test for non-zero function byte */
+    if (i <= l) {
 
-        /* Increment first operand address */
-        effective_addr1++;
-        effective_addr1 &= ADDRESS_MAXWRAP(regs);
+        /* Store address of argument byte in register 1 */
+#if defined(FEATURE_ESAME)
+        if(regs->psw.amode64)
+            regs->GR_G(1) = effective_addr1;
+        else
+#endif
+        if ( regs->psw.amode )
+            regs->GR_L(1) = effective_addr1;
+        else
+            regs->GR_LA24(1) = effective_addr1;
 
-    } /* end for(i) */
+        /* Store function byte in low-order byte of reg.2 */
+        regs->GR_LHLCL(2) = sbyte;
+
+        /* Set condition code 2 if argument byte was last byte
+           of first operand, otherwise set condition code 1 */
+        cc = (i == l) ? 2 : 1;
+
+    } /* end if(sbyte) */
 
     /* Update the condition code */
     regs->psw.cc = cc;
@@ -1692,10 +1723,11 @@ DEF_INST(translate_extended)
 {
 int     r1, r2;                         /* Values of R fields        */
 int     i;                              /* Loop counter              */
+int     n, k;                           /* Bytes in this 2K block    */
 int     cc = 0;                         /* Condition code            */
 VADR    addr1, addr2;                   /* Operand addresses         */
 GREG    len1;                           /* Operand length            */
-BYTE    byte1, byte2;                   /* Operand bytes             */
+BYTE   *m1, *p;                         /* Mainstor addresses        */
 BYTE    tbyte;                          /* Test byte                 */
 BYTE    trtab[256];                     /* Translate table           */
 
@@ -1719,8 +1751,9 @@ BYTE    trtab[256];                     /* Translate table           */
        operand may be recognized, even if not all bytes are used */
     ARCH_DEP(vfetchc) ( trtab, 255, addr2, r2, regs );
 
-    /* Process first operand from left to right */
-    for (i = 0; len1 > 0; i++)
+    /* Process first operand from left to right, one 2K block
+       at a time, translating the bytes up to the test byte */
+    for (i = 0; len1 > 0; i += n)
     {
         /* If 4096 bytes have been compared, exit with condition code 3 */
         if (i >= 4096)
@@ -1729,29 +1762,41 @@ BYTE    trtab[256];                     /* Translate table           */
             break;
         }
 
-        /* Fetch byte from first operand */
-        byte1 = ARCH_DEP(vfetchb) ( addr1, r1, regs );
+        /* Bytes of the operand in this 2K block */
+        n = 0x800 - (addr1 & 0x7FF);
+        if (n > 4096 - i)
+            n = 4096 - i;
+        if ((GREG)n > len1)
+            n = (int)len1;
+
+        /* Look for the test byte */
+        ITIMER_SYNC(addr1,n-1,regs);
+        m1 = MADDR (addr1, r1, regs, ACCTYPE_READ, regs->psw.pkey);
+        p = memchr (m1, tbyte, n);
+        k = p ? (int)(p - m1) : n;
+
+        /* Translate the bytes preceding it */
+        if (k > 0)
+        {
+            m1 = MADDR (addr1, r1, regs, ACCTYPE_WRITE, regs->psw.pkey);
+            simdops.tr (m1, k, trtab);
+            ITIMER_UPDATE(addr1,k-1,regs);
+            addr1 += k;
+            addr1 &= ADDRESS_MAXWRAP(regs);
+            len1 -= k;
+
+            /* Update the registers */
+            SET_GR_A(r1, regs, addr1);
+            SET_GR_A(r1+1, regs, len1);
+        }
 
         /* If equal to test byte, exit with condition code 1 */
-        if (byte1 == tbyte)
+        if (p)
         {
             cc = 1;
             break;
         }
 
-        /* Load indicated byte from translate table */
-        byte2 = trtab[byte1];
-
-        /* Store result at first operand address */
-        ARCH_DEP(vstoreb) ( byte2, addr1, r1, regs );
-        addr1++;
-        addr1 &= ADDRESS_MAXWRAP(regs);
-        len1--;
-
-        /* Update the registers */
-        SET_GR_A(r1, regs, addr1);
-        SET_GR_A(r1+1, regs, len1);
-
     } /* end for(i) */
 
     /* Set condition code */
@@ -37,7 +37,8 @@
                   "  hao cmd <cmd> : define command for previously defined rule\n" \
                   "  hao list <n>  : list all rules/commands or only at index <n>\n" \
                   "  hao del <n>   : delete the rule at index <n>\n" \
-                  "  hao clear     : delete all rules (stops automatic operator)\n"
+                  "  hao clear     : delete all rules (stops automatic operator)\n" \
+                  "  hao stats     : display the match counts of all rules\n"
 #define HHCAO008E "HHCAO008E No rule defined at index %d\n"
 #define HHCAO009E "HHCAO009E Invalid index, index must be between 0 and %d\n"
 #define HHCAO010E "HHCAO010E Target not added, table full\n"
@@ -57,10 +58,17 @@
 #define HHCAO024E "HHCAO024E Rule at index %d not deleted, already empty\n"
 #define HHCAO025I "HHCAO025I Rule at index %d succesfully deleted\n"
 #define HHCA0026E "HHCA0026E Command not added, may cause dead locks\n"
+#define HHCAO027I "HHCAO027I %" I64_FMT "u message(s) examined, %" I64_FMT "u passed the prefilter\n"
+#define HHCAO028I "HHCAO028I %02d: %" I64_FMT "u match(es) in %" I64_FMT "u test(s), prefilter '%s'\n"
 
 #define HAO_WKLEN    256    /* (maximum message length able to tolerate) */
 #define HAO_MAXRULE  64     /* (purely arbitrary and easily increasable) */
 #define HAO_MAXCAPT  9      /* (maximum number of capturing groups)      */
+#define HAO_MAXLIT   16     /* (maximum length of a prefilter literal)   */
+
+#if HAO_MAXRULE > 64
+  #error HAO_MAXRULE exceeds the number of bits in the prefilter rule mask
+#endif
 
 /*---------------------------------------------------------------------------*/
 /* local variables                                                           */
@@ -71,6 +79,22 @@ static char    *ao_cmd[HAO_MAXRULE];
 static char    *ao_tgt[HAO_MAXRULE];
 static char     ao_msgbuf[LOG_DEFSIZE+1];   /* (plus+1 for NULL termination) */
 
+/*---------------------------------------------------------------------------*/
+/* prefilter: every target yields, where possible, a literal string that     */
+/* any matching message must contain.  The literals of all complete rules    */
+/* are compiled into one Aho-Corasick automaton, expanded to a full state    */
+/* transition table, so a single pass over a message gives the set of rules  */
+/* which might match it.  Only those are then tried with regexec.            */
+/*---------------------------------------------------------------------------*/
+static char     ao_lit[HAO_MAXRULE][HAO_MAXLIT+1]; /* (empty = no literal)  */
+static U16     *ao_dfa;         /* state transition table [state][256]       */
+static U64     *ao_out;         /* rules whose literal was found, by state   */
+static U64      ao_any;         /* complete rules that have no literal       */
+static U64      ao_msgs;        /* messages examined                         */
+static U64      ao_cands;       /* messages that passed the prefilter        */
+static U64      ao_tests[HAO_MAXRULE];      /* regexec calls per rule        */
+static U64      ao_hits[HAO_MAXRULE];       /* matches per rule              */
+
 /*---------------------------------------------------------------------------*/
 /* function prototypes                                                       */
 /*---------------------------------------------------------------------------*/
@@ -82,6 +106,9 @@ static     void  hao_cmd(char *arg);
 static     void  hao_cpstrp(char *dest, char *src);
 static     void  hao_del(char *arg);
 static     void  hao_list(char *arg);
+static     void  hao_literal(char *lit, char *tgt);
+static     void  hao_prefilter(void);
+static     void  hao_stats(void);
 static     void  hao_tgt(char *arg);
 static     void* hao_thread(void* dummy);
 
@@ -180,6 +207,12 @@ DLL_EXPORT void hao_command(char *cmd)
     return;
   }
 
+  if(!strncasecmp(work2, "stats", 5))
+  {
+    hao_stats();
+    return;
+  }
+
   logmsg(HHCAO007E);
 }
 
@@ -217,7 +250,7 @@ static void hao_tgt(char *arg)
   obtain_lock(&ao_lock);
 
   /* find a free slot */
-  for(i = 0; ao_tgt[i] && i < HAO_MAXRULE; i++)
+  for(i = 0; i < HAO_MAXRULE && ao_tgt[i]; i++);
 
   /* check for table full */
   if(i == HAO_MAXRULE)
@@ -295,6 +328,10 @@ static void hao_tgt(char *arg)
     return;
   }
 
+  /* extract the prefilter literal and reset the counts */
+  hao_literal(ao_lit[i], arg);
+  ao_tests[i] = ao_hits[i] = 0;
+
   release_lock(&ao_lock);
   logmsg(HHCAO016I, i);
 }
@@ -315,7 +352,7 @@ static void hao_cmd(char *arg)
   obtain_lock(&ao_lock);
 
   /* find the free slot */
-  for(i = 0; ao_cmd[i] && i < HAO_MAXRULE; i++);
+  for(i = 0; i < HAO_MAXRULE && ao_cmd[i]; i++);
 
   /* check for table full -> so tgt cmd expected */
   if(i == HAO_MAXRULE)
@@ -372,6 +409,9 @@ static void hao_cmd(char *arg)
     return;
   }
 
+  /* the rule is complete, add it to the prefilter */
+  hao_prefilter();
+
   release_lock(&ao_lock);
   logmsg(HHCAO020I, i);
 }
@@ -422,6 +462,8 @@ static void hao_del(char *arg)
     free(ao_cmd[i]);
     ao_cmd[i] = NULL;
   }
+  ao_lit[i][0] = 0;
+  hao_prefilter();
 
   release_lock(&ao_lock);
   logmsg(HHCAO025I, i);
@@ -508,12 +550,288 @@ static void hao_clear(void)
       free(ao_cmd[i]);
       ao_cmd[i] = NULL;
     }
+    ao_lit[i][0] = 0;
   }
+  hao_prefilter();
 
   release_lock(&ao_lock);
   logmsg(HHCAO022I);
 }
 
+/*---------------------------------------------------------------------------*/
+/* void hao_stats(void)                                                      */
+/*                                                                           */
+/* This function is called when the hao stats command is given. It lists     */
+/* how many messages were examined and, for every complete rule, how often   */
+/* it was tried with regexec and how often it matched.                       */
+/*---------------------------------------------------------------------------*/
+static void hao_stats(void)
+{
+  int i;
+
+  /* serialize */
+  obtain_lock(&ao_lock);
+
+  logmsg(HHCAO027I, ao_msgs, ao_cands);
+  for(i = 0; i < HAO_MAXRULE; i++)
+  {
+    if(ao_tgt[i] && ao_cmd[i])
+      logmsg(HHCAO028I, i, ao_hits[i], ao_tests[i], ao_lit[i]);
+  }
+
+  release_lock(&ao_lock);
+}
+
+/*---------------------------------------------------------------------------*/
+/* void hao_literal(char *lit, char *tgt)                                    */
+/*                                                                           */
+/* This function extracts the longest run of literal characters that every   */
+/* match of the target regular expression must contain. Anything it cannot   */
+/* be sure about (alternation at the outer level, inline options, escapes    */
+/* in bracket expressions) results in an empty literal, which means the      */
+/* rule is always tried. Characters inside groups, bracket expressions and   */
+/* escapes other than escaped punctuation end the current run. A character   */
+/* made optional by ?, * or {m,n} is dropped from it. At most HAO_MAXLIT     */
+/* characters of the run are used.                                           */
+/*---------------------------------------------------------------------------*/
+static void hao_literal(char *lit, char *tgt)
+{
+  char run[HAO_WKLEN];
+  int n = 0;
+  int best = 0;
+  int depth = 0;
+  char *p;
+  char *q;
+
+  lit[0] = 0;
+
+#define HAO_ENDRUN()                                        \
+  do {                                                      \
+    if (n > best)                                           \
+    {                                                       \
+      best = n > HAO_MAXLIT ? HAO_MAXLIT : n;               \
+      memcpy(lit, run, best);                               \
+      lit[best] = 0;                                        \
+    }                                                       \
+    n = 0;                                                  \
+  } while (0)
+
+  for(p = tgt; *p; )
+  {
+    switch(*p)
+    {
+    case '\\':
+      /* escaped punctuation is a literal, anything else is a class */
+      if(p[1] && ispunct((unsigned char)p[1]))
+      {
+        if(!depth)
+          run[n++] = p[1];
+      }
+      else
+        HAO_ENDRUN();
+      p += p[1] ? 2 : 1;
+      break;
+
+    case '[':
+      /* skip the bracket expression */
+      q = p + 1;
+      if(*q == '^') q++;
+      if(*q == ']') q++;
+      for(; *q && *q != ']'; q++)
+      {
+        if(*q == '\\')
+        {
+          lit[0] = 0;
+          return;
+        }
+        if(*q == '[' && (q[1] == ':' || q[1] == '.' || q[1] == '='))
+        {
+          char *e = strchr(q + 2, ']');
+          if(!e)
+            break;
+          q = e;
+        }
+      }
+      if(!*q)
+      {
+        lit[0] = 0;
+        return;
+      }
+      HAO_ENDRUN();
+      p = q + 1;
+      break;
+
+    case '(':
+      /* inline options such as (?i) change what the literal means */
+      if(p[1] == '?' && p[2] != ':')
+      {
+        lit[0] = 0;
+        return;
+      }
+      HAO_ENDRUN();
+      depth++;
+      p++;
+      break;
+
+    case ')':
+      HAO_ENDRUN();
+      if(depth)
+        depth--;
+      p++;
+      break;
+
+    case '|':
+      /* an alternative at the outer level may match without the run */
+      if(!depth)
+      {
+        lit[0] = 0;
+        return;
+      }
+      p++;
+      break;
+
+    case '?':
+    case '*':
+    case '{':
+      /* the preceding character is optional */
+      if(n)
+        n--;
+      HAO_ENDRUN();
+      if(*p == '{' && isdigit((unsigned char)p[1]) && (q = strchr(p, '}')))
+        p = q + 1;
+      else
+        p++;
+      break;
+
+    case '+':
+    case '.':
+    case '^':
+    case '$':
+      HAO_ENDRUN();
+      p++;
+      break;
+
+    default:
+      if(!depth)
+        run[n++] = *p;
+      p++;
+      break;
+    }
+  }
+  HAO_ENDRUN();
+
+#undef HAO_ENDRUN
+}
+
+/*---------------------------------------------------------------------------*/
+/* void hao_prefilter(void)                                                  */
+/*                                                                           */
+/* This function rebuilds the prefilter automaton from the literals of all   */
+/* complete rules. It is called with ao_lock held whenever a rule is         */
+/* completed or deleted. The trie of literals is built first, with the       */
+/* transitions of each state in the table itself (0 meaning no child), and   */
+/* then completed breadth first: a missing transition is taken from the      */
+/* state's failure state, which is always nearer to the root.                */
+/*---------------------------------------------------------------------------*/
+static void hao_prefilter(void)
+{
+  U16 *dfa;
+  U64 *out;
+  U16 *fail;
+  U16 *queue;
+  int nstates;
+  int head;
+  int tail;
+  int i;
+  int c;
+  int s;
+  int t;
+  char *p;
+
+  free(ao_dfa);
+  free(ao_out);
+  ao_dfa = NULL;
+  ao_out = NULL;
+  ao_any = 0;
+
+  /* count the states: the root plus one per literal character */
+  for(nstates = 1, i = 0; i < HAO_MAXRULE; i++)
+  {
+    if(ao_tgt[i] && ao_cmd[i])
+    {
+      if(ao_lit[i][0])
+        nstates += strlen(ao_lit[i]);
+      else
+        ao_any |= (U64)1 << i;
+    }
+  }
+  if(nstates == 1)
+    return;
+
+  dfa = calloc(nstates * 256, sizeof(U16));
+  out = calloc(nstates, sizeof(U64));
+  fail = calloc(nstates, sizeof(U16));
+  queue = calloc(nstates, sizeof(U16));
+  if(!dfa || !out || !fail || !queue)
+  {
+    /* without a prefilter every complete rule is tried */
+    free(dfa);
+    free(out);
+    for(i = 0; i < HAO_MAXRULE; i++)
+      if(ao_tgt[i] && ao_cmd[i])
+        ao_any |= (U64)1 << i;
+    free(fail);
+    free(queue);
+    return;
+  }
+
+  /* build the trie */
+  for(nstates = 1, i = 0; i < HAO_MAXRULE; i++)
+  {
+    if(!ao_tgt[i] || !ao_cmd[i] || !ao_lit[i][0])
+      continue;
+    for(s = 0, p = ao_lit[i]; *p; p++)
+    {
+      c = (unsigned char)*p;
+      if(!dfa[s * 256 + c])
+        dfa[s * 256 + c] = nstates++;
+      s = dfa[s * 256 + c];
+    }
+    out[s] |= (U64)1 << i;
+  }
+
+  /* complete the transitions breadth first */
+  head = tail = 0;
+  for(c = 0; c < 256; c++)
+  {
+    if((t = dfa[c]))
+    {
+      fail[t] = 0;
+      queue[tail++] = t;
+    }
+  }
+  while(head < tail)
+  {
+    s = queue[head++];
+    out[s] |= out[fail[s]];
+    for(c = 0; c < 256; c++)
+    {
+      if((t = dfa[s * 256 + c]))
+      {
+        fail[t] = dfa[fail[s] * 256 + c];
+        queue[tail++] = t;
+      }
+      else
+        dfa[s * 256 + c] = dfa[fail[s] * 256 + c];
+    }
+  }
+
+  free(fail);
+  free(queue);
+  ao_dfa = dfa;
+  ao_out = out;
+}
+
 /*---------------------------------------------------------------------------*/
 /* void* hao_thread(void* dummy)                                             */
 /*                                                                           */
@@ -615,6 +933,8 @@ DLL_EXPORT void hao_message(char *buf)
   int i, j, k, numcapt;
   size_t n;
   char *p;
+  U64 cand;
+  int s;
 
   /* copy and strip spaces */
   hao_cpstrp(work, buf);
@@ -638,14 +958,33 @@ DLL_EXPORT void hao_message(char *buf)
   /* serialize */
   obtain_lock(&ao_lock);
 
-  /* check all defined rules */
-  for(i = 0; i < HAO_MAXRULE; i++)
+  /* find the rules that might match in one pass over the message */
+  ao_msgs++;
+  cand = ao_any;
+  if(ao_dfa)
+  {
+    for(s = 0, p = work; *p; p++)
+    {
+      s = ao_dfa[s * 256 + (unsigned char)*p];
+      cand |= ao_out[s];
+    }
+  }
+  if(cand)
+    ao_cands++;
+
+  /* check the candidate rules */
+  for(i = 0; cand && i < HAO_MAXRULE; i++)
   {
-    if(ao_tgt[i] && ao_cmd[i])  /* complete rule defined in this slot? */
+    if(cand & ((U64)1 << i))    /* complete rule that might match? */
     {
+      cand &= ~((U64)1 << i);
+      ao_tests[i]++;
+
       /* does this rule match our message? */
       if (regexec(&ao_preg[i], work, HAO_MAXCAPT+1, rm, 0) == 0)
       {
+        ao_hits[i]++;
+
         /* count the capturing group matches */
         for (j = 0; j <= HAO_MAXCAPT && rm[j].rm_so >= 0; j++);
         numcapt = j - 1;
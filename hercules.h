@@ -112,12 +112,14 @@
 #include "hdl.h"          // (Hercules Dynamic Loader)
 
 #include "cache.h"
+#include "dasdio.h"
 
 #include "devtype.h"
 #include "dasdtab.h"
 #include "shared.h"
 #include "hetlib.h"
 #include "sockdev.h"
+#include "spoolout.h"
 #include "w32ctca.h"
 
 #include "service.h"
@@ -26,10 +26,18 @@ static const char help[] =
     "%s - Initialize a tape\n\n"
     "Usage: %s [options] filename [volser] [owner]\n\n"
     "Options:\n"
+#if defined( HET_BZIP2 )
+    "  -b  use BZLIB compression\n"
+#endif /* defined( HET_BZIP2 ) */
     "  -d  disable compression\n"
     "  -h  display usage summary\n"
     "  -i  create an IEHINITT formatted tape (default: on)\n"
-    "  -n  create an NL tape\n";
+    "  -n  create an NL tape\n"
+    "  -z  use ZLIB compression (default)\n"
+#if defined( HET_ZSTD )
+    "  -Z  use ZSTD compression\n"
+#endif /* defined( HET_ZSTD ) */
+    ;
 
 /*
 || Prints usage information
@@ -63,6 +71,7 @@ main( int argc, char *argv[] )
     int o_iehinitt;
     int o_nl;
     int o_compress;
+    int o_method;
     char *o_filename;
     char *o_owner;
     char *o_volser;
@@ -75,6 +84,7 @@ main( int argc, char *argv[] )
     o_iehinitt = TRUE;
     o_nl = FALSE;
     o_compress = TRUE;
+    o_method = HETDFLT_METHOD;
     o_owner = NULL;
     o_volser = NULL;
 
@@ -83,7 +93,14 @@ main( int argc, char *argv[] )
 
     while( TRUE )
     {
-        rc = getopt( argc, argv, "dhin" );
+        rc = getopt( argc, argv,
+#if defined( HET_BZIP2 )
+                     "b"
+#endif /* defined( HET_BZIP2 ) */
+#if defined( HET_ZSTD )
+                     "Z"
+#endif /* defined( HET_ZSTD ) */
+                     "dhinz" );
         if( rc == -1 )
         {
             break;
@@ -91,6 +108,13 @@ main( int argc, char *argv[] )
 
         switch( rc )
         {
+#if defined( HET_BZIP2 )
+            case 'b':
+                o_method = HETMETH_BZLIB;
+                o_compress = TRUE;
+            break;
+#endif /* defined( HET_BZIP2 ) */
+
             case 'd':
                 o_compress = FALSE;
             break;
@@ -110,6 +134,18 @@ main( int argc, char *argv[] )
                 o_nl = TRUE;
             break;
 
+            case 'z':
+                o_method = HETMETH_ZLIB;
+                o_compress = TRUE;
+            break;
+
+#if defined( HET_ZSTD )
+            case 'Z':
+                o_method = HETMETH_ZSTD;
+                o_compress = TRUE;
+            break;
+#endif /* defined( HET_ZSTD ) */
+
             default:
                 usage( argv[ 0 ] );
                 goto exit;
@@ -173,6 +209,13 @@ main( int argc, char *argv[] )
         goto exit;
     }
 
+    rc = het_cntl( hetb, HETCNTL_SET | HETCNTL_METHOD, o_method );
+    if( rc < 0 )
+    {
+        printf( "het_cntl() returned %d\n", rc );
+        goto exit;
+    }
+
     if( o_iehinitt )
     {
         rc = sl_vol1( &lab, o_volser, o_owner );
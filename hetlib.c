@@ -51,10 +51,472 @@ static const char *het_errstr[] =
     "Insufficient memory",
     "Couldn't read block header",
     "Inconsistent compression flags",
+    "Bad number of threads",
     "Invalid error code",
 };
 #define HET_ERRSTR_MAX ( sizeof( het_errstr) / sizeof( het_errstr[ 0 ] ) )
 
+
+/*
+|| Size of a buffer for compressed data (the worst case of any method)
+*/
+#define HET_CBUFSIZE ( HETMAX_BLOCKSIZE + ( HETMAX_BLOCKSIZE / 100 ) + 1024 )
+
+/*
+|| Block queued for the compression threads
+*/
+typedef struct _hetwb
+{
+    int             state;              /* HETWB_xxx                        */
+    int             method;             /* Compression method               */
+    int             level;              /* Compression level                */
+    int             ulen;               /* Uncompressed length              */
+    int             rc;                 /* Compression flags or error       */
+    int             errnum;             /* errno of a compression error     */
+    unsigned long   clen;               /* Compressed length                */
+    char            ubuf[ HETMAX_BLOCKSIZE ];  /* Uncompressed data         */
+    char            cbuf[ HET_CBUFSIZE ];      /* Compressed data           */
+} HETWB;
+
+#define HETWB_FREE      0               /* Slot not in use                  */
+#define HETWB_QUEUED    1               /* Waiting for a compression thread */
+#define HETWB_BUSY      2               /* Being compressed                 */
+#define HETWB_DONE      3               /* Ready to be written              */
+
+/*
+|| Compression threads of an HET file.  The blocks are queued in the ring
+|| in the order they are written to the tape, and only ever written to
+|| the file from the front of the ring, by the thread calling hetlib.
+*/
+struct _hetwq
+{
+    HETWB          *wb;                 /* Ring of queued blocks            */
+    int             nwb;                /* Slots in the ring                */
+    int             head;               /* Oldest block not yet written     */
+    int             count;              /* Blocks in the ring               */
+    int             nthreads;           /* Compression threads running      */
+    int             err;                /* Error deferred to the next call  */
+    int             errnum;             /* errno of the deferred error      */
+    int             shutdown;           /* TRUE=threads must exit           */
+    LOCK            lock;               /* Lock for the ring                */
+    COND            work;               /* Block queued                     */
+    COND            done;               /* Block compressed                 */
+    ATTR            attr;               /* Thread attributes                */
+    TID             tid[ HETMAX_THREADS ];     /* Compression threads       */
+};
+
+/*
+|| Compress a block.  Returns the HETHDR_FLAGS1 compression flag with the
+|| compressed data in "tbuf", 0 if the block is to be written as it is, or
+|| HETE_COMPERR.
+*/
+static int
+het_compress( int method, int level, void *sbuf, int slen,
+              char *tbuf, unsigned long *tlen )
+{
+    int rc;
+
+    switch( method )
+    {
+#if defined(HAVE_LIBZ)
+        case HETMETH_ZLIB:
+            *tlen = HET_CBUFSIZE;
+
+            rc = compress2( (unsigned char *)tbuf, tlen, sbuf, slen, level );
+            if( rc != Z_OK )
+            {
+                errno = rc;
+                return( HETE_COMPERR );
+            }
+
+            rc = HETHDR_FLAGS1_ZLIB;
+        break;
+#endif
+
+#if defined( HET_BZIP2 )
+        case HETMETH_BZLIB:
+            *tlen = HET_CBUFSIZE;
+
+            rc = BZ2_bzBuffToBuffCompress( tbuf,
+                                           (void *) tlen,
+                                           sbuf,
+                                           slen,
+                                           level,
+                                           0,
+                                           0 );
+            if( rc != BZ_OK )
+            {
+                errno = rc;
+                return( HETE_COMPERR );
+            }
+
+            rc = HETHDR_FLAGS1_BZLIB;
+        break;
+#endif /* defined( HET_BZIP2 ) */
+
+#if defined( HET_ZSTD )
+        case HETMETH_ZSTD:
+            *tlen = ZSTD_compress( tbuf, HET_CBUFSIZE, sbuf, slen, level );
+            if( ZSTD_isError( *tlen ) )
+            {
+                errno = EINVAL;
+                return( HETE_COMPERR );
+            }
+
+            rc = HETHDR_FLAGS1_ZSTD;
+        break;
+#endif /* defined( HET_ZSTD ) */
+
+        default:
+            return( 0 );
+    }
+
+    /*
+    || Only worth it if the data got smaller
+    */
+    return( (int)*tlen < slen ? rc : 0 );
+}
+
+/*
+|| Write a block, breaking it into "chksize" chunks.  Returns the length
+|| written or < 0.
+*/
+static int
+het_write_block( HETB *hetb, void *sbuf, int slen, int flags )
+{
+    int rc;
+    unsigned long tlen;
+
+    /*
+    || Save compressed length
+    */
+    hetb->cblksize = slen;
+
+    do
+    {
+        /*
+        || Last chunk for this block?
+        */
+        if( slen <= (int)hetb->chksize )
+        {
+            flags |= HETHDR_FLAGS1_EOR;
+            tlen = slen;
+        }
+        else
+        {
+            tlen = hetb->chksize;
+        }
+
+        /*
+        || Write the header
+        */
+        rc = het_write_header( hetb, tlen, flags, 0 );
+        if( rc < 0 )
+        {
+            return( rc );
+        }
+
+        /*
+        || Write the block
+        */
+        rc = fwrite( sbuf, 1, tlen, hetb->fd );
+        if( rc != (int)tlen )
+        {
+            return( HETE_ERROR );
+        }
+
+        /*
+        || Bump pointers and turn off BOR flag
+        */
+        {
+            char    *csbuf;
+            csbuf=(char *)sbuf;
+            csbuf+=tlen;
+            sbuf=(void *)csbuf;
+        }
+        slen -= tlen;
+        flags &= (~HETHDR_FLAGS1_BOR);
+    }
+    while( slen > 0 );
+
+    /*
+    || Set new physical EOF
+    */
+    do rc = ftruncate( fileno( hetb->fd ), ftell( hetb->fd ) );
+    while (EINTR == rc);
+    if (rc != 0)
+    {
+        return( HETE_ERROR );
+    }
+
+    return( hetb->cblksize );
+}
+
+/*
+|| Compression thread
+*/
+static void *
+het_compress_thread( struct _hetwq *wq )
+{
+    HETWB *wb;
+    int i;
+
+    obtain_lock( &wq->lock );
+
+    while( !wq->shutdown )
+    {
+        /*
+        || Take the oldest block waiting to be compressed
+        */
+        wb = NULL;
+        for( i = 0; i < wq->count; i++ )
+        {
+            if( wq->wb[ ( wq->head + i ) % wq->nwb ].state == HETWB_QUEUED )
+            {
+                wb = &wq->wb[ ( wq->head + i ) % wq->nwb ];
+                break;
+            }
+        }
+
+        if( wb == NULL )
+        {
+            wait_condition( &wq->work, &wq->lock );
+            continue;
+        }
+
+        wb->state = HETWB_BUSY;
+        release_lock( &wq->lock );
+
+        wb->rc = het_compress( wb->method, wb->level, wb->ubuf, wb->ulen,
+                               wb->cbuf, &wb->clen );
+        wb->errnum = errno;
+
+        obtain_lock( &wq->lock );
+        wb->state = HETWB_DONE;
+        signal_condition( &wq->done );
+    }
+
+    release_lock( &wq->lock );
+
+    return( NULL );
+}
+
+/*
+|| Write the compressed blocks at the front of the ring.  Once a block
+|| has failed, the blocks behind it are discarded rather than leave a gap
+|| on the tape.  Called with the ring locked.
+*/
+static void
+het_write_done( HETB *hetb )
+{
+    struct _hetwq *wq = hetb->wq;
+    HETWB *wb;
+    int rc;
+
+    while( wq->count > 0 && wq->wb[ wq->head ].state == HETWB_DONE )
+    {
+        wb = &wq->wb[ wq->head ];
+
+        if( wq->err == 0 )
+        {
+            release_lock( &wq->lock );
+
+            rc = wb->rc;
+            if( rc < 0 )
+            {
+                errno = wb->errnum;
+            }
+            else
+            {
+                hetb->ublksize = wb->ulen;
+                if( rc > 0 )
+                {
+                    rc = het_write_block( hetb, wb->cbuf, wb->clen,
+                                          HETHDR_FLAGS1_BOR | rc );
+                }
+                else
+                {
+                    rc = het_write_block( hetb, wb->ubuf, wb->ulen,
+                                          HETHDR_FLAGS1_BOR );
+                }
+            }
+
+            obtain_lock( &wq->lock );
+
+            if( rc < 0 )
+            {
+                wq->err = rc;
+                wq->errnum = errno;
+            }
+        }
+
+        wb->state = HETWB_FREE;
+        wq->head = ( wq->head + 1 ) % wq->nwb;
+        wq->count--;
+    }
+}
+
+/*
+|| Queue a block to be compressed and written
+*/
+static int
+het_queue( HETB *hetb, void *sbuf, int slen )
+{
+    struct _hetwq *wq = hetb->wq;
+    HETWB *wb;
+    int rc;
+
+    obtain_lock( &wq->lock );
+
+    /*
+    || Write what is ready, waiting for room in the ring if it is full
+    */
+    het_write_done( hetb );
+    while( wq->count == wq->nwb )
+    {
+        wait_condition( &wq->done, &wq->lock );
+        het_write_done( hetb );
+    }
+
+    /*
+    || Report an earlier failure instead of accepting more data
+    */
+    rc = wq->err;
+    if( rc < 0 )
+    {
+        wq->err = 0;
+        errno = wq->errnum;
+        release_lock( &wq->lock );
+        return( rc );
+    }
+
+    wb = &wq->wb[ ( wq->head + wq->count ) % wq->nwb ];
+    memcpy( wb->ubuf, sbuf, slen );
+    wb->ulen = slen;
+    wb->method = hetb->method;
+    wb->level = hetb->level;
+    wb->state = HETWB_QUEUED;
+    wq->count++;
+    signal_condition( &wq->work );
+
+    release_lock( &wq->lock );
+
+    return( slen );
+}
+
+/*
+|| Write all of the queued blocks, leaving any error for the next call
+*/
+static void
+het_drain( HETB *hetb )
+{
+    struct _hetwq *wq = hetb->wq;
+
+    /*
+    || Only the calling thread changes the ring's contents
+    */
+    if( wq == NULL || wq->count == 0 )
+    {
+        return;
+    }
+
+    obtain_lock( &wq->lock );
+
+    het_write_done( hetb );
+    while( wq->count > 0 )
+    {
+        wait_condition( &wq->done, &wq->lock );
+        het_write_done( hetb );
+    }
+
+    release_lock( &wq->lock );
+}
+
+/*
+|| Stop the compression threads.  The ring must be empty.
+*/
+static void
+het_stop_threads( HETB *hetb )
+{
+    struct _hetwq *wq = hetb->wq;
+    int i;
+
+    if( wq == NULL )
+    {
+        return;
+    }
+
+    obtain_lock( &wq->lock );
+    wq->shutdown = TRUE;
+    broadcast_condition( &wq->work );
+    release_lock( &wq->lock );
+
+    for( i = 0; i < wq->nthreads; i++ )
+    {
+        join_thread( wq->tid[ i ], NULL );
+    }
+
+    destroy_condition( &wq->done );
+    destroy_condition( &wq->work );
+    destroy_lock( &wq->lock );
+    free( wq->wb );
+    free( wq );
+
+    hetb->wq = NULL;
+}
+
+/*
+|| Start the compression threads
+*/
+static int
+het_start_threads( HETB *hetb, int n )
+{
+    struct _hetwq *wq;
+
+    wq = calloc( 1, sizeof( struct _hetwq ) );
+    if( wq == NULL )
+    {
+        return( HETE_NOMEM );
+    }
+
+    /*
+    || Two blocks per thread lets the next ones be queued while each
+    || thread is busy
+    */
+    wq->nwb = n * 2;
+    wq->wb = calloc( wq->nwb, sizeof( HETWB ) );
+    if( wq->wb == NULL )
+    {
+        free( wq );
+        return( HETE_NOMEM );
+    }
+
+    initialize_lock( &wq->lock );
+    initialize_condition( &wq->work );
+    initialize_condition( &wq->done );
+    initialize_join_attr( &wq->attr );
+
+    for( wq->nthreads = 0; wq->nthreads < n; wq->nthreads++ )
+    {
+        if( create_thread( &wq->tid[ wq->nthreads ], &wq->attr,
+                           het_compress_thread, wq, "het_compress_thread" ) )
+        {
+            break;
+        }
+    }
+
+    /*
+    || Without any threads the blocks are simply compressed as they come
+    */
+    hetb->wq = wq;
+    if( wq->nthreads == 0 )
+    {
+        het_stop_threads( hetb );
+    }
+
+    return( 0 );
+}
+
 /*==DOC==
 
     NAME
@@ -165,6 +627,7 @@ het_open( HETB **hetb, char *filename, int flags )
     thetb->method     = HETDFLT_METHOD;
     thetb->level      = HETDFLT_LEVEL;
     thetb->chksize    = HETDFLT_CHKSIZE;
+    tapeidx_init( &thetb->idx );
 
     /*
     || clear HETOPEN_CREATE if HETOPEN_READONLY is specified
@@ -218,6 +681,11 @@ het_open( HETB **hetb, char *filename, int flags )
         return( HETE_ERROR );
     }
 
+    /*
+    || Set up the read-ahead (reads are unbuffered if this fails)
+    */
+    tapera_init( &thetb->ra, fd );
+
     /*
     || If uninitialized tape, write 2 tapemarks to make it a valid NL tape
     */
@@ -279,8 +747,9 @@ het_open( HETB **hetb, char *filename, int flags )
             and the location specified by the "hetb" parameter will be set
             to NULL.
 
-            If an error occurs, then the return value will be < 0.  At this
-            time, no errors will be returned.
+            If an error occurs, then the return value will be < 0.  The
+            only errors returned are those of het_flush(), and the HETB is
+            released regardless.
 
     EXAMPLE
             //
@@ -317,12 +786,19 @@ het_open( HETB **hetb, char *filename, int flags )
 DLL_EXPORT int
 het_close( HETB **hetb )
 {
+    int rc = 0;
 
     /*
     || Only free the HETB if we have one
     */
     if( *(hetb) != NULL )
     {
+        /*
+        || Write out the queued blocks and stop the compression threads
+        */
+        rc = het_flush( *hetb );
+        het_stop_threads( *hetb );
+
         /*
         || Only close the file if opened
         */
@@ -330,6 +806,8 @@ het_close( HETB **hetb )
         {
             fclose( (*hetb)->fd );
         }
+        tapera_term( &(*hetb)->ra );
+        tapeidx_term( &(*hetb)->idx );
         free( *(hetb) );
     }
 
@@ -338,7 +816,7 @@ het_close( HETB **hetb )
     */
     *hetb = NULL;
 
-    return( 0 );
+    return( rc );
 }
 
 /*==DOC==
@@ -379,6 +857,7 @@ het_close( HETB **hetb )
             HETCNTL_METHOD      val=Compression method to use
                                 Values:     HETMETH_ZLIB (1)
                                             HETMETH_BZLIB (2)
+                                            HETMETH_ZSTD (3)
                                 Default:    HETDFLT_METHOD (HETMETH_ZLIB)
 
             HETCNTL_LEVEL       val=Level of compression
@@ -391,6 +870,11 @@ het_close( HETB **hetb )
                                 Max:        HETMAX_CHUNKSIZE (65535)
                                 Default:    HETDFLT_CHUNKSIZE (65535)
 
+            HETCNTL_THREADS     val=Number of compression threads (see notes)
+                                Min:        0
+                                Max:        HETMAX_THREADS (8)
+                                Default:    0
+
     RETURN VALUE
             If no errors are detected then the return value will be either
             the current setting for a "get" request or >= 0 for a "set"
@@ -405,6 +889,8 @@ het_close( HETB **hetb )
 
             HETE_BADCHUNKSIZE   Specified chunk size out of range
 
+            HETE_BADTHREADS     Specified number of threads out of range
+
             HETE_BADFUNC        Unrecognized function code
 
     NOTES
@@ -414,6 +900,15 @@ het_close( HETB **hetb )
             If you wish to create an AWSTAPE compatible file, specify a chunk
             size of 4096 and disable write compression.
 
+            With compression threads, het_write() queues each block to be
+            compressed while the program carries on, and the blocks are
+            written to the file in order as they become ready.  The current
+            block number and the file position then lag behind the blocks
+            written until any of the other functions, which first write out
+            all of the queued blocks, is called.  An error writing a queued
+            block is returned by the next call.  Setting the number of
+            threads to 0 writes out the queued blocks and stops the threads.
+
     EXAMPLE
             //
             // Create an NL tape and write an uncompressed string to it
@@ -460,6 +955,7 @@ het_close( HETB **hetb )
 DLL_EXPORT int
 het_cntl( HETB *hetb, int func, unsigned long val )
 {
+    int rc;
     int mode;
 
     /*
@@ -500,6 +996,12 @@ het_cntl( HETB *hetb, int func, unsigned long val )
             {
                 return( HETE_BADMETHOD );
             }
+#if !defined( HET_BZIP2 )
+            if( val == HETMETH_BZLIB )
+            {
+                return( HETE_BADMETHOD );
+            }
+#endif /* !defined( HET_BZIP2 ) */
 
             hetb->method = val;
         break;
@@ -532,6 +1034,31 @@ het_cntl( HETB *hetb, int func, unsigned long val )
             hetb->chksize = val;
         break;
 
+        case HETCNTL_THREADS:
+            if( mode == HETCNTL_GET )
+            {
+                return( hetb->wq != NULL ? hetb->wq->nthreads : 0 );
+            }
+
+            if( val > HETMAX_THREADS )
+            {
+                return( HETE_BADTHREADS );
+            }
+
+            rc = het_flush( hetb );
+            if( rc < 0 )
+            {
+                return( rc );
+            }
+
+            het_stop_threads( hetb );
+
+            if( val > 0 )
+            {
+                return( het_start_threads( hetb, val ) );
+            }
+        break;
+
         default:
             return( HETE_BADFUNC );
         break;
@@ -615,15 +1142,33 @@ het_cntl( HETB *hetb, int func, unsigned long val )
 
 ==DOC==*/
 
-DLL_EXPORT int
-het_read_header( HETB *hetb )
+static int
+het_get_header( HETB *hetb, off_t *pos )
 {
     int rc;
 
     /*
-    || Read in a headers worth of data
+    || Read in a headers worth of data, from the stream or, when called by
+    || het_read(), through the read-ahead buffers at the offset given
     */
-    rc = fread( &hetb->chdr, sizeof( HETHDR ), 1, hetb->fd );
+    if( pos != NULL )
+    {
+        rc = tapera_read( &hetb->ra, &hetb->chdr, sizeof( HETHDR ), *pos );
+        if( rc < 0 )
+        {
+            return( HETE_ERROR );
+        }
+        *pos += rc;
+        rc = ( rc == sizeof( HETHDR ) );
+        if( rc != 1 )
+        {
+            return( HETE_EOT );
+        }
+    }
+    else
+    {
+        rc = fread( &hetb->chdr, sizeof( HETHDR ), 1, hetb->fd );
+    }
     if( rc != 1 )
     {
         /*
@@ -668,6 +1213,23 @@ het_read_header( HETB *hetb )
     return( 0 );
 }
 
+DLL_EXPORT int
+het_read_header( HETB *hetb )
+{
+    int rc;
+
+    /*
+    || Write out the blocks still queued for compression
+    */
+    rc = het_flush( hetb );
+    if( rc < 0 )
+    {
+        return( rc );
+    }
+
+    return( het_get_header( hetb, NULL ) );
+}
+
 /*==DOC==
 
     NAME
@@ -747,8 +1309,8 @@ het_read_header( HETB *hetb )
 
 ==DOC==*/
 
-DLL_EXPORT int
-het_read( HETB *hetb, void *sbuf )
+static int
+het_read_block( HETB *hetb, void *sbuf, off_t *pos )
 {
     char *tptr;
     int rc;
@@ -772,7 +1334,7 @@ het_read( HETB *hetb, void *sbuf )
         /*
         || Get a header
         */
-        rc = het_read_header( hetb );
+        rc = het_get_header( hetb, pos );
         if( rc < 0 )
         {
             return( rc );
@@ -857,15 +1419,33 @@ het_read( HETB *hetb, void *sbuf )
         /*
         || Finally read in the chunk data
         */
-        rc = fread( tptr, 1, slen, hetb->fd );
-        if( rc != (int)slen )
+        if( pos != NULL )
         {
-            if( feof( hetb->fd ) )
+            rc = tapera_read( &hetb->ra, tptr, slen, *pos );
+            if( rc != (int)slen )
             {
-                return( HETE_PREMEOF );
+                if( rc >= 0 )
+                {
+                    *pos += rc;
+                    return( HETE_PREMEOF );
+                }
+
+                return( HETE_ERROR );
             }
+            *pos += slen;
+        }
+        else
+        {
+            rc = fread( tptr, 1, slen, hetb->fd );
+            if( rc != (int)slen )
+            {
+                if( feof( hetb->fd ) )
+                {
+                    return( HETE_PREMEOF );
+                }
 
-            return( HETE_ERROR );
+                return( HETE_ERROR );
+            }
         }
 
         /*
@@ -948,6 +1528,19 @@ het_read( HETB *hetb, void *sbuf )
             break;
 #endif /* defined( HET_BZIP2 ) */
 
+#if defined( HET_ZSTD )
+            case HETHDR_FLAGS1_ZSTD:
+                slen = ZSTD_decompress( sbuf, HETMAX_BLOCKSIZE, tbuf, tlen );
+                if( ZSTD_isError( slen ) )
+                {
+                    errno = EINVAL;
+                    return( HETE_DECERR );
+                }
+
+                tlen = slen;
+            break;
+#endif /* defined( HET_ZSTD ) */
+
             default:
                 return( HETE_UNKMETH );
             break;
@@ -955,14 +1548,72 @@ het_read( HETB *hetb, void *sbuf )
     }
 
     /*
-    || Save uncompressed length
+    || Save uncompressed length
+    */
+    hetb->ublksize = tlen;
+
+    /*
+    || Success
+    */
+    return( tlen );
+}
+
+DLL_EXPORT int
+het_read( HETB *hetb, void *sbuf )
+{
+    int rc;
+    uint32_t blk;
+    off_t blkpos;
+    off_t pos;
+
+    /*
+    || Write out the blocks still queued for compression
+    */
+    rc = het_flush( hetb );
+    if( rc < 0 )
+    {
+        return( rc );
+    }
+
+    /*
+    || When the read-ahead can work in the background, the block is read
+    || through its buffers, starting at the current stream position, and
+    || the stream is then positioned after it.  Otherwise the stream's own
+    || buffering is cheaper.
+    */
+    blk = hetb->cblk;
+    if( hetb->ra.async )
+    {
+        fflush( hetb->fd );
+        blkpos = pos = ftell( hetb->fd );
+        if( pos == -1 )
+        {
+            return( HETE_ERROR );
+        }
+
+        rc = het_read_block( hetb, sbuf, &pos );
+
+        if( fseek( hetb->fd, pos, SEEK_SET ) == -1 )
+        {
+            return( HETE_ERROR );
+        }
+    }
+    else
+    {
+        blkpos = ftell( hetb->fd );
+        rc = het_read_block( hetb, sbuf, NULL );
+        pos = ftell( hetb->fd );
+    }
+
+    /*
+    || Remember where the block was
     */
-    hetb->ublksize = tlen;
+    if( ( rc >= 0 || rc == HETE_TAPEMARK ) && blkpos != -1 )
+    {
+        tapeidx_add( &hetb->idx, blk, blkpos, pos, rc == HETE_TAPEMARK );
+    }
 
-    /*
-    || Success
-    */
-    return( tlen );
+    return( rc );
 }
 
 /*==DOC==
@@ -1072,6 +1723,15 @@ het_write_header( HETB *hetb, int len, int flags1, int flags2 )
         len = 0;
     }
 
+    /*
+    || Anything buffered or indexed from here on is about to be replaced
+    */
+    tapera_reset( &hetb->ra );
+    if( flags1 & ( HETHDR_FLAGS1_BOR | HETHDR_FLAGS1_TAPEMARK ) )
+    {
+        tapeidx_truncate( &hetb->idx, hetb->cblk );
+    }
+
     /*
     || According to Linux fopen() man page, a positioning function is required
     || between reads and writes.  Is this REALLY necessary???
@@ -1154,7 +1814,8 @@ het_write_header( HETB *hetb, int len, int flags1, int flags2 )
             If no errors are detected then the return value will be the
             size of the block written.  This will be either the compressed or
             uncompressed length depending on the current AWSCNTL_COMPRESS
-            setting.
+            setting.  A block queued for the compression threads returns
+            its uncompressed length.
 
             If an error occurs, then the return value will be < 0 and can be
             one of the following:
@@ -1163,6 +1824,8 @@ het_write_header( HETB *hetb, int len, int flags1, int flags2 )
 
             HETE_BADLEN         "slen" parameter out of range
 
+            HETE_COMPERR        Compression failed
+
             HETE_BADCOMPRESS    Compression mismatch between related chunks
 
             For other possible errors, see:
@@ -1213,9 +1876,7 @@ het_write( HETB *hetb, void *sbuf, int slen )
     int rc;
     int flags;
     unsigned long tlen;
-#if defined(HAVE_LIBZ) || defined( HET_BZIP2 )
-    char tbuf[ ((((HETMAX_BLOCKSIZE * 1001) + 999) / 1000) + 12) ];
-#endif
+    char tbuf[ HET_CBUFSIZE ];
 
     /*
     || Validate
@@ -1225,6 +1886,20 @@ het_write( HETB *hetb, void *sbuf, int slen )
         return( HETE_BADLEN );
     }
 
+    /*
+    || Leave the compression to the threads, if there are any
+    */
+    if( hetb->wq != NULL && hetb->compress )
+    {
+        return( het_queue( hetb, sbuf, slen ) );
+    }
+
+    rc = het_flush( hetb );
+    if( rc < 0 )
+    {
+        return( rc );
+    }
+
     /*
     || Initialize
     */
@@ -1240,125 +1915,24 @@ het_write( HETB *hetb, void *sbuf, int slen )
     */
     if( hetb->compress )
     {
-        switch( hetb->method )
-        {
-#if defined(HAVE_LIBZ)
-            case HETHDR_FLAGS1_ZLIB:
-                tlen = sizeof( tbuf );
-
-                rc = compress2( (unsigned char *)tbuf, &tlen, sbuf, slen, hetb->level );
-                if( rc != Z_OK )
-                {
-                    errno = rc;
-                    return( HETE_COMPERR );
-                }
-
-                if( (int)tlen < slen )
-                {
-                    sbuf = tbuf;
-                    slen = tlen;
-                    flags |= HETHDR_FLAGS1_ZLIB;
-                }
-            break;
-#endif
-
-#if defined( HET_BZIP2 )
-            case HETHDR_FLAGS1_BZLIB:
-                tlen = sizeof( tbuf );
-
-                rc = BZ2_bzBuffToBuffCompress( tbuf,
-                                               (void *) &tlen,
-                                               sbuf,
-                                               slen,
-                                               hetb->level,
-                                               0,
-                                               0 );
-                if( rc != BZ_OK )
-                {
-                    errno = rc;
-                    return( HETE_COMPERR );
-                }
-
-                if( (int)tlen < slen )
-                {
-                    sbuf = tbuf;
-                    slen = tlen;
-                    flags |= HETHDR_FLAGS1_BZLIB;
-                }
-            break;
-#endif /* defined( HET_BZIP2 ) */
-        }
-    }
-
-    /*
-    || Save compressed length
-    */
-    hetb->cblksize = slen;
-
-    /*
-    || Write block, breaking it into "chksize" chunks
-    */
-    do
-    {
-        /*
-        || Last chunk for this block?
-        */
-        if( slen <= (int)hetb->chksize )
-        {
-            flags |= HETHDR_FLAGS1_EOR;
-            tlen = slen;
-        }
-        else
-        {
-            tlen = hetb->chksize;
-        }
-
-        /*
-        || Write the header
-        */
-        rc = het_write_header( hetb, tlen, flags, 0 );
+        rc = het_compress( hetb->method, hetb->level, sbuf, slen, tbuf, &tlen );
         if( rc < 0 )
         {
             return( rc );
         }
 
-        /*
-        || Write the block
-        */
-        rc = fwrite( sbuf, 1, tlen, hetb->fd );
-        if( rc != (int)tlen )
-        {
-            return( HETE_ERROR );
-        }
-
-        /*
-        || Bump pointers and turn off BOR flag
-        */
+        if( rc > 0 )
         {
-            char    *csbuf;
-            csbuf=(char *)sbuf;
-            csbuf+=tlen;
-            sbuf=(void *)csbuf;
+            sbuf = tbuf;
+            slen = tlen;
+            flags |= rc;
         }
-        slen -= tlen;
-        flags &= (~HETHDR_FLAGS1_BOR);
-    }
-    while( slen > 0 );
-
-    /*
-    || Set new physical EOF
-    */
-    do rc = ftruncate( fileno( hetb->fd ), ftell( hetb->fd ) );
-    while (EINTR == rc);
-    if (rc != 0)
-    {
-        return( HETE_ERROR );
     }
 
     /*
-    || Success
+    || Write block
     */
-    return( hetb->cblksize );
+    return( het_write_block( hetb, sbuf, slen, flags ) );
 }
 
 /*==DOC==
@@ -1423,6 +1997,15 @@ het_tapemark( HETB *hetb )
 {
     int rc;
 
+    /*
+    || Write out the blocks still queued for compression
+    */
+    rc = het_flush( hetb );
+    if( rc < 0 )
+    {
+        return( rc );
+    }
+
     /*
     || Just write a tapemark header
     */
@@ -1448,6 +2031,62 @@ het_tapemark( HETB *hetb )
     return( 0 );
 }
 
+/*==DOC==
+
+    NAME
+            het_flush - Write the blocks queued for compression
+
+    SYNOPSIS
+            #include "hetlib.h"
+
+            int het_flush( HETB *hetb )
+
+    DESCRIPTION
+            Waits for the compression threads to finish with the blocks
+            queued by het_write() and writes them to the HET file.  This
+            is done by all other functions before they start, so needs to
+            be called only to bring the file and HETB up to date, or to
+            collect an error writing a queued block.
+
+    RETURN VALUE
+            If no errors are detected then the return value will be >= 0.
+
+            If an error occurs, then the return value will be < 0 and will be
+            the one which writing or compressing the first failing block
+            would have returned from het_write().  The blocks following it
+            are discarded.
+
+    SEE ALSO
+            het_write(), het_cntl()
+
+==DOC==*/
+
+DLL_EXPORT int
+het_flush( HETB *hetb )
+{
+    struct _hetwq *wq = hetb->wq;
+    int rc;
+
+    if( wq == NULL || ( wq->count == 0 && wq->err == 0 ) )
+    {
+        return( 0 );
+    }
+
+    het_drain( hetb );
+
+    obtain_lock( &wq->lock );
+    rc = wq->err;
+    if( rc < 0 )
+    {
+        wq->err = 0;
+        errno = wq->errnum;
+    }
+
+    release_lock( &wq->lock );
+
+    return( rc );
+}
+
 /*==DOC==
 
     NAME
@@ -1526,6 +2165,15 @@ het_sync( HETB *hetb )
 {
     int rc;
 
+    /*
+    || Write out the blocks still queued for compression
+    */
+    rc = het_flush( hetb );
+    if( rc < 0 )
+    {
+        return( rc );
+    }
+
     /*
     || Can't sync to readonly media
     */
@@ -1617,9 +2265,47 @@ DLL_EXPORT int
 het_locate( HETB *hetb, int block )
 {
     int rc;
+    off_t pos;
+
+    /*
+    || Write out the blocks still queued for compression
+    */
+    rc = het_flush( hetb );
+    if( rc < 0 )
+    {
+        return( rc );
+    }
+
+    /*
+    || If the block index can find the preceding block, go straight there
+    || and space over it so that the current chunk header is kept valid
+    */
+    if( block > 0 )
+    {
+        fflush( hetb->fd );
+        if( tapeidx_locate( &hetb->idx, fileno( hetb->fd ), block - 1, &pos ) == 0 )
+        {
+            rc = fseek( hetb->fd, pos, SEEK_SET );
+            if( rc == -1 )
+            {
+                return( HETE_ERROR );
+            }
+
+            hetb->cblk = block - 1;
+            hetb->truncated = FALSE;
+
+            rc = het_fsb( hetb );
+            if( rc < 0 && HETE_TAPEMARK != rc )
+            {
+                return( rc );
+            }
+
+            return( hetb->cblk );
+        }
+    }
 
     /*
-    || Start the search from the beginning
+    || Otherwise start the search from the beginning
     */
     rc = het_rewind( hetb );
     if( rc < 0 )
@@ -1723,6 +2409,15 @@ het_bsb( HETB *hetb )
                     //  since we only ever seek from SEEK_CUR)
     int tapemark = FALSE;
 
+    /*
+    || Write out the blocks still queued for compression
+    */
+    rc = het_flush( hetb );
+    if( rc < 0 )
+    {
+        return( rc );
+    }
+
     /*
     || Error if at BOT
     */
@@ -1911,6 +2606,23 @@ DLL_EXPORT int
 het_fsb( HETB *hetb )
 {
     int rc;
+    uint32_t blk;
+    off_t blkpos;
+
+    /*
+    || Write out the blocks still queued for compression
+    */
+    rc = het_flush( hetb );
+    if( rc < 0 )
+    {
+        return( rc );
+    }
+
+    /*
+    || Remember where the block starts, for the block index
+    */
+    blk = hetb->cblk;
+    blkpos = ftell( hetb->fd );
 
     /*
     || Loop until we've processed an entire block
@@ -1923,6 +2635,10 @@ het_fsb( HETB *hetb )
         rc = het_read_header( hetb );
         if( rc < 0 )
         {
+            if( rc == HETE_TAPEMARK && blkpos != -1 )
+            {
+                tapeidx_add( &hetb->idx, blk, blkpos, ftell( hetb->fd ), TRUE );
+            }
             return( rc );
         }
 
@@ -1939,6 +2655,11 @@ het_fsb( HETB *hetb )
     }
     while( !( hetb->chdr.flags1 & HETHDR_FLAGS1_EOR ) );
 
+    if( blkpos != -1 )
+    {
+        tapeidx_add( &hetb->idx, blk, blkpos, ftell( hetb->fd ), FALSE );
+    }
+
     /*
     || Reset flag to force truncation if a write occurs
     */
@@ -2017,9 +2738,39 @@ DLL_EXPORT int
 het_bsf( HETB *hetb )
 {
     int rc;
+    uint32_t tm;
+
+    /*
+    || Write out the blocks still queued for compression
+    */
+    rc = het_flush( hetb );
+    if( rc < 0 )
+    {
+        return( rc );
+    }
+
+    /*
+    || If the block index knows the preceding tapemark, locate it directly
+    */
+    if( hetb->cblk > 0 )
+    {
+        fflush( hetb->fd );
+        if( tapeidx_prevtm( &hetb->idx, fileno( hetb->fd ), hetb->cblk, &tm ) == 0 )
+        {
+            return( het_locate( hetb, tm ) );
+        }
+
+        /*
+        || No tapemark at all before the current block
+        */
+        if( hetb->idx.nblks >= hetb->cblk )
+        {
+            return( het_rewind( hetb ) );
+        }
+    }
 
     /*
-    || Backspace until we hit a tapemark
+    || Otherwise backspace until we hit a tapemark
     */
     do
     {
@@ -2104,6 +2855,38 @@ DLL_EXPORT int
 het_fsf( HETB *hetb )
 {
     int rc;
+    uint32_t tm;
+
+    /*
+    || Write out the blocks still queued for compression
+    */
+    rc = het_flush( hetb );
+    if( rc < 0 )
+    {
+        return( rc );
+    }
+
+    /*
+    || If the block index can find the next tapemark, locate the block
+    || after it directly
+    */
+    fflush( hetb->fd );
+    if( tapeidx_nexttm( &hetb->idx, fileno( hetb->fd ), hetb->cblk, &tm ) == 0 )
+    {
+        return( het_locate( hetb, tm + 1 ) );
+    }
+
+    /*
+    || If there are no more tapemarks, skip to the last block
+    */
+    if( hetb->idx.complete && hetb->cblk < hetb->idx.nblks )
+    {
+        rc = het_locate( hetb, hetb->idx.nblks - 1 );
+        if( rc < 0 )
+        {
+            return( rc );
+        }
+    }
 
     /*
     || Forward space until we hit a tapemark
@@ -2193,6 +2976,15 @@ het_rewind( HETB *hetb )
 {
     int rc;
 
+    /*
+    || Write out the blocks still queued for compression
+    */
+    rc = het_flush( hetb );
+    if( rc < 0 )
+    {
+        return( rc );
+    }
+
     /*
     || Just seek to the beginning of the file
     */
@@ -2352,7 +3144,14 @@ DLL_EXPORT
 off_t
 het_tell( HETB *hetb )
 {
-    off_t rwptr = ftell( hetb->fd );
+    off_t rwptr;
+
+    /*
+    || Any error writing the queued blocks is left for the next call
+    */
+    het_drain( hetb );
+
+    rwptr = ftell( hetb->fd );
     if ( rwptr < 0 )
     {
         return HETE_ERROR;
@@ -16,6 +16,7 @@
 */
 
 #include "hercules.h"
+#include "tapeidx.h"
 
 #ifndef _HETLIB_C_
 #ifndef _HTAPE_DLL_
@@ -60,6 +61,7 @@ typedef struct _hethdr
 #define HETHDR_FLAGS1_TAPEMARK  0x40    /* Tape mark                        */
 #define HETHDR_FLAGS1_EOR       0x20    /* End of record                    */
 #define HETHDR_FLAGS1_COMPRESS  0x03    /* Compression method mask          */
+#define HETHDR_FLAGS1_ZSTD      0x03    /* ZSTD compression                 */
 #define HETHDR_FLAGS1_BZLIB     0x02    /* BZLIB compression                */
 #define HETHDR_FLAGS1_ZLIB      0x01    /* ZLIB compression                 */
 
@@ -85,8 +87,11 @@ typedef struct _hetb
     u_int           truncated:1;        /* TRUE=file truncated              */
     u_int           compress:1;         /* TRUE=compress written data       */
     u_int           decompress:1;       /* TRUE=decompress read data        */
-    u_int           method:2;           /* 1=ZLIB, 2=BZLIB compresion       */
+    u_int           method:2;           /* 1=ZLIB, 2=BZLIB, 3=ZSTD          */
     u_int           level:4;            /* 1=<n<=9 compression level        */
+    struct _hetwq  *wq;                 /* Compression threads, if any      */
+    TAPEIDX         idx;                /* Block index                      */
+    TAPERA          ra;                 /* Read-ahead                       */
 } HETB;
 
 /*
@@ -94,22 +99,26 @@ typedef struct _hetb
 */
 #define HETMETH_ZLIB            1       /* ZLIB compression                 */
 #define HETMETH_BZLIB           2       /* BZLIB compression                */
+#define HETMETH_ZSTD            3       /* ZSTD compression                 */
 
 /*
 || Limits
 */
 #define HETMIN_METHOD           1       /* Minimum compression method       */
-#if defined( HET_BZIP2 )
+#if defined( HET_ZSTD )
+#define HETMAX_METHOD           3       /* Maximum compression method       */
+#elif defined( HET_BZIP2 )
 #define HETMAX_METHOD           2       /* Maximum compression method       */
 #else
 #define HETMAX_METHOD           1       /* Maximum compression method       */
-#endif /* defined( HET_BZIP2 ) */
+#endif
 #define HETMIN_LEVEL            1       /* Minimum compression level        */
 #define HETMAX_LEVEL            9       /* Maximum compression level        */
 #define HETMIN_CHUNKSIZE        4096    /* Minimum chunksize                */
 #define HETMAX_CHUNKSIZE        65535   /* Maximum chunksize                */
 #define HETMIN_BLOCKSIZE        1       /* Minimum blocksize                */
 #define HETMAX_BLOCKSIZE        65535   /* Maximum blocksize                */
+#define HETMAX_THREADS          8       /* Maximum compression threads      */
 
 /*
 || Default settings
@@ -120,6 +129,13 @@ typedef struct _hetb
 #define HETDFLT_LEVEL           4       /* Middle of the road               */
 #define HETDFLT_CHKSIZE         HETMAX_BLOCKSIZE /* As big as it gets       */
 
+/*
+|| Compression threads worth starting, leaving a processor for the caller
+*/
+#define HETAUTO_THREADS         ( hostinfo.num_procs > 1 ?                    \
+                                  MIN( hostinfo.num_procs - 1,                \
+                                       HETMAX_THREADS ) : 0 )
+
 /*
 || Flags for het_open()
 */
@@ -140,6 +156,7 @@ typedef struct _hetb
 #define HETCNTL_METHOD          3       /* Compression method               */
 #define HETCNTL_LEVEL           4       /* Compression level                */
 #define HETCNTL_CHUNKSIZE       5       /* Chunk size                       */
+#define HETCNTL_THREADS         6       /* Compression threads              */
 
 /*
 || Error definitions
@@ -167,6 +184,7 @@ typedef struct _hetb
 #define HETE_NOMEM              -20     /* Insufficient memory              */
 #define HETE_BADHDR             -21     /* Couldn't read block header       */
 #define HETE_BADCOMPRESS        -22     /* Inconsistent compression flags   */
+#define HETE_BADTHREADS         -23     /* Bad number of threads            */
 
 /*
 || Public functions
@@ -178,6 +196,7 @@ HET_DLL_IMPORT int het_read( HETB *hetb, void *sbuf );
 HET_DLL_IMPORT int het_write_header( HETB *hetb, int len, int flags1, int flags2 );
 HET_DLL_IMPORT int het_write( HETB *hetb, void *sbuf, int slen );
 HET_DLL_IMPORT int het_tapemark( HETB *hetb );
+HET_DLL_IMPORT int het_flush( HETB *hetb );
 HET_DLL_IMPORT int het_sync( HETB *hetb );
 HET_DLL_IMPORT int het_cntl( HETB *hetb, int func, unsigned long val );
 HET_DLL_IMPORT int het_locate( HETB *hetb, int block );
@@ -78,6 +78,16 @@ int             rc;                     /* Return code               */
                                 HETCNTL_SET | HETCNTL_CHUNKSIZE,
                                 dev->tdparms.chksize);
                 }
+                /* Compress on other processors while the channel
+                   program continues, unless every write has to
+                   find the exact size of the file anyway */
+                if (rc >= 0 && dev->tdparms.compress
+                 && dev->tdparms.maxsize == 0)
+                {
+                    rc = het_cntl (dev->hetb,
+                                HETCNTL_SET | HETCNTL_THREADS,
+                                HETAUTO_THREADS);
+                }
             }
         }
     }
@@ -97,6 +107,10 @@ int             rc;                     /* Return code               */
         return -1;
     }
 
+    /* Use the block index from the last time, if it is still valid */
+    if (dev->tdparms.idxfile)
+        tapeidx_load (&dev->hetb->idx, fileno(dev->hetb->fd), dev->filename);
+
     /* Indicate file opened */
     dev->fd = 1;
 
@@ -111,6 +125,24 @@ int             rc;                     /* Return code               */
 /*-------------------------------------------------------------------*/
 void close_het (DEVBLK *dev)
 {
+int             rc;                     /* Return code               */
+
+    /* Write out the blocks still being compressed */
+    if (dev->hetb && (rc = het_flush (dev->hetb)) < 0)
+        logmsg (_("HHCTA423E %4.4X: Error writing data block "
+                "at block %8.8X in file %s: %s(%s)\n"),
+                dev->devnum, dev->hetb->cblk, dev->filename,
+                het_error(rc), strerror(errno));
+
+    /* Keep the block index for the next time the tape is used */
+    if (dev->hetb && dev->tdparms.idxfile)
+    {
+        fflush (dev->hetb->fd);
+        if (tapeidx_save (&dev->hetb->idx, fileno(dev->hetb->fd),
+                          dev->filename) < 0)
+            logmsg (_("HHCTA422W %4.4X: Unable to write block index "
+                    "of file %s\n"), dev->devnum, dev->filename);
+    }
 
     /* Close the HET file */
     het_close (&dev->hetb);
@@ -252,6 +284,8 @@ off_t           cursize;                /* Current size for size chk */
                         dev->devnum);
                 het_bsb(dev->hetb);
                 cursize=het_tell(dev->hetb);
+                tapera_reset(&dev->hetb->ra);
+                tapeidx_truncate(&dev->hetb->idx,dev->hetb->cblk);
                 ftruncate( fileno(dev->hetb->fd),cursize);
                 dev->hetb->truncated=TRUE; /* SHOULD BE IN HETLIB */
             }
@@ -527,3 +561,45 @@ int             rc;                     /* Return code               */
     return 0;
 
 } /* end function bsf_het */
+
+/*-------------------------------------------------------------------*/
+/* Locate a block of an HET format file                              */
+/*                                                                   */
+/* If the block index can find the block, the file is positioned     */
+/* directly.  Otherwise the tape is spaced from the load point.      */
+/*                                                                   */
+/* If successful, return value is zero.                              */
+/* If error, return value is -1 and unitstat is set to CE+DE+UC      */
+/*-------------------------------------------------------------------*/
+int locateblk_het (DEVBLK *dev, U32 blockid, BYTE *unitstat, BYTE code)
+{
+int             rc;                     /* Return code               */
+off_t           blkpos;                 /* Offset of block           */
+
+    /* The index knows only of the blocks already written */
+    rc = het_flush (dev->hetb);
+    if (rc < 0)
+    {
+        logmsg (_("HHCTA416E %4.4X: Error writing data block "
+                "at block %8.8X in file %s: %s(%s)\n"),
+                dev->devnum, dev->hetb->cblk, dev->filename,
+                het_error(rc), strerror(errno));
+        build_senseX(TAPE_BSENSE_WRITEFAIL,dev,unitstat,code);
+        return -1;
+    }
+
+    fflush (dev->hetb->fd);
+    if (tapeidx_locate (&dev->hetb->idx, fileno(dev->hetb->fd),
+                        blockid, &blkpos) < 0
+     || het_locate (dev->hetb, blockid) < 0)
+        return locateblk_virtual (dev, blockid, unitstat, code);
+
+    /* Set the position as locateblk_virtual would */
+    dev->curfilen = 1 + tapeidx_files (&dev->hetb->idx, blockid);
+    dev->nxtblkpos = 0;
+    dev->prvblkpos = -1;
+    dev->blockid = blockid;
+    dev->fenced = 0;
+    return 0;
+
+} /* end function locateblk_het */
@@ -61,7 +61,11 @@ static const char help[] =
     "  -r   rechucnk\n"
     "  -s   strict AWSTAPE specification (chunksize=4096,no compression)\n"
     "  -v   verbose information\n"
-    "  -z   use ZLIB compression\n";
+    "  -z   use ZLIB compression\n"
+#if defined( HET_ZSTD )
+    "  -Z   use ZSTD compression\n"
+#endif /* defined( HET_ZSTD ) */
+    ;
 
 /*
 || Prints usage information
@@ -84,30 +88,41 @@ yesno( int val )
 /*
 || Close tapes and cleanup
 */
-static void
+static int
 closetapes( int rc )
 {
+    int crc;
 
-    het_close( &d_hetb );
+    /*
+    || The last blocks may only be written when the output is closed
+    */
+    crc = het_close( &d_hetb );
+    if( crc < 0 && rc >= 0 )
+    {
+        printf( "Error writing destination - HETLIB rc: %d\n%s\n",
+            crc,
+            het_error( crc ) );
+        rc = crc;
+    }
     het_close( &s_hetb );
 
     if( dorename )
     {
         if( rc >= 0 )
         {
-            rc = rename( o_dname, o_sname );
+            crc = rename( o_dname, o_sname );
         }
         else
         {
-            rc = remove( o_dname );
+            crc = remove( o_dname );
         }
-        if( rc == -1 )
+        if( crc == -1 )
         {
             printf( "Error renaming files - manual checks required\n");
         }
     }
 
-    return;
+    return( rc );
 }
 
 /*
@@ -219,6 +234,18 @@ opentapes( void )
         goto exit;
     }
 
+    /*
+    || Compress the output on the other processors while reading the input
+    */
+    if( o_compress )
+    {
+        rc = het_cntl( d_hetb, HETCNTL_SET | HETCNTL_THREADS, HETAUTO_THREADS );
+        if( rc < 0 )
+        {
+            goto exit;
+        }
+    }
+
     if( o_verbose )
     {
         printf( "Source             : %s\n",
@@ -233,6 +260,8 @@ opentapes( void )
             het_cntl( d_hetb, HETCNTL_METHOD, 0 ) );
         printf( "Compression level  : %d\n",
             het_cntl( d_hetb, HETCNTL_LEVEL, 0 ) );
+        printf( "Compression threads: %d\n",
+            het_cntl( d_hetb, HETCNTL_THREADS, 0 ) );
     }
 
 exit:
@@ -267,11 +296,14 @@ main( int argc, char *argv[] )
 
     while( TRUE )
     {
+        rc = getopt( argc, argv,
 #if defined( HET_BZIP2 )
-        rc = getopt( argc, argv, "bc:dhrsvz0123456789" );
-#else
-        rc = getopt( argc, argv, "c:dhrsvz0123456789" );
+                     "b"
 #endif /* defined( HET_BZIP2 ) */
+#if defined( HET_ZSTD )
+                     "Z"
+#endif /* defined( HET_ZSTD ) */
+                     "c:dhrsvz0123456789" );
         if( rc == -1 )
         {
             break;
@@ -328,6 +360,14 @@ main( int argc, char *argv[] )
                 o_decompress = TRUE;
             break;
 
+#if defined( HET_ZSTD )
+            case 'Z':                               /* Use ZSTD compression */
+                o_method = HETMETH_ZSTD;
+                o_compress = TRUE;
+                o_decompress = TRUE;
+            break;
+#endif /* defined( HET_ZSTD ) */
+
             default:                                /* Print usage          */
                 usage( argv[ 0 ] );
                 exit( 1 );
@@ -374,7 +414,11 @@ main( int argc, char *argv[] )
         exit( 1 );
     }
 
-    closetapes( rc );
+    rc = closetapes( rc );
+    if( rc < 0 )
+    {
+        exit( 1 );
+    }
 
     return 0;
 }
@@ -84,6 +84,16 @@
 #define IMPL_DLL_IMPORT DLL_EXPORT
 #endif
 
+#ifndef _TRACEBIN_C_
+#ifndef _HENGINE_DLL_
+#define TBIN_DLL_IMPORT DLL_IMPORT
+#else   /* _HENGINE_DLL_ */
+#define TBIN_DLL_IMPORT extern
+#endif  /* _HENGINE_DLL_ */
+#else
+#define TBIN_DLL_IMPORT DLL_EXPORT
+#endif
+
 #ifndef _CCKDUTIL_C_
 #ifndef _HDASD_DLL_
 #define CCDU_DLL_IMPORT DLL_IMPORT
@@ -176,7 +186,7 @@ void build_config (char *fname);
 void release_config ();
 CONF_DLL_IMPORT DEVBLK *find_device_by_devnum (U16 lcss, U16 devnum);
 DEVBLK *find_device_by_subchan (U32 ioid);
-REGS *devregs(DEVBLK *dev);
+CONF_DLL_IMPORT REGS *devregs(DEVBLK *dev);
 DEVBLK *get_devblk (U16 lcss, U16 devnum);
 void ret_devblk (DEVBLK *dev);
 int  attach_device (U16 lcss, U16 devnum, const char *devtype, int addargc,
@@ -397,6 +407,38 @@ void alter_display_virt (char *opnd, REGS *regs);
 void disasm_stor(REGS *regs, char *opnd);
 int drop_privileges(int capa);
 
+/* Functions in module profile.c */
+#if defined(OPTION_INSTRUCTION_PROFILE)
+void profile_init (void);
+U64  profile_clock (void);
+int  profile_tick (void);
+void profile_sample (int cpuad, U64 addr, BYTE *inst);
+void profile_time (BYTE *inst, U64 nsecs);
+int  profile_opcodes (PROFSTAT **stat);
+int  profile_addrs (PROFSTAT **stat);
+U64  profile_samples (int *active, int *interval, U64 *lost);
+U64  profile_pct (PROFSTAT *stat, int pct);
+int  profile_cmd (int argc, char *argv[], char *cmdline);
+#endif /*defined(OPTION_INSTRUCTION_PROFILE)*/
+
+/* Functions in module tracebin.c */
+#if defined(OPTION_TRACEBIN)
+void tracebin_init (void);
+void tracebin_cpu (TBREC *rec);
+void tracebin_io (DEVBLK *dev, TBREC *rec);
+int  tracebin_cmd (int argc, char *argv[], char *cmdline);
+#endif /*defined(OPTION_TRACEBIN)*/
+TBIN_DLL_IMPORT int tracebin_disasm (BYTE *inst, char *buf);
+
+/* Functions in module metrics.c */
+char *metrics_format (int json);
+int   metrics_cmd (int argc, char *argv[], char *cmdline);
+
+/* Functions in module simdops.c */
+extern SIMDOPS simdops;
+void simd_init (void);
+int  simd_cmd (int argc, char *argv[], char *cmdline);
+
 /* Functions in module sr.c */
 int suspend_cmd(int argc, char *argv[],char *cmdline);
 int resume_cmd(int argc, char *argv[],char *cmdline);
@@ -451,42 +451,67 @@ typedef U64  (*z900_trace_br_func) (int amode,  U64 ia, REGS *regs);
 /* Macros to queue/dequeue a device on the I/O interrupt queue...    */
 /*-------------------------------------------------------------------*/
 
-/* NOTE: sysblk.iointqlk ALWAYS needed to examine sysblk.iointq */
+/* NOTE: The lock of the queue for the device's interruption subclass
+   is ALWAYS needed to update or to search that queue.  The queue heads
+   may be tested for NULL without it.  The subclass of a device cannot
+   change while it has an interrupt queued (MSCH gives cc 2).         */
+
+#define IOINTQ_ISC(_dev)        (((_dev)->pmcw.flag4 & PMCW4_ISC) >> 3)
+#define IOINTQ(_dev)            (&sysblk.iointq[IOINTQ_ISC((_dev))])
+
+#define OBTAIN_IOINTQLOCK(_dev)  obtain_lock(&IOINTQ((_dev))->lock)
+#define RELEASE_IOINTQLOCK(_dev) release_lock(&IOINTQ((_dev))->lock)
 
 #define QUEUE_IO_INTERRUPT(_io) \
  do { \
-   obtain_lock(&sysblk.iointqlk); \
+   OBTAIN_IOINTQLOCK((_io)->dev); \
    QUEUE_IO_INTERRUPT_QLOCKED((_io)); \
-   release_lock(&sysblk.iointqlk); \
+   RELEASE_IOINTQLOCK((_io)->dev); \
  } while (0)
 
 #define QUEUE_IO_INTERRUPT_QLOCKED(_io) \
  do { \
    IOINT *prev; \
-   for (prev = (IOINT *)&sysblk.iointq; prev->next != NULL; prev = prev->next) \
-     if (prev->next == (_io) || prev->next->priority > (_io)->dev->priority) \
+   for (prev = (IOINT *)&IOINTQ((_io)->dev)->head; prev->next != NULL; prev = prev->next) \
+     if (prev->next == (_io)) \
        break; \
    if (prev->next != (_io)) { \
-     (_io)->next = prev->next; \
+     (_io)->next = NULL; \
      prev->next = (_io); \
      (_io)->priority = (_io)->dev->priority; \
+     IOINTQ((_io)->dev)->queued++; \
    } \
         if ((_io)->pending)     (_io)->dev->pending     = 1; \
    else if ((_io)->pcipending)  (_io)->dev->pcipending  = 1; \
    else if ((_io)->attnpending) (_io)->dev->attnpending = 1; \
  } while (0)
 
+/* Number of interrupts ever queued, read without the queue locks.
+   A CPU which presents interrupts without the interrupt lock uses it
+   to see whether an interrupt was queued meanwhile, as the device
+   thread then only wakes up the CPUs which were already waiting.
+   Each count is a fullword, which is stored only under its queue
+   lock and so is always read whole, and is compared for equality
+   only, so that it may wrap.                                        */
+#define IOINT_QUEUED(_n) \
+ do { \
+   int isc; \
+   (_n) = 0; \
+   for (isc = 0; isc < IOINTQ_MAX; isc++) \
+     (_n) += *(volatile U32 *)&sysblk.iointq[isc].queued; \
+ } while (0)
+
 #define DEQUEUE_IO_INTERRUPT(_io) \
  do { \
-   obtain_lock(&sysblk.iointqlk); \
+   OBTAIN_IOINTQLOCK((_io)->dev); \
    DEQUEUE_IO_INTERRUPT_QLOCKED((_io)); \
-   release_lock(&sysblk.iointqlk); \
+   RELEASE_IOINTQLOCK((_io)->dev); \
  } while (0)
 
 #define DEQUEUE_IO_INTERRUPT_QLOCKED(_io) \
  do { \
    IOINT *prev; \
-   for (prev = (IOINT *)&sysblk.iointq; prev->next != NULL; prev = prev->next) \
+   for (prev = (IOINT *)&IOINTQ((_io)->dev)->head; prev->next != NULL; prev = prev->next) \
      if (prev->next == (_io)) { \
        prev->next = (_io)->next; \
             if ((_io)->pending)     (_io)->dev->pending     = 0; \
@@ -496,20 +521,17 @@ typedef U64  (*z900_trace_br_func) (int amode,  U64 ia, REGS *regs);
      } \
  } while (0)
 
-/* NOTE: sysblk.iointqlk needed to examine sysblk.iointq,
-   sysblk.intlock (which MUST be held before calling these
-   macros) needed in order to set/reset IC_IOPENDING flag */
+/* NOTE: sysblk.intlock (which MUST be held before calling these
+   macros) needed in order to set/reset IC_IOPENDING flag.  The
+   queue heads are tested without obtaining the queue locks.     */
 
 #define UPDATE_IC_IOPENDING() \
  do { \
-   obtain_lock(&sysblk.iointqlk); \
-   UPDATE_IC_IOPENDING_QLOCKED(); \
-   release_lock(&sysblk.iointqlk); \
- } while (0)
-
-#define UPDATE_IC_IOPENDING_QLOCKED() \
- do { \
-   if (sysblk.iointq == NULL) \
+   int isc; \
+   for (isc = 0; isc < IOINTQ_MAX; isc++) \
+     if (sysblk.iointq[isc].head != NULL) \
+       break; \
+   if (isc >= IOINTQ_MAX) \
      OFF_IC_IOPENDING; \
    else { \
      ON_IC_IOPENDING; \
@@ -517,6 +539,9 @@ typedef U64  (*z900_trace_br_func) (int amode,  U64 ia, REGS *regs);
    } \
  } while (0)
 
+#define UPDATE_IC_IOPENDING_QLOCKED() \
+   UPDATE_IC_IOPENDING()
+
 /*-------------------------------------------------------------------*/
 /* Handy utility macro for channel.c                                 */
 /*-------------------------------------------------------------------*/
@@ -528,6 +553,73 @@ typedef U64  (*z900_trace_br_func) (int amode,  U64 ia, REGS *regs);
     || IS_CCW_NOP((_dev)->code) \
   )
 
+/*-------------------------------------------------------------------*/
+/* Change map for incremental suspend (sr.c)                         */
+/*-------------------------------------------------------------------*/
+
+/* NOTE: sysblk.chgmap has one byte per 4K frame and exists only
+   while changes are tracked for incremental suspend or migration.
+   CHGMAP_DIRTY marks a frame that the next suspend must write.
+   Each suspend, and each migration round, moves the change bits
+   that are on into CHGMAP_SAVED and resets them, so that any later
+   store turns them on again.  The guest must still see them, so
+   instructions that return a change bit include STORKEY_SAVEDC or
+   STORKEY_SAVEDC4K, and instructions that replace one must first
+   use STORKEY_CHGSAVE.                                           */
+
+#define CHGMAP_DIRTY    0x01            /* Frame must be written     */
+#define CHGMAP_SAVED    0x02            /* Change bit reset for the
+                                           first key unit, 0x04 for
+                                           the second 2K unit        */
+
+#define STORKEY_CHGUNIT(_addr, _regs) \
+  ((U64)(&STORAGE_KEY((_addr), (_regs)) - sysblk.storkeys))
+
+#define STORKEY_CHGPAGE(_addr, _regs) \
+  ((STORKEY_CHGUNIT((_addr), (_regs)) * STORAGE_KEY_UNITSIZE) >> 12)
+
+#define CHGMAP_SAVEDBIT(_unit) \
+  (CHGMAP_SAVED << ((_unit) & (4096 / STORAGE_KEY_UNITSIZE - 1)))
+
+/* Reset change bit of the key unit of _addr */
+#define STORKEY_SAVEDC(_addr, _regs) \
+  ((sysblk.chgmap \
+    && (sysblk.chgmap[STORKEY_CHGPAGE((_addr), (_regs))] \
+        & CHGMAP_SAVEDBIT(STORKEY_CHGUNIT((_addr), (_regs))))) \
+   ? STORKEY_CHANGE : 0)
+
+/* Reset change bit of either key unit of the frame of _addr */
+#define STORKEY_SAVEDC4K(_addr, _regs) \
+  ((sysblk.chgmap \
+    && (sysblk.chgmap[STORKEY_CHGPAGE((_addr), (_regs))] \
+        & (CHGMAP_SAVED | (CHGMAP_SAVED << 1)))) \
+   ? STORKEY_CHANGE : 0)
+
+/* The frame must be written if a change bit is on, and reset
+   change bits are put back before the guest replaces them     */
+#define STORKEY_CHGSAVE(_addr, _regs) \
+ do { \
+   if (sysblk.chgmap) { \
+     U64 _pg = STORKEY_CHGPAGE((_addr), (_regs)); \
+     BYTE *_k1 = sysblk.storkeys + (_pg << 12) / STORAGE_KEY_UNITSIZE; \
+     BYTE *_k2 = sysblk.storkeys \
+               + ((_pg << 12) + 4095) / STORAGE_KEY_UNITSIZE; \
+     if ((*_k1 | *_k2) & STORKEY_CHANGE) \
+       sysblk.chgmap[_pg] |= CHGMAP_DIRTY; \
+     if (sysblk.chgmap[_pg] & CHGMAP_SAVED) \
+       *_k1 |= STORKEY_CHANGE; \
+     if (sysblk.chgmap[_pg] & (CHGMAP_SAVED << 1)) \
+       *_k2 |= STORKEY_CHANGE; \
+     sysblk.chgmap[_pg] &= CHGMAP_DIRTY; \
+   } \
+ } while (0)
+
+#define STORKEY_CHGSET(_addr, _regs) \
+ do { \
+   if (sysblk.chgmap) \
+     sysblk.chgmap[STORKEY_CHGPAGE((_addr), (_regs))] |= CHGMAP_DIRTY; \
+ } while (0)
+
 /*-------------------------------------------------------------------*/
 /* Hercules Dynamic Loader macro to call optional function override  */
 /*-------------------------------------------------------------------*/
@@ -563,13 +655,17 @@ typedef U64  (*z900_trace_br_func) (int amode,  U64 ia, REGS *regs);
 /*-------------------------------------------------------------------*/
 /* sleep for as long as we like                                      */
 /*-------------------------------------------------------------------*/
+/* (sleep() rounds the time left when it is interrupted, so that     */
+/* frequent signals, e.g. glibc's for every setresuid by a starting  */
+/* device thread, cut the pause short; nanosleep() returns it exact) */
 
 #define SLEEP(_n) \
  do { \
-   unsigned int rc = (_n); \
-   while (rc) \
-     if ((rc = sleep (rc))) \
-       sched_yield(); \
+   struct timespec ts; \
+   ts.tv_sec = (_n); \
+   ts.tv_nsec = 0; \
+   while (nanosleep (&ts, &ts) < 0 && errno == EINTR) \
+     sched_yield(); \
  } while (0)
 
 /*-------------------------------------------------------------------*/
@@ -16,8 +16,35 @@
 
 #include "hercules.h"
 
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
 DLL_EXPORT HOST_INFO  hostinfo;     /* Host system information       */
 
+#define NODE_PATH   "/sys/devices/system/node/node%d"
+
+/*-------------------------------------------------------------------*/
+/* Return the number of host NUMA nodes                              */
+/*-------------------------------------------------------------------*/
+static int host_nodes ()
+{
+#if defined(__linux__)
+char    path[64];                       /* Node directory path       */
+int     n;                              /* Number of nodes           */
+
+    for (n = 0; n < 1024; n++)
+    {
+        snprintf (path, sizeof(path), NODE_PATH, n);
+        if (access (path, F_OK) != 0)
+            break;
+    }
+    return n > 0 ? n : 1;
+#else
+    return 1;
+#endif
+}
+
 /*-------------------------------------------------------------------*/
 /* Initialize host system information                                */
 /*-------------------------------------------------------------------*/
@@ -41,6 +68,7 @@ DLL_EXPORT void init_hostinfo ( HOST_INFO* pHostInfo )
   #else
     pHostInfo->num_procs = 1;
   #endif
+    pHostInfo->num_nodes = host_nodes();
 #else
     if ( !pHostInfo ) pHostInfo = &hostinfo;
     strlcpy( pHostInfo->sysname,  "(unknown)", sizeof(pHostInfo->sysname)  );
@@ -54,6 +82,7 @@ DLL_EXPORT void init_hostinfo ( HOST_INFO* pHostInfo )
   #else
     pHostInfo->num_procs = 1;
   #endif
+    pHostInfo->num_nodes = 1;
 #endif
 }
 
@@ -110,3 +139,79 @@ DLL_EXPORT void display_hostinfo ( HOST_INFO* pHostInfo, FILE *f, int httpfd )
         hprintf(httpfd,"%s\n",host_info_str);
     }
 }
+
+/*-------------------------------------------------------------------*/
+/* Restrict the calling thread to the processors of a NUMA node      */
+/*      Returns 0 if successful, otherwise -1                        */
+/*-------------------------------------------------------------------*/
+DLL_EXPORT int bind_host_node ( int node )
+{
+#if defined(HAVE_SCHED_SETAFFINITY) && defined(CPU_SET)
+char    path[80];                       /* Node cpulist path         */
+char    buf[1024];                      /* Node cpulist              */
+char   *p;                              /* -> Next range             */
+FILE   *f;                              /* cpulist file              */
+int     lo, hi;                         /* Processor range           */
+int     n = 0;                          /* Number of processors      */
+cpu_set_t set;                          /* Processor set             */
+
+    snprintf (path, sizeof(path), NODE_PATH "/cpulist", node);
+    if ((f = fopen (path, "r")) == NULL)
+        return -1;
+    p = fgets (buf, sizeof(buf), f);
+    fclose (f);
+    if (p == NULL)
+        return -1;
+
+    /* The list is ranges separated by commas, e.g. "0-7,16-23" */
+    CPU_ZERO (&set);
+    while (sscanf (p, "%d", &lo) == 1)
+    {
+        hi = lo;
+        while (isdigit(*p)) p++;
+        if (*p == '-')
+        {
+            if (sscanf (++p, "%d", &hi) != 1)
+                break;
+            while (isdigit(*p)) p++;
+        }
+        for ( ; lo <= hi && lo < CPU_SETSIZE; lo++, n++)
+            CPU_SET (lo, &set);
+        if (*p != ',')
+            break;
+        p++;
+    }
+    if (n == 0)
+        return -1;
+
+    return sched_setaffinity (0, sizeof(set), &set);
+#else
+    UNREFERENCED(node);
+    return -1;
+#endif
+}
+
+/*-------------------------------------------------------------------*/
+/* Place a range of untouched storage on a set of NUMA nodes         */
+/*      `nodes' is a mask of node numbers; the pages are either      */
+/*      interleaved over the nodes or bound to them when touched.    */
+/*      Returns 0 if successful, otherwise -1                        */
+/*-------------------------------------------------------------------*/
+DLL_EXPORT int bind_host_memory ( void *addr, size_t len,
+                                  int interleave, U64 nodes )
+{
+#if defined(__linux__) && defined(SYS_mbind)
+unsigned long mask = (unsigned long)nodes; /* Node mask for mbind    */
+
+    /* MPOL_BIND (2) and MPOL_INTERLEAVE (3) from <numaif.h>; the
+       kernel reads maxnode - 1 bits of the mask */
+    return (int)syscall (SYS_mbind, addr, len, interleave ? 3 : 2,
+                         &mask, (unsigned long)(sizeof(mask) * 8 + 1), 0);
+#else
+    UNREFERENCED(addr);
+    UNREFERENCED(len);
+    UNREFERENCED(interleave);
+    UNREFERENCED(nodes);
+    return -1;
+#endif
+}
@@ -33,6 +33,7 @@ typedef struct HOST_INFO
     char  machine[20];
     int   trycritsec_avail;             /* 1=TryEnterCriticalSection */
     int   num_procs;                    /* #of processors            */
+    int   num_nodes;                    /* #of NUMA nodes            */
 } HOST_INFO;
 
 HI_DLL_IMPORT HOST_INFO     hostinfo;
@@ -41,6 +42,9 @@ HI_DLL_IMPORT void  display_hostinfo ( HOST_INFO* pHostInfo, FILE *f,int httpfd
 HI_DLL_IMPORT char* get_hostinfo_str ( HOST_INFO* pHostInfo,
                                        char*      pszHostInfoStrBuff,
                                        size_t     nHostInfoStrBuffSiz );
+HI_DLL_IMPORT int   bind_host_node   ( int node );
+HI_DLL_IMPORT int   bind_host_memory ( void *addr, size_t len,
+                                       int interleave, U64 nodes );
 
 /* Hercules Host Information structure  (similar to utsname struct)  */
 
@@ -178,6 +178,11 @@
 #undef  OPTION_SCSI_ERASE_GAP           /* (NOT supported!)          */
 #endif
 #undef  OPTION_FBA_BLKDEVICE            /* (no FBA BLKDEVICE support)*/
+#undef  OPTION_DASD_MMAP                /* (no mmap dasd support)    */
+#undef  OPTION_TRACEBIN                 /* (no mmap trace support)   */
+#undef  OPTION_SR_MMAP                  /* (no mmap resume support)  */
+#undef  OPTION_SR_MIGRATE               /* (no live migration)       */
+#undef  OPTION_HUGE_STORAGE             /* (no huge page storage)    */
 
 #define MAX_DEVICE_THREADS          0   /* (0 == unlimited)          */
 #undef  MIXEDCASE_FILENAMES_ARE_UNIQUE  /* ("Foo" same as "fOo"!!)   */
@@ -313,6 +318,9 @@
 #undef  OPTION_SCSI_ERASE_TAPE          /* (NOT supported)           */
 #undef  OPTION_SCSI_ERASE_GAP           /* (NOT supported)           */
 #define OPTION_FBA_BLKDEVICE            /* FBA block device support  */
+#if defined( HAVE_LINUX_IO_URING_H )
+  #define OPTION_IO_URING               /* io_uring dasd file i/o    */
+#endif
 
 #define MAX_DEVICE_THREADS          0   /* (0 == unlimited)          */
 #define MIXEDCASE_FILENAMES_ARE_UNIQUE  /* ("Foo" and "fOo" unique)  */
@@ -3574,6 +3574,171 @@ int lsid_cmd(int argc, char *argv[], char *cmdline)
 }
 
 
+/*-------------------------------------------------------------------*/
+/* tlbsize command - set second level TLB size and associativity     */
+/*-------------------------------------------------------------------*/
+int tlbsize_cmd(int argc, char *argv[], char *cmdline)
+{
+int     entries;                        /* Number of TLB entries     */
+int     ways = 1;                       /* Number of entries per set */
+char    c;                              /* Character work area       */
+
+    UNREFERENCED(cmdline);
+
+    if (argc < 2)
+    {
+        if (sysblk.tlbsets)
+            logmsg(_("HHCCF117I Second level TLB %d entries, %d way\n"),
+              sysblk.tlbsets * sysblk.tlbways, sysblk.tlbways);
+        else
+            logmsg(_("HHCCF117I No second level TLB\n"));
+        return 0;
+    }
+
+    /* Parse number of entries and optional associativity */
+    if (argc > 3
+     || sscanf(argv[1], "%d%c", &entries, &c) != 1
+     || (argc > 2 && sscanf(argv[2], "%d%c", &ways, &c) != 1)
+     || (ways != 1 && ways != 2 && ways != TLB_MAXWAYS)
+     || (entries != 0
+      && (entries < TLBN * ways
+       || entries > TLB_MAXSETS * ways
+       || (entries & (entries - 1)))))
+    {
+        logmsg(_("HHCCF116E Invalid TLB size: entries must be 0 or a "
+                 "power of 2 from %d to %d times the number of ways "
+                 "(1, 2 or %d)\n"),
+          TLBN, TLB_MAXSETS, TLB_MAXWAYS);
+        return -1;
+    }
+
+    sysblk.tlbsets = entries / ways;
+    sysblk.tlbways = ways;
+
+    return 0;
+}
+
+
+#if defined(OPTION_HUGE_STORAGE)
+/*-------------------------------------------------------------------*/
+/* hugepages command - set the page size backing storage             */
+/*-------------------------------------------------------------------*/
+int hugepages_cmd(int argc, char *argv[], char *cmdline)
+{
+    UNREFERENCED(cmdline);
+
+    if (argc < 2)
+    {
+        if (sysblk.hugepages == HUGEPAGES_THP)
+            logmsg(_("HHCCF119I Storage pages are transparent huge pages\n"));
+        else if (sysblk.hugepages)
+            logmsg(_("HHCCF119I Storage pages are %dK huge pages\n"),
+              sysblk.hugepages);
+        else
+            logmsg(_("HHCCF119I Storage pages are host pages\n"));
+        return 0;
+    }
+
+    if (argc == 2 && !strcasecmp(argv[1], "no"))
+        sysblk.hugepages = 0;
+    else if (argc == 2 && !strcasecmp(argv[1], "thp"))
+        sysblk.hugepages = HUGEPAGES_THP;
+    else if (argc == 2 && (!strcasecmp(argv[1], "yes")
+                        || !strcasecmp(argv[1], "2m")))
+        sysblk.hugepages = 2048;
+    else if (argc == 2 && !strcasecmp(argv[1], "1g"))
+        sysblk.hugepages = 1024*1024;
+    else
+    {
+        logmsg(_("HHCCF118E Invalid hugepages operand: "
+                 "specify NO, YES, 2M, 1G or THP\n"));
+        return -1;
+    }
+
+    return 0;
+}
+
+
+/*-------------------------------------------------------------------*/
+/* numa command - set the NUMA placement of storage and CPUs         */
+/*-------------------------------------------------------------------*/
+int numa_cmd(int argc, char *argv[], char *cmdline)
+{
+U64     nodes = 0;                      /* Node mask                 */
+int     policy;                         /* NUMA policy               */
+int     lo, hi;                         /* Node range                */
+char   *p;                              /* -> Next node range        */
+char    buf[256];                       /* Node list                 */
+
+    UNREFERENCED(cmdline);
+
+    if (argc < 2)
+    {
+        for (p = buf, *p = '\0', lo = 0; lo < 64; lo++)
+            if (sysblk.numanodes & (1ULL << lo))
+                p += snprintf(p, sizeof(buf) - (p - buf), "%s%d",
+                              p == buf ? "" : ",", lo);
+        logmsg(_("HHCCF121I NUMA policy %s%s%s\n"),
+          sysblk.numa == NUMA_INTERLEAVE ? "INTERLEAVE" :
+          sysblk.numa == NUMA_BIND       ? "BIND" : "NONE",
+          sysblk.numa == NUMA_NONE ? "" : " nodes ",
+          sysblk.numa == NUMA_NONE ? "" : buf);
+        return 0;
+    }
+
+    if (!strcasecmp(argv[1], "none") || !strcasecmp(argv[1], "no"))
+        policy = NUMA_NONE;
+    else if (!strcasecmp(argv[1], "interleave"))
+        policy = NUMA_INTERLEAVE;
+    else if (!strcasecmp(argv[1], "bind"))
+        policy = NUMA_BIND;
+    else
+        policy = -1;
+
+    /* The node list is ranges separated by commas, e.g. "0-1,3" */
+    if (policy != NUMA_NONE && argc == 3)
+    {
+        for (p = argv[2]; sscanf(p, "%d", &lo) == 1; p++)
+        {
+            hi = lo;
+            while (isdigit(*p)) p++;
+            if (*p == '-')
+            {
+                if (sscanf(++p, "%d", &hi) != 1)
+                    break;
+                while (isdigit(*p)) p++;
+            }
+            if (lo < 0 || hi < lo || hi > 63)
+                break;
+            for ( ; lo <= hi; lo++)
+                nodes |= 1ULL << lo;
+            if (*p != ',')
+                break;
+        }
+        if (*p)
+            policy = -1;
+    }
+    else if (policy == NUMA_INTERLEAVE && argc == 2)
+        nodes = hostinfo.num_nodes >= 64 ? ~0ULL
+              : (1ULL << hostinfo.num_nodes) - 1;
+    else if (policy != NUMA_NONE || argc != 2)
+        policy = -1;
+
+    if (policy < 0 || (policy != NUMA_NONE && !nodes))
+    {
+        logmsg(_("HHCCF120E Invalid numa operand: specify NONE, "
+                 "INTERLEAVE [nodes] or BIND nodes\n"));
+        return -1;
+    }
+
+    sysblk.numa = policy;
+    sysblk.numanodes = nodes;
+
+    return 0;
+}
+#endif /*defined(OPTION_HUGE_STORAGE)*/
+
+
 /*-------------------------------------------------------------------*/
 /* codepage xxxxxxxx command                                         */
 /*-------------------------------------------------------------------*/
@@ -4696,6 +4861,7 @@ int devtmax_cmd(int argc, char *argv[], char *cmdline)
 #else /* !defined(OPTION_FISHIO) */
 
     TID tid;
+    int i, devtwait;
 
     UNREFERENCED(cmdline);
 
@@ -4712,25 +4878,26 @@ int devtmax_cmd(int argc, char *argv[], char *cmdline)
             return -1;
         }
 
-        /* Create a new device thread if the I/O queue is not NULL
+        /* Create a new device thread if an I/O queue is not empty
            and more threads can be created */
-
-        /* the IOQ lock is obtained in order to write to sysblk.devtwait */
         obtain_lock(&sysblk.ioqlock);
-        if (sysblk.ioq && (!sysblk.devtmax || sysblk.devtnbr < sysblk.devtmax))
+        if (ioq_pending() && (!sysblk.devtmax || sysblk.devtnbr < sysblk.devtmax))
             create_thread(&tid, DETACHED, device_thread, NULL, "idle device thread");
+        release_lock(&sysblk.ioqlock);
 
         /* Wakeup threads in case they need to terminate */
-        sysblk.devtwait=0;
-        broadcast_condition (&sysblk.ioqcond);
-        release_lock(&sysblk.ioqlock);
+        ioq_wakeup();
     }
     else
+    {
+        for (i = devtwait = 0; i < sysblk.numioq; i++)
+            devtwait += sysblk.devioq[i].waiting;
         logmsg( _("HHCPN078E Max device threads %d current %d most %d "
             "waiting %d total I/Os queued %d\n"),
             sysblk.devtmax, sysblk.devtnbr, sysblk.devthwm,
-            sysblk.devtwait, sysblk.devtunavail
+            devtwait, sysblk.devtunavail
         );
+    }
 
 #endif /* defined(OPTION_FISHIO) */
 
@@ -4739,6 +4906,60 @@ int devtmax_cmd(int argc, char *argv[], char *cmdline)
 
 
 
+#if !defined(OPTION_FISHIO)
+/*-------------------------------------------------------------------*/
+/* ioq command - display device I/O queue statistics                 */
+/*-------------------------------------------------------------------*/
+int ioq_cmd(int argc, char *argv[], char *cmdline)
+{
+    int     i;                          /* Queue index               */
+    int     reset = 0;                  /* 1=Reset device counts     */
+    DEVIOQ *q;                          /* -> Device I/O queue       */
+    DEVBLK *dev;                        /* -> Device block           */
+
+    UNREFERENCED(cmdline);
+
+    if (argc > 1)
+    {
+        if (argc > 2 || strcasecmp(argv[1], "reset") != 0)
+        {
+            logmsg( _("HHCPN225E Invalid ioq option: %s\n"), argv[argc-1] );
+            return -1;
+        }
+        reset = 1;
+    }
+
+    if (!reset)
+        for (i = 0; i < sysblk.numioq; i++)
+        {
+            q = &sysblk.devioq[i];
+            logmsg( _("HHCPN226I I/O queue %d: queued %" I64_FMT "u "
+                      "taken by other queues %" I64_FMT "u "
+                      "waiting threads %d node %d\n"),
+                    i, q->queued, q->stolen, q->waiting, q->node );
+        }
+
+    for (dev = sysblk.firstdev; dev != NULL; dev = dev->nextdev)
+    {
+        if (!dev->allocated || dev->ioqcount == 0)
+            continue;
+        if (reset)
+        {
+            dev->ioqwait = dev->ioqwaitmax = 0;
+            dev->ioqcount = 0;
+            continue;
+        }
+        logmsg( _("HHCPN227I %d:%4.4X I/Os %u queue wait "
+                  "avg %" I64_FMT "u max %" I64_FMT "u usecs\n"),
+                SSID_TO_LCSS(dev->ssid), dev->devnum, dev->ioqcount,
+                dev->ioqwait / dev->ioqcount, dev->ioqwaitmax );
+    }
+
+    return 0;
+}
+#endif /* !defined(OPTION_FISHIO) */
+
+
 /*-------------------------------------------------------------------*/
 /* sf commands - shadow file add/remove/set/compress/display         */
 /*-------------------------------------------------------------------*/
@@ -5130,7 +5351,8 @@ REGS *regs;
     if (argc < 3 || '*' == *(loadaddr = argv[2]))
     {
         for (aaddr = 0; aaddr < sysblk.mainsize &&
-            !(STORAGE_KEY(aaddr, regs) & STORKEY_CHANGE); aaddr += 4096)
+            !((STORAGE_KEY(aaddr, regs) | STORKEY_SAVEDC(aaddr, regs))
+              & STORKEY_CHANGE); aaddr += 4096)
         {
             ;   /* (nop) */
         }
@@ -5152,12 +5374,14 @@ REGS *regs;
     if (argc < 4 || '*' == *(loadaddr = argv[3]))
     {
         for (aaddr2 = sysblk.mainsize - 4096; aaddr2 > 0 &&
-            !(STORAGE_KEY(aaddr2, regs) & STORKEY_CHANGE); aaddr2 -= 4096)
+            !((STORAGE_KEY(aaddr2, regs) | STORKEY_SAVEDC(aaddr2, regs))
+              & STORKEY_CHANGE); aaddr2 -= 4096)
         {
             ;   /* (nop) */
         }
 
-        if ( STORAGE_KEY(aaddr2, regs) & STORKEY_CHANGE )
+        if ( (STORAGE_KEY(aaddr2, regs) | STORKEY_SAVEDC(aaddr2, regs))
+             & STORKEY_CHANGE )
             aaddr2 |= 0xFFF;
         else
         {
@@ -5391,6 +5615,7 @@ int loadtext_cmd(int argc, char *argv[], char *cmdline)
             n   = buf[5]*65536 + buf[6]*256 + buf[7];
             len = buf[11];
             memcpy(regs->mainstor + aaddr + n, &buf[16], len);
+            BBC_INVALIDATE(regs->mainstor + aaddr + n, len);
             STORAGE_KEY(aaddr + n, regs) |= (STORKEY_REF | STORKEY_CHANGE);
             STORAGE_KEY(aaddr + n + len - 1, regs) |= (STORKEY_REF | STORKEY_CHANGE);
         }
@@ -5658,25 +5883,37 @@ int ipending_cmd(int argc, char *argv[], char *cmdline)
 
     logmsg( _("          I/O interrupt queue: ") );
 
-    if (!sysblk.iointq)
+    for (i = 0; i < IOINTQ_MAX; i++)
+        if (sysblk.iointq[i].head)
+            break;
+    if (i >= IOINTQ_MAX)
         logmsg( _("(NULL)") );
     logmsg("\n");
 
-    for (io = sysblk.iointq; io; io = io->next)
-        logmsg
-        (
-            _("          DEV %d:%4.4X,%s%s%s%s, pri %d\n")
+    for (i = 0; i < IOINTQ_MAX; i++)
+    {
+        if (!sysblk.iointq[i].head && !sysblk.iointq[i].presented)
+            continue;
 
-            ,SSID_TO_LCSS(io->dev->ssid)
-            ,io->dev->devnum
+        logmsg( _("          ISC %d: %" I64_FMT "u presented\n"),
+                i, sysblk.iointq[i].presented );
 
-            ,io->pending      ? " normal"  : ""
-            ,io->pcipending   ? " PCI"     : ""
-            ,io->attnpending  ? " ATTN"    : ""
-            ,!IOPENDING(io)   ? " unknown" : ""
+        for (io = sysblk.iointq[i].head; io; io = io->next)
+            logmsg
+            (
+                _("          DEV %d:%4.4X,%s%s%s%s, pri %d\n")
 
-            ,io->priority
-        );
+                ,SSID_TO_LCSS(io->dev->ssid)
+                ,io->dev->devnum
+
+                ,io->pending      ? " normal"  : ""
+                ,io->pcipending   ? " PCI"     : ""
+                ,io->attnpending  ? " ATTN"    : ""
+                ,!IOPENDING(io)   ? " unknown" : ""
+
+                ,io->priority
+            );
+    }
 
     return 0;
 }
@@ -6881,6 +7118,74 @@ DLL_EXPORT int aia_cmd(int argc, char *argv[], char *cmdline)
 }
 
 
+#if defined(OPTION_BLOCK_CACHE)
+/*-------------------------------------------------------------------*/
+/* blkcache - enable, disable or display basic block cache           */
+/*-------------------------------------------------------------------*/
+int blkcache_cmd(int argc, char *argv[], char *cmdline)
+{
+    int     i;                          /* CPU index                 */
+    REGS   *regs;
+
+    UNREFERENCED(cmdline);
+
+    if (argc > 1)
+    {
+        if (strcasecmp(argv[1], "on") == 0)
+            sysblk.blkcache = 1;
+        else if (strcasecmp(argv[1], "off") == 0)
+            sysblk.blkcache = 0;
+        else
+        {
+            logmsg( _("HHCPN220E Invalid blkcache option: %s\n"), argv[1] );
+            return -1;
+        }
+        return 0;
+    }
+
+    logmsg( _("HHCPN221I Basic block cache is %s\n"),
+            sysblk.blkcache ? "on" : "off" );
+
+    for (i = 0; i < MAX_CPU; i++)
+    {
+        obtain_lock (&sysblk.cpulock[i]);
+        regs = sysblk.regs[i];
+        if (IS_CPU_ONLINE(i) && regs->bbc)
+            logmsg( _("HHCPN222I CPU%4.4X: hits %" I64_FMT "u "
+                      "built %" I64_FMT "u not cached %" I64_FMT "u\n"),
+                    regs->cpuad, regs->bbc->hits,
+                    regs->bbc->misses, regs->bbc->interp );
+        release_lock (&sysblk.cpulock[i]);
+    }
+
+    return 0;
+}
+#endif /*defined(OPTION_BLOCK_CACHE)*/
+
+
+/*-------------------------------------------------------------------*/
+/* Display TLB statistics                                            */
+/*-------------------------------------------------------------------*/
+/* Only translations which miss the accelerated lookup are counted,  */
+/* so the misses are shown per 1000 instructions, not as a hit rate. */
+/*-------------------------------------------------------------------*/
+static void tlb_stats (REGS *regs, char *pfx)
+{
+U64     instcount;                      /* Instructions executed     */
+
+    instcount = regs->prevcount + regs->instcount;
+    logmsg( _("HHCPN224I %sCPU%4.4X TLB misses %" I64_FMT "u "
+              "(%.3f per 1000 instructions)\n"),
+            pfx, regs->cpuad, regs->tlb.misses,
+            instcount ? (double)regs->tlb.misses * 1000 / instcount : 0.0 );
+    if (regs->tlb.l2.entries)
+        logmsg( _("HHCPN224I %sCPU%4.4X second level TLB %d entries "
+                  "%d way: hits %" I64_FMT "u\n"),
+                pfx, regs->cpuad, regs->tlb.l2.entries, regs->tlb.l2.ways,
+                regs->tlb.l2hits );
+}
+
+
 /*-------------------------------------------------------------------*/
 /* tlb - display tlb table                                           */
 /*-------------------------------------------------------------------*/
@@ -6900,12 +7205,21 @@ int tlb_cmd(int argc, char *argv[], char *cmdline)
     int     bytemask;                   /* Byte mask                 */
     U64     pagemask;                   /* Page mask                 */
     int     matches = 0;                /* Number aeID matches       */
+    int     stats = 0;                  /* 1=Display statistics only */
     REGS   *regs;
 
-    UNREFERENCED(argc);
-    UNREFERENCED(argv);
     UNREFERENCED(cmdline);
 
+    if (argc > 1)
+    {
+        if (argc > 2 || strcasecmp(argv[1], "stats") != 0)
+        {
+            logmsg( _("HHCPN223E Invalid tlb option: %s\n"), argv[argc-1]);
+            return -1;
+        }
+        stats = 1;
+    }
+
     obtain_lock(&sysblk.cpulock[sysblk.pcpu]);
 
     if (!IS_CPU_ONLINE(sysblk.pcpu))
@@ -6915,6 +7229,16 @@ int tlb_cmd(int argc, char *argv[], char *cmdline)
         return 0;
     }
     regs = sysblk.regs[sysblk.pcpu];
+
+    if (stats)
+    {
+        tlb_stats (regs, "");
+        if (regs->sie_active)
+            tlb_stats (regs->guestregs, "SIE: ");
+        release_lock(&sysblk.cpulock[sysblk.pcpu]);
+        return 0;
+    }
+
     shift = regs->arch_mode == ARCH_370 ? 11 : 12;
     bytemask = regs->arch_mode == ARCH_370 ? 0x1FFFFF : 0x3FFFFF;
     pagemask = regs->arch_mode == ARCH_370 ? 0x00E00000 :
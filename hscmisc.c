@@ -655,7 +655,7 @@ static REGS  *copy_regs (REGS *regs)
 
     /* Perform partial copy and clear the TLB */
     memcpy(newregs, regs, sysblk.regs_copy_len);
-    memset(&newregs->tlb.vaddr, 0, TLBN * sizeof(DW));
+    tlb_init(newregs, 0, 1);
     newregs->tlbID = 1;
     newregs->ghostregs = 1;
     newregs->hostregs = newregs;
@@ -668,7 +668,7 @@ static REGS  *copy_regs (REGS *regs)
     {
         hostregs = newregs + 1;
         memcpy(hostregs, regs->hostregs, sysblk.regs_copy_len);
-        memset(&hostregs->tlb.vaddr, 0, TLBN * sizeof(DW));
+        tlb_init(hostregs, 0, 1);
         hostregs->tlbID = 1;
         hostregs->ghostregs = 1;
         hostregs->hostregs = hostregs;
@@ -760,7 +760,8 @@ BYTE    c;                              /* Character work area       */
         return n;
     }
 
-    n += sprintf (buf+n, "K:%2.2X=", STORAGE_KEY(aaddr, regs));
+    n += sprintf (buf+n, "K:%2.2X=",
+                  STORAGE_KEY(aaddr, regs) | STORKEY_SAVEDC(aaddr, regs));
 
     memset (hbuf, SPACE, sizeof(hbuf));
     memset (cbuf, SPACE, sizeof(cbuf));
@@ -948,6 +949,7 @@ char    buf[100];                       /* Message buffer            */
             aaddr = APPLY_PREFIXING (aaddr, regs->PX);
             regs->mainstor[aaddr] = newval[i];
             STORAGE_KEY(aaddr, regs) |= (STORKEY_REF | STORKEY_CHANGE);
+            BBC_INVALIDATE(regs->mainstor + aaddr, 1);
         } /* end for(i) */
 
     }
@@ -1028,6 +1030,7 @@ char    buf[100];                       /* Message buffer            */
             aaddr = APPLY_PREFIXING (raddr, regs->PX);
             regs->mainstor[aaddr] = newval[i];
             STORAGE_KEY(aaddr, regs) |= (STORKEY_REF | STORKEY_CHANGE);
+            BBC_INVALIDATE(regs->mainstor + aaddr, 1);
         } /* end for(i) */
     }
 
@@ -1061,91 +1064,27 @@ char    buf[100];                       /* Message buffer            */
 } /* end function alter_display_virt */
 
 
+#if defined(DISPLAY_INSTRUCTION_OPERANDS) || defined(OPTION_TRACEBIN)
 /*-------------------------------------------------------------------*/
-/* Display instruction                                               */
+/* Calculate the storage operand addresses of an instruction         */
 /*-------------------------------------------------------------------*/
-void ARCH_DEP(display_inst) (REGS *iregs, BYTE *inst)
+/* The base register numbers are returned in b1 and b2, or -1 if     */
+/* the instruction has no first or second storage operand.  For RR  */
+/* and RRE instructions with storage operands they are the general   */
+/* registers containing the operand addresses.                       */
+/*-------------------------------------------------------------------*/
+static void ARCH_DEP(inst_operands) (REGS *regs, BYTE *inst,
+                                     int *pb1, VADR *paddr1,
+                                     int *pb2, VADR *paddr2)
 {
-QWORD   qword;                          /* Doubleword work area      */
 BYTE    opcode;                         /* Instruction operation code*/
 int     ilc;                            /* Instruction length        */
-#ifdef DISPLAY_INSTRUCTION_OPERANDS
 int     b1=-1, b2=-1, x1;               /* Register numbers          */
 VADR    addr1 = 0, addr2 = 0;           /* Operand addresses         */
-#endif /*DISPLAY_INSTRUCTION_OPERANDS*/
-char    buf[256];                       /* Message buffer            */
-int     n;                              /* Number of bytes in buffer */
-REGS   *regs;                           /* Copied regs               */
-
-    if (iregs->ghostregs)
-        regs = iregs;
-    else if ((regs = copy_regs(iregs)) == NULL)
-        return;
-
-  #if defined(_FEATURE_SIE)
-    if(SIE_MODE(regs))
-        logmsg(_("SIE: "));
-  #endif /*defined(_FEATURE_SIE)*/
-
-#if 0
-#if _GEN_ARCH == 370
-    logmsg("S/370 ");
-#elif _GEN_ARCH == 390
-    logmsg("ESA/390 ");
-#else
-    logmsg("Z/Arch ");
-#endif
-#endif
-
-    /* Display the PSW */
-    memset (qword, 0x00, sizeof(qword));
-    copy_psw (regs, qword);
-    if(sysblk.cpus>1)
-    {
-        n=sprintf(buf,"CPU%4.4X:  ",regs->cpuad);
-    }
-    else
-    {
-        n=0;
-    }
-    n += sprintf (buf+n,
-                "PSW=%2.2X%2.2X%2.2X%2.2X %2.2X%2.2X%2.2X%2.2X ",
-                qword[0], qword[1], qword[2], qword[3],
-                qword[4], qword[5], qword[6], qword[7]);
-  #if defined(FEATURE_ESAME)
-        n += sprintf (buf + n,
-                "%2.2X%2.2X%2.2X%2.2X%2.2X%2.2X%2.2X%2.2X ",
-                qword[8], qword[9], qword[10], qword[11],
-                qword[12], qword[13], qword[14], qword[15]);
-  #endif /*defined(FEATURE_ESAME)*/
 
-    /* Exit if instruction is not valid */
-    if (inst == NULL)
-    {
-        logmsg (_("%sInstruction fetch error\n"), buf);
-        display_regs (regs);
-        if (!iregs->ghostregs) free(regs);
-        return;
-    }
-
-    /* Extract the opcode and determine the instruction length */
     opcode = inst[0];
     ilc = ILC(opcode);
 
-    /* Show registers associated with the instruction */
-    if (sysblk.showregsfirst)
-        display_inst_regs (regs, inst, opcode);
-
-    /* Display the instruction */
-    n += sprintf (buf+n, "INST=%2.2X%2.2X", inst[0], inst[1]);
-    if (ilc > 2) n += sprintf (buf+n, "%2.2X%2.2X", inst[2], inst[3]);
-    if (ilc > 4) n += sprintf (buf+n, "%2.2X%2.2X", inst[4], inst[5]);
-    logmsg ("%s %s", buf,(ilc<4) ? "        " : (ilc<6) ? "    " : "");
-    DISASM_INSTRUCTION(inst, buf);
-    logmsg("%s\n", buf);
-
-#ifdef DISPLAY_INSTRUCTION_OPERANDS
-
     /* Process the first storage operand */
     if (ilc > 2
         && opcode != 0x84 && opcode != 0x85
@@ -1240,6 +1179,103 @@ REGS   *regs;                           /* Copied regs               */
         b1 = 0;
     }
 
+    *pb1 = b1;
+    *paddr1 = addr1;
+    *pb2 = b2;
+    *paddr2 = addr2;
+
+} /* end function inst_operands */
+#endif /*defined(DISPLAY_INSTRUCTION_OPERANDS) || defined(OPTION_TRACEBIN)*/
+
+
+/*-------------------------------------------------------------------*/
+/* Display instruction                                               */
+/*-------------------------------------------------------------------*/
+void ARCH_DEP(display_inst) (REGS *iregs, BYTE *inst)
+{
+QWORD   qword;                          /* Doubleword work area      */
+BYTE    opcode;                         /* Instruction operation code*/
+int     ilc;                            /* Instruction length        */
+#ifdef DISPLAY_INSTRUCTION_OPERANDS
+int     b1, b2;                         /* Register numbers          */
+VADR    addr1, addr2;                   /* Operand addresses         */
+#endif /*DISPLAY_INSTRUCTION_OPERANDS*/
+char    buf[256];                       /* Message buffer            */
+int     n;                              /* Number of bytes in buffer */
+REGS   *regs;                           /* Copied regs               */
+
+    if (iregs->ghostregs)
+        regs = iregs;
+    else if ((regs = copy_regs(iregs)) == NULL)
+        return;
+
+  #if defined(_FEATURE_SIE)
+    if(SIE_MODE(regs))
+        logmsg(_("SIE: "));
+  #endif /*defined(_FEATURE_SIE)*/
+
+#if 0
+#if _GEN_ARCH == 370
+    logmsg("S/370 ");
+#elif _GEN_ARCH == 390
+    logmsg("ESA/390 ");
+#else
+    logmsg("Z/Arch ");
+#endif
+#endif
+
+    /* Display the PSW */
+    memset (qword, 0x00, sizeof(qword));
+    copy_psw (regs, qword);
+    if(sysblk.cpus>1)
+    {
+        n=sprintf(buf,"CPU%4.4X:  ",regs->cpuad);
+    }
+    else
+    {
+        n=0;
+    }
+    n += sprintf (buf+n,
+                "PSW=%2.2X%2.2X%2.2X%2.2X %2.2X%2.2X%2.2X%2.2X ",
+                qword[0], qword[1], qword[2], qword[3],
+                qword[4], qword[5], qword[6], qword[7]);
+  #if defined(FEATURE_ESAME)
+        n += sprintf (buf + n,
+                "%2.2X%2.2X%2.2X%2.2X%2.2X%2.2X%2.2X%2.2X ",
+                qword[8], qword[9], qword[10], qword[11],
+                qword[12], qword[13], qword[14], qword[15]);
+  #endif /*defined(FEATURE_ESAME)*/
+
+    /* Exit if instruction is not valid */
+    if (inst == NULL)
+    {
+        logmsg (_("%sInstruction fetch error\n"), buf);
+        display_regs (regs);
+        if (!iregs->ghostregs) free(regs);
+        return;
+    }
+
+    /* Extract the opcode and determine the instruction length */
+    opcode = inst[0];
+    ilc = ILC(opcode);
+
+    /* Show registers associated with the instruction */
+    if (sysblk.showregsfirst)
+        display_inst_regs (regs, inst, opcode);
+
+    /* Display the instruction */
+    n += sprintf (buf+n, "INST=%2.2X%2.2X", inst[0], inst[1]);
+    if (ilc > 2) n += sprintf (buf+n, "%2.2X%2.2X", inst[2], inst[3]);
+    if (ilc > 4) n += sprintf (buf+n, "%2.2X%2.2X", inst[4], inst[5]);
+    logmsg ("%s %s", buf,(ilc<4) ? "        " : (ilc<6) ? "    " : "");
+    DISASM_INSTRUCTION(inst, buf);
+    logmsg("%s\n", buf);
+
+#ifdef DISPLAY_INSTRUCTION_OPERANDS
+
+    /* Calculate the storage operand addresses */
+    ARCH_DEP(inst_operands) (regs, inst, &b1, &addr1, &b2, &addr2);
+
     /* Display storage at first storage operand location */
     if (b1 >= 0)
     {
@@ -1296,6 +1332,62 @@ REGS   *regs;                           /* Copied regs               */
 } /* end function display_inst */
 
 
+#if defined(OPTION_TRACEBIN)
+/*-------------------------------------------------------------------*/
+/* Record instruction in the binary trace                            */
+/*-------------------------------------------------------------------*/
+void ARCH_DEP(tracebin_inst) (REGS *regs, BYTE *inst)
+{
+TBREC   rec;                            /* Trace record              */
+int     b1, b2;                         /* Register numbers          */
+VADR    addr1, addr2;                   /* Operand addresses         */
+
+    memset (&rec, 0, sizeof(rec));
+    rec.type = TBREC_INST;
+#if __GEN_ARCH == 370
+    rec.arch = TBREC_370;
+#elif __GEN_ARCH == 390
+    rec.arch = TBREC_390;
+#else
+    rec.arch = TBREC_900;
+#endif
+    rec.cpuad = regs->cpuad;
+  #if defined(_FEATURE_SIE)
+    if (SIE_MODE(regs))
+    {
+        rec.flags |= TBREC_SIE;
+        rec.cpuad = regs->hostregs->cpuad;
+    }
+  #endif /*defined(_FEATURE_SIE)*/
+
+    ARCH_DEP(store_psw) (regs, rec.u.inst.psw);
+
+    if (inst)
+    {
+        rec.len = ILC(inst[0]);
+        memcpy (rec.u.inst.inst, inst, rec.len);
+
+        ARCH_DEP(inst_operands) (regs, inst, &b1, &addr1, &b2, &addr2);
+        if (b1 >= 0)
+        {
+            rec.flags |= TBREC_OP1;
+            rec.u.inst.op1 = addr1;
+        }
+        if (b2 >= 0)
+        {
+            rec.flags |= TBREC_OP2;
+            rec.u.inst.op2 = addr2;
+        }
+        if (REAL_MODE(&regs->psw))
+            rec.flags |= TBREC_REAL;
+    }
+
+    tracebin_cpu (&rec);
+
+} /* end function tracebin_inst */
+#endif /*defined(OPTION_TRACEBIN)*/
+
+
 #if !defined(_GEN_ARCH)
 
 #if defined(_ARCHMODE2)
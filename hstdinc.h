@@ -156,6 +156,9 @@
 #ifdef HAVE_DIRENT_H
   #include <dirent.h>
 #endif
+#if defined(HAVE_LZ4_H) && defined(CCKD_LZ4)
+  #include <lz4.h>
+#endif
 #ifdef OPTION_DYNAMIC_LOAD
   #ifdef HDL_USE_LIBTOOL
     #include <ltdl.h>
@@ -203,6 +206,9 @@
 #ifdef HAVE_ZLIB_H
   #include <zlib.h>
 #endif
+#if defined(HAVE_ZSTD_H) && (defined(CCKD_ZSTD) || defined(HET_ZSTD))
+  #include <zstd.h>
+#endif
 #ifdef HAVE_SYS_CAPABILITY_H
   #include <sys/capability.h>
 #endif
@@ -108,6 +108,9 @@ struct REGS {                           /* Processor registers       */
         U32     siosrate;               /* IOs per second            */
         U64     siototal;               /* Total SIO/SSCH count      */
         int     cpupct;                 /* Percent CPU busy          */
+#if defined(OPTION_INSTRUCTION_PROFILE)
+        BYTE    profsample;             /* 1=Profile next instruction*/
+#endif
         U64     waittod;                /* Time of day last wait (us)*/
         U64     waittime;               /* Wait time (us) in interval*/
         DAT     dat;                    /* Fields for DAT use        */
@@ -357,6 +360,18 @@ struct REGS {                           /* Processor registers       */
         unsigned int tlbID;             /* Validation identifier     */
         TLB     tlb;                    /* Translation lookaside buf */
 
+     /* Compression call dictionary cache                            */
+
+        CMPSCCACHE *cmpsc;              /* -> CMPSC dictionary cache
+                                           or NULL until first used  */
+
+#if defined(OPTION_BLOCK_CACHE)
+     /* Basic block cache                                            */
+
+        BBCACHE *bbc;                   /* -> Basic block cache or
+                                           NULL if not enabled       */
+#endif /*defined(OPTION_BLOCK_CACHE)*/
+
 };
 
 /*-------------------------------------------------------------------*/
@@ -373,6 +388,145 @@ struct VFREGS {                          /* Vector Facility Registers*/
 };
 #endif /*defined(_FEATURE_VECTOR_FACILITY)*/
 
+/*-------------------------------------------------------------------*/
+/* CMPSC dictionary cache                                            */
+/*                                                                   */
+/* Each CPU keeps host copies of the dictionaries its compression    */
+/* calls used most recently, with the dead ends and expanded index   */
+/* symbols derived from them.  The entries are private to cmpsc.c.   */
+/*-------------------------------------------------------------------*/
+#define CMPSC_DICTS     4               /* Dictionaries per CPU      */
+
+struct CMPSCCACHE {                     /* CMPSC dictionary cache    */
+        U64     uses;                   /* Lookups, for replacement  */
+        void   *dict[CMPSC_DICTS];      /* -> Cached dictionaries    */
+};
+
+#if defined(OPTION_BLOCK_CACHE)
+/*-------------------------------------------------------------------*/
+/* Basic block cache                                                 */
+/*                                                                   */
+/* Each CPU may keep a cache of the instruction sequences it has     */
+/* recently executed.  A block is keyed by the mainstor address of   */
+/* its first instruction (ie. by real page and offset) and holds,    */
+/* for each instruction, the function which finally executes it and  */
+/* the operand fields decoded from the instruction text.             */
+/*                                                                   */
+/* Blocks are not revalidated against storage when they are used.    */
+/* Instead a BBFRAME for each 4K frame of main storage records which */
+/* 64 byte lines of the frame blocks were built from.  No TLB entry  */
+/* of any CPU gives write access to such a frame, so every CPU store */
+/* into it goes through logical_to_main_l and bbc_store, and stores  */
+/* which do not use the TLB (channel data transfer, interruption     */
+/* codes, panel alter) call bbc_invalidate.  A store into a line     */
+/* holding code increments the frame generation, which discards all  */
+/* blocks built from the frame.  A frame which is stored into too    */
+/* often is no longer cached.  Lines are only added to a frame with  */
+/* the other CPUs stopped at an instruction boundary.                */
+/*-------------------------------------------------------------------*/
+#define BBC_MAXINST     16              /* Max instructions per block*/
+#define BBC_BLOCKS      256             /* Number of blocks per CPU  */
+#define BBC_HASH(_ip)   ((((uintptr_t)(_ip)) >> 1) & (BBC_BLOCKS-1))
+#define BBC_FRAMESHIFT  12              /* 4K frames                 */
+#define BBC_LINESHIFT   6               /* 64 byte lines             */
+#define BBC_MAXHITS     8               /* Stores into a frame before
+                                           it is no longer cached    */
+#define BBC_LINES(_off, _last)          /* Lines holding the bytes
+                                           from _off to _last        */ \
+        ((~(U64)0 >> (63 - ((_last) >> BBC_LINESHIFT))) \
+       & (~(U64)0 << ((_off) >> BBC_LINESHIFT)))
+
+struct BBINST {                         /* Cached instruction        */
+        void  (ATTR_REGPARM(2) *func)   /* Instruction function      */
+                (BYTE inst[], REGS *regs);
+        BYTE   *inst;                   /* Argument for func: the
+                                           instruction text, or this
+                                           BBINST for the functions
+                                           using the decoded fields  */
+        BYTE   *next;                   /* Mainstor address of the
+                                           next instruction          */
+        S32     i2;                     /* Displacement or immediate */
+        BYTE    r1;                     /* R1 or M1 field            */
+        BYTE    r2;                     /* R2 or X2 field            */
+        BYTE    b2;                     /* B2 field                  */
+};
+
+struct BBLOCK {                         /* Cached basic block        */
+        BYTE   *ip;                     /* Mainstor address of first
+                                           instruction or NULL       */
+        BBFRAME *frame;                 /* -> Frame holding block    */
+        U32     gen;                    /* Frame generation at build */
+        U32     cgen;                   /* Cache generation at build */
+        int     count;                  /* Number of instructions    */
+        BBINST  inst[BBC_MAXINST];      /* Decoded instructions      */
+};
+
+struct BBCACHE {                        /* Basic block cache         */
+        U32     gen;                    /* Generation, incremented
+                                           when the TLB is purged    */
+        U64     hits;                   /* Block found in cache      */
+        U64     misses;                 /* Block built               */
+        U64     interp;                 /* Block not cached          */
+        BBLOCK  blk[BBC_BLOCKS];        /* Cached blocks             */
+};
+
+struct BBFRAME {                        /* Main storage frame        */
+        U64     code;                   /* Lines blocks were built
+                                           from                      */
+        U32     gen;                    /* Generation                */
+        U32     hits;                   /* Stores which invalidated
+                                           blocks or could otherwise
+                                           have used the TLB         */
+};
+#endif /*defined(OPTION_BLOCK_CACHE)*/
+
+#if !defined(OPTION_FISHIO)
+/*-------------------------------------------------------------------*/
+/* Device I/O queue                                                  */
+/*                                                                   */
+/* Start subchannel queues the device on the queue selected by its   */
+/* first channel path.  Each queue has its own lock and its own idle */
+/* device threads, so starts on different channel paths do not       */
+/* contend with each other.  A device thread whose queue is empty    */
+/* takes work from the other queues before it waits.                 */
+/*-------------------------------------------------------------------*/
+#define DEVIOQ_MAX      16              /* Maximum number of queues  */
+
+struct DEVIOQ {                         /* Device I/O queue          */
+        LOCK    lock;                   /* Queue lock                */
+        COND    cond;                   /* Work queued condition     */
+        DEVBLK *ioq;                    /* -> First queued device    */
+        int     waiting;                /* Device threads waiting    */
+        int     searching;              /* Device threads looking at
+                                           the other queues          */
+        int     recheck;                /* 1=Work queued elsewhere
+                                           while searching           */
+        int     node;                   /* Host NUMA node or -1      */
+        U64     queued;                 /* Number of I/Os queued     */
+        U64     stolen;                 /* I/Os run by a device thread
+                                           of another queue          */
+};
+#endif // !defined(OPTION_FISHIO)
+
+/*-------------------------------------------------------------------*/
+/* I/O interrupt queue                                               */
+/*                                                                   */
+/* There is one queue for each interruption subclass.  A CPU which   */
+/* is disabled for a subclass, or finds its queue empty, passes over */
+/* it without obtaining the queue lock, so CPUs taking interrupts    */
+/* for different subclasses do not contend with each other.         */
+/*-------------------------------------------------------------------*/
+#define IOINTQ_MAX      8               /* One queue per subclass    */
+
+struct IOINTQ {                         /* I/O interrupt queue       */
+        LOCK    lock;                   /* Queue lock                */
+        IOINT  *head;                   /* -> First queued interrupt */
+        U32     queued;                 /* Interrupts queued, updated
+                                           under the queue lock and
+                                           read without it           */
+        U64     presented;              /* Interrupts presented      */
+};
+
 // #if defined(FEATURE_REGION_RELOCATE)
 /*-------------------------------------------------------------------*/
 /* Zone Parameter Block                                              */
@@ -406,6 +560,13 @@ struct SYSBLK {
         BYTE   *storkeys;               /* -> Main storage key array */
         U32     xpndsize;               /* Expanded size (4K pages)  */
         BYTE   *xpndstor;               /* -> Expanded storage       */
+        BYTE   *chgmap;                 /* -> Changed frames since
+                                              last suspend (4K frames)*/
+        char   *srbase;                 /* Last suspend file written */
+#if defined(OPTION_BLOCK_CACHE)
+        BBFRAME *bbcframe;              /* -> Block cache frame table
+                                              or NULL if never used  */
+#endif /*defined(OPTION_BLOCK_CACHE)*/
         U64     todstart;               /* Time of initialisation    */
         U64     cpuid;                  /* CPU identifier for STIDP  */
         TID     impltid;                /* Thread-id for main progr. */
@@ -420,6 +581,18 @@ struct SYSBLK {
         int     maxcpu;                 /* Max number of CPUs        */
         int     cpus;                   /* Number CPUs configured    */
         int     hicpu;                  /* Hi cpu + 1 configured     */
+        U32     tlbsets;                /* Number of TLB sets        */
+        int     tlbways;                /* Number of TLB ways        */
+#if defined(OPTION_HUGE_STORAGE)
+        int     hugepages;              /* Storage page size in K,
+                                           0=host default, -1=THP    */
+#define HUGEPAGES_THP   (-1)            /* ...transparent huge pages */
+        int     numa;                   /* Storage NUMA policy...    */
+#define NUMA_NONE       0               /* ...host default           */
+#define NUMA_INTERLEAVE 1               /* ...interleaved over nodes */
+#define NUMA_BIND       2               /* ...bound to nodes         */
+        U64     numanodes;              /* NUMA nodes for policy     */
+#endif
         int     sysepoch;               /* TOD clk epoch (1900/1960) */
         int     topology;               /* Configuration topology... */
 #define TOPOLOGY_HORIZ  0               /* ...horizontal polarization*/
@@ -465,8 +638,10 @@ struct SYSBLK {
 
         LOCK    mainlock;               /* Main storage lock         */
         LOCK    intlock;                /* Interrupt lock            */
-        LOCK    iointqlk;               /* I/O Interrupt Queue lock  */
         LOCK    sigplock;               /* Signal processor lock     */
+#if defined(OPTION_BLOCK_CACHE)
+        LOCK    bbclock;                /* Block cache frame lock    */
+#endif /*defined(OPTION_BLOCK_CACHE)*/
         ATTR    detattr;                /* Detached thread attribute */
         ATTR    joinattr;               /* Joinable thread attribute */
 #define  DETACHED  &sysblk.detattr      /* (helper macro)            */
@@ -528,12 +703,11 @@ struct SYSBLK {
 #endif  /* FAST_DEVICE_LOOKUP */
         U16     highsubchan[FEATURE_LCSS_MAX];  /* Highest subchan+1 */
         U32     chp_reset[8];           /* Channel path reset masks  */
-        IOINT  *iointq;                 /* I/O interrupt queue       */
+        IOINTQ  iointq[IOINTQ_MAX];     /* I/O interrupt queues      */
 #if !defined(OPTION_FISHIO)
-        DEVBLK *ioq;                    /* I/O queue                 */
-        LOCK    ioqlock;                /* I/O queue lock            */
-        COND    ioqcond;                /* I/O queue condition       */
-        int     devtwait;               /* Device threads waiting    */
+        DEVIOQ  devioq[DEVIOQ_MAX];     /* Device I/O queues         */
+        int     numioq;                 /* Number of I/O queues      */
+        LOCK    ioqlock;                /* Device thread count lock  */
         int     devtnbr;                /* Number of device threads  */
         int     devtmax;                /* Max device threads        */
         int     devthwm;                /* High water mark           */
@@ -556,6 +730,7 @@ struct SYSBLK {
                 sigintreq:1,            /* 1 = SIGINT request pending*/
                 insttrace:1,            /* 1 = Instruction trace     */
                 inststep:1,             /* 1 = Instruction step      */
+                tracebin:1,             /* 1 = Binary trace active   */
                 shutdown:1,             /* 1 = shutdown requested    */
                 shutfini:1,             /* 1 = shutdown complete     */
 #if defined( _MSVC_ )
@@ -569,8 +744,19 @@ struct SYSBLK {
                                              if tape already mounted */
                 legacysenseid:1,        /* ena/disa senseid on       */
                                         /*   legacy devices          */
+#if defined(OPTION_BLOCK_CACHE)
+                blkcache:1,             /* 1 = Basic block cache     */
+#endif
 #if defined(OPTION_IPLPARM)
                 haveiplparm:1,          /* IPL PARM a la VM          */
+#endif
+#if defined(OPTION_SR_MMAP)
+                srmapped:1,             /* 1 = mainstor maps resume
+                                               file pages            */
+#endif
+#if defined(OPTION_HUGE_STORAGE)
+                mainmmap:1,             /* 1 = mainstor is mmap'd
+                                               huge or NUMA pages    */
 #endif
                 logoptnotime:1;         /* 1 = don't timestamp log   */
         U32     ints_state;             /* Common Interrupts Status  */
@@ -727,6 +913,114 @@ struct IOINT {                          /* I/O interrupt queue entry */
                 attnpending:1;          /* 1=ATTN interrupt          */
 };
 
+#if defined(OPTION_INSTRUCTION_PROFILE)
+/*-------------------------------------------------------------------*/
+/* Instruction profile entry, by opcode or by instruction address    */
+/*-------------------------------------------------------------------*/
+#define PROF_HISTMAX    24              /* Host time histogram size  */
+
+struct PROFSTAT {                       /* Instruction profile entry */
+        U64     samples;                /* Number of samples         */
+        U64     timed;                  /* Number of timed samples   */
+        U64     nsecs;                  /* Host nanoseconds taken by
+                                           the timed samples         */
+        U64     addr;                   /* Instruction address       */
+        U32     hist[PROF_HISTMAX];     /* Timed samples taking less
+                                           than 2**(n+1) nanoseconds */
+        U16     cpuad;                  /* CPU address               */
+        BYTE    inst[6];                /* Instruction               */
+        char    mnemonic[8];            /* Instruction mnemonic      */
+};
+#endif /*defined(OPTION_INSTRUCTION_PROFILE)*/
+
+/*-------------------------------------------------------------------*/
+/* Binary trace ring file                                            */
+/*-------------------------------------------------------------------*/
+/* A ring file is a TBHDR padded to TBHDR_SIZE bytes followed by     */
+/* `nrecs' record slots.  The n'th record written since the trace    */
+/* was started (counting from zero) is in slot n % nrecs.  All       */
+/* fields are in host byte order, which `endian' identifies.         */
+/*-------------------------------------------------------------------*/
+#define TBHDR_ID        "HERCTB01"      /* File identifier           */
+#define TBHDR_SIZE      4096            /* Offset of first record    */
+#define TBHDR_ENDIAN    0x01020304      /* Byte order check          */
+#define TBHDR_IO        0xFFFF          /* Ring number of I/O ring   */
+
+struct TBHDR {                          /* Binary trace file header  */
+        char    id[8];                  /* TBHDR_ID                  */
+        U32     endian;                 /* TBHDR_ENDIAN              */
+        U32     recsize;                /* Record size               */
+        U32     hdrsize;                /* Offset of first record    */
+        U32     nrecs;                  /* Number of record slots    */
+        U64     next;                   /* Number of records written */
+        U64     start;                  /* Host time of trace start  */
+        U16     ring;                   /* CPU address or TBHDR_IO   */
+        BYTE    resv[6];                /* Reserved                  */
+};
+
+struct TBREC {                          /* Binary trace record       */
+        BYTE    type;                   /* Record type               */
+#define TBREC_INST      1               /* Instruction               */
+#define TBREC_CCW       2               /* CCW to be executed        */
+#define TBREC_CCWEND    3               /* CCW ending status         */
+#define TBREC_CSW       4               /* Channel status word       */
+#define TBREC_SCSW      5               /* Subchannel status word    */
+        BYTE    arch;                   /* Architecture mode         */
+#define TBREC_370       0               /* S/370                     */
+#define TBREC_390       1               /* ESA/390                   */
+#define TBREC_900       2               /* z/Arch                    */
+        BYTE    flags;                  /* Flags                     */
+#define TBREC_OP1       0x01            /* op1 address is valid      */
+#define TBREC_OP2       0x02            /* op2 address is valid      */
+#define TBREC_REAL      0x04            /* Operands are real         */
+#define TBREC_DATA      0x08            /* Data bytes are valid      */
+#define TBREC_SENSE     0x10            /* Sense bytes are valid     */
+#define TBREC_SIE       0x80            /* SIE guest instruction     */
+        BYTE    len;                    /* Instruction length        */
+        U16     cpuad;                  /* CPU address, or LCSS for
+                                           an I/O record             */
+        U16     devnum;                 /* Device number             */
+        U64     time;                   /* Host time (nanoseconds
+                                           since the epoch)          */
+        union {
+            struct {
+                BYTE    psw[16];        /* PSW (8 bytes if not
+                                           z/Arch)                   */
+                BYTE    inst[6];        /* Instruction               */
+                BYTE    resv[2];        /* Reserved                  */
+                U64     op1;            /* First operand address     */
+                U64     op2;            /* Second operand address    */
+            } inst;
+            struct {
+                BYTE    word[16];       /* CCW, CSW or SCSW, or the
+                                           sense bytes at CCW end    */
+                U32     addr;           /* CCW data address          */
+                U16     count;          /* Residual count            */
+                BYTE    unitstat;       /* Unit status               */
+                BYTE    chanstat;       /* Channel status            */
+                BYTE    data[16];       /* Data at CCW data address  */
+            } io;
+        } u;
+        BYTE    resv[8];                /* Reserved                  */
+};
+
+/*-------------------------------------------------------------------*/
+/* Storage instruction kernels                                       */
+/*-------------------------------------------------------------------*/
+struct SIMDOPS {                        /* Selected kernels          */
+        int     level;                  /* Vector instruction level  */
+        int   (*xc)  (BYTE *dest, BYTE *src, int len);
+        int   (*nc)  (BYTE *dest, BYTE *src, int len);
+        int   (*oc)  (BYTE *dest, BYTE *src, int len);
+                                        /* Returns 1 if any result
+                                           byte is non-zero          */
+        void  (*tr)  (BYTE *dest, int len, BYTE *tab);
+        int   (*trt) (BYTE *src, int len, BYTE *tab);
+                                        /* Returns index of first byte
+                                           with a non-zero function
+                                           byte, or len              */
+};
+
 /*-------------------------------------------------------------------*/
 /* SCSI support threads request structures...   (i.e. work items)    */
 /*-------------------------------------------------------------------*/
@@ -822,6 +1116,11 @@ struct DEVBLK {                         /* Device configuration block*/
         TID     tid;                    /* Thread-id executing CCW   */
         int     priority;               /* I/O q scehduling priority */
         DEVBLK *nextioq;                /* -> next device in I/O q   */
+        DEVIOQ *devioq;                 /* -> I/O q device was put on*/
+        U64     ioqtime;                /* Time queued (usecs)       */
+        U64     ioqwait;                /* Total I/O q wait (usecs)  */
+        U64     ioqwaitmax;             /* Longest I/O q wait (usecs)*/
+        U32     ioqcount;               /* Number of I/Os queued     */
         IOINT   ioint;                  /* Normal i/o interrupt
                                                queue entry           */
         IOINT   pciioint;               /* PCI i/o interrupt
@@ -899,6 +1198,8 @@ struct DEVBLK {                         /* Device configuration block*/
                 ckdkeytrace:1,          /* 1=Log CKD_KEY_TRACE       */
 #endif /*OPTION_CKD_KEY_TRACING*/
                 syncio:2,               /* 1=Synchronous I/Os allowed*/
+                iouring:1,              /* 1=File i/o via io_uring   */
+                dasdmmap:1,             /* 1=Image files are mapped  */
                 shared:1,               /* 1=Device is shareable     */
                 console:1,              /* 1=Console device          */
                 connected:1,            /* 1=Console client connected*/
@@ -937,6 +1238,14 @@ struct DEVBLK {                         /* Device configuration block*/
         U64     syncios;                /* Number synchronous I/Os   */
         U64     asyncios;               /* Number asynchronous I/Os  */
 
+        /*  I/O statistics, updated by the thread executing the
+            channel program and read without serialization           */
+
+        U64     excps;                  /* Channel programs started  */
+        U64     ccws;                   /* CCWs executed             */
+        U64     iobytes;                /* Bytes transferred         */
+        U64     unitchecks;             /* Unit checks presented     */
+
         /*  Device dependent data (generic)                          */
         void    *dev_data;
 
@@ -962,6 +1271,14 @@ struct DEVBLK {                         /* Device configuration block*/
         int     rmtcomps;               /* Supported compressions    */
         int     rmtpurgen;              /* Remote purge count        */
         FWORD  *rmtpurge;               /* Remote purge list         */
+        int     rmtnext;                /* Next sequential track     */
+        int     rmtpend;                /* Pipelined requests        */
+        int     rmtpx;                  /* First pipelined request   */
+        int     rmtunsent;              /* Pipelined writes to resend*/
+        unsigned int                    /* Pipelined write flags     */
+                rmtresend:1,            /* 1=Resending writes        */
+                rmtwerr:1;              /* 1=Pipelined write failed  */
+        SHRD_PEND rmtpq[SHARED_MAX_PEND]; /* Pipelined request queue */
 
 #ifdef OPTION_SHARED_DEVICES
         /*  Fields for device sharing                                */
@@ -1084,6 +1401,8 @@ struct DEVBLK {                         /* Device configuration block*/
         int     currline;               /* curr line number          */
         int     destline;               /* destination  line number  */
 
+        SPOOLOUT spool;                 /* Printer/punch output ring */
+
         /*  Device dependent fields for tapedev                      */
 
         void   *omadesc;                /* -> OMA descriptor array   */
@@ -1101,6 +1420,8 @@ struct DEVBLK {                         /* Device configuration block*/
         U16     tapssdlen;              /* #of bytes of data prepared
                                            for Read Subsystem Data   */
         HETB   *hetb;                   /* HET control block         */
+        TAPEIDX tapeidx;                /* AWS block index           */
+        TAPERA  tapera;                 /* AWS read-ahead            */
 
         struct                          /* HET device parms          */
         {
@@ -1113,6 +1434,7 @@ struct DEVBLK {                         /* Device configuration block*/
           u_int deonirq:1;              /* DE on IRQ on tape motion  */
                                         /* MVS 3.8j workaround       */
           u_int logical_readonly:1;     /* Tape is forced READ ONLY  */
+          u_int idxfile:1;              /* Keep block index file     */
           U16   chksize;                /* Chunk size                */
           off_t maxsize;                /* Maximum allowed TAPE file
                                            size                      */
@@ -1209,6 +1531,8 @@ struct DEVBLK {                         /* Device configuration block*/
 
         char   *dasdsfn;                /* Shadow file name          */
         char   *dasdsfx;                /* Pointer to suffix char    */
+        BYTE   *dasdmap[CKD_MAXFILES];  /* -> Mapped image files     */
+        off_t   dasdmapsz[CKD_MAXFILES];/* Mapped image file sizes   */
 
 
         /*  Device dependent fields for fbadasd                      */
@@ -1397,7 +1721,15 @@ struct CCKDDASD_DEVHDR {                /* Compress device header    */
 #define CCKD_COMPRESS_NONE     0x00
 #define CCKD_COMPRESS_ZLIB     0x01
 #define CCKD_COMPRESS_BZIP2    0x02
-#define CCKD_COMPRESS_MASK     0x03
+#define CCKD_COMPRESS_LZ4      0x04
+#define CCKD_COMPRESS_ZSTD     0x08
+#define CCKD_COMPRESS_MASK     0x0f
+
+/* Compression names indexed by (byte 0 & CCKD_COMPRESS_MASK)        */
+#define CCKD_COMPRESS_NAMES    { "none", "zlib", "bzip2", "?",      \
+                                 "lz4",  "?",    "?",     "?",      \
+                                 "zstd", "?",    "?",     "?",      \
+                                 "?",    "?",    "?",     "?"     }
 
 #define CCKD_STRESS_MINLEN     4096
 #if defined(HAVE_LIBZ)
@@ -1467,7 +1799,7 @@ typedef  char         CCKD_TRACE[128];  /* Trace table entry         */
 #define CCKD_MAX_READAHEADS    16       /* Max readahead trks        */
 #define CCKD_MAX_RA_SIZE       16       /* Readahead queue size      */
 #define CCKD_MAX_RA            9        /* Max readahead threads     */
-#define CCKD_MAX_WRITER        9        /* Max writer threads        */
+#define CCKD_MAX_WRITER        32       /* Max writer threads        */
 #define CCKD_MAX_GCOL          1        /* Max garbage collectors    */
 #define CCKD_MAX_TRACE         200000   /* Max nbr trace entries     */
 #define CCKD_MAX_FREEPEND      4        /* Max free pending cycles   */
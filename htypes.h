@@ -187,7 +187,18 @@ typedef struct REGS      REGS;      // CPU register context
 typedef struct VFREGS    VFREGS;    // Vector Facility Registers
 typedef struct ZPBLK     ZPBLK;     // Zone Parameter Block
 typedef struct DEVBLK    DEVBLK;    // Device configuration block
-typedef struct IOINT     IOINT;     // I/O interrupt queue
+typedef struct IOINT     IOINT;     // I/O interrupt queue entry
+typedef struct IOINTQ    IOINTQ;    // I/O interrupt queue
+typedef struct PROFSTAT  PROFSTAT;  // Instruction profile entry
+typedef struct TBHDR     TBHDR;     // Binary trace file header
+typedef struct TBREC     TBREC;     // Binary trace record
+typedef struct SIMDOPS   SIMDOPS;   // Storage instruction kernels
+typedef struct DEVIOQ    DEVIOQ;    // Device I/O queue
+typedef struct CMPSCCACHE CMPSCCACHE; // CMPSC dictionary cache
+typedef struct BBINST    BBINST;    // Basic block cache instruction
+typedef struct BBLOCK    BBLOCK;    // Basic block cache entry
+typedef struct BBCACHE   BBCACHE;   // Basic block cache
+typedef struct BBFRAME   BBFRAME;   // Basic block cache frame
 
 typedef struct DEVDATA   DEVDATA;   // xxxxxxxxx
 typedef struct DEVGRP    DEVGRP;    // xxxxxxxxx
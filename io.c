@@ -728,16 +728,10 @@ RADR    pfx;                            /* Prefix                    */
 
     if( IS_IC_IOPENDING )
     {
-        /* Obtain the interrupt lock */
-        OBTAIN_INTLOCK(regs);
-
         /* Test and clear pending interrupt, set condition code */
         icode = ARCH_DEP(present_io_interrupt) (regs, &ioid, &ioparm,
                                                        &iointid, NULL);
 
-        /* Release the interrupt lock */
-        RELEASE_INTLOCK(regs);
-
         /* Store the SSID word and I/O parameter if an interrupt was pending */
         if (icode)
         {
@@ -770,6 +764,7 @@ RADR    pfx;                            /* Prefix                    */
 #if defined(FEATURE_ESAME) || defined(_FEATURE_IO_ASSIST)
                 STORE_FW(psa->iointid,iointid);
 #endif /*defined(FEATURE_ESAME)*/
+                BBC_INVALIDATE(psa, sizeof(*psa));
 
 #if defined(_FEATURE_IO_ASSIST)
                 if(icode != SIE_NO_INTERCEPT)
@@ -260,11 +260,11 @@ BYTE    chanstat;                       /* IPL device channel status */
     OBTAIN_INTLOCK(NULL);
 
     /* Clear the interrupt pending and device busy conditions */
-    obtain_lock (&sysblk.iointqlk);
+    OBTAIN_IOINTQLOCK(dev);
     DEQUEUE_IO_INTERRUPT_QLOCKED(&dev->ioint);
     DEQUEUE_IO_INTERRUPT_QLOCKED(&dev->pciioint);
     DEQUEUE_IO_INTERRUPT_QLOCKED(&dev->attnioint);
-    release_lock(&sysblk.iointqlk);
+    RELEASE_IOINTQLOCK(dev);
     dev->busy = 0;
     dev->scsw.flag2 = 0;
     dev->scsw.flag3 = 0;
@@ -611,6 +611,9 @@ void storage_clear()
     {
         memset(sysblk.mainstor,0,sysblk.mainsize);
         memset(sysblk.storkeys,0,sysblk.mainsize / STORAGE_KEY_UNITSIZE);
+        if (sysblk.chgmap)
+            memset(sysblk.chgmap,1,sysblk.mainsize >> 12);
+        BBC_INVALIDATE(sysblk.mainstor, sysblk.mainsize);
         sysblk.main_clear = 1;
     }
 }
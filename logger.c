@@ -35,6 +35,48 @@ static FILE *logger_syslog[2];          /* Syslog read/write pipe    */
 static FILE *logger_hrdcpy;             /* Hardcopy log or zero      */
 static int   logger_hrdcpyfd;           /* Hardcopt fd or -1         */
 
+static U64 volatile logger_seq;         /* Total bytes ever logged   */
+
+#if defined(OPTION_LOGGER_RING) \
+ && (!defined(ASSIST_CMPXCHG4) || !defined(ASSIST_CMPXCHG8))
+ #undef OPTION_LOGGER_RING              /* Needs real atomics        */
+#endif
+
+#if defined(OPTION_LOGGER_RING)
+/* Messages from logmsg are placed in a lock free multi-producer     */
+/* ring rather than written to the syslog pipe.  Each record is a    */
+/* 4 byte header followed by the message text padded to a fullword.  */
+/* A producer reserves space by advancing logger_ringhead, copies    */
+/* its text and then publishes the header.  A zero header means the  */
+/* record is not yet complete; the logger thread stops there and     */
+/* zeroes each record again once consumed.  The syslog pipe is still */
+/* read for anything written directly to stdout.                     */
+#define LOG_RINGSIZE    (1024*1024)     /* Must be a power of 2      */
+#define LOGREC_DATA     0x80000000      /* Record contains text      */
+#define LOGREC_PAD      0x40000000      /* Filler to end of ring     */
+#define LOGREC_LEN      0x3FFFFFFF      /* Text (or filler) length   */
+#define LOGREC_MAX      (LOG_RINGSIZE/4)/* Longer messages are split */
+
+/* The cmpxchg assists are not compiler barriers on every host, so   */
+/* the text and the header that publishes it are ordered explicitly  */
+#if defined(__GNUC__)
+ #define LOGREC_BARRIER()  __asm__ __volatile__ ("" ::: "memory")
+#elif defined(_MSVC_)
+ #define LOGREC_BARRIER()  _ReadWriteBarrier()
+#else
+ #define LOGREC_BARRIER()
+#endif
+
+static BYTE *logger_ring;               /* Message ring              */
+static U32 volatile logger_ringhead;    /* Next byte to reserve      */
+static U32 volatile logger_ringtail;    /* Next byte to consume      */
+static U32   logger_ringpart;           /* Bytes of record consumed  */
+static U32 volatile logger_ringon;      /* 1=Ring in use             */
+static U32 volatile logger_ringusers;   /* Producers using the ring  */
+static U32 volatile logger_asleep;      /* 1=Logger needs doorbell   */
+static int   logger_bellfd[2];          /* Doorbell pipe             */
+#endif /*defined(OPTION_LOGGER_RING)*/
+
 /* Find the index for a specific line number in the log,             */
 /* one being the most recent line                                    */
 /* Example:                                                          */
@@ -152,6 +194,278 @@ int bytes_returned;
 }
 
 
+/* log_seq - return the sequence number of the next byte to be       */
+/* added to the system log                                           */
+DLL_EXPORT U64 log_seq(void)
+{
+U64 seq = 0;
+
+#if defined(ASSIST_CMPXCHG8)
+    cmpxchg8(&seq, 0, (void *)&logger_seq);
+#else
+    obtain_lock(&logger_lock);
+    seq = logger_seq;
+    release_lock(&logger_lock);
+#endif
+    return seq;
+}
+
+
+/* log_read_seq - read system log by sequence number, never blocks   */
+/* parameters:                                                       */
+/*   buffer   - pointer to bufferpointer                             */
+/*              the bufferpointer will be returned                   */
+/*   seq      - sequence number of the first byte wanted, updated    */
+/*              to the next byte to be read.  Zero, or a position    */
+/*              that has already been overwritten, starts reading    */
+/*              at the oldest entry still in the log                 */
+/* returns:                                                          */
+/*   number of bytes in buffer or zero                               */
+/*                                                                   */
+/* Example:                                                          */
+/*   static U64 seq = 0;                                             */
+/*                                                                   */
+/*        while((msgcnt = log_read_seq(&msgbuf, &seq)))              */
+/*            function_to_process_log(msgbuf, msgcnt);               */
+/*                                                                   */
+DLL_EXPORT int log_read_seq(char **buffer, U64 *seq)
+{
+U64 curr, oldest;
+int idx, bytes_returned;
+
+    curr = log_seq();
+
+    /* The logger thread may be filling up to LOG_DEFSIZE bytes
+       beyond the current position, so that much is not returned */
+    oldest = curr > (U64)(logger_bufsize - LOG_DEFSIZE)
+           ? curr - (logger_bufsize - LOG_DEFSIZE) : 0;
+
+    if(*seq < oldest || *seq > curr)
+        *seq = oldest;
+
+    if(*seq == curr)
+        return 0;
+
+    idx = (int)(*seq % logger_bufsize);
+    bytes_returned = (int)(curr - *seq);
+    if(bytes_returned > logger_bufsize - idx)
+        bytes_returned = logger_bufsize - idx;
+
+    *buffer = logger_buffer + idx;
+    *seq += bytes_returned;
+
+    return bytes_returned;
+}
+
+
+#if defined(OPTION_LOGGER_RING)
+/* Ring the logger doorbell if the logger thread is waiting for it   */
+static void logger_ring_bell(void)
+{
+U32 old = 1;
+BYTE c = 0;
+
+    if(logger_asleep && !cmpxchg4(&old, 0, (void *)&logger_asleep))
+        VERIFY(write_pipe(logger_bellfd[LOG_WRITE], &c, 1) == 1);
+}
+
+
+/* Count a producer in or out of the ring                            */
+static void logger_ring_users(int n)
+{
+U32 old;
+
+    do
+        old = logger_ringusers;
+    while(cmpxchg4(&old, old + n, (void *)&logger_ringusers));
+}
+
+
+/* Place one record of at most LOGREC_MAX bytes in the ring.         */
+/* Returns nonzero if the ring was stopped while it was full.        */
+static int logger_ring_put(char *msg, U32 len)
+{
+U32 need, head, tail, off, pad, hdr;
+
+    need = sizeof(U32) + ((len + 3) & ~3);
+
+    /* Reserve space, along with filler up to the end of the ring
+       if the record would otherwise not be contiguous */
+    for(;;)
+    {
+        head = logger_ringhead;
+        tail = logger_ringtail;
+        off = head & (LOG_RINGSIZE - 1);
+        pad = off + need > LOG_RINGSIZE ? LOG_RINGSIZE - off : 0;
+
+        if(head + pad + need - tail > LOG_RINGSIZE)
+        {
+            /* Ring is full; wait for the logger to catch up unless
+               it is terminating and will not empty the ring again */
+            if(!logger_ringon)
+                return -1;
+            logger_ring_bell();
+            sched_yield();
+            continue;
+        }
+
+        if(!cmpxchg4(&head, head + pad + need, (void *)&logger_ringhead))
+            break;
+    }
+
+    if(pad)
+    {
+        hdr = 0;
+        cmpxchg4(&hdr, LOGREC_PAD | pad, logger_ring + off);
+        off = 0;
+    }
+
+    memcpy(logger_ring + off + sizeof(U32), msg, len);
+    LOGREC_BARRIER();
+
+    /* Publishing the header makes the record visible to the logger */
+    hdr = 0;
+    cmpxchg4(&hdr, LOGREC_DATA | len, logger_ring + off);
+
+    logger_ring_bell();
+    return 0;
+}
+
+
+/* Copy completed records from the ring to the log buffer.  A record */
+/* that does not fit is continued on the next call.                  */
+static int logger_ring_read(char *buffer, int space)
+{
+U32 tail = logger_ringtail;
+U32 hdr, len, size;
+int bytes_read = 0;
+BYTE *rec;
+
+    while(bytes_read < space)
+    {
+        rec = logger_ring + (tail & (LOG_RINGSIZE - 1));
+
+        hdr = 0;
+        cmpxchg4(&hdr, 0, rec);
+        if(!hdr)
+            break;
+        LOGREC_BARRIER();
+
+        len = hdr & LOGREC_LEN;
+
+        if(hdr & LOGREC_PAD)
+            size = len;
+        else
+        {
+            size = (U32)(space - bytes_read);
+            if(size > len - logger_ringpart)
+                size = len - logger_ringpart;
+            memcpy(buffer + bytes_read, rec + sizeof(U32) + logger_ringpart, size);
+            bytes_read += size;
+            logger_ringpart += size;
+            if(logger_ringpart < len)
+                break;
+            logger_ringpart = 0;
+            size = sizeof(U32) + ((len + 3) & ~3);
+        }
+
+        /* Free the record for reuse by the producers */
+        memset(rec, 0, size);
+        tail += size;
+    }
+
+    LOGREC_BARRIER();
+
+    if(tail != logger_ringtail)
+    {
+        U32 old = logger_ringtail;
+        cmpxchg4(&old, tail, (void *)&logger_ringtail);
+    }
+
+    return bytes_read;
+}
+
+
+/* Wait for the syslog pipe or the ring doorbell, or just poll them  */
+/* if block is zero.  Returns nonzero if the syslog pipe is readable */
+static int logger_select(int block)
+{
+fd_set readset;
+struct timeval tv = {0, 0};
+int maxfd, rc;
+BYTE bell[64];
+
+    FD_ZERO(&readset);
+    FD_SET(logger_syslogfd[LOG_READ], &readset);
+    FD_SET(logger_bellfd[LOG_READ], &readset);
+    maxfd = MAX(logger_syslogfd[LOG_READ], logger_bellfd[LOG_READ]);
+
+    rc = select(maxfd + 1, &readset, NULL, NULL, block ? NULL : &tv);
+    if(rc <= 0)
+        return 0;
+
+    if(FD_ISSET(logger_bellfd[LOG_READ], &readset))
+        read_pipe(logger_bellfd[LOG_READ], bell, sizeof(bell));
+
+    return FD_ISSET(logger_syslogfd[LOG_READ], &readset);
+}
+
+
+/* Sleep until a producer rings the doorbell or the syslog pipe      */
+/* becomes readable.  Returns nonzero if the syslog pipe is readable */
+static int logger_ring_wait(void)
+{
+U32 old = 0, hdr = 0;
+
+    cmpxchg4(&old, 1, (void *)&logger_asleep);
+
+    /* Recheck after setting logger_asleep so that a record published
+       in the meantime is not left waiting for the next doorbell */
+    cmpxchg4(&hdr, 0, logger_ring + (logger_ringtail & (LOG_RINGSIZE - 1)));
+    if(hdr)
+    {
+        old = 1;
+        cmpxchg4(&old, 0, (void *)&logger_asleep);
+        return 0;
+    }
+
+    return logger_select(1);
+}
+#endif /*defined(OPTION_LOGGER_RING)*/
+
+
+/* log_enqueue - add a message to the system log                     */
+/* Used by logmsg; when the logger ring is not in use the message is */
+/* written to the syslog pipe                                        */
+DLL_EXPORT void log_enqueue(char *msg, int len)
+{
+#if defined(OPTION_LOGGER_RING)
+int n;
+
+    /* The logger waits for producers counted in here before it
+       empties the ring for the last time */
+    logger_ring_users(1);
+    if(logger_ringon)
+    {
+        for( ; len > 0; msg += n, len -= n)
+        {
+            n = len > LOGREC_MAX ? LOGREC_MAX : len;
+            if(logger_ring_put(msg, n))
+                break;
+        }
+        if(len <= 0)
+        {
+            logger_ring_users(-1);
+            return;
+        }
+    }
+    logger_ring_users(-1);
+#endif /*defined(OPTION_LOGGER_RING)*/
+
+    write_pipe(logger_syslogfd[LOG_WRITE], msg, len);
+}
+
+
 static void logger_term(void *arg)
 {
     UNREFERENCED(arg);
@@ -182,6 +496,31 @@ static void logger_term(void *arg)
         detach_thread( logger_tid );
     }
 }
+/* Nonzero if the text contains an error or severe message (with an  */
+/* id of the form HHCxxnnnE or HHCxxnnnS).  These are written to the */
+/* hardcopy at once rather than with the rest of the batch, so that  */
+/* they are not lost if Hercules crashes before it catches up.       */
+static int logger_logfile_urgent( char* p, size_t n )
+{
+char* q;
+
+    while ( n >= 9 && (q = memchr( p, 'H', n - 8 )) != NULL )
+    {
+        n -= q - p;
+        p = q;
+        if (1
+            && memcmp( p, "HHC", 3 ) == 0
+            && isdigit( (unsigned char)p[5] )
+            && isdigit( (unsigned char)p[6] )
+            && isdigit( (unsigned char)p[7] )
+            && (p[8] == 'E' || p[8] == 'S')
+        )
+            return 1;
+        p++;
+        n--;
+    }
+    return 0;
+}
 static void logger_logfile_write( void* pBuff, size_t nBytes )
 {
     if ( fwrite( pBuff, nBytes, 1, logger_hrdcpy ) != 1 )
@@ -189,7 +528,7 @@ static void logger_logfile_write( void* pBuff, size_t nBytes )
         fprintf(logger_hrdcpy, _("HHCLG003E Error writing hardcopy log: %s\n"),
             strerror(errno));
     }
-    if ( sysblk.shutdown )
+    if ( sysblk.shutdown || logger_logfile_urgent( pBuff, nBytes ) )
         fflush ( logger_hrdcpy );
 }
 
@@ -219,9 +558,147 @@ static void logger_logfile_timestamp()
 #endif
 
 
+/* Write bytes_read bytes just added at logger_currmsg to the        */
+/* terminal and hardcopy, then make them available to log readers    */
+static void logger_process(int bytes_read)
+{
+    /* If Hercules is not running in daemon mode and panel
+       initialization is not yet complete, write message
+       to stderr so the user can see it on the terminal */
+    if (!sysblk.daemon_mode)
+    {
+        if (!sysblk.panel_init)
+        {
+            /* (ignore any errors; we did the best we could) */
+            fwrite( logger_buffer + logger_currmsg, bytes_read, 1, stderr );
+        }
+    }
+
+    /* Write log data to hardcopy file */
+    if (logger_hrdcpy)
+#if !defined( OPTION_TIMESTAMP_LOGFILE )
+    {
+        char* pLeft2 = logger_buffer + logger_currmsg;
+        int   nLeft2 = bytes_read;
+#if defined( OPTION_MSGCLR )
+        /* Remove "<pnl,..." color string if it exists */
+        if (1
+            && nLeft2 > 5
+            && strncasecmp( pLeft2, "<pnl", 4 ) == 0
+            && (pLeft2 = memchr( pLeft2+4, '>', nLeft2-4 )) != NULL
+        )
+        {
+            pLeft2++;
+            nLeft2 -= (pLeft2 - (logger_buffer + logger_currmsg));
+        }
+        else
+        {
+            pLeft2 = logger_buffer + logger_currmsg;
+            nLeft2 = bytes_read;
+        }
+#endif // defined( OPTION_MSGCLR )
+
+        logger_logfile_write( pLeft2, nLeft2 );
+    }
+#else // defined( OPTION_TIMESTAMP_LOGFILE )
+    {
+        /* Need to prefix each line with a timestamp. */
+
+        static int needstamp = 1;
+        char*  pLeft  = logger_buffer + logger_currmsg;
+        int    nLeft  = bytes_read;
+        char*  pRight = NULL;
+        int    nRight = 0;
+        char*  pNL    = NULL;   /* (pointer to NEWLINE character) */
+
+        if (needstamp)
+        {
+            if (!sysblk.logoptnotime) logger_logfile_timestamp();
+            needstamp = 0;
+        }
+
+        while ( (pNL = memchr( pLeft, '\n', nLeft )) != NULL )
+        {
+            pRight  = pNL + 1;
+            nRight  = nLeft - (pRight - pLeft);
+            nLeft  -= nRight;
+
+#if defined( OPTION_MSGCLR )
+            /* Remove "<pnl...>" color string if it exists */
+            {
+                char* pLeft2 = pLeft;
+                int   nLeft2 = nLeft;
+
+                if (1
+                    && nLeft > 5
+                    && strncasecmp( pLeft, "<pnl", 4 ) == 0
+                    && (pLeft2 = memchr( pLeft+4, '>', nLeft-4 )) != NULL
+                )
+                {
+                    pLeft2++;
+                    nLeft2 -= (pLeft2 - pLeft);
+                }
+                else
+                {
+                    pLeft2 = pLeft;
+                    nLeft2 = nLeft;
+                }
+
+                logger_logfile_write( pLeft2, nLeft2 );
+            }
+#else // !defined( OPTION_MSGCLR )
+
+            logger_logfile_write( pLeft, nLeft );
+
+#endif // defined( OPTION_MSGCLR )
+
+            pLeft = pRight;
+            nLeft = nRight;
+
+            if (!nLeft)
+            {
+                needstamp = 1;
+                break;
+            }
+
+            if (!sysblk.logoptnotime) logger_logfile_timestamp();
+        }
+
+        if (nLeft)
+            logger_logfile_write( pLeft, nLeft );
+    }
+#endif // !defined( OPTION_TIMESTAMP_LOGFILE )
+
+    /* Increment buffer index to next available position */
+    logger_currmsg += bytes_read;
+    if(logger_currmsg >= logger_bufsize)
+    {
+        logger_currmsg = 0;
+        logger_wrapped = 1;
+    }
+
+    /* Notify all interested parties new log data is available */
+    obtain_lock(&logger_lock);
+#if defined(ASSIST_CMPXCHG8)
+    {
+        U64 seq = logger_seq;
+        cmpxchg8(&seq, seq + bytes_read, (void *)&logger_seq);
+    }
+#else
+    logger_seq += bytes_read;
+#endif
+    broadcast_condition(&logger_cond);
+    release_lock(&logger_lock);
+}
+
+
 static void logger_thread(void *arg)
 {
 int bytes_read;
+int space;
+#if defined(OPTION_LOGGER_RING)
+U32 old;
+#endif /*defined(OPTION_LOGGER_RING)*/
 
     UNREFERENCED(arg);
 
@@ -253,6 +730,10 @@ int bytes_read;
 
     logger_active = 1;
 
+#if defined(OPTION_LOGGER_RING)
+    logger_ringon = 1;
+#endif /*defined(OPTION_LOGGER_RING)*/
+
     /* Signal initialization complete */
     signal_condition(&logger_cond);
 
@@ -264,8 +745,29 @@ int bytes_read;
 
     while(logger_active)
     {
-        bytes_read = read_pipe(logger_syslogfd[LOG_READ],logger_buffer + logger_currmsg,
-          ((logger_bufsize - logger_currmsg) > LOG_DEFSIZE ? LOG_DEFSIZE : logger_bufsize - logger_currmsg));
+        space = (logger_bufsize - logger_currmsg) > LOG_DEFSIZE ? LOG_DEFSIZE : logger_bufsize - logger_currmsg;
+
+#if defined(OPTION_LOGGER_RING)
+        /* Take whatever logmsg has queued, but do not let a flood of
+           messages hold up output written directly to stdout */
+        if(!logger_select(0))
+        {
+            if((bytes_read = logger_ring_read(logger_buffer + logger_currmsg, space)))
+            {
+                logger_process(bytes_read);
+                continue;
+            }
+
+            /* All caught up; write out the hardcopy batch and wait */
+            if(logger_hrdcpy)
+                fflush(logger_hrdcpy);
+
+            if(!logger_ring_wait())
+                continue;
+        }
+#endif /*defined(OPTION_LOGGER_RING)*/
+
+        bytes_read = read_pipe(logger_syslogfd[LOG_READ], logger_buffer + logger_currmsg, space);
 
         if(bytes_read == -1)
         {
@@ -283,126 +785,33 @@ int bytes_read;
             bytes_read = 0;
         }
 
-        /* If Hercules is not running in daemon mode and panel
-           initialization is not yet complete, write message
-           to stderr so the user can see it on the terminal */
-        if (!sysblk.daemon_mode)
-        {
-            if (!sysblk.panel_init)
-            {
-                /* (ignore any errors; we did the best we could) */
-                fwrite( logger_buffer + logger_currmsg, bytes_read, 1, stderr );
-            }
-        }
-
-        /* Write log data to hardcopy file */
-        if (logger_hrdcpy)
-#if !defined( OPTION_TIMESTAMP_LOGFILE )
-        {
-            char* pLeft2 = logger_buffer + logger_currmsg;
-            int   nLeft2 = bytes_read;
-#if defined( OPTION_MSGCLR )
-            /* Remove "<pnl,..." color string if it exists */
-            if (1
-                && nLeft2 > 5
-                && strncasecmp( pLeft2, "<pnl", 4 ) == 0
-                && (pLeft2 = memchr( pLeft2+4, '>', nLeft2-4 )) != NULL
-            )
-            {
-                pLeft2++;
-                nLeft2 -= (pLeft2 - (logger_buffer + logger_currmsg));
-            }
-            else
-            {
-                pLeft2 = logger_buffer + logger_currmsg;
-                nLeft2 = bytes_read;
-            }
-#endif // defined( OPTION_MSGCLR )
-
-            logger_logfile_write( pLeft2, nLeft2 );
-        }
-#else // defined( OPTION_TIMESTAMP_LOGFILE )
-        {
-            /* Need to prefix each line with a timestamp. */
-
-            static int needstamp = 1;
-            char*  pLeft  = logger_buffer + logger_currmsg;
-            int    nLeft  = bytes_read;
-            char*  pRight = NULL;
-            int    nRight = 0;
-            char*  pNL    = NULL;   /* (pointer to NEWLINE character) */
-
-            if (needstamp)
-            {
-                if (!sysblk.logoptnotime) logger_logfile_timestamp();
-                needstamp = 0;
-            }
-
-            while ( (pNL = memchr( pLeft, '\n', nLeft )) != NULL )
-            {
-                pRight  = pNL + 1;
-                nRight  = nLeft - (pRight - pLeft);
-                nLeft  -= nRight;
-
-#if defined( OPTION_MSGCLR )
-                /* Remove "<pnl...>" color string if it exists */
-                {
-                    char* pLeft2 = pLeft;
-                    int   nLeft2 = nLeft;
-
-                    if (1
-                        && nLeft > 5
-                        && strncasecmp( pLeft, "<pnl", 4 ) == 0
-                        && (pLeft2 = memchr( pLeft+4, '>', nLeft-4 )) != NULL
-                    )
-                    {
-                        pLeft2++;
-                        nLeft2 -= (pLeft2 - pLeft);
-                    }
-                    else
-                    {
-                        pLeft2 = pLeft;
-                        nLeft2 = nLeft;
-                    }
-
-                    logger_logfile_write( pLeft2, nLeft2 );
-                }
-#else // !defined( OPTION_MSGCLR )
-
-                logger_logfile_write( pLeft, nLeft );
-
-#endif // defined( OPTION_MSGCLR )
-
-                pLeft = pRight;
-                nLeft = nRight;
-
-                if (!nLeft)
-                {
-                    needstamp = 1;
-                    break;
-                }
-
-                if (!sysblk.logoptnotime) logger_logfile_timestamp();
-            }
-
-            if (nLeft)
-                logger_logfile_write( pLeft, nLeft );
-        }
-#endif // !defined( OPTION_TIMESTAMP_LOGFILE )
+        logger_process(bytes_read);
 
-        /* Increment buffer index to next available position */
-        logger_currmsg += bytes_read;
-        if(logger_currmsg >= logger_bufsize)
-        {
-            logger_currmsg = 0;
-            logger_wrapped = 1;
-        }
+#if !defined(OPTION_LOGGER_RING)
+        if(logger_hrdcpy)
+            fflush(logger_hrdcpy);
+#endif /*!defined(OPTION_LOGGER_RING)*/
+    }
 
-        /* Notify all interested parties new log data is available */
-        obtain_lock(&logger_lock);
-        broadcast_condition(&logger_cond);
-        release_lock(&logger_lock);
+#if defined(OPTION_LOGGER_RING)
+    /* Stop queueing, let producers that already saw the ring in use
+       finish, and write out anything left in the ring.  A producer
+       waiting on a full ring gives up and writes to the syslog pipe
+       instead, so that is emptied as well */
+    old = 1;
+    cmpxchg4(&old, 0, (void *)&logger_ringon);
+    while(logger_ringusers)
+        sched_yield();
+    for(;;)
+    {
+        space = (logger_bufsize - logger_currmsg) > LOG_DEFSIZE ? LOG_DEFSIZE : logger_bufsize - logger_currmsg;
+        if(!(bytes_read = logger_ring_read(logger_buffer + logger_currmsg, space))
+          && (!logger_select(0)
+            || (bytes_read = read_pipe(logger_syslogfd[LOG_READ], logger_buffer + logger_currmsg, space)) <= 0))
+            break;
+        logger_process(bytes_read);
     }
+#endif /*defined(OPTION_LOGGER_RING)*/
 
     /* Logger is now terminating */
     obtain_lock(&logger_lock);
@@ -416,6 +825,7 @@ int bytes_read;
         if (!sysblk.logoptnotime) logger_logfile_timestamp();
 #endif
         logger_logfile_write( term_msg, term_msg_len );
+        fflush(logger_hrdcpy);
     }
 
     /* Redirect all msgs to stderr */
@@ -495,15 +905,19 @@ DLL_EXPORT void logger_init(void)
             strerror(errno));
         }
 
+        /* The logger thread flushes the hardcopy whenever it has
+           caught up, so that a burst of messages is written at once;
+           error and severe messages are flushed as they are written */
         if(logger_hrdcpy)
-            setvbuf(logger_hrdcpy, NULL, _IONBF, 0);
+            setvbuf(logger_hrdcpy, NULL, _IOFBF, LOG_DEFSIZE);
     }
     else
     {
         logger_syslog[LOG_WRITE]=fopen("LOG","a");
     }
 
-    logger_bufsize = LOG_DEFSIZE;
+    /* Keep several pipe reads worth of log for log_read_seq */
+    logger_bufsize = LOG_DEFSIZE * 4;
 
     if(!(logger_buffer = malloc(logger_bufsize)))
     {
@@ -519,6 +933,22 @@ DLL_EXPORT void logger_init(void)
         exit(1);  /* Hercules running without syslog */
     }
 
+#if defined(OPTION_LOGGER_RING)
+    if(!(logger_ring = calloc(1, LOG_RINGSIZE)))
+    {
+        fprintf(stderr, _("HHCLG008S logbuffer malloc failed: %s\n"),
+          strerror(errno));
+        exit(1);
+    }
+
+    if(create_pipe(logger_bellfd))
+    {
+        fprintf(stderr, _("HHCLG009S Syslog message pipe creation failed: %s\n"),
+          strerror(errno));
+        exit(1);
+    }
+#endif /*defined(OPTION_LOGGER_RING)*/
+
     setvbuf (logger_syslog[LOG_WRITE], NULL, _IONBF, 0);
 
     if (create_thread (&logger_tid, JOINABLE,
@@ -586,7 +1016,7 @@ int   new_hrdcpyfd;
             }
             else
             {
-                setvbuf(new_hrdcpy, NULL, _IONBF, 0);
+                setvbuf(new_hrdcpy, NULL, _IOFBF, LOG_DEFSIZE);
 
                 obtain_lock(&logger_lock);
                 logger_hrdcpy = new_hrdcpy;
@@ -48,6 +48,9 @@ LOGR_DLL_IMPORT void logger_init(void);
 
 LOGR_DLL_IMPORT int log_read(char **buffer, int *msgindex, int block);
 LOGR_DLL_IMPORT int log_line(int linenumber);
+LOGR_DLL_IMPORT U64 log_seq(void);
+LOGR_DLL_IMPORT int log_read_seq(char **buffer, U64 *seq);
+LOGR_DLL_IMPORT void log_enqueue(char *msg, int len);
 LOGR_DLL_IMPORT void log_sethrdcpy(char *filename);
 LOGR_DLL_IMPORT void log_wakeup(void *arg);
 
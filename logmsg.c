@@ -9,6 +9,7 @@
 #include "hercules.h"
 
 #define  BFR_CHUNKSIZE    (256)
+#define  BFR_STAGESIZE    (1024)
 
 /******************************************/
 /* UTILITY MACRO BFR_VSNPRINTF            */
@@ -19,7 +20,7 @@
 /* Purpose : set 'bfr' to contain         */
 /*  a C string based on a message format  */
 /*  and a va_list of args.                */
-/*  bfr must be free()d when over with    */
+/*  bfr must be released with BFR_FREE()  */
 /*  this macro can ONLY be used from the  */
 /*  topmost variable arg function         */
 /*  that is the va_list cannot be passed  */
@@ -27,8 +28,10 @@
 /*  since va_xxx functions behavio(u)r    */
 /*  seems to be undefined in those cases  */
 /* char *bfr; must be originally defined  */
-/* int siz;    must be defined and cont-  */
-/*             ain a start size           */
+/* char stage[]; must be defined; short   */
+/*             messages are formatted     */
+/*             there without a malloc     */
+/* int siz;    must be defined            */
 /* va_list vl; must be defined and init-  */
 /*             ialised with va_start      */
 /* char *msg; is the message format       */
@@ -36,7 +39,8 @@
 /******************************************/
 
 #define  BFR_VSNPRINTF()                  \
-    bfr=malloc(siz);                      \
+    bfr=stage;                            \
+    siz=sizeof(stage);                    \
     rc=-1;                                \
     while(bfr&&rc<0)                      \
     {                                     \
@@ -45,11 +49,18 @@
         va_end(vl);                       \
         if(rc>=0 && rc<siz)               \
             break;                        \
+        siz=rc>=siz ? rc+1                \
+                    : siz+BFR_CHUNKSIZE;  \
         rc=-1;                            \
-        siz+=BFR_CHUNKSIZE;               \
-        bfr=realloc(bfr,siz);             \
+        if(bfr!=stage)                    \
+            free(bfr);                    \
+        bfr=malloc(siz);                  \
     }
 
+#define  BFR_FREE()                       \
+    if(bfr && bfr!=stage)                 \
+        free(bfr)
+
 static LOCK log_route_lock;
 
 #define MAX_LOG_ROUTES 16
@@ -64,6 +75,7 @@ typedef struct _LOG_ROUTES
 LOG_ROUTES log_routes[MAX_LOG_ROUTES];
 
 static int log_route_inited=0;
+static int log_routes_open=0;           /* Routes currently in use   */
 
 static void log_route_init(void)
 {
@@ -119,6 +131,7 @@ DLL_EXPORT int log_open(LOG_WRITER *lw,LOG_CLOSER *lc,void *uw)
     log_routes[slot].w=lw;
     log_routes[slot].c=lc;
     log_routes[slot].u=uw;
+    log_routes_open++;
     release_lock(&log_route_lock);
     return(0);
 }
@@ -139,6 +152,7 @@ DLL_EXPORT void log_close(void)
     log_routes[slot].w=NULL;
     log_routes[slot].c=NULL;
     log_routes[slot].u=NULL;
+    log_routes_open--;
     release_lock(&log_route_lock);
     return;
 }
@@ -148,9 +162,10 @@ DLL_EXPORT void log_close(void)
 /*-------------------------------------------------------------------*/
 DLL_EXPORT void logmsg(char *msg,...)
 {
+    char stage[BFR_STAGESIZE];
     char *bfr=NULL;
     int rc;
-    int siz=1024;
+    int siz;
     va_list vl;
   #ifdef NEED_LOGMSG_FFLUSH
     fflush(stdout);  
@@ -161,10 +176,7 @@ DLL_EXPORT void logmsg(char *msg,...)
   #ifdef NEED_LOGMSG_FFLUSH
     fflush(stdout);  
   #endif
-    if(bfr)
-    {
-        free(bfr);
-    }
+    BFR_FREE();
 }
 
 /*-------------------------------------------------------------------*/
@@ -172,9 +184,10 @@ DLL_EXPORT void logmsg(char *msg,...)
 /*-------------------------------------------------------------------*/
 DLL_EXPORT void logmsgp(char *msg,...)
 {
+    char stage[BFR_STAGESIZE];
     char *bfr=NULL;
     int rc;
-    int siz=1024;
+    int siz;
     va_list vl;
   #ifdef NEED_LOGMSG_FFLUSH
     fflush(stdout);  
@@ -185,10 +198,7 @@ DLL_EXPORT void logmsgp(char *msg,...)
   #ifdef NEED_LOGMSG_FFLUSH
     fflush(stdout);  
   #endif
-    if(bfr)
-    {
-        free(bfr);
-    }
+    BFR_FREE();
 }
  
 /*-------------------------------------------------------------------*/
@@ -196,9 +206,10 @@ DLL_EXPORT void logmsgp(char *msg,...)
 /*-------------------------------------------------------------------*/
 DLL_EXPORT void logmsgb(char *msg,...)
 {
+    char stage[BFR_STAGESIZE];
     char *bfr=NULL;
     int rc;
-    int siz=1024;
+    int siz;
     va_list vl;
   #ifdef NEED_LOGMSG_FFLUSH
     fflush(stdout);  
@@ -209,10 +220,7 @@ DLL_EXPORT void logmsgb(char *msg,...)
   #ifdef NEED_LOGMSG_FFLUSH
     fflush(stdout);  
   #endif
-    if(bfr)
-    {
-        free(bfr);
-    }
+    BFR_FREE();
 }
 
 /*-------------------------------------------------------------------*/
@@ -220,9 +228,10 @@ DLL_EXPORT void logmsgb(char *msg,...)
 /*-------------------------------------------------------------------*/
 DLL_EXPORT void logdevtr(DEVBLK *dev,char *msg,...)
 {
+    char stage[BFR_STAGESIZE];
     char *bfr=NULL;
     int rc;
-    int siz=1024;
+    int siz;
     va_list vl;
   #ifdef NEED_LOGMSG_FFLUSH
     fflush(stdout);  
@@ -237,10 +246,7 @@ DLL_EXPORT void logdevtr(DEVBLK *dev,char *msg,...)
   #ifdef NEED_LOGMSG_FFLUSH
     fflush(stdout);  
   #endif
-    if(bfr)
-    {
-        free(bfr);
-    }
+    BFR_FREE();
 } /* end function logdevtr */ 
 
 /* panel : 0 - No, 1 - Only, 2 - Also */
@@ -252,15 +258,22 @@ DLL_EXPORT void log_write(int panel,char *msg)
     log_route_init();
     if(panel==1)
     {
-        write_pipe( logger_syslogfd[LOG_WRITE], msg, strlen(msg) );
+        log_enqueue( msg, strlen(msg) );
         return;
     }
-    obtain_lock(&log_route_lock);
-    slot=log_route_search(thread_id());
-    release_lock(&log_route_lock);
+    /* Only a thread that has opened a route can find one, and it
+       sees its own update of log_routes_open without the lock */
+    if(!log_routes_open)
+        slot=-1;
+    else
+    {
+        obtain_lock(&log_route_lock);
+        slot=log_route_search(thread_id());
+        release_lock(&log_route_lock);
+    }
     if(slot<0 || panel>0)
     {
-        write_pipe( logger_syslogfd[LOG_WRITE], msg, strlen(msg) );
+        log_enqueue( msg, strlen(msg) );
         if(slot<0)
             return;
     }
@@ -251,6 +251,9 @@ RADR    fsta = 0;
     /* Store current PSW at PSA+X'30' */
     ARCH_DEP(store_psw) ( regs, psa->mckold );
 
+    /* Discard cached blocks built from the PSA */
+    BBC_INVALIDATE(psa, sizeof(*psa));
+
     /* Load new PSW from PSA+X'70' */
     rc = ARCH_DEP(load_psw) ( regs, psa->mcknew );
 
@@ -0,0 +1,509 @@
+/* METRICS.C    (c)Copyright The Hercules Project, 2026              */
+/*              Machine readable performance metrics                 */
+
+/*-------------------------------------------------------------------*/
+/* This module gathers the counters kept by the CPUs, the devices,   */
+/* the cache and the compressed dasd driver into one snapshot and    */
+/* formats it either as Prometheus text exposition format or as a    */
+/* JSON document.  The counters themselves are plain fields updated  */
+/* by the thread that owns them (instcount, siocount and tlb in the  */
+/* REGS, excps, ccws and iobytes in the DEVBLK) and are read here    */
+/* without serialization, so collecting them costs the hot paths     */
+/* nothing.  The snapshot is served by the http server as            */
+/* cgi-bin/metrics/prometheus and cgi-bin/metrics/json, and can be   */
+/* displayed with the `metrics' command.                             */
+/*-------------------------------------------------------------------*/
+
+#include "hstdinc.h"
+
+#define _METRICS_C_
+#define _HENGINE_DLL_
+
+#include "hercules.h"
+#include "cache.h"
+
+/*-------------------------------------------------------------------*/
+/* Snapshot entries.  Every value is a U64 so that the tables below  */
+/* can describe each metric by its offset.                           */
+/*-------------------------------------------------------------------*/
+typedef struct _MCPU {                  /* CPU counters              */
+        int     cpuad;                  /* CPU address               */
+        U64     instructions;           /* Instructions executed     */
+        U64     mips;                   /* Instructions per second   */
+        U64     sios;                   /* SIO/SSCH executed         */
+        U64     siorate;                /* SIO/SSCH per second       */
+        U64     busy;                   /* Percent busy              */
+        U64     tlbl2hits;              /* Second level TLB hits     */
+        U64     tlbmisses;              /* TLB misses                */
+} MCPU;
+
+typedef struct _MDEV {                  /* Device counters           */
+        int     lcss;                   /* Logical channel subsystem */
+        U16     devnum;                 /* Device number             */
+        char    type[16];               /* Device type name          */
+        int     cckd;                   /* 1=Compressed dasd         */
+        int     spool;                  /* 1=Printer or punch output */
+        U64     excps;                  /* Channel programs started  */
+        U64     ccws;                   /* CCWs executed             */
+        U64     iobytes;                /* Bytes transferred         */
+        U64     unitchecks;             /* Unit checks presented     */
+        U64     syncios;                /* Synchronous I/Os          */
+        U64     busy;                   /* 1=Device is busy          */
+        U64     reads;                  /* cckd track reads          */
+        U64     writes;                 /* cckd track writes         */
+        U64     l2reads;                /* cckd level 2 table reads  */
+        U64     cachehits;              /* cckd cache hits           */
+        U64     readaheads;             /* cckd tracks read ahead    */
+        U64     switches;               /* cckd track switches       */
+        U64     records;                /* Spool records written     */
+        U64     bytes;                  /* Spool bytes written       */
+        U64     spoolwrites;            /* Spool writes to the file  */
+        U64     stalls;                 /* Spool waits for space     */
+        U64     stallusecs;             /* Spool microseconds waited */
+        U64     bufsize;                /* Spool buffer size         */
+        U64     buffered;               /* Spool bytes buffered      */
+        U64     maxbuffered;            /* Spool most bytes buffered */
+} MDEV;
+
+typedef struct _MCACHE {                /* Cache counters            */
+        int     ix;                     /* Cache index               */
+        U64     entries;                /* Number of entries         */
+        U64     busy;                   /* Busy entries              */
+        U64     empty;                  /* Empty entries             */
+        U64     bytes;                  /* Size of buffers           */
+        U64     hits;                   /* Hits                      */
+        U64     misses;                 /* Misses                    */
+} MCACHE;
+
+typedef struct _MSYS {                  /* System counters           */
+        U64     mips;                   /* Instructions per second   */
+        U64     siorate;                /* SIO/SSCH per second       */
+        U64     cpus;                   /* CPUs online               */
+        U64     devices;                /* Devices defined           */
+        U64     cckdreads;              /* cckd track reads          */
+        U64     cckdreadbytes;          /* cckd bytes read           */
+        U64     cckdwrites;             /* cckd track writes         */
+        U64     cckdwritebytes;         /* cckd bytes written        */
+        U64     cckdcachehits;          /* cckd cache hits           */
+        U64     cckdcachemisses;        /* cckd cache misses         */
+        U64     cckdl2hits;             /* cckd L2 cache hits        */
+        U64     cckdl2misses;           /* cckd L2 cache misses      */
+        U64     cckdreadaheads;         /* cckd readaheads           */
+        U64     cckdsyncios;            /* cckd synchronous i/os     */
+        U64     cckdgcolbytes;          /* cckd garbage collected    */
+} MSYS;
+
+typedef struct _METRIC {                /* Metric description        */
+        char   *name;                   /* Name within its group     */
+        char   *type;                   /* "counter" or "gauge"      */
+        char   *help;                   /* Description               */
+        size_t  offset;                 /* Offset of the U64 value   */
+} METRIC;
+
+#define MVAL(_p, _m)    (*(U64 *)((BYTE *)(_p) + (_m)->offset))
+
+static METRIC msys[] = {
+ { "instruction_rate",       "gauge",   "Instructions per second, all CPUs",     offsetof(MSYS, mips) },
+ { "sio_rate",               "gauge",   "SIO/SSCH per second, all CPUs",         offsetof(MSYS, siorate) },
+ { "cpus_online",            "gauge",   "CPUs online",                           offsetof(MSYS, cpus) },
+ { "devices",                "gauge",   "Devices defined",                       offsetof(MSYS, devices) },
+ { "cckd_reads_total",       "counter", "Compressed dasd track reads",           offsetof(MSYS, cckdreads) },
+ { "cckd_read_bytes_total",  "counter", "Compressed dasd bytes read",            offsetof(MSYS, cckdreadbytes) },
+ { "cckd_writes_total",      "counter", "Compressed dasd track writes",          offsetof(MSYS, cckdwrites) },
+ { "cckd_write_bytes_total", "counter", "Compressed dasd bytes written",         offsetof(MSYS, cckdwritebytes) },
+ { "cckd_cache_hits_total",  "counter", "Compressed dasd track cache hits",      offsetof(MSYS, cckdcachehits) },
+ { "cckd_cache_misses_total","counter", "Compressed dasd track cache misses",    offsetof(MSYS, cckdcachemisses) },
+ { "cckd_l2_hits_total",     "counter", "Compressed dasd L2 cache hits",         offsetof(MSYS, cckdl2hits) },
+ { "cckd_l2_misses_total",   "counter", "Compressed dasd L2 cache misses",       offsetof(MSYS, cckdl2misses) },
+ { "cckd_readaheads_total",  "counter", "Compressed dasd tracks read ahead",     offsetof(MSYS, cckdreadaheads) },
+ { "cckd_syncios_total",     "counter", "Compressed dasd synchronous i/os",      offsetof(MSYS, cckdsyncios) },
+ { "cckd_gcol_bytes_total",  "counter", "Compressed dasd bytes moved by garbage collection", offsetof(MSYS, cckdgcolbytes) },
+ { NULL, NULL, NULL, 0 } };
+
+static METRIC mcpu[] = {
+ { "instructions_total",     "counter", "Instructions executed",                 offsetof(MCPU, instructions) },
+ { "instruction_rate",       "gauge",   "Instructions per second",               offsetof(MCPU, mips) },
+ { "sios_total",             "counter", "SIO/SSCH instructions executed",        offsetof(MCPU, sios) },
+ { "sio_rate",               "gauge",   "SIO/SSCH per second",                   offsetof(MCPU, siorate) },
+ { "busy_percent",           "gauge",   "Percent of the last interval not in wait state", offsetof(MCPU, busy) },
+ { "tlb_l2_hits_total",      "counter", "Translations found in the second level TLB", offsetof(MCPU, tlbl2hits) },
+ { "tlb_misses_total",       "counter", "Translations which walked the DAT tables", offsetof(MCPU, tlbmisses) },
+ { NULL, NULL, NULL, 0 } };
+
+static METRIC mdev[] = {
+ { "channel_programs_total", "counter", "Channel programs started",              offsetof(MDEV, excps) },
+ { "ccws_total",             "counter", "CCWs executed",                         offsetof(MDEV, ccws) },
+ { "bytes_total",            "counter", "Bytes transferred by CCWs",             offsetof(MDEV, iobytes) },
+ { "unit_checks_total",      "counter", "Unit checks presented",                 offsetof(MDEV, unitchecks) },
+ { "syncios_total",          "counter", "Channel programs run synchronously",    offsetof(MDEV, syncios) },
+ { "busy",                   "gauge",   "1 if a channel program is active",      offsetof(MDEV, busy) },
+ { NULL, NULL, NULL, 0 } };
+
+static METRIC mcckd[] = {
+ { "cckd_reads_total",       "counter", "Compressed dasd track reads",           offsetof(MDEV, reads) },
+ { "cckd_writes_total",      "counter", "Compressed dasd track writes",          offsetof(MDEV, writes) },
+ { "cckd_l2_reads_total",    "counter", "Compressed dasd L2 table reads",        offsetof(MDEV, l2reads) },
+ { "cckd_cache_hits_total",  "counter", "Compressed dasd track cache hits",      offsetof(MDEV, cachehits) },
+ { "cckd_readaheads_total",  "counter", "Compressed dasd tracks read ahead",     offsetof(MDEV, readaheads) },
+ { "cckd_switches_total",    "counter", "Compressed dasd track switches",        offsetof(MDEV, switches) },
+ { NULL, NULL, NULL, 0 } };
+
+static METRIC mspool[] = {
+ { "spool_records_total",    "counter", "Printer or punch records written",      offsetof(MDEV, records) },
+ { "spool_bytes_total",      "counter", "Printer or punch bytes written",        offsetof(MDEV, bytes) },
+ { "spool_writes_total",     "counter", "Writes to the printer or punch file",   offsetof(MDEV, spoolwrites) },
+ { "spool_stalls_total",     "counter", "Writes which waited for buffer space",  offsetof(MDEV, stalls) },
+ { "spool_stall_microseconds_total", "counter", "Microseconds waited for buffer space", offsetof(MDEV, stallusecs) },
+ { "spool_buffer_bytes",     "gauge",   "Size of the output buffer",             offsetof(MDEV, bufsize) },
+ { "spool_buffered_bytes",   "gauge",   "Bytes waiting in the output buffer",    offsetof(MDEV, buffered) },
+ { "spool_buffered_bytes_max", "gauge", "Most bytes ever waiting in the output buffer", offsetof(MDEV, maxbuffered) },
+ { NULL, NULL, NULL, 0 } };
+
+static METRIC mcache[] = {
+ { "entries",                "gauge",   "Cache entries",                         offsetof(MCACHE, entries) },
+ { "busy",                   "gauge",   "Busy cache entries",                    offsetof(MCACHE, busy) },
+ { "empty",                  "gauge",   "Empty cache entries",                   offsetof(MCACHE, empty) },
+ { "bytes",                  "gauge",   "Bytes of cache buffers",                offsetof(MCACHE, bytes) },
+ { "hits_total",             "counter", "Cache lookups found",                   offsetof(MCACHE, hits) },
+ { "misses_total",           "counter", "Cache lookups not found",               offsetof(MCACHE, misses) },
+ { NULL, NULL, NULL, 0 } };
+
+typedef struct _MSNAP {                 /* Snapshot                  */
+        MSYS    sys;                    /* System counters           */
+        MCPU    cpu[MAX_CPU_ENGINES];   /* CPU counters              */
+        int     ncpu;                   /* Number of CPU entries     */
+        MDEV   *dev;                    /* Device counters           */
+        int     ndev;                   /* Number of device entries  */
+        MCACHE  cache[CACHE_MAX_INDEX]; /* Cache counters            */
+        int     ncache;                 /* Number of cache entries   */
+} MSNAP;
+
+typedef struct _MBUF {                  /* Output buffer             */
+        char   *buf;                    /* -> Buffer or NULL         */
+        size_t  len;                    /* Length used               */
+        size_t  size;                   /* Size of buffer            */
+} MBUF;
+
+/*-------------------------------------------------------------------*/
+/* Append formatted text to the output buffer                        */
+/*-------------------------------------------------------------------*/
+static void mput (MBUF *mb, char *fmt, ...)
+{
+va_list vl;                             /* Argument list             */
+int     n;                              /* Formatted length          */
+char   *p;                              /* -> Reallocated buffer     */
+
+    if (mb->size && !mb->buf)
+        return;
+
+    for ( ; ; )
+    {
+        va_start (vl, fmt);
+        n = vsnprintf (mb->buf + mb->len, mb->size - mb->len, fmt, vl);
+        va_end (vl);
+
+        if (n >= 0 && mb->len + n < mb->size)
+        {
+            mb->len += n;
+            return;
+        }
+
+        mb->size = mb->size ? mb->size * 2 : 16384;
+        if ((p = realloc (mb->buf, mb->size)) == NULL)
+        {
+            free (mb->buf);
+            mb->buf = NULL;
+            return;
+        }
+        mb->buf = p;
+    }
+}
+
+/*-------------------------------------------------------------------*/
+/* Collect the counters                                              */
+/*-------------------------------------------------------------------*/
+static void metrics_snap (MSNAP *ms)
+{
+DEVBLK *dev;                            /* -> Device block           */
+REGS   *regs;                           /* -> CPU register context   */
+MCPU   *mc;                             /* -> CPU entry              */
+MDEV   *md;                             /* -> Device entry           */
+MCACHE *mh;                             /* -> Cache entry            */
+CCKDDASD_EXT *cckd;                     /* -> cckd extension         */
+int     i;                              /* Index                     */
+
+    memset (ms, 0, sizeof(MSNAP));
+
+    /* System */
+#if defined(OPTION_MIPS_COUNTING)
+    ms->sys.mips = sysblk.mipsrate;
+    ms->sys.siorate = sysblk.siosrate;
+#endif
+    ms->sys.cckdreads = cckdblk.stats_reads;
+    ms->sys.cckdreadbytes = cckdblk.stats_readbytes;
+    ms->sys.cckdwrites = cckdblk.stats_writes;
+    ms->sys.cckdwritebytes = cckdblk.stats_writebytes;
+    ms->sys.cckdcachehits = cckdblk.stats_cachehits;
+    ms->sys.cckdcachemisses = cckdblk.stats_cachemisses;
+    ms->sys.cckdl2hits = cckdblk.stats_l2cachehits;
+    ms->sys.cckdl2misses = cckdblk.stats_l2cachemisses;
+    ms->sys.cckdreadaheads = cckdblk.stats_readaheads;
+    ms->sys.cckdsyncios = cckdblk.stats_syncios;
+    ms->sys.cckdgcolbytes = cckdblk.stats_gcolbytes;
+
+    /* CPUs, under the cpu lock so the REGS cannot go away */
+    for (i = 0; i < HI_CPU && i < MAX_CPU_ENGINES; i++)
+    {
+        obtain_lock (&sysblk.cpulock[i]);
+        if (!IS_CPU_ONLINE(i))
+        {
+            release_lock (&sysblk.cpulock[i]);
+            continue;
+        }
+        regs = sysblk.regs[i];
+        mc = &ms->cpu[ms->ncpu++];
+        mc->cpuad = regs->cpuad;
+        mc->instructions = regs->prevcount + regs->instcount;
+        mc->sios = regs->siototal + regs->siocount;
+#if defined(OPTION_MIPS_COUNTING)
+        mc->mips = regs->mipsrate;
+        mc->siorate = regs->siosrate;
+        mc->busy = regs->cpupct;
+#endif
+        mc->tlbl2hits = regs->tlb.l2hits;
+        mc->tlbmisses = regs->tlb.misses;
+        release_lock (&sysblk.cpulock[i]);
+    }
+    ms->sys.cpus = ms->ncpu;
+
+    /* Devices */
+    for (dev = sysblk.firstdev; dev; dev = dev->nextdev)
+        if (dev->allocated)
+            ms->sys.devices++;
+
+    if (ms->sys.devices
+     && (ms->dev = calloc ((size_t)ms->sys.devices, sizeof(MDEV))) != NULL)
+    {
+        for (dev = sysblk.firstdev; dev && ms->ndev < (int)ms->sys.devices;
+             dev = dev->nextdev)
+        {
+            if (!dev->allocated)
+                continue;
+            md = &ms->dev[ms->ndev++];
+            md->lcss = SSID_TO_LCSS(dev->ssid);
+            md->devnum = dev->devnum;
+            if (dev->typname)
+                strlcpy (md->type, dev->typname, sizeof(md->type));
+            else
+                snprintf (md->type, sizeof(md->type), "%4.4X", dev->devtype);
+            md->excps = dev->excps;
+            md->ccws = dev->ccws;
+            md->iobytes = dev->iobytes;
+            md->unitchecks = dev->unitchecks;
+            md->syncios = dev->syncios;
+            md->busy = dev->busy;
+            if ((cckd = dev->cckd_ext) != NULL)
+            {
+                md->cckd = 1;
+                md->reads = cckd->totreads;
+                md->writes = cckd->totwrites;
+                md->l2reads = cckd->totl2reads;
+                md->cachehits = cckd->cachehits;
+                md->readaheads = cckd->readaheads;
+                md->switches = cckd->switches;
+            }
+            if (dev->spool.size || dev->spool.records)
+            {
+                md->spool = 1;
+                md->records = dev->spool.records;
+                md->bytes = dev->spool.bytes;
+                md->spoolwrites = dev->spool.writes;
+                md->stalls = dev->spool.stalls;
+                md->stallusecs = dev->spool.stallusecs;
+                md->bufsize = dev->spool.size;
+                md->buffered = dev->spool.count;
+                md->maxbuffered = dev->spool.maxcount;
+            }
+        }
+    }
+
+    /* Caches */
+    for (i = 0; i < CACHE_MAX_INDEX; i++)
+    {
+        if (cache_nbr (i) <= 0)
+            continue;
+        mh = &ms->cache[ms->ncache++];
+        mh->ix = i;
+        mh->entries = cache_nbr (i);
+        mh->busy = cache_busy (i);
+        mh->empty = cache_empty (i);
+        mh->bytes = cache_size (i);
+        mh->hits = cache_hits (i);
+        mh->misses = cache_misses (i);
+    }
+}
+
+/*-------------------------------------------------------------------*/
+/* Format one group of metrics in Prometheus text format             */
+/*-------------------------------------------------------------------*/
+static void metrics_prom (MBUF *mb, char *group, METRIC *m,
+                          void *ent, size_t entsize, int n,
+                          char *(*label)(void *, char *))
+{
+int     i;                              /* Entry index               */
+char    lbl[64];                        /* Label set                 */
+
+    for ( ; m->name; m++)
+    {
+        mput (mb, "# HELP hercules_%s%s %s\n", group, m->name, m->help);
+        mput (mb, "# TYPE hercules_%s%s %s\n", group, m->name, m->type);
+        for (i = 0; i < n; i++)
+        {
+            void *e = (BYTE *)ent + i * entsize;
+            if (label && !label (e, lbl))
+                continue;
+            mput (mb, "hercules_%s%s%s %" I64_FMT "u\n", group, m->name,
+                  label ? lbl : "", MVAL(e, m));
+        }
+    }
+}
+
+/*-------------------------------------------------------------------*/
+/* Format the members of one entry as JSON                           */
+/*-------------------------------------------------------------------*/
+static void metrics_json (MBUF *mb, METRIC *m, void *ent)
+{
+    for ( ; m->name; m++)
+        mput (mb, ",\"%s\":%" I64_FMT "u", m->name, MVAL(ent, m));
+}
+
+/*-------------------------------------------------------------------*/
+/* Prometheus labels                                                 */
+/*-------------------------------------------------------------------*/
+static char *label_cpu (void *e, char *lbl)
+{
+    sprintf (lbl, "{cpu=\"%d\"}", ((MCPU *)e)->cpuad);
+    return lbl;
+}
+
+static char *label_dev (void *e, char *lbl)
+{
+MDEV   *md = e;
+
+    sprintf (lbl, "{device=\"%d:%4.4X\",type=\"%s\"}",
+             md->lcss, md->devnum, md->type);
+    return lbl;
+}
+
+static char *label_cckd (void *e, char *lbl)
+{
+    return ((MDEV *)e)->cckd ? label_dev (e, lbl) : NULL;
+}
+
+static char *label_spool (void *e, char *lbl)
+{
+    return ((MDEV *)e)->spool ? label_dev (e, lbl) : NULL;
+}
+
+static char *label_cache (void *e, char *lbl)
+{
+    sprintf (lbl, "{cache=\"%d\"}", ((MCACHE *)e)->ix);
+    return lbl;
+}
+
+/*-------------------------------------------------------------------*/
+/* Format the metrics                                                */
+/*-------------------------------------------------------------------*/
+/* Returns a buffer obtained with malloc, which the caller frees,    */
+/* containing the metrics as Prometheus text (json=0) or as a JSON   */
+/* document (json=1).  NULL is returned if no storage is available.  */
+/*-------------------------------------------------------------------*/
+char *metrics_format (int json)
+{
+MSNAP   ms;                             /* Snapshot                  */
+MBUF    mb;                             /* Output buffer             */
+int     i;                              /* Index                     */
+
+    metrics_snap (&ms);
+    memset (&mb, 0, sizeof(mb));
+
+    if (!json)
+    {
+        metrics_prom (&mb, "", msys, &ms.sys, 0, 1, NULL);
+        metrics_prom (&mb, "cpu_", mcpu, ms.cpu, sizeof(MCPU), ms.ncpu,
+                      label_cpu);
+        metrics_prom (&mb, "device_", mdev, ms.dev, sizeof(MDEV), ms.ndev,
+                      label_dev);
+        metrics_prom (&mb, "device_", mcckd, ms.dev, sizeof(MDEV), ms.ndev,
+                      label_cckd);
+        metrics_prom (&mb, "device_", mspool, ms.dev, sizeof(MDEV), ms.ndev,
+                      label_spool);
+        metrics_prom (&mb, "cache_", mcache, ms.cache, sizeof(MCACHE),
+                      ms.ncache, label_cache);
+    }
+    else
+    {
+        mput (&mb, "{\"system\":{\"time\":%" I64_FMT "u", (U64)time (NULL));
+        metrics_json (&mb, msys, &ms.sys);
+        mput (&mb, "},\n\"cpus\":[");
+        for (i = 0; i < ms.ncpu; i++)
+        {
+            mput (&mb, "%s\n{\"cpu\":%d", i ? "," : "", ms.cpu[i].cpuad);
+            metrics_json (&mb, mcpu, &ms.cpu[i]);
+            mput (&mb, "}");
+        }
+        mput (&mb, "],\n\"devices\":[");
+        for (i = 0; i < ms.ndev; i++)
+        {
+            mput (&mb, "%s\n{\"device\":\"%d:%4.4X\",\"type\":\"%s\"",
+                  i ? "," : "", ms.dev[i].lcss, ms.dev[i].devnum,
+                  ms.dev[i].type);
+            metrics_json (&mb, mdev, &ms.dev[i]);
+            if (ms.dev[i].cckd)
+                metrics_json (&mb, mcckd, &ms.dev[i]);
+            if (ms.dev[i].spool)
+                metrics_json (&mb, mspool, &ms.dev[i]);
+            mput (&mb, "}");
+        }
+        mput (&mb, "],\n\"caches\":[");
+        for (i = 0; i < ms.ncache; i++)
+        {
+            mput (&mb, "%s\n{\"cache\":%d", i ? "," : "", ms.cache[i].ix);
+            metrics_json (&mb, mcache, &ms.cache[i]);
+            mput (&mb, "}");
+        }
+        mput (&mb, "]}\n");
+    }
+
+    free (ms.dev);
+    return mb.buf;
+}
+
+/*-------------------------------------------------------------------*/
+/* metrics command                                                   */
+/*-------------------------------------------------------------------*/
+int metrics_cmd (int argc, char *argv[], char *cmdline)
+{
+char   *buf;                            /* -> Formatted metrics      */
+int     json = 0;                       /* 1=JSON                    */
+
+    UNREFERENCED(cmdline);
+
+    if (argc > 2 || (argc == 2 && strcasecmp (argv[1], "json")
+                               && strcasecmp (argv[1], "prometheus")))
+    {
+        logmsg (_("HHCMT001E Invalid metrics operand %s\n"), argv[argc-1]);
+        return -1;
+    }
+    if (argc == 2 && !strcasecmp (argv[1], "json"))
+        json = 1;
+
+    if ((buf = metrics_format (json)) == NULL)
+    {
+        logmsg (_("HHCMT002E Out of memory for metrics\n"));
+        return -1;
+    }
+    logmsg ("%s", buf);
+    free (buf);
+    return 0;
+}
@@ -1342,6 +1342,75 @@ DEF_INST(execute_e4xx)
 #endif /*defined(FEATURE_VECTOR_FACILITY)*/
 
 
+#if defined(OPTION_BLOCK_CACHE)
+/*-------------------------------------------------------------------*/
+/* Resolve the function which finally executes an instruction        */
+/*                                                                   */
+/* Used by the basic block cache.  If the opcode table entry for     */
+/* the first opcode byte is one of the execute_xxxx routines above   */
+/* then the second level table is looked up here, once, instead of   */
+/* each time the instruction is executed.  The offset of the byte    */
+/* which selected the second level entry is returned in `xoff', or   */
+/* zero if the first level function was returned.                    */
+/*-------------------------------------------------------------------*/
+zz_func ARCH_DEP(resolve_opcode) (BYTE inst[], REGS *regs, int *xoff)
+{
+zz_func func;                           /* First level function      */
+
+    func = regs->ARCH_DEP(opcode_table)[inst[0]];
+
+#define RESOLVE_XX(_xx, _off)                                        \
+    if (func == ARCH_DEP(execute_ ## _xx))                           \
+    {                                                                \
+        *xoff = (_off);                                              \
+        return regs->ARCH_DEP(opcode_ ## _xx)[inst[(_off)]];         \
+    }
+
+#if ARCH_MODE != ARCH_370
+    RESOLVE_XX(01xx, 1);
+#endif
+    RESOLVE_XX(a7xx, 1);
+    RESOLVE_XX(b2xx, 1);
+    RESOLVE_XX(b9xx, 1);
+    RESOLVE_XX(ebxx, 5);
+#if defined(FEATURE_BASIC_FP_EXTENSIONS)
+    RESOLVE_XX(b3xx, 1);
+    RESOLVE_XX(edxx, 5);
+#endif /*defined(FEATURE_BASIC_FP_EXTENSIONS)*/
+    RESOLVE_XX(e5xx, 1);
+#if ARCH_MODE == ARCH_370
+    RESOLVE_XX(e6xx, 1);
+#endif
+#if defined(FEATURE_ESAME) || defined(FEATURE_ESAME_N3_ESA390) \
+ || defined(FEATURE_VECTOR_FACILITY)
+    RESOLVE_XX(a5xx, 1);
+#endif
+#if defined(FEATURE_ESAME) || defined(FEATURE_ESAME_N3_ESA390)
+    RESOLVE_XX(e3xx, 5);
+    RESOLVE_XX(ecxx, 5);
+    RESOLVE_XX(c0xx, 1);
+    RESOLVE_XX(c2xx, 1);
+#endif /*defined(FEATURE_ESAME) || defined(FEATURE_ESAME_N3_ESA390)*/
+    RESOLVE_XX(c4xx, 1);
+    RESOLVE_XX(c6xx, 1);
+#if defined(FEATURE_ESAME)
+    RESOLVE_XX(c8xx, 1);
+    RESOLVE_XX(ccxx, 1);
+#endif /*defined(FEATURE_ESAME)*/
+#if defined(FEATURE_VECTOR_FACILITY)
+    RESOLVE_XX(a4xx, 1);
+    RESOLVE_XX(a6xx, 1);
+    RESOLVE_XX(e4xx, 1);
+#endif /*defined(FEATURE_VECTOR_FACILITY)*/
+
+#undef RESOLVE_XX
+
+    *xoff = 0;
+    return func;
+}
+#endif /*defined(OPTION_BLOCK_CACHE)*/
+
+
 DEF_INST(operation_exception)
 {
     INST_UPDATE_PSW (regs, ILC(inst[0]), ILC(inst[0]));
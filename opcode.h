@@ -913,6 +913,18 @@ do { \
    } \
  } while (0)
 
+#if defined(OPTION_BLOCK_CACHE)
+/* Discard cached blocks after storing without using the TLB */
+#define BBC_INVALIDATE(_main, _len) \
+ do { \
+   if (sysblk.bbcframe) \
+     bbc_invalidate ((RADR)((BYTE *)(_main) - sysblk.mainstor), \
+                     (RADR)(_len)); \
+ } while (0)
+#else
+#define BBC_INVALIDATE(_main, _len)
+#endif /*defined(OPTION_BLOCK_CACHE)*/
+
 #if defined(INLINE_STORE_FETCH_ADDR_CHECK)
  #define FETCH_MAIN_ABSOLUTE(_addr, _regs, _len) \
   ARCH_DEP(fetch_main_absolute)((_addr), (_regs), (_len))
@@ -2827,6 +2839,11 @@ int  ARCH_DEP(present_io_interrupt) (REGS *regs, U32 *ioid,
 int ARCH_DEP(present_zone_io_interrupt) (U32 *ioid, U32 *ioparm,
                                               U32 *iointid, BYTE zone);
 void io_reset (void);
+#if !defined(OPTION_FISHIO)
+void ioq_init (void);
+void ioq_wakeup (void);
+int  ioq_pending (void);
+#endif /*!defined(OPTION_FISHIO)*/
 int  chp_reset(REGS *, BYTE chpid);
 void channelset_reset(REGS *regs);
 DLL_EXPORT int  device_attention (DEVBLK *dev, BYTE unitstat);
@@ -2853,6 +2870,13 @@ void z900_process_trace (REGS *regs);
 #endif
 
 int cpu_init (int cpu, REGS *regs, REGS *hostregs);
+int tlb_init (REGS *regs, U32 sets, int ways);
+void tlb_uninit (REGS *regs);
+#if defined(OPTION_BLOCK_CACHE)
+int bbc_init (REGS *regs);
+int bbc_store (RADR addr, size_t len, int acctype, int slow);
+void bbc_invalidate (RADR addr, RADR len);
+#endif /*defined(OPTION_BLOCK_CACHE)*/
 void ARCH_DEP(perform_io_interrupt) (REGS *regs);
 void ARCH_DEP(checkstop_config)(void);
 #if defined(_FEATURE_SIE)
@@ -2951,11 +2975,17 @@ void sigabend_handler (int signo);
 /* Functions in module opcode.c */
 OPC_DLL_IMPORT void copy_opcode_tables ();
 void set_opcode_pointers (REGS *regs);
+#if defined(OPTION_BLOCK_CACHE)
+zz_func ARCH_DEP(resolve_opcode) (BYTE inst[], REGS *regs, int *xoff);
+#endif /*defined(OPTION_BLOCK_CACHE)*/
 
 
 /* Functions in module panel.c */
 void ARCH_DEP(display_inst) (REGS *regs, BYTE *inst);
 void display_inst (REGS *regs, BYTE *inst);
+#if defined(OPTION_TRACEBIN)
+void ARCH_DEP(tracebin_inst) (REGS *regs, BYTE *inst);
+#endif /*defined(OPTION_TRACEBIN)*/
 
 
 /* Functions in module sie.c */
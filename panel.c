@@ -266,7 +266,7 @@ static int      npquiet = 0;            /* screen updating flag      */
 
 static char *lmsbuf = NULL;             /* xxx                       */
 static int   lmsndx = 0;                /* xxx                       */
-static int   lmsnum = -1;               /* xxx                       */
+static U64   lmsseq = 0;                /* Next log sequence number  */
 static int   lmscnt = -1;               /* xxx                       */
 static int   lmsmax = LOG_DEFSIZE/2;    /* xxx                       */
 static int   keybfd = -1;               /* Keyboard file descriptor  */
@@ -2638,7 +2638,7 @@ FinishShutdown:
 
         if ( lmsndx >= lmscnt )  // (all previous data processed?)
         {
-            lmscnt = log_read( &lmsbuf, &lmsnum, LOG_NOBLOCK );
+            lmscnt = log_read_seq( &lmsbuf, &lmsseq );
             lmsndx = 0;
         }
         else if ( lmsndx >= lmsmax )
@@ -3050,7 +3050,7 @@ PANMSG* p;
     fwrite("\n",1,1,stderr);
 
     /* Read and display any msgs still remaining in the system log */
-    while((lmscnt = log_read(&lmsbuf, &lmsnum, LOG_NOBLOCK)))
+    while((lmscnt = log_read_seq(&lmsbuf, &lmsseq)))
         fwrite(lmsbuf,lmscnt,1,stderr);
 
     fflush(stderr);
@@ -245,7 +245,7 @@ static void* spthread (DEVBLK* dev)
 
     while ( !sysblk.shutdown && dev->fd == fd )
     {
-        if (dev->busy)
+        if (dev->busy || dev->spool.count)
         {
             SLEEP(3);
             continue;
@@ -299,6 +299,7 @@ static void* spthread (DEVBLK* dev)
     if (dev->fd == fd)
     {
         dev->fd = -1;
+        spool_detach( &dev->spool );
         close_socket( fd );
         logmsg (_("HHCPR016I %s (%s) disconnected from device %4.4X (%s)\n"),
             dev->bs->clientname, dev->bs->clientip, dev->devnum, dev->bs->spec);
@@ -320,6 +321,11 @@ char   *ptr;
 char   *nxt;
 int     sockdev = 0;                    /* 1 == is socket device     */
 
+    /* Finish any output written before a devinit */
+    if (spool_close (&dev->spool) < 0)
+        logmsg (_("HHCPR003E %4.4X Error writing to %s: %s\n"),
+                dev->devnum, dev->filename, strerror(errno));
+
     /* Forcibly disconnect anyone already currently connected */
     if (dev->bs && !unbind_device_ex(dev,1))
         return -1; // (error msg already issued)
@@ -346,6 +352,9 @@ int     sockdev = 0;                    /* 1 == is socket device     */
     dev->stopprt = 0;
     dev->notrunc = 0;
     dev->ispiped = (dev->filename[0] == '|');
+    dev->spool.fd = -1;
+    dev->spool.size = SPOOL_BUFSIZE;
+    dev->spool.compress = 0;
 
     /* initialize the new fields for FCB+ support */
     dev->fcbsupp = 1;
@@ -401,6 +410,30 @@ int     sockdev = 0;                    /* 1 == is socket device     */
             continue;
         }
 
+        if (strncasecmp("bufsize=", argv[iarg], 8) == 0)
+        {
+            ptr = argv[iarg]+8;
+            errno = 0;
+            dev->spool.size = (int) strtoul(ptr,&nxt,10);
+            if (errno != 0 || nxt == ptr || *nxt != 0
+             || dev->spool.size < 0 || dev->spool.size > SPOOL_MAXSIZE)
+            {
+                j = ptr - argv[iarg];
+                logmsg("HHCPR103E %d:%4.4X Printer: parameter %s in argument %d at position %d is invalid\n",
+                        SSID_TO_LCSS(dev->ssid), dev->devnum, argv[iarg], iarg + 1, j);
+                return -1;
+            }
+            continue;
+        }
+
+#if defined(HAVE_LIBZ)
+        if (strcasecmp(argv[iarg], "compress") == 0)
+        {
+            dev->spool.compress = 1;
+            continue;
+        }
+#endif /*defined(HAVE_LIBZ)*/
+
         if (strcasecmp(argv[iarg], "cc") == 0)
         {
             dev->cc = 1;
@@ -616,6 +649,13 @@ int     sockdev = 0;                    /* 1 == is socket device     */
         return -1;
     }
 
+    if (sockdev && dev->spool.compress)
+    {
+        logmsg("HHCPR104E %d:%4.4X Printer: option %s is incompatible\n",
+                SSID_TO_LCSS(dev->ssid), dev->devnum, "sockdev/compress");
+        return -1;
+    }
+
     /* If socket device, create a listening socket
        to accept connections on.
     */
@@ -656,13 +696,21 @@ int     sockdev = 0;                    /* 1 == is socket device     */
 static void printer_query_device (DEVBLK *dev, char **class,
                 int buflen, char *buffer)
 {
+char bufsize[20];                       /* bufsize= option           */
+
     BEGIN_DEVICE_CLASS_QUERY( "PRT", dev, class, buflen, buffer );
 
-    snprintf (buffer, buflen, "%s%s%s%s%s%s%s",
+    bufsize[0] = 0;
+    if (dev->spool.size != SPOOL_BUFSIZE)
+        snprintf (bufsize, sizeof(bufsize), " bufsize=%d", dev->spool.size);
+
+    snprintf (buffer, buflen, "%s%s%s%s%s%s%s%s%s",
                  dev->filename,
                 (dev->bs         ? " sockdev"      : ""),
                 (dev->crlf       ? " crlf"         : ""),
                 (dev->notrunc    ? " noclear"      : ""),
+                (dev->spool.compress ? " compress" : ""),
+                 bufsize,
                 (dev->rawcc      ? " rawcc"        : dev->browse  ? " brwse"    : " print"),
                 (dev->nofcbcheck ? " nofcbck"   : " fcbck"),
                 (dev->stopprt    ? " (stopped)"    : ""));
@@ -830,44 +878,36 @@ write_buffer (DEVBLK *dev, char *buf, int len, BYTE *unitstat)
 {
 int             rc;                     /* Return code               */
 
-    /* Write data to the printer file */
+    /* Queue data for the printer file */
+    rc = spool_write (&dev->spool, buf, len);
+    if (rc == 0)
+        return;
+
     if (dev->bs)
     {
-        /* (socket printer) */
-        rc = write_socket (dev->fd, buf, len);
-
-        /* Check for socket error */
-        if (rc < len)
+        /* Close the connection */
+        if (dev->fd != -1)
         {
-            /* Close the connection */
-            if (dev->fd != -1)
-            {
-                int fd = dev->fd;
-                dev->fd = -1;
-                close_socket( fd );
-                logmsg (_("HHCPR017I %s (%s) disconnected from device %4.4X (%s)\n"),
-                    dev->bs->clientname, dev->bs->clientip, dev->devnum, dev->bs->spec);
-            }
-
-            /* Set unit check with intervention required */
-            dev->sense[0] = SENSE_IR;
-            *unitstat = CSW_CE | CSW_DE | CSW_UC;
+            int fd = dev->fd;
+            dev->fd = -1;
+            spool_detach( &dev->spool );
+            close_socket( fd );
+            logmsg (_("HHCPR017I %s (%s) disconnected from device %4.4X (%s)\n"),
+                dev->bs->clientname, dev->bs->clientip, dev->devnum, dev->bs->spec);
         }
+
+        /* Set unit check with intervention required */
+        dev->sense[0] = SENSE_IR;
+        *unitstat = CSW_CE | CSW_DE | CSW_UC;
     }
     else
     {
-        /* Write data to the printer file */
-        rc = write (dev->fd, buf, len);
-
-        /* Equipment check if error writing to printer file */
-        if (rc < len)
-        {
-            logmsg (_("HHCPR003E %4.4X Error writing to %s: %s\n"),
-                    dev->devnum, dev->filename,
-                    (errno == 0 ? _("incomplete"): strerror(errno)));
-            dev->sense[0] = SENSE_EC;
-            *unitstat = CSW_CE | CSW_DE | CSW_UC;
-        }
+        /* Equipment check if error writing to printer file.  With
+           a buffer this may be the error of an earlier line */
+        logmsg (_("HHCPR003E %4.4X Error writing to %s: %s\n"),
+                dev->devnum, dev->filename, strerror(errno));
+        dev->sense[0] = SENSE_EC;
+        *unitstat = CSW_CE | CSW_DE | CSW_UC;
     }
 
 } /* end function write_buffer */
@@ -879,6 +919,11 @@ static int printer_close_device ( DEVBLK *dev )
 {
 int fd = dev->fd;
 
+    /* Write the buffered output and stop the flusher thread */
+    if (spool_close (&dev->spool) < 0 && fd != -1)
+        logmsg (_("HHCPR003E %4.4X Error writing to %s: %s\n"),
+                dev->devnum, dev->filename, strerror(errno));
+
     if (fd == -1)
         return 0;
 
@@ -951,6 +996,15 @@ char            wbuf[150];
             rc = 0;
     }
 
+    /* Start buffering output for a new file or connection */
+    if (rc == 0 && dev->fd >= 0 && dev->spool.fd != dev->fd)
+    {
+        rc = spool_open (&dev->spool, dev->fd, dev->bs != NULL);
+        if (rc < 0)
+            logmsg (_("HHCPR004E Error opening file %s: %s\n"),
+                    dev->filename, strerror(errno));
+    }
+
     if (rc < 0)
     {
         /* Set unit check with intervention required */
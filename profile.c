@@ -0,0 +1,506 @@
+/* PROFILE.C    (c)Copyright The Hercules Project, 2026              */
+/*              Sampling instruction profiler                        */
+
+/*-------------------------------------------------------------------*/
+/* While profiling is active the timer thread asks each running CPU  */
+/* for a sample every `interval' microseconds.  The CPU records the  */
+/* address and opcode of the next instruction it executes, and the   */
+/* host time taken to execute that one instruction.  Samples are     */
+/* accumulated by opcode and by guest instruction address.  They     */
+/* can be displayed with the `profile' command, viewed from the http */
+/* server, and written as folded stacks (flamegraph.pl, speedscope)  */
+/* or as a legacy pprof cpu profile.                                 */
+/*-------------------------------------------------------------------*/
+
+#include "hstdinc.h"
+
+#define _PROFILE_C_
+#define _HENGINE_DLL_
+
+#include "hercules.h"
+#include "opcode.h"
+
+#if defined(OPTION_INSTRUCTION_PROFILE)
+
+#define PROF_OPMAX      65536           /* Opcode table entries      */
+#define PROF_HOTMAX     8192            /* Address table entries     */
+#define PROF_HOTPROBE   16              /* Address table probes      */
+#define PROF_INTERVAL   1000            /* Default interval (usecs)  */
+#define PROF_SHOW       10              /* Default entries displayed */
+
+static LOCK      proflock;              /* Profile lock              */
+static PROFSTAT **profop;               /* Samples by opcode         */
+static PROFSTAT *profhot;               /* Samples by address        */
+static int       profactive;            /* 1=Sampling                */
+static int       profinterval = PROF_INTERVAL; /* Interval (usecs)   */
+static U64       profnext;              /* Time of next sample (us)  */
+static U64       profsamples;           /* Samples taken             */
+static U64       proflost;              /* Samples without an address
+                                           table entry               */
+
+/*-------------------------------------------------------------------*/
+/* Initialize the profiler                                           */
+/*-------------------------------------------------------------------*/
+void profile_init (void)
+{
+    initialize_lock (&proflock);
+}
+
+/*-------------------------------------------------------------------*/
+/* Host clock in nanoseconds                                         */
+/*-------------------------------------------------------------------*/
+U64 profile_clock (void)
+{
+#if defined(CLOCK_MONOTONIC)
+struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (U64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+struct timeval  tv;
+
+    gettimeofday (&tv, NULL);
+    return ((U64)tv.tv_sec * 1000000 + tv.tv_usec) * 1000;
+#endif
+}
+
+/*-------------------------------------------------------------------*/
+/* Opcode table index: first byte and any extended opcode            */
+/*-------------------------------------------------------------------*/
+static int profile_opkey (BYTE *inst)
+{
+    switch (inst[0]) {
+    case 0x01: case 0xA4: case 0xA6: case 0xB2: case 0xB3:
+    case 0xB9: case 0xE4: case 0xE5: case 0xE6:
+        return (inst[0] << 8) | inst[1];
+    case 0xA5: case 0xA7: case 0xC0: case 0xC2: case 0xC4:
+    case 0xC6: case 0xC8: case 0xCC:
+        return (inst[0] << 8) | (inst[1] & 0x0F);
+    case 0xE3: case 0xEB: case 0xEC: case 0xED:
+        return (inst[0] << 8) | inst[5];
+    default:
+        return inst[0] << 8;
+    }
+}
+
+/*-------------------------------------------------------------------*/
+/* Called by the timer thread: return 1 if a sample is due           */
+/*-------------------------------------------------------------------*/
+int profile_tick (void)
+{
+U64     now;                            /* Current time (usecs)      */
+
+    if (!profactive)
+        return 0;
+
+    now = host_tod();
+    if (now < profnext)
+        return 0;
+
+    profnext = now + profinterval;
+    return 1;
+}
+
+/*-------------------------------------------------------------------*/
+/* Record a sample for the instruction a CPU is about to execute     */
+/*-------------------------------------------------------------------*/
+void profile_sample (int cpuad, U64 addr, BYTE *inst)
+{
+PROFSTAT *op;                           /* -> Opcode entry           */
+PROFSTAT *hot;                          /* -> Address entry          */
+unsigned  i, n;                         /* Address table index       */
+
+    obtain_lock (&proflock);
+
+    if (!profactive)
+    {
+        release_lock (&proflock);
+        return;
+    }
+
+    profsamples++;
+
+    /* Count the sample for the opcode */
+    i = profile_opkey (inst);
+    if ((op = profop[i]) == NULL
+     && (op = profop[i] = calloc (1, sizeof(PROFSTAT))) != NULL)
+    {
+        op->cpuad = cpuad;
+        memcpy (op->inst, inst, ILC(inst[0]));
+    }
+    if (op)
+        op->samples++;
+
+    /* Count the sample for the address */
+    i = (unsigned)((addr >> 1) ^ (addr >> 13) ^ ((U64)cpuad << 7));
+    for (n = 0; n < PROF_HOTPROBE; n++, i++)
+    {
+        hot = &profhot[i & (PROF_HOTMAX - 1)];
+        if (hot->samples == 0)
+        {
+            hot->addr = addr;
+            hot->cpuad = cpuad;
+            memcpy (hot->inst, inst, ILC(inst[0]));
+            break;
+        }
+        if (hot->addr == addr && hot->cpuad == cpuad)
+            break;
+    }
+    if (n < PROF_HOTPROBE)
+        hot->samples++;
+    else
+        proflost++;
+
+    release_lock (&proflock);
+}
+
+/*-------------------------------------------------------------------*/
+/* Record the host time taken by a sampled instruction               */
+/*-------------------------------------------------------------------*/
+void profile_time (BYTE *inst, U64 nsecs)
+{
+PROFSTAT *op;                           /* -> Opcode entry           */
+int       i;                            /* Histogram bucket          */
+
+    obtain_lock (&proflock);
+
+    if (profactive && (op = profop[profile_opkey (inst)]) != NULL)
+    {
+        op->timed++;
+        op->nsecs += nsecs;
+        for (i = 0; i < PROF_HISTMAX - 1 && (nsecs >> i) > 1; i++);
+        op->hist[i]++;
+    }
+
+    release_lock (&proflock);
+}
+
+/*-------------------------------------------------------------------*/
+/* Fill in the mnemonic of an entry                                  */
+/*-------------------------------------------------------------------*/
+static void profile_mnemonic (PROFSTAT *stat)
+{
+char    buf[256];                       /* Disassembled instruction  */
+
+    buf[0] = '\0';
+    DISASM_INSTRUCTION(stat->inst, buf);
+    if (sscanf (buf, "%7s", stat->mnemonic) != 1 || stat->mnemonic[0] == '?')
+        snprintf (stat->mnemonic, sizeof(stat->mnemonic), "%2.2X", stat->inst[0]);
+}
+
+/*-------------------------------------------------------------------*/
+/* Sort entries by descending sample count                           */
+/*-------------------------------------------------------------------*/
+static int profile_compare (const void *a, const void *b)
+{
+const PROFSTAT *x = a, *y = b;
+
+    return x->samples < y->samples ? 1 : x->samples > y->samples ? -1 : 0;
+}
+
+/*-------------------------------------------------------------------*/
+/* Return a sorted copy of the opcode or address entries             */
+/*-------------------------------------------------------------------*/
+/* The number of entries is returned; *stat must be freed by the     */
+/* caller when it is not NULL.                                       */
+/*-------------------------------------------------------------------*/
+static int profile_copy (PROFSTAT **stat, int byaddr)
+{
+PROFSTAT *copy;                         /* -> Copied entries         */
+int       i, n = 0;                     /* Entry counts              */
+
+    *stat = NULL;
+
+    obtain_lock (&proflock);
+
+    if (profop == NULL
+     || (copy = malloc ((byaddr ? PROF_HOTMAX : PROF_OPMAX)
+                        * sizeof(PROFSTAT))) == NULL)
+    {
+        release_lock (&proflock);
+        return 0;
+    }
+
+    if (byaddr)
+    {
+        for (i = 0; i < PROF_HOTMAX; i++)
+            if (profhot[i].samples)
+                copy[n++] = profhot[i];
+    }
+    else
+    {
+        for (i = 0; i < PROF_OPMAX; i++)
+            if (profop[i] && profop[i]->samples)
+                copy[n++] = *profop[i];
+    }
+
+    release_lock (&proflock);
+
+    qsort (copy, n, sizeof(PROFSTAT), profile_compare);
+    for (i = 0; i < n; i++)
+        profile_mnemonic (&copy[i]);
+
+    *stat = copy;
+    return n;
+}
+
+int profile_opcodes (PROFSTAT **stat)
+{
+    return profile_copy (stat, 0);
+}
+
+int profile_addrs (PROFSTAT **stat)
+{
+    return profile_copy (stat, 1);
+}
+
+/*-------------------------------------------------------------------*/
+/* Return the number of samples and the profiling state              */
+/*-------------------------------------------------------------------*/
+U64 profile_samples (int *active, int *interval, U64 *lost)
+{
+    if (active)   *active = profactive;
+    if (interval) *interval = profinterval;
+    if (lost)     *lost = proflost;
+    return profsamples;
+}
+
+/*-------------------------------------------------------------------*/
+/* Discard all samples                                               */
+/*-------------------------------------------------------------------*/
+static void profile_clear (void)
+{
+int     i;                              /* Opcode index              */
+
+    if (profop)
+        for (i = 0; i < PROF_OPMAX; i++)
+        {
+            free (profop[i]);
+            profop[i] = NULL;
+        }
+    if (profhot)
+        memset (profhot, 0, PROF_HOTMAX * sizeof(PROFSTAT));
+    profsamples = proflost = 0;
+}
+
+/*-------------------------------------------------------------------*/
+/* Host nanoseconds below which `pct' percent of timed samples fall  */
+/*-------------------------------------------------------------------*/
+U64 profile_pct (PROFSTAT *stat, int pct)
+{
+U64     n = 0;                          /* Samples so far            */
+int     i;                              /* Histogram bucket          */
+
+    for (i = 0; i < PROF_HISTMAX; i++)
+        if ((n += stat->hist[i]) * 100 >= stat->timed * pct)
+            break;
+    return (U64)2 << (i < PROF_HISTMAX ? i : PROF_HISTMAX - 1);
+}
+
+/*-------------------------------------------------------------------*/
+/* Display the most sampled opcodes and addresses                    */
+/*-------------------------------------------------------------------*/
+static void profile_display (int max)
+{
+PROFSTAT *stat;                         /* -> Sorted entries         */
+int       i, n;                         /* Entry counts              */
+U64       total;                        /* Total samples             */
+
+    total = profsamples;
+
+    logmsg (_("HHCPF006I Profiling %s, interval %d usecs, "
+              "%" I64_FMT "u samples, %" I64_FMT "u without address\n"),
+            profactive ? _("active") : _("stopped"), profinterval,
+            total, proflost);
+
+    if (total == 0)
+        return;
+
+    n = profile_opcodes (&stat);
+    logmsg (_("HHCPF007I Opcode     Samples      %%   Avg ns  50%% ns  99%% ns\n"));
+    for (i = 0; i < n && i < max; i++)
+        logmsg (_("HHCPF007I %-8s %8" I64_FMT "u %6.2f %8" I64_FMT "u"
+                  " %7" I64_FMT "u %7" I64_FMT "u\n"),
+                stat[i].mnemonic, stat[i].samples,
+                (stat[i].samples * 100.0) / total,
+                stat[i].timed ? stat[i].nsecs / stat[i].timed : 0,
+                stat[i].timed ? profile_pct (&stat[i], 50) : 0,
+                stat[i].timed ? profile_pct (&stat[i], 99) : 0);
+    free (stat);
+
+    n = profile_addrs (&stat);
+    logmsg (_("HHCPF008I CPU  Address          Opcode    Samples      %%\n"));
+    for (i = 0; i < n && i < max; i++)
+        logmsg (_("HHCPF008I %4.4X %16.16" I64_FMT "X %-8s %8" I64_FMT "u %6.2f\n"),
+                stat[i].cpuad, stat[i].addr, stat[i].mnemonic,
+                stat[i].samples, (stat[i].samples * 100.0) / total);
+    free (stat);
+}
+
+/*-------------------------------------------------------------------*/
+/* Write a legacy pprof cpu profile word                             */
+/*-------------------------------------------------------------------*/
+static void profile_word (FILE *f, uintptr_t word)
+{
+    fwrite (&word, sizeof(word), 1, f);
+}
+
+/*-------------------------------------------------------------------*/
+/* Write the address samples to a file                               */
+/*-------------------------------------------------------------------*/
+/* Folded stacks have one line per address, `CPnnnn;mnemonic;address */
+/* samples', for flamegraph.pl and similar tools.  The pprof format  */
+/* is the legacy binary cpu profile, with the guest instruction      */
+/* address as a one frame stack.                                     */
+/*-------------------------------------------------------------------*/
+static int profile_dump (char *fn, int pprof)
+{
+PROFSTAT *stat;                         /* -> Sorted entries         */
+FILE     *f;                            /* Output file               */
+char      pathname[MAX_PATH];           /* Host path name            */
+int       i, n;                         /* Entry counts              */
+
+    hostpath (pathname, fn, sizeof(pathname));
+    if ((f = fopen (pathname, pprof ? "wb" : "w")) == NULL)
+    {
+        logmsg (_("HHCPF009E Profile file %s open error: %s\n"),
+                fn, strerror(errno));
+        return -1;
+    }
+
+    n = profile_addrs (&stat);
+
+    if (pprof)
+    {
+        /* Header: count, words, version, period, padding */
+        profile_word (f, 0);
+        profile_word (f, 3);
+        profile_word (f, 0);
+        profile_word (f, profinterval);
+        profile_word (f, 0);
+        for (i = 0; i < n; i++)
+        {
+            profile_word (f, (uintptr_t)stat[i].samples);
+            profile_word (f, 1);
+            profile_word (f, (uintptr_t)stat[i].addr);
+        }
+        /* Trailer */
+        profile_word (f, 0);
+        profile_word (f, 1);
+        profile_word (f, 0);
+    }
+    else
+    {
+        for (i = 0; i < n; i++)
+            fprintf (f, "CP%4.4X;%s;%" I64_FMT "X %" I64_FMT "u\n",
+                     stat[i].cpuad, stat[i].mnemonic,
+                     stat[i].addr, stat[i].samples);
+    }
+
+    free (stat);
+
+    n = ferror (f) ? -1 : n;
+    if (fclose (f) != 0 || n < 0)
+    {
+        logmsg (_("HHCPF010E Profile file %s write error: %s\n"),
+                fn, strerror(errno));
+        return -1;
+    }
+
+    logmsg (_("HHCPF011I %d profile records written to %s\n"), n, fn);
+    return 0;
+}
+
+/*-------------------------------------------------------------------*/
+/* profile command                                                   */
+/*-------------------------------------------------------------------*/
+int profile_cmd (int argc, char *argv[], char *cmdline)
+{
+int     n;                              /* Numeric operand           */
+char    c;                              /* Trailing character        */
+
+    UNREFERENCED(cmdline);
+
+    if (argc < 2 || strcasecmp (argv[1], "show") == 0)
+    {
+        n = PROF_SHOW;
+        if (argc > 2 && (sscanf (argv[2], "%d%c", &n, &c) != 1 || n < 1))
+        {
+            logmsg (_("HHCPF004E Invalid profile operand %s\n"), argv[2]);
+            return -1;
+        }
+        profile_display (n);
+        return 0;
+    }
+
+    if (strcasecmp (argv[1], "start") == 0)
+    {
+        n = profinterval;
+        if (argc > 2 && (sscanf (argv[2], "%d%c", &n, &c) != 1 || n < 1))
+        {
+            logmsg (_("HHCPF004E Invalid profile operand %s\n"), argv[2]);
+            return -1;
+        }
+
+        obtain_lock (&proflock);
+        if (profop == NULL)
+        {
+            profop = calloc (PROF_OPMAX, sizeof(PROFSTAT *));
+            profhot = calloc (PROF_HOTMAX, sizeof(PROFSTAT));
+            if (profop == NULL || profhot == NULL)
+            {
+                free (profop);
+                free (profhot);
+                profop = NULL;
+                profhot = NULL;
+                release_lock (&proflock);
+                logmsg (_("HHCPF005E Profile storage allocation failed: %s\n"),
+                        strerror(errno));
+                return -1;
+            }
+        }
+        profinterval = n;
+        profnext = 0;
+        profactive = 1;
+        release_lock (&proflock);
+
+        logmsg (_("HHCPF001I Profiling started, interval %d usecs\n"),
+                profinterval);
+        return 0;
+    }
+
+    if (strcasecmp (argv[1], "stop") == 0)
+    {
+        obtain_lock (&proflock);
+        profactive = 0;
+        release_lock (&proflock);
+        logmsg (_("HHCPF002I Profiling stopped\n"));
+        return 0;
+    }
+
+    if (strcasecmp (argv[1], "reset") == 0)
+    {
+        obtain_lock (&proflock);
+        profile_clear ();
+        release_lock (&proflock);
+        logmsg (_("HHCPF003I Profile samples discarded\n"));
+        return 0;
+    }
+
+    if (strcasecmp (argv[1], "dump") == 0 && argc > 2 && argc < 5)
+    {
+        if (argc > 3 && strcasecmp (argv[3], "pprof") != 0
+                     && strcasecmp (argv[3], "folded") != 0)
+        {
+            logmsg (_("HHCPF004E Invalid profile operand %s\n"), argv[3]);
+            return -1;
+        }
+        return profile_dump (argv[2],
+                             argc > 3 && strcasecmp (argv[3], "pprof") == 0);
+    }
+
+    logmsg (_("HHCPF004E Invalid profile operand %s\n"), argv[1]);
+    return -1;
+}
+
+#endif /* defined(OPTION_INSTRUCTION_PROFILE) */
@@ -0,0 +1,97 @@
+/* QDIO.H       (c)Copyright The Hercules Project, 2026              */
+/*              Queued Direct Input Output                           */
+
+/* This header contains the formats of the control blocks which the  */
+/* program and a QDIO adapter share in main storage: the Queue       */
+/* Description Record passed on ESTABLISH QUEUES, and for each queue */
+/* the Storage List (SL) of Storage Block Address Lists (SBALs) and  */
+/* the Storage List State Block (SLSB) through which ownership of    */
+/* each buffer passes between program and adapter.                  */
+
+#if !defined(_QDIO_H)
+#define _QDIO_H
+
+#define QDIO_MAXQ       32              /* Max input/output queues   */
+#define QDIO_BUFFERS    128             /* SBALs per queue           */
+#define QDIO_ENTRIES    16              /* Entries per SBAL          */
+
+
+/*-------------------------------------------------------------------*/
+/* Queue Description Record                                          */
+/*-------------------------------------------------------------------*/
+typedef struct _QDIO_QDR {
+        BYTE    qfmt;                   /* Queue format              */
+        BYTE    resv001[2];
+        BYTE    iqdcnt;                 /* Input queue desc count    */
+        BYTE    resv004[3];
+        BYTE    oqdcnt;                 /* Output queue desc count   */
+        BYTE    resv008;
+        BYTE    iqdsz;                  /* Input desc size (words)   */
+        BYTE    resv00a;
+        BYTE    oqdsz;                  /* Output desc size (words)  */
+        BYTE    resv00c[36];
+        DBLWRD  qiba;                   /* Queue info block address  */
+        BYTE    resv038[4];
+        BYTE    qkey;                   /* QIB key (bits 0-3)        */
+        BYTE    resv03d[3];
+                                        /* Input then output queue
+                                           descriptors follow        */
+    } QDIO_QDR;
+
+#define QDR_QFMT_OSA    0x00            /* OSA Express (format 0)    */
+
+
+/*-------------------------------------------------------------------*/
+/* Queue Descriptor format 0                                         */
+/*-------------------------------------------------------------------*/
+typedef struct _QDIO_QDES0 {
+        DBLWRD  sliba;                  /* SL information block addr */
+        DBLWRD  sla;                    /* Storage list address      */
+        DBLWRD  slsba;                  /* SL state block address    */
+        BYTE    resv018[4];
+        BYTE    keyp1;                  /* SLIB key / SL key         */
+        BYTE    keyp2;                  /* SBAL key / SLSB key       */
+        BYTE    resv01e[2];
+    } QDIO_QDES0;
+
+#define QDES_KEY_HI(_k) ((_k) & 0xF0)   /* akey or ckey              */
+#define QDES_KEY_LO(_k) (((_k) & 0x0F) << 4) /* bkey or dkey         */
+
+
+/*-------------------------------------------------------------------*/
+/* Storage Block Address List Entry                                  */
+/*-------------------------------------------------------------------*/
+typedef struct _QDIO_SBALE {
+        BYTE    flags[4];               /* Entry and SBAL flags      */
+        FWORD   length;                 /* Length of storage block   */
+        DBLWRD  addr;                   /* Absolute address of block */
+    } QDIO_SBALE;
+
+/* Bit definitions for flags[0] */
+#define SBALE_F0_LAST   0x40            /* Last entry in SBAL        */
+#define SBALE_F0_CONT   0x20            /* Contiguous with next      */
+#define SBALE_F0_FRAG   0x0C            /* Fragment type mask        */
+#define SBALE_F0_FIRST  0x04            /* First fragment of packet  */
+#define SBALE_F0_MIDDLE 0x08            /* Middle fragment           */
+#define SBALE_F0_LASTF  0x0C            /* Last fragment of packet   */
+
+/* Bit definitions for flags[3] of the first entry (SBAL flags) */
+#define SBAL_F3_PCI     0x40            /* PCI requested on output   */
+
+
+/*-------------------------------------------------------------------*/
+/* Storage List State Block buffer states                            */
+/*-------------------------------------------------------------------*/
+#define SLSB_OWNER_PROG 0x80            /* Owned by program          */
+#define SLSB_OWNER_CU   0x40            /* Owned by adapter          */
+#define SLSB_TYPE_OUT   0x20            /* Output queue              */
+#define SLSB_STATE      0x0F            /* State mask                */
+
+#define SLSB_CU_INPUT_EMPTY     0x41    /* Empty, given to adapter   */
+#define SLSB_P_INPUT_PRIMED     0x82    /* Filled, given to program  */
+#define SLSB_P_INPUT_ERROR      0x8F    /* Input error               */
+#define SLSB_CU_OUTPUT_PRIMED   0x62    /* Filled, given to adapter  */
+#define SLSB_P_OUTPUT_EMPTY     0xA1    /* Sent, given to program    */
+#define SLSB_P_OUTPUT_ERROR     0xAF    /* Output error              */
+
+#endif /*!defined(_QDIO_H)*/
@@ -6,11 +6,53 @@
 
 /* Device module hdtqeth.dll devtype QETH (config)                   */
 /* hercules.cnf:                                                     */
-/* 0A00-0A02 QETH <optional parameters>                              */
+/* 0A00-0A02 QETH [-n tundev] [-l 2|3] [-t mtu] [-s netmask]         */
+/*                [-p buffers] [-w usecs] [-d] [guestip [hostip]]    */
+
+/* The three devices of the group are the read, write and data       */
+/* devices.  ESTABLISH QUEUES on the data device names the storage   */
+/* list and SLSB of each queue, and its ACTIVATE QUEUES channel      */
+/* program then stays active, the device thread moving frames from   */
+/* the TUN (layer 3) or TAP (layer 2) interface into the input       */
+/* buffers the program has primed, until halted or cleared.  SIGA-w  */
+/* sends the primed output buffers.  Both directions use readv and   */
+/* writev on the storage blocks named by the SBAL entries, so frames */
+/* are never copied.  Primed input buffers are signalled with a PCI  */
+/* once -p buffers are waiting or the oldest has waited -w usecs.    */
+
+/* The read and write devices carry the control exchanges.  Each is  */
+/* first activated by writing IDX ACTIVATE and reading the reply.    */
+/* The MPC setup messages (CM ENABLE and SETUP, ULP ENABLE and       */
+/* SETUP, DM ACTIVATE) and the IP assist commands are then written   */
+/* to the write device, and their replies read from the read device. */
+/* Only the IPA commands a driver needs to bring the interface up    */
+/* are answered; others are returned as unsupported.                 */
 
 #include "hstdinc.h"
 #include "hercules.h"
 #include "devtype.h"
+#include "tuntap.h"
+#include "hercifc.h"
+#include "qeth.h"
+
+#if defined(OPTION_W32_CTCI)
+ /* No scatter/gather TUN/TAP i/o: frames are consumed and discarded */
+ typedef struct _OSAIOV { void *iov_base; size_t iov_len; } OSAIOV;
+#else
+ #define OSAIOV struct iovec
+#endif
+
+#define QETH_POLL_USECS 1000000         /* Idle halt/clear poll      */
+#define QETH_BLOCKED_USECS 10000        /* Input buffer poll         */
+
+/* Tokens and level the adapter returns in its control replies */
+#define QETH_TOKEN_RM_READ    0x00010001  /* IDX ACTIVATE read       */
+#define QETH_TOKEN_RM_WRITE   0x00010002  /* IDX ACTIVATE write      */
+#define QETH_TOKEN_CM_FILTER  0x00020001  /* CM ENABLE               */
+#define QETH_TOKEN_CM_CONN    0x00020002  /* CM SETUP                */
+#define QETH_TOKEN_ULP_FILTER 0x00030001  /* ULP ENABLE              */
+#define QETH_TOKEN_ULP_CONN   0x00030002  /* ULP SETUP               */
+#define QETH_UCLEVEL          0x00000001  /* Microcode level         */
 
 
 #if defined(WIN32) && defined(OPTION_DYNAMIC_LOAD) && !defined(HDL_USE_LIBTOOL) && !defined(_MSVC_)
@@ -23,24 +65,1279 @@ static BYTE sense_id_bytes[] = { 0xff,
                                  0x17, 0x31, 0x01,            /* D/T */
                                  0x17, 0x32, 0x01,           /* CU/T */
                                  0x00,
-                                 0x40, 0xfa, 0x01, 0x00,  /* RCD CIW */
-                                 0x03, 0xfc, 0x01, 0x00, /*Ena Q CIW */
-                                 0x04, 0xfd, 0x01, 0x00 /* Act Q CIW */
+                                 0x40, OSA_RCD, 0x01, 0x00, /* RCD CIW */
+                                 0x43, OSA_EQ, 0x10, 0x00, /* Est Q CIW */
+                                 0x44, OSA_AQ, 0x00, 0x00  /* Act Q CIW */
                                };
 
 
+/*-------------------------------------------------------------------*/
+/* Host time in microseconds, for PCI thresholding                   */
+/*-------------------------------------------------------------------*/
+static U64 qeth_usecs(void)
+{
+struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return (U64)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Validate adapter access to main storage                           */
+/* Returns a pointer to the area, or NULL if it is outside main      */
+/* storage or protected against the access key.  Reference, and for  */
+/* a store access change, bits are set for the area.                 */
+/*-------------------------------------------------------------------*/
+static BYTE *qeth_storage(DEVBLK *dev, U64 addr, U32 len, BYTE key,
+                                                            int store)
+{
+U64     unit;                           /* Storage key unit address  */
+BYTE   *sk;                             /* -> Storage key            */
+
+    if (len == 0 || addr > dev->mainlim || len - 1 > dev->mainlim - addr)
+        return NULL;
+
+    for (unit = addr & ~(U64)(STORAGE_KEY_UNITSIZE - 1);
+         unit < addr + len; unit += STORAGE_KEY_UNITSIZE)
+    {
+        sk = dev->storkeys + unit / STORAGE_KEY_UNITSIZE;
+        if (key && (*sk & STORKEY_KEY) != key
+         && (store || (*sk & STORKEY_FETCH)))
+            return NULL;
+        *sk |= store ? (STORKEY_REF | STORKEY_CHANGE) : STORKEY_REF;
+    }
+
+    return dev->mainstor + addr;
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Set the change bits of an area once the adapter has stored into   */
+/* it, so that the store is not hidden by a reset of the change bits */
+/* while it was in progress                                          */
+/*-------------------------------------------------------------------*/
+static void qeth_changed(BYTE *addr, U32 len)
+{
+U64     unit;                           /* Storage key unit          */
+
+    if (len == 0)
+        return;
+
+    for (unit = (U64)(addr - sysblk.mainstor) / STORAGE_KEY_UNITSIZE;
+         unit <= (U64)(addr + len - 1 - sysblk.mainstor)
+                 / STORAGE_KEY_UNITSIZE; unit++)
+        sysblk.storkeys[unit] |= STORKEY_CHANGE;
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Locate SBAL n of a queue through the queue's storage list         */
+/*-------------------------------------------------------------------*/
+static BYTE *qeth_sbal(DEVBLK *dev, OSAQUE *que, int n, int store)
+{
+BYTE   *sl;                             /* -> Storage list entry     */
+U64     sbala;                          /* SBAL address              */
+
+    if (!(sl = qeth_storage(dev, que->sla + n * 8, 8, que->slkey, 0)))
+        return NULL;
+    FETCH_DW(sbala, sl);
+
+    return qeth_storage(dev, sbala, QDIO_ENTRIES * sizeof(QDIO_SBALE),
+                        que->sbalkey, store);
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Pass a buffer to the program, unless it has taken it back         */
+/*-------------------------------------------------------------------*/
+static void qeth_set_slsb(OSAQUE *que, int n, BYTE old, BYTE new)
+{
+    if (cmpxchg1(&old, new, que->slsb + n) == 0)
+        qeth_changed(que->slsb + n, 1);
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Present a PCI for the active ACTIVATE QUEUES channel program      */
+/*-------------------------------------------------------------------*/
+static void qeth_raise_pci(DEVBLK *dev, OSAGRP *grp)
+{
+U32     ccwaddr;                        /* Address of AQ CCW         */
+
+    obtain_lock (&dev->lock);
+
+    if ((dev->scsw.flag2 & SCSW2_Q) == 0)
+    {
+        release_lock (&dev->lock);
+        return;
+    }
+
+    FETCH_FW(ccwaddr, dev->orb.ccwaddr);
+    dev->pciscsw.flag0 = dev->orb.flag4 & SCSW0_KEY;
+    dev->pciscsw.flag1 = (dev->orb.flag5 & ORB5_F) ? SCSW1_F : 0;
+    dev->pciscsw.flag2 = SCSW2_FC_START;
+    dev->pciscsw.flag3 = SCSW3_AC_SCHAC | SCSW3_AC_DEVAC
+                       | SCSW3_SC_INTER | SCSW3_SC_PEND;
+    STORE_FW(dev->pciscsw.ccwaddr, ccwaddr + 8);
+    dev->pciscsw.unitstat = 0;
+    dev->pciscsw.chanstat = CSW_PCI;
+    store_hw (dev->pciscsw.count, 0);
+
+    QUEUE_IO_INTERRUPT(&dev->pciioint);
+    grp->pcis++;
+
+    release_lock (&dev->lock);
+
+    OBTAIN_INTLOCK(devregs(dev));
+    UPDATE_IC_IOPENDING();
+    RELEASE_INTLOCK(devregs(dev));
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Process ESTABLISH QUEUES: record the queues the QDR describes     */
+/*-------------------------------------------------------------------*/
+static int qeth_establish_queues(DEVBLK *dev, OSAGRP *grp,
+                                 BYTE *iobuf, U16 count)
+{
+QDIO_QDR   *qdr = (QDIO_QDR*)iobuf;     /* -> Queue description rec  */
+QDIO_QDES0 *qdes;                       /* -> Queue descriptor       */
+OSAQUE     *que;                        /* -> Queue                  */
+int         isz, osz;                   /* Descriptor sizes          */
+int         i;
+U64         sla, slsba;                 /* SL and SLSB addresses     */
+
+    if (count < sizeof(QDIO_QDR) || qdr->qfmt != QDR_QFMT_OSA)
+        return -1;
+
+    isz = qdr->iqdsz << 2;
+    osz = qdr->oqdsz << 2;
+
+    if (qdr->iqdcnt == 0 || qdr->iqdcnt > QDIO_MAXQ
+     || qdr->oqdcnt == 0 || qdr->oqdcnt > QDIO_MAXQ
+     || isz < (int)sizeof(QDIO_QDES0) || osz < (int)sizeof(QDIO_QDES0)
+     || sizeof(QDIO_QDR) + qdr->iqdcnt * isz + qdr->oqdcnt * osz > count)
+        return -1;
+
+    qdes = (QDIO_QDES0*)(iobuf + sizeof(QDIO_QDR));
+
+    for (i = 0; i < qdr->iqdcnt + qdr->oqdcnt; i++)
+    {
+        que = i < qdr->iqdcnt ? &grp->iq[i] : &grp->oq[i - qdr->iqdcnt];
+
+        FETCH_DW(sla, qdes->sla);
+        FETCH_DW(slsba, qdes->slsba);
+
+        que->slkey = QDES_KEY_LO(qdes->keyp1);
+        que->sbalkey = QDES_KEY_HI(qdes->keyp2);
+        que->next = 0;
+
+        if (!qeth_storage(dev, sla, QDIO_BUFFERS * 8, que->slkey, 0)
+         || !(que->slsb = qeth_storage(dev, slsba, QDIO_BUFFERS,
+                                       QDES_KEY_LO(qdes->keyp2), 1)))
+            return -1;
+        que->sla = sla;
+
+        qdes = (QDIO_QDES0*)((BYTE*)qdes
+                             + (i < qdr->iqdcnt ? isz : osz));
+    }
+
+    grp->iqcnt = qdr->iqdcnt;
+    grp->oqcnt = qdr->oqdcnt;
+    grp->ibuf = -1;
+    grp->ipend = 0;
+    grp->established = 1;
+
+    if (grp->debug)
+        logmsg(_("HHCQE010I %4.4X: %d input and %d output queues "
+                 "established\n"), dev->devnum, grp->iqcnt, grp->oqcnt);
+
+    return 0;
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Hand input buffer n, which can not hold a frame, back in error    */
+/*-------------------------------------------------------------------*/
+static void qeth_reject_input(OSAGRP *grp, int n)
+{
+OSAQUE     *que = &grp->iq[0];          /* -> Input queue            */
+
+    qeth_set_slsb(que, n, SLSB_CU_INPUT_EMPTY, SLSB_P_INPUT_ERROR);
+    que->next = (n + 1) % QDIO_BUFFERS;
+    grp->ibuf = -1;
+
+    if (!grp->ipend++)
+        grp->ipendtime = qeth_usecs();
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Take the next input buffer the program has given to the adapter   */
+/* Returns 0 if there is none                                        */
+/*-------------------------------------------------------------------*/
+static int qeth_open_input(DEVBLK *dev, OSAGRP *grp)
+{
+OSAQUE     *que = &grp->iq[0];          /* -> Input queue            */
+QDIO_SBALE *sbale;                      /* -> SBAL entry             */
+U64         addr;                       /* Storage block address     */
+U32         len;                        /* Storage block length      */
+int         i;
+
+    while (que->slsb[que->next] == SLSB_CU_INPUT_EMPTY)
+    {
+        grp->ielems = 0;
+
+        if ((grp->isbal = qeth_sbal(dev, que, que->next, 1)))
+        {
+            sbale = (QDIO_SBALE*)grp->isbal;
+            for (i = 0; i < QDIO_ENTRIES; i++, sbale++)
+            {
+                FETCH_DW(addr, sbale->addr);
+                FETCH_FW(len, sbale->length);
+                if (!(grp->iaddr[i] = qeth_storage(dev, addr, len,
+                                                   que->sbalkey, 1)))
+                    break;
+                grp->icap[i] = len;
+                grp->iused[i] = 0;
+                grp->ielems = i + 1;
+                if (sbale->flags[0] & SBALE_F0_LAST)
+                    break;
+            }
+        }
+
+        if (grp->ielems && grp->icap[0] >= OSA_HDR_SIZE)
+        {
+            grp->ibuf = que->next;
+            grp->ielem = 0;
+            grp->ioff = 0;
+            return 1;
+        }
+
+        /* Not a usable buffer: hand it straight back in error */
+        qeth_reject_input(grp, que->next);
+    }
+
+    return 0;
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Hand the input buffer being filled to the program                 */
+/*-------------------------------------------------------------------*/
+static void qeth_prime_input(OSAGRP *grp)
+{
+OSAQUE     *que = &grp->iq[0];          /* -> Input queue            */
+QDIO_SBALE *sbale = (QDIO_SBALE*)grp->isbal;
+int         last;                       /* Last entry holding data   */
+int         i;
+
+    last = grp->ioff ? grp->ielem : grp->ielem - 1;
+
+    for (i = 0; i <= last; i++)
+    {
+        STORE_FW(sbale[i].length, grp->iused[i]);
+        sbale[i].flags[0] = (i == last) ? SBALE_F0_LAST : 0;
+        qeth_changed(grp->iaddr[i], grp->iused[i]);
+    }
+    qeth_changed(grp->isbal, (last + 1) * sizeof(QDIO_SBALE));
+
+    qeth_set_slsb(que, grp->ibuf, SLSB_CU_INPUT_EMPTY, SLSB_P_INPUT_PRIMED);
+    que->next = (grp->ibuf + 1) % QDIO_BUFFERS;
+    grp->ibuf = -1;
+
+    if (!grp->ipend++)
+        grp->ipendtime = qeth_usecs();
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Build the OSA header for a frame received from the interface      */
+/*-------------------------------------------------------------------*/
+static void qeth_build_header(OSAGRP *grp, BYTE *hdr, OSAIOV *iov,
+                              int len)
+{
+BYTE   *frame = iov->iov_base;          /* -> Start of frame         */
+int     flen = (int)iov->iov_len;       /* Bytes at frame            */
+static const BYTE bcast[6] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+
+    memset(hdr, 0, OSA_HDR_SIZE);
+
+    if (grp->layer == 2)
+    {
+    OSA_HDR2 *hdr2 = (OSA_HDR2*)hdr;
+
+        hdr2->id = OSA_HDR_ID_L2;
+        if (flen >= 6 && (frame[0] & 0x01))
+            hdr2->flags[2] = memcmp(frame, bcast, 6) ? OSA_HDR2_MCAST
+                                                     : OSA_HDR2_BCAST;
+        else
+            hdr2->flags[2] = OSA_HDR2_UCAST;
+        STORE_HW(hdr2->pktlen, len);
+    }
+    else
+    {
+    OSA_HDR3 *hdr3 = (OSA_HDR3*)hdr;
+
+        hdr3->id = OSA_HDR_ID_L3;
+        if (flen >= 40 && (frame[0] >> 4) == 6)
+            hdr3->flags = OSA_HDR3_IPV6 | (frame[24] == 0xFF ?
+                                      OSA_HDR3_MCAST : OSA_HDR3_UCAST);
+        else if (flen >= 20 && (frame[16] & 0xF0) == 0xE0)
+            hdr3->flags = OSA_HDR3_MCAST;
+        else if (flen >= 20 && !memcmp(frame + 16, bcast, 4))
+            hdr3->flags = OSA_HDR3_BCAST;
+        else
+            hdr3->flags = OSA_HDR3_UCAST;
+        STORE_HW(hdr3->length, len);
+    }
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Read frames from the interface straight into the input buffers    */
+/* Returns 1 if reading stopped because the program has no empty     */
+/* buffers, 0 if the interface has no more frames.                   */
+/*-------------------------------------------------------------------*/
+static int qeth_read_input(DEVBLK *dev, OSAGRP *grp)
+{
+OSAIOV  iov[QDIO_ENTRIES];              /* Free space in the buffer  */
+BYTE   *hdr;                            /* -> Header for next frame  */
+int     cnt;                            /* Number of iov entries     */
+U32     cap;                            /* Bytes available           */
+int     e;                              /* Entry for next frame      */
+U32     off;                            /* Offset in that entry      */
+U32     len;                            /* Bytes placed              */
+int     n;
+
+    for (;;)
+    {
+        if (grp->ibuf < 0 && !qeth_open_input(dev, grp))
+            return 1;
+
+        /* The header may not span storage blocks */
+        for (e = grp->ielem, off = grp->ioff;
+             e < grp->ielems && grp->icap[e] - off < OSA_HDR_SIZE;
+             e++, off = 0);
+
+        cnt = 0;
+        cap = 0;
+        hdr = NULL;
+        if (e < grp->ielems)
+        {
+            hdr = grp->iaddr[e] + off;
+            iov[0].iov_base = hdr + OSA_HDR_SIZE;
+            iov[0].iov_len = cap = grp->icap[e] - off - OSA_HDR_SIZE;
+            for (cnt = 1; e + cnt < grp->ielems
+                       && cap < (U32)grp->maxframe; cnt++)
+            {
+                iov[cnt].iov_base = grp->iaddr[e + cnt];
+                iov[cnt].iov_len = grp->icap[e + cnt];
+                cap += grp->icap[e + cnt];
+            }
+        }
+
+        /* Hand over the buffer once another frame might not fit,
+           or back in error if it can not hold even one, so that
+           the interface is never read with no room for a frame */
+        if (cap < (U32)grp->maxframe)
+        {
+            if (grp->ielem || grp->ioff)
+                qeth_prime_input(grp);
+            else
+                qeth_reject_input(grp, grp->ibuf);
+            continue;
+        }
+
+#if defined(OPTION_W32_CTCI)
+        n = -1;
+        errno = EAGAIN;
+#else
+        n = readv(grp->fd, iov, cnt);
+#endif
+        if (n <= 0)
+        {
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK
+             && errno != EINTR)
+                grp->rxdrops++;
+            else if (grp->ielem || grp->ioff)
+                qeth_prime_input(grp);
+            return 0;
+        }
+
+        qeth_build_header(grp, hdr, iov, n);
+
+        if (grp->debug)
+            logmsg(_("HHCQE011I %4.4X: Received %d byte frame "
+                     "into buffer %d\n"), dev->devnum, n, grp->ibuf);
+
+        /* Advance past the header and frame */
+        for (len = OSA_HDR_SIZE + n; ; e++, off = 0)
+        {
+            if (len <= grp->icap[e] - off)
+            {
+                off += len;
+                break;
+            }
+            len -= grp->icap[e] - off;
+            grp->iused[e] = grp->icap[e];
+        }
+        grp->iused[e] = off;
+        grp->ielem = e;
+        grp->ioff = off;
+
+        grp->rxframes++;
+        grp->rxbytes += n;
+    }
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Check the OSA header of an outbound packet                        */
+/* Returns the packet length, or -1 if it is not for this interface  */
+/*-------------------------------------------------------------------*/
+static int qeth_check_header(OSAGRP *grp, BYTE *hdr)
+{
+U16     len;
+
+    if (grp->layer == 2 && hdr[0] == OSA_HDR_ID_L2)
+        FETCH_HW(len, ((OSA_HDR2*)hdr)->pktlen);
+    else if (grp->layer == 3 && hdr[0] == OSA_HDR_ID_L3)
+        FETCH_HW(len, ((OSA_HDR3*)hdr)->length);
+    else
+        return -1;
+
+    return len;
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Send one packet straight from the storage blocks holding it       */
+/*-------------------------------------------------------------------*/
+static void qeth_send_packet(DEVBLK *dev, OSAGRP *grp, OSAIOV *iov,
+                             int cnt, int pktlen)
+{
+int     len;                            /* Bytes in storage blocks   */
+int     i;
+
+    for (i = 0, len = 0; i < cnt; i++)
+        len += (int)iov[i].iov_len;
+
+    if (pktlen < 0 || (pktlen && len < pktlen))
+    {
+        grp->txdrops++;
+        return;
+    }
+
+    /* The last block may extend beyond the packet */
+    if (pktlen && len > pktlen)
+    {
+        for (i = 0, len = 0; len + (int)iov[i].iov_len < pktlen; i++)
+            len += (int)iov[i].iov_len;
+        iov[i].iov_len = pktlen - len;
+        cnt = i + 1;
+        len = pktlen;
+    }
+
+    if (grp->debug)
+        logmsg(_("HHCQE012I %4.4X: Sending %d byte frame\n"),
+               dev->devnum, len);
+
+#if defined(OPTION_W32_CTCI)
+    grp->txdrops++;
+#else
+    if (writev(grp->fd, iov, cnt) < 0)
+    {
+        grp->txdrops++;
+        return;
+    }
+#endif
+
+    grp->txframes++;
+    grp->txbytes += len;
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Send the packets in one output buffer                             */
+/* Returns the SLSB state to give the buffer back in                 */
+/*-------------------------------------------------------------------*/
+static BYTE qeth_write_buffer(DEVBLK *dev, OSAGRP *grp, OSAQUE *que,
+                              BYTE *sbal)
+{
+QDIO_SBALE *sbale = (QDIO_SBALE*)sbal;  /* -> SBAL entry             */
+OSAIOV  iov[QDIO_ENTRIES];              /* Packet storage blocks     */
+int     cnt = 0;                        /* Number of iov entries     */
+int     pktlen = -1;                    /* Packet length from header */
+BYTE   *blk;                            /* -> Storage block          */
+U64     addr;                           /* Storage block address     */
+U32     len;                            /* Storage block length      */
+BYTE    frag;                           /* Fragment type             */
+int     i;
+
+    for (i = 0; i < QDIO_ENTRIES; i++, sbale++)
+    {
+        FETCH_DW(addr, sbale->addr);
+        FETCH_FW(len, sbale->length);
+        frag = sbale->flags[0] & SBALE_F0_FRAG;
+
+        blk = NULL;
+        if (len && !(blk = qeth_storage(dev, addr, len, que->sbalkey, 0)))
+            return SLSB_P_OUTPUT_ERROR;
+
+        /* Each packet starts with its OSA header */
+        if (frag == 0 || frag == SBALE_F0_FIRST)
+        {
+            if (len < OSA_HDR_SIZE)
+                return SLSB_P_OUTPUT_ERROR;
+            pktlen = qeth_check_header(grp, blk);
+            blk += OSA_HDR_SIZE;
+            len -= OSA_HDR_SIZE;
+            cnt = 0;
+        }
+
+        if (len)
+        {
+            iov[cnt].iov_base = blk;
+            iov[cnt].iov_len = len;
+            cnt++;
+        }
+
+        if (frag == 0 || frag == SBALE_F0_LASTF)
+            qeth_send_packet(dev, grp, iov, cnt, pktlen);
+
+        if (sbale->flags[0] & SBALE_F0_LAST)
+            break;
+    }
+
+    return SLSB_P_OUTPUT_EMPTY;
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Wake the ACTIVATE QUEUES loop                                     */
+/*-------------------------------------------------------------------*/
+static void qeth_wakeup(OSAGRP *grp)
+{
+    SEND_PIPE_SIGNAL(grp->ppfd[1], grp->lock, grp->ppflag);
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Position of a device in its group (OSA_READ, OSA_WRITE, OSA_DATA) */
+/*-------------------------------------------------------------------*/
+static int qeth_member(DEVBLK *dev)
+{
+int     i;
+
+    for (i = 0; i < dev->group->acount; i++)
+        if (dev->group->memdev[i] == dev)
+            break;
+
+    return i;
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Halt or clear of the ACTIVATE QUEUES channel program, or of a     */
+/* READ waiting for a reply on the read or write device              */
+/*-------------------------------------------------------------------*/
+static void qeth_halt_device(DEVBLK *dev)
+{
+OSAGRP *grp = dev->group ? dev->group->grp_data : NULL;
+int     m;
+
+    if (!grp)
+        return;
+
+    m = qeth_member(dev);
+    if (m == OSA_DATA)
+    {
+        if (grp->active)
+        {
+            grp->halt = 1;
+            qeth_wakeup(grp);
+        }
+        return;
+    }
+
+    obtain_lock (&grp->rsplock);
+    grp->rsphalt[m] = 1;
+    broadcast_condition (&grp->rspcond);
+    release_lock (&grp->rsplock);
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Process ACTIVATE QUEUES                                           */
+/* The channel program stays active, moving input frames to the      */
+/* program and presenting PCIs, until it is halted or cleared.       */
+/*-------------------------------------------------------------------*/
+static void qeth_activate_queues(DEVBLK *dev, OSAGRP *grp)
+{
+fd_set  rfds;                           /* Select read set           */
+struct timeval tv;                      /* Select timeout            */
+int     maxfd;                          /* Highest fd in set         */
+int     blocked = 0;                    /* No empty input buffers    */
+U64     now, wait;                      /* Times in microseconds     */
+
+    obtain_lock (&dev->lock);
+    dev->scsw.flag2 |= SCSW2_Q;
+    dev->halt_device = qeth_halt_device;
+    grp->halt = 0;
+    grp->opci = 0;
+    grp->active = 1;
+    release_lock (&dev->lock);
+
+    if (grp->debug)
+        logmsg(_("HHCQE013I %4.4X: Queues active\n"), dev->devnum);
+
+    while (!grp->halt
+      && !(dev->scsw.flag2 & (SCSW2_AC_HALT | SCSW2_AC_CLEAR)))
+    {
+        if (grp->fd >= 0)
+            blocked = qeth_read_input(dev, grp);
+
+        /* Signal input once enough buffers or time have passed,
+           or straight away if the program has run out of buffers */
+        now = qeth_usecs();
+        if (grp->opci
+         || (grp->ipend && (blocked || grp->ipend >= grp->pcithresh
+                      || now - grp->ipendtime >= (U64)grp->pciwait)))
+        {
+            grp->opci = 0;
+            grp->ipend = 0;
+            qeth_raise_pci(dev, grp);
+        }
+
+        FD_ZERO(&rfds);
+        FD_SET(grp->ppfd[0], &rfds);
+        maxfd = grp->ppfd[0];
+        if (grp->fd >= 0 && !blocked)
+        {
+            FD_SET(grp->fd, &rfds);
+            maxfd = maxfd > grp->fd ? maxfd : grp->fd;
+        }
+
+        wait = blocked ? QETH_BLOCKED_USECS : QETH_POLL_USECS;
+        if (grp->ipend)
+            wait = grp->ipendtime + grp->pciwait - now;
+        tv.tv_sec = wait / 1000000;
+        tv.tv_usec = wait % 1000000;
+
+        if (select(maxfd + 1, &rfds, NULL, NULL, &tv) > 0
+         && FD_ISSET(grp->ppfd[0], &rfds))
+            RECV_PIPE_SIGNAL(grp->ppfd[0], grp->lock, grp->ppflag);
+    }
+
+    obtain_lock (&dev->lock);
+    dev->scsw.flag2 &= ~SCSW2_Q;
+    dev->halt_device = NULL;
+    grp->active = 0;
+    grp->ibuf = -1;
+    grp->ipend = 0;
+    release_lock (&dev->lock);
+
+    if (grp->debug)
+        logmsg(_("HHCQE014I %4.4X: Queues inactive\n"), dev->devnum);
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Allocate a reply of len bytes                                     */
+/*-------------------------------------------------------------------*/
+static OSARSP *qeth_new_reply(int len)
+{
+OSARSP *rsp;
+
+    if ((rsp = malloc(sizeof(OSARSP) + len)))
+    {
+        rsp->next = NULL;
+        rsp->len = len;
+    }
+
+    return rsp;
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Queue a reply to be read from the read or write device            */
+/* Returns 0, or -1 with the reply freed if too many are waiting     */
+/*-------------------------------------------------------------------*/
+static int qeth_queue_reply(OSAGRP *grp, int m, OSARSP *rsp)
+{
+    obtain_lock (&grp->rsplock);
+
+    if (grp->rspcnt[m] >= OSA_MAXRSP)
+    {
+        release_lock (&grp->rsplock);
+        free(rsp);
+        return -1;
+    }
+
+    if (grp->rsptail[m])
+        grp->rsptail[m]->next = rsp;
+    else
+        grp->rsphead[m] = rsp;
+    grp->rsptail[m] = rsp;
+    grp->rspcnt[m]++;
+
+    broadcast_condition (&grp->rspcond);
+    release_lock (&grp->rsplock);
+
+    return 0;
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Discard the replies waiting on the read or write device           */
+/*-------------------------------------------------------------------*/
+static void qeth_flush_replies(OSAGRP *grp, int m)
+{
+OSARSP *rsp;
+
+    obtain_lock (&grp->rsplock);
+
+    while ((rsp = grp->rsphead[m]))
+    {
+        grp->rsphead[m] = rsp->next;
+        free(rsp);
+    }
+    grp->rsptail[m] = NULL;
+    grp->rspcnt[m] = 0;
+
+    release_lock (&grp->rsplock);
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Wait for the next reply on the read or write device               */
+/* Returns the reply, or NULL if the READ was halted or cleared      */
+/*-------------------------------------------------------------------*/
+static OSARSP *qeth_wait_reply(DEVBLK *dev, OSAGRP *grp, int m)
+{
+OSARSP *rsp;
+
+    obtain_lock (&grp->rsplock);
+    grp->rsphalt[m] = 0;
+    grp->rspwait++;
+    release_lock (&grp->rsplock);
+
+    obtain_lock (&dev->lock);
+    dev->halt_device = qeth_halt_device;
+    release_lock (&dev->lock);
+
+    /* Clear does not call the halt routine, so poll for it */
+    obtain_lock (&grp->rsplock);
+    while (!(rsp = grp->rsphead[m]) && !grp->rsphalt[m]
+      && !(dev->scsw.flag2 & (SCSW2_AC_HALT | SCSW2_AC_CLEAR)))
+        timed_wait_condition_relative_usecs (&grp->rspcond,
+                               &grp->rsplock, QETH_POLL_USECS, NULL);
+    if (rsp)
+    {
+        if (!(grp->rsphead[m] = rsp->next))
+            grp->rsptail[m] = NULL;
+        grp->rspcnt[m]--;
+    }
+    grp->rspwait--;
+    release_lock (&grp->rsplock);
+
+    obtain_lock (&dev->lock);
+    dev->halt_device = NULL;
+    release_lock (&dev->lock);
+
+    return rsp;
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Process IDX ACTIVATE written to the read or write device          */
+/* The reply is read back from the same device.  A repeated          */
+/* activation, as made by a driver recovering the adapter, discards  */
+/* any replies left from the last one.                               */
+/* Returns 0, or -1 if the request is not valid for the device.      */
+/*-------------------------------------------------------------------*/
+static int qeth_idx_activate(DEVBLK *dev, OSAGRP *grp, int m,
+                             BYTE *iobuf, U16 count)
+{
+OSA_IDX *req = (OSA_IDX*)iobuf;         /* -> Request                */
+OSA_IDX *idx;                           /* -> Reply                  */
+OSARSP  *rsp;
+U16     datadev;                        /* Data device number        */
+U16     flevel;                         /* Function level            */
+
+    if (count < OSA_IDX_SIZE)
+        return -1;
+
+    FETCH_HW(datadev, req->datadev);
+    if (req->type != (m == OSA_READ ? IDX_TYPE_READ : IDX_TYPE_WRITE)
+     || datadev != dev->group->memdev[OSA_DATA]->devnum)
+        return -1;
+
+    if (!(rsp = qeth_new_reply(OSA_IDX_SIZE)))
+        return -1;
+
+    qeth_flush_replies(grp, m);
+    if (m == OSA_READ)
+        grp->thseq = grp->pduseq = 0;
+
+    idx = (OSA_IDX*)rsp->data;
+    memset(idx, 0, OSA_IDX_SIZE);
+    idx->type = IDX_RSP_OK;
+    idx->port = IDX_RSP_NOPORT;
+    STORE_FW(idx->token, m == OSA_READ ? QETH_TOKEN_RM_READ
+                                       : QETH_TOKEN_RM_WRITE);
+    STORE_FW(idx->uclevel, QETH_UCLEVEL);
+
+    /* The reply carries the adapter's function level matching the
+       level of the driver */
+    FETCH_HW(flevel, req->flevel);
+    if ((flevel & 0xFF) == 8)
+        flevel = (flevel & 0xFF) + 0x400;
+    else if (((flevel >> 8) & 3) == 1)
+        flevel = (flevel & 0xFF) + 0x200;
+    STORE_HW(idx->flevel, flevel);
+
+    if (qeth_queue_reply(grp, m, rsp))
+        return -1;
+    grp->idxactive[m] = 1;
+
+    if (grp->debug)
+        logmsg(_("HHCQE015I %4.4X: IDX ACTIVATE %s accepted\n"),
+               dev->devnum, m == OSA_READ ? "read" : "write");
+
+    return 0;
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Process a CM or ULP PDU, storing the adapter's token in the reply */
+/* Returns 0, or -1 if the PDU is not recognised                     */
+/*-------------------------------------------------------------------*/
+static int qeth_mpc_pdu(DEVBLK *dev, OSAGRP *grp, BYTE type,
+                        BYTE *pdu, U32 len)
+{
+OSA_PDU *hdr = (OSA_PDU*)pdu;           /* -> PDU header             */
+U32     off;                            /* Offset of the token       */
+U32     token;                          /* Adapter's token           */
+int     layer;                          /* Layer the driver asks for */
+char   *name;                           /* Request name              */
+
+    if (len < sizeof(OSA_PDU))
+        return -1;
+
+    /* DM ACTIVATE starts the data device: nothing to return */
+    if (type == RRH_TYPE_ULP && hdr->tgt == PDU_TGT_QDIO
+     && hdr->cmd == PDU_CMD_ACTIVATE)
+    {
+        if (grp->debug)
+            logmsg(_("HHCQE016I %4.4X: DM ACTIVATE processed\n"),
+                   dev->devnum);
+        return 0;
+    }
+
+    if (hdr->tgt != PDU_TGT_OSA)
+        return -1;
+
+    switch (hdr->cmd) {
+
+    case PDU_CMD_ENABLE:
+        off = PDU_ENABLE_FILTER_TOKEN;
+        if (type == RRH_TYPE_CM)
+        {
+            name = "CM ENABLE";
+            token = QETH_TOKEN_CM_FILTER;
+            break;
+        }
+        name = "ULP ENABLE";
+        token = QETH_TOKEN_ULP_FILTER;
+
+        /* The data path passes the frames of the configured layer */
+        if (len > PDU_ULP_ENABLE_PROTO)
+        {
+            layer = pdu[PDU_ULP_ENABLE_PROTO] == PDU_PROTO_L2 ? 2 : 3;
+            if (layer != grp->layer)
+                logmsg(_("HHCQE018W %4.4X: Guest requested layer %d, "
+                         "adapter is configured for layer %d\n"),
+                       dev->devnum, layer, grp->layer);
+        }
+        break;
+
+    case PDU_CMD_SETUP:
+        off = PDU_SETUP_CONN_TOKEN;
+        name = type == RRH_TYPE_CM ? "CM SETUP" : "ULP SETUP";
+        token = type == RRH_TYPE_CM ? QETH_TOKEN_CM_CONN
+                                    : QETH_TOKEN_ULP_CONN;
+        break;
+
+    default:
+        return -1;
+    }
+
+    if (len < off + 4)
+        return -1;
+    STORE_FW(pdu + off, token);
+
+    if (grp->debug)
+        logmsg(_("HHCQE016I %4.4X: %s processed\n"), dev->devnum, name);
+
+    return 0;
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Process SETADAPTERPARMS                                           */
+/* Only the subcommands a driver needs to bring the adapter up are   */
+/* supported: query of the supported subcommands and reading of the  */
+/* MAC address.  Others are answered with an unsupported return code */
+/* in the SETADAPTERPARMS header.                                    */
+/*-------------------------------------------------------------------*/
+static void qeth_setadpparms(OSAGRP *grp, BYTE *sap, U32 len)
+{
+OSA_SAP *hdr = (OSA_SAP*)sap;           /* -> Subcommand header      */
+OSA_SAP_QRY *qry;                       /* -> Query data             */
+OSA_SAP_MAC *mac;                       /* -> MAC address data       */
+U32     cmd;                            /* Subcommand                */
+U32     mcmd;                           /* MAC address subcommand    */
+
+    if (len < sizeof(OSA_SAP))
+        return;
+
+    FETCH_FW(cmd, hdr->cmd);
+    STORE_FW(hdr->supp, SAP_QUERY_CMDS | SAP_ALTER_MAC);
+    STORE_HW(hdr->rc, IPA_RC_OK);
+
+    switch (cmd) {
+
+    case SAP_QUERY_CMDS:
+        if (len < sizeof(OSA_SAP) + sizeof(OSA_SAP_QRY))
+            break;
+        qry = (OSA_SAP_QRY*)(hdr + 1);
+        STORE_FW(qry->nlan, 1);
+        STORE_FW(qry->cmds, SAP_QUERY_CMDS | SAP_ALTER_MAC);
+        return;
+
+    case SAP_ALTER_MAC:
+        if (len < sizeof(OSA_SAP) + sizeof(OSA_SAP_MAC))
+            break;
+        mac = (OSA_SAP_MAC*)(hdr + 1);
+        FETCH_FW(mcmd, mac->cmd);
+        if (mcmd != SAP_MAC_READ)
+            break;
+        STORE_FW(mac->addrlen, sizeof(grp->mac));
+        STORE_FW(mac->count, 1);
+        memcpy(mac->addr, grp->mac, sizeof(grp->mac));
+        return;
+    }
+
+    STORE_HW(hdr->rc, IPA_RC_UNSUPP);
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Process an IP assist command, setting its return code             */
+/* The addresses the guest registers need no action: every frame the */
+/* interface passes is presented to the guest.                       */
+/*-------------------------------------------------------------------*/
+static int qeth_ipa_command(DEVBLK *dev, OSAGRP *grp, BYTE *pdu, U32 len)
+{
+OSA_IPA *ipa = (OSA_IPA*)pdu;           /* -> IPA command            */
+U16     rc = IPA_RC_OK;                 /* Return code               */
+
+    if (len < sizeof(OSA_IPA))
+        return -1;
+
+    switch (ipa->cmd) {
+
+    case IPA_CMD_SETADPPARMS:
+        qeth_setadpparms(grp, pdu + sizeof(OSA_IPA),
+                         len - sizeof(OSA_IPA));
+        break;
+
+    case IPA_CMD_STARTLAN:
+    case IPA_CMD_STOPLAN:
+    case IPA_CMD_SETVMAC:
+    case IPA_CMD_DELVMAC:
+    case IPA_CMD_SETGMAC:
+    case IPA_CMD_DELGMAC:
+    case IPA_CMD_SETIP:
+    case IPA_CMD_DELIP:
+    case IPA_CMD_SETIPM:
+    case IPA_CMD_DELIPM:
+    case IPA_CMD_SETRTG:
+    case IPA_CMD_QIPASSIST:
+        break;
+
+    default:
+        rc = IPA_RC_UNSUPP;
+    }
+
+    STORE_HW(ipa->rc, rc);
+    STORE_FW(ipa->ipas, IPA_SETADAPTERPARMS);
+    STORE_FW(ipa->ipae, IPA_SETADAPTERPARMS);
+
+    if (grp->debug)
+        logmsg(_("HHCQE017I %4.4X: IPA command %2.2X return code "
+                 "%4.4X\n"), dev->devnum, ipa->cmd, rc);
+
+    return 0;
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Process an MPC message written to the write device                */
+/* The reply, a copy of the message carrying the adapter's tokens    */
+/* and results, is read from the read device.                        */
+/* Returns 0, or -1 if the message is not valid                      */
+/*-------------------------------------------------------------------*/
+static int qeth_mpc_request(DEVBLK *dev, OSAGRP *grp,
+                            BYTE *iobuf, U16 count)
+{
+OSA_TH  *th = (OSA_TH*)iobuf;           /* -> Transport header       */
+OSA_RRH *rrh;                           /* -> Request header         */
+OSA_PH  *ph;                            /* -> PDU header             */
+OSARSP  *rsp;
+U32     length;                         /* Message length            */
+U32     offrrh;                         /* Offset of the RRH         */
+U32     offpdu;                         /* Offset of the PDU         */
+U32     pdulen;                         /* PDU length                */
+U32     seq;                            /* Request sequence number   */
+U16     offph;                          /* Offset of the PH          */
+int     rc;
+
+    if (!grp->idxactive[OSA_READ] || !grp->idxactive[OSA_WRITE]
+     || count < sizeof(OSA_TH))
+        return -1;
+
+    /* The headers and PDU must lie within the message */
+    FETCH_FW(length, th->length);
+    FETCH_FW(offrrh, th->offrrh);
+    if (length > count || offrrh > length
+     || length - offrrh < sizeof(OSA_RRH))
+        return -1;
+
+    rrh = (OSA_RRH*)(iobuf + offrrh);
+    FETCH_HW(offph, rrh->offph);
+    if (offph > length - offrrh
+     || length - offrrh - offph < sizeof(OSA_PH))
+        return -1;
+
+    ph = (OSA_PH*)((BYTE*)rrh + offph);
+    FETCH_FW(offpdu, ph->offpdu);
+    pdulen = (ph->pdulen[0] << 16) | (ph->pdulen[1] << 8) | ph->pdulen[2];
+    if (offpdu > length || pdulen > length - offpdu)
+        return -1;
+
+    if (!(rsp = qeth_new_reply(length)))
+        return -1;
+    memcpy(rsp->data, iobuf, length);
+    th = (OSA_TH*)rsp->data;
+    rrh = (OSA_RRH*)(rsp->data + offrrh);
+
+    if (rrh->type == RRH_TYPE_IPA)
+        rc = qeth_ipa_command(dev, grp, rsp->data + offpdu, pdulen);
+    else if (rrh->type == RRH_TYPE_CM || rrh->type == RRH_TYPE_ULP)
+        rc = qeth_mpc_pdu(dev, grp, rrh->type, rsp->data + offpdu, pdulen);
+    else
+        rc = -1;
+
+    if (rc)
+    {
+        free(rsp);
+        return -1;
+    }
+
+    /* The reply acknowledges the request's sequence number */
+    FETCH_FW(seq, rrh->seq);
+    STORE_FW(rrh->ack, seq);
+    STORE_FW(rrh->seq, ++grp->pduseq);
+    STORE_FW(th->seq, ++grp->thseq);
+
+    return qeth_queue_reply(grp, OSA_READ, rsp);
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Open and configure the TUN or TAP interface                       */
+/*-------------------------------------------------------------------*/
+static int qeth_open_interface(DEVBLK *dev, OSAGRP *grp)
+{
+#if defined(OPTION_W32_CTCI)
+    logmsg(_("HHCQE004W %4.4X: TUN/TAP attachment not supported, "
+             "frames will be discarded\n"), dev->devnum);
+    return 0;
+#else
+int     flags;                          /* Interface flags           */
+
+    if (TUNTAP_CreateInterface(grp->ttdev,
+               (grp->layer == 2 ? IFF_TAP : IFF_TUN) | IFF_NO_PI,
+               &grp->fd, grp->ttifname) < 0)
+        return -1;
+
+    logmsg(_("HHCQE001I %4.4X: %s device %s opened\n"), dev->devnum,
+           grp->layer == 2 ? "TAP" : "TUN", grp->ttifname);
+
+    fcntl(grp->fd, F_SETFL, fcntl(grp->fd, F_GETFL) | O_NONBLOCK);
+
+    if (grp->hostip)
+        VERIFY(TUNTAP_SetIPAddr(grp->ttifname, grp->hostip) == 0);
+    if (grp->layer == 3 && grp->guestip)
+        VERIFY(TUNTAP_SetDestAddr(grp->ttifname, grp->guestip) == 0);
+#if defined(OPTION_TUNTAP_SETNETMASK)
+    if (grp->netmask)
+        VERIFY(TUNTAP_SetNetMask(grp->ttifname, grp->netmask) == 0);
+#endif
+    VERIFY(TUNTAP_SetMTU(grp->ttifname, grp->mtu) == 0);
+
+    flags = IFF_UP | (grp->layer == 2 ? IFF_BROADCAST : 0);
+#if defined(TUNTAP_IFF_RUNNING_NEEDED)
+    flags |= IFF_RUNNING;
+#endif
+    VERIFY(TUNTAP_SetFlags(grp->ttifname, flags) == 0);
+
+    return 0;
+#endif
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Parse the device statement parameters                             */
+/*-------------------------------------------------------------------*/
+static int qeth_parse_args(DEVBLK *dev, OSAGRP *grp,
+                           int argc, char *argv[])
+{
+struct in_addr addr;                    /* Work area for addresses   */
+int     i, n;
+char    c;
+
+    strlcpy(grp->ttdev, HERCTUN_DEV, sizeof(grp->ttdev));
+    grp->layer = 2;
+    grp->mtu = strdup("1500");
+    grp->pcithresh = 1;
+    grp->pciwait = 100;
+
+    for (i = 0; i < argc; i++)
+    {
+        if (argv[i][0] != '-')
+        {
+            if (inet_aton(argv[i], &addr) == 0 || (grp->guestip
+                                                   && grp->hostip))
+            {
+                logmsg(_("HHCQE002E %4.4X: Invalid parameter %s\n"),
+                       dev->devnum, argv[i]);
+                return -1;
+            }
+            if (!grp->guestip)
+                grp->guestip = strdup(argv[i]);
+            else
+                grp->hostip = strdup(argv[i]);
+            continue;
+        }
+
+        if (!strcmp(argv[i], "-d"))
+        {
+            grp->debug = 1;
+            continue;
+        }
+
+        if (strlen(argv[i]) != 2 || !strchr("nltspw", argv[i][1])
+         || i + 1 >= argc)
+        {
+            logmsg(_("HHCQE002E %4.4X: Invalid parameter %s\n"),
+                   dev->devnum, argv[i]);
+            return -1;
+        }
+
+        switch (argv[i++][1]) {
+
+        case 'n':
+            strlcpy(grp->ttdev, argv[i], sizeof(grp->ttdev));
+            break;
+
+        case 'l':
+            if (sscanf(argv[i], "%d%c", &n, &c) != 1 || (n != 2 && n != 3))
+                goto badval;
+            grp->layer = n;
+            break;
+
+        case 't':
+            if (sscanf(argv[i], "%d%c", &n, &c) != 1 || n < 576 || n > 65535)
+                goto badval;
+            free(grp->mtu);
+            grp->mtu = strdup(argv[i]);
+            break;
+
+        case 's':
+            if (inet_aton(argv[i], &addr) == 0)
+                goto badval;
+            grp->netmask = strdup(argv[i]);
+            break;
+
+        case 'p':
+            if (sscanf(argv[i], "%d%c", &n, &c) != 1
+             || n < 1 || n > QDIO_BUFFERS)
+                goto badval;
+            grp->pcithresh = n;
+            break;
+
+        case 'w':
+            if (sscanf(argv[i], "%d%c", &n, &c) != 1 || n < 0 || n > 1000000)
+                goto badval;
+            grp->pciwait = n;
+            break;
+        }
+        continue;
+
+    badval:
+        logmsg(_("HHCQE003E %4.4X: Invalid value %s for %s\n"),
+               dev->devnum, argv[i], argv[i-1]);
+        return -1;
+    }
+
+    /* Largest frame the interface passes: the MTU plus, on layer 2,
+       an Ethernet header with a VLAN tag */
+    grp->maxframe = atoi(grp->mtu) + (grp->layer == 2 ? 18 : 0);
+
+    return 0;
+}
+
+
+/*-------------------------------------------------------------------*/
+/* Release the device group's resources                              */
+/*-------------------------------------------------------------------*/
+static void qeth_free_group(OSAGRP *grp)
+{
+#if !defined(OPTION_W32_CTCI)
+    if (grp->fd >= 0)
+        TUNTAP_Close(grp->fd);
+#endif
+    if (grp->ppfd[0] >= 0)
+        close_pipe(grp->ppfd[0]);
+    if (grp->ppfd[1] >= 0)
+        close_pipe(grp->ppfd[1]);
+    qeth_flush_replies(grp, OSA_READ);
+    qeth_flush_replies(grp, OSA_WRITE);
+    destroy_lock(&grp->lock);
+    destroy_lock(&grp->rsplock);
+    destroy_condition(&grp->rspcond);
+    free(grp->guestip);
+    free(grp->hostip);
+    free(grp->netmask);
+    free(grp->mtu);
+    free(grp);
+}
+
+
 /*-------------------------------------------------------------------*/
 /* Initialize the device handler                                     */
 /*-------------------------------------------------------------------*/
 static int qeth_init_handler ( DEVBLK *dev, int argc, char *argv[] )
 {
-UNREFERENCED(argc);
-UNREFERENCED(argv);
-
-logmsg(D_("dev(%4.4x) experimental driver\n"),dev->devnum);
+OSAGRP *grp;
+int     i;
 
     dev->numdevid = sizeof(sense_id_bytes);
-logmsg(D_("senseidnum=%d\n"),dev->numdevid);
     memcpy(dev->devid, sense_id_bytes, sizeof(sense_id_bytes));
     dev->devtype = dev->devid[1] << 8 | dev->devid[2];
     
@@ -53,13 +1350,45 @@ logmsg(D_("senseidnum=%d\n"),dev->numdevid);
     }
     else
     {
-    int i;
         logmsg(D_("group = ( "));
         for(i = 0; i < dev->group->acount; i++)
             logmsg("%4.4x ",dev->group->memdev[i]->devnum);
         logmsg(") complete\n");
     }
 
+    /* The group is complete: set up the adapter */
+    if(!(grp = malloc(sizeof(OSAGRP))))
+    {
+        logmsg(_("HHCQE005E %4.4X: Unable to allocate OSA group: %s\n"),
+               dev->devnum, strerror(errno));
+        return -1;
+    }
+    memset(grp, 0, sizeof(OSAGRP));
+    grp->fd = grp->ppfd[0] = grp->ppfd[1] = -1;
+    grp->ibuf = -1;
+    initialize_lock(&grp->lock);
+    initialize_lock(&grp->rsplock);
+    initialize_condition(&grp->rspcond);
+
+    /* Locally administered MAC address from the read device number */
+    grp->mac[0] = 0x02;
+    grp->mac[4] = dev->group->memdev[OSA_READ]->devnum >> 8;
+    grp->mac[5] = dev->group->memdev[OSA_READ]->devnum & 0xFF;
+
+    if(qeth_parse_args(dev, grp, argc, argv)
+     || create_pipe(grp->ppfd) < 0
+     || qeth_open_interface(dev, grp))
+    {
+        qeth_free_group(grp);
+        return -1;
+    }
+
+    dev->group->grp_data = grp;
+
+    /* Copy the fd to make panel.c happy */
+    for(i = 0; i < dev->group->acount; i++)
+        dev->group->memdev[i]->fd = grp->fd;
+
     return 0;
 } /* end function qeth_init_handler */
 
@@ -70,9 +1399,22 @@ logmsg(D_("senseidnum=%d\n"),dev->numdevid);
 static void qeth_query_device (DEVBLK *dev, char **class,
                 int buflen, char *buffer)
 {
+OSAGRP *grp = dev->group ? dev->group->grp_data : NULL;
+
     BEGIN_DEVICE_CLASS_QUERY( "QETH", dev, class, buflen, buffer );
 
-    snprintf (buffer, buflen, "\n");
+    if (!grp)
+    {
+        snprintf (buffer, buflen, "*Incomplete");
+        return;
+    }
+
+    snprintf (buffer, buflen, "%s L%d%s rx=%" I64_FMT "u tx=%" I64_FMT "u"
+              " drop=%" I64_FMT "u/%" I64_FMT "u pci=%" I64_FMT "u",
+              grp->ttifname[0] ? grp->ttifname : "-", grp->layer,
+              grp->active ? " QDIO" : "",
+              grp->rxframes, grp->txframes, grp->rxdrops, grp->txdrops,
+              grp->pcis);
 
 } /* end function qeth_query_device */
 
@@ -82,9 +1424,31 @@ static void qeth_query_device (DEVBLK *dev, char **class,
 /*-------------------------------------------------------------------*/
 static int qeth_close_device ( DEVBLK *dev )
 {
-    UNREFERENCED(dev);
+OSAGRP *grp = dev->group ? dev->group->grp_data : NULL;
+int     i;
 
-    /* Close the device file */
+    /* The first member detached releases the group's resources */
+    if (!grp)
+        return 0;
+
+    /* Stop the data path and any READ waiting for a reply */
+    for (i = 0; (grp->active || grp->rspwait) && i < 50; i++)
+    {
+        grp->halt = 1;
+        qeth_wakeup(grp);
+        obtain_lock(&grp->rsplock);
+        grp->rsphalt[OSA_READ] = grp->rsphalt[OSA_WRITE] = 1;
+        broadcast_condition(&grp->rspcond);
+        release_lock(&grp->rsplock);
+        usleep(10000);
+    }
+
+    dev->group->grp_data = NULL;
+    for (i = 0; i < dev->group->acount; i++)
+        if (dev->group->memdev[i])
+            dev->group->memdev[i]->fd = -1;
+
+    qeth_free_group(grp);
 
     return 0;
 } /* end function qeth_close_device */
@@ -97,16 +1461,19 @@ static void qeth_execute_ccw ( DEVBLK *dev, BYTE code, BYTE flags,
         BYTE chained, U16 count, BYTE prevcode, int ccwseq,
         BYTE *iobuf, BYTE *more, BYTE *unitstat, U16 *residual )
 {
+OSAGRP *grp = dev->group ? dev->group->grp_data : NULL;
 int     rc = 0;                         /* Return code               */
 int     num;                            /* Number of bytes to move   */
 int     blocksize = 1024;
+int     m;                              /* Group member              */
+U32     id;                             /* Message identifier        */
+OSARSP *rsp;                            /* -> Reply to be read       */
 #define CONFIG_DATA_SIZE 1024
 
     UNREFERENCED(flags);
     UNREFERENCED(prevcode);
     UNREFERENCED(ccwseq);
     UNREFERENCED(chained);
-    UNREFERENCED(rc);
     UNREFERENCED(blocksize);
 
     /* Process depending on CCW opcode */
@@ -117,14 +1484,26 @@ int     blocksize = 1024;
     /* WRITE                                                         */
     /*---------------------------------------------------------------*/
 logmsg(D_("Write dev(%4.4x)\n"),dev->devnum);
-#define WR_SIZE 0x22
-
-        /* Calculate number of bytes to read and set residual count */
-        num = (count < WR_SIZE) ? count : WR_SIZE;
-        *residual = count - num;
-        if (count < WR_SIZE) *more = 1;
+        /* IDX ACTIVATE on the read or write device, MPC messages
+           on the write device once it is active */
+        rc = -1;
+        if (grp && count >= 4 && (m = qeth_member(dev)) != OSA_DATA)
+        {
+            FETCH_FW(id, iobuf);
+            if (m == OSA_WRITE && id == OSA_TH_ID)
+                rc = qeth_mpc_request(dev, grp, iobuf, count);
+            else
+                rc = qeth_idx_activate(dev, grp, m, iobuf, count);
+        }
+
+        if (rc)
+        {
+            dev->sense[0] = SENSE_CR;
+            *unitstat = CSW_CE | CSW_DE | CSW_UC;
+            break;
+        }
 
-        /* Return normal status */
+        *residual = 0;
         *unitstat = CSW_CE | CSW_DE;
         break;
 
@@ -133,12 +1512,28 @@ logmsg(D_("Write dev(%4.4x)\n"),dev->devnum);
     /* READ                                                          */
     /*---------------------------------------------------------------*/
 logmsg(D_("Read dev(%4.4x)\n"),dev->devnum);
+        if (!grp || (m = qeth_member(dev)) == OSA_DATA)
+        {
+            dev->sense[0] = SENSE_CR;
+            *unitstat = CSW_CE | CSW_DE | CSW_UC;
+            break;
+        }
+
+        /* This CCW waits for the next reply, or a halt or clear */
+        if (!(rsp = qeth_wait_reply(dev, grp, m)))
+        {
+            *residual = count;
+            *unitstat = CSW_CE | CSW_DE;
+            break;
+        }
 
-#define RD_SIZE 0x22
         /* Calculate number of bytes to read and set residual count */
-        num = (count < RD_SIZE) ? count : RD_SIZE;
+        num = (count < rsp->len) ? count : rsp->len;
         *residual = count - num;
-        if (count < RD_SIZE) *more = 1;
+        if (count < rsp->len) *more = 1;
+
+        memcpy (iobuf, rsp->data, num);
+        free(rsp);
 
         /* Return normal status */
         *unitstat = CSW_CE | CSW_DE;
@@ -190,7 +1585,7 @@ logmsg(D_("Sense ID dev(%4.4x)\n"),dev->devnum);
         *unitstat = CSW_CE | CSW_DE;
         break;
 
-    case 0xFA:
+    case OSA_RCD:
     /*---------------------------------------------------------------*/
     /* READ CONFIGURATION DATA                                       */
     /*---------------------------------------------------------------*/
@@ -208,44 +1603,40 @@ logmsg(D_("Read Configuration Data dev(%4.4x)\n"),dev->devnum);
         break;
 
         
-    case 0xFC:
+    case OSA_EQ:
     /*---------------------------------------------------------------*/
     /* ESTABLISH QUEUES                                              */
     /*---------------------------------------------------------------*/
 logmsg(D_("Establish Queues dev(%4.4x)\n"),dev->devnum);
-        /* Calculate residual byte count */
-        num = (count < CONFIG_DATA_SIZE) ? count : CONFIG_DATA_SIZE;
-        *residual = count - num;
-        if (count < CONFIG_DATA_SIZE) *more = 1;
-
-        memset (iobuf, 0x00, CONFIG_DATA_SIZE);
+        /* The data is the Queue Description Record */
+        if (!grp || grp->active
+         || qeth_establish_queues(dev, grp, iobuf, count))
+        {
+            dev->sense[0] = SENSE_CR;
+            *unitstat = CSW_CE | CSW_DE | CSW_UC;
+            break;
+        }
 
-        /* INCOMPLETE ZZ
-         * QUEUES MUST BE SETUP HERE
-         */
-
-        /* Return unit status */
+        *residual = 0;
         *unitstat = CSW_CE | CSW_DE;
         break;
 
-    case 0xFD:
+    case OSA_AQ:
     /*---------------------------------------------------------------*/
     /* ACTIVATE QUEUES                                               */
     /*---------------------------------------------------------------*/
 logmsg(D_("Activate Queues dev(%4.4x)\n"),dev->devnum);
-        /* Calculate residual byte count */
-        num = (count < CONFIG_DATA_SIZE) ? count : CONFIG_DATA_SIZE;
-        *residual = count - num;
-        if (count < CONFIG_DATA_SIZE) *more = 1;
-
-        memset (iobuf, 0x00, CONFIG_DATA_SIZE);
+        if (!grp || !grp->established || grp->active)
+        {
+            dev->sense[0] = SENSE_CR;
+            *unitstat = CSW_CE | CSW_DE | CSW_UC;
+            break;
+        }
 
-        /* INCOMPLETE ZZ
-         * QUEUES MUST BE HANDLED HERE, THIS CCW WILL ONLY EXIT
-         * IN CASE OF AN ERROR OR A HALT, CLEAR OR CANCEL SIGNAL
-         */
+        /* This CCW only ends on a halt, clear or cancel signal */
+        qeth_activate_queues(dev, grp);
 
-        /* Return unit status */
+        *residual = 0;
         *unitstat = CSW_CE | CSW_DE;
         break;
 
@@ -268,9 +1659,18 @@ logmsg(D_("Unkown CCW dev(%4.4x) code(%2.2x)\n"),dev->devnum,code);
 /*-------------------------------------------------------------------*/
 static int qeth_initiate_input(DEVBLK *dev, U32 qmask)
 {
+OSAGRP *grp = dev->group ? dev->group->grp_data : NULL;
+
     UNREFERENCED(qmask);
 
-logmsg(D_("SIGA-r dev(%4.4x) qmask(%8.8x)\n"),dev->devnum);
+    if (!grp || !grp->active)
+        return 1;
+
+    /* Input buffers have been returned: let the device thread
+       resume reading */
+    grp->sigar++;
+    qeth_wakeup(grp);
+
     return 0;
 }
 
@@ -280,9 +1680,46 @@ logmsg(D_("SIGA-r dev(%4.4x) qmask(%8.8x)\n"),dev->devnum);
 /*-------------------------------------------------------------------*/
 static int qeth_initiate_output(DEVBLK *dev, U32 qmask)
 {
-    UNREFERENCED(qmask);
+OSAGRP *grp = dev->group ? dev->group->grp_data : NULL;
+OSAQUE *que;                            /* -> Output queue           */
+BYTE   *sbal;                           /* -> SBAL                   */
+BYTE    state;                          /* New buffer state          */
+int     q, n;
+
+    if (!grp || !grp->active)
+        return 1;
+
+    grp->sigaw++;
+
+    /* Send every primed buffer of the signalled queues */
+    for (q = 0; q < grp->oqcnt; q++)
+    {
+        if (!(qmask & (0x80000000 >> q)))
+            continue;
+
+        que = &grp->oq[q];
+        for (n = 0; n < QDIO_BUFFERS
+                 && que->slsb[que->next] == SLSB_CU_OUTPUT_PRIMED; n++)
+        {
+            if ((sbal = qeth_sbal(dev, que, que->next, 0)))
+            {
+                state = qeth_write_buffer(dev, grp, que, sbal);
+                if (sbal[3] & SBAL_F3_PCI)
+                    grp->opci = 1;
+            }
+            else
+                state = SLSB_P_OUTPUT_ERROR;
+
+            qeth_set_slsb(que, que->next, SLSB_CU_OUTPUT_PRIMED, state);
+            que->next = (que->next + 1) % QDIO_BUFFERS;
+        }
+    }
+
+    /* The PCI is presented by the device thread, as the caller
+       holds the device lock */
+    if (grp->opci)
+        qeth_wakeup(grp);
 
-logmsg(D_("SIGA-w dev(%4.4x) qmask(%8.8x)\n"),dev->devnum);
     return 0;
 }
 
@@ -0,0 +1,326 @@
+/* QETH.H       (c)Copyright The Hercules Project, 2026              */
+/*              OSA Express                                          */
+
+#if !defined(_QETH_H)
+#define _QETH_H
+
+#include "qdio.h"
+
+
+/*-------------------------------------------------------------------*/
+/* Channel commands (as advertised by the SENSE ID CIWs)             */
+/*-------------------------------------------------------------------*/
+#define OSA_RCD         0xFA            /* Read Configuration Data   */
+#define OSA_EQ          0x1B            /* Establish Queues          */
+#define OSA_AQ          0x1F            /* Activate Queues           */
+
+
+/*-------------------------------------------------------------------*/
+/* Group members                                                     */
+/*-------------------------------------------------------------------*/
+#define OSA_READ        0               /* Read (control) device     */
+#define OSA_WRITE       1               /* Write (control) device    */
+#define OSA_DATA        2               /* Data (QDIO) device        */
+
+
+/*-------------------------------------------------------------------*/
+/* IDX ACTIVATE, written to the read or write device, whose reply    */
+/* is then read back from the same device                            */
+/*-------------------------------------------------------------------*/
+typedef struct _OSA_IDX {
+/*000*/ HWORD   resv000;
+/*002*/ BYTE    flags;                  /* Request flags             */
+/*003*/ BYTE    resv003[5];
+/*008*/ BYTE    type;                   /* Request type / response   */
+/*009*/ BYTE    cause;                  /* Reject cause code         */
+/*00A*/ BYTE    resv00a;
+/*00B*/ BYTE    port;                   /* Port / response flags     */
+/*00C*/ FWORD   token;                  /* Issuer RM token           */
+/*010*/ HWORD   flevel;                 /* Function level            */
+/*012*/ FWORD   uclevel;                /* Microcode level           */
+/*016*/ HWORD   datadev;                /* Data device number        */
+/*018*/ BYTE    resv018[6];
+/*01E*/ HWORD   realaddr;               /* Data device real address  */
+/*020*/ HWORD   resv020;
+    } OSA_IDX;
+
+#define OSA_IDX_SIZE    0x22
+
+#define IDX_TYPE_READ   0x19            /* type: Activate read       */
+#define IDX_TYPE_WRITE  0x15            /*       Activate write      */
+#define IDX_RSP_OK      0x02            /*       Positive response   */
+#define IDX_RSP_NOPORT  0x80            /* port: No portname needed  */
+
+
+/*-------------------------------------------------------------------*/
+/* MPC control messages, written to the write device and answered    */
+/* on the read device: a transport header, one request/response      */
+/* header, a PDU header and the PDU itself                           */
+/*-------------------------------------------------------------------*/
+typedef struct _OSA_TH {                /* Transport header          */
+/*000*/ FWORD   id;                     /* OSA_TH_ID                 */
+/*004*/ FWORD   seq;                    /* Sequence number           */
+/*008*/ FWORD   offrrh;                 /* Offset of the RRH         */
+/*00C*/ FWORD   length;                 /* Total length              */
+/*010*/ FWORD   resv010;
+    } OSA_TH;
+
+#define OSA_TH_ID       0x00E00000
+
+typedef struct _OSA_RRH {               /* Request/response header   */
+/*000*/ FWORD   resv000;
+/*004*/ BYTE    type;                   /* Message type              */
+/*005*/ BYTE    proto;                  /* Protocol                  */
+/*006*/ HWORD   numph;                  /* Number of PDU headers     */
+/*008*/ FWORD   seq;                    /* PDU sequence number       */
+/*00C*/ FWORD   ack;                    /* Acknowledged sequence     */
+/*010*/ HWORD   offph;                  /* Offset of the PH          */
+/*012*/ HWORD   pdulen;                 /* PDU length                */
+/*014*/ BYTE    resv014[4];
+/*018*/ FWORD   token;                  /* Destination token         */
+/*01C*/ BYTE    resv01c[8];
+    } OSA_RRH;
+
+#define RRH_TYPE_CM     0x81            /* Control manager           */
+#define RRH_TYPE_ULP    0x41            /* Upper layer protocol      */
+#define RRH_TYPE_IPA    0xC1            /* IP assist command         */
+
+typedef struct _OSA_PH {                /* PDU header                */
+/*000*/ BYTE    locator;
+/*001*/ BYTE    pdulen[3];              /* PDU length                */
+/*004*/ FWORD   offpdu;                 /* Offset of the PDU         */
+    } OSA_PH;
+
+typedef struct _OSA_PDU {               /* CM and ULP PDU            */
+/*000*/ HWORD   hdrlen;                 /* Header length             */
+/*002*/ BYTE    tgt;                    /* Target                    */
+/*003*/ BYTE    cmd;                    /* Command                   */
+/*004*/ HWORD   parmlen;                /* Parameter length          */
+/*006*/ BYTE    resv006[6];
+    } OSA_PDU;
+
+#define PDU_TGT_OSA     0x41            /* tgt: Adapter              */
+#define PDU_TGT_QDIO    0x43            /*      QDIO data device     */
+#define PDU_CMD_ENABLE  0x02            /* cmd: CM/ULP ENABLE        */
+#define PDU_CMD_SETUP   0x04            /*      CM/ULP SETUP         */
+#define PDU_CMD_ACTIVATE 0x60           /*      DM ACTIVATE          */
+
+/* Offsets in the PDU of the adapter's token in a response */
+#define PDU_ENABLE_FILTER_TOKEN   0x13  /* ENABLE: filter token      */
+#define PDU_SETUP_CONN_TOKEN      0x1A  /* SETUP: connection token   */
+
+/* Offset in the ULP ENABLE PDU of the requested protocol */
+#define PDU_ULP_ENABLE_PROTO      0x10
+#define PDU_PROTO_L2    0x08            /* Layer 2                   */
+#define PDU_PROTO_L3    0x03            /* Layer 3 (TCP/IP)          */
+
+
+/*-------------------------------------------------------------------*/
+/* IP assist commands, carried as the PDU of an RRH_TYPE_IPA message */
+/*-------------------------------------------------------------------*/
+typedef struct _OSA_IPA {
+/*000*/ BYTE    cmd;                    /* Command                   */
+/*001*/ BYTE    iid;                    /* Initiator                 */
+/*002*/ HWORD   seq;                    /* Sequence number           */
+/*004*/ HWORD   rc;                     /* Return code               */
+/*006*/ BYTE    at;                     /* Adapter type              */
+/*007*/ BYTE    port;                   /* Relative port number      */
+/*008*/ BYTE    lvl;                    /* Command level             */
+/*009*/ BYTE    count;                  /* Parameter count           */
+/*00A*/ HWORD   proto;                  /* IP version                */
+/*00C*/ FWORD   ipas;                   /* Assists supported         */
+/*010*/ FWORD   ipae;                   /* Assists enabled           */
+    } OSA_IPA;
+
+#define IPA_CMD_STARTLAN  0x01
+#define IPA_CMD_STOPLAN   0x02
+#define IPA_CMD_SETVMAC   0x21
+#define IPA_CMD_DELVMAC   0x22
+#define IPA_CMD_SETGMAC   0x23
+#define IPA_CMD_DELGMAC   0x24
+#define IPA_CMD_SETIP     0xB1
+#define IPA_CMD_QIPASSIST 0xB2
+#define IPA_CMD_SETASSPARMS 0xB3
+#define IPA_CMD_SETIPM    0xB4
+#define IPA_CMD_DELIPM    0xB5
+#define IPA_CMD_SETRTG    0xB6
+#define IPA_CMD_DELIP     0xB7
+#define IPA_CMD_SETADPPARMS 0xB8
+#define IPA_CMD_CREATE_ADDR 0xC3
+#define IPA_CMD_DESTROY_ADDR 0xC4
+
+#define IPA_RC_OK       0x0000          /* rc: Success               */
+#define IPA_RC_UNSUPP   0x0004          /*     Unsupported command   */
+
+#define IPA_SETADAPTERPARMS 0x00000400  /* ipas: SETADPPARMS         */
+
+typedef struct _OSA_SAP {               /* SETADPPARMS header        */
+/*000*/ FWORD   supp;                   /* Subcommands supported     */
+/*004*/ FWORD   resv004;
+/*008*/ HWORD   cmdlen;                 /* Command length            */
+/*00A*/ HWORD   resv00a;
+/*00C*/ FWORD   cmd;                    /* Subcommand                */
+/*010*/ HWORD   rc;                     /* Return code               */
+/*012*/ BYTE    used;
+/*013*/ BYTE    seq;
+/*014*/ FWORD   resv014;
+    } OSA_SAP;
+
+#define SAP_QUERY_CMDS  0x00000001      /* Query subcommands         */
+#define SAP_ALTER_MAC   0x00000002      /* Read or change MAC        */
+
+typedef struct _OSA_SAP_QRY {           /* SAP_QUERY_CMDS data       */
+/*000*/ FWORD   nlan;                   /* Number of LAN types       */
+/*004*/ BYTE    lantype;                /* LAN type                  */
+/*005*/ BYTE    resv005[3];
+/*008*/ FWORD   cmds;                   /* Subcommands supported     */
+/*00C*/ BYTE    resv00c[8];
+    } OSA_SAP_QRY;
+
+typedef struct _OSA_SAP_MAC {           /* SAP_ALTER_MAC data        */
+/*000*/ FWORD   cmd;                    /* SAP_MAC_READ etc          */
+/*004*/ FWORD   addrlen;                /* Address length            */
+/*008*/ FWORD   count;                  /* Number of addresses       */
+/*00C*/ BYTE    addr[6];                /* MAC address               */
+    } OSA_SAP_MAC;
+
+#define SAP_MAC_READ    0x00000000      /* cmd: Read adapter MAC     */
+
+
+/*-------------------------------------------------------------------*/
+/* Reply waiting to be read from the read or write device            */
+/*-------------------------------------------------------------------*/
+typedef struct _OSARSP {
+        struct _OSARSP *next;           /* -> Next reply             */
+        int     len;                    /* Reply length              */
+        BYTE    data[1];                /* Reply                     */
+    } OSARSP;
+
+#define OSA_MAXRSP      16              /* Most replies held         */
+
+
+/*-------------------------------------------------------------------*/
+/* Header preceding each packet in a QDIO buffer                     */
+/*-------------------------------------------------------------------*/
+typedef struct _OSA_HDR2 {              /* Layer 2 (Ethernet frames) */
+        BYTE    id;                     /* Header type               */
+        BYTE    flags[3];               /* flags[2] is cast type     */
+        BYTE    port;                   /* Port number               */
+        BYTE    hdrlen;                 /* Header length             */
+        HWORD   pktlen;                 /* Frame length              */
+        HWORD   seqno;                  /* Sequence number           */
+        HWORD   vlanid;                 /* VLAN id                   */
+        BYTE    resv00c[20];
+    } OSA_HDR2;
+
+typedef struct _OSA_HDR3 {              /* Layer 3 (IP packets)      */
+        BYTE    id;                     /* Header type               */
+        BYTE    flags;                  /* Cast type and flags       */
+        HWORD   inckstm;                /* Inbound checksum          */
+        FWORD   token;                  /* Token                     */
+        HWORD   length;                 /* Packet length             */
+        BYTE    vlanprio;               /* VLAN priority             */
+        BYTE    extflags;               /* Extended flags            */
+        HWORD   vlanid;                 /* VLAN id                   */
+        HWORD   frameoff;               /* Frame offset              */
+        BYTE    destaddr[16];           /* Next hop address          */
+    } OSA_HDR3;
+
+#define OSA_HDR_SIZE    32
+
+#define OSA_HDR_ID_L3   0x01            /* Layer 3 header            */
+#define OSA_HDR_ID_L2   0x02            /* Layer 2 header            */
+
+#define OSA_HDR2_MCAST  0x01            /* flags[2]: Multicast       */
+#define OSA_HDR2_BCAST  0x02            /*           Broadcast       */
+#define OSA_HDR2_UCAST  0x04            /*           Unicast         */
+
+#define OSA_HDR3_IPV6   0x80            /* flags: IPv6 packet        */
+#define OSA_HDR3_PASSTHRU 0x10          /*        Passthru           */
+#define OSA_HDR3_MCAST  0x04            /*        Multicast          */
+#define OSA_HDR3_BCAST  0x05            /*        Broadcast          */
+#define OSA_HDR3_UCAST  0x06            /*        Unicast            */
+
+
+/*-------------------------------------------------------------------*/
+/* Adapter side state of one QDIO queue                              */
+/*-------------------------------------------------------------------*/
+typedef struct _OSAQUE {
+        RADR    sla;                    /* Storage list address      */
+        BYTE   *slsb;                   /* -> SLSB in main storage   */
+        BYTE    slkey;                  /* SL access key             */
+        BYTE    sbalkey;                /* SBAL and buffer key       */
+        int     next;                   /* Next buffer to process    */
+    } OSAQUE;
+
+
+/*-------------------------------------------------------------------*/
+/* OSA device group                                                  */
+/*-------------------------------------------------------------------*/
+typedef struct _OSAGRP {
+        char    ttdev[PATH_MAX+1];      /* TUN/TAP character device  */
+        char    ttifname[IFNAMSIZ];     /* Interface name            */
+        char   *guestip;                /* Guest IP address          */
+        char   *hostip;                 /* Host side IP address      */
+        char   *netmask;                /* Host side netmask         */
+        char   *mtu;                    /* Interface MTU             */
+        int     fd;                     /* TUN/TAP file descriptor   */
+        int     ppfd[2];                /* Wakeup pipe               */
+        int     ppflag;                 /* Wakeup pending            */
+        LOCK    lock;                   /* Wakeup lock               */
+        int     layer;                  /* 2=Ethernet (tap) 3=IP(tun)*/
+        int     maxframe;               /* Largest frame read        */
+        int     pcithresh;              /* Buffers per input PCI     */
+        int     pciwait;                /* Max PCI delay (usecs)     */
+        BYTE    mac[6];                 /* Adapter MAC address       */
+
+        /* Control exchanges on the read and write devices */
+        LOCK    rsplock;                /* Reply queue lock          */
+        COND    rspcond;                /* Reply queued or halt      */
+        OSARSP *rsphead[2];             /* Replies for read, write   */
+        OSARSP *rsptail[2];
+        int     rspcnt[2];              /* Replies queued            */
+        int     rsphalt[2];             /* Halt of a waiting READ    */
+        volatile int rspwait;           /* READs waiting for replies */
+        int     idxactive[2];           /* IDX ACTIVATE accepted     */
+        U32     thseq;                  /* Transport sequence number */
+        U32     pduseq;                 /* PDU sequence number       */
+
+        int     iqcnt;                  /* Input queues              */
+        int     oqcnt;                  /* Output queues             */
+        OSAQUE  iq[QDIO_MAXQ];          /* Input queues              */
+        OSAQUE  oq[QDIO_MAXQ];          /* Output queues             */
+
+        /* Input buffer currently being filled */
+        int     ibuf;                   /* SBAL number or -1         */
+        BYTE   *isbal;                  /* -> SBAL                   */
+        int     ielems;                 /* Usable entries            */
+        int     ielem;                  /* Current entry             */
+        U32     ioff;                   /* Offset in current entry   */
+        BYTE   *iaddr[QDIO_ENTRIES];    /* -> Storage block          */
+        U32     icap[QDIO_ENTRIES];     /* Storage block size        */
+        U32     iused[QDIO_ENTRIES];    /* Bytes placed in block     */
+        int     ipend;                  /* Buffers primed since PCI  */
+        U64     ipendtime;              /* Time first one was primed */
+
+        /* Set from CPU and device threads, so not bit fields */
+        volatile int active;            /* Queues active             */
+        volatile int halt;              /* Halt or clear requested   */
+        volatile int opci;              /* Output PCI requested      */
+
+        unsigned int
+                established:1,          /* Queues established        */
+                debug:1;                /* Trace data path           */
+
+        U64     rxframes;               /* Frames to guest           */
+        U64     rxbytes;
+        U64     rxdrops;                /* Frames lost on input      */
+        U64     txframes;               /* Frames from guest         */
+        U64     txbytes;
+        U64     txdrops;                /* Frames lost on output     */
+        U64     sigar;                  /* SIGA-r count              */
+        U64     sigaw;                  /* SIGA-w count              */
+        U64     pcis;                   /* PCIs presented            */
+    } OSAGRP;
+
+#endif /*!defined(_QETH_H)*/
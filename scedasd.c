@@ -262,6 +262,7 @@ U32  pagesize;
         if (len > 0)
         {
             STORAGE_KEY(pageaddr, &sysblk) |= STORKEY_REF|STORKEY_CHANGE;
+            BBC_INVALIDATE(sysblk.mainstor + pageaddr, len);
             rc += len;
         }
 
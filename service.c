@@ -783,7 +783,7 @@ int servc_hresume(void *file)
             break;
         case SR_SYS_SERVC_SCPCMD:
             if ( len <= sizeof(servc_scpcmdstr) )
-                SR_READ_STRING(file, servc_scpcmdstr, sizeof(servc_scpcmdstr));
+                SR_READ_STRING(file, servc_scpcmdstr, len);
             else
                 SR_READ_SKIP(file, len);
             break;
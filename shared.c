@@ -80,7 +80,8 @@ int      i, j;                          /* Indexes                   */
         /* Add the block if it's not already there */
         if (j >= dev->shrd[i]->purgen)
         {
-            if (dev->shrd[i]->purgen >= SHARED_PURGE_MAX)
+            if (dev->shrd[i]->purgen >= (dev->shrd[i]->release >= 2
+                                       ? SHARED_PURGE_MAX2 : SHARED_PURGE_MAX))
                 dev->shrd[i]->purgen = -1;
             else
                 store_fw (dev->shrd[i]->purge[dev->shrd[i]->purgen++],
@@ -357,17 +358,25 @@ init_retry:
  *-------------------------------------------------------------------*/
 static int shared_ckd_close ( DEVBLK *dev )
 {
+    /* Receive any outstanding responses */
+    if (dev->rmtpend > 0)
+        clientDrain (dev, -1);
+
     /* Purge the cached entries */
     clientPurge (dev, 0, NULL);
 
-    /* Disconnect and close */
-    if (dev->fd >= 0)
+    /* Disconnect and close; unacknowledged writes are resent first */
+    if (dev->fd >= 0 || dev->rmtunsent > 0)
     {
         clientRequest (dev, NULL, 0, SHRD_DISCONNECT, 0, NULL, NULL);
-        close_socket (dev->fd);
+        if (dev->fd >= 0)
+            close_socket (dev->fd);
         dev->fd = -1;
     }
 
+    /* Free the writes that were never acknowledged */
+    clientRelease (dev);
+
     return 0;
 } /* shared_ckd_close */
 
@@ -596,14 +605,18 @@ static int shared_fba_close (DEVBLK *dev)
     /* Purge the cached entries */
     clientPurge (dev, 0, NULL);
 
-    /* Disconnect and close */
-    if (dev->fd >= 0)
+    /* Disconnect and close; unacknowledged writes are resent first */
+    if (dev->fd >= 0 || dev->rmtunsent > 0)
     {
         clientRequest (dev, NULL, 0, SHRD_DISCONNECT, 0, NULL, NULL);
-        close_socket (dev->fd);
+        if (dev->fd >= 0)
+            close_socket (dev->fd);
         dev->fd = -1;
     }
 
+    /* Free the writes that were never acknowledged */
+    clientRelease (dev);
+
     return 0;
 }
 
@@ -615,8 +628,9 @@ static void shared_start(DEVBLK *dev)
 int      rc;                            /* Return code               */
 U16      devnum;                        /* Cache device number       */
 int      trk;                           /* Cache track number        */
+int      i;                             /* Cache index               */
 int      code;                          /* Response code             */
-BYTE     buf[SHARED_PURGE_MAX * 4];     /* Purge list                */
+BYTE     buf[SHARED_PURGE_MAX2 * 4];    /* Purge list                */
 
     shrdtrc(dev,"start cur %d cache %d\n",dev->bufcur,dev->cache);
 
@@ -636,14 +650,15 @@ BYTE     buf[SHARED_PURGE_MAX * 4];     /* Purge list                */
     /* Check for purge */
     if (code & SHRD_PURGE)
     {
-        if (rc / 4 > SHARED_PURGE_MAX) rc = 0;
+        if (rc / 4 > SHARED_PURGE_MAX2) rc = 0;
         clientPurge (dev, rc / 4, buf);
     }
 
     /* Make previous active entry active again */
     if (dev->cache >= 0)
     {
-        cache_lock (CACHE_DEVBUF);
+        i = dev->cache;
+        cache_lock_entry (CACHE_DEVBUF, i);
         SHRD_CACHE_GETKEY (dev->cache, devnum, trk);
         if (dev->devnum == devnum && dev->bufcur == trk)
             cache_setflag(CACHE_DEVBUF, dev->cache, ~0, SHRD_CACHE_ACTIVE);
@@ -652,7 +667,7 @@ BYTE     buf[SHARED_PURGE_MAX * 4];     /* Purge list                */
             dev->cache = dev->bufcur = -1;
             dev->buf = NULL;
         }
-        cache_unlock (CACHE_DEVBUF);
+        cache_unlock_entry (CACHE_DEVBUF, i);
     }
 } /* shared_start */
 
@@ -673,9 +688,9 @@ int      rc;                            /* Return code               */
     /* Mark the active entry inactive */
     if (dev->cache >= 0)
     {
-        cache_lock (CACHE_DEVBUF);
+        cache_lock_entry (CACHE_DEVBUF, dev->cache);
         cache_setflag (CACHE_DEVBUF, dev->cache, ~SHRD_CACHE_ACTIVE, 0);
-        cache_unlock (CACHE_DEVBUF);
+        cache_unlock_entry (CACHE_DEVBUF, dev->cache);
     }
 
     /* Send the END request */
@@ -700,16 +715,29 @@ int      rc;                            /* Return code               */
 int      retries = 10;                  /* Number read retries       */
 int      cache;                         /* Lookup index              */
 int      lru;                           /* Available index           */
+U64      key;                           /* Cache key                 */
 int      len;                           /* Response length           */
 int      id;                            /* Response id               */
 BYTE    *buf;                           /* Cache buffer              */
 BYTE     code;                          /* Response code             */
 U16      devnum;                        /* Response device number    */
-BYTE     hdr[SHRD_HDR_SIZE + 4];        /* Read request header       */
+int      i, o;                          /* Read ahead cache indexes  */
+int      n = 0;                         /* Number tracks read ahead  */
+int      ra[SHARED_MAX_READAHEAD];      /* Read ahead cache entries  */
+BYTE     hdr[SHRD_HDR_SIZE + 6];        /* Read request header       */
 
     /* Initialize the unit status */
     *unitstat = 0;
 
+    /* Unit check if a pipelined write failed */
+    if (dev->rmtwerr)
+    {
+        dev->rmtwerr = 0;
+        ckd_build_sense (dev, SENSE_EC, 0, 0, FORMAT_1, MESSAGE_0);
+        *unitstat = CSW_CE | CSW_DE | CSW_UC;
+        return -1;
+    }
+
     /* Return if reading the same track image */
     if (trk == dev->bufcur && dev->cache >= 0)
     {
@@ -729,23 +757,39 @@ BYTE     hdr[SHRD_HDR_SIZE + 4];        /* Read request header       */
     dev->bufoff = 0;
     dev->bufoffhi = dev->ckdtrksz;
 
-    cache_lock (CACHE_DEVBUF);
-
     /* Inactivate the previous image */
     if (dev->cache >= 0)
+    {
+        cache_lock_entry (CACHE_DEVBUF, dev->cache);
         cache_setflag (CACHE_DEVBUF, dev->cache, ~SHRD_CACHE_ACTIVE, 0);
+        cache_unlock_entry (CACHE_DEVBUF, dev->cache);
+    }
     dev->cache = dev->bufcur = -1;
 
+    key = SHRD_CACHE_SETKEY(dev->devnum, trk);
+    cache_lock_key (CACHE_DEVBUF, key);
+
 cache_retry:
 
     /* Lookup the track in the cache */
-    cache = cache_lookup (CACHE_DEVBUF, SHRD_CACHE_SETKEY(dev->devnum, trk), &lru);
+    cache = cache_lookup (CACHE_DEVBUF, key, &lru);
+
+    /* Wait for the track if it is still being read ahead */
+    if (cache >= 0
+     && (cache_getflag (CACHE_DEVBUF, cache) & SHRD_CACHE_READING))
+    {
+        cache_unlock_key (CACHE_DEVBUF, key);
+        clientDrain (dev, cache);
+        cache_lock_key (CACHE_DEVBUF, key);
+        goto cache_retry;
+    }
 
     /* Process cache hit */
     if (cache >= 0)
     {
         cache_setflag (CACHE_DEVBUF, cache, ~0, SHRD_CACHE_ACTIVE);
-        cache_unlock (CACHE_DEVBUF);
+        cache_unlock_key (CACHE_DEVBUF, key);
+        dev->rmtnext = trk + 1;
         dev->cachehits++;
         dev->cache = cache;
         dev->buf = cache_getbuf (CACHE_DEVBUF, cache, 0);
@@ -763,7 +807,7 @@ cache_retry:
     {
         shrdtrc(dev,"ckd_read trk %d cache wait\n",trk);
         dev->cachewaits++;
-        cache_wait (CACHE_DEVBUF);
+        cache_wait (CACHE_DEVBUF, key);
         goto cache_retry;
     }
 
@@ -771,20 +815,65 @@ cache_retry:
     shrdtrc(dev,"ckd_read trk %d cache miss %d\n",trk,dev->cache);
     dev->cachemisses++;
     cache_setflag (CACHE_DEVBUF, lru, 0, SHRD_CACHE_ACTIVE|DEVBUF_TYPE_SCKD);
-    cache_setkey (CACHE_DEVBUF, lru, SHRD_CACHE_SETKEY(dev->devnum, trk));
+    cache_setkey (CACHE_DEVBUF, lru, key);
     cache_setage (CACHE_DEVBUF, lru);
     buf = cache_getbuf (CACHE_DEVBUF, lru, dev->ckdtrksz);
 
-    cache_unlock (CACHE_DEVBUF);
+    cache_unlock_key (CACHE_DEVBUF, key);
+
+    /* If the tracks are being read sequentially then also read the
+       uncached tracks following this one up to the end of the cylinder */
+    if (dev->rmtrel >= 2 && trk == dev->rmtnext)
+    {
+        for (n = 0; n < SHARED_MAX_READAHEAD; n++)
+        {
+            if ((trk + n + 1) % dev->ckdheads == 0
+             || trk + n + 1 >= dev->ckdtrks)
+                break;
+            key = SHRD_CACHE_SETKEY(dev->devnum, trk + n + 1);
+            cache_lock_key (CACHE_DEVBUF, key);
+            i = cache_lookup (CACHE_DEVBUF, key, &o);
+            if (i >= 0 || o < 0)
+            {
+                cache_unlock_key (CACHE_DEVBUF, key);
+                break;
+            }
+            cache_setflag (CACHE_DEVBUF, o, 0,
+                           SHRD_CACHE_READING|DEVBUF_TYPE_SCKD);
+            cache_setkey (CACHE_DEVBUF, o, key);
+            cache_setage (CACHE_DEVBUF, o);
+            cache_getbuf (CACHE_DEVBUF, o, dev->ckdtrksz);
+            cache_unlock_key (CACHE_DEVBUF, key);
+            ra[n] = o;
+        }
+        if (n > 0)
+            shrdtrc(dev,"ckd_read trk %d read ahead %d\n",trk,n);
+    }
+    dev->rmtnext = trk + 1;
 
 read_retry:
 
     /* Send the read request for the track to the remote host */
-    SHRD_SET_HDR (hdr, SHRD_READ, 0, dev->rmtnum, dev->rmtid, 4);
-    store_fw (hdr + SHRD_HDR_SIZE, trk);
+    if (n > 0)
+    {
+        SHRD_SET_HDR (hdr, SHRD_READMULT, 0, dev->rmtnum, dev->rmtid, 6);
+        store_fw (hdr + SHRD_HDR_SIZE, trk);
+        store_hw (hdr + SHRD_HDR_SIZE + 4, n + 1);
+    }
+    else
+    {
+        SHRD_SET_HDR (hdr, SHRD_READ, 0, dev->rmtnum, dev->rmtid, 4);
+        store_fw (hdr + SHRD_HDR_SIZE, trk);
+    }
     rc = clientSend (dev, hdr, NULL, 0);
     if (rc < 0)
     {
+        for (i = 0; i < n; i++)
+        {
+            cache_lock_entry (CACHE_DEVBUF, ra[i]);
+            cache_release (CACHE_DEVBUF, ra[i], 0);
+            cache_unlock_entry (CACHE_DEVBUF, ra[i]);
+        }
         ckd_build_sense (dev, SENSE_EC, 0, 0, FORMAT_1, MESSAGE_0);
         *unitstat = CSW_CE | CSW_DE | CSW_UC;
         logmsg(_("HHCSH022E %4.4X error reading track %d\n"), dev->devnum, trk);
@@ -797,6 +886,12 @@ read_retry:
     if (rc < 0 || code & SHRD_ERROR)
     {
         if (rc < 0 && retries--) goto read_retry;
+        for (i = 0; i < n; i++)
+        {
+            cache_lock_entry (CACHE_DEVBUF, ra[i]);
+            cache_release (CACHE_DEVBUF, ra[i], 0);
+            cache_unlock_entry (CACHE_DEVBUF, ra[i]);
+        }
         ckd_build_sense (dev, SENSE_EC, 0, 0, FORMAT_1, MESSAGE_0);
         *unitstat = CSW_CE | CSW_DE | CSW_UC;
         logmsg(_("HHCSH023E %4.4X error reading track %d\n"),
@@ -804,6 +899,19 @@ read_retry:
         return -1;
     }
 
+    /* The read ahead tracks follow; they are received when
+       referenced or before the next request is sent */
+    for (i = 0; i < n; i++)
+    {
+        dev->rmtpq[(dev->rmtpx + dev->rmtpend) % SHARED_MAX_PEND].cmd
+            = SHRD_READ;
+        dev->rmtpq[(dev->rmtpx + dev->rmtpend) % SHARED_MAX_PEND].rcd
+            = trk + i + 1;
+        dev->rmtpq[(dev->rmtpx + dev->rmtpend) % SHARED_MAX_PEND].cache
+            = ra[i];
+        dev->rmtpend++;
+    }
+
     /* Read the sense data if an i/o error occurred */
     if (code & SHRD_IOERR)
         clientRequest (dev, dev->sense, dev->numsense,
@@ -843,6 +951,15 @@ int      rc;                            /* Return code               */
         return -1;
     }
 
+    /* Unit check if a pipelined write failed */
+    if (dev->rmtwerr)
+    {
+        dev->rmtwerr = 0;
+        ckd_build_sense (dev, SENSE_EC, 0, 0, FORMAT_1, MESSAGE_0);
+        *unitstat = CSW_CE | CSW_DE | CSW_UC;
+        return -1;
+    }
+
     shrdtrc(dev,"ckd_write trk %d off %d len %d\n",trk,off,len);
 
     /* If the track is not current then read it */
@@ -918,6 +1035,7 @@ static int shared_fba_read (DEVBLK *dev, int blkgrp, BYTE *unitstat)
 int      rc;                            /* Return code               */
 int      retries = 10;                  /* Number read retries       */
 int      i, o;                          /* Cache indexes             */
+U64      key;                           /* Cache key                 */
 BYTE     code;                          /* Response code             */
 U16      devnum;                        /* Response device number    */
 int      len;                           /* Response length           */
@@ -925,6 +1043,15 @@ int      id;                            /* Response id               */
 BYTE     hdr[SHRD_HDR_SIZE + 4];        /* Read request header       */
 
 
+    /* Unit check if a pipelined write failed */
+    if (dev->rmtwerr)
+    {
+        dev->rmtwerr = 0;
+        dev->sense[0] = SENSE_EC;
+        *unitstat = CSW_CE | CSW_DE | CSW_UC;
+        return -1;
+    }
+
     /* Return if reading the same block group */
     if (blkgrp >= 0 && blkgrp == dev->bufcur)
         return 0;
@@ -940,24 +1067,29 @@ BYTE     hdr[SHRD_HDR_SIZE + 4];        /* Read request header       */
     dev->bufoff = 0;
     dev->bufoffhi = FBA_BLKGRP_SIZE;
 
-    cache_lock (CACHE_DEVBUF);
-
     /* Make the previous cache entry inactive */
     if (dev->cache >= 0)
+    {
+        cache_lock_entry (CACHE_DEVBUF, dev->cache);
         cache_setflag(CACHE_DEVBUF, dev->cache, ~FBA_CACHE_ACTIVE, 0);
+        cache_unlock_entry (CACHE_DEVBUF, dev->cache);
+    }
     dev->bufcur = dev->cache = -1;
 
+    key = FBA_CACHE_SETKEY(dev->devnum, blkgrp);
+    cache_lock_key (CACHE_DEVBUF, key);
+
 cache_retry:
 
     /* Search the cache */
-    i = cache_lookup (CACHE_DEVBUF, FBA_CACHE_SETKEY(dev->devnum, blkgrp), &o);
+    i = cache_lookup (CACHE_DEVBUF, key, &o);
 
     /* Cache hit */
     if (i >= 0)
     {
-        cache_setflag(CACHE_DEVBUF, dev->cache, ~0, FBA_CACHE_ACTIVE);
-        cache_setage(CACHE_DEVBUF, dev->cache);
-        cache_unlock(CACHE_DEVBUF);
+        cache_setflag(CACHE_DEVBUF, i, ~0, FBA_CACHE_ACTIVE);
+        cache_setage(CACHE_DEVBUF, i);
+        cache_unlock_key (CACHE_DEVBUF, key);
         dev->cachehits++;
         dev->cache = i;
         dev->buf = cache_getbuf(CACHE_DEVBUF, dev->cache, 0);
@@ -975,7 +1107,7 @@ cache_retry:
     {
         shrdtrc(dev,"fba_read blkgrp %d cache wait\n",blkgrp);
         dev->cachewaits++;
-        cache_wait(CACHE_DEVBUF);
+        cache_wait(CACHE_DEVBUF, key);
         goto cache_retry;
     }
 
@@ -983,11 +1115,11 @@ cache_retry:
     shrdtrc(dev,"fba_read blkgrp %d cache miss %d\n",blkgrp,dev->cache);
     dev->cachemisses++;
     cache_setflag(CACHE_DEVBUF, o, 0, FBA_CACHE_ACTIVE|DEVBUF_TYPE_SFBA);
-    cache_setkey (CACHE_DEVBUF, o, FBA_CACHE_SETKEY(dev->devnum, blkgrp));
+    cache_setkey (CACHE_DEVBUF, o, key);
     cache_setage (CACHE_DEVBUF, o);
     dev->buf = cache_getbuf(CACHE_DEVBUF, o, FBA_BLKGRP_SIZE);
 
-    cache_unlock (CACHE_DEVBUF);
+    cache_unlock_key (CACHE_DEVBUF, key);
 
 read_retry:
 
@@ -1042,6 +1174,15 @@ static int shared_fba_write (DEVBLK *dev, int blkgrp, int off,
 {
 int             rc;                     /* Return code               */
 
+    /* Unit check if a pipelined write failed */
+    if (dev->rmtwerr)
+    {
+        dev->rmtwerr = 0;
+        dev->sense[0] = SENSE_EC;
+        *unitstat = CSW_CE | CSW_DE | CSW_UC;
+        return -1;
+    }
+
     /* Read the block group */
     if (blkgrp != dev->bufcur)
     {
@@ -1149,6 +1290,8 @@ int         status;                     /* Response status           */
 int         id;                         /* Response identifier       */
 U16         devnum;                     /* Response device number    */
 BYTE        errmsg[SHARED_MAX_MSGLEN+1];/* Error message             */
+BYTE       *data = NULL;                /* Copy of pipelined data    */
+SHRD_PEND  *p;                          /* -> pipelined request      */
 
     /* Calculate length to write */
     len = dev->bufupdhi - dev->bufupdlo;
@@ -1160,6 +1303,16 @@ BYTE        errmsg[SHARED_MAX_MSGLEN+1];/* Error message             */
 
     shrdtrc(dev,"write rcd %d off %d len %d\n",block,dev->bufupdlo,len);
 
+    /* Don't wait for the response if the server pipelines requests.
+       The data is kept until the write is acknowledged so that it
+       can be resent if the connection is lost in the meantime */
+    if (dev->rmtrel >= 2 && dev->rmtpend < SHARED_MAX_PEND)
+    {
+        data = malloc (len);
+        if (data)
+            memcpy (data, dev->buf + dev->bufupdlo, len);
+    }
+
 write_retry:
 
     /* The write request contains a 2 byte offset and 4 byte id,
@@ -1173,11 +1326,31 @@ write_retry:
     {
         logmsg(_("HHCSH027E %4.4X error writing track %d\n"),
              dev->devnum, dev->bufcur);
+        if (data) free (data);
+        dev->rmtwerr = 1;
         dev->bufupdlo = dev->bufupdhi = 0;
         clientPurge (dev, 0, NULL);
         return -1;
     }
 
+    /* The response is received ahead of the response to the next
+       request; an error is presented as a unit check on the next i/o */
+    if (data)
+    {
+        p = &dev->rmtpq[(dev->rmtpx + dev->rmtpend) % SHARED_MAX_PEND];
+        p->cmd = SHRD_WRITE;
+        p->rcd = block;
+        p->cache = -1;
+        p->off = dev->bufupdlo;
+        p->len = len;
+        p->data = data;
+        dev->rmtpend++;
+        if (dev->rmtpend >= SHARED_MAX_PEND)
+            clientDrain (dev, -1);
+        dev->bufupdlo = dev->bufupdhi = 0;
+        return rc;
+    }
+
     /* Get the response */
     rc = clientRecv (dev, hdr, errmsg, sizeof(errmsg));
     SHRD_GET_HDR (hdr, code, status, devnum, id, len);
@@ -1186,6 +1359,7 @@ write_retry:
         if (rc < 0 && retries--) goto write_retry;
         logmsg(_("HHCSH028E %4.4X remote error writing track %d: "
          "%2.2X-%2.2X\n"), dev->devnum, dev->bufcur, code, status);
+        dev->rmtwerr = 1;
         dev->bufupdlo = dev->bufupdhi = 0;
         clientPurge (dev, 0, NULL);
         return -1;
@@ -1195,11 +1369,216 @@ write_retry:
     return rc;
 } /* clientWrite */
 
+/*-------------------------------------------------------------------
+ * Receive responses to pipelined requests (client side)
+ *
+ * Responses arrive in the order the requests were sent.  If `cache'
+ * is not negative then return once the read ahead track for that
+ * cache entry has been received, otherwise receive all of them.
+ * Writes still to be resent after a reconnect have no response yet.
+ *-------------------------------------------------------------------*/
+static int clientDrain (DEVBLK *dev, int cache)
+{
+int         rc;                         /* Return code               */
+SHRD_PEND  *p;                          /* -> pipelined request      */
+BYTE       *buf;                        /* Receive buffer            */
+BYTE        hdr[SHRD_HDR_SIZE];         /* Response header           */
+BYTE        code;                       /* Response code             */
+int         status;                     /* Response status           */
+int         id;                         /* Response identifier       */
+int         len;                        /* Response length           */
+U16         devnum;                     /* Response device number    */
+BYTE        errmsg[SHARED_MAX_MSGLEN+1];/* Error message             */
+int         i;                          /* Cache index               */
+U64         key;                        /* Cache key                 */
+
+    while (dev->rmtpend > dev->rmtunsent)
+    {
+        p = &dev->rmtpq[dev->rmtpx];
+
+        if (p->cmd == SHRD_WRITE)
+        {
+            rc = clientResponse (dev, hdr, errmsg, sizeof(errmsg));
+            SHRD_GET_HDR (hdr, code, status, devnum, id, len);
+
+            /* Keep the write to be resent if the connection is lost */
+            if (rc < 0)
+            {
+                clientDiscard (dev);
+                return -1;
+            }
+
+            free (p->data);
+            p->data = NULL;
+            if ((code & SHRD_ERROR) || (code & SHRD_IOERR))
+            {
+                logmsg(_("HHCSH028E %4.4X remote error writing track %d: "
+                 "%2.2X-%2.2X\n"), dev->devnum, p->rcd, code, status);
+                dev->rmtwerr = 1;
+                /* Drop the cached track unless it's being reread */
+                key = SHRD_CACHE_SETKEY(dev->devnum, p->rcd);
+                cache_lock_key (CACHE_DEVBUF, key);
+                i = cache_lookup (CACHE_DEVBUF, key, NULL);
+                if (i >= 0 && !(cache_getflag (CACHE_DEVBUF, i)
+                                & (SHRD_CACHE_READING|SHRD_CACHE_ACTIVE)))
+                    cache_release (CACHE_DEVBUF, i, 0);
+                cache_unlock_key (CACHE_DEVBUF, key);
+            }
+        }
+        else
+        {
+            buf = cache_getbuf (CACHE_DEVBUF, p->cache, 0);
+            rc = clientResponse (dev, hdr, buf, dev->ckdtrksz);
+            SHRD_GET_HDR (hdr, code, status, devnum, id, len);
+            shrdtrc(dev,"drain trk %d cache %d code %2.2x rc=%d\n",
+                    p->rcd, p->cache, code, rc);
+            cache_lock_entry (CACHE_DEVBUF, p->cache);
+            if (rc < 0 || (code & SHRD_ERROR) || (code & SHRD_IOERR))
+                cache_release (CACHE_DEVBUF, p->cache, 0);
+            else
+            {
+                buf[0] = 0;
+                cache_setflag (CACHE_DEVBUF, p->cache,
+                               ~SHRD_CACHE_READING, 0);
+            }
+            cache_unlock_entry (CACHE_DEVBUF, p->cache);
+        }
+
+        dev->rmtpx = (dev->rmtpx + 1) % SHARED_MAX_PEND;
+        dev->rmtpend--;
+
+        if (rc < 0)
+        {
+            clientDiscard (dev);
+            return -1;
+        }
+
+        if (cache >= 0 && p->cache == cache)
+            break;
+    }
+
+    return 0;
+} /* clientDrain */
+
+/*-------------------------------------------------------------------
+ * Discard pipelined requests after a connection error (client side)
+ *
+ * Read ahead tracks are dropped.  Unacknowledged writes are kept, in
+ * order, at the front of the queue to be resent after the reconnect.
+ * The connection is closed so that the next request reconnects and
+ * resends them first.
+ *-------------------------------------------------------------------*/
+static void clientDiscard (DEVBLK *dev)
+{
+SHRD_PEND  *p;                          /* -> pipelined request      */
+SHRD_PEND   q[SHARED_MAX_PEND];         /* Kept writes               */
+int         n = 0;                      /* Number kept writes        */
+
+    for ( ; dev->rmtpend > 0; dev->rmtpend--)
+    {
+        p = &dev->rmtpq[dev->rmtpx];
+        dev->rmtpx = (dev->rmtpx + 1) % SHARED_MAX_PEND;
+        shrdtrc(dev,"discard %2.2x trk %d cache %d\n",
+                p->cmd, p->rcd, p->cache);
+        if (p->cmd == SHRD_WRITE)
+            q[n++] = *p;
+        else
+        {
+            cache_lock_entry (CACHE_DEVBUF, p->cache);
+            cache_release (CACHE_DEVBUF, p->cache, 0);
+            cache_unlock_entry (CACHE_DEVBUF, p->cache);
+        }
+    }
+    memcpy (dev->rmtpq, q, n * sizeof(SHRD_PEND));
+    dev->rmtpx = 0;
+    dev->rmtpend = dev->rmtunsent = n;
+
+    if (dev->fd >= 0)
+    {
+        close_socket (dev->fd);
+        dev->fd = -1;
+    }
+} /* clientDiscard */
+
+/*-------------------------------------------------------------------
+ * Resend unacknowledged writes after a reconnect (client side)
+ *-------------------------------------------------------------------*/
+static int clientResend (DEVBLK *dev)
+{
+int         rc = 0;                     /* Return code               */
+SHRD_PEND  *p;                          /* -> pipelined request      */
+BYTE        hdr[SHRD_HDR_SIZE + 2 + 4]; /* Write header              */
+
+    /* A send error ends the resend instead of reconnecting again */
+    dev->rmtresend = 1;
+    while (dev->rmtunsent > 0)
+    {
+        p = &dev->rmtpq[(dev->rmtpx + dev->rmtpend - dev->rmtunsent)
+                        % SHARED_MAX_PEND];
+        shrdtrc(dev,"resend rcd %d off %d len %d\n",p->rcd,p->off,p->len);
+        SHRD_SET_HDR (hdr, SHRD_WRITE, 0, dev->rmtnum, dev->rmtid,
+                      p->len + 6);
+        store_hw (hdr + SHRD_HDR_SIZE, p->off);
+        store_fw (hdr + SHRD_HDR_SIZE + 2, p->rcd);
+        rc = clientSend (dev, hdr, p->data, p->len);
+        if (rc < 0) break;
+        dev->rmtunsent--;
+    }
+    dev->rmtresend = 0;
+
+    return rc < 0 ? -1 : 0;
+} /* clientResend */
+
+/*-------------------------------------------------------------------
+ * Release the pipelined requests when closing (client side)
+ *-------------------------------------------------------------------*/
+static void clientRelease (DEVBLK *dev)
+{
+SHRD_PEND  *p;                          /* -> pipelined request      */
+
+    clientDiscard (dev);
+    for ( ; dev->rmtpend > 0; dev->rmtpend--)
+    {
+        p = &dev->rmtpq[dev->rmtpx++];
+        logmsg(_("HHCSH067E %4.4X write of track %d lost with "
+                 "the connection\n"), dev->devnum, p->rcd);
+        free (p->data);
+        p->data = NULL;
+    }
+    dev->rmtpx = dev->rmtunsent = 0;
+} /* clientRelease */
+
 /*-------------------------------------------------------------------
  * Purge cache entries (client side)
  *-------------------------------------------------------------------*/
 static void clientPurge (DEVBLK *dev, int n, void *buf)
 {
+int             i;                      /* Cache index               */
+int             p;                      /* Purge index               */
+U64             key;                    /* Cache key                 */
+
+    /* Look up each record in the purge list by key; only a purge
+       of all the device's records needs to scan the whole cache.
+       Read ahead entries are still being received and are current */
+    if (n > 0)
+    {
+        for (p = 0; p < n; p++)
+        {
+            key = SHRD_CACHE_SETKEY(dev->devnum,
+                                    fetch_fw (((FWORD *)buf)[p]));
+            cache_lock_key (CACHE_DEVBUF, key);
+            i = cache_lookup (CACHE_DEVBUF, key, NULL);
+            if (i >= 0
+             && !(cache_getflag (CACHE_DEVBUF, i) & SHRD_CACHE_READING))
+            {
+                shrdtrc(dev,"purge %d\n",(int)fetch_fw (((FWORD *)buf)[p]));
+                cache_release (CACHE_DEVBUF, i, 0);
+            }
+            cache_unlock_key (CACHE_DEVBUF, key);
+        }
+        return;
+    }
+
     cache_lock(CACHE_DEVBUF);
     dev->rmtpurgen = n;
     dev->rmtpurge = (FWORD *)buf;
@@ -1215,7 +1594,8 @@ DEVBLK         *dev = data;             /* -> device block           */
 
     UNREFERENCED(answer);
     SHRD_CACHE_GETKEY(i, devnum, trk);
-    if (devnum == dev->devnum)
+    if (devnum == dev->devnum
+     && !(cache_getflag (ix, i) & SHRD_CACHE_READING))
     {
         if (dev->rmtpurgen == 0) {
             cache_release (ix, i, 0);
@@ -1251,13 +1631,15 @@ struct sockaddr_in iserver;             /* inet server descriptor    */
 struct sockaddr_un userver;             /* unix server descriptor    */
 #endif
 int                retries = 10;        /* Number of retries         */
+int                optval;              /* Argument for setsockopt   */
 HWORD              id;                  /* Returned identifier       */
 HWORD              comp;                /* Returned compression parm */
 
     do {
 
-        /* Close previous connection */
-        if (dev->fd >= 0) close_socket (dev->fd);
+        /* Close the previous connection; responses to pipelined
+           requests are lost with it */
+        clientDiscard (dev);
 
         /* Get a socket */
         if (dev->localhost)
@@ -1289,6 +1671,10 @@ HWORD              comp;                /* Returned compression parm */
                         dev->devnum, strerror(HSO_errno));
                 return -1;
             }
+            /* Requests are small and latency bound */
+            optval = 1;
+            setsockopt (dev->fd, IPPROTO_TCP, TCP_NODELAY,
+                        (GETSET_SOCKOPT_T*)&optval, sizeof(optval));
             iserver.sin_family      = AF_INET;
             iserver.sin_port        = htons(dev->rmtport);
             memcpy(&iserver.sin_addr.s_addr,&dev->rmtaddr,sizeof(struct in_addr));
@@ -1335,6 +1721,10 @@ HWORD              comp;                /* Returned compression parm */
                     dev->rmtcomp = fetch_hw (comp);
             }
 
+            /* Resend the writes that were not acknowledged */
+            if (rc >= 0 && dev->rmtunsent > 0)
+                rc = clientResend (dev);
+
         }
         else if (!retry)
             logmsg(_("HHCSH032E %4.4X Connect %s %d: %s\n"),
@@ -1357,7 +1747,8 @@ HWORD              comp;                /* Returned compression parm */
  *
  * Since `buf' may be NULL or not very long, response data is
  * received in a temporary buffer.  This enables us to receive
- * an error message from the remote system.
+ * an error message from the remote system.  A `buf' longer than
+ * the temporary buffer (eg the purge list) is received directly.
  *-------------------------------------------------------------------*/
 static int clientRequest (DEVBLK *dev, BYTE *buf, int len, int cmd,
                           int flags, int *code, int *status)
@@ -1371,6 +1762,7 @@ int      rid;                           /* Request return id         */
 int      rlen;                          /* Request return length     */
 BYTE     hdr[SHRD_HDR_SIZE];            /* Header                    */
 BYTE     temp[256];                     /* Temporary buffer          */
+BYTE    *rbuf;                          /* Receive buffer            */
 
 retry :
 
@@ -1382,7 +1774,8 @@ retry :
     if (rc < 0) return rc;
 
     /* Receive the response */
-    rc = clientRecv (dev, hdr, temp, sizeof(temp));
+    rbuf = buf && len > (int)sizeof(temp) ? buf : temp;
+    rc = clientRecv (dev, hdr, rbuf, rbuf == temp ? (int)sizeof(temp) : len);
 
     /* Retry recv errors */
     if (rc < 0)
@@ -1404,7 +1797,7 @@ retry :
     if (status) *status = rstatus;
 
     /* Copy the data into the caller's buffer */
-    if (buf && len > 0 && rlen > 0)
+    if (buf && len > 0 && rlen > 0 && rbuf == temp)
         memcpy (buf, temp, len < rlen ? len : rlen);
 
     return rlen;
@@ -1424,6 +1817,7 @@ retry :
 static int clientSend (DEVBLK *dev, BYTE *hdr, BYTE *buf, int buflen)
 {
 int      rc;                            /* Return code               */
+int      i;                             /* Loop index                */
 BYTE     cmd;                           /* Header command            */
 BYTE     flag;                          /* Header flags              */
 U16      devnum;                        /* Header device nu          */
@@ -1452,6 +1846,15 @@ BYTE     cbuf[SHRD_HDR_SIZE + 65536];   /* Combined buffer           */
         if (rc < 0) return -1;
     }
 
+    /* Receive outstanding read ahead tracks before sending anything
+       else, otherwise both sides could block sending to each other */
+    for (i = 0; i < dev->rmtpend; i++)
+        if (dev->rmtpq[(dev->rmtpx + i) % SHARED_MAX_PEND].cmd == SHRD_READ)
+        {
+            clientDrain (dev, -1);
+            break;
+        }
+
 #ifdef HAVE_LIBZ
     /* Compress the buf */
     if (dev->rmtcomp != 0
@@ -1499,7 +1902,7 @@ retry:
 
     /* Send the header and data */
     rc = send (dev->fd, sendbuf, sendlen, 0);
-    if (rc < 0)
+    if (rc < 0 && !dev->rmtresend)
     {
         rc = clientConnect (dev, 0);
         if (rc >= 0) goto retry;
@@ -1519,8 +1922,24 @@ retry:
 
 /*-------------------------------------------------------------------
  * Receive a response (client side)
+ *
+ * Responses to pipelined requests precede the response we want
  *-------------------------------------------------------------------*/
 static int clientRecv (DEVBLK *dev, BYTE *hdr, BYTE *buf, int buflen)
+{
+    if (dev->rmtpend > 0 && clientDrain (dev, -1) < 0)
+    {
+        memset (hdr, 0, SHRD_HDR_SIZE);
+        return -1;
+    }
+
+    return clientResponse (dev, hdr, buf, buflen);
+} /* clientRecv */
+
+/*-------------------------------------------------------------------
+ * Receive the next response (client side)
+ *-------------------------------------------------------------------*/
+static int clientResponse (DEVBLK *dev, BYTE *hdr, BYTE *buf, int buflen)
 {
 int      rc;                            /* Return code               */
 BYTE     code;                          /* Response code             */
@@ -1573,7 +1992,7 @@ int      len;                           /* Response length           */
     SHRD_SET_HDR(hdr, code, status, devnum, id, len);
 
     return len;
-} /* clientRecv */
+} /* clientResponse */
 
 /*-------------------------------------------------------------------
  * Receive data (server or client)
@@ -1723,6 +2142,7 @@ int      len;                           /* Header length             */
 int      code;                          /* Response code             */
 int      rcd;                           /* Record to read/write      */
 int      off;                           /* Offset into record        */
+int      n;                             /* Number records to read    */
 
     /* Extract header information */
     SHRD_GET_HDR (hdr, cmd, flag, devnum, id, len);
@@ -1954,6 +2374,7 @@ int      off;                           /* Offset into record        */
         break;
 
     case SHRD_READ:
+    case SHRD_READMULT:
         /* Must be active on the device for this command */
         if (dev->ioactive != id)
         {
@@ -1962,29 +2383,28 @@ int      off;                           /* Offset into record        */
             break;
         }
 
-        /* Set the compressions client is willing to accept */
-        dev->comps = dev->shrd[ix]->comps;
-        dev->comp = dev->compoff = 0;
-
-        /* Call the I/O read exit */
         rcd = (int)fetch_fw (buf);
-        rc = (dev->hnd->read) (dev, rcd, &flag);
-        shrdtrc(dev,"server_request read rcd %d flag %2.2x rc=%d\n",
-                rcd, flag, rc);
-
-        if (rc < 0)
-            code = SHRD_IOERR;
-        else
+        n = cmd == SHRD_READMULT ? fetch_hw (buf + 4) : 1;
+        if (n < 1 || n > SHARED_MAX_READAHEAD + 1)
         {
-            code = dev->comp ? SHRD_COMP : 0;
-            flag = (dev->comp << 4) | dev->compoff;
+            serverError (dev, ix, SHRD_ERROR_INVALID, cmd,
+                         "invalid read count");
+            break;
         }
 
-        /* Reset compression stuff */
-        dev->comps = dev->comp = dev->compoff = 0;
-
-        SHRD_SET_HDR (hdr, code, flag, dev->devnum, id, dev->buflen);
-        serverSend (dev, ix, hdr, dev->buf, dev->buflen);
+        /* Send a response for each record; after an i/o error the
+           remaining records are not read, so the sense is preserved */
+        for (i = 0, code = 0; i < n; i++)
+        {
+            if (code & SHRD_IOERR)
+            {
+                SHRD_SET_HDR (hdr, SHRD_IOERR, 0, dev->devnum, id, 0);
+                rc = serverSend (dev, ix, hdr, NULL, 0);
+            }
+            else
+                rc = code = serverRead (dev, ix, hdr, rcd + i);
+            if (rc < 0) break;
+        }
 
         break;
 
@@ -2105,6 +2525,44 @@ int      off;                           /* Offset into record        */
     } /* switch (cmd) */
 } /* serverRequest */
 
+/*-------------------------------------------------------------------
+ * Read a record and send it to the client (server side)
+ *
+ * Returns the response code or -1 if the send failed
+ *-------------------------------------------------------------------*/
+static int serverRead (DEVBLK *dev, int ix, BYTE *hdr, int rcd)
+{
+int      rc;                            /* Return code               */
+int      code;                          /* Response code             */
+BYTE     flag;                          /* Response flags            */
+
+    /* Set the compressions client is willing to accept */
+    dev->comps = dev->shrd[ix]->comps;
+    dev->comp = dev->compoff = 0;
+
+    /* Call the I/O read exit */
+    rc = (dev->hnd->read) (dev, rcd, &flag);
+    shrdtrc(dev,"server_request read rcd %d flag %2.2x rc=%d\n",
+            rcd, flag, rc);
+
+    if (rc < 0)
+        code = SHRD_IOERR;
+    else
+    {
+        code = dev->comp ? SHRD_COMP : 0;
+        flag = (dev->comp << 4) | dev->compoff;
+    }
+
+    /* Reset compression stuff */
+    dev->comps = dev->comp = dev->compoff = 0;
+
+    SHRD_SET_HDR (hdr, code, flag, dev->devnum, dev->shrd[ix]->id,
+                  dev->buflen);
+    rc = serverSend (dev, ix, hdr, dev->buf, dev->buflen);
+
+    return rc < 0 ? -1 : code;
+} /* serverRead */
+
 /*-------------------------------------------------------------------
  * Locate the SHRD block for a socket (server side)
  *-------------------------------------------------------------------*/
@@ -2849,6 +3307,15 @@ TID                     tid;            /* Negotiation thread id     */
                 continue;
             }
 
+            /* Responses are small and latency bound; don't let
+               Nagle hold them back waiting for the client's ack */
+            if (rsock == lsock)
+            {
+                optval = 1;
+                setsockopt (csock, IPPROTO_TCP, TCP_NODELAY,
+                            (GETSET_SOCKOPT_T*)&optval, sizeof(optval));
+            }
+
             psock = malloc (sizeof (csock));
             if (psock == NULL)
             {
@@ -143,6 +143,8 @@
  *                      in the device context and `offset' and `length'
  *                      identify what to update in `record'.
  *                      *Must* be issued within the scope of START/END.
+ *                      For release 2 the response is pipelined; see
+ *                      PIPELINING below.
  * 0xea  SENSE          Retrieves the sense information after an i/o
  *                      error has occurred on the server side.  This
  *                      is typically issued within the scope of the
@@ -160,6 +162,15 @@
  *                      *NOTE* This action should actually be SETOPT or
  *                      some such; it was just easier to code a COMPRESS
  *                      specific SETOPT (less code).
+ * 0xed  READMULT       Read consecutive records from a device.  The
+ *                      request data contains the 4-byte first `record'
+ *                      followed by a 2-byte count (1 .. 16).  The server
+ *                      sends one READ response for each record, in
+ *                      order.  After an i/o error the remaining records
+ *                      are not read and their responses are IOERR with
+ *                      no data.  Only issued when the server release
+ *                      is 2 or higher.
+ *                      *Must* be issued within the scope of START/END.
  *
  * `flag' qualifies the client request and varies by the request.
  *
@@ -231,7 +242,8 @@
  *                     the client by other systems.  Each record identifier
  *                     is a 4-byte field in the data segment.  The number
  *                     of records then is `length'/4.  If the number of
- *                     records exceeds a threshold (16) then `length'
+ *                     records exceeds a threshold (16, or 4096 for a
+ *                     release 2 client) then `length'
  *                     will be zero indicating that the client should
  *                     purge all locally cached records for the device.
  *
@@ -256,6 +268,27 @@
  * the server will indicate that the client should purge all records for
  * the device.
  *
+ * A release 2 client purges each listed record by a keyed lookup rather
+ * than by scanning the whole cache, and the server keeps a much longer
+ * list for it, so records not updated elsewhere stay cached across
+ * channel programs.  The list is delivered with the START response
+ * rather than being sent unsolicited: the client only consults its cache
+ * between START and END, and responses on the connection must arrive in
+ * request order.
+ *
+ * PIPELINING
+ *
+ * Against a release 2 server the client does not wait for the response
+ * to a WRITE; it is received (and any error reported) ahead of the
+ * response to the next request.  When the client reads tracks
+ * sequentially, a cache miss reads the rest of the cylinder (up to 16
+ * tracks) with a single READMULT request.  The first track is used as
+ * soon as it arrives; the cache entries for the others are marked
+ * `reading' until their responses are received, either when the track
+ * is referenced or before the next request is sent.  Responses are always
+ * received in the order the requests were sent, so at most one READMULT
+ * is outstanding and it is drained before anything else is sent.
+ *
  * COMPRESSION
  *
  * Data that would normally be transferred uncompressed between client
@@ -306,8 +339,7 @@
  * TODO
  *
  *  1.  More doc (sorry, I got winded)
- *  2.  Delays observed during short transfers (redrive select ?)
- *  3.  Better server side behaviour due to disconnect
+ *  2.  Better server side behaviour due to disconnect
  *  3.  etc.
  *
  *
@@ -339,7 +371,7 @@
    */
 
 #define SHARED_VERSION              0   /* Version level  (0 .. 15)  */
-#define SHARED_RELEASE              1   /* Release level  (0 .. 15)  */
+#define SHARED_RELEASE              2   /* Release level  (0 .. 15)  */
 
 #define SHARED_MAX_SYS              8   /* Max number connections    */
 typedef char SHRD_TRACE[128];           /* Trace entry               */
@@ -360,6 +392,7 @@ typedef char SHRD_TRACE[128];           /* Trace entry               */
 #define SHRD_SENSE               0xea   /* Sense                     */
 #define SHRD_QUERY               0xeb   /* Query                     */
 #define SHRD_COMPRESS            0xec   /* Compress request          */
+#define SHRD_READMULT            0xed   /* Read consecutive records  */
 
 /* Response codes                                                    */
 #define SHRD_OK                  0x00   /* Success                   */
@@ -400,6 +433,9 @@ typedef char SHRD_TRACE[128];           /* Trace entry               */
 /* Constraints                                                       */
 #define SHARED_DEFAULT_PORT      3990   /* Default shared port       */
 #define SHARED_PURGE_MAX           16   /* Max size of purge list    */
+#define SHARED_PURGE_MAX2        4096   /* Max purge list, release 2 */
+#define SHARED_MAX_READAHEAD       15   /* Max tracks read ahead     */
+#define SHARED_MAX_PEND            32   /* Max pipelined requests    */
 #define SHARED_MAX_MSGLEN         255   /* Max message length        */
 #define SHARED_TIMEOUT            120   /* Disconnect timeout (sec)  */
 #define SHARED_FORCE_TIMEOUT      300   /* Force disconnect (sec)    */
@@ -420,9 +456,18 @@ struct SHRD {
                 disconnect:1;           /* 1=Disconnect device       */
         DBLWRD  hdr;                    /* Header                    */
         int     purgen;                 /* Number purge entries      */
-        FWORD   purge[SHARED_PURGE_MAX];/* Purge list                */
+        FWORD   purge[SHARED_PURGE_MAX2];/* Purge list               */
 };
 
+typedef struct _SHRD_PEND {             /* Pipelined request (client)*/
+        int     cmd;                    /* Request                   */
+        int     rcd;                    /* Record                    */
+        int     cache;                  /* Cache entry being read    */
+        int     off;                    /* Offset of written data    */
+        int     len;                    /* Length of written data    */
+        BYTE   *data;                   /* Written data until acked  */
+} SHRD_PEND;
+
 typedef struct _SHRD_HDR {
         BYTE    cmd;                    /* 0 Command                 */
         BYTE    code;                   /* 1 Flags and Codes         */
@@ -480,6 +525,10 @@ static int     shared_used (DEVBLK *dev);
 static void    shared_reserve (DEVBLK *dev);
 static void    shared_release (DEVBLK *dev);
 static int     clientWrite (DEVBLK *dev, int block);
+static int     clientDrain (DEVBLK *dev, int cache);
+static void    clientDiscard (DEVBLK *dev);
+static int     clientResend (DEVBLK *dev);
+static void    clientRelease (DEVBLK *dev);
 static void    clientPurge (DEVBLK *dev, int n, void *buf);
 static int     clientPurgescan (int *answer, int ix, int i, void *data);
 static int     clientConnect (DEVBLK *dev, int retry);
@@ -487,8 +536,10 @@ static int     clientRequest (DEVBLK *dev, BYTE *buf, int len, int cmd,
                       int flags, int *code, int *status);
 static int     clientSend (DEVBLK *dev, BYTE *hdr, BYTE *buf, int buflen);
 static int     clientRecv (DEVBLK *dev, BYTE *hdr, BYTE *buf, int buflen);
+static int     clientResponse (DEVBLK *dev, BYTE *hdr, BYTE *buf, int buflen);
 static int     recvData(int sock, BYTE *hdr, BYTE *buf, int buflen, int server);
 static void    serverRequest (DEVBLK *dev, int ix, BYTE *hdr, BYTE *buf);
+static int     serverRead (DEVBLK *dev, int ix, BYTE *hdr, int rcd);
 static int     serverLocate (DEVBLK *dev, int id, int *avail);
 static int     serverId (DEVBLK *dev);
 static int     serverError (DEVBLK *dev, int ix, int code, int status,
@@ -935,6 +935,8 @@ int ARCH_DEP(run_sie) (REGS *regs)
     int   icode;    /* SIE longjmp intercept code      */
     BYTE  oldv;     /* siebk->v change check reference */
     BYTE *ip;       /* instruction pointer             */
+    U32   ioqueued; /* I/O interrupts queued           */
+    U32   ioqueued2;/* ... after presentation          */
 
     SIE_PERFMON(SIE_PERF_RUNSIE);
 
@@ -993,7 +995,14 @@ int ARCH_DEP(run_sie) (REGS *regs)
                     {
                         PERFORM_SERIALIZATION (GUESTREGS);
                         PERFORM_CHKPT_SYNC (GUESTREGS);
-                        ARCH_DEP (perform_io_interrupt) (GUESTREGS);
+                        do {
+                            IOINT_QUEUED(ioqueued);
+                            RELEASE_INTLOCK(regs);
+                            ARCH_DEP (perform_io_interrupt) (GUESTREGS);
+                            OBTAIN_INTLOCK(regs);
+                            IOINT_QUEUED(ioqueued2);
+                        } while (ioqueued2 != ioqueued
+                              && OPEN_IC_IOPENDING(GUESTREGS));
                     }
 
 #if defined(_FEATURE_WAITSTATE_ASSIST)
@@ -0,0 +1,405 @@
+/* SIMDOPS.C    (c) Copyright The Hercules Project, 2026             */
+/*              Vector kernels for storage-to-storage instructions   */
+
+/*   Released under the Q Public License                             */
+/*      (http://www.hercules-390.org/herclic.html)                   */
+/*   as modifications to Hercules.                                   */
+
+/*-------------------------------------------------------------------*/
+/* This module contains the inner loops of the XC, NC, OC, TR, TRT   */
+/* and TRE instructions.  The instruction routines translate the     */
+/* operand addresses and call these kernels once for each part of    */
+/* an operand that lies within a single 2K block of main storage.    */
+/*                                                                   */
+/* On x86 hosts SSE2, SSSE3 and AVX2 versions are provided and the   */
+/* best level supported by the host processor is selected at startup */
+/* by simd_init.  The `simd' command displays or lowers the level.   */
+/*                                                                   */
+/* The logical kernels process the operands left to right 16 or 32  */
+/* bytes at a time, which gives the same result as processing them   */
+/* one byte at a time unless the first operand starts within the     */
+/* second operand; that case is done a byte at a time.  TR copies    */
+/* the translation table first, so it is done a byte at a time if    */
+/* the table overlaps the first operand.                             */
+/*-------------------------------------------------------------------*/
+
+#include "hstdinc.h"
+
+#define _SIMDOPS_C_
+#define _HENGINE_DLL_
+
+#include "hercules.h"
+
+#if defined(OPTION_SIMD_STORAGE_OPS) \
+ && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) \
+ && (__GNUC__ >= 5 || defined(__clang__))
+ #define SIMD_X86
+ #include <immintrin.h>
+ #define TARGET_SSE2   __attribute__ ((target ("sse2")))
+ #define TARGET_SSSE3  __attribute__ ((target ("ssse3")))
+ #define TARGET_AVX2   __attribute__ ((target ("avx2")))
+#endif
+
+#define SIMD_NONE       0               /* Byte at a time            */
+#define SIMD_SSE2       1               /* 16 byte logical ops       */
+#define SIMD_SSSE3      2               /* 16 byte TRT               */
+#define SIMD_AVX2       3               /* 32 byte ops               */
+
+static const char *simd_names[] = { "none", "sse2", "ssse3", "avx2" };
+
+static int  simd_host;                  /* Best host supported level */
+
+SIMDOPS     simdops;                    /* Selected kernels          */
+
+/* The first operand starts within the second operand                */
+#define SIMD_OVERLAP(_dest, _src, _len) \
+        ((_src) < (_dest) && (_dest) < (_src) + (_len))
+
+/* The translation table overlaps the first operand                  */
+#define SIMD_TABOVERLAP(_dest, _len, _tab) \
+        ((_tab) < (_dest) + (_len) && (_dest) < (_tab) + 256)
+
+/*-------------------------------------------------------------------*/
+/* Byte at a time kernels                                            */
+/*-------------------------------------------------------------------*/
+#define SIMD_LOGICAL_NONE(_name, _op)                                 \
+static int _name (BYTE *dest, BYTE *src, int len)                     \
+{                                                                     \
+BYTE    r = 0;                          /* Result bytes ORed         */\
+int     i;                              /* Byte index                */\
+                                                                      \
+    for (i = 0; i < len; i++)                                         \
+        r |= (dest[i] _op src[i]);                                    \
+    return r != 0;                                                    \
+}
+
+SIMD_LOGICAL_NONE (none_xc, ^=)
+SIMD_LOGICAL_NONE (none_nc, &=)
+SIMD_LOGICAL_NONE (none_oc, |=)
+
+static void none_tr (BYTE *dest, int len, BYTE *tab)
+{
+int     i;                              /* Byte index                */
+
+    for (i = 0; i < len; i++)
+        dest[i] = tab[dest[i]];
+}
+
+static int none_trt (BYTE *src, int len, BYTE *tab)
+{
+int     i;                              /* Byte index                */
+
+    for (i = 0; i < len; i++)
+        if (tab[src[i]])
+            break;
+    return i;
+}
+
+#if defined(SIMD_X86)
+/*-------------------------------------------------------------------*/
+/* SSE2 kernels                                                      */
+/*-------------------------------------------------------------------*/
+#define SIMD_LOGICAL_SSE2(_name, _vop, _op)                           \
+static int TARGET_SSE2 _name (BYTE *dest, BYTE *src, int len)         \
+{                                                                     \
+__m128i acc = _mm_setzero_si128 ();     /* Result bytes ORed         */\
+__m128i d;                              /* Result                    */\
+BYTE    r = 0;                          /* Result bytes ORed         */\
+int     i = 0;                          /* Byte index                */\
+                                                                      \
+    if (!SIMD_OVERLAP (dest, src, len))                               \
+        for ( ; i + 16 <= len; i += 16)                               \
+        {                                                             \
+            d = _vop (_mm_loadu_si128 ((__m128i *)(dest + i)),        \
+                      _mm_loadu_si128 ((__m128i *)(src + i)));        \
+            _mm_storeu_si128 ((__m128i *)(dest + i), d);              \
+            acc = _mm_or_si128 (acc, d);                              \
+        }                                                             \
+    for ( ; i < len; i++)                                             \
+        r |= (dest[i] _op src[i]);                                    \
+    return r != 0 || _mm_movemask_epi8 (                              \
+           _mm_cmpeq_epi8 (acc, _mm_setzero_si128 ())) != 0xFFFF;     \
+}
+
+SIMD_LOGICAL_SSE2 (sse2_xc, _mm_xor_si128, ^=)
+SIMD_LOGICAL_SSE2 (sse2_nc, _mm_and_si128, &=)
+SIMD_LOGICAL_SSE2 (sse2_oc, _mm_or_si128,  |=)
+
+/*-------------------------------------------------------------------*/
+/* SSSE3 kernels                                                     */
+/*-------------------------------------------------------------------*/
+/* For TRT only whether a function byte is zero matters.  The table  */
+/* is reduced to a 256 bit map held as two 16 byte rows indexed by   */
+/* the low four bits of an argument byte: `lo' for bytes below 0x80  */
+/* and `hi' for the rest, bit n of the row byte for high bits n or   */
+/* n+8.  The leftmost bytes are tested one at a time first, as TRT   */
+/* often stops after a few bytes.                                    */
+/*-------------------------------------------------------------------*/
+#define SIMD_TRT_SCALAR 16              /* Bytes tested before map   */
+
+static void TARGET_SSE2 simd_trt_map (BYTE *tab, __m128i *lo, __m128i *hi)
+{
+__m128i zero = _mm_setzero_si128 ();    /* Zero bytes                */
+int     k;                              /* Table row                 */
+
+    *lo = *hi = zero;
+    for (k = 0; k < 8; k++)
+    {
+        *lo = _mm_or_si128 (*lo, _mm_andnot_si128 (
+                 _mm_cmpeq_epi8 (_mm_loadu_si128 ((__m128i *)(tab + 16 * k)),
+                                 zero),
+                 _mm_set1_epi8 ((char)(1 << k))));
+        *hi = _mm_or_si128 (*hi, _mm_andnot_si128 (
+                 _mm_cmpeq_epi8 (_mm_loadu_si128 ((__m128i *)(tab + 128 + 16 * k)),
+                                 zero),
+                 _mm_set1_epi8 ((char)(1 << k))));
+    }
+}
+
+static int TARGET_SSSE3 ssse3_trt (BYTE *src, int len, BYTE *tab)
+{
+__m128i lo, hi;                         /* Non-zero function map     */
+__m128i x, bits, bit;                   /* Work vectors              */
+__m128i low = _mm_set1_epi8 ((char)0x8F); /* High bit and low nibble  */
+__m128i sign = _mm_set1_epi8 ((char)0x80);/* High order bit          */
+__m128i nib = _mm_set1_epi8 (0x0F);     /* Low four bits             */
+__m128i pow2 = _mm_setr_epi8 (1, 2, 4, 8, 16, 32, 64, (char)128,
+                              1, 2, 4, 8, 16, 32, 64, (char)128);
+__m128i zero = _mm_setzero_si128 ();    /* Zero bytes                */
+int     mask;                           /* Non-zero function bytes   */
+int     i;                              /* Byte index                */
+
+    for (i = 0; i < len && i < SIMD_TRT_SCALAR; i++)
+        if (tab[src[i]])
+            return i;
+
+    if (i + 16 <= len)
+    {
+        simd_trt_map (tab, &lo, &hi);
+        for ( ; i + 16 <= len; i += 16)
+        {
+            x = _mm_loadu_si128 ((__m128i *)(src + i));
+            bits = _mm_or_si128 (
+                     _mm_shuffle_epi8 (lo, _mm_and_si128 (x, low)),
+                     _mm_shuffle_epi8 (hi, _mm_and_si128 (
+                                             _mm_xor_si128 (x, sign), low)));
+            bit = _mm_shuffle_epi8 (pow2,
+                     _mm_and_si128 (_mm_srli_epi16 (x, 4), nib));
+            mask = ~_mm_movemask_epi8 (_mm_cmpeq_epi8 (
+                      _mm_and_si128 (bits, bit), zero)) & 0xFFFF;
+            if (mask)
+                return i + __builtin_ctz (mask);
+        }
+    }
+
+    for ( ; i < len; i++)
+        if (tab[src[i]])
+            break;
+    return i;
+}
+
+/*-------------------------------------------------------------------*/
+/* AVX2 kernels                                                      */
+/*-------------------------------------------------------------------*/
+#define SIMD_LOGICAL_AVX2(_name, _vop, _vop128, _op)                 \
+static int TARGET_AVX2 _name (BYTE *dest, BYTE *src, int len)         \
+{                                                                     \
+__m256i acc = _mm256_setzero_si256 ();  /* Result bytes ORed         */\
+__m256i d;                              /* Result                    */\
+__m128i d128;                           /* Result                    */\
+BYTE    r = 0;                          /* Result bytes ORed         */\
+int     i = 0;                          /* Byte index                */\
+                                                                      \
+    if (!SIMD_OVERLAP (dest, src, len))                               \
+    {                                                                 \
+        for ( ; i + 32 <= len; i += 32)                               \
+        {                                                             \
+            d = _vop (_mm256_loadu_si256 ((__m256i *)(dest + i)),     \
+                      _mm256_loadu_si256 ((__m256i *)(src + i)));     \
+            _mm256_storeu_si256 ((__m256i *)(dest + i), d);           \
+            acc = _mm256_or_si256 (acc, d);                           \
+        }                                                             \
+        if (i + 16 <= len)                                            \
+        {                                                             \
+            d128 = _vop128 (_mm_loadu_si128 ((__m128i *)(dest + i)),  \
+                            _mm_loadu_si128 ((__m128i *)(src + i)));  \
+            _mm_storeu_si128 ((__m128i *)(dest + i), d128);           \
+            acc = _mm256_or_si256 (acc,                               \
+                                   _mm256_castsi128_si256 (d128));    \
+            i += 16;                                                  \
+        }                                                             \
+    }                                                                 \
+    for ( ; i < len; i++)                                             \
+        r |= (dest[i] _op src[i]);                                    \
+    return r != 0 || !_mm256_testz_si256 (acc, acc);                  \
+}
+
+SIMD_LOGICAL_AVX2 (avx2_xc, _mm256_xor_si256, _mm_xor_si128, ^=)
+SIMD_LOGICAL_AVX2 (avx2_nc, _mm256_and_si256, _mm_and_si128, &=)
+SIMD_LOGICAL_AVX2 (avx2_oc, _mm256_or_si256,  _mm_or_si128,  |=)
+
+/*-------------------------------------------------------------------*/
+/* TR widens the table to 32 bit entries and translates 32 bytes at  */
+/* a time with four VPGATHERDD loads, packing the results back to    */
+/* bytes.  Translating with PSHUFB needs sixteen lookups per vector  */
+/* and is no faster than a byte at a time, so SSSE3 does not use it. */
+/*-------------------------------------------------------------------*/
+static void TARGET_AVX2 avx2_tr (BYTE *dest, int len, BYTE *tab)
+{
+int     t[256];                         /* Widened table             */
+__m256i perm = _mm256_setr_epi32 (0, 4, 1, 5, 2, 6, 3, 7);
+__m256i r0, r1, r2, r3;                 /* Translated bytes          */
+__m128i lo, hi;                         /* Argument bytes            */
+int     i = 0;                          /* Byte index                */
+
+    if (len >= 128 && !SIMD_TABOVERLAP (dest, len, tab))
+    {
+        for (i = 0; i < 256; i += 8)
+            _mm256_storeu_si256 ((__m256i *)(t + i), _mm256_cvtepu8_epi32 (
+                _mm_loadl_epi64 ((__m128i *)(tab + i))));
+        for (i = 0; i + 32 <= len; i += 32)
+        {
+            lo = _mm_loadu_si128 ((__m128i *)(dest + i));
+            hi = _mm_loadu_si128 ((__m128i *)(dest + i + 16));
+            r0 = _mm256_i32gather_epi32 (t, _mm256_cvtepu8_epi32 (lo), 4);
+            r1 = _mm256_i32gather_epi32 (t, _mm256_cvtepu8_epi32 (
+                                                _mm_srli_si128 (lo, 8)), 4);
+            r2 = _mm256_i32gather_epi32 (t, _mm256_cvtepu8_epi32 (hi), 4);
+            r3 = _mm256_i32gather_epi32 (t, _mm256_cvtepu8_epi32 (
+                                                _mm_srli_si128 (hi, 8)), 4);
+            r0 = _mm256_packus_epi16 (_mm256_packus_epi32 (r0, r1),
+                                      _mm256_packus_epi32 (r2, r3));
+            _mm256_storeu_si256 ((__m256i *)(dest + i),
+                                 _mm256_permutevar8x32_epi32 (r0, perm));
+        }
+    }
+    for ( ; i < len; i++)
+        dest[i] = tab[dest[i]];
+}
+
+static int TARGET_AVX2 avx2_trt (BYTE *src, int len, BYTE *tab)
+{
+__m128i lo128, hi128;                   /* Non-zero function map     */
+__m256i lo, hi;                         /* Map rows in both lanes    */
+__m256i x, bits, bit;                   /* Work vectors              */
+__m256i low = _mm256_set1_epi8 ((char)0x8F);
+__m256i sign = _mm256_set1_epi8 ((char)0x80);
+__m256i nib = _mm256_set1_epi8 (0x0F);
+__m256i pow2 = _mm256_setr_epi8 (1, 2, 4, 8, 16, 32, 64, (char)128,
+                                 1, 2, 4, 8, 16, 32, 64, (char)128,
+                                 1, 2, 4, 8, 16, 32, 64, (char)128,
+                                 1, 2, 4, 8, 16, 32, 64, (char)128);
+__m256i zero = _mm256_setzero_si256 ();
+U32     mask;                           /* Non-zero function bytes   */
+int     i;                              /* Byte index                */
+
+    for (i = 0; i < len && i < SIMD_TRT_SCALAR; i++)
+        if (tab[src[i]])
+            return i;
+
+    if (i + 32 <= len)
+    {
+        simd_trt_map (tab, &lo128, &hi128);
+        lo = _mm256_broadcastsi128_si256 (lo128);
+        hi = _mm256_broadcastsi128_si256 (hi128);
+        for ( ; i + 32 <= len; i += 32)
+        {
+            x = _mm256_loadu_si256 ((__m256i *)(src + i));
+            bits = _mm256_or_si256 (
+                     _mm256_shuffle_epi8 (lo, _mm256_and_si256 (x, low)),
+                     _mm256_shuffle_epi8 (hi, _mm256_and_si256 (
+                                             _mm256_xor_si256 (x, sign), low)));
+            bit = _mm256_shuffle_epi8 (pow2,
+                     _mm256_and_si256 (_mm256_srli_epi16 (x, 4), nib));
+            mask = ~(U32)_mm256_movemask_epi8 (_mm256_cmpeq_epi8 (
+                      _mm256_and_si256 (bits, bit), zero));
+            if (mask)
+                return i + __builtin_ctz (mask);
+        }
+    }
+
+    for ( ; i < len; i++)
+        if (tab[src[i]])
+            break;
+    return i;
+}
+#endif /*defined(SIMD_X86)*/
+
+/*-------------------------------------------------------------------*/
+/* Select the kernels for a level                                    */
+/*-------------------------------------------------------------------*/
+static void simd_select (int level)
+{
+    simdops.level = level;
+    simdops.xc  = none_xc;
+    simdops.nc  = none_nc;
+    simdops.oc  = none_oc;
+    simdops.tr  = none_tr;
+    simdops.trt = none_trt;
+
+#if defined(SIMD_X86)
+    switch (level) {
+    case SIMD_AVX2:
+        simdops.xc  = avx2_xc;
+        simdops.nc  = avx2_nc;
+        simdops.oc  = avx2_oc;
+        simdops.tr  = avx2_tr;
+        simdops.trt = avx2_trt;
+        break;
+    case SIMD_SSSE3:
+        simdops.trt = ssse3_trt;
+        /* fallthru */
+    case SIMD_SSE2:
+        simdops.xc  = sse2_xc;
+        simdops.nc  = sse2_nc;
+        simdops.oc  = sse2_oc;
+        break;
+    }
+#endif /*defined(SIMD_X86)*/
+}
+
+/*-------------------------------------------------------------------*/
+/* Select the best kernels supported by the host processor           */
+/*-------------------------------------------------------------------*/
+void simd_init (void)
+{
+    simd_host = SIMD_NONE;
+#if defined(SIMD_X86)
+    __builtin_cpu_init ();
+    if (__builtin_cpu_supports ("avx2"))
+        simd_host = SIMD_AVX2;
+    else if (__builtin_cpu_supports ("ssse3"))
+        simd_host = SIMD_SSSE3;
+    else if (__builtin_cpu_supports ("sse2"))
+        simd_host = SIMD_SSE2;
+#endif /*defined(SIMD_X86)*/
+    simd_select (simd_host);
+}
+
+/*-------------------------------------------------------------------*/
+/* simd command - display or set the storage instruction kernels     */
+/*-------------------------------------------------------------------*/
+int simd_cmd (int argc, char *argv[], char *cmdline)
+{
+int     level;                          /* Requested level           */
+
+    UNREFERENCED(cmdline);
+
+    if (argc > 1)
+    {
+        for (level = SIMD_NONE; level <= SIMD_AVX2; level++)
+            if (strcasecmp (argv[1], simd_names[level]) == 0)
+                break;
+        if (argc > 2 || level > simd_host)
+        {
+            logmsg (_("HHCPN229E Invalid simd level %s; host supports "
+                      "up to %s\n"), argv[argc-1], simd_names[simd_host]);
+            return -1;
+        }
+        simd_select (level);
+    }
+
+    logmsg (_("HHCPN228I Storage instruction kernels %s, host supports %s\n"),
+            simd_names[simdops.level], simd_names[simd_host]);
+    return 0;
+}
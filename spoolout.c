@@ -0,0 +1,353 @@
+/* SPOOLOUT.C   (c)Copyright The Hercules Project, 2026              */
+/*              Buffered output for printer and punch devices        */
+
+/*-------------------------------------------------------------------*/
+/* This module contains the output buffering shared by the printer   */
+/* and card punch device handlers.  See spoolout.h.                  */
+/*-------------------------------------------------------------------*/
+
+#include "hstdinc.h"
+#include "hercules.h"
+
+/*-------------------------------------------------------------------*/
+/* Write data to the file, pipe or socket                            */
+/*-------------------------------------------------------------------*/
+/* Returns 0, or -1 with errno set.                                  */
+/*-------------------------------------------------------------------*/
+static int spool_out (SPOOLOUT *sp, int fd, BYTE *buf, int len)
+{
+int             rc;                     /* Return code               */
+
+    sp->writes++;
+
+#if defined(HAVE_LIBZ)
+    if (sp->gz)
+    {
+        if (gzwrite ((gzFile)sp->gz, buf, len) != len)
+        {
+            errno = EIO;
+            return -1;
+        }
+        return 0;
+    }
+#endif /*defined(HAVE_LIBZ)*/
+
+    while (len > 0)
+    {
+        errno = 0;
+        rc = sp->sock ? write_socket (fd, buf, len) : write (fd, buf, len);
+        if (rc <= 0)
+        {
+            if (errno == 0)
+                errno = EIO;
+            return -1;
+        }
+        buf += rc;
+        len -= rc;
+    }
+    return 0;
+
+} /* end function spool_out */
+
+/*-------------------------------------------------------------------*/
+/* Flusher thread                                                    */
+/*-------------------------------------------------------------------*/
+static void *spool_thread (SPOOLOUT *sp)
+{
+int             fd;                     /* File being written        */
+int             n;                      /* Bytes to write            */
+int             rc;                     /* Return code               */
+
+    obtain_lock (&sp->lock);
+
+    while (1)
+    {
+        if (sp->count == 0)
+        {
+            if (sp->shutdown)
+                break;
+            wait_condition (&sp->work, &sp->lock);
+            continue;
+        }
+
+        /* Write the data up to the end of the ring buffer.  The
+           device thread meanwhile only adds data behind it */
+        fd = sp->fd;
+        n = sp->size - sp->head;
+        if (n > sp->count)
+            n = sp->count;
+        sp->writing = 1;
+        release_lock (&sp->lock);
+
+        if (fd < 0)
+        {
+            errno = EBADF;
+            rc = -1;
+        }
+        else
+            rc = spool_out (sp, fd, sp->buf + sp->head, n);
+
+        obtain_lock (&sp->lock);
+        sp->writing = 0;
+
+        if (rc < 0)
+        {
+            /* Discard the rest until the error has been reported */
+            sp->err = errno;
+            sp->head = sp->count = 0;
+        }
+        else
+        {
+            sp->head = (sp->head + n) % sp->size;
+            sp->count -= n;
+        }
+        broadcast_condition (&sp->space);
+    }
+
+    release_lock (&sp->lock);
+    return NULL;
+
+} /* end function spool_thread */
+
+/*-------------------------------------------------------------------*/
+/* Start sending output to a file, pipe or socket                    */
+/*-------------------------------------------------------------------*/
+/* The ring buffer size and compression are set by the device        */
+/* handler beforehand.  Returns 0, or -1 with errno set.             */
+/*-------------------------------------------------------------------*/
+int spool_open (SPOOLOUT *sp, int fd, int sock)
+{
+#if defined(HAVE_LIBZ)
+int             gzfd;                   /* Descriptor for zlib       */
+#endif
+
+    if (sp->active)
+    {
+        /* (only a new socket connection, so nothing is buffered) */
+        obtain_lock (&sp->lock);
+        sp->fd = fd;
+        sp->sock = sock;
+        sp->err = 0;
+        release_lock (&sp->lock);
+        return 0;
+    }
+
+#if defined(HAVE_LIBZ)
+    /* zlib closes the descriptor it is given when the stream ends */
+    if (sp->compress && !sock)
+    {
+        if ((gzfd = dup (fd)) < 0)
+            return -1;
+        if ((sp->gz = gzdopen (gzfd, "wb")) == NULL)
+        {
+            close (gzfd);
+            errno = ENOMEM;
+            return -1;
+        }
+    }
+#endif /*defined(HAVE_LIBZ)*/
+
+    sp->fd = fd;
+    sp->sock = sock;
+    sp->err = 0;
+    sp->head = sp->count = 0;
+
+    /* Without a flusher thread the data is written immediately,
+       which is also the fallback if the thread can not be started */
+    if (sp->size == 0)
+        return 0;
+
+    if ((sp->buf = malloc (sp->size)) == NULL)
+        return 0;
+
+    initialize_lock (&sp->lock);
+    initialize_condition (&sp->work);
+    initialize_condition (&sp->space);
+    initialize_join_attr (&sp->attr);
+    sp->shutdown = 0;
+
+    if (create_thread (&sp->tid, &sp->attr, spool_thread, sp,
+                       "spool_thread"))
+    {
+        destroy_condition (&sp->space);
+        destroy_condition (&sp->work);
+        destroy_lock (&sp->lock);
+        free (sp->buf);
+        sp->buf = NULL;
+        return 0;
+    }
+    sp->active = 1;
+    return 0;
+
+} /* end function spool_open */
+
+/*-------------------------------------------------------------------*/
+/* Queue output                                                      */
+/*-------------------------------------------------------------------*/
+/* Returns 0, or -1 with errno set if this or an earlier write has   */
+/* failed.                                                           */
+/*-------------------------------------------------------------------*/
+int spool_write (SPOOLOUT *sp, void *buf, int len)
+{
+BYTE           *p = buf;                /* -> Data not yet queued    */
+int             n;                      /* Bytes to copy             */
+int             tail;                   /* Offset after newest byte  */
+struct timeval  t0, t1;                 /* Start and end of stall    */
+
+    if (sp->fd < 0)
+    {
+        errno = EBADF;
+        return -1;
+    }
+
+    sp->records++;
+    sp->bytes += len;
+
+    if (!sp->active)
+        return spool_out (sp, sp->fd, p, len);
+
+    obtain_lock (&sp->lock);
+
+    while (len > 0 && !sp->err)
+    {
+        /* Wait for the flusher thread if the buffer is full */
+        if (sp->count == sp->size)
+        {
+            sp->stalls++;
+            gettimeofday (&t0, NULL);
+            while (sp->count == sp->size && !sp->err)
+                wait_condition (&sp->space, &sp->lock);
+            gettimeofday (&t1, NULL);
+            sp->stallusecs += (U64)(t1.tv_sec - t0.tv_sec) * 1000000
+                            + (t1.tv_usec - t0.tv_usec);
+            continue;
+        }
+
+        tail = (sp->head + sp->count) % sp->size;
+        n = (tail >= sp->head ? sp->size : sp->head) - tail;
+        if (n > sp->size - sp->count)
+            n = sp->size - sp->count;
+        if (n > len)
+            n = len;
+
+        memcpy (sp->buf + tail, p, n);
+        sp->count += n;
+        p += n;
+        len -= n;
+
+        if (sp->count > sp->maxcount)
+            sp->maxcount = sp->count;
+        signal_condition (&sp->work);
+    }
+
+    if (sp->err)
+    {
+        errno = sp->err;
+        sp->err = 0;
+        release_lock (&sp->lock);
+        return -1;
+    }
+
+    release_lock (&sp->lock);
+    return 0;
+
+} /* end function spool_write */
+
+/*-------------------------------------------------------------------*/
+/* Wait until all of the output has been written                     */
+/*-------------------------------------------------------------------*/
+/* Returns 0, or -1 with errno set if a write has failed.            */
+/*-------------------------------------------------------------------*/
+int spool_flush (SPOOLOUT *sp)
+{
+int             rc = 0;                 /* Return code               */
+
+    if (!sp->active)
+        return 0;
+
+    obtain_lock (&sp->lock);
+
+    while (sp->count > 0 && !sp->err)
+        wait_condition (&sp->space, &sp->lock);
+
+    if (sp->err)
+    {
+        errno = sp->err;
+        sp->err = 0;
+        rc = -1;
+    }
+
+    release_lock (&sp->lock);
+    return rc;
+
+} /* end function spool_flush */
+
+/*-------------------------------------------------------------------*/
+/* Discard the output to a socket which is about to be closed        */
+/*-------------------------------------------------------------------*/
+void spool_detach (SPOOLOUT *sp)
+{
+    if (!sp->active)
+    {
+        sp->fd = -1;
+        return;
+    }
+
+    obtain_lock (&sp->lock);
+
+    /* Not while the flusher thread may be using the socket */
+    while (sp->writing)
+        wait_condition (&sp->space, &sp->lock);
+
+    sp->fd = -1;
+    sp->head = sp->count = 0;
+    sp->err = 0;
+
+    release_lock (&sp->lock);
+
+} /* end function spool_detach */
+
+/*-------------------------------------------------------------------*/
+/* Write the remaining output and stop the flusher thread            */
+/*-------------------------------------------------------------------*/
+/* The file itself is closed by the device handler afterwards.       */
+/* Returns 0, or -1 with errno set if a write has failed.            */
+/*-------------------------------------------------------------------*/
+int spool_close (SPOOLOUT *sp)
+{
+int             rc;                     /* Return code               */
+
+    rc = spool_flush (sp);
+
+    if (sp->active)
+    {
+        obtain_lock (&sp->lock);
+        sp->shutdown = 1;
+        signal_condition (&sp->work);
+        release_lock (&sp->lock);
+        join_thread (sp->tid, NULL);
+
+        destroy_condition (&sp->space);
+        destroy_condition (&sp->work);
+        destroy_lock (&sp->lock);
+        free (sp->buf);
+        sp->buf = NULL;
+        sp->active = 0;
+    }
+
+#if defined(HAVE_LIBZ)
+    if (sp->gz)
+    {
+        if (gzclose ((gzFile)sp->gz) != Z_OK && rc == 0)
+        {
+            errno = EIO;
+            rc = -1;
+        }
+        sp->gz = NULL;
+    }
+#endif /*defined(HAVE_LIBZ)*/
+
+    sp->fd = -1;
+    return rc;
+
+} /* end function spool_close */
@@ -0,0 +1,59 @@
+/* SPOOLOUT.H   (c)Copyright The Hercules Project, 2026              */
+/*              Buffered output for printer and punch devices        */
+
+/*-------------------------------------------------------------------*/
+/* Lines written by a printer or punch are copied into a ring buffer */
+/* and written to the file, pipe or socket by a flusher thread, so   */
+/* that the channel program need not wait for a slow pipe receiver   */
+/* or socket client.  The device thread waits only when the buffer   */
+/* is full, and these stalls are counted.  A failed write is         */
+/* reported by the next spool_write or spool_flush, after which the  */
+/* data still buffered is discarded.  Output to a file or pipe may   */
+/* also be written in gzip format.                                   */
+/*-------------------------------------------------------------------*/
+
+#include "htypes.h"
+
+#ifndef _SPOOLOUT_H_
+#define _SPOOLOUT_H_
+
+#define SPOOL_BUFSIZE   65536           /* Default ring buffer size  */
+#define SPOOL_MAXSIZE   (16*1024*1024)  /* Largest ring buffer       */
+
+typedef struct _SPOOLOUT
+{
+    BYTE       *buf;                    /* Ring buffer, or NULL      */
+    int         size;                   /* Ring buffer size, 0 to
+                                           write synchronously       */
+    int         head;                   /* Offset of oldest byte     */
+    int         count;                  /* Bytes in the ring buffer  */
+    int         fd;                     /* File, pipe or socket      */
+    int         err;                    /* errno of a failed write   */
+    void       *gz;                     /* gzip stream, or NULL      */
+    LOCK        lock;                   /* Lock for the ring buffer  */
+    COND        work;                   /* Data queued               */
+    COND        space;                  /* Data written              */
+    ATTR        attr;                   /* Flusher thread attributes */
+    TID         tid;                    /* Flusher thread            */
+    u_int       sock:1;                 /* fd is a socket            */
+    u_int       compress:1;             /* Write gzip format         */
+    u_int       active:1;               /* Flusher thread started    */
+    u_int       writing:1;              /* Flusher thread is writing */
+    u_int       shutdown:1;             /* Flusher thread must exit  */
+
+    /* Statistics, read without serialization */
+    U64         records;                /* Calls to spool_write      */
+    U64         bytes;                  /* Bytes accepted            */
+    U64         writes;                 /* Writes to the file        */
+    U64         stalls;                 /* Waits for buffer space    */
+    U64         stallusecs;             /* Microseconds waited       */
+    int         maxcount;               /* Most bytes ever buffered  */
+} SPOOLOUT;
+
+extern int  spool_open  (SPOOLOUT *sp, int fd, int sock);
+extern int  spool_write (SPOOLOUT *sp, void *buf, int len);
+extern int  spool_flush (SPOOLOUT *sp);
+extern void spool_detach(SPOOLOUT *sp);
+extern int  spool_close (SPOOLOUT *sp);
+
+#endif // _SPOOLOUT_H_
@@ -39,38 +39,495 @@ DEVBLK *dev;
     return NULL;
 }
 
-int suspend_cmd(int argc, char *argv[],char *cmdline)
+/*-------------------------------------------------------------------*/
+/* Main storage chunks                                               */
+/*-------------------------------------------------------------------*/
+typedef struct _SR_CHUNKS {
+    SR_FILE  file;                      /* Suspend file              */
+    LOCK     lock;                      /* Lock for the fields below */
+    U64      next;                      /* Next chunk to process     */
+    U64      nchunks;                   /* Number of chunks          */
+    int      incremental;               /* 1=Only changed frames     */
+    int      live;                      /* 1=CPUs are running        */
+    int      method;                    /* SR_CHUNK_RAW/SR_CHUNK_ZLIB*/
+    int      error;                     /* 1=A thread failed         */
+    U64      data;                      /* Frames written            */
+    U64      zero;                      /* Zero frames               */
+    U64      same;                      /* Unchanged frames          */
+    U64      bytes;                     /* Frame data bytes written  */
+} SR_CHUNKS;
+
+static BYTE sr_pad[4096];
+
+/* Return 1 if a 4K frame is all zeroes */
+static int sr_frame_zero (BYTE *frame)
 {
-char    *fn = SR_DEFAULT_FILENAME;
-SR_FILE  file;
-CPU_BITMAP started_mask;
-struct   timeval tv;
-time_t   tt;
-int      i, j, rc;
-REGS    *regs;
-DEVBLK  *dev;
-IOINT   *ioq;
-BYTE     psw[16];
+U64     *w = (U64 *)frame;
+U64      z;
+int      i;
+
+    for (i = 0, z = 0; i < 512 && !z; i += 8)
+        z = w[i] | w[i+1] | w[i+2] | w[i+3]
+          | w[i+4] | w[i+5] | w[i+6] | w[i+7];
+    return z == 0;
+}
 
-    UNREFERENCED(cmdline);
+/* Build and write one chunk; copy is a chunk sized buffer if live */
+static int sr_write_chunk (SR_CHUNKS *c, U64 chunk, BYTE *zbuf, U32 zbufsz,
+                           BYTE *copy)
+{
+U64      origin = chunk * SR_CHUNK_PAGES * 4096;
+U64      pg;
+U32      npages, datalen, pad;
+BYTE     hdr[SR_CHUNK_HDRLEN];
+BYTE    *frame;
+BYTE    *src;                           /* Frame data of the chunk   */
+int      k, ndata = 0, nzero = 0, nsame = 0;
+#if defined(HAVE_LIBZ)
+z_stream z;
+#endif
 
-    if (argc > 2)
+    npages = (U32)((sysblk.mainsize - origin) / 4096);
+    if (npages > SR_CHUNK_PAGES)
+        npages = SR_CHUNK_PAGES;
+
+    src = copy ? copy : sysblk.mainstor + origin;
+    memset (hdr, 0, sizeof(hdr));
+    for (k = 0; k < (int)npages; k++)
     {
-        logmsg( _("HHCSR101E Too many arguments\n"));
+        pg = (origin >> 12) + k;
+        frame = sysblk.mainstor + (pg << 12);
+
+        /* An incremental suspend only writes the frames that were
+           stored into since the last one (see sr_track_sweep)     */
+        if (c->incremental && !(sysblk.chgmap[pg] & CHGMAP_DIRTY))
+        {
+            nsame++;
+            continue;
+        }
+
+        /* While the CPUs are running the frame is copied, so that
+           the data written is consistent.  A store made after the
+           last sweep has turned a change bit on again, so the next
+           sweep marks the frame to be written again               */
+        if (sysblk.chgmap)
+            sysblk.chgmap[pg] &= ~CHGMAP_DIRTY;
+        if (copy)
+        {
+            memcpy (copy + k * 4096, frame, 4096);
+            frame = copy + k * 4096;
+        }
+
+        if (sr_frame_zero (frame))
+        {
+            hdr[56 + k/8] |= 0x80 >> (k & 7);
+            nzero++;
+        }
+        else
+        {
+            hdr[24 + k/8] |= 0x80 >> (k & 7);
+            ndata++;
+        }
+    }
+
+    datalen = ndata * 4096;
+#if defined(HAVE_LIBZ)
+    if (ndata && c->method == SR_CHUNK_ZLIB)
+    {
+        memset (&z, 0, sizeof(z));
+        if (deflateInit (&z, Z_BEST_SPEED) != Z_OK)
+            return -1;
+        z.next_out = zbuf;
+        z.avail_out = zbufsz;
+        for (k = 0; k < (int)npages; k++)
+            if (hdr[24 + k/8] & (0x80 >> (k & 7)))
+            {
+                z.next_in = src + k * 4096;
+                z.avail_in = 4096;
+                if (deflate (&z, Z_NO_FLUSH) != Z_OK)
+                {
+                    deflateEnd (&z);
+                    return -1;
+                }
+            }
+        if (deflate (&z, Z_FINISH) != Z_STREAM_END)
+        {
+            deflateEnd (&z);
+            return -1;
+        }
+        datalen = (U32)z.total_out;
+        deflateEnd (&z);
+    }
+#else
+    UNREFERENCED(zbufsz);
+#endif
+
+    obtain_lock (&c->lock);
+    c->data += ndata;
+    c->zero += nzero;
+    c->same += nsame;
+
+    /* Nothing to write for a chunk with no changed frames */
+    if (ndata + nzero == 0)
+    {
+        release_lock (&c->lock);
+        return 0;
+    }
+
+    /* Raw frame data starts on a 4K file offset */
+    pad = 0;
+    if (c->method == SR_CHUNK_RAW && ndata)
+        pad = (4096 - ((SR_TELL(c->file) + 8 + SR_CHUNK_HDRLEN) & 4095)) & 4095;
+
+    store_dw (hdr, origin);
+    store_fw (hdr + 8, npages);
+    store_fw (hdr + 12, c->method);
+    store_fw (hdr + 16, datalen);
+    store_fw (hdr + 20, pad);
+    SR_WRITE_HDR (c->file, SR_SYS_MAINCHUNK, SR_CHUNK_HDRLEN + pad + datalen);
+    if ((size_t)SR_WRITE (hdr, 1, SR_CHUNK_HDRLEN, c->file) != SR_CHUNK_HDRLEN)
+        goto sr_write_error;
+    if (pad && (size_t)SR_WRITE (sr_pad, 1, pad, c->file) != pad)
+        goto sr_write_error;
+    if (c->method == SR_CHUNK_RAW)
+    {
+        for (k = 0; k < (int)npages; k++)
+            if (hdr[24 + k/8] & (0x80 >> (k & 7)))
+                if ((size_t)SR_WRITE (src + k * 4096,
+                                      1, 4096, c->file) != 4096)
+                    goto sr_write_error;
+    }
+    else if (datalen
+          && (size_t)SR_WRITE (zbuf, 1, datalen, c->file) != datalen)
+        goto sr_write_error;
+    c->bytes += datalen;
+    release_lock (&c->lock);
+    return 0;
+
+sr_write_error:
+    release_lock (&c->lock);
+    logmsg(_("HHCSR010E write error: %s\n"), strerror(errno));
+    return -1;
+}
+
+/* Suspend thread: build and write chunks until there are no more */
+static void *sr_chunk_thread (void *arg)
+{
+SR_CHUNKS *c = arg;
+BYTE      *zbuf = NULL;
+U32        zbufsz = 0;
+BYTE      *copy = NULL;
+U64        chunk;
+
+#if defined(HAVE_LIBZ)
+    if (c->method == SR_CHUNK_ZLIB)
+    {
+        zbufsz = (U32)compressBound (SR_CHUNK_PAGES * 4096) + 64;
+        zbuf = malloc (zbufsz);
+        if (zbuf == NULL)
+        {
+            c->error = 1;
+            return NULL;
+        }
+    }
+#endif
+    if (c->live && (copy = malloc (SR_CHUNK_PAGES * 4096)) == NULL)
+    {
+        if (zbuf)
+            free (zbuf);
+        c->error = 1;
+        return NULL;
+    }
+
+    while (!c->error)
+    {
+        obtain_lock (&c->lock);
+        chunk = c->next++;
+        release_lock (&c->lock);
+        if (chunk >= c->nchunks)
+            break;
+        if (sr_write_chunk (c, chunk, zbuf, zbufsz, copy) < 0)
+            c->error = 1;
+    }
+
+    if (zbuf)
+        free (zbuf);
+    if (copy)
+        free (copy);
+    return NULL;
+}
+
+/* Write main storage using one thread per host processor;
+   returns the number of frames written or -1 if an error occurred */
+static S64 sr_write_mainstor (SR_FILE file, int incremental, int method,
+                              int live, char *fn)
+{
+SR_CHUNKS c;
+TID       tid[SR_MAX_WORKERS];
+int       i, n;
+struct timeval beg, end, dif;
+
+    memset (&c, 0, sizeof(c));
+    c.file = file;
+    c.incremental = incremental;
+    c.live = live;
+    c.method = method;
+    c.nchunks = (sysblk.mainsize / 4096 + SR_CHUNK_PAGES - 1) / SR_CHUNK_PAGES;
+    initialize_lock (&c.lock);
+
+    n = hostinfo.num_procs;
+    if (n > SR_MAX_WORKERS) n = SR_MAX_WORKERS;
+    if ((U64)n > c.nchunks) n = (int)c.nchunks;
+    if (n < 1) n = 1;
+
+    gettimeofday (&beg, NULL);
+    for (i = 0; i < n; i++)
+        if (create_thread (&tid[i], JOINABLE, sr_chunk_thread, &c,
+                           "sr_chunk_thread"))
+            break;
+    if (i == 0)
+        sr_chunk_thread (&c);
+    n = i;
+    for (i = 0; i < n; i++)
+    {
+        join_thread (tid[i], NULL);
+        detach_thread (tid[i]);
+    }
+    gettimeofday (&end, NULL);
+    timeval_subtract (&beg, &end, &dif);
+    destroy_lock (&c.lock);
+
+    if (c.error)
         return -1;
+
+    logmsg (_("HHCSR020I %s: %" I64_FMT "u frames written, %" I64_FMT "u zero,"
+              " %" I64_FMT "u unchanged, %" I64_FMT "uK data,"
+              " %d.%3.3d seconds\n"),
+            fn, c.data, c.zero, c.same, c.bytes / 1024,
+            (int)dif.tv_sec, (int)(dif.tv_usec / 1000));
+    return (S64)(c.data + c.zero);
+}
+
+/* Read one chunk; fd >= 0 if the file may be mapped */
+static int sr_read_chunk (SR_FILE file, U32 len, int fd,
+                          BYTE **zbuf, U32 *zbufsz)
+{
+BYTE     hdr[SR_CHUNK_HDRLEN];
+U64      origin;
+U32      npages, method, datalen, pad;
+int      k;
+#if defined(OPTION_SR_MMAP)
+off_t    off;
+int      j, idx;
+#endif
+#if defined(HAVE_LIBZ)
+z_stream z;
+int      rc;
+#endif
+
+    UNREFERENCED(fd);
+
+    if (len < SR_CHUNK_HDRLEN)
+        goto sr_chunk_error;
+    SR_READ_BUF (file, hdr, SR_CHUNK_HDRLEN);
+    origin  = fetch_dw (hdr);
+    npages  = fetch_fw (hdr + 8);
+    method  = fetch_fw (hdr + 12);
+    datalen = fetch_fw (hdr + 16);
+    pad     = fetch_fw (hdr + 20);
+    if ((origin & 4095)
+     || npages > SR_CHUNK_PAGES
+     || origin + (U64)npages * 4096 > sysblk.mainsize
+     || len != SR_CHUNK_HDRLEN + pad + datalen
+     || method > SR_CHUNK_ZLIB)
+        goto sr_chunk_error;
+
+    /* Frames that are already zero are not written, so that
+       untouched storage is not allocated by the host            */
+    for (k = 0; k < (int)npages; k++)
+        if (hdr[56 + k/8] & (0x80 >> (k & 7)))
+        {
+            if (!sr_frame_zero (sysblk.mainstor + origin + k * 4096))
+                memset (sysblk.mainstor + origin + k * 4096, 0, 4096);
+        }
+
+    SR_READ_SKIP (file, pad);
+
+    if (method == SR_CHUNK_RAW)
+    {
+#if defined(OPTION_SR_MMAP)
+        /* Map runs of frames so they are read when first touched */
+        off = SR_TELL (file);
+        if (fd >= 0 && SR_DIRECT (file) && (off & 4095) == 0 && datalen
+#if defined(OPTION_HUGE_STORAGE)
+         /* Huge or NUMA placed pages are not replaced by file pages */
+         && !sysblk.mainmmap
+#endif
+           )
+        {
+            for (k = idx = 0; k < (int)npages; )
+            {
+                if (!(hdr[24 + k/8] & (0x80 >> (k & 7))))
+                {
+                    k++;
+                    continue;
+                }
+                for (j = k + 1; j < (int)npages
+                             && (hdr[24 + j/8] & (0x80 >> (j & 7))); j++);
+                if (mmap (sysblk.mainstor + origin + k * 4096,
+                          (size_t)(j - k) * 4096, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_FIXED, fd,
+                          off + (off_t)idx * 4096) == MAP_FAILED)
+                    break;
+                sysblk.srmapped = 1;
+                idx += j - k;
+                k = j;
+            }
+            if (k >= (int)npages
+             && SR_SEEK (file, datalen, SEEK_CUR) == off + (off_t)datalen)
+                return 0;
+            if (k < (int)npages)
+                logmsg (_("HHCSR021W Unable to map resume file: %s\n"),
+                        strerror(errno));
+            if (SR_SEEK (file, off, SEEK_SET) != off)
+                goto sr_read_error;
+        }
+#endif
+        for (k = 0; k < (int)npages; k++)
+            if (hdr[24 + k/8] & (0x80 >> (k & 7)))
+                SR_READ_BUF (file, sysblk.mainstor + origin + k * 4096, 4096);
+        return 0;
     }
 
-    if (argc == 2)
-        fn = argv[1];
+#if defined(HAVE_LIBZ)
+    if (datalen > *zbufsz)
+    {
+        free (*zbuf);
+        *zbufsz = 0;
+        if ((*zbuf = malloc (datalen)) == NULL)
+            goto sr_chunk_error;
+        *zbufsz = datalen;
+    }
+    SR_READ_BUF (file, *zbuf, datalen);
+
+    memset (&z, 0, sizeof(z));
+    if (inflateInit (&z) != Z_OK)
+        goto sr_chunk_error;
+    z.next_in = *zbuf;
+    z.avail_in = datalen;
+    for (k = 0, rc = Z_OK; k < (int)npages && rc == Z_OK; k++)
+        if (hdr[24 + k/8] & (0x80 >> (k & 7)))
+        {
+            z.next_out = sysblk.mainstor + origin + k * 4096;
+            z.avail_out = 4096;
+            rc = inflate (&z, Z_SYNC_FLUSH);
+            if (rc == Z_STREAM_END && z.avail_out == 0)
+                rc = Z_OK;
+            else if (z.avail_out)
+                rc = Z_DATA_ERROR;
+        }
+    inflateEnd (&z);
+    if (rc != Z_OK)
+        goto sr_chunk_error;
+    return 0;
+#else
+    UNREFERENCED(zbuf);
+    UNREFERENCED(zbufsz);
+    logmsg (_("HHCSR022E Compressed storage requires zlib support\n"));
+    return -1;
+#endif
 
-    file = SR_OPEN (fn, "wb");
+sr_read_error:
+    logmsg(_("HHCSR011E read error: %s\n"), strerror(errno));
+    return -1;
+sr_chunk_error:
+    logmsg(_("HHCSR023E Storage chunk at offset %" I64_FMT "d is not valid\n"),
+           (S64)SR_TELL(file));
+    return -1;
+}
+
+/* Load the main storage of the base file of an incremental file */
+static int sr_load_base (char *fn, int depth, BYTE **zbuf, U32 *zbufsz)
+{
+SR_FILE  file;
+U32      key = 0, len = 0;
+int      fd = -1, rc = -1;
+char     buf[SR_MAX_STRING_LENGTH+1];
+
+    if (depth > SR_MAX_BASE_DEPTH)
+    {
+        logmsg (_("HHCSR024E %s: too many incremental files\n"), fn);
+        return -1;
+    }
+
+    file = SR_OPEN (fn, "rb");
     if (file == NULL)
     {
         logmsg( _("HHCSR102E %s open error: %s\n"),fn,strerror(errno));
         return -1;
     }
+#if defined(OPTION_SR_MMAP)
+    fd = hopen (fn, O_RDONLY|O_BINARY);
+#endif
+
+    SR_READ_HDR(file, key, len);
+    if (key == SR_HDR_ID) SR_READ_STRING(file, buf, len);
+    if (key != SR_HDR_ID || strcmp(buf, SR_ID))
+    {
+        logmsg( _("HHCSR104E File identifier error\n"));
+        goto sr_base_exit;
+    }
+
+    while (key != SR_EOF)
+    {
+        SR_READ_HDR(file, key, len);
+        switch (key) {
+
+        case SR_HDR_BASE:
+            SR_READ_STRING(file, buf, len);
+            if (sr_load_base (buf, depth + 1, zbuf, zbufsz) < 0)
+                goto sr_base_exit;
+            break;
+
+        case SR_SYS_MAINSTOR:
+            if (len > sysblk.mainsize)
+                goto sr_base_exit;
+            SR_READ_BUF(file, sysblk.mainstor, len);
+            break;
+
+        case SR_SYS_MAINCHUNK:
+            if (sr_read_chunk (file, len, fd, zbuf, zbufsz) < 0)
+                goto sr_base_exit;
+            break;
+
+        default:
+            SR_READ_SKIP(file, len);
+            break;
+        }
+    }
+    rc = 0;
+    goto sr_base_exit;
+
+sr_read_error:
+    logmsg(_("HHCSR011E read error: %s\n"), strerror(errno));
+    goto sr_base_exit;
+sr_string_error:
+    logmsg(_("HHCSR014E string error, incorrect length\n"));
+sr_base_exit:
+    if (rc < 0)
+        logmsg(_("HHCSR015E Error processing file %s\n"), fn);
+    if (fd >= 0)
+        close (fd);
+    SR_CLOSE (file);
+    return rc;
+}
+
+/* Stop all CPUs; returns the CPUs that were started */
+static CPU_BITMAP sr_pause_cpus ()
+{
+CPU_BITMAP started_mask;
+int      i;
 
-    /* Save CPU state and stop all CPU's */
     OBTAIN_INTLOCK(NULL);
     started_mask = sysblk.started_mask;
     while (sysblk.started_mask)
@@ -90,18 +547,25 @@ BYTE     psw[16];
     }
     RELEASE_INTLOCK(NULL);
 
+    return started_mask;
+}
+
+/* Stop all CPUs and wait for I/O to complete; returns the CPUs that
+   were started */
+static CPU_BITMAP sr_stop_cpus ()
+{
+CPU_BITMAP started_mask;
+DEVBLK  *dev;
+int      i;
+
+    started_mask = sr_pause_cpus ();
+
     /* Wait for I/O queue to clear out */
 #ifdef OPTION_FISHIO
     SLEEP (2);
 #else
-    obtain_lock (&sysblk.ioqlock);
-    while (sysblk.ioq)
-    {
-        release_lock (&sysblk.ioqlock);
+    while (ioq_pending ())
         usleep (1000);
-        obtain_lock (&sysblk.ioqlock);
-    }
-    release_lock (&sysblk.ioqlock);
 #endif
 
     /* Wait for active I/Os to complete */
@@ -118,19 +582,160 @@ BYTE     psw[16];
         logmsg( _("HHCSR104W Device %4.4X still busy, proceeding anyway\n"),
                 dev->devnum);
 
-    /* Write header */
+    return started_mask;
+}
+
+/* Restart the CPUs that were started */
+static void sr_start_cpus (CPU_BITMAP started_mask)
+{
+int      i;
+
+    OBTAIN_INTLOCK(NULL);
+    for (i = 0; i < MAX_CPU_ENGINES; i++)
+        if (IS_CPU_ONLINE(i) && (started_mask & CPU_BIT(i)))
+        {
+            sysblk.regs[i]->opinterv = 0;
+            sysblk.regs[i]->cpustate = CPUSTATE_STARTED;
+            sysblk.regs[i]->checkstop = 0;
+            WAKEUP_CPU(sysblk.regs[i]);
+        }
+    RELEASE_INTLOCK(NULL);
+}
+
+/*-------------------------------------------------------------------*/
+/* Change tracking for incremental suspend and migration             */
+/*                                                                   */
+/* Each suspend, and each migration round, first sweeps the storage  */
+/* keys with the CPUs stopped: a frame with a change bit on is       */
+/* marked CHGMAP_DIRTY, and the change bit is reset and remembered   */
+/* as CHGMAP_SAVED for the guest.  The CPUs purge their TLBs when    */
+/* they are restarted and devices set the change bit after storing,  */
+/* so any store made after the sweep turns a change bit on again     */
+/* and the frame is written by the next round.  No frame that was    */
+/* stored into can be missed.  See also STORKEY_CHGSAVE.             */
+/*-------------------------------------------------------------------*/
+
+/* Mark the frames with a change bit on and reset their change bits;
+   the CPUs must be stopped */
+static void sr_track_sweep ()
+{
+U64      pg, npages;
+BYTE    *key;
+int      u;
+
+    npages = sysblk.mainsize >> 12;
+    for (pg = 0; pg < npages; pg++)
+    {
+        key = sysblk.storkeys + (pg << 12) / STORAGE_KEY_UNITSIZE;
+        for (u = 0; u < 4096 / STORAGE_KEY_UNITSIZE; u++)
+            if (key[u] & STORKEY_CHANGE)
+            {
+                key[u] &= ~STORKEY_CHANGE;
+                sysblk.chgmap[pg] |= CHGMAP_DIRTY | (CHGMAP_SAVED << u);
+            }
+    }
+}
+
+/* Return the storage keys as the guest sees them, in storage that
+   the caller frees if it is not sysblk.storkeys; NULL on error   */
+static BYTE *sr_track_storkeys ()
+{
+BYTE    *keys;
+U64      n, pg;
+int      u;
+
+    if (sysblk.chgmap == NULL)
+        return sysblk.storkeys;
+
+    n = sysblk.mainsize / STORAGE_KEY_UNITSIZE;
+    if ((keys = malloc ((size_t)n)) == NULL)
+        return NULL;
+    memcpy (keys, sysblk.storkeys, (size_t)n);
+    for (pg = 0; pg < (sysblk.mainsize >> 12); pg++)
+        for (u = 0; u < 4096 / STORAGE_KEY_UNITSIZE; u++)
+            if (sysblk.chgmap[pg] & (CHGMAP_SAVED << u))
+                keys[(pg << 12) / STORAGE_KEY_UNITSIZE + u]
+                                                    |= STORKEY_CHANGE;
+    return keys;
+}
+
+/* Stop tracking changes, putting the reset change bits back */
+static void sr_track_free ()
+{
+CPU_BITMAP started_mask;
+U64      pg;
+int      u;
+
+    if (sysblk.chgmap)
+    {
+        started_mask = sr_pause_cpus ();
+        for (pg = 0; pg < (sysblk.mainsize >> 12); pg++)
+            for (u = 0; u < 4096 / STORAGE_KEY_UNITSIZE; u++)
+                if (sysblk.chgmap[pg] & (CHGMAP_SAVED << u))
+                    sysblk.storkeys[(pg << 12) / STORAGE_KEY_UNITSIZE + u]
+                                                    |= STORKEY_CHANGE;
+        free (sysblk.chgmap);
+        sysblk.chgmap = NULL;
+        sr_start_cpus (started_mask);
+    }
+    if (sysblk.srbase)
+        free (sysblk.srbase);
+    sysblk.srbase = NULL;
+}
+
+/* Write the header; base is the base file of an incremental file */
+static int sr_write_header (SR_FILE file, char *base)
+{
+struct   timeval tv;
+time_t   tt;
+
     SR_WRITE_STRING(file, SR_HDR_ID, SR_ID);
     SR_WRITE_STRING(file, SR_HDR_VERSION, VERSION);
     gettimeofday(&tv, NULL); tt = tv.tv_sec;
     SR_WRITE_STRING(file, SR_HDR_DATE, ctime(&tt));
+    if (base)
+        SR_WRITE_STRING(file, SR_HDR_BASE, base);
+    return 0;
+
+sr_write_error:
+    logmsg(_("HHCSR010E write error: %s\n"), strerror(errno));
+    return -1;
+sr_string_error:
+    logmsg(_("HHCSR014E string error, incorrect length\n"));
+    return -1;
+}
+
+/* Write the system, CPU and device state; the CPUs must be stopped */
+static int sr_write_state (SR_FILE file, CPU_BITMAP started_mask,
+                           int incremental, int method, char *fn)
+{
+int      i, j, rc;
+REGS    *regs;
+DEVBLK  *dev;
+IOINT   *ioq;
+BYTE     psw[16];
+BYTE    *keys;                          /* Storage keys to write     */
+size_t   nkeys;                         /* Number of storage keys    */
 
     /* Write system data */
     SR_WRITE_STRING(file,SR_SYS_ARCH_NAME,arch_name[sysblk.arch_mode]);
     SR_WRITE_VALUE (file,SR_SYS_STARTED_MASK,started_mask,sizeof(started_mask));
     SR_WRITE_VALUE (file,SR_SYS_MAINSIZE,sysblk.mainsize,sizeof(sysblk.mainsize));
-    SR_WRITE_BUF   (file,SR_SYS_MAINSTOR,sysblk.mainstor,sysblk.mainsize);
+
+    if (sr_write_mainstor (file, incremental, method, 0, fn) < 0)
+        return -1;
     SR_WRITE_VALUE (file,SR_SYS_SKEYSIZE,sysblk.mainsize/STORAGE_KEY_UNITSIZE,sizeof(int));
-    SR_WRITE_BUF   (file,SR_SYS_STORKEYS,sysblk.storkeys,sysblk.mainsize/STORAGE_KEY_UNITSIZE);
+
+    /* The storage keys are written with the tracked change bits */
+    nkeys = (size_t)(sysblk.mainsize / STORAGE_KEY_UNITSIZE);
+    SR_WRITE_HDR   (file,SR_SYS_STORKEYS,nkeys);
+    if ((keys = sr_track_storkeys ()) == NULL)
+        goto sr_write_error;
+    rc = (size_t)SR_WRITE (keys, 1, nkeys, file) == nkeys;
+    if (keys != sysblk.storkeys)
+        free (keys);
+    if (!rc)
+        goto sr_write_error;
     SR_WRITE_VALUE (file,SR_SYS_XPNDSIZE,sysblk.xpndsize,sizeof(sysblk.xpndsize));
     SR_WRITE_BUF   (file,SR_SYS_XPNDSTOR,sysblk.xpndstor,sysblk.xpndsize);
     SR_WRITE_VALUE (file,SR_SYS_CPUID,sysblk.cpuid,sizeof(sysblk.cpuid));
@@ -141,22 +746,23 @@ BYTE     psw[16];
     SR_WRITE_VALUE (file,SR_SYS_MBM,sysblk.mbm,sizeof(sysblk.mbm));
     SR_WRITE_VALUE (file,SR_SYS_MBD,sysblk.mbd,sizeof(sysblk.mbd));
 
-    for (ioq = sysblk.iointq; ioq; ioq = ioq->next)
-        if (ioq->pcipending)
-        {
-            SR_WRITE_VALUE(file,SR_SYS_PCIPENDING_LCSS, SSID_TO_LCSS(ioq->dev->ssid),sizeof(U16));
-            SR_WRITE_VALUE(file,SR_SYS_PCIPENDING, ioq->dev->devnum,sizeof(ioq->dev->devnum));
-        }
-        else if (ioq->attnpending)
-        {
-            SR_WRITE_VALUE(file,SR_SYS_ATTNPENDING_LCSS, SSID_TO_LCSS(ioq->dev->ssid),sizeof(U16));
-            SR_WRITE_VALUE(file,SR_SYS_ATTNPENDING, ioq->dev->devnum,sizeof(ioq->dev->devnum));
-        }
-        else
-        {
-            SR_WRITE_VALUE(file,SR_SYS_IOPENDING_LCSS, SSID_TO_LCSS(ioq->dev->ssid),sizeof(U16));
-            SR_WRITE_VALUE(file,SR_SYS_IOPENDING, ioq->dev->devnum,sizeof(ioq->dev->devnum));
-        }
+    for (j = 0; j < IOINTQ_MAX; j++)
+        for (ioq = sysblk.iointq[j].head; ioq; ioq = ioq->next)
+            if (ioq->pcipending)
+            {
+                SR_WRITE_VALUE(file,SR_SYS_PCIPENDING_LCSS, SSID_TO_LCSS(ioq->dev->ssid),sizeof(U16));
+                SR_WRITE_VALUE(file,SR_SYS_PCIPENDING, ioq->dev->devnum,sizeof(ioq->dev->devnum));
+            }
+            else if (ioq->attnpending)
+            {
+                SR_WRITE_VALUE(file,SR_SYS_ATTNPENDING_LCSS, SSID_TO_LCSS(ioq->dev->ssid),sizeof(U16));
+                SR_WRITE_VALUE(file,SR_SYS_ATTNPENDING, ioq->dev->devnum,sizeof(ioq->dev->devnum));
+            }
+            else
+            {
+                SR_WRITE_VALUE(file,SR_SYS_IOPENDING_LCSS, SSID_TO_LCSS(ioq->dev->ssid),sizeof(U16));
+                SR_WRITE_VALUE(file,SR_SYS_IOPENDING, ioq->dev->devnum,sizeof(ioq->dev->devnum));
+            }
 
     for (i = 0; i < 8; i++)
         SR_WRITE_VALUE(file,SR_SYS_CHP_RESET+i,sysblk.chp_reset[i],sizeof(sysblk.chp_reset[0]));
@@ -282,38 +888,145 @@ BYTE     psw[16];
         if (dev->hnd->hsuspend)
         {
             rc = (dev->hnd->hsuspend) (dev, file);
-            if (rc < 0) goto sr_error_exit;
+            if (rc < 0) return -1;
         }
         SR_WRITE_HDR(file, SR_DELIMITER, 0);
     }
 
     SR_WRITE_HDR(file, SR_EOF, 0);
-    SR_CLOSE (file);
-
-    /* Shutdown */
-    do_shutdown();
-
     return 0;
 
 sr_write_error:
     logmsg(_("HHCSR010E write error: %s\n"), strerror(errno));
-    goto sr_error_exit;
+    return -1;
 sr_value_error:
     logmsg(_("HHCSR013E value error, incorrect length\n"));
-    goto sr_error_exit;
+    return -1;
 sr_string_error:
     logmsg(_("HHCSR014E string error, incorrect length\n"));
-    goto sr_error_exit;
-sr_error_exit:
-    logmsg(_("HHCSR015E error processing file %s\n"),fn);
-    SR_CLOSE (file);
     return -1;
 }
 
-int resume_cmd(int argc, char *argv[],char *cmdline)
+int suspend_cmd(int argc, char *argv[],char *cmdline)
 {
 char    *fn = SR_DEFAULT_FILENAME;
 SR_FILE  file;
+CPU_BITMAP started_mask;
+int      i;
+int      incremental = 0;               /* 1=Only changed frames     */
+int      cont = 0;                      /* 1=Continue after suspend  */
+int      method = SR_CHUNK_RAW;         /* Frame data method         */
+int      havefn = 0;
+
+    UNREFERENCED(cmdline);
+
+#if defined(HAVE_LIBZ)
+    method = SR_CHUNK_ZLIB;
+#endif
+    for (i = 1; i < argc; i++)
+    {
+        if (strcasecmp (argv[i], "incremental") == 0)
+            incremental = 1;
+        else if (strcasecmp (argv[i], "continue") == 0)
+            cont = 1;
+        else if (strcasecmp (argv[i], "raw") == 0)
+            method = SR_CHUNK_RAW;
+        else if (!havefn)
+        {
+            fn = argv[i];
+            havefn = 1;
+        }
+        else
+        {
+            logmsg( _("HHCSR101E Too many arguments\n"));
+            return -1;
+        }
+    }
+
+    if (incremental)
+    {
+        if (sysblk.chgmap == NULL || sysblk.srbase == NULL)
+        {
+            logmsg( _("HHCSR025E Incremental suspend requires a previous"
+                      " suspend with continue\n"));
+            return -1;
+        }
+        if (strcmp (fn, sysblk.srbase) == 0)
+        {
+            logmsg( _("HHCSR026E %s is the base file of the incremental"
+                      " suspend\n"), fn);
+            return -1;
+        }
+    }
+
+#if defined(OPTION_SR_MMAP)
+    /* Main storage may still map pages of the file being replaced */
+    if (sysblk.srmapped)
+        unlink (fn);
+#endif
+
+    file = SR_OPEN (fn, SR_WRITE_MODE);
+    if (file == NULL)
+    {
+        logmsg( _("HHCSR102E %s open error: %s\n"),fn,strerror(errno));
+        return -1;
+    }
+
+    started_mask = sr_stop_cpus ();
+
+    /* Start tracking changes for the next incremental suspend */
+    if (cont && sysblk.chgmap == NULL)
+    {
+        sysblk.chgmap = calloc ((size_t)(sysblk.mainsize >> 12), 1);
+        if (sysblk.chgmap == NULL)
+            logmsg( _("HHCSR027W Unable to track changes for incremental"
+                      " suspend: %s\n"), strerror(errno));
+    }
+    if (sysblk.chgmap)
+        sr_track_sweep ();
+
+    if (sr_write_header (file, incremental ? sysblk.srbase : NULL) < 0
+     || sr_write_state (file, started_mask, incremental, method, fn) < 0)
+        goto sr_error_exit;
+    if (SR_CLOSE (file) != 0)
+    {
+        file = NULL;
+        logmsg(_("HHCSR010E write error: %s\n"), strerror(errno));
+        goto sr_error_exit;
+    }
+
+    if (!cont)
+    {
+        /* Shutdown */
+        do_shutdown();
+        return 0;
+    }
+
+    /* The next incremental suspend is taken after this one */
+    if (sysblk.chgmap)
+    {
+        if (sysblk.srbase)
+            free (sysblk.srbase);
+        sysblk.srbase = strdup (fn);
+    }
+
+    /* Restart the CPUs */
+    sr_start_cpus (started_mask);
+
+    return 0;
+
+sr_error_exit:
+    logmsg(_("HHCSR015E error processing file %s\n"),fn);
+    if (file)
+        SR_CLOSE (file);
+    /* Frames marked as written may be missing from the file */
+    sr_track_free ();
+    return -1;
+}
+
+/* Resume from a suspend file or stream; fd >= 0 if it may be mapped */
+static int sr_resume (SR_FILE file, char *fn, int fd)
+{
 U32      key = 0, len = 0;
 CPU_BITMAP started_mask = 0;
 int      i, rc;
@@ -325,42 +1038,16 @@ int      devargc=0;
 char    *devargv[16];
 int      devargx=0;
 DEVBLK  *dev = NULL;
-IOINT   *ioq = NULL;
 char     buf[SR_MAX_STRING_LENGTH+1];
 char     zeros[16];
 S64      dreg;
-
-    UNREFERENCED(cmdline);
-
-    if (argc > 2)
-    {
-        logmsg( _("HHCSR101E Too many arguments\n"));
-        return -1;
-    }
-
-    if (argc == 2)
-        fn = argv[1];
+BYTE    *zbuf = NULL;                   /* Compressed chunk buffer   */
+U32      zbufsz = 0;                    /* Size of zbuf              */
 
     memset (zeros, 0, sizeof(zeros));
 
-    /* Make sure all CPUs are deconfigured or stopped */
-    OBTAIN_INTLOCK(NULL);
-    for (i = 0; i < MAX_CPU_ENGINES; i++)
-        if (IS_CPU_ONLINE(i)
-         && CPUSTATE_STOPPED != sysblk.regs[i]->cpustate)
-        {
-            RELEASE_INTLOCK(NULL);
-            logmsg( _("HHCSR103E All CPU's must be stopped to resume\n") );
-            return -1;
-        }
-    RELEASE_INTLOCK(NULL);
-
-    file = SR_OPEN (fn, "rb");
-    if (file == NULL)
-    {
-        logmsg( _("HHCSR102E %s open error: %s\n"),fn,strerror(errno));
-        return -1;
-    }
+    /* Main storage is replaced, so changes are no longer tracked */
+    sr_track_free ();
 
     /* First key must be SR_HDR_ID and string must match SR_ID */
     SR_READ_HDR(file, key, len);
@@ -388,6 +1075,13 @@ S64      dreg;
             logmsg( _("HHCSR001I Resuming suspended file created %s"), buf);
             break;
 
+        case SR_HDR_BASE:
+            SR_READ_STRING(file, buf, len);
+            logmsg( _("HHCSR002I Loading main storage of base file %s\n"), buf);
+            if (sr_load_base (buf, 1, &zbuf, &zbufsz) < 0)
+                goto sr_error_exit;
+            break;
+
         case SR_SYS_STARTED_MASK:
             SR_READ_VALUE(file, len, &started_mask, sizeof(started_mask));
             break;
@@ -463,6 +1157,11 @@ S64      dreg;
             SR_READ_BUF(file, sysblk.mainstor, len);
             break;
 
+        case SR_SYS_MAINCHUNK:
+            if (sr_read_chunk (file, len, fd, &zbuf, &zbufsz) < 0)
+                goto sr_error_exit;
+            break;
+
         case SR_SYS_SKEYSIZE:
             SR_READ_VALUE(file, len, &len, sizeof(len));
             if (len > sysblk.mainsize/STORAGE_KEY_UNITSIZE)
@@ -532,15 +1231,9 @@ S64      dreg;
             break;
 
         case SR_SYS_IOPENDING:
+            /* Queued again by the device pending records, after
+               the subchannel (and so the subclass) is restored */
             SR_READ_VALUE(file, len, &hw, sizeof(hw));
-            dev = find_device_by_devnum(lcss,hw);
-            if (dev == NULL) break;
-            if (ioq == NULL)
-                sysblk.iointq = &dev->ioint;
-            else
-                ioq->next = &dev->ioint;
-            ioq = &dev->ioint;
-            dev = NULL;
             lcss = 0;
             break;
 
@@ -549,15 +1242,9 @@ S64      dreg;
             break;
 
         case SR_SYS_PCIPENDING:
+            /* Queued again by the device pending records, after
+               the subchannel (and so the subclass) is restored */
             SR_READ_VALUE(file, len, &hw, sizeof(hw));
-            dev = find_device_by_devnum(lcss,hw);
-            if (dev == NULL) break;
-            if (ioq == NULL)
-                sysblk.iointq = &dev->pciioint;
-            else
-                ioq->next = &dev->pciioint;
-            ioq = &dev->pciioint;
-            dev = NULL;
             lcss = 0;
             break;
 
@@ -566,15 +1253,9 @@ S64      dreg;
             break;
 
         case SR_SYS_ATTNPENDING:
+            /* Queued again by the device pending records, after
+               the subchannel (and so the subclass) is restored */
             SR_READ_VALUE(file, len, &hw, sizeof(hw));
-            dev = find_device_by_devnum(lcss,hw);
-            if (dev == NULL) break;
-            if (ioq == NULL)
-                sysblk.iointq = &dev->attnioint;
-            else
-                ioq->next = &dev->attnioint;
-            ioq = &dev->attnioint;
-            dev = NULL;
             lcss = 0;
             break;
 
@@ -1315,6 +1996,9 @@ S64      dreg;
 #endif
     machine_check_crwpend();
 
+    /* Discard the blocks built from the storage replaced */
+    BBC_INVALIDATE(sysblk.mainstor, sysblk.mainsize);
+
     /* Start the CPUs */
     OBTAIN_INTLOCK(NULL);
     ON_IC_IOPENDING;
@@ -1328,6 +2012,8 @@ S64      dreg;
         }
     RELEASE_INTLOCK(NULL);
 
+    if (zbuf)
+        free (zbuf);
     return 0;
 
 sr_read_error:
@@ -1349,6 +2035,380 @@ sr_null_regs_exit:
     goto sr_error_exit;
 sr_error_exit:
     logmsg(_("HHCSR015E Error processing file %s\n"), fn);
-    SR_CLOSE (file);
+    if (zbuf)
+        free (zbuf);
     return -1;
 }
+
+/* Check that all CPUs are deconfigured or stopped */
+static int sr_cpus_stopped ()
+{
+int      i;
+
+    OBTAIN_INTLOCK(NULL);
+    for (i = 0; i < MAX_CPU_ENGINES; i++)
+        if (IS_CPU_ONLINE(i)
+         && CPUSTATE_STOPPED != sysblk.regs[i]->cpustate)
+        {
+            RELEASE_INTLOCK(NULL);
+            logmsg( _("HHCSR103E All CPU's must be stopped to resume\n") );
+            return 0;
+        }
+    RELEASE_INTLOCK(NULL);
+    return 1;
+}
+
+int resume_cmd(int argc, char *argv[],char *cmdline)
+{
+char    *fn = SR_DEFAULT_FILENAME;
+SR_FILE  file;
+int      fd = -1;                       /* Descriptor for mapping    */
+int      rc;
+
+    UNREFERENCED(cmdline);
+
+    if (argc > 2)
+    {
+        logmsg( _("HHCSR101E Too many arguments\n"));
+        return -1;
+    }
+
+    if (argc == 2)
+        fn = argv[1];
+
+    if (!sr_cpus_stopped ())
+        return -1;
+
+    file = SR_OPEN (fn, "rb");
+    if (file == NULL)
+    {
+        logmsg( _("HHCSR102E %s open error: %s\n"),fn,strerror(errno));
+        return -1;
+    }
+#if defined(OPTION_SR_MMAP)
+    fd = hopen (fn, O_RDONLY|O_BINARY);
+#endif
+
+    rc = sr_resume (file, fn, fd);
+
+    if (fd >= 0)
+        close (fd);
+    SR_CLOSE (file);
+    return rc;
+}
+
+#if defined(OPTION_SR_MIGRATE)
+/*-------------------------------------------------------------------*/
+/* Live migration                                                    */
+/*-------------------------------------------------------------------*/
+typedef struct _SR_MIGRATE {
+    int      sock;                      /* Connected/listen socket   */
+    int      method;                    /* SR_CHUNK_RAW/SR_CHUNK_ZLIB*/
+    char     name[256];                 /* Peer host:port            */
+} SR_MIGRATE;
+
+static int sr_migrating;                /* 1=Migrate thread active   */
+
+/* Send the system to another hercules while the CPUs are running */
+static void *sr_migrate_thread (void *arg)
+{
+SR_MIGRATE *m = arg;
+SR_FILE  file = NULL;
+CPU_BITMAP started_mask = 0;
+int      stopped = 0;                   /* 1=CPUs have been stopped  */
+int      fd, rc, round;
+S64      n;
+BYTE     ack;
+struct timeval beg, end, dif;
+
+    /* The change map describes what the receiver has, so any
+       tracking for incremental suspend files is restarted       */
+    sr_track_free ();
+    sysblk.chgmap = calloc ((size_t)(sysblk.mainsize >> 12), 1);
+    if (sysblk.chgmap == NULL)
+    {
+        logmsg (_("HHCSR030E Unable to track changed frames: %s\n"),
+                strerror(errno));
+        goto sr_migrate_exit;
+    }
+
+    fd = dup (m->sock);
+    if (fd < 0 || (file = SR_FDOPEN (fd, SR_WRITE_MODE)) == NULL)
+    {
+        logmsg (_("HHCSR031E %s: %s failed: %s\n"), m->name, "open",
+                strerror(errno));
+        if (fd >= 0)
+            close (fd);
+        goto sr_migrate_exit;
+    }
+
+    if (sr_write_header (file, NULL) < 0)
+        goto sr_migrate_exit;
+    SR_WRITE_VALUE (file,SR_SYS_MAINSIZE,sysblk.mainsize,sizeof(sysblk.mainsize));
+
+    /* Send main storage while the CPUs are running, until a round
+       finds few enough changed frames.  The CPUs are only stopped
+       while each round marks the frames stored into since the last */
+    for (round = 0; round < SR_MIGRATE_ROUNDS; )
+    {
+        started_mask = sr_pause_cpus ();
+        sr_track_sweep ();
+        sr_start_cpus (started_mask);
+
+        n = sr_write_mainstor (file, round > 0, m->method, 1, m->name);
+        if (n < 0)
+            goto sr_migrate_exit;
+        if (round++ > 0 && n <= SR_MIGRATE_DIRTY)
+            break;
+    }
+
+    /* Stop the CPUs and send every frame stored into since the last
+       round with the rest of the state */
+    gettimeofday (&beg, NULL);
+    started_mask = sr_stop_cpus ();
+    stopped = 1;
+    sr_track_sweep ();
+    if (sr_write_state (file, started_mask, 1, m->method, m->name) < 0)
+        goto sr_migrate_exit;
+    rc = SR_CLOSE (file);
+    file = NULL;
+    if (rc != 0)
+        goto sr_write_error;
+
+    /* Wait for the receiver to resume the system */
+    shutdown (m->sock, SHUT_WR);
+    if (recv (m->sock, &ack, 1, 0) != 1 || ack != 0)
+    {
+        logmsg (_("HHCSR032E %s did not resume the system\n"), m->name);
+        goto sr_migrate_exit;
+    }
+    gettimeofday (&end, NULL);
+    timeval_subtract (&beg, &end, &dif);
+    logmsg (_("HHCSR033I Migrated to %s in %d rounds, CPUs stopped for"
+              " %d.%3.3d seconds\n"), m->name, round + 1,
+            (int)dif.tv_sec, (int)(dif.tv_usec / 1000));
+
+    close_socket (m->sock);
+    free (m);
+    sr_track_free ();
+    sr_migrating = 0;
+    do_shutdown ();
+    return NULL;
+
+sr_write_error:
+    logmsg(_("HHCSR010E write error: %s\n"), strerror(errno));
+    goto sr_migrate_exit;
+sr_value_error:
+    logmsg(_("HHCSR013E value error, incorrect length\n"));
+    goto sr_migrate_exit;
+sr_migrate_exit:
+    logmsg (_("HHCSR034E Migration to %s failed\n"), m->name);
+    if (file)
+        SR_CLOSE (file);
+    close_socket (m->sock);
+    sr_track_free ();
+    if (stopped)
+        sr_start_cpus (started_mask);
+    free (m);
+    sr_migrating = 0;
+    return NULL;
+}
+
+/* Receive a system sent by another hercules */
+static void *sr_listen_thread (void *arg)
+{
+SR_MIGRATE *m = arg;
+SR_FILE  file;
+struct sockaddr_in client;
+socklen_t namelen = sizeof(client);
+int      csock, fd, rc = -1;
+BYTE     ack;
+
+    csock = accept (m->sock, (struct sockaddr *)&client, &namelen);
+    close_socket (m->sock);
+    if (csock < 0)
+    {
+        logmsg (_("HHCSR031E %s: %s failed: %s\n"), m->name, "accept",
+                strerror(HSO_errno));
+        free (m);
+        sr_migrating = 0;
+        return NULL;
+    }
+    snprintf (m->name, sizeof(m->name), "%s:%d",
+              inet_ntoa (client.sin_addr), ntohs (client.sin_port));
+    logmsg (_("HHCSR036I Receiving system from %s\n"), m->name);
+
+    if (sr_cpus_stopped ())
+    {
+        fd = dup (csock);
+        if (fd >= 0 && (file = SR_FDOPEN (fd, "rb")) != NULL)
+        {
+            rc = sr_resume (file, m->name, -1);
+            SR_CLOSE (file);
+        }
+        else
+        {
+            logmsg (_("HHCSR031E %s: %s failed: %s\n"), m->name, "open",
+                    strerror(errno));
+            if (fd >= 0)
+                close (fd);
+        }
+    }
+
+    /* Tell the sender whether it may terminate */
+    ack = rc < 0;
+    send (csock, &ack, 1, 0);
+    close_socket (csock);
+    if (rc == 0)
+        logmsg (_("HHCSR037I System received from %s\n"), m->name);
+    free (m);
+    sr_migrating = 0;
+    return NULL;
+}
+
+int migrate_cmd(int argc, char *argv[],char *cmdline)
+{
+SR_MIGRATE *m;
+struct sockaddr_in addr;
+struct hostent *he;
+char    *host, *port;
+char     c;
+U16      portnum;
+int      listening = 0;                 /* 1=migrate listen          */
+int      optval, rc;
+TID      tid;
+
+    UNREFERENCED(cmdline);
+
+    if (argc < 2 || (argc == 2 && strcasecmp (argv[1], "listen") == 0))
+    {
+        logmsg( _("HHCSR038E Missing host:port or listen port\n"));
+        return -1;
+    }
+    if (argc > 3)
+    {
+        logmsg( _("HHCSR101E Too many arguments\n"));
+        return -1;
+    }
+    if (sr_migrating)
+    {
+        logmsg( _("HHCSR039E Migration is already in progress\n"));
+        return -1;
+    }
+
+    if ((m = malloc (sizeof(SR_MIGRATE))) == NULL)
+    {
+        logmsg( _("HHCSR031E %s: %s failed: %s\n"), argv[1], "malloc",
+                strerror(errno));
+        return -1;
+    }
+#if defined(HAVE_LIBZ)
+    m->method = SR_CHUNK_ZLIB;
+#else
+    m->method = SR_CHUNK_RAW;
+#endif
+
+    memset (&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    if (strcasecmp (argv[1], "listen") == 0)
+    {
+        listening = 1;
+        strlcpy (m->name, argv[2], sizeof(m->name));
+        addr.sin_addr.s_addr = INADDR_ANY;
+        port = m->name;
+    }
+    else
+    {
+        if (argc == 3 && strcasecmp (argv[2], "raw") == 0)
+            m->method = SR_CHUNK_RAW;
+        else if (argc == 3)
+        {
+            logmsg( _("HHCSR101E Too many arguments\n"));
+            free (m);
+            return -1;
+        }
+        strlcpy (m->name, argv[1], sizeof(m->name));
+        host = m->name;
+        he = NULL;
+        if ((port = strchr (host, ':')) != NULL)
+        {
+            *port = '\0';
+            he = gethostbyname (host);
+            *port++ = ':';
+        }
+        if (he == NULL)
+        {
+            logmsg( _("HHCSR040E Invalid host:port %s\n"), argv[1]);
+            free (m);
+            return -1;
+        }
+        memcpy (&addr.sin_addr, he->h_addr_list[0], sizeof(addr.sin_addr));
+    }
+    if (sscanf (port, "%hu%c", &portnum, &c) != 1 || portnum == 0)
+    {
+        logmsg( _("HHCSR040E Invalid host:port %s\n"), argv[argc - 1]);
+        free (m);
+        return -1;
+    }
+    addr.sin_port = htons (portnum);
+
+    if (listening && !sr_cpus_stopped ())
+    {
+        free (m);
+        return -1;
+    }
+
+    m->sock = socket (AF_INET, SOCK_STREAM, 0);
+    if (m->sock < 0)
+    {
+        logmsg( _("HHCSR031E %s: %s failed: %s\n"), argv[1], "socket",
+                strerror(HSO_errno));
+        free (m);
+        return -1;
+    }
+
+    if (listening)
+    {
+        /* Allow previous instance of socket to be reused */
+        optval = 1;
+        setsockopt (m->sock, SOL_SOCKET, SO_REUSEADDR,
+                    (GETSET_SOCKOPT_T*)&optval, sizeof(optval));
+        if (bind (m->sock, (struct sockaddr *)&addr, sizeof(addr)) < 0
+         || listen (m->sock, 1) < 0)
+        {
+            logmsg( _("HHCSR031E %s: %s failed: %s\n"), m->name, "bind",
+                    strerror(HSO_errno));
+            close_socket (m->sock);
+            free (m);
+            return -1;
+        }
+        logmsg( _("HHCSR035I Waiting for migration on port %u\n"), portnum);
+    }
+    else if (connect (m->sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        logmsg( _("HHCSR031E %s: %s failed: %s\n"), m->name, "connect",
+                strerror(HSO_errno));
+        close_socket (m->sock);
+        free (m);
+        return -1;
+    }
+
+    sr_migrating = 1;
+    if (listening)
+        rc = create_thread (&tid, DETACHED, sr_listen_thread, m,
+                            "sr_listen_thread");
+    else
+        rc = create_thread (&tid, DETACHED, sr_migrate_thread, m,
+                            "sr_migrate_thread");
+    if (rc)
+    {
+        logmsg( _("HHCSR031E %s: %s failed: %s\n"), m->name,
+                "create_thread", strerror(errno));
+        close_socket (m->sock);
+        free (m);
+        sr_migrating = 0;
+        return -1;
+    }
+    return 0;
+}
+#endif /*defined(OPTION_SR_MIGRATE)*/
@@ -123,6 +123,47 @@
  * There may be other instances where the processing of one
  * key requires that another key has been previously processed.
  *
+ * Main storage
+ *
+ * Main storage is written as SR_SYS_MAINCHUNK text units, each
+ * describing SR_CHUNK_PAGES 4K frames starting at the chunk origin.
+ * The chunks are built by several threads and may appear in any
+ * order.  A chunk unit contains
+ *
+ *   8 bytes   origin of the chunk
+ *   4 bytes   number of frames in the chunk
+ *   4 bytes   method (SR_CHUNK_RAW or SR_CHUNK_ZLIB)
+ *   4 bytes   length of the frame data
+ *   4 bytes   number of pad bytes before the frame data
+ *  32 bytes   data map, one bit per frame whose data follows
+ *  32 bytes   zero map, one bit per frame that is all zeroes
+ *
+ * followed by the pad bytes and the frame data, which is the data
+ * map frames in ascending order, compressed as one stream for
+ * SR_CHUNK_ZLIB.  The pad bytes put SR_CHUNK_RAW data on a 4K
+ * file offset so resume can map it instead of reading it.
+ *
+ * A frame in neither map is unchanged.  In a full suspend file
+ * every frame is in one of the maps.  An incremental file starts
+ * with SR_HDR_BASE, naming the file it was taken after; resume
+ * loads the main storage of the base file (and of its base, and
+ * so on) before that of the incremental file.
+ *
+ * Files written with SR_SYS_MAINSTOR instead are still resumed.
+ *
+ * Live migration
+ *
+ * The migrate command sends the same text units over a TCP
+ * connection to a hercules waiting in `migrate listen'.  After the
+ * header and SR_SYS_MAINSIZE, main storage is sent in rounds while
+ * the CPUs keep running: the first round has every frame, and each
+ * later round has the frames changed since the previous one.  When
+ * a round is small enough, or after SR_MIGRATE_ROUNDS rounds, the
+ * CPUs are stopped and the last changed frames are sent with the
+ * rest of the state, as in an incremental suspend file.  The sender
+ * then shuts down its side of the connection, and the receiver
+ * replies with one byte, zero if the resume was successful.
+ *
  */
 
 // $Log$
@@ -147,6 +188,7 @@
 #define SR_HDR_ID               0xace00000
 #define SR_HDR_VERSION          0xace00001
 #define SR_HDR_DATE             0xace00002
+#define SR_HDR_BASE             0xace00003
 
 #define SR_SYS_MASK             0xfffff000
 #define SR_SYS_STARTED_MASK     0xace10000
@@ -191,6 +233,16 @@
 #define SR_SYS_PCIPENDING_LCSS  0xace10046
 #define SR_SYS_ATTNPENDING_LCSS 0xace10047
 
+#define SR_SYS_MAINCHUNK        0xace10050
+#define SR_CHUNK_PAGES          256     /* 4K frames per chunk       */
+#define SR_CHUNK_HDRLEN         88      /* Chunk header length       */
+#define SR_CHUNK_RAW            0       /* Uncompressed frame data   */
+#define SR_CHUNK_ZLIB           1       /* zlib compressed frame data*/
+#define SR_MAX_WORKERS          16      /* Max suspend threads       */
+#define SR_MAX_BASE_DEPTH       32      /* Max incremental file chain*/
+#define SR_MIGRATE_ROUNDS       30      /* Max live migration rounds */
+#define SR_MIGRATE_DIRTY        256     /* Frames left to stop CPUs  */
+
 #define SR_SYS_SERVC            0xace11000
 
 #define SR_SYS_CLOCK            0xace12000
@@ -474,27 +526,43 @@
 #ifdef HAVE_LIBZ
 #define SR_DEFAULT_FILENAME "hercules.srf.gz"
 #define SR_FILE gzFile
+/* Storage chunks are compressed by the suspend threads, so the file
+   itself is written without gzip compression */
+#define SR_WRITE_MODE "wbT"
 #define SR_OPEN(_path, _mode) \
  gzopen((_path), (_mode))
+#define SR_FDOPEN(_fd, _mode) \
+ gzdopen((_fd), (_mode))
 #define SR_READ(_ptr, _size, _nmemb, _stream) \
  gzread((_stream), (_ptr), (unsigned int)((_size) * (_nmemb)))
 #define SR_WRITE(_ptr, _size, _nmemb, _stream) \
  gzwrite((_stream), (_ptr), (unsigned int)((_size) * (_nmemb)))
 #define SR_SEEK(_stream, _offset, _whence) \
  gzseek((_stream), (_offset), (_whence))
+#define SR_TELL(_stream) \
+ gztell((_stream))
+#define SR_DIRECT(_stream) \
+ gzdirect((_stream))
 #define SR_CLOSE(_stream) \
  gzclose((_stream))
 #else
 #define SR_DEFAULT_FILENAME "hercules.srf"
 #define SR_FILE FILE*
+#define SR_WRITE_MODE "wb"
 #define SR_OPEN(_path, _mode) \
  fopen((_path), (_mode))
+#define SR_FDOPEN(_fd, _mode) \
+ fdopen((_fd), (_mode))
 #define SR_READ(_ptr, _size, _nmemb, _stream) \
  fread((_ptr), (_size), (_nmemb), (_stream))
 #define SR_WRITE(_ptr, _size, _nmemb, _stream) \
  fwrite((_ptr), (_size), (_nmemb), (_stream))
 #define SR_SEEK(_stream, _offset, _whence) \
  fseek((_stream), (_offset), (_whence))
+#define SR_TELL(_stream) \
+ ftell((_stream))
+#define SR_DIRECT(_stream) \
+ (1)
 #define SR_CLOSE(_stream) \
  fclose((_stream))
 #endif
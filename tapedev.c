@@ -242,7 +242,7 @@ TAPEMEDIA_HANDLER  tmh_aws  =
     &is_tapeloaded_filename,
     &passedeot_awstape,
     &readblkid_virtual,
-    &locateblk_virtual
+    &locateblk_awstape
 };
 
 /*-------------------------------------------------------------------*/
@@ -266,7 +266,7 @@ TAPEMEDIA_HANDLER  tmh_het   =
     &is_tapeloaded_filename,
     &passedeot_het,
     &readblkid_virtual,
-    &locateblk_virtual
+    &locateblk_het
 };
 
 /*-------------------------------------------------------------------*/
@@ -1088,6 +1088,7 @@ PARSER  ptab  [] =
     { "rw",         NULL },
     { "ring",       NULL },
     { "deonirq",    "%d" },
+    { "idxfile",    NULL },
 #if defined( OPTION_TAPE_AUTOMOUNT )
     { "noautomount",NULL },
 #endif
@@ -1123,6 +1124,7 @@ enum
     TDPARM_RW,
     TDPARM_RING,
     TDPARM_DEONIRQ,
+    TDPARM_IDXFILE,
 #if defined( OPTION_TAPE_AUTOMOUNT )
     TDPARM_NOAUTOMOUNT,
 #endif
@@ -1210,6 +1212,7 @@ int  mountnewtape ( DEVBLK *dev, int argc, char **argv )
     dev->tdparms.maxsize   = 0;        // no max size     (default)
     dev->eotmargin         = 128*1024; // 128K EOT margin (default)
     dev->tdparms.logical_readonly = 0; // read/write      (default)
+    dev->tdparms.idxfile   = 0;        // no index file   (default)
 #if defined( OPTION_TAPE_AUTOMOUNT )
     dev->noautomount       = 0;
 #endif
@@ -1389,6 +1392,17 @@ int  mountnewtape ( DEVBLK *dev, int argc, char **argv )
             dev->tdparms.deonirq=(res.num ? 1 : 0 );
             break;
 
+        case TDPARM_IDXFILE:
+            if (1
+                && TAPEDEVT_AWSTAPE != dev->tapedevt
+                && TAPEDEVT_HETTAPE != dev->tapedevt
+            )
+            {
+                HHCTA078E(); optrc = -1; break;
+            }
+            dev->tdparms.idxfile = 1;
+            break;
+
 #if defined( OPTION_TAPE_AUTOMOUNT )
 
         case TDPARM_NOAUTOMOUNT:
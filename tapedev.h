@@ -463,6 +463,8 @@ extern int  read_awstape      (DEVBLK *dev, BYTE *buf,
                                             BYTE *unitstat, BYTE code);
 extern int  write_awstape     (DEVBLK *dev, BYTE *buf, U16 blklen,
                                             BYTE *unitstat, BYTE code);
+extern int  locateblk_awstape (DEVBLK *dev, U32 blockid,
+                                            BYTE *unitstat, BYTE code);
 
 /*-------------------------------------------------------------------*/
 /* Functions defined in FAKETAPE.C                                   */
@@ -505,6 +507,8 @@ extern int  read_het      (DEVBLK *dev, BYTE *buf,
                                         BYTE *unitstat, BYTE code);
 extern int  write_het     (DEVBLK *dev, BYTE *buf, U16 blklen,
                                         BYTE *unitstat, BYTE code);
+extern int  locateblk_het (DEVBLK *dev, U32 blockid,
+                                        BYTE *unitstat, BYTE code);
 
 /*-------------------------------------------------------------------*/
 /* Functions defined in OMATAPE.C                                    */
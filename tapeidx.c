@@ -0,0 +1,733 @@
+/* TAPEIDX.C    (c)Copyright The Hercules Project, 2026              */
+/*              Block index and read-ahead for AWS and HET tapes     */
+
+/*-------------------------------------------------------------------*/
+/* This module contains the block index and the sequential read-     */
+/* ahead used by the AWSTAPE device handler and by the HET library.  */
+/* See tapeidx.h for a description of the interfaces.                */
+/*                                                                   */
+/* Both formats chain blocks with the same 6-byte chunk header, so   */
+/* the index is built the same way for either.  Compressed HET data  */
+/* is never examined: only the headers are read.                     */
+/*-------------------------------------------------------------------*/
+
+#include "hstdinc.h"
+
+#define _TAPEIDX_C_
+#define _HTAPE_DLL_
+
+#include "hercules.h"
+#include "hetlib.h"
+
+/*-------------------------------------------------------------------*/
+/* Index file header                                                 */
+/*-------------------------------------------------------------------*/
+typedef struct _TAPEIDX_HDR
+{
+    BYTE            id[8];              /* TAPEIDX_ID                */
+    DBLWRD          size;               /* Tape file size            */
+    DBLWRD          mtime;              /* Tape file modified time   */
+    FWORD           nblks;              /* Number of blocks          */
+    FWORD           ntms;               /* Number of tapemarks       */
+} TAPEIDX_HDR;                          /* Followed by nblks DBLWRD
+                                           block offsets and then
+                                           ntms FWORD block numbers  */
+
+static const BYTE TAPEIDX_ID[8] = { 'H','E','R','C','T','I','D','X' };
+
+#define TAPEIDX_SCANSIZE  4096          /* Header scan buffer size   */
+
+/*-------------------------------------------------------------------*/
+/* Read from the tape file at an offset                              */
+/*-------------------------------------------------------------------*/
+static int tape_pread (int fd, void *buf, int len, off_t pos)
+{
+int             rc;                     /* Return code               */
+int             n = 0;                  /* Bytes read                */
+
+    while (n < len)
+    {
+#if defined(_MSVC_)
+        if (lseek (fd, pos + n, SEEK_SET) < 0)
+            return -1;
+        rc = read (fd, (BYTE *)buf + n, len - n);
+#else
+        rc = pread (fd, (BYTE *)buf + n, len - n, pos + n);
+#endif
+        if (rc < 0)
+        {
+            if (EINTR == errno)
+                continue;
+            return -1;
+        }
+        if (rc == 0)
+            break;
+        n += rc;
+    }
+    return n;
+
+} /* end function tape_pread */
+
+/*-------------------------------------------------------------------*/
+/* Initialize an empty block index                                   */
+/*-------------------------------------------------------------------*/
+DLL_EXPORT void tapeidx_init (TAPEIDX *idx)
+{
+    memset (idx, 0, sizeof(TAPEIDX));
+}
+
+/*-------------------------------------------------------------------*/
+/* Release the storage of a block index                              */
+/*-------------------------------------------------------------------*/
+DLL_EXPORT void tapeidx_term (TAPEIDX *idx)
+{
+    free (idx->blkpos);
+    free (idx->tmblk);
+    tapeidx_init (idx);
+}
+
+/*-------------------------------------------------------------------*/
+/* Return the number of indexed tapemarks preceding a block          */
+/*-------------------------------------------------------------------*/
+DLL_EXPORT U32 tapeidx_files (TAPEIDX *idx, U32 blk)
+{
+U32             lo = 0;                 /* First candidate           */
+U32             hi = idx->ntms;         /* Last candidate + 1        */
+U32             mid;                    /* Midpoint                  */
+
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if (idx->tmblk[mid] < blk)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+
+} /* end function tapeidx_files */
+
+/*-------------------------------------------------------------------*/
+/* Add the next block to the index                                   */
+/*-------------------------------------------------------------------*/
+DLL_EXPORT void tapeidx_add (TAPEIDX *idx, U32 blk, off_t pos,
+                             off_t nxtpos, int tapemark)
+{
+void           *p;                      /* New array                 */
+U32             n;                      /* New array size            */
+
+    /* Only the block following the last one indexed can be added */
+    if (blk != idx->nblks || pos != idx->endpos || nxtpos <= pos
+     || idx->stopped)
+        return;
+
+    if (idx->nblks == idx->maxblks)
+    {
+        n = idx->maxblks ? idx->maxblks * 2 : 1024;
+        if (n < idx->maxblks
+         || !(p = realloc (idx->blkpos, n * sizeof(off_t))))
+        {
+            /* Stop indexing if storage is exhausted */
+            idx->stopped = 1;
+            return;
+        }
+        idx->blkpos = p;
+        idx->maxblks = n;
+    }
+
+    if (tapemark && idx->ntms == idx->maxtms)
+    {
+        n = idx->maxtms ? idx->maxtms * 2 : 64;
+        if (n < idx->maxtms
+         || !(p = realloc (idx->tmblk, n * sizeof(U32))))
+        {
+            idx->stopped = 1;
+            return;
+        }
+        idx->tmblk = p;
+        idx->maxtms = n;
+    }
+
+    idx->blkpos[idx->nblks++] = pos;
+    if (tapemark)
+        idx->tmblk[idx->ntms++] = blk;
+    idx->endpos = nxtpos;
+    idx->changed = 1;
+
+} /* end function tapeidx_add */
+
+/*-------------------------------------------------------------------*/
+/* Remove a block and all following blocks from the index            */
+/*-------------------------------------------------------------------*/
+DLL_EXPORT void tapeidx_truncate (TAPEIDX *idx, U32 blk)
+{
+    if (blk < idx->nblks)
+    {
+        idx->endpos = idx->blkpos[blk];
+        idx->nblks = blk;
+        idx->ntms = tapeidx_files (idx, blk);
+        idx->stopped = 0;
+        idx->changed = 1;
+    }
+    else if (blk == idx->nblks)
+        idx->stopped = 0;
+
+    /* The file is about to be extended */
+    if (idx->complete)
+    {
+        idx->complete = 0;
+        idx->changed = 1;
+    }
+
+} /* end function tapeidx_truncate */
+
+/*-------------------------------------------------------------------*/
+/* Extend the index by scanning the chunk headers                    */
+/*                                                                   */
+/* Scans until block `blk' is indexed or, if `tmstop', until another */
+/* tapemark has been indexed.  Sets `complete' at end of file, or    */
+/* `stopped' if a header is invalid or the file ends within a block. */
+/* Returns 0, or -1 if a read fails.                                 */
+/*-------------------------------------------------------------------*/
+static int tapeidx_scan (TAPEIDX *idx, int fd, U32 blk, int tmstop)
+{
+BYTE            buf[TAPEIDX_SCANSIZE];  /* Scan buffer               */
+off_t           bufpos = 0;             /* File offset of buffer     */
+int             buflen = 0;             /* Bytes in buffer           */
+struct stat     st;                     /* Tape file information     */
+HETHDR         *hdr;                    /* -> Chunk header           */
+off_t           blkpos;                 /* Offset of block           */
+off_t           pos;                    /* Offset of chunk header    */
+U32             ntms;                   /* Tapemarks before scan     */
+int             first;                  /* First chunk of block      */
+int             rc;                     /* Return code               */
+
+    if (fstat (fd, &st) < 0)
+        return -1;
+
+    ntms = idx->ntms;
+
+    while (!idx->complete && !idx->stopped
+        && (tmstop ? idx->ntms == ntms : idx->nblks <= blk))
+    {
+        blkpos = pos = idx->endpos;
+
+        for (first = 1; ; first = 0)
+        {
+            /* Refill the buffer unless it holds the whole header */
+            if (pos < bufpos
+             || pos + (off_t)sizeof(HETHDR) > bufpos + buflen)
+            {
+                rc = tape_pread (fd, buf, sizeof(buf), pos);
+                if (rc < 0)
+                    return -1;
+                bufpos = pos;
+                buflen = rc;
+            }
+
+            /* End of file at a block boundary ends the tape */
+            if (first && pos == bufpos && buflen == 0)
+            {
+                idx->complete = 1;
+                idx->changed = 1;
+                return 0;
+            }
+
+            if (pos + (off_t)sizeof(HETHDR) > bufpos + buflen)
+            {
+                idx->stopped = 1;
+                return 0;
+            }
+
+            hdr = (HETHDR *)(buf + (pos - bufpos));
+
+            /* A block starts with a new record chunk or a tapemark
+               and no later chunk of the block may be either */
+            if ((hdr->flags1 & (HETHDR_FLAGS1_BOR | HETHDR_FLAGS1_TAPEMARK))
+                ? !first : first)
+            {
+                idx->stopped = 1;
+                return 0;
+            }
+
+            pos += sizeof(HETHDR) + ((hdr->clen[1] << 8) | hdr->clen[0]);
+
+            if (pos > st.st_size)
+            {
+                idx->stopped = 1;
+                return 0;
+            }
+
+            if (hdr->flags1 & (HETHDR_FLAGS1_EOR | HETHDR_FLAGS1_TAPEMARK))
+                break;
+        }
+
+        tapeidx_add (idx, idx->nblks, blkpos, pos,
+                     (hdr->flags1 & HETHDR_FLAGS1_TAPEMARK) != 0);
+    }
+
+    return 0;
+
+} /* end function tapeidx_scan */
+
+/*-------------------------------------------------------------------*/
+/* Find the offset of a block                                        */
+/*-------------------------------------------------------------------*/
+DLL_EXPORT int tapeidx_locate (TAPEIDX *idx, int fd, U32 blk, off_t *pos)
+{
+    if (tapeidx_scan (idx, fd, blk, 0) < 0)
+        return -1;
+
+    if (blk < idx->nblks)
+    {
+        *pos = idx->blkpos[blk];
+        return 0;
+    }
+
+    /* The position after the last block */
+    if (blk == idx->nblks && (idx->complete || idx->stopped))
+    {
+        *pos = idx->endpos;
+        return 0;
+    }
+
+    return -1;
+
+} /* end function tapeidx_locate */
+
+/*-------------------------------------------------------------------*/
+/* Find the first tapemark at or after a block                       */
+/*-------------------------------------------------------------------*/
+DLL_EXPORT int tapeidx_nexttm (TAPEIDX *idx, int fd, U32 blk, U32 *tm)
+{
+U32             i;                      /* Tapemark index            */
+
+    /* Make sure everything up to the block is indexed */
+    if (blk > 0 && tapeidx_scan (idx, fd, blk - 1, 0) < 0)
+        return -1;
+
+    for (;;)
+    {
+        i = tapeidx_files (idx, blk);
+        if (i < idx->ntms)
+        {
+            *tm = idx->tmblk[i];
+            return 0;
+        }
+
+        if (idx->complete || idx->stopped
+         || tapeidx_scan (idx, fd, 0, 1) < 0)
+            return -1;
+    }
+
+} /* end function tapeidx_nexttm */
+
+/*-------------------------------------------------------------------*/
+/* Find the last tapemark before a block                             */
+/*-------------------------------------------------------------------*/
+DLL_EXPORT int tapeidx_prevtm (TAPEIDX *idx, int fd, U32 blk, U32 *tm)
+{
+U32             i;                      /* Tapemark index            */
+
+    if (blk == 0
+     || tapeidx_scan (idx, fd, blk - 1, 0) < 0
+     || idx->nblks < blk)
+        return -1;
+
+    i = tapeidx_files (idx, blk);
+    if (i == 0)
+        return -1;
+
+    *tm = idx->tmblk[i - 1];
+    return 0;
+
+} /* end function tapeidx_prevtm */
+
+/*-------------------------------------------------------------------*/
+/* Build the name of the index file of a tape                        */
+/*-------------------------------------------------------------------*/
+static void tapeidx_name (char *idxname, size_t size, char *filename)
+{
+char            buf[MAX_PATH];          /* Index file name           */
+
+    snprintf (buf, sizeof(buf), "%s" TAPEIDX_SUFFIX, filename);
+    hostpath (idxname, buf, size);
+}
+
+/*-------------------------------------------------------------------*/
+/* Load the index from the index file                                */
+/*-------------------------------------------------------------------*/
+DLL_EXPORT int tapeidx_load (TAPEIDX *idx, int fd, char *filename)
+{
+char            idxname[MAX_PATH];      /* Index file name           */
+struct stat     st;                     /* Tape file information     */
+TAPEIDX_HDR     hdr;                    /* Index file header         */
+FILE           *f;                      /* Index file                */
+BYTE            ent[8];                 /* Index file entry          */
+U64             size, mtime;            /* Tape file size and time   */
+U32             nblks, ntms;            /* Header counts             */
+U32             i;                      /* Entry number              */
+off_t           pos;                    /* Block offset              */
+
+    if (fstat (fd, &st) < 0)
+        return -1;
+
+    tapeidx_name (idxname, sizeof(idxname), filename);
+    if (!(f = fopen (idxname, "rb")))
+        return -1;
+
+    if (fread (&hdr, sizeof(hdr), 1, f) != 1
+     || memcmp (hdr.id, TAPEIDX_ID, sizeof(hdr.id)))
+    {
+        fclose (f);
+        return -1;
+    }
+
+    FETCH_DW (size, hdr.size);
+    FETCH_DW (mtime, hdr.mtime);
+    FETCH_FW (nblks, hdr.nblks);
+    FETCH_FW (ntms, hdr.ntms);
+
+    /* The tape must not have changed since the index was written */
+    if (size != (U64)st.st_size || mtime != (U64)st.st_mtime
+     || ntms > nblks)
+    {
+        fclose (f);
+        return -1;
+    }
+
+    tapeidx_term (idx);
+    idx->blkpos = malloc ((nblks ? nblks : 1) * sizeof(off_t));
+    idx->tmblk = malloc ((ntms ? ntms : 1) * sizeof(U32));
+    if (!idx->blkpos || !idx->tmblk)
+    {
+        fclose (f);
+        tapeidx_term (idx);
+        return -1;
+    }
+    idx->maxblks = nblks ? nblks : 1;
+    idx->maxtms = ntms ? ntms : 1;
+
+    /* Block offsets must ascend within the file */
+    for (i = 0; i < nblks; i++)
+    {
+        if (fread (ent, 8, 1, f) != 1)
+            break;
+        FETCH_DW (pos, ent);
+        if (pos >= st.st_size || (i ? pos <= idx->blkpos[i-1] : pos != 0))
+            break;
+        idx->blkpos[i] = pos;
+    }
+
+    /* Tapemark block numbers must ascend within the blocks */
+    if (i == nblks)
+        for (i = 0; i < ntms; i++)
+        {
+            if (fread (ent, 4, 1, f) != 1)
+                break;
+            FETCH_FW (idx->tmblk[i], ent);
+            if (idx->tmblk[i] >= nblks
+             || (i && idx->tmblk[i] <= idx->tmblk[i-1]))
+                break;
+        }
+    else
+        i = ntms + 1;
+
+    fclose (f);
+
+    if (i != ntms)
+    {
+        tapeidx_term (idx);
+        return -1;
+    }
+
+    idx->nblks = nblks;
+    idx->ntms = ntms;
+    idx->endpos = st.st_size;
+    idx->complete = 1;
+    return 0;
+
+} /* end function tapeidx_load */
+
+/*-------------------------------------------------------------------*/
+/* Write the index to the index file                                 */
+/*-------------------------------------------------------------------*/
+DLL_EXPORT int tapeidx_save (TAPEIDX *idx, int fd, char *filename)
+{
+char            idxname[MAX_PATH];      /* Index file name           */
+struct stat     st;                     /* Tape file information     */
+TAPEIDX_HDR     hdr;                    /* Index file header         */
+FILE           *f;                      /* Index file                */
+BYTE            ent[8];                 /* Index file entry          */
+U32             i;                      /* Entry number              */
+int             rc = 0;                 /* Return code               */
+
+    /* Index the rest of the tape so that the file is complete */
+    if (tapeidx_scan (idx, fd, ~0U, 0) < 0)
+        return -1;
+
+    if (!idx->complete || !idx->changed)
+        return 0;
+
+    if (fstat (fd, &st) < 0)
+        return -1;
+
+    tapeidx_name (idxname, sizeof(idxname), filename);
+    if (!(f = fopen (idxname, "wb")))
+        return -1;
+
+    memcpy (hdr.id, TAPEIDX_ID, sizeof(hdr.id));
+    STORE_DW (hdr.size, (U64)st.st_size);
+    STORE_DW (hdr.mtime, (U64)st.st_mtime);
+    STORE_FW (hdr.nblks, idx->nblks);
+    STORE_FW (hdr.ntms, idx->ntms);
+    if (fwrite (&hdr, sizeof(hdr), 1, f) != 1)
+        rc = -1;
+
+    for (i = 0; rc == 0 && i < idx->nblks; i++)
+    {
+        STORE_DW (ent, (U64)idx->blkpos[i]);
+        if (fwrite (ent, 8, 1, f) != 1)
+            rc = -1;
+    }
+
+    for (i = 0; rc == 0 && i < idx->ntms; i++)
+    {
+        STORE_FW (ent, idx->tmblk[i]);
+        if (fwrite (ent, 4, 1, f) != 1)
+            rc = -1;
+    }
+
+    if (fclose (f) != 0)
+        rc = -1;
+
+    if (rc < 0)
+        remove (idxname);
+    else
+        idx->changed = 0;
+
+    return rc;
+
+} /* end function tapeidx_save */
+
+/*-------------------------------------------------------------------*/
+/* Read-ahead helper thread: fill the requested buffer               */
+/*-------------------------------------------------------------------*/
+static void *tapera_thread (TAPERA *ra)
+{
+int             b;                      /* Buffer to fill            */
+int             n;                      /* Bytes read                */
+
+    obtain_lock (&ra->lock);
+
+    while (!ra->shutdown)
+    {
+        if (ra->fill < 0)
+        {
+            wait_condition (&ra->cond, &ra->lock);
+            continue;
+        }
+
+        b = ra->fill;
+        release_lock (&ra->lock);
+
+        /* A failed fill leaves the buffer empty, so that the read
+           is retried synchronously and the error reported then */
+        n = tape_pread (ra->fd, ra->buf[b], TAPERA_BUFSIZE, ra->pos[b]);
+
+        obtain_lock (&ra->lock);
+        ra->len[b] = n < 0 ? 0 : n;
+        ra->fill = -1;
+        broadcast_condition (&ra->cond);
+    }
+
+    release_lock (&ra->lock);
+    return NULL;
+
+} /* end function tapera_thread */
+
+/*-------------------------------------------------------------------*/
+/* Wait for the helper thread to finish filling a buffer             */
+/*-------------------------------------------------------------------*/
+static void tapera_wait (TAPERA *ra)
+{
+    if (!ra->active)
+        return;
+
+    obtain_lock (&ra->lock);
+    while (ra->fill >= 0)
+        wait_condition (&ra->cond, &ra->lock);
+    release_lock (&ra->lock);
+}
+
+/*-------------------------------------------------------------------*/
+/* Start filling a buffer in the background                          */
+/*-------------------------------------------------------------------*/
+static void tapera_prefetch (TAPERA *ra, int b, off_t pos)
+{
+#if defined(_MSVC_)
+    /* Without pread the helper would move the file pointer */
+    (void)ra; (void)b; (void)pos;
+#else
+    if (!ra->async)
+        return;
+
+    tapera_wait (ra);
+
+    if (!ra->active)
+    {
+        if (create_thread (&ra->tid, &ra->attr, tapera_thread, ra,
+                           "tapera_thread"))
+            return;
+        ra->active = 1;
+    }
+
+    obtain_lock (&ra->lock);
+    ra->pos[b] = pos;
+    ra->len[b] = 0;
+    ra->fill = b;
+    signal_condition (&ra->cond);
+    release_lock (&ra->lock);
+#endif
+}
+
+/*-------------------------------------------------------------------*/
+/* Set up the read-ahead for a file                                  */
+/*-------------------------------------------------------------------*/
+DLL_EXPORT int tapera_init (TAPERA *ra, int fd)
+{
+    memset (ra, 0, sizeof(TAPERA));
+    ra->fd = fd;
+    ra->fill = -1;
+
+    /* Without buffers tapera_read reads the file directly */
+    ra->buf[0] = malloc (TAPERA_BUFSIZE);
+    ra->buf[1] = malloc (TAPERA_BUFSIZE);
+    if (!ra->buf[0] || !ra->buf[1])
+    {
+        free (ra->buf[0]);
+        free (ra->buf[1]);
+        ra->buf[0] = ra->buf[1] = NULL;
+        return -1;
+    }
+
+    initialize_lock (&ra->lock);
+    initialize_condition (&ra->cond);
+    initialize_join_attr (&ra->attr);
+
+    /* (the utilities do not initialize the host information) */
+    if (!hostinfo.num_procs)
+        init_hostinfo (NULL);
+    ra->async = hostinfo.num_procs > 1;
+    return 0;
+
+} /* end function tapera_init */
+
+/*-------------------------------------------------------------------*/
+/* Stop the helper thread and release the buffers                    */
+/*-------------------------------------------------------------------*/
+DLL_EXPORT void tapera_term (TAPERA *ra)
+{
+    if (!ra->buf[0])
+        return;
+
+    if (ra->active)
+    {
+        obtain_lock (&ra->lock);
+        ra->shutdown = 1;
+        broadcast_condition (&ra->cond);
+        release_lock (&ra->lock);
+        join_thread (ra->tid, NULL);
+    }
+
+    destroy_condition (&ra->cond);
+    destroy_lock (&ra->lock);
+    free (ra->buf[0]);
+    free (ra->buf[1]);
+    memset (ra, 0, sizeof(TAPERA));
+
+} /* end function tapera_term */
+
+/*-------------------------------------------------------------------*/
+/* Discard the buffered data                                         */
+/*-------------------------------------------------------------------*/
+DLL_EXPORT void tapera_reset (TAPERA *ra)
+{
+    if (!ra->buf[0])
+        return;
+
+    tapera_wait (ra);
+    ra->len[0] = ra->len[1] = 0;
+
+} /* end function tapera_reset */
+
+/*-------------------------------------------------------------------*/
+/* Read from the file through the read-ahead buffers                 */
+/*-------------------------------------------------------------------*/
+DLL_EXPORT int tapera_read (TAPERA *ra, void *buf, int len, off_t pos)
+{
+int             n = 0;                  /* Bytes copied              */
+int             k;                      /* Bytes copied this time    */
+int             b;                      /* Buffer number             */
+int             seq;                    /* Reading sequentially      */
+off_t           at;                     /* File offset of next byte  */
+
+    if (!ra->buf[0])
+        return tape_pread (ra->fd, buf, len, pos);
+
+    while (n < len)
+    {
+        at = pos + n;
+        b = ra->cur;
+
+        if (at < ra->pos[b] || at >= ra->pos[b] + ra->len[b])
+        {
+            /* Wait for the other buffer if it is being filled
+               with the data required */
+            b = 1 - ra->cur;
+            if (at >= ra->pos[b] && at < ra->pos[b] + TAPERA_BUFSIZE)
+                tapera_wait (ra);
+
+            if (at >= ra->pos[b] && at < ra->pos[b] + ra->len[b])
+            {
+                /* Switch buffers and start reading the next part
+                   of the file into the one just finished with */
+                ra->cur = b;
+                if (ra->len[b] == TAPERA_BUFSIZE)
+                    tapera_prefetch (ra, 1 - b, ra->pos[b] + TAPERA_BUFSIZE);
+            }
+            else
+            {
+                /* Read the data now.  If it follows on from the
+                   buffer just finished with then start reading
+                   ahead, as the file is being read sequentially */
+                b = ra->cur;
+                seq = ra->len[b] == TAPERA_BUFSIZE
+                   && at == ra->pos[b] + TAPERA_BUFSIZE;
+
+                /* (the helper only ever fills the other buffer) */
+                k = tape_pread (ra->fd, ra->buf[b], TAPERA_BUFSIZE, at);
+                if (k < 0)
+                {
+                    ra->len[b] = 0;
+                    return -1;
+                }
+                ra->pos[b] = at;
+                ra->len[b] = k;
+
+                if (k == 0)
+                    break;
+
+                if (seq && k == TAPERA_BUFSIZE)
+                    tapera_prefetch (ra, 1 - b, at + TAPERA_BUFSIZE);
+            }
+        }
+
+        k = (int)MIN ((off_t)(len - n), ra->pos[b] + ra->len[b] - at);
+        memcpy ((BYTE *)buf + n, ra->buf[b] + (at - ra->pos[b]), k);
+        n += k;
+    }
+
+    return n;
+
+} /* end function tapera_read */
@@ -0,0 +1,159 @@
+/* TAPEIDX.H    (c)Copyright The Hercules Project, 2026              */
+/*              Block index and read-ahead for AWS and HET tapes     */
+
+/*-------------------------------------------------------------------
+  Description:
+    AWS and HET tape images are chains of chunk headers, so finding
+    a block or the next tapemark otherwise means reading every header
+    from the load point.  The block index remembers the file offset
+    of each block, and the block numbers of the tapemarks, as the tape
+    is read or spaced over, and is extended on demand by scanning the
+    headers beyond the furthest block seen.  Locate Block and forward
+    and backward space file then position directly.  The index of a
+    tape which has been indexed to the end can be kept in an index
+    file next to the tape, named as the tape with ".idx" appended,
+    which is used only while the size and modification time of the
+    tape still match.
+
+    Reads are served from two buffers by the read-ahead.  Once reads
+    are found to be sequential, the buffer following the one in use
+    is filled by a helper thread while the program processes the
+    data already read.  On a uniprocessor the helper thread could
+    only compete with the program, so the buffers are then filled
+    as they are needed and `async' is left clear.
+
+  APIs:
+
+      void        tapeidx_init (TAPEIDX *idx);
+      void        tapeidx_term (TAPEIDX *idx);
+                  Initialize an empty index, or release its storage.
+
+      void        tapeidx_add (TAPEIDX *idx, U32 blk, off_t pos,
+                               off_t nxtpos, int tapemark);
+                  Record that block `blk' starts at `pos' and the one
+                  after it at `nxtpos'.  Ignored unless `blk' is the
+                  first block not yet indexed.
+
+      void        tapeidx_truncate (TAPEIDX *idx, U32 blk);
+                  Forget block `blk' and all following blocks, which
+                  are about to be overwritten.
+
+      int         tapeidx_locate (TAPEIDX *idx, int fd, U32 blk,
+                                  off_t *pos);
+                  Store the offset of block `blk', scanning as far as
+                  necessary.  Returns 0, or -1 if the block is beyond
+                  the end of the tape or can not be reached.
+
+      int         tapeidx_nexttm (TAPEIDX *idx, int fd, U32 blk,
+                                  U32 *tm);
+      int         tapeidx_prevtm (TAPEIDX *idx, int fd, U32 blk,
+                                  U32 *tm);
+                  Store the block number of the first tapemark at or
+                  after block `blk', or of the last tapemark before it.
+                  Return 0, or -1 if there is none or the index can
+                  not tell.
+
+      U32         tapeidx_files (TAPEIDX *idx, U32 blk);
+                  Return the number of tapemarks preceding block `blk'.
+
+      int         tapeidx_load (TAPEIDX *idx, int fd, char *filename);
+      int         tapeidx_save (TAPEIDX *idx, int fd, char *filename);
+                  Read or write the index file of tape `filename'.
+                  Return 0 or -1.  Only a complete index is written,
+                  and only if it differs from the file.
+
+      int         tapera_init (TAPERA *ra, int fd);
+      void        tapera_term (TAPERA *ra);
+                  Allocate the buffers for reading `fd', or stop the
+                  helper thread and release them.
+
+      int         tapera_read (TAPERA *ra, void *buf, int len,
+                               off_t pos);
+                  Read `len' bytes at offset `pos'.  Returns the number
+                  of bytes read, which is less than `len' only at end
+                  of file, or -1 with errno set.
+
+      void        tapera_reset (TAPERA *ra);
+                  Discard the buffered data.  Must be called before the
+                  file is written or truncated.
+
+ -------------------------------------------------------------------*/
+
+#if !defined( _TAPEIDX_H_ )
+#define _TAPEIDX_H_
+
+#include "hercules.h"
+
+#ifndef _TAPEIDX_C_
+#ifndef _HTAPE_DLL_
+#define TIDX_DLL_IMPORT DLL_IMPORT
+#else   /* _HTAPE_DLL_ */
+#define TIDX_DLL_IMPORT extern
+#endif  /* _HTAPE_DLL_ */
+#else
+#define TIDX_DLL_IMPORT DLL_EXPORT
+#endif
+
+/*-------------------------------------------------------------------*/
+/* Block index                                                       */
+/*-------------------------------------------------------------------*/
+typedef struct _TAPEIDX
+{
+    off_t          *blkpos;             /* Offset of each block      */
+    U32             nblks;              /* Blocks indexed            */
+    U32             maxblks;            /* Entries in blkpos         */
+    U32            *tmblk;              /* Tapemark block numbers    */
+    U32             ntms;               /* Tapemarks indexed         */
+    U32             maxtms;             /* Entries in tmblk          */
+    off_t           endpos;             /* Offset after last block   */
+    u_int           complete:1;         /* Indexed to end of file    */
+    u_int           stopped:1;          /* Scan found a bad header   */
+    u_int           changed:1;          /* Differs from index file   */
+} TAPEIDX;
+
+#define TAPEIDX_SUFFIX  ".idx"          /* Index file name suffix    */
+
+/*-------------------------------------------------------------------*/
+/* Sequential read-ahead                                             */
+/*-------------------------------------------------------------------*/
+#define TAPERA_BUFSIZE  (256*1024)      /* Size of each buffer       */
+
+typedef struct _TAPERA
+{
+    int             fd;                 /* File being read           */
+    BYTE           *buf[2];             /* Buffers                   */
+    off_t           pos[2];             /* File offset of buffer     */
+    int             len[2];             /* Bytes in buffer           */
+    int             cur;                /* Buffer being consumed     */
+    int             fill;               /* Buffer being filled by
+                                           the helper thread, or -1  */
+    LOCK            lock;               /* Lock for fill and len     */
+    COND            cond;               /* Fill requested/completed  */
+    ATTR            attr;               /* Helper thread attributes  */
+    TID             tid;                /* Helper thread             */
+    u_int           async:1;            /* Helper thread may be used */
+    u_int           active:1;           /* Helper thread started     */
+    u_int           shutdown:1;         /* Helper thread must exit   */
+} TAPERA;
+
+/*-------------------------------------------------------------------*/
+/* Public functions                                                  */
+/*-------------------------------------------------------------------*/
+TIDX_DLL_IMPORT void tapeidx_init( TAPEIDX *idx );
+TIDX_DLL_IMPORT void tapeidx_term( TAPEIDX *idx );
+TIDX_DLL_IMPORT void tapeidx_add( TAPEIDX *idx, U32 blk, off_t pos,
+                                  off_t nxtpos, int tapemark );
+TIDX_DLL_IMPORT void tapeidx_truncate( TAPEIDX *idx, U32 blk );
+TIDX_DLL_IMPORT int  tapeidx_locate( TAPEIDX *idx, int fd, U32 blk, off_t *pos );
+TIDX_DLL_IMPORT int  tapeidx_nexttm( TAPEIDX *idx, int fd, U32 blk, U32 *tm );
+TIDX_DLL_IMPORT int  tapeidx_prevtm( TAPEIDX *idx, int fd, U32 blk, U32 *tm );
+TIDX_DLL_IMPORT U32  tapeidx_files( TAPEIDX *idx, U32 blk );
+TIDX_DLL_IMPORT int  tapeidx_load( TAPEIDX *idx, int fd, char *filename );
+TIDX_DLL_IMPORT int  tapeidx_save( TAPEIDX *idx, int fd, char *filename );
+
+TIDX_DLL_IMPORT int  tapera_init( TAPERA *ra, int fd );
+TIDX_DLL_IMPORT void tapera_term( TAPERA *ra );
+TIDX_DLL_IMPORT int  tapera_read( TAPERA *ra, void *buf, int len, off_t pos );
+TIDX_DLL_IMPORT void tapera_reset( TAPERA *ra );
+
+#endif /* !defined( _TAPEIDX_H_ ) */
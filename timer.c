@@ -144,6 +144,44 @@ CPU_BITMAP      intmask = 0;            /* Interrupt CPU mask        */
 
 } /* end function check_timer_event */
 
+#if defined(OPTION_INSTRUCTION_PROFILE)
+/*-------------------------------------------------------------------*/
+/* Request a profile sample from each running CPU                    */
+/*                                                                   */
+/* A CPU running a SIE guest is not asked, as the request would not  */
+/* be seen until the guest exits.                                    */
+/*-------------------------------------------------------------------*/
+static void profile_request (void)
+{
+int             cpu;                    /* CPU counter               */
+REGS           *regs;                   /* -> CPU register context   */
+
+    OBTAIN_INTLOCK(NULL);
+
+    for (cpu = 0; cpu < HI_CPU; cpu++)
+    {
+        if (!IS_CPU_ONLINE(cpu))
+            continue;
+
+        regs = sysblk.regs[cpu];
+
+        if (regs->cpustate != CPUSTATE_STARTED
+         || WAITSTATE(&regs->psw)
+#if defined(_FEATURE_SIE)
+         || regs->sie_active
+#endif /*defined(_FEATURE_SIE)*/
+           )
+            continue;
+
+        regs->profsample = 1;
+        ON_IC_INTERRUPT(regs);
+    }
+
+    RELEASE_INTLOCK(NULL);
+
+} /* end function profile_request */
+#endif /*defined(OPTION_INSTRUCTION_PROFILE)*/
+
 /*-------------------------------------------------------------------*/
 /* TOD clock and timer thread                                        */
 /*                                                                   */
@@ -195,6 +233,11 @@ U64     total_sios;                     /* Total SIO rate            */
         /* Update TOD clock */
         update_tod_clock();
 
+#if defined(OPTION_INSTRUCTION_PROFILE)
+        if (profile_tick())
+            profile_request();
+#endif /*defined(OPTION_INSTRUCTION_PROFILE)*/
+
 #ifdef OPTION_MIPS_COUNTING
         now = host_tod();
         diff = now - then;
@@ -0,0 +1,360 @@
+/* TRACEBIN.C   (c)Copyright The Hercules Project, 2026              */
+/*              Binary instruction and I/O trace recorder            */
+
+/*-------------------------------------------------------------------*/
+/* While the binary trace is active, instructions selected by the    */
+/* `t+' command and channel programs on devices selected by `t+devn' */
+/* are recorded as fixed length records in memory mapped ring files  */
+/* instead of being formatted as messages.  Each CPU has its own     */
+/* ring file, written only by that CPU thread, and the channel       */
+/* program records from all devices share one more.  The files are   */
+/* written by the host as storage is modified, so they survive even  */
+/* if Hercules does not.  The tracedump utility decodes them.        */
+/*-------------------------------------------------------------------*/
+
+#include "hstdinc.h"
+
+#define _TRACEBIN_C_
+#define _HENGINE_DLL_
+
+#include "hercules.h"
+#include "opcode.h"
+
+#if defined(OPTION_TRACEBIN)
+
+#define TB_DEFSIZE      64              /* Default ring size (MB)    */
+#define TB_IORING       MAX_CPU_ENGINES /* Index of the I/O ring     */
+
+typedef struct _TBRING {                /* Binary trace ring         */
+        LOCK    lock;                   /* Serializes writes         */
+        TBHDR  *hdr;                    /* -> Mapped file or NULL    */
+        TBREC  *rec;                    /* -> First record slot      */
+        size_t  size;                   /* Size of mapping           */
+        int     fd;                     /* File descriptor           */
+} TBRING;
+
+static LOCK     tblock;                 /* Serializes the command    */
+static TBRING   tbring[MAX_CPU_ENGINES + 1];   /* CPU and I/O rings  */
+static char     tbdir[MAX_PATH] = ".";  /* Ring file directory       */
+static int      tbsize = TB_DEFSIZE;    /* Ring file size (MB)       */
+static int      tbadsc;                 /* 1=Shutdown call added     */
+
+/*-------------------------------------------------------------------*/
+/* Initialize the binary trace                                       */
+/*-------------------------------------------------------------------*/
+void tracebin_init (void)
+{
+int     i;                              /* Ring index                */
+
+    initialize_lock (&tblock);
+    for (i = 0; i <= TB_IORING; i++)
+    {
+        initialize_lock (&tbring[i].lock);
+        tbring[i].fd = -1;
+    }
+}
+
+/*-------------------------------------------------------------------*/
+/* Host clock in nanoseconds since the epoch                         */
+/*-------------------------------------------------------------------*/
+static U64 tracebin_clock (void)
+{
+#if defined(CLOCK_REALTIME)
+struct timespec ts;
+
+    clock_gettime (CLOCK_REALTIME, &ts);
+    return (U64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+struct timeval  tv;
+
+    gettimeofday (&tv, NULL);
+    return ((U64)tv.tv_sec * 1000000 + tv.tv_usec) * 1000;
+#endif
+}
+
+/*-------------------------------------------------------------------*/
+/* Add a record to a ring                                            */
+/*-------------------------------------------------------------------*/
+static void tracebin_put (TBRING *ring, TBREC *rec)
+{
+TBHDR  *hdr;                            /* -> Ring file header       */
+
+    rec->time = tracebin_clock ();
+
+    obtain_lock (&ring->lock);
+    if ((hdr = ring->hdr) != NULL)
+    {
+        memcpy (&ring->rec[hdr->next % hdr->nrecs], rec, sizeof(TBREC));
+        hdr->next++;
+    }
+    release_lock (&ring->lock);
+}
+
+/*-------------------------------------------------------------------*/
+/* Record an instruction in the ring of the CPU that executed it     */
+/*-------------------------------------------------------------------*/
+void tracebin_cpu (TBREC *rec)
+{
+    if (rec->cpuad < MAX_CPU_ENGINES)
+        tracebin_put (&tbring[rec->cpuad], rec);
+}
+
+/*-------------------------------------------------------------------*/
+/* Record a channel program event in the I/O ring                    */
+/*-------------------------------------------------------------------*/
+/* The caller fills in the type, the CCW/CSW/SCSW, the status and    */
+/* the CCW data address.  TBREC_DATA in the flags requests a copy of */
+/* the first 16 bytes at the data address.                           */
+/*-------------------------------------------------------------------*/
+void tracebin_io (DEVBLK *dev, TBREC *rec)
+{
+    rec->arch = sysblk.arch_mode == ARCH_900 ? TBREC_900
+              : sysblk.arch_mode == ARCH_390 ? TBREC_390 : TBREC_370;
+    rec->cpuad = SSID_TO_LCSS(dev->ssid);
+    rec->devnum = dev->devnum;
+
+    if (rec->flags & TBREC_DATA)
+    {
+        if (rec->u.io.addr <= dev->mainlim - 16)
+            memcpy (rec->u.io.data, dev->mainstor + rec->u.io.addr, 16);
+        else
+            rec->flags &= ~TBREC_DATA;
+    }
+
+    tracebin_put (&tbring[TB_IORING], rec);
+}
+
+/*-------------------------------------------------------------------*/
+/* Unmap and close a ring file                                       */
+/*-------------------------------------------------------------------*/
+static void tracebin_unmap (TBRING *ring)
+{
+TBHDR  *hdr;                            /* -> Ring file header       */
+
+    obtain_lock (&ring->lock);
+    hdr = ring->hdr;
+    ring->hdr = NULL;
+    ring->rec = NULL;
+    release_lock (&ring->lock);
+
+    if (hdr)
+    {
+        msync (hdr, ring->size, MS_SYNC);
+        munmap (hdr, ring->size);
+    }
+    if (ring->fd >= 0)
+    {
+        close (ring->fd);
+        ring->fd = -1;
+    }
+}
+
+/*-------------------------------------------------------------------*/
+/* Create and map a ring file                                        */
+/*-------------------------------------------------------------------*/
+static int tracebin_map (TBRING *ring, U16 id, U64 start)
+{
+TBHDR  *hdr;                            /* -> Ring file header       */
+char    fn[MAX_PATH+32];                /* File name                 */
+char    pathname[MAX_PATH];             /* Host path name            */
+U32     nrecs;                          /* Number of record slots    */
+size_t  size;                           /* Size of file              */
+int     fd;                             /* File descriptor           */
+
+    if (id == TBHDR_IO)
+        snprintf (fn, sizeof(fn), "%s/trace-io.htb", tbdir);
+    else
+        snprintf (fn, sizeof(fn), "%s/trace-cpu%4.4X.htb", tbdir, id);
+    hostpath (pathname, fn, sizeof(pathname));
+
+    nrecs = (U32)(((U64)tbsize << 20) / sizeof(TBREC));
+    size = TBHDR_SIZE + (size_t)nrecs * sizeof(TBREC);
+
+    fd = hopen (pathname, O_RDWR | O_CREAT | O_TRUNC | O_BINARY,
+                S_IRUSR | S_IWUSR | S_IRGRP);
+    if (fd < 0 || ftruncate (fd, size) < 0)
+    {
+        logmsg (_("HHCTB003E Trace file %s open error: %s\n"),
+                fn, strerror(errno));
+        if (fd >= 0)
+            close (fd);
+        return -1;
+    }
+
+    hdr = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (hdr == MAP_FAILED)
+    {
+        logmsg (_("HHCTB004E Trace file %s mmap error: %s\n"),
+                fn, strerror(errno));
+        close (fd);
+        return -1;
+    }
+
+    memcpy (hdr->id, TBHDR_ID, sizeof(hdr->id));
+    hdr->endian = TBHDR_ENDIAN;
+    hdr->recsize = sizeof(TBREC);
+    hdr->hdrsize = TBHDR_SIZE;
+    hdr->nrecs = nrecs;
+    hdr->next = 0;
+    hdr->start = start;
+    hdr->ring = id;
+
+    obtain_lock (&ring->lock);
+    ring->fd = fd;
+    ring->size = size;
+    ring->rec = (TBREC *)((BYTE *)hdr + TBHDR_SIZE);
+    ring->hdr = hdr;
+    release_lock (&ring->lock);
+
+    return 0;
+}
+
+/*-------------------------------------------------------------------*/
+/* Stop the binary trace and close the ring files                    */
+/*-------------------------------------------------------------------*/
+static void tracebin_stop (void)
+{
+int     i;                              /* Ring index                */
+
+    sysblk.tracebin = 0;
+    for (i = 0; i <= TB_IORING; i++)
+        tracebin_unmap (&tbring[i]);
+}
+
+/*-------------------------------------------------------------------*/
+/* Close the ring files at shutdown                                  */
+/*-------------------------------------------------------------------*/
+static void tracebin_term (void *arg)
+{
+    UNREFERENCED(arg);
+
+    obtain_lock (&tblock);
+    tracebin_stop ();
+    release_lock (&tblock);
+}
+
+/*-------------------------------------------------------------------*/
+/* Start the binary trace                                            */
+/*-------------------------------------------------------------------*/
+static int tracebin_start (void)
+{
+U64     start;                          /* Trace start time          */
+int     i;                              /* CPU address               */
+
+    tracebin_stop ();
+
+    start = tracebin_clock ();
+    for (i = 0; i < sysblk.maxcpu && i < MAX_CPU_ENGINES; i++)
+        if (tracebin_map (&tbring[i], (U16)i, start) != 0)
+            break;
+
+    if ((i < sysblk.maxcpu && i < MAX_CPU_ENGINES)
+     || tracebin_map (&tbring[TB_IORING], TBHDR_IO, start) != 0)
+    {
+        tracebin_stop ();
+        return -1;
+    }
+
+    if (!tbadsc)
+    {
+        hdl_adsc ("tracebin_term", tracebin_term, NULL);
+        tbadsc = 1;
+    }
+
+    sysblk.tracebin = 1;
+    return 0;
+}
+
+/*-------------------------------------------------------------------*/
+/* Display the ring files                                            */
+/*-------------------------------------------------------------------*/
+static void tracebin_display (void)
+{
+int     i;                              /* Ring index                */
+U64     next;                           /* Records written           */
+U32     nrecs;                          /* Number of record slots    */
+
+    logmsg (_("HHCTB001I Binary trace is %s, %d MB per ring in %s\n"),
+            sysblk.tracebin ? _("on") : _("off"), tbsize, tbdir);
+
+    for (i = 0; i <= TB_IORING; i++)
+    {
+        obtain_lock (&tbring[i].lock);
+        if (tbring[i].hdr == NULL)
+        {
+            release_lock (&tbring[i].lock);
+            continue;
+        }
+        next = tbring[i].hdr->next;
+        nrecs = tbring[i].hdr->nrecs;
+        release_lock (&tbring[i].lock);
+
+        if (i == TB_IORING)
+            logmsg (_("HHCTB002I I/O     %" I64_FMT "u records, ring %u%s\n"),
+                    next, nrecs, next > nrecs ? _(" (wrapped)") : "");
+        else
+            logmsg (_("HHCTB002I CPU%4.4X %" I64_FMT "u records, ring %u%s\n"),
+                    i, next, nrecs, next > nrecs ? _(" (wrapped)") : "");
+    }
+}
+
+/*-------------------------------------------------------------------*/
+/* tracebin command                                                  */
+/*-------------------------------------------------------------------*/
+int tracebin_cmd (int argc, char *argv[], char *cmdline)
+{
+int     n;                              /* Numeric operand           */
+char    c;                              /* Trailing character        */
+int     rc = 0;                         /* Return code               */
+
+    UNREFERENCED(cmdline);
+
+    obtain_lock (&tblock);
+
+    if (argc < 2)
+        tracebin_display ();
+
+    else if (strcasecmp (argv[1], "on") == 0 && argc < 5)
+    {
+        n = tbsize;
+        if (argc > 3 && (sscanf (argv[3], "%d%c", &n, &c) != 1
+                         || n < 1 || n > 4095))
+        {
+            logmsg (_("HHCTB005E Invalid tracebin operand %s\n"), argv[3]);
+            release_lock (&tblock);
+            return -1;
+        }
+        if (argc > 2)
+            strlcpy (tbdir, argv[2], sizeof(tbdir));
+        tbsize = n;
+
+        if ((rc = tracebin_start ()) == 0)
+            logmsg (_("HHCTB006I Binary trace started, %d MB per ring in %s\n"),
+                    tbsize, tbdir);
+    }
+
+    else if (strcasecmp (argv[1], "off") == 0 && argc == 2)
+    {
+        tracebin_stop ();
+        logmsg (_("HHCTB007I Binary trace stopped\n"));
+    }
+
+    else
+    {
+        logmsg (_("HHCTB005E Invalid tracebin operand %s\n"), argv[1]);
+        rc = -1;
+    }
+
+    release_lock (&tblock);
+    return rc;
+}
+
+#endif /* defined(OPTION_TRACEBIN) */
+
+/*-------------------------------------------------------------------*/
+/* Disassemble an instruction for the tracedump utility              */
+/*-------------------------------------------------------------------*/
+DLL_EXPORT int tracebin_disasm (BYTE *inst, char *buf)
+{
+    return DISASM_INSTRUCTION (inst, buf);
+}
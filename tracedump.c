@@ -0,0 +1,316 @@
+/* TRACEDUMP.C  (c)Copyright The Hercules Project, 2026              */
+/*              Decode binary trace ring files                       */
+
+/*-------------------------------------------------------------------*/
+/* This program formats the ring files written by the `tracebin'     */
+/* command.  The records of all files named on the command line are  */
+/* merged in time order and displayed in the same layout as the      */
+/* instruction and CCW trace messages.                               */
+/*-------------------------------------------------------------------*/
+
+#include "hstdinc.h"
+
+#include "hercules.h"
+#include "herc_getopt.h"
+
+typedef struct _TDREC {                 /* Record read from a file   */
+        TBREC   rec;                    /* Trace record              */
+        U64     seq;                    /* Sequence in file order    */
+} TDREC;
+
+static TDREC   *tdrec;                  /* -> Records read           */
+static size_t   tdnum;                  /* Number of records read    */
+static size_t   tdmax;                  /* Number of entries in tdrec*/
+
+/*-------------------------------------------------------------------*/
+/* Display usage and exit                                            */
+/*-------------------------------------------------------------------*/
+static void usage (char *pgm)
+{
+    fprintf (stderr,
+        "Usage: %s [-c cpu] [-d devnum] [-n count] file...\n\n"
+        "  -c cpu     display only instructions executed by this CPU\n"
+        "  -d devnum  display only channel program records for this device\n"
+        "  -n count   display only the last count records\n",
+        pgm);
+    exit (1);
+}
+
+/*-------------------------------------------------------------------*/
+/* Add a record to the table                                         */
+/*-------------------------------------------------------------------*/
+static void add_rec (TBREC *rec)
+{
+    if (tdnum == tdmax)
+    {
+        tdmax = tdmax ? tdmax * 2 : 65536;
+        tdrec = realloc (tdrec, tdmax * sizeof(TDREC));
+        if (tdrec == NULL)
+        {
+            fprintf (stderr, "Out of memory for %lu records\n",
+                     (unsigned long)tdmax);
+            exit (2);
+        }
+    }
+    memcpy (&tdrec[tdnum].rec, rec, sizeof(TBREC));
+    tdrec[tdnum].seq = tdnum;
+    tdnum++;
+}
+
+/*-------------------------------------------------------------------*/
+/* Read the records of a ring file, oldest first                     */
+/*-------------------------------------------------------------------*/
+static int read_ring (char *fn)
+{
+FILE   *fp;                             /* Ring file                 */
+TBHDR   hdr;                            /* Ring file header          */
+TBREC   rec;                            /* Trace record              */
+U64     first;                          /* First record number       */
+U64     n;                              /* Record number             */
+
+    if ((fp = fopen (fn, "rb")) == NULL)
+    {
+        fprintf (stderr, "%s open error: %s\n", fn, strerror(errno));
+        return -1;
+    }
+
+    if (fread (&hdr, sizeof(hdr), 1, fp) != 1
+     || memcmp (hdr.id, TBHDR_ID, sizeof(hdr.id)) != 0)
+    {
+        fprintf (stderr, "%s is not a binary trace file\n", fn);
+        fclose (fp);
+        return -1;
+    }
+
+    if (hdr.endian != TBHDR_ENDIAN)
+    {
+        fprintf (stderr, "%s was written on a host with different "
+                 "byte order\n", fn);
+        fclose (fp);
+        return -1;
+    }
+
+    if (hdr.recsize != sizeof(TBREC) || hdr.nrecs == 0)
+    {
+        fprintf (stderr, "%s has unsupported record size %u\n",
+                 fn, hdr.recsize);
+        fclose (fp);
+        return -1;
+    }
+
+    /* Once the ring has wrapped the oldest record is the next slot */
+    first = hdr.next > hdr.nrecs ? hdr.next - hdr.nrecs : 0;
+
+    for (n = first; n < hdr.next; n++)
+    {
+        if (n == first || n % hdr.nrecs == 0)
+        {
+            if (fseek (fp, hdr.hdrsize
+                 + (long)(n % hdr.nrecs) * hdr.recsize, SEEK_SET) != 0)
+                break;
+        }
+        if (fread (&rec, sizeof(rec), 1, fp) != 1)
+            break;
+        add_rec (&rec);
+    }
+
+    if (n < hdr.next)
+        fprintf (stderr, "%s is truncated\n", fn);
+
+    fclose (fp);
+    return 0;
+}
+
+/*-------------------------------------------------------------------*/
+/* Compare records by time, keeping file order for equal times       */
+/*-------------------------------------------------------------------*/
+static int cmp_rec (const void *a, const void *b)
+{
+const TDREC *ra = a, *rb = b;
+
+    if (ra->rec.time != rb->rec.time)
+        return ra->rec.time < rb->rec.time ? -1 : 1;
+    return ra->seq < rb->seq ? -1 : ra->seq > rb->seq ? 1 : 0;
+}
+
+/*-------------------------------------------------------------------*/
+/* Format bytes in hexadecimal                                       */
+/*-------------------------------------------------------------------*/
+static char *hex (char *buf, BYTE *p, int len, int group)
+{
+char   *s = buf;
+int     i;
+
+    for (i = 0; i < len; i++)
+    {
+        if (i && group && i % group == 0)
+            *s++ = ' ';
+        s += sprintf (s, "%2.2X", p[i]);
+    }
+    *s = '\0';
+    return buf;
+}
+
+/*-------------------------------------------------------------------*/
+/* Format CCW data bytes as hex and EBCDIC                           */
+/*-------------------------------------------------------------------*/
+static char *data (char *buf, BYTE *p)
+{
+char    hx[40];
+char    ch[17];
+int     i;
+
+    for (i = 0; i < 16; i++)
+    {
+        ch[i] = guest_to_host(p[i]);
+        if (!isprint((unsigned char)ch[i]))
+            ch[i] = '.';
+    }
+    ch[16] = '\0';
+    sprintf (buf, "=>%s %s", hex (hx, p, 16, 4), ch);
+    return buf;
+}
+
+/*-------------------------------------------------------------------*/
+/* Display a trace record                                            */
+/*-------------------------------------------------------------------*/
+static void display_rec (TBREC *rec)
+{
+char    tm[32];                         /* Time of day               */
+char    buf[128];                       /* Hex work area             */
+char    buf2[128];                      /* Data work area            */
+char    mnem[256];                      /* Disassembled instruction  */
+time_t  secs;                           /* Time in seconds           */
+struct tm *lt;                          /* Local time                */
+int     ilc;                            /* Instruction length        */
+
+    secs = (time_t)(rec->time / 1000000000);
+    lt = localtime (&secs);
+    strftime (tm, sizeof(tm), "%H:%M:%S", lt);
+    printf ("%s.%9.9u ", tm, (U32)(rec->time % 1000000000));
+
+    switch (rec->type) {
+
+    case TBREC_INST:
+        ilc = rec->len > 6 ? 6 : rec->len;
+        tracebin_disasm (rec->u.inst.inst, mnem);
+        printf ("CP%4.4X%s PSW=%s INST=%-12s %s",
+                rec->cpuad, (rec->flags & TBREC_SIE) ? " SIE:" : "",
+                hex (buf, rec->u.inst.psw,
+                     rec->arch == TBREC_900 ? 16 : 8, 4),
+                hex (buf2, rec->u.inst.inst, ilc, 0), mnem);
+        if (rec->flags & TBREC_OP1)
+            printf (" op1=%s%16.16" I64_FMT "X",
+                    (rec->flags & TBREC_REAL) ? "R:" : "",
+                    rec->u.inst.op1);
+        if (rec->flags & TBREC_OP2)
+            printf (" op2=%s%16.16" I64_FMT "X",
+                    (rec->flags & TBREC_REAL) ? "R:" : "",
+                    rec->u.inst.op2);
+        printf ("\n");
+        break;
+
+    case TBREC_CCW:
+        printf ("%d:%4.4X CCW=%s%s\n", rec->cpuad, rec->devnum,
+                hex (buf, rec->u.io.word, 8, 4),
+                (rec->flags & TBREC_DATA) ? data (buf2, rec->u.io.data) : "");
+        break;
+
+    case TBREC_CCWEND:
+        printf ("%d:%4.4X Stat=%2.2X%2.2X Count=%4.4X %s\n",
+                rec->cpuad, rec->devnum,
+                rec->u.io.unitstat, rec->u.io.chanstat, rec->u.io.count,
+                (rec->flags & TBREC_DATA) ? data (buf2, rec->u.io.data) : "");
+        if (rec->flags & TBREC_SENSE)
+            printf ("%28s%d:%4.4X Sense=%s\n", "",
+                    rec->cpuad, rec->devnum,
+                    hex (buf, rec->u.io.word, 16, 4));
+        break;
+
+    case TBREC_CSW:
+        printf ("%d:%4.4X CSW=%s\n", rec->cpuad, rec->devnum,
+                hex (buf, rec->u.io.word, 8, 4));
+        break;
+
+    case TBREC_SCSW:
+        printf ("%d:%4.4X SCSW=%s\n", rec->cpuad, rec->devnum,
+                hex (buf, rec->u.io.word, 12, 4));
+        break;
+
+    default:
+        printf ("Unknown record type %d\n", rec->type);
+        break;
+    }
+}
+
+/*-------------------------------------------------------------------*/
+/* TRACEDUMP main entry point                                        */
+/*-------------------------------------------------------------------*/
+int main (int argc, char *argv[])
+{
+char   *pgm = "tracedump";              /* Program name              */
+int     cpu = -1;                       /* CPU to display or -1      */
+int     devnum = -1;                    /* Device to display or -1   */
+long    count = 0;                      /* Records to display or 0   */
+size_t  i;                              /* Record index              */
+size_t  first;                          /* First record displayed    */
+char    c;                              /* Trailing character        */
+int     rc = 0;                         /* Return code               */
+int     o;                              /* Option character          */
+
+    INITIALIZE_UTILITY(pgm);
+
+    display_version (stderr, "Hercules binary trace dump program ", FALSE);
+
+    while ((o = getopt (argc, argv, "c:d:n:")) != -1)
+    {
+        switch (o)
+        {
+        case 'c':
+            if (sscanf (optarg, "%x%c", &cpu, &c) != 1
+             || cpu < 0 || cpu >= MAX_CPU_ENGINES)
+                usage (pgm);
+            break;
+        case 'd':
+            if (sscanf (optarg, "%x%c", &devnum, &c) != 1
+             || devnum < 0 || devnum > 0xFFFF)
+                usage (pgm);
+            break;
+        case 'n':
+            if (sscanf (optarg, "%ld%c", &count, &c) != 1 || count < 1)
+                usage (pgm);
+            break;
+        default:
+            usage (pgm);
+        }
+    }
+
+    if (optind >= argc)
+        usage (pgm);
+
+    for ( ; optind < argc; optind++)
+        if (read_ring (argv[optind]) != 0)
+            rc = 1;
+
+    qsort (tdrec, tdnum, sizeof(TDREC), cmp_rec);
+
+    /* Apply the CPU and device selections */
+    for (i = first = 0; i < tdnum; i++)
+    {
+        if (tdrec[i].rec.type == TBREC_INST
+          ? (devnum >= 0 && cpu < 0) || (cpu >= 0 && tdrec[i].rec.cpuad != cpu)
+          : (cpu >= 0 && devnum < 0) || (devnum >= 0 && tdrec[i].rec.devnum != devnum))
+            continue;
+        if (first != i)
+            tdrec[first] = tdrec[i];
+        first++;
+    }
+    tdnum = first;
+
+    first = (count > 0 && (size_t)count < tdnum) ? tdnum - count : 0;
+    for (i = first; i < tdnum; i++)
+        display_rec (&tdrec[i].rec);
+
+    free (tdrec);
+    return rc;
+}
@@ -268,6 +268,464 @@ int             TUNTAP_CreateInterface( char* pszTUNDevice,
     return 0;
 }
 
+#ifdef OPTION_TUNTAP_MULTIQUEUE
+//
+// TUNTAP_AddQueue
+//
+//
+// Attaches another queue to an interface which was created with the
+// IFF_MULTI_QUEUE flag. Each queue has its own file descriptor, and
+// the kernel spreads the flows sent to the interface over the queues
+// so that they can be read in parallel by separate threads.
+//
+// Input:
+//      pszTUNDevice  Pointer to the name of the TUN/TAP char device
+//      iFlags        The same flags the interface was created with
+//      pszNetDevName Name of the interface
+//
+// Output:
+//      pfd           Pointer to receive the file descriptor of the
+//                       new queue.
+//
+
+int             TUNTAP_AddQueue( char* pszTUNDevice,
+                                 int   iFlags,
+                                 int*  pfd,
+                                 char* pszNetDevName )
+{
+    struct ifreq   ifr;
+    int            fd;                  // File descriptor
+
+    fd = TUNTAP_Open( pszTUNDevice, O_RDWR );
+
+    if( fd < 0 )
+    {
+        logmsg( _("HHCTU002E Error opening TUN/TAP device: %s: %s\n"),
+                pszTUNDevice, strerror( errno ) );
+
+        return -1;
+    }
+
+    memset( &ifr, 0, sizeof( ifr ) );
+    strlcpy( ifr.ifr_name, pszNetDevName, sizeof( ifr.ifr_name ) );
+    ifr.ifr_flags = iFlags | IFF_MULTI_QUEUE;
+
+    if( TUNTAP_SetMode( fd, &ifr ) < 0 )
+    {
+        logmsg( _("HHCTU032E %s: Error attaching queue: %s\n"),
+                pszNetDevName, strerror( errno ) );
+        TUNTAP_Close( fd );
+        return -1;
+    }
+
+    *pfd = fd;
+
+    return 0;
+}
+#endif // OPTION_TUNTAP_MULTIQUEUE
+
+#ifdef OPTION_TUNTAP_VNETHDR
+//
+// TUNTAP_SetOffload
+//
+//
+// Tells the kernel that frames read from an IFF_VNET_HDR interface
+// may carry a partial checksum or be up to 64K TCP/IPv4 segmentation
+// offload frames. The host stack then no longer checksums and cuts
+// up every packet it sends to the guest; TUNTAP_ReadBatch finishes
+// the job for the (fewer, larger) frames it actually reads.
+//
+
+int             TUNTAP_SetOffload( int   fd,
+                                   char* pszNetDevName )
+{
+    if( ioctl( fd, TUNSETOFFLOAD, TUN_F_CSUM | TUN_F_TSO4 ) < 0 )
+    {
+        logmsg( _("HHCTU033E %s: Error setting offloads: %s\n"),
+                pszNetDevName, strerror( errno ) );
+        return -1;
+    }
+
+    return 0;
+}
+
+//
+// TUNTAP_Checksum
+//
+// Returns the ones' complement sum of the data added to a partial
+// sum, folded to 16 bits (network byte order arithmetic).
+//
+
+static U32      TUNTAP_Checksum( BYTE* pData, int iLength, U32 lSum )
+{
+    while( iLength > 1 )
+    {
+        lSum    += ( pData[0] << 8 ) | pData[1];
+        pData   += 2;
+        iLength -= 2;
+    }
+
+    if( iLength > 0 )
+        lSum += pData[0] << 8;
+
+    while( lSum >> 16 )
+        lSum = ( lSum & 0xFFFF ) + ( lSum >> 16 );
+
+    return lSum;
+}
+
+//
+// TUNTAP_Segment
+//
+// Cuts a TCP/IPv4 segmentation offload frame into segments of at
+// most sGSOSize payload bytes, each with its own IP and TCP header
+// and checksums, placed one after the other at pOut. Returns the
+// number of bytes stored, or -1 if the frame is malformed or the
+// segments do not fit.
+//
+
+static int      TUNTAP_Segment( TTBATCH* pBatch, VNETHDR* pHdr,
+                                BYTE* pData, int iLength,
+                                BYTE* pOut,  int iOutLen )
+{
+    BYTE*   pIP;                        // -> IP header
+    BYTE*   pTCP;                       // -> TCP header
+    int     iIPLen;                     // IP header length
+    int     iTCPLen;                    // TCP header length
+    int     iHdrLen;                    // Length of all headers
+    int     iPayload;                   // TCP payload length
+    int     iSegLen;                    // Payload in this segment
+    int     iOffset;                    // Offset into payload
+    int     iUsed = 0;                  // Bytes stored at pOut
+    U16     sID;                        // First IP identification
+    U32     lSeq;                       // First TCP sequence number
+    U32     lSum;                       // Checksum accumulator
+    int     i;
+
+    pIP = pData + pBatch->iLinkHdr;
+
+    if( iLength < pBatch->iLinkHdr + 20 || ( pIP[0] >> 4 ) != 4 )
+        return -1;
+
+    iIPLen = ( pIP[0] & 0x0F ) * 4;
+    pTCP   = pIP + iIPLen;
+
+    if( iIPLen < 20 || pIP[9] != IPPROTO_TCP
+     || iLength < pBatch->iLinkHdr + iIPLen + 20 )
+        return -1;
+
+    iTCPLen = ( pTCP[12] >> 4 ) * 4;
+    iHdrLen = pBatch->iLinkHdr + iIPLen + iTCPLen;
+
+    if( iTCPLen < 20 || iHdrLen > iLength || !pHdr->sGSOSize )
+        return -1;
+
+    iPayload = iLength - iHdrLen;
+    FETCH_HW( sID,  pIP  + 4 );
+    FETCH_FW( lSeq, pTCP + 4 );
+
+    for( i = 0, iOffset = 0; iOffset < iPayload; i++, iOffset += iSegLen )
+    {
+        BYTE*   pSegIP;
+        BYTE*   pSegTCP;
+
+        iSegLen = iPayload - iOffset;
+        if( iSegLen > pHdr->sGSOSize )
+            iSegLen = pHdr->sGSOSize;
+
+        if( iUsed + iHdrLen + iSegLen > iOutLen
+         || pBatch->iFrames >= TUNTAP_BATCH_FRAMES )
+        {
+            pBatch->iFrames -= i;       // (forget the segments made)
+            return -1;
+        }
+
+        memcpy( pOut + iUsed, pData, iHdrLen );
+        memcpy( pOut + iUsed + iHdrLen, pData + iHdrLen + iOffset, iSegLen );
+
+        pSegIP  = pOut + iUsed + pBatch->iLinkHdr;
+        pSegTCP = pSegIP + iIPLen;
+
+        // IP total length, identification and header checksum
+        STORE_HW( pSegIP + 2, iIPLen + iTCPLen + iSegLen );
+        STORE_HW( pSegIP + 4, (U16)( sID + i ) );
+        STORE_HW( pSegIP + 10, 0 );
+        STORE_HW( pSegIP + 10, (U16)~TUNTAP_Checksum( pSegIP, iIPLen, 0 ) );
+
+        // Sequence number; FIN and PSH belong to the last segment
+        // only, and CWR to the first
+        STORE_FW( pSegTCP + 4, lSeq + iOffset );
+        if( iOffset + iSegLen < iPayload )
+            pSegTCP[13] &= ~( 0x01 | 0x08 );
+        if( i > 0 )
+            pSegTCP[13] &= ~0x80;
+
+        // TCP checksum over the pseudo header and the segment
+        lSum = TUNTAP_Checksum( pSegIP + 12, 8, 0 );
+        lSum += IPPROTO_TCP + iTCPLen + iSegLen;
+        STORE_HW( pSegTCP + 16, 0 );
+        STORE_HW( pSegTCP + 16,
+                  (U16)~TUNTAP_Checksum( pSegTCP, iTCPLen + iSegLen, lSum ) );
+
+        pBatch->pFrame [ pBatch->iFrames ] = pOut + iUsed;
+        pBatch->iLength[ pBatch->iFrames ] = iHdrLen + iSegLen;
+        pBatch->iFrames++;
+
+        iUsed += iHdrLen + iSegLen;
+    }
+
+    pBatch->nSegmented++;
+
+    return iUsed;
+}
+#endif // OPTION_TUNTAP_VNETHDR
+
+//
+// TUNTAP_InitBatch
+//
+// Prepares a batch for reading frames from fd. fVnetHdr says that the
+// interface was created with IFF_VNET_HDR, iLinkHdr is the length of
+// the link header preceding the IP header (0 for TUN, 14 for TAP) and
+// iFrameSize the largest frame read when offloads are not in use.
+//
+
+int             TUNTAP_InitBatch( TTBATCH* pBatch,
+                                  int      fd,
+                                  int      fVnetHdr,
+                                  int      iLinkHdr,
+                                  int      iFrameSize )
+{
+    memset( pBatch, 0, sizeof( TTBATCH ) );
+
+    pBatch->fd         = fd;
+    pBatch->fVnetHdr   = fVnetHdr;
+    pBatch->iLinkHdr   = iLinkHdr;
+    pBatch->iFrameSize = iFrameSize;
+
+    if( !( pBatch->pBuff = malloc( TUNTAP_BATCH_SIZE ) ) )
+        return -1;
+
+#if !defined( OPTION_W32_CTCI )
+    // Reads after the first one in a batch must not wait
+    fcntl( fd, F_SETFL, fcntl( fd, F_GETFL ) | O_NONBLOCK );
+#endif
+
+    return 0;
+}
+
+//
+// TUNTAP_FreeBatch
+//
+
+void            TUNTAP_FreeBatch( TTBATCH* pBatch )
+{
+    free( pBatch->pBuff );
+    pBatch->pBuff = NULL;
+}
+
+//
+// TUNTAP_ReadBatch
+//
+// Waits up to iTimeout milliseconds for a frame and then reads all of
+// the frames that are queued on the interface, up to the capacity of
+// the batch. Returns the number of frames in the batch, 0 if none was
+// read (timeout or EINTR), or -1 if the read failed.
+//
+
+int             TUNTAP_ReadBatch( TTBATCH* pBatch,
+                                  int      iTimeout )
+{
+    int     iLength;                    // Length read
+#if !defined( OPTION_W32_CTCI )
+    BYTE*   pFrame;                     // -> Frame being read
+    int     iUsed = 0;                  // Bytes used in pBuff
+    int     iSize;                      // Space for this frame
+    int     fWaited;                    // Waited for the first frame
+    fd_set          selset;
+    struct timeval  tv;
+#endif
+#ifdef OPTION_TUNTAP_VNETHDR
+    VNETHDR         vnet;               // virtio-net header
+    struct iovec    iov[2];
+    int             iOut;               // Segmented length
+    int             i;
+#endif
+
+    pBatch->iFrames = 0;
+
+#if defined( OPTION_W32_CTCI )
+    UNREFERENCED( iTimeout );
+
+    // TunTap32 reads with a timeout of its own, one frame at a time
+    iLength = TUNTAP_Read( pBatch->fd, pBatch->pBuff, pBatch->iFrameSize );
+
+    if( iLength <= 0 )
+        return iLength;
+
+    pBatch->pFrame [0] = pBatch->pBuff;
+    pBatch->iLength[0] = iLength;
+    pBatch->iFrames    = 1;
+    pBatch->nReads++;
+    pBatch->nBatches++;
+
+    return 1;
+#else
+    // Unless the last batch filled up, the queue was found empty then
+    // and there's no point trying a read before waiting for a frame
+    for( fWaited = !pBatch->fFull, pBatch->fFull = 0; ; )
+    {
+        pFrame = pBatch->pBuff + iUsed;
+        iSize  = pBatch->fVnetHdr ? TUNTAP_GSO_SIZE : pBatch->iFrameSize;
+
+        // Leave room for a whole offloaded frame and its segments
+        if( TUNTAP_BATCH_SIZE - iUsed < ( pBatch->fVnetHdr ? 2 : 1 ) * iSize
+         || TUNTAP_BATCH_FRAMES - pBatch->iFrames
+                                   < ( pBatch->fVnetHdr ? TUNTAP_GSO_SEGS : 1 ) )
+        {
+            pBatch->fFull = 1;
+            break;
+        }
+
+#ifdef OPTION_TUNTAP_VNETHDR
+        if( pBatch->fVnetHdr )
+        {
+            // Keep the header apart so the frame lands in the batch
+            iov[0].iov_base = &vnet;
+            iov[0].iov_len  = sizeof( vnet );
+            iov[1].iov_base = pFrame;
+            iov[1].iov_len  = iSize;
+
+            iLength = readv( pBatch->fd, iov, 2 );
+            if( iLength >= 0 )
+                iLength -= sizeof( vnet );
+        }
+        else
+#endif
+            iLength = TUNTAP_Read( pBatch->fd, pFrame, iSize );
+
+        if( iLength == 0 )
+            break;
+
+        if( iLength < 0 )
+        {
+            if( errno == EAGAIN || errno == EWOULDBLOCK )
+            {
+                // Only the first frame of a batch is waited for
+                if( pBatch->iFrames || fWaited == 2 )
+                    break;
+
+                FD_ZERO( &selset );
+                FD_SET( pBatch->fd, &selset );
+                tv.tv_sec  = iTimeout / 1000;
+                tv.tv_usec = ( iTimeout % 1000 ) * 1000;
+
+                iLength = select( pBatch->fd + 1, &selset, NULL, NULL, &tv );
+
+                if( iLength <= 0 )
+                    return ( iLength < 0 && errno != EINTR ) ? -1 : 0;
+
+                fWaited = 2;
+                continue;
+            }
+
+            // Report the error once the frames already read are used
+            if( errno == EINTR || pBatch->iFrames )
+                break;
+
+            return -1;
+        }
+
+        pBatch->nReads++;
+
+#ifdef OPTION_TUNTAP_VNETHDR
+        if( pBatch->fVnetHdr && ( vnet.bGSOType & ~VNET_GSO_ECN ) != VNET_GSO_NONE )
+        {
+            // Segment behind the original and slide the result down
+            iOut = -1;
+            if( ( vnet.bGSOType & ~VNET_GSO_ECN ) == VNET_GSO_TCPV4 )
+                iOut = TUNTAP_Segment( pBatch, &vnet, pFrame, iLength,
+                                       pFrame + iLength,
+                                       TUNTAP_BATCH_SIZE - iUsed - iLength );
+            if( iOut < 0 )
+            {
+                pBatch->nDropped++;
+                continue;
+            }
+
+            memmove( pFrame, pFrame + iLength, iOut );
+            for( i = pBatch->iFrames - 1; i >= 0 && pBatch->pFrame[i] > pFrame; i-- )
+                pBatch->pFrame[i] -= iLength;
+
+            iUsed += iOut;
+            continue;
+        }
+
+        if( pBatch->fVnetHdr && ( vnet.bFlags & VNET_F_NEEDS_CSUM ) )
+        {
+            // Fill in the checksum the host stack left for us
+            if( vnet.sCsumStart + vnet.sCsumOffset + 2 > iLength )
+            {
+                pBatch->nDropped++;
+                continue;
+            }
+            STORE_HW( pFrame + vnet.sCsumStart + vnet.sCsumOffset,
+                      (U16)~TUNTAP_Checksum( pFrame + vnet.sCsumStart,
+                                             iLength - vnet.sCsumStart,
+                                             0 ) );
+        }
+#endif
+
+        pBatch->pFrame [ pBatch->iFrames ] = pFrame;
+        pBatch->iLength[ pBatch->iFrames ] = iLength;
+        pBatch->iFrames++;
+
+        iUsed += iLength;
+    }
+
+    if( pBatch->iFrames )
+        pBatch->nBatches++;
+
+    return pBatch->iFrames;
+#endif // defined( OPTION_W32_CTCI )
+}
+
+//
+// TUNTAP_WriteFrame
+//
+// Writes a frame, preceded by an empty virtio-net header if the
+// interface was created with IFF_VNET_HDR. Returns the length of
+// the frame written or -1.
+//
+
+int             TUNTAP_WriteFrame( int   fd,
+                                   int   fVnetHdr,
+                                   BYTE* pData,
+                                   int   iLength )
+{
+#ifdef OPTION_TUNTAP_VNETHDR
+    if( fVnetHdr )
+    {
+        VNETHDR         vnet;
+        struct iovec    iov[2];
+        int             rc;
+
+        memset( &vnet, 0, sizeof( vnet ) );
+        iov[0].iov_base = &vnet;
+        iov[0].iov_len  = sizeof( vnet );
+        iov[1].iov_base = pData;
+        iov[1].iov_len  = iLength;
+
+        rc = writev( fd, iov, 2 );
+
+        return rc < 0 ? rc : rc - (int)sizeof( vnet );
+    }
+#else
+    UNREFERENCED( fVnetHdr );
+#endif
+
+    return TUNTAP_Write( fd, pData, iLength );
+}
+
 //
 // Redefine 'TUNTAP_IOCtl' for the remainder of the functions.
 // This forces all 'ioctl' calls to go to 'hercifc'.
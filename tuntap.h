@@ -27,6 +27,94 @@ extern int      TUNTAP_CreateInterface  ( char*   pszTUNDevice,
                                           int*    pfd,
                                           char*   pszNetDevName );
 
+//
+// Multi-queue interfaces and virtio-net headers (Linux only)
+//
+
+#if !defined( OPTION_W32_CTCI ) && defined( IFF_MULTI_QUEUE )
+  #define OPTION_TUNTAP_MULTIQUEUE      // IFF_MULTI_QUEUE supported
+#endif
+#if !defined( OPTION_W32_CTCI ) && defined( IFF_VNET_HDR ) && defined( TUNSETOFFLOAD )
+  #define OPTION_TUNTAP_VNETHDR         // IFF_VNET_HDR supported
+#endif
+
+#ifdef OPTION_TUNTAP_MULTIQUEUE
+extern int      TUNTAP_AddQueue         ( char*   pszTUNDevice,
+                                          int     iFlags,
+                                          int*    pfd,
+                                          char*   pszNetDevName );
+#endif
+#ifdef OPTION_TUNTAP_VNETHDR
+extern int      TUNTAP_SetOffload       ( int     fd,
+                                          char*   pszNetDevName );
+#endif
+
+//
+// Batched frame reads
+//
+// TUNTAP_ReadBatch waits for the interface to become readable and
+// then reads every frame that is already queued, up to the capacity
+// of the batch, so that the caller can hand them all to the guest in
+// a single pass. On an interface created with IFF_VNET_HDR each frame
+// is preceded by a virtio-net header: frames whose checksum was left
+// for us are completed and TCP/IPv4 segmentation offload frames are
+// cut back into MSS sized segments, so what the caller sees is always
+// an ordinary frame that the guest can use as is.
+//
+
+#define TUNTAP_FRAME_SIZE     2048      // Default largest plain frame
+#define TUNTAP_BATCH_FRAMES   512       // Max frames per batch
+#define TUNTAP_BATCH_SIZE     (512*1024)// Batch buffer size
+#define TUNTAP_GSO_SIZE       (64*1024) // Largest offloaded frame
+#define TUNTAP_GSO_SEGS       128       // Frame slots kept free for it
+
+typedef struct _VNETHDR                 // virtio_net_hdr (host order)
+{
+    BYTE        bFlags;                 // VNET_F_xxx
+    BYTE        bGSOType;               // VNET_GSO_xxx
+    U16         sHdrLen;                // Length of protocol headers
+    U16         sGSOSize;               // Segment size (MSS)
+    U16         sCsumStart;             // Offset to start summing
+    U16         sCsumOffset;            // Offset of checksum field
+}
+VNETHDR;
+
+#define VNET_F_NEEDS_CSUM     0x01      // Checksum must be completed
+#define VNET_GSO_NONE         0x00      // Not a GSO frame
+#define VNET_GSO_TCPV4        0x01      // TCP/IPv4 segmentation
+#define VNET_GSO_ECN          0x80      // TCP has ECN set
+
+typedef struct _TTBATCH
+{
+    int         fd;                     // TUN/TAP fd
+    int         fVnetHdr;               // Frames have VNETHDR prefix
+    int         iLinkHdr;               // Link header size (TAP=14)
+    int         iFrameSize;             // Largest plain frame
+    int         fFull;                  // Last batch ran out of room
+    int         iFrames;                // Frames in this batch
+    BYTE*       pFrame[TUNTAP_BATCH_FRAMES];  // -> Frame
+    int         iLength[TUNTAP_BATCH_FRAMES]; // Frame length
+    BYTE*       pBuff;                  // -> Batch buffer
+    U64         nReads;                 // Frames read
+    U64         nBatches;               // Non-empty batches
+    U64         nSegmented;             // GSO frames segmented
+    U64         nDropped;               // Bad frames dropped
+}
+TTBATCH;
+
+extern int      TUNTAP_InitBatch        ( TTBATCH* pBatch,
+                                          int      fd,
+                                          int      fVnetHdr,
+                                          int      iLinkHdr,
+                                          int      iFrameSize );
+extern void     TUNTAP_FreeBatch        ( TTBATCH* pBatch );
+extern int      TUNTAP_ReadBatch        ( TTBATCH* pBatch,
+                                          int      iTimeout );
+extern int      TUNTAP_WriteFrame       ( int      fd,
+                                          int      fVnetHdr,
+                                          BYTE*    pData,
+                                          int      iLength );
+
 //
 // Configure TUN/TAP Interface
 //
@@ -1301,6 +1301,7 @@ DLL_EXPORT void w32_init_hostinfo( HOST_INFO* pHostInfo )
     }
 
     pHostInfo->num_procs = si.dwNumberOfProcessors;
+    pHostInfo->num_nodes = 1;
 
     InitializeCriticalSection( &cs );
 